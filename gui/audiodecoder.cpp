@@ -31,27 +31,39 @@
 #include <math.h>
 
 #include "audiodecoder.h"
+#include "audiokernels.h"
+#include "diagnostics.h"
+#include "shmexport.h"
+#include "audiostreamserver.h"
+#include "threadpriority.h"
 
 Q_LOGGING_CATEGORY(audioDecoder, "AudioDecoder", QtDebugMsg)
 
-audioFifo_t audioFifo[2];
-
 AudioDecoder::AudioDecoder(AudioRecorder *recorder, QObject *parent) : QObject(parent)
 {
+    m_audioFifo[0].reset();
+    m_audioFifo[1].reset();
+    m_memory.set(sizeof(m_audioFifo));
     m_outFifoIdx = 0;
-    m_outFifoPtr = &audioFifo[m_outFifoIdx];
+    m_outFifoPtr = &m_audioFifo[m_outFifoIdx];
     m_aacDecoderHandle = nullptr;
     m_mp2DecoderHandle = nullptr;
+    m_mp2DecoderCache = nullptr;
 
     Q_ASSERT(recorder != nullptr);
     m_recorder = recorder;
 
     m_playbackState = PlaybackState::Stopped;
+    m_audioParameters.sampleRateKHz = 48;
 
 #if HAVE_FDKAAC
     Q_ASSERT(sizeof(int16_t) == sizeof(INT_PCM));
 #endif
-    m_outBufferPtr = new int16_t[AUDIO_DECODER_BUFFER_SIZE];
+    m_outBufferPtr = new audioSample_t[AUDIO_DECODER_BUFFER_SIZE];
+    m_outPtr = m_outBufferPtr;
+#if HAVE_FDKAAC && HAVE_AUDIO_FLOAT32
+    m_pcmBufferPtr = new int16_t[AUDIO_DECODER_BUFFER_SIZE];
+#endif
 
 #if !HAVE_FDKAAC
 #if AUDIO_DECODER_NOISE_CONCEALMENT
@@ -64,15 +76,21 @@ AudioDecoder::AudioDecoder(AudioRecorder *recorder, QObject *parent) : QObject(p
 
 AudioDecoder::~AudioDecoder()
 {
-    if (nullptr != m_aacDecoderHandle)
+    for (auto & entry : m_aacDecoderCache)
     {
+        if (nullptr != entry.handle)
+        {
 #if HAVE_FDKAAC
-        aacDecoder_Close(m_aacDecoderHandle);
+            aacDecoder_Close(entry.handle);
 #else
-        NeAACDecClose(m_aacDecoderHandle);
+            NeAACDecClose(entry.handle);
 #endif
+        }
     }
     delete [] m_outBufferPtr;
+#if HAVE_FDKAAC && HAVE_AUDIO_FLOAT32
+    delete [] m_pcmBufferPtr;
+#endif
 
 #if !HAVE_FDKAAC
 #if AUDIO_DECODER_NOISE_CONCEALMENT
@@ -85,15 +103,15 @@ AudioDecoder::~AudioDecoder()
 #endif
 #endif
 
-    if (nullptr != m_mp2DecoderHandle)
+    if (nullptr != m_mp2DecoderCache)
     {
-        int res = mpg123_close(m_mp2DecoderHandle);
+        int res = mpg123_close(m_mp2DecoderCache);
         if (MPG123_OK != res)
         {
             qCCritical(audioDecoder, "error while mpg123_close: %s\n", mpg123_plain_strerror(res));
         }
 
-        mpg123_delete(m_mp2DecoderHandle);
+        mpg123_delete(m_mp2DecoderCache);
         mpg123_exit();
     }
 }
@@ -108,6 +126,21 @@ void AudioDecoder::start(const RadioControlServiceComponent&s)
         }
         m_playbackState = PlaybackState::WaitForInit;
         m_recorder->setAudioService(s);
+        if (m_isStreamSource)
+        {
+            AudioStreamServer::feedService(s);
+        }
+
+        if ((DabAudioDataSCty::DAB_AUDIO == s.streamAudioData.scType) && (nullptr == m_mp2DecoderCache))
+        {   // prewarm, decoder is ready when first frame comes
+            createMPG123();
+        }
+        else { /* AAC configuration is known from first AU, decoders of previous services are cached */ }
+
+        // new service starts live
+        m_timeshift.setup(m_timeshiftSec, s.streamAudioData.bitRate);
+        m_timeshiftPaused = false;
+        updateTimeshiftInfo();
     }
     else
     {   // no audio service -> can happen during reconfiguration
@@ -120,76 +153,97 @@ void AudioDecoder::stop()
     m_playbackState = PlaybackState::Stopped;
     m_recorder->stop();
 
+    m_timeshift.reset();
+    m_timeshiftPaused = false;
+    updateTimeshiftInfo();
+
     deinitAACDecoder();
     deinitMPG123();
 
     emit stopAudio();
 }
 
-void AudioDecoder::initMPG123()
+void AudioDecoder::createMPG123()
 {
-    deinitMPG123();
-    deinitAACDecoder();
-
     int res = mpg123_init();
     if (MPG123_OK != res)
     {
         throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while mpg123_init");
     }
 
-    m_mp2DecoderHandle = mpg123_new(nullptr, &res);
-    if (nullptr == m_mp2DecoderHandle)
+    m_mp2DecoderCache = mpg123_new(nullptr, &res);
+    if (nullptr == m_mp2DecoderCache)
     {
         throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while mpg123_new: " + std::string(mpg123_plain_strerror(res)));
     }
 
     // set allowed formats
-    res = mpg123_format_none(m_mp2DecoderHandle);
+    res = mpg123_format_none(m_mp2DecoderCache);
     if (MPG123_OK != res)
     {
         throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while mpg123_format_none: " + std::string(mpg123_plain_strerror(res)));
     }
 
-    res = mpg123_format(m_mp2DecoderHandle, 48000, MPG123_STEREO, MPG123_ENC_SIGNED_16);
+#if HAVE_AUDIO_FLOAT32
+    const int encoding = MPG123_ENC_FLOAT_32;
+#else
+    const int encoding = MPG123_ENC_SIGNED_16;
+#endif
+    res = mpg123_format(m_mp2DecoderCache, 48000, MPG123_STEREO, encoding);
     if (MPG123_OK != res)
     {
         throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while mpg123_format for 48KHz: " + std::string(mpg123_plain_strerror(res)));
     }
 
-    res = mpg123_format(m_mp2DecoderHandle, 24000, MPG123_STEREO, MPG123_ENC_SIGNED_16);
+    res = mpg123_format(m_mp2DecoderCache, 24000, MPG123_STEREO, encoding);
     if (MPG123_OK != res)
     {
         throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while mpg123_format for 24KHz: " + std::string(mpg123_plain_strerror(res)));
     }
 
     // disable resync limit
-    res = mpg123_param(m_mp2DecoderHandle, MPG123_RESYNC_LIMIT, -1, 0);
+    res = mpg123_param(m_mp2DecoderCache, MPG123_RESYNC_LIMIT, -1, 0);
     if (MPG123_OK != res)
     {
         throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while mpg123_param: " + std::string(mpg123_plain_strerror(res)));
     }
 
-    res = mpg123_open_feed(m_mp2DecoderHandle);
+    res = mpg123_open_feed(m_mp2DecoderCache);
     if (MPG123_OK != res)
     {
         throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while mpg123_open_feed: " + std::string(mpg123_plain_strerror(res)));
     }
 }
 
-void AudioDecoder::deinitMPG123()
+void AudioDecoder::initMPG123()
 {
-    if (nullptr != m_mp2DecoderHandle)
+    deinitMPG123();
+    deinitAACDecoder();
+
+    if (nullptr == m_mp2DecoderCache)
     {
-        int res = mpg123_close(m_mp2DecoderHandle);
+        createMPG123();
+    }
+    else
+    {   // new feed drops all data of previous stream, format is detected again
+        int res = mpg123_close(m_mp2DecoderCache);
         if (MPG123_OK != res)
         {
             qCCritical(audioDecoder, "error while mpg123_close: %s\n", mpg123_plain_strerror(res));
         }
-
-        mpg123_delete(m_mp2DecoderHandle);
-        mpg123_exit();
-        m_mp2DecoderHandle = nullptr;
+        res = mpg123_open_feed(m_mp2DecoderCache);
+        if (MPG123_OK != res)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while mpg123_open_feed: " + std::string(mpg123_plain_strerror(res)));
+        }
+        qCDebug(audioDecoder) << "MP2 decoder reused";
     }
+    m_mp2DecoderHandle = m_mp2DecoderCache;
+}
+
+void AudioDecoder::deinitMPG123()
+{
+    m_mp2DecoderHandle = nullptr;
 }
 
 void AudioDecoder::readAACHeader()
@@ -300,56 +354,105 @@ void AudioDecoder::readAACHeader()
     }
 }
 
+AudioDecoder::AACDecoderCacheEntry * AudioDecoder::getAACDecoder()
+{
+    m_aacDecoderUseCntr += 1;
+
+    AACDecoderCacheEntry * lruEntry = &m_aacDecoderCache[0];
+    for (auto & entry : m_aacDecoderCache)
+    {
+        if ((nullptr != entry.handle) && (entry.ascLen == m_ascLen) && (0 == memcmp(entry.asc, m_asc, m_ascLen)))
+        {   // same configuration
+            entry.lastUse = m_aacDecoderUseCntr;
+            return &entry;
+        }
+        if (entry.lastUse < lruEntry->lastUse)
+        {
+            lruEntry = &entry;
+        }
+    }
+
+    // not found, least recently used decoder is replaced
+    if (nullptr != lruEntry->handle)
+    {
+#if HAVE_FDKAAC
+        aacDecoder_Close(lruEntry->handle);
+#else
+        NeAACDecClose(lruEntry->handle);
+#endif
+        lruEntry->handle = nullptr;
+    }
+    lruEntry->ascLen = m_ascLen;
+    memcpy(lruEntry->asc, m_asc, m_ascLen);
+    lruEntry->lastUse = m_aacDecoderUseCntr;
+    return lruEntry;
+}
+
 #if HAVE_FDKAAC
 void AudioDecoder::initAACDecoder()
 {
     deinitMPG123();
     deinitAACDecoder();
 
-    m_aacDecoderHandle = aacDecoder_Open(TT_MP4_RAW, 1);
-    if (!m_aacDecoderHandle)
-    {
-        throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while aacDecoder_Open");
-    }
-
-    // init decoder
     int channels = m_audioParameters.stereo ? 2 : 1;
-    AAC_DECODER_ERROR init_result;
+    AACDecoderCacheEntry * decoder = getAACDecoder();
+    if (nullptr != decoder->handle)
+    {   // decoder is already configured, only data of previous stream are discarded
+        m_aacDecoderHandle = decoder->handle;
+        AAC_DECODER_ERROR result = aacDecoder_SetParam(m_aacDecoderHandle, AAC_TPDEC_CLEAR_BUFFER, 1);
+        if (AAC_DEC_OK != result)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while setting parameter AAC_TPDEC_CLEAR_BUFFER: " + std::to_string(result));
+        }
+        qCDebug(audioDecoder) << "AAC decoder reused";
+    }
+    else
+    {
+        decoder->handle = aacDecoder_Open(TT_MP4_RAW, 1);
+        m_aacDecoderHandle = decoder->handle;
+        if (!m_aacDecoderHandle)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while aacDecoder_Open");
+        }
 
-    /* Restrict output channel count to actual input channel count.
-     *
-     * Just using the parameter value -1 (no up-/downmix) does not work, as with
-     * SBR and Mono the lib assumes possibly present PS and then outputs Stereo!
-     *
-     * Note:
-     * Older lib versions use a combined parameter for the output channel count.
-     * As the headers of these didn't define the version, branch accordingly.
-     */
+        // init decoder
+        AAC_DECODER_ERROR init_result;
+
+        /* Restrict output channel count to actual input channel count.
+         *
+         * Just using the parameter value -1 (no up-/downmix) does not work, as with
+         * SBR and Mono the lib assumes possibly present PS and then outputs Stereo!
+         *
+         * Note:
+         * Older lib versions use a combined parameter for the output channel count.
+         * As the headers of these didn't define the version, branch accordingly.
+         */
 #if !defined (AACDECODER_LIB_VL0) && !defined (AACDECODER_LIB_VL1) && !defined (AACDECODER_LIB_VL2)
-    init_result = aacDecoder_SetParam(m_aacDecoderHandle, AAC_PCM_OUTPUT_CHANNELS, channels);
-    if (AAC_DEC_OK != init_result)
-    {
-        throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while setting parameter AAC_PCM_OUTPUT_CHANNELS: " + std::to_string(init_result));
-    }
+        init_result = aacDecoder_SetParam(m_aacDecoderHandle, AAC_PCM_OUTPUT_CHANNELS, channels);
+        if (AAC_DEC_OK != init_result)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while setting parameter AAC_PCM_OUTPUT_CHANNELS: " + std::to_string(init_result));
+        }
 #else
-    init_result = aacDecoder_SetParam(m_aacDecoderHandle, AAC_PCM_MIN_OUTPUT_CHANNELS, channels);
-    if (AAC_DEC_OK != init_result)
-    {
-        throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while setting parameter AAC_PCM_MIN_OUTPUT_CHANNELS: " + std::to_string(init_result));
-    }
-    init_result = aacDecoder_SetParam(m_aacDecoderHandle, AAC_PCM_MAX_OUTPUT_CHANNELS, channels);
-    if (AAC_DEC_OK != init_result)
-    {
-        throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while setting parameter AAC_PCM_MAX_OUTPUT_CHANNELS: " + std::to_string(init_result));
-    }
+        init_result = aacDecoder_SetParam(m_aacDecoderHandle, AAC_PCM_MIN_OUTPUT_CHANNELS, channels);
+        if (AAC_DEC_OK != init_result)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while setting parameter AAC_PCM_MIN_OUTPUT_CHANNELS: " + std::to_string(init_result));
+        }
+        init_result = aacDecoder_SetParam(m_aacDecoderHandle, AAC_PCM_MAX_OUTPUT_CHANNELS, channels);
+        if (AAC_DEC_OK != init_result)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while setting parameter AAC_PCM_MAX_OUTPUT_CHANNELS: " + std::to_string(init_result));
+        }
 #endif
 
-    uint8_t * asc_array[1] { m_asc };
-    const unsigned int asc_sizeof_array[1] { (unsigned int)m_ascLen };
-    init_result = aacDecoder_ConfigRaw(m_aacDecoderHandle, asc_array, asc_sizeof_array);
-    if (AAC_DEC_OK != init_result)
-    {
-        throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while aacDecoder_ConfigRaw: " + std::to_string(init_result));
+        uint8_t * asc_array[1] { m_asc };
+        const unsigned int asc_sizeof_array[1] { (unsigned int)m_ascLen };
+        init_result = aacDecoder_ConfigRaw(m_aacDecoderHandle, asc_array, asc_sizeof_array);
+        if (AAC_DEC_OK != init_result)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while aacDecoder_ConfigRaw: " + std::to_string(init_result));
+        }
     }
 
     m_outputBufferSamples = 960 * channels * (m_aacHeader.bits.sbr_flag ? 2 : 1);
@@ -368,57 +471,74 @@ void AudioDecoder::initAACDecoder()
     deinitMPG123();
     deinitAACDecoder();
 
-    m_aacDecoderHandle = NeAACDecOpen();
-    if (!m_aacDecoderHandle)
-    {
-        throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while NeAACDecOpen");
+    AACDecoderCacheEntry * decoder = getAACDecoder();
+    if (nullptr != decoder->handle)
+    {   // decoder is already configured, only state of previous stream is reset
+        m_aacDecoderHandle = decoder->handle;
+        NeAACDecPostSeekReset(m_aacDecoderHandle, 0);
+        qCDebug(audioDecoder) << "AAC decoder reused";
     }
-
-    // ensure features
-    unsigned long cap = NeAACDecGetCapabilities();
-    if (!(cap & LC_DEC_CAP))
+    else
     {
-        throw std::runtime_error(std::string(Q_FUNC_INFO) + ": no LC decoding support!");
-    }
+        decoder->handle = NeAACDecOpen();
+        m_aacDecoderHandle = decoder->handle;
+        if (!m_aacDecoderHandle)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while NeAACDecOpen");
+        }
 
-    // set general config
-    NeAACDecConfigurationPtr config = NeAACDecGetCurrentConfiguration(m_aacDecoderHandle);
-    if (!config)
-    {
-        throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while NeAACDecGetCurrentConfiguration");
-    }
+        // ensure features
+        unsigned long cap = NeAACDecGetCapabilities();
+        if (!(cap & LC_DEC_CAP))
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": no LC decoding support!");
+        }
 
-    config->outputFormat = FAAD_FMT_16BIT;
-    config->dontUpSampleImplicitSBR = 0;
-    config->downMatrix = 1;
+        // set general config
+        NeAACDecConfigurationPtr config = NeAACDecGetCurrentConfiguration(m_aacDecoderHandle);
+        if (!config)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while NeAACDecGetCurrentConfiguration");
+        }
 
-    if (NeAACDecSetConfiguration(m_aacDecoderHandle, config) != 1)
-    {
-        throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while NeAACDecSetConfiguration");
-    }
+#if HAVE_AUDIO_FLOAT32
+        config->outputFormat = FAAD_FMT_FLOAT;
+#else
+        config->outputFormat = FAAD_FMT_16BIT;
+#endif
+        config->dontUpSampleImplicitSBR = 0;
+        config->downMatrix = 1;
 
-    // init decoder
-    unsigned long sampleRate;
-    unsigned char numChannels;
-    long int init_result = NeAACDecInit2(m_aacDecoderHandle, m_asc, (unsigned long)m_ascLen, &sampleRate, &numChannels);
-    if (init_result != 0)
-    {
-        throw std::runtime_error("AACDecoderFAAD2: error while NeAACDecInit2: " + std::string(NeAACDecGetErrorMessage(-init_result)));
+        if (NeAACDecSetConfiguration(m_aacDecoderHandle, config) != 1)
+        {
+            throw std::runtime_error(std::string(Q_FUNC_INFO) + ": error while NeAACDecSetConfiguration");
+        }
+
+        // init decoder
+        long int init_result = NeAACDecInit2(m_aacDecoderHandle, m_asc, (unsigned long)m_ascLen, &decoder->sampleRate, &decoder->numChannels);
+        if (init_result != 0)
+        {
+            throw std::runtime_error("AACDecoderFAAD2: error while NeAACDecInit2: " + std::string(NeAACDecGetErrorMessage(-init_result)));
+        }
     }
+    unsigned long sampleRate = decoder->sampleRate;
+    unsigned char numChannels = decoder->numChannels;
 
     m_numChannels = numChannels;
     m_outputBufferSamples = 960 * numChannels * (m_aacHeader.bits.sbr_flag ? 2 : 1);
 
     // calculate mute ramp
-    // mute ramp is sin^2 that changes from 0 to 1 during AUDIOOUTPUT_FADE_TIME_MS
-    m_muteRamp.clear();
+    // unmute ramp is sin^2 that changes from 0 to 1 during AUDIOOUTPUT_FADE_TIME_MS
+    // ramps are expanded to all channels so that they can be applied to the buffer in one block
+    m_unmuteRamp.clear();
     int sampleRate_kHz = sampleRate/1000.0;
     float coe = M_PI / (2.0 * AUDIO_DECODER_FADE_TIME_MS * sampleRate_kHz);
     for (int n = 0; n < AUDIO_DECODER_FADE_TIME_MS * sampleRate_kHz; ++n)
     {
         float g = sinf(n * coe);
-        m_muteRamp.push_back(g * g);
+        m_unmuteRamp.insert(m_unmuteRamp.end(), numChannels, g * g);
     }
+    m_muteRamp.assign(m_unmuteRamp.crbegin(), m_unmuteRamp.crend());
 
     qCInfo(audioDecoder, "Output sample rate %lu Hz, channels: %d", sampleRate, numChannels);
 
@@ -428,43 +548,70 @@ void AudioDecoder::initAACDecoder()
 
 void AudioDecoder::deinitAACDecoder()
 {
-    if (nullptr != m_aacDecoderHandle)
-    {
-#if HAVE_FDKAAC
-        aacDecoder_Close(m_aacDecoderHandle);
-#else
-        NeAACDecClose(m_aacDecoderHandle);
-#endif
-        m_aacDecoderHandle = nullptr;
-    }
+    m_aacDecoderHandle = nullptr;
 }
 
 void AudioDecoder::decodeData(RadioControlAudioData *inData)
 {
+    ThreadPriority::update(ThreadClass::Decoder);
+
     if (PlaybackState::Stopped == m_playbackState)
     {   // do nothing if not running
-        delete inData;  // free input buffer
+        inData->release();  // return input buffer to pool
         return;
     }
 
-    switch (inData->ASCTy)
+    Diagnostics * diag = Diagnostics::getInstance();
+    diag->addDelay(DiagnosticsMetric::AudioDataQueueDelay, inData->timestampUs);
+    uint64_t startUs = Diagnostics::timestampUs();
+
+    // live AU is decoded unless timeshift is active, delayed stream keeps pace of live stream (one AU in, one AU out)
+    RadioControlAudioData * decData = inData;
+    if (m_timeshiftPaused)
     {
-    case DabAudioDataSCty::DAB_AUDIO:
-        processMP2(inData);
-        break;
+        decData = nullptr;
+    }
+    else if (m_timeshift.isShifted() && m_timeshift.read(&m_timeshiftData))
+    {
+        decData = &m_timeshiftData;
+    }
+    else { /* live */ }
 
-    case DabAudioDataSCty::DABPLUS_AUDIO:
-        processAAC(inData);
-        break;
+    if (nullptr != decData)
+    {
+        m_captureUs = decData->captureUs;
+        switch (decData->ASCTy)
+        {
+        case DabAudioDataSCty::DAB_AUDIO:
+            processMP2(decData);
+            break;
+
+        case DabAudioDataSCty::DABPLUS_AUDIO:
+            processAAC(decData);
+            break;
+
+        default:
+            ; // do nothing
+        }
+    }
+
+    diag->addDelay(DiagnosticsMetric::AudioDecodeTime, startUs);
 
-    default:
-        ; // do nothing
+    if (m_timeshift.isEnabled())
+    {   // this is only copy of AU
+        m_timeshift.store(inData, m_audioParameters.sampleRateKHz);
+        updateTimeshiftInfo();
     }
 
-    m_recorder->recordData(inData, m_outBufferPtr, m_outputBufferSamples);
+    // encoded stream is recorded live, WAV recording contains what is played
+    m_recorder->recordData(inData, m_outPtr, (nullptr != decData) ? m_outputBufferSamples : 0);
+    if (m_isStreamSource)
+    {   // live AU without decoding
+        AudioStreamServer::feedAU(inData);
+    }
 
-    // free input data
-    delete inData;
+    // return input data to pool
+    inData->release();
 }
 
 void AudioDecoder::getAudioParameters()
@@ -480,6 +627,62 @@ void AudioDecoder::getAudioParameters()
     }
 }
 
+void AudioDecoder::setTimeshift(int durationMin)
+{
+    m_timeshiftSec = qMax(0, durationMin) * 60;
+    if (0 == m_timeshiftSec)
+    {   // releases memory
+        m_timeshift.setup(0, 0);
+        m_timeshiftPaused = false;
+        updateTimeshiftInfo();
+    }
+    else { /* buffer is allocated when service starts */ }
+}
+
+void AudioDecoder::timeshiftPause(bool pause)
+{
+    if (!m_timeshift.isEnabled() || (PlaybackState::Stopped == m_playbackState))
+    {
+        return;
+    }
+    if (pause)
+    {   // live stream is stored, playback continues from here
+        m_timeshift.setShifted();
+    }
+    m_timeshiftPaused = pause;
+    updateTimeshiftInfo();
+}
+
+void AudioDecoder::timeshiftSkip(int offsetSec)
+{
+    if (!m_timeshift.isEnabled())
+    {
+        return;
+    }
+    m_timeshift.seek(offsetSec * 1000);
+    updateTimeshiftInfo();
+}
+
+void AudioDecoder::timeshiftLive()
+{
+    m_timeshift.goLive();
+    m_timeshiftPaused = false;
+    updateTimeshiftInfo();
+}
+
+void AudioDecoder::updateTimeshiftInfo()
+{
+    int delaySec = m_timeshift.delayMs() / 1000;
+    int bufferedSec = m_timeshift.bufferedMs() / 1000;
+    if ((m_timeshiftPaused != m_timeshiftInfoPaused) || (delaySec != m_timeshiftDelaySec) || (bufferedSec != m_timeshiftBufferedSec))
+    {   // emitted approximately once per second
+        m_timeshiftInfoPaused = m_timeshiftPaused;
+        m_timeshiftDelaySec = delaySec;
+        m_timeshiftBufferedSec = bufferedSec;
+        emit timeshiftInfo(m_timeshiftPaused, delaySec, bufferedSec);
+    }
+}
+
 void AudioDecoder::setNoiseConcealment(int level)
 {
 #if !HAVE_FDKAAC && AUDIO_DECODER_NOISE_CONCEALMENT
@@ -534,7 +737,8 @@ void AudioDecoder::processMP2(RadioControlAudioData *inData)
 
         /* Feed input chunk and get first chunk of decoded audio. */
         size_t size;
-        int ret = mpg123_decode(m_mp2DecoderHandle, &inData->data[0], inData->data.size(), m_outBufferPtr, AUDIO_DECODER_BUFFER_SIZE * sizeof(int16_t), &size);
+        audioSample_t * outPtr = reserveOutput();
+        int ret = mpg123_decode(m_mp2DecoderHandle, &inData->data[0], inData->data.size(), outPtr, AUDIO_DECODER_BUFFER_SIZE * sizeof(audioSample_t), &size);
         if ((MPG123_NEW_FORMAT == ret) || (inData->id != m_inputDataDecoderId))
         {   // this is stream reconfiguration or announcement (different instance)
             long sampleRate;
@@ -556,14 +760,14 @@ void AudioDecoder::processMP2(RadioControlAudioData *inData)
             m_mp2DRC = 0;
         }
 
-        m_outputBufferSamples = size / sizeof(int16_t);
+        m_outputBufferSamples = size / sizeof(audioSample_t);
 
         // there should be nothing more to decode, but try to be sure
         while (ret != MPG123_ERR && ret != MPG123_NEED_MORE)
         {   // Get all decoded audio that is available now before feeding more input
-            ret = mpg123_decode(m_mp2DecoderHandle, NULL, 0, m_outBufferPtr + m_outputBufferSamples, (AUDIO_DECODER_BUFFER_SIZE - m_outputBufferSamples) * sizeof(int16_t), &size);
+            ret = mpg123_decode(m_mp2DecoderHandle, NULL, 0, outPtr + m_outputBufferSamples, (AUDIO_DECODER_BUFFER_SIZE - m_outputBufferSamples) * sizeof(audioSample_t), &size);
 
-            m_outputBufferSamples += size / sizeof(int16_t);
+            m_outputBufferSamples += size / sizeof(audioSample_t);
 
             if ((0 == size) || (m_outputBufferSamples >= AUDIO_DECODER_BUFFER_SIZE))
             {
@@ -577,41 +781,14 @@ void AudioDecoder::processMP2(RadioControlAudioData *inData)
         if (m_mp2DRC != 0)
         {   // multiply buffer by gain
             float gain = pow(10, m_mp2DRC * 0.0125);    // 0.0125 = 1/(4*20)
-            for (int n = 0; n < m_outputBufferSamples; ++n)     // considering int16_t data => 2 bytes
+            for (int n = 0; n < m_outputBufferSamples; ++n)
             {   // multiply all samples by gain
-                m_outBufferPtr[n] = int16_t(qRound(m_outBufferPtr[n] * gain));
+                outPtr[n] = audioSampleRound(outPtr[n] * gain);
             }
         }
 #endif // MP2_DRC_ENABLE
 
-        int64_t bytesToWrite = m_outputBufferSamples * sizeof(int16_t);
-
-        // wait for space in ouput buffer
-        m_outFifoPtr->mutex.lock();
-        uint64_t count = m_outFifoPtr->count;
-        while (int64_t(AUDIO_FIFO_SIZE - count) < bytesToWrite)
-        {
-            m_outFifoPtr->countChanged.wait(&m_outFifoPtr->mutex);
-            count = m_outFifoPtr->count;
-        }
-        m_outFifoPtr->mutex.unlock();
-
-        int64_t bytesToEnd = AUDIO_FIFO_SIZE - m_outFifoPtr->head;
-        if (bytesToEnd < bytesToWrite)
-        {
-            memcpy(m_outFifoPtr->buffer + m_outFifoPtr->head, m_outBufferPtr, bytesToEnd);
-            memcpy(m_outFifoPtr->buffer, reinterpret_cast<uint8_t *>(m_outBufferPtr) + bytesToEnd, bytesToWrite - bytesToEnd);
-            m_outFifoPtr->head = bytesToWrite - bytesToEnd;
-        }
-        else
-        {
-            memcpy(m_outFifoPtr->buffer + m_outFifoPtr->head, m_outBufferPtr, bytesToWrite);
-            m_outFifoPtr->head += bytesToWrite;
-        }
-
-        m_outFifoPtr->mutex.lock();
-        m_outFifoPtr->count += bytesToWrite;
-        m_outFifoPtr->mutex.unlock();
+        writeOutput();
     }
     // store DRC for next frame
     m_mp2DRC = inData->header.mp2DRC;
@@ -738,7 +915,12 @@ void AudioDecoder::processAAC(RadioControlAudioData *inData)
     }
 
     // decode audio
-    result = aacDecoder_DecodeFrame(m_aacDecoderHandle, (INT_PCM *)m_outBufferPtr, m_outputBufferSamples, AACDEC_CONCEAL * conceal);
+    audioSample_t * outPtr = reserveOutput();
+#if HAVE_AUDIO_FLOAT32
+    result = aacDecoder_DecodeFrame(m_aacDecoderHandle, (INT_PCM *)m_pcmBufferPtr, m_outputBufferSamples, AACDEC_CONCEAL * conceal);
+#else
+    result = aacDecoder_DecodeFrame(m_aacDecoderHandle, (INT_PCM *)outPtr, m_outputBufferSamples, AACDEC_CONCEAL * conceal);
+#endif
     if (AAC_DEC_OK != result)
     {
         qCWarning(audioDecoder) << "Error decoding AAC frame:" << result;
@@ -749,34 +931,11 @@ void AudioDecoder::processAAC(RadioControlAudioData *inData)
         return;
     }
 
-    int64_t bytesToWrite = m_outputBufferSamples * sizeof(int16_t);
-
-    // wait for space in ouput buffer
-    m_outFifoPtr->mutex.lock();
-    uint64_t count = m_outFifoPtr->count;
-    while (int64_t(AUDIO_FIFO_SIZE - count) < bytesToWrite)
-    {
-        m_outFifoPtr->countChanged.wait(&m_outFifoPtr->mutex);
-        count = m_outFifoPtr->count;
-    }
-    m_outFifoPtr->mutex.unlock();
-
-    int64_t bytesToEnd = AUDIO_FIFO_SIZE - m_outFifoPtr->head;
-    if (bytesToEnd < bytesToWrite)
-    {
-        memcpy(m_outFifoPtr->buffer + m_outFifoPtr->head, m_outBufferPtr, bytesToEnd);
-        memcpy(m_outFifoPtr->buffer, reinterpret_cast<uint8_t *>(m_outBufferPtr) + bytesToEnd, bytesToWrite - bytesToEnd);
-        m_outFifoPtr->head = bytesToWrite - bytesToEnd;
-    }
-    else
-    {
-        memcpy(m_outFifoPtr->buffer + m_outFifoPtr->head, m_outBufferPtr, bytesToWrite);
-        m_outFifoPtr->head += bytesToWrite;
-    }
+#if HAVE_AUDIO_FLOAT32
+    AudioKernels::scale(m_pcmBufferPtr, outPtr, m_outputBufferSamples, 1.0);
+#endif
 
-    m_outFifoPtr->mutex.lock();
-    m_outFifoPtr->count += bytesToWrite;
-    m_outFifoPtr->mutex.unlock();
+    writeOutput();
 #else // HAVE_FDKAAC
     uint8_t * outputFrame = (uint8_t *)NeAACDecDecode(m_aacDecoderHandle, &m_aacDecFrameInfo, &inData->data[0], inData->data.size());
 
@@ -787,42 +946,23 @@ void AudioDecoder::processAAC(RadioControlAudioData *inData)
 #if !HAVE_FDKAAC
 void AudioDecoder::handleAudioOutputFAAD(const NeAACDecFrameInfo&frameInfo, const uint8_t *inFramePtr)
 {
+    // output is delayed by one frame in intermediate buffer (mute ramp is applied to previous frame)
+    m_outPtr = m_outBufferPtr;
+    m_outReservedFifo = nullptr;
+
     if (frameInfo.samples != m_outputBufferSamples)
     {
         if (OutputState::Unmuted == m_state)
         {   // do mute
-#if AUDIO_DECODER_NOISE_CONCEALMENT
-            // read noise samples
             qCInfo(audioDecoder) << "Muting audio (decoding errors)";
-            int valuesToRead = m_muteRamp.size()*m_numChannels;
-            if (nullptr != m_noiseFile)
-            {
-                if (m_noiseFile->bytesAvailable() < valuesToRead*sizeof(int16_t))
-                {
-                    m_noiseFile->seek(0);
-                }
-                m_noiseFile->read((char *) m_noiseBufferPtr, valuesToRead*sizeof(int16_t));
-            }
-            int16_t * noisePtr = m_noiseBufferPtr;
-#else
-
-#endif
 
-            int16_t * dataPtr = &m_outBufferPtr[m_outputBufferSamples - 1];  // last sample
-            std::vector <float>::const_iterator it = m_muteRamp.cbegin();            
-            while (it != m_muteRamp.end())
-            {
-                float gain = *it++;
-                for (uint_fast32_t ch = 0; ch < m_numChannels; ++ch)
-                {
+            // mute ramp is applied to the end of the last buffer
+            audioSample_t * dataPtr = &m_outBufferPtr[m_outputBufferSamples - m_muteRamp.size()];
 #if AUDIO_DECODER_NOISE_CONCEALMENT
-                    *dataPtr = int16_t(qRound(gain * *dataPtr)) + (1-gain) * m_noiseLevel * *noisePtr++;
+            AudioKernels::applyRamp(dataPtr, m_muteRamp.data(), m_muteRamp.size(), readNoise(m_muteRamp.size()), m_noiseLevel);
 #else
-                    *dataPtr = int16_t(qRound(gain * *dataPtr));
+            AudioKernels::applyRamp(dataPtr, m_muteRamp.data(), m_muteRamp.size(), nullptr, 0.0);
 #endif
-                    --dataPtr;
-                }
-            }
         }
         else if (OutputState::Init == m_state)
         {   // do nothing and return -> decoder is initializing
@@ -834,137 +974,141 @@ void AudioDecoder::handleAudioOutputFAAD(const NeAACDecFrameInfo&frameInfo, cons
 
     if (OutputState::Init == m_state)
     {   // only copy to internal buffer -> this is the first buffer
-        memcpy(m_outBufferPtr, inFramePtr, m_outputBufferSamples * sizeof(int16_t));
+        memcpy(m_outBufferPtr, inFramePtr, m_outputBufferSamples * sizeof(audioSample_t));
 
         // apply unmute ramp
-        int16_t * dataPtr = &m_outBufferPtr[0];  // first sample
-        std::vector <float>::const_iterator it = m_muteRamp.cbegin();
-        while (it != m_muteRamp.end())
-        {
-            float gain = *it++;
-            for (uint_fast32_t ch = 0; ch < m_numChannels; ++ch)
-            {
-                *dataPtr = int16_t(qRound(gain * *dataPtr));
-                dataPtr += 1;
-            }
-        }
+        AudioKernels::applyRamp(m_outBufferPtr, m_unmuteRamp.data(), m_unmuteRamp.size(), nullptr, 0.0);
 
-        m_state = OutputState::Unmuted;                
+        m_state = OutputState::Unmuted;
         return;
     }
 
     // copy data to output FIFO
-    int64_t bytesToWrite = m_outputBufferSamples * sizeof(int16_t);
-
-    // wait for space in ouput buffer
-    m_outFifoPtr->mutex.lock();
-    uint64_t count = m_outFifoPtr->count;
-    while (int64_t(AUDIO_FIFO_SIZE - count) < bytesToWrite)
-    {
-        m_outFifoPtr->countChanged.wait(&m_outFifoPtr->mutex);
-        count = m_outFifoPtr->count;
-    }
-    m_outFifoPtr->mutex.unlock();
-
-    int64_t bytesToEnd = AUDIO_FIFO_SIZE - m_outFifoPtr->head;
-    if (bytesToEnd < bytesToWrite)
-    {
-        memcpy(m_outFifoPtr->buffer + m_outFifoPtr->head, m_outBufferPtr, bytesToEnd);
-        memcpy(m_outFifoPtr->buffer, reinterpret_cast<uint8_t *>(m_outBufferPtr) + bytesToEnd, bytesToWrite - bytesToEnd);
-        m_outFifoPtr->head = bytesToWrite - bytesToEnd;
-    }
-    else
-    {
-        memcpy(m_outFifoPtr->buffer + m_outFifoPtr->head, m_outBufferPtr, bytesToWrite);
-        m_outFifoPtr->head += bytesToWrite;
-    }
-
-    m_outFifoPtr->mutex.lock();
-    m_outFifoPtr->count += bytesToWrite;
-    m_outFifoPtr->mutex.unlock();
+    writeOutput();
 
     // copy new data to buffer
     if (frameInfo.samples != m_outputBufferSamples)
     {   // error
 #if AUDIO_DECODER_NOISE_CONCEALMENT
-        // read noise
-        int valuesToRead = m_outputBufferSamples;
-        if (nullptr != m_noiseFile)
+        // copy noise
+        const int16_t * noisePtr = readNoise(m_outputBufferSamples);
+        if (nullptr != noisePtr)
         {
-            if (m_noiseFile->bytesAvailable() < valuesToRead*sizeof(int16_t))
-            {
-                m_noiseFile->seek(0);
-            }
-            m_noiseFile->read((char *) m_noiseBufferPtr, valuesToRead*sizeof(int16_t));
+            AudioKernels::scale(noisePtr, m_outBufferPtr, m_outputBufferSamples, m_noiseLevel);
         }
-        // copy noise
-        int16_t * dataPtr = m_outBufferPtr;
-        int16_t * noisePtr = m_noiseBufferPtr;
-        for (int n = 0; n < m_outputBufferSamples; ++n)
+        else
         {
-            *dataPtr++ = m_noiseLevel * *noisePtr++;
+            memset(m_outBufferPtr, 0, m_outputBufferSamples * sizeof(audioSample_t));
         }
         m_state = OutputState::Muted;
 #else
         if (OutputState::Unmuted == m_state)
         {   // copy 0
-            memset(m_outBufferPtr, 0, m_outputBufferSamples * sizeof(int16_t));
+            memset(m_outBufferPtr, 0, m_outputBufferSamples * sizeof(audioSample_t));
             m_state = OutputState::Muted;
         }
 #endif
     }
     else
     {   // OK
-        memcpy(m_outBufferPtr, inFramePtr, m_outputBufferSamples * sizeof(int16_t));
+        memcpy(m_outBufferPtr, inFramePtr, m_outputBufferSamples * sizeof(audioSample_t));
 
         if (OutputState::Muted == m_state)
         {   // do unmute
             qCInfo(audioDecoder) << "Umuting audio";
-#if AUDIO_DECODER_NOISE_CONCEALMENT
-            // read noise
-            int valuesToRead = m_muteRamp.size()*m_numChannels;
-            if (nullptr != m_noiseFile)
-            {
-                if (m_noiseFile->bytesAvailable() < valuesToRead*sizeof(int16_t))
-                {
-                    m_noiseFile->seek(0);
-                }
-                m_noiseFile->read((char *) m_noiseBufferPtr, valuesToRead*sizeof(int16_t));
-            }
-            int16_t * noisePtr = m_noiseBufferPtr;
-#endif
 
             // apply unmute ramp
-            int16_t * dataPtr = &m_outBufferPtr[0];  // first sample
-            std::vector <float>::const_iterator it = m_muteRamp.cbegin();
-            while (it != m_muteRamp.end())
-            {
-                float gain = *it++;
-                for (uint_fast32_t ch = 0; ch < m_numChannels; ++ch)
-                {
 #if AUDIO_DECODER_NOISE_CONCEALMENT
-                    *dataPtr = int16_t(qRound(gain * *dataPtr)) + (1-gain) * m_noiseLevel * *noisePtr++;
+            AudioKernels::applyRamp(m_outBufferPtr, m_unmuteRamp.data(), m_unmuteRamp.size(), readNoise(m_unmuteRamp.size()), m_noiseLevel);
 #else
-                    *dataPtr = int16_t(qRound(gain * *dataPtr));
+            AudioKernels::applyRamp(m_outBufferPtr, m_unmuteRamp.data(), m_unmuteRamp.size(), nullptr, 0.0);
 #endif
-                    dataPtr += 1;
-                }
-            }
             m_state = OutputState::Unmuted;
         }
     }
 }
+
+#if AUDIO_DECODER_NOISE_CONCEALMENT
+const int16_t * AudioDecoder::readNoise(int numValues)
+{   // returns nullptr when noise concealment is disabled
+    if (nullptr == m_noiseFile)
+    {
+        return nullptr;
+    }
+
+    if (m_noiseFile->bytesAvailable() < numValues*sizeof(int16_t))
+    {
+        m_noiseFile->seek(0);
+    }
+    m_noiseFile->read((char *) m_noiseBufferPtr, numValues*sizeof(int16_t));
+    return m_noiseBufferPtr;
+}
+#endif
 #endif // HAVE_FDKAAC
 
+audioSample_t * AudioDecoder::reserveOutput()
+{   // decoder writes to contiguous space at FIFO head, intermediate buffer is used only when space would wrap
+    const int64_t maxBytes = AUDIO_DECODER_BUFFER_SIZE * sizeof(audioSample_t);
+    m_outFifoPtr->waitForSpace(maxBytes);
+    m_outPtr = m_outFifoPtr->reserveWrite(maxBytes);
+    if (nullptr != m_outPtr)
+    {
+        m_outReservedFifo = m_outFifoPtr;
+    }
+    else
+    {
+        m_outPtr = m_outBufferPtr;
+        m_outReservedFifo = nullptr;
+    }
+    return m_outPtr;
+}
+
+void AudioDecoder::writeOutput()
+{
+    int64_t bytesToWrite = m_outputBufferSamples * sizeof(audioSample_t);
+
+    if ((nullptr != m_outReservedFifo) && (m_outReservedFifo == m_outFifoPtr))
+    {   // samples are already in FIFO
+        m_outFifoPtr->commitWrite(bytesToWrite);
+    }
+    else
+    {   // intermediate buffer or output changed after reservation (new stream format)
+        // wait for space in ouput buffer
+        m_outFifoPtr->waitForSpace(bytesToWrite);
+        m_outFifoPtr->write(m_outPtr, bytesToWrite);
+    }
+    m_outFifoPtr->markCapture(m_captureUs);
+    m_outReservedFifo = nullptr;
+
+    if (nullptr != m_tap)
+    {   // consumers read it at their own pace
+        m_tap->write(m_outPtr, m_outputBufferSamples);
+    }
+    SharedMemoryExport * shm = SharedMemoryExport::instance();
+    if ((nullptr != shm) && m_isShmExport)
+    {
+        shm->writeAudio(m_outPtr, m_outputBufferSamples);
+    }
+}
+
 void AudioDecoder::setOutput(int sampleRate, int numChannels)
 {
     // toggle index 0->1 or 1->0
     m_outFifoIdx = (m_outFifoIdx + 1) & 0x1;
-    m_outFifoPtr = &audioFifo[m_outFifoIdx];
+    m_outFifoPtr = &m_audioFifo[m_outFifoIdx];
 
     m_outFifoPtr->sampleRate = sampleRate;
     m_outFifoPtr->numChannels = numChannels;
     m_outFifoPtr->reset();
+    if (nullptr != m_tap)
+    {
+        m_tap->setFormat(sampleRate, numChannels);
+    }
+    SharedMemoryExport * shm = SharedMemoryExport::instance();
+    if ((nullptr != shm) && m_isShmExport)
+    {
+        shm->setAudioFormat(sampleRate, numChannels);
+    }
 
     if (PlaybackState::Running == m_playbackState)
     {   // switch audio source
@@ -44,8 +44,12 @@
 #include "radiocontrol.h"
 #include "audiofifo.h"
 #include "audiorecorder.h"
+#include "audiotimeshift.h"
+#include "audiotap.h"
+#include "diagnostics.h"
 
 #define AUDIO_DECODER_BUFFER_SIZE     3840  // this is maximum buffer size for HE-AAC
+#define AUDIO_DECODER_AAC_CACHE_SIZE     4  // initialized AAC decoders kept for service switching
 #if HAVE_FDKAAC
 #define AUDIO_DECODER_FDKAAC_CONCEALMENT 1
 #define AUDIO_DECODER_NOISE_CONCEALMENT  0 // keep 0 here
@@ -84,12 +88,23 @@ public:
     void decodeData(RadioControlAudioData *inData);
     void getAudioParameters();
     void setNoiseConcealment(int level);
+    // decoded PCM is also copied to tap (meters), must be set before decoder is started
+    void setAudioTap(AudioTap * tap) { m_tap = tap; }
+    void setStreamSource(bool ena) { m_isStreamSource = ena; }    // original AUs are forwarded to AudioStreamServer
+    void setSharedMemoryExport(bool ena) { m_isShmExport = ena; } // decoded PCM is written to shared memory audio ring
+
+    // timeshift of current service, 0 minutes disables it
+    void setTimeshift(int durationMin);
+    void timeshiftPause(bool pause);
+    void timeshiftSkip(int offsetSec);
+    void timeshiftLive();
 
 signals:
     void startAudio(audioFifo_t *buffer);
     void switchAudio(audioFifo_t *buffer);
     void stopAudio();
     void audioParametersInfo(const AudioParameters & params);
+    void timeshiftInfo(bool isPaused, int delaySec, int bufferedSec);
 
 private:
     enum class PlaybackState { Stopped = 0, WaitForInit, Running } m_playbackState;
@@ -99,28 +114,58 @@ private:
     dabsdrAudioFrameHeader_t m_aacHeader;
     AudioParameters m_audioParameters;
 
-    int16_t * m_outBufferPtr;
+    audioSample_t * m_outBufferPtr;
+    audioSample_t * m_outPtr;               // decoded samples, reserved space in output FIFO or m_outBufferPtr
+    audioFifo_t * m_outReservedFifo = nullptr;
     size_t m_outputBufferSamples;
 #if HAVE_FDKAAC
-    HANDLE_AACDECODER m_aacDecoderHandle;
+    HANDLE_AACDECODER m_aacDecoderHandle;     // active decoder (from cache)
+#if HAVE_AUDIO_FLOAT32
+    int16_t * m_pcmBufferPtr;       // FDK-AAC output is always int16, it is converted to float
+#endif
 #else
-    NeAACDecHandle m_aacDecoderHandle;
+    NeAACDecHandle m_aacDecoderHandle;        // active decoder (from cache)
     NeAACDecFrameInfo m_aacDecFrameInfo;
     void handleAudioOutputFAAD(const NeAACDecFrameInfo & frameInfo, const uint8_t * inFramePtr);
 #endif
     int m_ascLen;
     uint8_t m_asc[7];
 
+    // decoders are initialized once for each configuration (AudioSpecificConfig) and reused
+    // service switch within ensemble then only resets decoder state
+    struct AACDecoderCacheEntry
+    {
+#if HAVE_FDKAAC
+        HANDLE_AACDECODER handle = nullptr;
+#else
+        NeAACDecHandle handle = nullptr;
+        unsigned long sampleRate;
+        unsigned char numChannels;
+#endif
+        int ascLen = 0;
+        uint8_t asc[7];
+        uint64_t lastUse = 0;
+    } m_aacDecoderCache[AUDIO_DECODER_AAC_CACHE_SIZE];
+    uint64_t m_aacDecoderUseCntr = 0;
+
     float m_mp2DRC = 0;
-    mpg123_handle * m_mp2DecoderHandle;
+    mpg123_handle * m_mp2DecoderHandle;       // active decoder
+    mpg123_handle * m_mp2DecoderCache;        // MP2 decoder is created only once
 
     dabsdrDecoderId_t m_inputDataDecoderId;
+    audioFifo_t m_audioFifo[2];   // each decoder instance has its own output buffers
+    DiagnosticsMemoryCounter m_memory { DiagnosticsMemory::AudioFifo };
     int m_outFifoIdx;
     audioFifo_t * m_outFifoPtr;
+    uint64_t m_captureUs = 0;     // capture time of input of AU being decoded, output FIFO is marked with it
+    AudioTap * m_tap = nullptr;
+    bool m_isStreamSource = false;
+    bool m_isShmExport = false;
 
 #if !HAVE_FDKAAC
     int m_numChannels;
-    std::vector<float> m_muteRamp;
+    std::vector<float> m_unmuteRamp;   // sin^2 gain 0 -> 1, one value per sample value (channels interleaved)
+    std::vector<float> m_muteRamp;     // unmute ramp in reversed order
     enum class OutputState
     {
         Init = 0,
@@ -131,17 +176,31 @@ private:
     QFile * m_noiseFile = nullptr;
     int16_t * m_noiseBufferPtr;
     float m_noiseLevel;
+    const int16_t * readNoise(int numValues);
 #endif
 #endif
+    AudioTimeshift m_timeshift;
+    int m_timeshiftSec = 0;
+    bool m_timeshiftPaused = false;
+    RadioControlAudioData m_timeshiftData;      // AU read from timeshift buffer
+    bool m_timeshiftInfoPaused = false;    // last emitted info
+    int m_timeshiftDelaySec = 0;
+    int m_timeshiftBufferedSec = 0;
+    void updateTimeshiftInfo();
+
     void setOutput(int sampleRate, int numChannels);
+    audioSample_t * reserveOutput();       // space for decoder output, directly in output FIFO when possible
+    void writeOutput();                    // m_outPtr to output FIFO and tap
 
     void readAACHeader();
     void initAACDecoder();
-    void deinitAACDecoder();
+    void deinitAACDecoder();               // decoder stays in cache
+    AACDecoderCacheEntry * getAACDecoder();
     void processAAC(RadioControlAudioData *inData);
 
+    void createMPG123();
     void initMPG123();
-    void deinitMPG123();
+    void deinitMPG123();                   // decoder stays in cache
     void processMP2(RadioControlAudioData *inData);
     void getFormatMP2();
 };
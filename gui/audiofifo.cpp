@@ -24,13 +24,163 @@
  * SOFTWARE.
  */
 
+#include <cstring>
 #include "audiofifo.h"
 
-void AudioFifo::reset()
-{
-    mutex.lock();
+template <typename T>
+void AudioFifoT<T>::reset()
+{   // called when neither reader nor writer is running
     count = 0;
     head = 0;
     tail = 0;
-    mutex.unlock();
-};
+    writeTotal = 0;
+    readTotal = 0;
+    timestamps.reset();
+    writerWaiting = false;
+    spaceAvailable.tryAcquire(spaceAvailable.available());
+}
+
+template <typename T>
+void AudioFifoT<T>::commitRead(int64_t bytes)
+{
+    readTotal.fetch_add(bytes, std::memory_order_relaxed);
+    count.fetch_sub(bytes);
+    if (writerWaiting.load() && writerWaiting.exchange(false))
+    {   // semaphore does not block when there is no waiting thread
+        spaceAvailable.release();
+    }
+    else { /* writer is not waiting */ }
+}
+
+template <typename T>
+void AudioFifoT<T>::read(void *data, int64_t bytes)
+{
+    int64_t bytesToEnd = size - tail;
+    if (bytesToEnd < bytes)
+    {
+        memcpy(data, buffer + tail, bytesToEnd);
+        memcpy(static_cast<uint8_t *>(data) + bytesToEnd, buffer, bytes - bytesToEnd);
+        tail = bytes - bytesToEnd;
+    }
+    else
+    {
+        memcpy(data, buffer + tail, bytes);
+        tail += bytes;
+    }
+    commitRead(bytes);
+}
+
+template <typename T>
+void AudioFifoT<T>::discard(int64_t bytes)
+{
+    tail = (tail + bytes) % size;
+    commitRead(bytes);
+}
+
+template <typename T>
+void AudioFifoT<T>::waitForSpace(int64_t bytes)
+{
+    while (int64_t(size - count.load()) < bytes)
+    {
+        writerWaiting = true;
+
+        // check again, reader could consume data before writerWaiting was set
+        if (int64_t(size - count.load()) >= bytes)
+        {
+            writerWaiting = false;
+            break;
+        }
+        spaceAvailable.tryAcquire(1, AUDIO_FIFO_WAIT_MS);
+    }
+}
+
+template <typename T>
+void AudioFifoT<T>::write(const void *data, int64_t bytes)
+{
+    int64_t bytesToEnd = size - head;
+    if (bytesToEnd < bytes)
+    {
+        memcpy(buffer + head, data, bytesToEnd);
+        memcpy(buffer, static_cast<const uint8_t *>(data) + bytesToEnd, bytes - bytesToEnd);
+        head = bytes - bytesToEnd;
+    }
+    else
+    {
+        memcpy(buffer + head, data, bytes);
+        head += bytes;
+    }
+    writeTotal.fetch_add(bytes, std::memory_order_relaxed);
+    count.fetch_add(bytes, std::memory_order_release);
+}
+
+template <typename T>
+void AudioFifoT<T>::commitWrite(int64_t bytes)
+{
+    head = (head + bytes) % size;
+    writeTotal.fetch_add(bytes, std::memory_order_relaxed);
+    count.fetch_add(bytes, std::memory_order_release);
+}
+
+template <typename T>
+void AudioFifoT<T>::markCapture(uint64_t captureUs)
+{
+    if (0 != captureUs)
+    {
+        timestamps.mark(writeTotal.load(std::memory_order_relaxed), captureUs);
+    }
+    else { /* unknown (e.g. timeshift) */ }
+}
+
+template <typename T>
+uint64_t AudioFifoT<T>::captureUs() const
+{
+    double bytesPerUs = sampleRate * 1e-6 * numChannels * sizeof(T);
+    return timestamps.captureUs(readTotal.load(std::memory_order_relaxed), bytesPerUs);
+}
+
+template struct AudioFifoT<int16_t>;
+template struct AudioFifoT<float>;
+
+AudioFifoDrain::AudioFifoDrain(QObject *parent) : QThread(parent)
+{
+    m_inFifoPtr = nullptr;
+    m_exitRequest = false;
+}
+
+void AudioFifoDrain::start(audioFifo_t *buffer)
+{
+    m_inFifoPtr = buffer;
+    if (!isRunning())
+    {
+        QThread::start();
+    }
+}
+
+void AudioFifoDrain::stop()
+{
+    m_inFifoPtr = nullptr;
+}
+
+void AudioFifoDrain::finish()
+{
+    m_exitRequest = true;
+    wait();
+}
+
+void AudioFifoDrain::run()
+{
+    while (!m_exitRequest)
+    {
+        audioFifo_t * fifo = m_inFifoPtr;
+        if (nullptr != fifo)
+        {
+            int64_t count = fifo->availableBytes();
+            if (count > 0)
+            {
+                fifo->tail = (fifo->tail + count) % AUDIO_FIFO_SIZE;
+                fifo->commitRead(count);
+            }
+        }
+        QThread::msleep(AUDIO_FIFO_DRAIN_PERIOD_MS);
+    }
+}
@@ -27,28 +27,107 @@
 #ifndef AUDIOFIFO_H
 #define AUDIOFIFO_H
 
-#include <QMutex>
-#include <QWaitCondition>
+#include <QSemaphore>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include "config.h"
+#include "sampletimestamps.h"
+
+// audio sample type used from decoder to audio output
+#if HAVE_AUDIO_FLOAT32
+typedef float audioSample_t;        // normalized to [-1.0, 1.0)
+#define AUDIO_SAMPLE_MAX  (1.0f)
+#else
+typedef int16_t audioSample_t;
+#define AUDIO_SAMPLE_MAX  (32768.0f)
+#endif
 
 #define AUDIO_FIFO_CHUNK_MS   (60)
 #define AUDIO_FIFO_MS         (32 * AUDIO_FIFO_CHUNK_MS)
-#define AUDIO_FIFO_SIZE       (48 * AUDIO_FIFO_MS * 2 * sizeof(int16_t))  // FS - 48kHz, stereo, int16_t samples
+#define AUDIO_FIFO_SIZE_T(T)  (48 * AUDIO_FIFO_MS * 2 * sizeof(T))   // FS - 48kHz, stereo
+#define AUDIO_FIFO_SIZE       AUDIO_FIFO_SIZE_T(audioSample_t)
+#define AUDIO_FIFO_DRAIN_PERIOD_MS  (10)
+#define AUDIO_FIFO_WAIT_MS          (100)   // writer rechecks space after this timeout
 
+// value in audioSample_t scale is rounded and saturated (no-op for float)
+static inline audioSample_t audioSampleRound(float value)
+{
+#if HAVE_AUDIO_FLOAT32
+    return value;
+#else
+    return int16_t(std::lroundf(std::clamp(value, -32768.0f, 32767.0f)));
+#endif
+}
 
-struct AudioFifo
+// single producer (decoder) single consumer (audio output) ring buffer
+// reader never takes a lock, it is called from real-time audio callback
+// writer waits on semaphore only when there is not enough space
+// buffer size is 32 chunks of stereo 48kHz samples of type T, all positions are in bytes
+template <typename T>
+struct AudioFifoT
 {
+    typedef T sample_t;
+    static constexpr int64_t size = AUDIO_FIFO_SIZE_T(T);
+
     uint32_t sampleRate;
     uint8_t numChannels;
     std::atomic<int64_t> count;
-    int64_t head;
-    int64_t tail;
-    uint8_t buffer[AUDIO_FIFO_SIZE];
-    QWaitCondition countChanged;
-    QMutex mutex;
+    int64_t head;   // writer only
+    int64_t tail;   // reader only
+    alignas(16) uint8_t buffer[AUDIO_FIFO_SIZE_T(T)];
+    std::atomic<bool> writerWaiting;
+    QSemaphore spaceAvailable;
+
+    // capture time of input samples the audio was decoded from, positions are total bytes
+    std::atomic<uint64_t> writeTotal;
+    std::atomic<uint64_t> readTotal;
+    SampleTimestamps timestamps;
+
     void reset();
+
+    // reader side
+    int64_t availableBytes() const { return count.load(std::memory_order_acquire); }
+    void commitRead(int64_t bytes);
+    void read(void * data, int64_t bytes);      // copy from tail and commit
+    void discard(int64_t bytes);                // oldest samples are dropped
+    uint64_t captureUs() const;                 // capture time of the oldest sample in FIFO, 0 if unknown
+
+    // writer side
+    void waitForSpace(int64_t bytes);
+    void write(const void * data, int64_t bytes);
+
+    // writer side without copy: data are written directly at head and then committed
+    // returns nullptr when requested space is not contiguous (it would wrap), caller waits for space before
+    T * reserveWrite(int64_t bytes) { return (size - head >= bytes) ? reinterpret_cast<T *>(buffer + head) : nullptr; }
+    void commitWrite(int64_t bytes);
+    void markCapture(uint64_t captureUs);       // samples written so far were decoded from input captured at captureUs
 };
 
-typedef struct AudioFifo audioFifo_t;
+// both sample types are instantiated in audiofifo.cpp
+extern template struct AudioFifoT<int16_t>;
+extern template struct AudioFifoT<float>;
+
+typedef AudioFifoT<audioSample_t> AudioFifo;
+typedef AudioFifo audioFifo_t;
+
+// used instead of audio output when decoded audio is only recorded
+// samples are discarded so that decoder never waits for space in FIFO
+class AudioFifoDrain : public QThread
+{
+    Q_OBJECT
+public:
+    explicit AudioFifoDrain(QObject *parent = nullptr);
+    void start(audioFifo_t *buffer);
+    void stop();
+    void finish();
+protected:
+    void run() override;
+private:
+    std::atomic<audioFifo_t *> m_inFifoPtr;
+    std::atomic<bool> m_exitRequest;
+};
 
 //extern audioFifo_t audioBuffer[2];
 
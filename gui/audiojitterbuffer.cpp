@@ -0,0 +1,98 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "audiojitterbuffer.h"
+
+void AudioJitterBuffer::reset(uint32_t sampleRate_kHz, uint8_t numChannels)
+{
+    m_sampleRate_kHz = sampleRate_kHz;
+    m_numChannels = numChannels;
+    m_maxFrames = AUDIO_JB_MAX_FRAMES_MS * m_sampleRate_kHz;
+
+    // max input frames is max output frames * max ratio + 1
+    uint32_t maxInputFrames = m_maxFrames + m_maxFrames / 100 + 2;
+    m_buffer.assign(maxInputFrames * m_numChannels, 0);
+    m_resampler.reset(m_numChannels, maxInputFrames);
+
+    m_targetFrames = configuredFrames();
+    m_fillLevel = m_targetFrames;
+    m_windowMin = UINT64_MAX;
+    m_windowMax = 0;
+    m_windowFrames = 0;
+    m_jitterFrames = 0;
+    m_integrator = 0.0f;
+    m_ratio = 1.0;
+    m_phase = 0.0;
+}
+
+void AudioJitterBuffer::update(uint64_t availableFrames, uint32_t outputFrames)
+{
+    // jitter of decoder output is measured as peak to peak fill level variation in window
+    m_windowMin = std::min(m_windowMin, availableFrames);
+    m_windowMax = std::max(m_windowMax, availableFrames);
+    m_windowFrames += outputFrames;
+    if (m_windowFrames >= AUDIO_JB_WINDOW_MS * m_sampleRate_kHz)
+    {   // fast attack, slow release
+        uint64_t jitter = m_windowMax - m_windowMin;
+        m_jitterFrames = (jitter > m_jitterFrames) ? jitter : (m_jitterFrames + jitter) / 2;
+        m_windowMin = UINT64_MAX;
+        m_windowMax = 0;
+        m_windowFrames = 0;
+    }
+
+    // minimum fill level must stay above one output buffer
+    uint64_t minTarget = outputFrames + AUDIO_JB_MARGIN_MS * m_sampleRate_kHz + m_jitterFrames;
+    m_targetFrames = std::max(configuredFrames(), minTarget);
+
+    // PI controller of drift compensation, integrator is limited to avoid windup
+    m_fillLevel += AUDIO_JB_FILL_ALPHA * (float(availableFrames) - m_fillLevel);
+    float err = (m_fillLevel - float(m_targetFrames)) / float(m_targetFrames);
+    float maxDev = AUDIO_JB_MAX_PPM * 1e-6f;
+    m_integrator = std::clamp(m_integrator + AUDIO_JB_LOOP_INT_GAIN * err, -maxDev, maxDev);
+    m_ratio = 1.0 + std::clamp(AUDIO_JB_LOOP_GAIN * err + m_integrator, -maxDev, maxDev);
+}
+
+uint64_t AudioJitterBuffer::configuredFrames() const
+{
+    int latencyMs = m_targetLatencyMs;
+    return uint64_t((latencyMs > 0) ? latencyMs : AUDIO_JB_DEFAULT_LATENCY_MS) * m_sampleRate_kHz;
+}
+
+uint32_t AudioJitterBuffer::inputFrames(uint32_t outputFrames)
+{
+    double frames = m_phase + m_ratio * outputFrames;
+    uint32_t numFrames = uint32_t(frames);
+    m_phase = frames - numFrames;
+    return numFrames;
+}
+
+void AudioJitterBuffer::process(audioSample_t *out, uint32_t numInFrames, uint32_t numOutFrames, float volume)
+{
+    m_resampler.process(m_buffer.data(), numInFrames, out, numOutFrames, volume);
+}
@@ -0,0 +1,97 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIOJITTERBUFFER_H
+#define AUDIOJITTERBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "audioresampler.h"
+
+// drift compensation is used also with default latency
+#define AUDIO_JB_DRIFT_COMPENSATION  1
+
+#define AUDIO_JB_DEFAULT_LATENCY_MS (400)   // target latency when not configured
+#define AUDIO_JB_WINDOW_MS        (2000)   // fill level statistics window
+#define AUDIO_JB_MARGIN_MS          (20)   // minimum fill level kept above one output buffer
+#define AUDIO_JB_MAX_FRAMES_MS     (500)   // max length of one output buffer
+#define AUDIO_JB_MAX_PPM          (2000)   // max deviation of resampling ratio => inaudible pitch change
+#define AUDIO_JB_LOOP_GAIN       (0.01f)   // ratio deviation per relative fill level error
+#define AUDIO_JB_LOOP_INT_GAIN  (0.0002f)   // integral part removes steady error caused by clock drift
+#define AUDIO_JB_FILL_ALPHA      (0.05f)   // fill level IIR filter coefficient
+
+// adaptive jitter buffer for audio output
+// it keeps audio FIFO fill level around target latency by gentle resampling instead of mute/unmute cycles
+// resampling ratio is controlled by fill level => compensates drift between DAB and sound card clock
+// all functions except setTargetLatency() are called from audio output callback only
+class AudioJitterBuffer
+{
+public:
+    // 0 means default latency, jitter buffer is then disabled without drift compensation
+    void setTargetLatency(int latencyMs) { m_targetLatencyMs = latencyMs; }
+    bool isEnabled() const { return AUDIO_JB_DRIFT_COMPENSATION || (m_targetLatencyMs > 0); }
+
+    void reset(uint32_t sampleRate_kHz, uint8_t numChannels);
+
+    // called at the beginning of every callback with FIFO fill level
+    void update(uint64_t availableFrames, uint32_t outputFrames);
+    uint64_t targetFrames() const { return m_targetFrames; }
+
+    // number of input frames to be read from FIFO for outputFrames of output
+    uint32_t inputFrames(uint32_t outputFrames);
+    uint32_t maxOutputFrames() const { return m_maxFrames; }
+
+    // samples are read to this buffer, numFrames of inputFrames() fits there
+    audioSample_t * inputBuffer() { return m_buffer.data(); }
+
+    // resampling of numInFrames from inputBuffer() to numOutFrames, volume is applied
+    void process(audioSample_t * out, uint32_t numInFrames, uint32_t numOutFrames, float volume);
+
+private:
+    std::atomic<int> m_targetLatencyMs = 0;
+    uint32_t m_sampleRate_kHz = 48;
+    uint8_t m_numChannels = 2;
+    uint32_t m_maxFrames = 0;
+
+    uint64_t m_targetFrames = 0;
+    float m_fillLevel = 0;
+    uint64_t m_windowMin = 0;
+    uint64_t m_windowMax = 0;
+    uint64_t m_windowFrames = 0;
+    uint64_t m_jitterFrames = 0;
+    float m_integrator = 0.0f;
+    double m_ratio = 1.0;
+    double m_phase = 0.0;
+
+    std::vector<audioSample_t> m_buffer;
+    AudioResampler m_resampler;
+
+    uint64_t configuredFrames() const;
+};
+
+#endif // AUDIOJITTERBUFFER_H
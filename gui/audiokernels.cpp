@@ -0,0 +1,398 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AUDIOKERNELS_SSE2 1
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define AUDIOKERNELS_NEON 1
+#endif
+
+#include "audiokernels.h"
+
+#define AUDIOKERNELS_S16_TO_FLOAT  (1.0f / 32768.0f)
+
+static inline int16_t saturate(float value)
+{
+    long res = std::lroundf(value);
+    if (res > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (res < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+    return int16_t(res);
+}
+
+// generic implementation, also used for the last incomplete block
+static void scale_generic(const int16_t * in, int16_t * out, uint32_t len, float gain)
+{
+    for (uint32_t k = 0; k < len; ++k)
+    {
+        out[k] = saturate(gain * in[k]);
+    }
+}
+
+static void applyRamp_generic(int16_t * data, const float * ramp, uint32_t len, const int16_t * noise, float noiseLevel)
+{
+    if (nullptr == noise)
+    {
+        for (uint32_t k = 0; k < len; ++k)
+        {
+            data[k] = saturate(ramp[k] * data[k]);
+        }
+    }
+    else
+    {
+        for (uint32_t k = 0; k < len; ++k)
+        {
+            data[k] = saturate(ramp[k] * data[k] + (1.0f - ramp[k]) * noiseLevel * noise[k]);
+        }
+    }
+}
+
+static void scaleRamp_generic(const int16_t * in, int16_t * out, uint32_t numFrames, uint8_t numChannels, float gain, float step)
+{
+    for (uint32_t n = 0; n < numFrames; ++n)
+    {
+        for (uint_fast8_t c = 0; c < numChannels; ++c)
+        {
+            *out++ = saturate(gain * *in++);
+        }
+        gain += step;
+    }
+}
+
+static void scaleRampFloat_generic(const int16_t * in, float * out, uint32_t numFrames, uint8_t numChannels, float gain, float step)
+{
+    gain *= AUDIOKERNELS_S16_TO_FLOAT;
+    step *= AUDIOKERNELS_S16_TO_FLOAT;
+    for (uint32_t n = 0; n < numFrames; ++n)
+    {
+        for (uint_fast8_t c = 0; c < numChannels; ++c)
+        {
+            *out++ = gain * *in++;
+        }
+        gain += step;
+    }
+}
+
+#if AUDIOKERNELS_SSE2
+// converts 8 int16 values to 2x4 floats
+static inline void loadS16_sse2(const int16_t * in, __m128 & lo, __m128 & hi)
+{
+    __m128i x = _mm_loadu_si128((const __m128i *) in);
+    lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+    hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+}
+
+// rounds 2x4 floats to nearest and stores 8 int16 values with saturation
+static inline void storeS16_sse2(int16_t * out, __m128 lo, __m128 hi)
+{
+    _mm_storeu_si128((__m128i *) out, _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+}
+
+static void scale_sse2(const int16_t * in, int16_t * out, uint32_t len, float gain)
+{
+    const __m128 g = _mm_set1_ps(gain);
+    uint32_t k = 0;
+    for (; k + 8 <= len; k += 8)
+    {
+        __m128 lo, hi;
+        loadS16_sse2(in + k, lo, hi);
+        storeS16_sse2(out + k, _mm_mul_ps(lo, g), _mm_mul_ps(hi, g));
+    }
+    scale_generic(in + k, out + k, len - k, gain);
+}
+
+static void applyRamp_sse2(int16_t * data, const float * ramp, uint32_t len, const int16_t * noise, float noiseLevel)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 level = _mm_set1_ps(noiseLevel);
+    uint32_t k = 0;
+    for (; k + 8 <= len; k += 8)
+    {
+        __m128 lo, hi;
+        loadS16_sse2(data + k, lo, hi);
+        __m128 rlo = _mm_loadu_ps(ramp + k);
+        __m128 rhi = _mm_loadu_ps(ramp + k + 4);
+        lo = _mm_mul_ps(lo, rlo);
+        hi = _mm_mul_ps(hi, rhi);
+        if (nullptr != noise)
+        {
+            __m128 nlo, nhi;
+            loadS16_sse2(noise + k, nlo, nhi);
+            lo = _mm_add_ps(lo, _mm_mul_ps(_mm_sub_ps(one, rlo), _mm_mul_ps(level, nlo)));
+            hi = _mm_add_ps(hi, _mm_mul_ps(_mm_sub_ps(one, rhi), _mm_mul_ps(level, nhi)));
+        }
+        storeS16_sse2(data + k, lo, hi);
+    }
+    applyRamp_generic(data + k, ramp + k, len - k, (nullptr != noise) ? noise + k : nullptr, noiseLevel);
+}
+// SIMD ramp is supported for mono and stereo, 4 values are 4 frames (mono) or 2 frames (stereo)
+// returns number of processed frames
+static uint32_t scaleRampBody_sse2(const int16_t * in, int16_t * outS16, float * outF32, uint32_t numFrames, uint8_t numChannels, float gain, float step)
+{
+    if ((numChannels != 1) && (numChannels != 2))
+    {
+        return 0;
+    }
+    const uint32_t framesPerStep = 8 / numChannels;     // 8 values per iteration
+    const __m128 frameOffset = (1 == numChannels) ? _mm_setr_ps(0, 1, 2, 3) : _mm_setr_ps(0, 0, 1, 1);
+    const __m128 stepV = _mm_set1_ps(step);
+    const __m128 halfStepV = _mm_set1_ps(step * (4 / numChannels));
+    const __m128 iterStepV = _mm_set1_ps(step * framesPerStep);
+    const __m128 normV = _mm_set1_ps(AUDIOKERNELS_S16_TO_FLOAT);
+    __m128 glo = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(frameOffset, stepV));
+
+    uint32_t n = 0;
+    for (; n + framesPerStep <= numFrames; n += framesPerStep)
+    {
+        __m128 lo, hi;
+        loadS16_sse2(in, lo, hi);
+        __m128 ghi = _mm_add_ps(glo, halfStepV);
+        lo = _mm_mul_ps(lo, glo);
+        hi = _mm_mul_ps(hi, ghi);
+        if (nullptr != outF32)
+        {
+            _mm_storeu_ps(outF32, _mm_mul_ps(lo, normV));
+            _mm_storeu_ps(outF32 + 4, _mm_mul_ps(hi, normV));
+            outF32 += 8;
+        }
+        else
+        {
+            storeS16_sse2(outS16, lo, hi);
+            outS16 += 8;
+        }
+        in += 8;
+        glo = _mm_add_ps(glo, iterStepV);
+    }
+    return n;
+}
+
+static void scaleRamp_sse2(const int16_t * in, int16_t * out, uint32_t numFrames, uint8_t numChannels, float gain, float step)
+{
+    uint32_t n = scaleRampBody_sse2(in, out, nullptr, numFrames, numChannels, gain, step);
+    scaleRamp_generic(in + n*numChannels, out + n*numChannels, numFrames - n, numChannels, gain + n*step, step);
+}
+
+static void scaleRampFloat_sse2(const int16_t * in, float * out, uint32_t numFrames, uint8_t numChannels, float gain, float step)
+{
+    uint32_t n = scaleRampBody_sse2(in, nullptr, out, numFrames, numChannels, gain, step);
+    scaleRampFloat_generic(in + n*numChannels, out + n*numChannels, numFrames - n, numChannels, gain + n*step, step);
+}
+#endif // AUDIOKERNELS_SSE2
+
+#if AUDIOKERNELS_NEON
+static inline void loadS16_neon(const int16_t * in, float32x4_t & lo, float32x4_t & hi)
+{
+    int16x8_t x = vld1q_s16(in);
+    lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+    hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+}
+
+static inline void storeS16_neon(int16_t * out, float32x4_t lo, float32x4_t hi)
+{
+    vst1q_s16(out, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)), vqmovn_s32(vcvtnq_s32_f32(hi))));
+}
+
+static void scale_neon(const int16_t * in, int16_t * out, uint32_t len, float gain)
+{
+    uint32_t k = 0;
+    for (; k + 8 <= len; k += 8)
+    {
+        float32x4_t lo, hi;
+        loadS16_neon(in + k, lo, hi);
+        storeS16_neon(out + k, vmulq_n_f32(lo, gain), vmulq_n_f32(hi, gain));
+    }
+    scale_generic(in + k, out + k, len - k, gain);
+}
+
+static void applyRamp_neon(int16_t * data, const float * ramp, uint32_t len, const int16_t * noise, float noiseLevel)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    uint32_t k = 0;
+    for (; k + 8 <= len; k += 8)
+    {
+        float32x4_t lo, hi;
+        loadS16_neon(data + k, lo, hi);
+        float32x4_t rlo = vld1q_f32(ramp + k);
+        float32x4_t rhi = vld1q_f32(ramp + k + 4);
+        lo = vmulq_f32(lo, rlo);
+        hi = vmulq_f32(hi, rhi);
+        if (nullptr != noise)
+        {
+            float32x4_t nlo, nhi;
+            loadS16_neon(noise + k, nlo, nhi);
+            lo = vmlaq_f32(lo, vsubq_f32(one, rlo), vmulq_n_f32(nlo, noiseLevel));
+            hi = vmlaq_f32(hi, vsubq_f32(one, rhi), vmulq_n_f32(nhi, noiseLevel));
+        }
+        storeS16_neon(data + k, lo, hi);
+    }
+    applyRamp_generic(data + k, ramp + k, len - k, (nullptr != noise) ? noise + k : nullptr, noiseLevel);
+}
+static uint32_t scaleRampBody_neon(const int16_t * in, int16_t * outS16, float * outF32, uint32_t numFrames, uint8_t numChannels, float gain, float step)
+{
+    if ((numChannels != 1) && (numChannels != 2))
+    {
+        return 0;
+    }
+    const uint32_t framesPerStep = 8 / numChannels;     // 8 values per iteration
+    const float monoOffset[4] = { 0, 1, 2, 3 };
+    const float stereoOffset[4] = { 0, 0, 1, 1 };
+    const float32x4_t frameOffset = vld1q_f32((1 == numChannels) ? monoOffset : stereoOffset);
+    const float halfStep = step * (4 / numChannels);
+    const float iterStep = step * framesPerStep;
+    float32x4_t glo = vmlaq_n_f32(vdupq_n_f32(gain), frameOffset, step);
+
+    uint32_t n = 0;
+    for (; n + framesPerStep <= numFrames; n += framesPerStep)
+    {
+        float32x4_t lo, hi;
+        loadS16_neon(in, lo, hi);
+        float32x4_t ghi = vaddq_f32(glo, vdupq_n_f32(halfStep));
+        lo = vmulq_f32(lo, glo);
+        hi = vmulq_f32(hi, ghi);
+        if (nullptr != outF32)
+        {
+            vst1q_f32(outF32, vmulq_n_f32(lo, AUDIOKERNELS_S16_TO_FLOAT));
+            vst1q_f32(outF32 + 4, vmulq_n_f32(hi, AUDIOKERNELS_S16_TO_FLOAT));
+            outF32 += 8;
+        }
+        else
+        {
+            storeS16_neon(outS16, lo, hi);
+            outS16 += 8;
+        }
+        in += 8;
+        glo = vaddq_f32(glo, vdupq_n_f32(iterStep));
+    }
+    return n;
+}
+
+static void scaleRamp_neon(const int16_t * in, int16_t * out, uint32_t numFrames, uint8_t numChannels, float gain, float step)
+{
+    uint32_t n = scaleRampBody_neon(in, out, nullptr, numFrames, numChannels, gain, step);
+    scaleRamp_generic(in + n*numChannels, out + n*numChannels, numFrames - n, numChannels, gain + n*step, step);
+}
+
+static void scaleRampFloat_neon(const int16_t * in, float * out, uint32_t numFrames, uint8_t numChannels, float gain, float step)
+{
+    uint32_t n = scaleRampBody_neon(in, nullptr, out, numFrames, numChannels, gain, step);
+    scaleRampFloat_generic(in + n*numChannels, out + n*numChannels, numFrames - n, numChannels, gain + n*step, step);
+}
+#endif // AUDIOKERNELS_NEON
+
+AudioKernels::Implementation AudioKernels::selectImplementation()
+{
+#if AUDIOKERNELS_SSE2
+    return Implementation { "SSE2", scale_sse2, applyRamp_sse2, scaleRamp_sse2, scaleRampFloat_sse2 };
+#elif AUDIOKERNELS_NEON
+    return Implementation { "NEON", scale_neon, applyRamp_neon, scaleRamp_neon, scaleRampFloat_neon };
+#else
+    return Implementation { "generic", scale_generic, applyRamp_generic, scaleRamp_generic, scaleRampFloat_generic };
+#endif
+}
+
+const AudioKernels::Implementation & AudioKernels::implementation()
+{   // selected on first use
+    static const Implementation impl = selectImplementation();
+    return impl;
+}
+
+void AudioKernels::scale(const int16_t *in, int16_t *out, uint32_t len, float gain)
+{
+    implementation().scale(in, out, len, gain);
+}
+
+void AudioKernels::applyRamp(int16_t *data, const float *ramp, uint32_t len, const int16_t *noise, float noiseLevel)
+{
+    implementation().applyRamp(data, ramp, len, noise, noiseLevel);
+}
+
+void AudioKernels::scaleRamp(const int16_t *in, int16_t *out, uint32_t numFrames, uint8_t numChannels, float gainStart, float gainEnd)
+{
+    if (gainStart == gainEnd)
+    {   // constant gain
+        implementation().scale(in, out, numFrames * numChannels, gainStart);
+        return;
+    }
+    implementation().scaleRamp(in, out, numFrames, numChannels, gainStart, (gainEnd - gainStart) / numFrames);
+}
+
+void AudioKernels::scaleRampFloat(const int16_t *in, float *out, uint32_t numFrames, uint8_t numChannels, float gainStart, float gainEnd)
+{
+    implementation().scaleRampFloat(in, out, numFrames, numChannels, gainStart, (gainEnd - gainStart) / numFrames);
+}
+
+void AudioKernels::scale(const int16_t *in, float *out, uint32_t len, float gain)
+{   // the same as ramp with constant gain in one channel
+    implementation().scaleRampFloat(in, out, len, 1, gain, 0.0f);
+}
+
+// float kernels are simple loops without dependencies, they are vectorized by compiler
+void AudioKernels::applyRamp(float *data, const float *ramp, uint32_t len, const int16_t *noise, float noiseLevel)
+{
+    if (nullptr == noise)
+    {
+        for (uint32_t k = 0; k < len; ++k)
+        {
+            data[k] *= ramp[k];
+        }
+    }
+    else
+    {
+        const float level = noiseLevel * AUDIOKERNELS_S16_TO_FLOAT;
+        for (uint32_t k = 0; k < len; ++k)
+        {
+            data[k] = ramp[k] * data[k] + (1.0f - ramp[k]) * level * noise[k];
+        }
+    }
+}
+
+void AudioKernels::scaleRamp(const float *in, float *out, uint32_t numFrames, uint8_t numChannels, float gainStart, float gainEnd)
+{
+    const float step = (gainEnd - gainStart) / numFrames;
+    float gain = gainStart;
+    for (uint32_t n = 0; n < numFrames; ++n)
+    {
+        for (uint_fast8_t c = 0; c < numChannels; ++c)
+        {
+            *out++ = gain * *in++;
+        }
+        gain += step;
+    }
+}
+
+const char *AudioKernels::implementationName()
+{
+    return implementation().name;
+}
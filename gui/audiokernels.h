@@ -0,0 +1,79 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIOKERNELS_H
+#define AUDIOKERNELS_H
+
+#include <cstdint>
+
+// low level int16 audio sample processing used by audio decoder and audio output
+// implementation is selected in runtime according to CPU capabilities (SSE2, NEON or generic C++)
+// all results are rounded and saturated to int16 range
+class AudioKernels
+{
+public:
+    // out = gain * in, in and out can be the same buffer
+    // len is number of values (all channels)
+    static void scale(const int16_t * in, int16_t * out, uint32_t len, float gain);
+
+    // data = ramp * data + (1 - ramp) * noiseLevel * noise
+    // ramp has one value per sample value (channels interleaved), noise can be nullptr (no noise added)
+    static void applyRamp(int16_t * data, const float * ramp, uint32_t len, const int16_t * noise, float noiseLevel);
+
+    // out = gain * in, gain changes linearly per frame from gainStart to gainEnd over the buffer
+    // (smooth volume change), in and out can be the same buffer
+    static void scaleRamp(const int16_t * in, int16_t * out, uint32_t numFrames, uint8_t numChannels, float gainStart, float gainEnd);
+
+    // the same as scaleRamp() but output is float32 normalized to [-1.0, 1.0)
+    static void scaleRampFloat(const int16_t * in, float * out, uint32_t numFrames, uint8_t numChannels, float gainStart, float gainEnd);
+
+    // float32 variants for float audio pipeline (HAVE_AUDIO_FLOAT32), samples are normalized to [-1.0, 1.0)
+    // int16 input (noise, FDK-AAC output) is normalized by these functions
+    static void scale(const int16_t * in, float * out, uint32_t len, float gain);
+    static void applyRamp(float * data, const float * ramp, uint32_t len, const int16_t * noise, float noiseLevel);
+    static void scaleRamp(const float * in, float * out, uint32_t numFrames, uint8_t numChannels, float gainStart, float gainEnd);
+
+    // returns name of selected implementation
+    static const char * implementationName();
+
+private:
+    typedef void (*scaleFcn_t)(const int16_t *, int16_t *, uint32_t, float);
+    typedef void (*applyRampFcn_t)(int16_t *, const float *, uint32_t, const int16_t *, float);
+    typedef void (*scaleRampFcn_t)(const int16_t *, int16_t *, uint32_t, uint8_t, float, float);
+    typedef void (*scaleRampFloatFcn_t)(const int16_t *, float *, uint32_t, uint8_t, float, float);
+    struct Implementation
+    {
+        const char * name;
+        scaleFcn_t scale;
+        applyRampFcn_t applyRamp;
+        scaleRampFcn_t scaleRamp;               // gain and gain step per frame
+        scaleRampFloatFcn_t scaleRampFloat;
+    };
+    static const Implementation & implementation();
+    static Implementation selectImplementation();
+};
+
+#endif // AUDIOKERNELS_H
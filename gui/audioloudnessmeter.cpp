@@ -0,0 +1,229 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstring>
+#include "audioloudnessmeter.h"
+
+AudioLoudnessMeter::AudioLoudnessMeter(const AudioTap *tap, QObject *parent) : QObject(parent)
+{
+    m_tap = tap;
+    m_timer = new QTimer(this);
+    m_timer->setInterval(AUDIO_LOUDNESS_PERIOD_MS);
+    connect(m_timer, &QTimer::timeout, this, &AudioLoudnessMeter::onTimer);
+
+    m_readBuffer.resize(48 * 2 * AUDIO_LOUDNESS_PERIOD_MS * 4);   // enough to catch up after timer delay
+    m_blocks.assign(AUDIO_LOUDNESS_SHORT_TERM, 0.0);
+    m_hist.assign(AUDIO_LOUDNESS_HIST_BINS, 0);
+}
+
+void AudioLoudnessMeter::start()
+{
+    m_cursor = AudioTapCursor();
+    m_timer->start();
+}
+
+void AudioLoudnessMeter::stop()
+{
+    m_timer->stop();
+}
+
+void AudioLoudnessMeter::reset()
+{
+    memset(m_state, 0, sizeof(m_state));
+    m_blockCntr = 0;
+    m_blockEnergy = 0.0;
+    m_blockIdx = 0;
+    m_numBlocks = 0;
+    std::fill(m_blocks.begin(), m_blocks.end(), 0.0);
+    std::fill(m_hist.begin(), m_hist.end(), 0);
+    m_momentary = AUDIO_LOUDNESS_INVALID;
+    m_shortTerm = AUDIO_LOUDNESS_INVALID;
+}
+
+void AudioLoudnessMeter::setFormat(uint32_t sampleRate, uint8_t numChannels)
+{
+    m_sampleRate = sampleRate;
+    m_numChannels = std::min(numChannels, uint8_t(2));
+    m_blockFrames = sampleRate * AUDIO_LOUDNESS_PERIOD_MS / 1000;
+
+    // K-weighting filter coefficients for any sample rate (ITU-R BS.1770 filters are specified at 48kHz)
+    double K = tan(M_PI * 1681.974450955533 / sampleRate);
+    double Q = 0.7071752369554196;
+    double Vh = pow(10.0, 3.999843853973347 / 20.0);
+    double Vb = pow(Vh, 0.4996667741545416);
+    double a0 = 1.0 + K / Q + K * K;
+    m_shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+    m_shelf.b1 = 2.0 * (K * K - Vh) / a0;
+    m_shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+    m_shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+    m_shelf.a2 = (1.0 - K / Q + K * K) / a0;
+
+    K = tan(M_PI * 38.13547087602444 / sampleRate);
+    Q = 0.5003270373238773;
+    a0 = 1.0 + K / Q + K * K;
+    m_highPass.b0 = 1.0;
+    m_highPass.b1 = -2.0;
+    m_highPass.b2 = 1.0;
+    m_highPass.a1 = 2.0 * (K * K - 1.0) / a0;
+    m_highPass.a2 = (1.0 - K / Q + K * K) / a0;
+
+    reset();
+}
+
+void AudioLoudnessMeter::onTimer()
+{
+    bool updated = false;
+    uint32_t generation = m_cursor.generation;
+    uint32_t numSamples;
+    while ((numSamples = m_tap->read(m_cursor, m_readBuffer.data(), m_readBuffer.size())) > 0)
+    {
+        if ((m_sampleRate != m_tap->sampleRate()) || (m_numChannels != std::min(m_tap->numChannels(), uint8_t(2))))
+        {   // new stream format
+            setFormat(m_tap->sampleRate(), m_tap->numChannels());
+        }
+        process(m_readBuffer.data(), numSamples / m_tap->numChannels());
+        updated = true;
+    }
+    if (generation != m_cursor.generation)
+    {   // cursor was synchronized to new stream, values of previous service are not valid
+        reset();
+        updated = true;
+    }
+
+    if (updated)
+    {
+        emit loudness(m_momentary, m_shortTerm, integrated());
+    }
+}
+
+void AudioLoudnessMeter::process(const audioSample_t *data, uint32_t numFrames)
+{
+    if (0 == m_blockFrames)
+    {
+        return;
+    }
+
+    uint8_t stride = m_tap->numChannels();
+    for (uint32_t n = 0; n < numFrames; ++n)
+    {
+        for (uint8_t ch = 0; ch < m_numChannels; ++ch)
+        {   // two biquads in direct form II transposed
+            double * z = m_state[ch];
+            double x = data[n * stride + ch] / AUDIO_SAMPLE_MAX;
+            double y = m_shelf.b0 * x + z[0];
+            z[0] = m_shelf.b1 * x - m_shelf.a1 * y + z[1];
+            z[1] = m_shelf.b2 * x - m_shelf.a2 * y;
+            x = y;
+            y = m_highPass.b0 * x + z[2];
+            z[2] = m_highPass.b1 * x - m_highPass.a1 * y + z[3];
+            z[3] = m_highPass.b2 * x - m_highPass.a2 * y;
+
+            m_blockEnergy += y * y;
+        }
+        if (++m_blockCntr >= m_blockFrames)
+        {
+            onBlock();
+        }
+    }
+}
+
+void AudioLoudnessMeter::onBlock()
+{
+    m_blocks[m_blockIdx] = m_blockEnergy / m_blockFrames;
+    m_blockIdx = (m_blockIdx + 1) % AUDIO_LOUDNESS_SHORT_TERM;
+    m_numBlocks = std::min(m_numBlocks + 1, AUDIO_LOUDNESS_SHORT_TERM);
+    m_blockEnergy = 0.0;
+    m_blockCntr = 0;
+
+    if (m_numBlocks >= AUDIO_LOUDNESS_MOMENTARY)
+    {   // 400ms gating blocks with 75% overlap
+        m_momentary = toLUFS(meanEnergy(AUDIO_LOUDNESS_MOMENTARY));
+        if (m_momentary > AUDIO_LOUDNESS_ABS_GATE)
+        {
+            int bin = std::min(int((m_momentary - AUDIO_LOUDNESS_ABS_GATE) / AUDIO_LOUDNESS_HIST_STEP), AUDIO_LOUDNESS_HIST_BINS - 1);
+            m_hist[bin] += 1;
+        }
+        else { /* below absolute gate */ }
+    }
+    if (m_numBlocks >= AUDIO_LOUDNESS_SHORT_TERM)
+    {
+        m_shortTerm = toLUFS(meanEnergy(AUDIO_LOUDNESS_SHORT_TERM));
+    }
+}
+
+double AudioLoudnessMeter::meanEnergy(int numBlocks) const
+{
+    double sum = 0.0;
+    for (int n = 1; n <= numBlocks; ++n)
+    {
+        sum += m_blocks[(m_blockIdx - n + AUDIO_LOUDNESS_SHORT_TERM) % AUDIO_LOUDNESS_SHORT_TERM];
+    }
+    return sum / numBlocks;
+}
+
+float AudioLoudnessMeter::integrated() const
+{
+    // energy of block is represented by center of its bin
+    auto binEnergy = [](int bin) { return pow(10.0, (AUDIO_LOUDNESS_ABS_GATE + (bin + 0.5) * AUDIO_LOUDNESS_HIST_STEP + 0.691) / 10.0); };
+
+    double sum = 0.0;
+    uint64_t count = 0;
+    for (int bin = 0; bin < AUDIO_LOUDNESS_HIST_BINS; ++bin)
+    {
+        sum += m_hist[bin] * binEnergy(bin);
+        count += m_hist[bin];
+    }
+    if (0 == count)
+    {
+        return AUDIO_LOUDNESS_INVALID;
+    }
+
+    // relative gate
+    double relGate = toLUFS(sum / count) + AUDIO_LOUDNESS_REL_GATE;
+    int startBin = std::max(0, int(ceil((relGate - AUDIO_LOUDNESS_ABS_GATE) / AUDIO_LOUDNESS_HIST_STEP)));
+    sum = 0.0;
+    count = 0;
+    for (int bin = startBin; bin < AUDIO_LOUDNESS_HIST_BINS; ++bin)
+    {
+        sum += m_hist[bin] * binEnergy(bin);
+        count += m_hist[bin];
+    }
+    if (0 == count)
+    {
+        return AUDIO_LOUDNESS_INVALID;
+    }
+    return toLUFS(sum / count);
+}
+
+double AudioLoudnessMeter::toLUFS(double energy)
+{
+    if (energy <= 0.0)
+    {
+        return AUDIO_LOUDNESS_INVALID;
+    }
+    return -0.691 + 10.0 * log10(energy);
+}
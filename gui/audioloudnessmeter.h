@@ -0,0 +1,95 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIOLOUDNESSMETER_H
+#define AUDIOLOUDNESSMETER_H
+
+#include <QObject>
+#include <QTimer>
+#include <vector>
+#include "audiotap.h"
+
+#define AUDIO_LOUDNESS_PERIOD_MS      (100)     // block length, values are updated with this period
+#define AUDIO_LOUDNESS_MOMENTARY      (4)       // blocks, 400 ms
+#define AUDIO_LOUDNESS_SHORT_TERM     (30)      // blocks, 3 s
+#define AUDIO_LOUDNESS_ABS_GATE       (-70.0)   // LUFS
+#define AUDIO_LOUDNESS_REL_GATE       (-10.0)   // LU
+#define AUDIO_LOUDNESS_HIST_STEP      (0.1)     // LU, integrated loudness resolution
+#define AUDIO_LOUDNESS_HIST_BINS      (800)     // -70 ... +10 LUFS
+#define AUDIO_LOUDNESS_INVALID        (-144.0)
+
+// EBU R128 (ITU-R BS.1770) loudness meter
+// consumer of audio tap, it runs in thread of its owner (timer based)
+// integrated loudness uses histogram of gated blocks, memory is constant for any programme length
+class AudioLoudnessMeter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AudioLoudnessMeter(const AudioTap * tap, QObject *parent = nullptr);
+    void start();
+    void stop();
+    void reset();
+
+signals:
+    // values in LUFS, AUDIO_LOUDNESS_INVALID when not available yet
+    void loudness(float momentary, float shortTerm, float integrated);
+
+private:
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    const AudioTap * m_tap;
+    QTimer * m_timer;
+    AudioTapCursor m_cursor;
+    std::vector<audioSample_t> m_readBuffer;
+
+    uint32_t m_sampleRate = 0;
+    uint8_t m_numChannels = 0;
+    Biquad m_shelf;                         // K-weighting stage 1
+    Biquad m_highPass;                      // K-weighting stage 2
+    double m_state[2][4] = {};              // filter state per channel
+    uint32_t m_blockFrames = 0;
+    uint32_t m_blockCntr = 0;
+    double m_blockEnergy = 0.0;
+    std::vector<double> m_blocks;           // energy of last AUDIO_LOUDNESS_SHORT_TERM blocks
+    int m_blockIdx = 0;
+    int m_numBlocks = 0;
+    std::vector<uint32_t> m_hist;           // momentary loudness above absolute gate
+    float m_momentary = AUDIO_LOUDNESS_INVALID;
+    float m_shortTerm = AUDIO_LOUDNESS_INVALID;
+
+    void setFormat(uint32_t sampleRate, uint8_t numChannels);
+    void process(const audioSample_t * data, uint32_t numFrames);
+    void onBlock();
+    void onTimer();
+    double meanEnergy(int numBlocks) const;
+    float integrated() const;
+    static double toLUFS(double energy);
+};
+
+#endif // AUDIOLOUDNESSMETER_H
@@ -34,6 +34,7 @@
 #include <QTimer>
 #include <QAudioSink>
 #include <QMediaDevices>
+#include <vector>
 
 #include "audiofifo.h"
 
@@ -52,6 +53,95 @@ enum class AudioOutputPlaybackState
     Playing = 1,
 };
 
+// switching between buffers of service and announcement decoder without audio gap
+// requests are set from GUI thread, other methods are called from audio callback only
+// standby buffer (service during announcement) is kept at playback level so its decoder is never blocked
+class AudioOutputCrossfade
+{
+public:
+    void request(audioFifo_t * buffer) { m_nextFifoPtr = buffer; }
+    void setStandby(audioFifo_t * buffer) { m_standbyFifoPtr = buffer; }
+    audioFifo_t * standby() const { return m_standbyFifoPtr; }
+    audioFifo_t * takeStandby() { return m_standbyFifoPtr.exchange(nullptr); }
+    void reset() { m_nextFifoPtr = nullptr; m_standbyFifoPtr = nullptr; }
+    void reserve(uint32_t numSamples) { m_buffer.reserve(numSamples); }
+
+    // oldest samples of standby buffer above levelMs are dropped
+    void drainStandby(const audioFifo_t * current, uint32_t levelMs)
+    {
+        audioFifo_t * fifo = m_standbyFifoPtr;
+        if ((nullptr != fifo) && (current != fifo))
+        {
+            int64_t levelBytes = levelBytesOf(fifo, levelMs);
+            int64_t count = fifo->availableBytes();
+            if (count > levelBytes)
+            {
+                fifo->discard(count - levelBytes);
+            }
+            else { /* below level */ }
+        }
+        else { /* nothing in standby */ }
+    }
+
+    // switches current to requested buffer when it is filled to levelMs
+    // if isPlaying then data (numFrames from current buffer) is crossfaded to samples of new buffer
+    // returns true when buffer was switched
+    bool process(audioFifo_t *& current, audioSample_t * data, uint32_t numFrames, uint32_t levelMs, bool isPlaying)
+    {
+        audioFifo_t * next = m_nextFifoPtr;
+        if (nullptr == next)
+        {
+            return false;
+        }
+        if (next == current)
+        {   // nothing to do
+            m_nextFifoPtr.compare_exchange_strong(next, nullptr);
+            return false;
+        }
+        if (next->availableBytes() < std::max(levelBytesOf(next, levelMs), int64_t(numFrames * next->numChannels * sizeof(audioSample_t))))
+        {   // waiting for samples
+            return false;
+        }
+
+        if (isPlaying)
+        {   // out = (1 - g) * current + g * next, g goes linearly from 0 to 1 over the buffer
+            uint32_t numSamples = numFrames * next->numChannels;
+            if (m_buffer.size() < numSamples)
+            {
+                m_buffer.resize(numSamples);
+            }
+            next->read(m_buffer.data(), numSamples * sizeof(audioSample_t));
+
+            float step = 1.0f / numFrames;
+            float g = 0.5f * step;
+            for (uint32_t n = 0; n < numSamples; n += next->numChannels)
+            {
+                for (uint8_t ch = 0; ch < next->numChannels; ++ch)
+                {
+                    float from = data[n + ch];
+                    data[n + ch] = audioSampleRound(from + g * (float(m_buffer[n + ch]) - from));
+                }
+                g += step;
+            }
+        }
+        else { /* muted - new buffer is unmuted by normal procedure */ }
+
+        current = next;
+        m_nextFifoPtr.compare_exchange_strong(next, nullptr);
+        return true;
+    }
+
+private:
+    std::atomic<audioFifo_t *> m_nextFifoPtr = nullptr;
+    std::atomic<audioFifo_t *> m_standbyFifoPtr = nullptr;
+    std::vector<audioSample_t> m_buffer;
+
+    static int64_t levelBytesOf(const audioFifo_t * fifo, uint32_t levelMs)
+    {
+        return int64_t(levelMs) * (fifo->sampleRate / 1000) * fifo->numChannels * sizeof(audioSample_t);
+    }
+};
+
 
 class AudioOutput : public QObject
 {
@@ -66,9 +156,16 @@ public:
     virtual void start(audioFifo_t *buffer) = 0;
     virtual void restart(audioFifo_t *buffer) = 0;
     virtual void stop() = 0;
+
+    // switches to buffer of announcement decoder with crossfade, current buffer is kept in standby
+    // stream is restarted when stream parameters are different
+    virtual void crossfade(audioFifo_t *buffer) = 0;
+    // switches back to buffer that was played before crossfade()
+    virtual void crossfadeBack() = 0;
     virtual void mute(bool on) = 0;
     virtual void setVolume(int value) = 0;
     virtual void setAudioDevice(const QByteArray & deviceId) = 0;
+    virtual void setTargetLatency(int latencyMs) = 0;     // 0 = default buffering
     QList<QAudioDevice> getAudioDevices()
     {
         QList<QAudioDevice> list;
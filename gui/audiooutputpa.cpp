@@ -31,6 +31,20 @@
 #include <QAudioDevice>
 
 #include "audiooutputpa.h"
+#include "audiokernels.h"
+#include "diagnostics.h"
+#include "threadpriority.h"
+
+#if defined(Q_OS_WIN) && __has_include("pa_win_wasapi.h")
+#include "pa_win_wasapi.h"
+#define AUDIOOUTPUTPA_HAVE_WASAPI 1
+#elif defined(Q_OS_LINUX) && __has_include("pa_linux_alsa.h")
+#include "pa_linux_alsa.h"
+#define AUDIOOUTPUTPA_HAVE_ALSA 1
+#elif defined(Q_OS_MACOS) && __has_include("pa_mac_core.h")
+#include "pa_mac_core.h"
+#define AUDIOOUTPUTPA_HAVE_COREAUDIO 1
+#endif
 
 Q_DECLARE_LOGGING_CATEGORY(audioOutput)
 
@@ -40,6 +54,7 @@ AudioOutputPa::AudioOutputPa( QObject *parent) : AudioOutput(parent)
     m_outStream = nullptr;
     m_numChannels = m_sampleRate_kHz = 0;
     m_linearVolume = 1.0;
+    m_currentVolume = 1.0;
 
     PaError err = Pa_Initialize();
     if (paNoError != err)
@@ -56,6 +71,7 @@ AudioOutputPa::AudioOutputPa( QObject *parent) : AudioOutput(parent)
 #endif
 
     connect(this, &AudioOutputPa::streamFinished, this, &AudioOutputPa::onStreamFinished, Qt::QueuedConnection);
+    connect(m_devices, &QMediaDevices::audioOutputsChanged, this, [this]() { m_reinitPa = true; });
 }
 
 AudioOutputPa::~AudioOutputPa()
@@ -106,9 +122,18 @@ void AudioOutputPa::start(audioFifo_t *buffer)
 
         m_sampleRate_kHz = sRate/1000;
         m_numChannels = numCh;
+#if HAVE_AUDIO_FLOAT32
+        m_floatOutput = false;                  // samples in FIFO are already float32
+        PaSampleFormat sampleFormat = paFloat32;
+#else
+        m_floatOutput = m_floatOutputRequest;
+        PaSampleFormat sampleFormat = m_floatOutput ? paFloat32 : paInt16;
+#endif
 
-        m_bytesPerFrame = numCh * sizeof(int16_t);
+        m_bytesPerFrame = numCh * sizeof(audioSample_t);
         m_bufferFrames = AUDIOOUTPUT_FADE_TIME_MS * m_sampleRate_kHz;  // 120 ms (FIFO size should be integer multiple of this)
+        m_renderBuffer.assign(m_floatOutput ? m_bufferFrames * numCh : 0, 0);
+        m_crossfade.reserve(m_bufferFrames * numCh);
 
         // mute ramp is exponential
         // value are precalculated to save MIPS in runtime
@@ -116,47 +141,60 @@ void AudioOutputPa::start(audioFifo_t *buffer)
         // m_muteFactor is calculated for change from 0dB to AUDIOOUTPUT_FADE_MIN_DB in AUDIOOUTPUT_FADE_TIME_MS
         m_muteFactor = powf(10, AUDIOOUTPUT_FADE_MIN_DB/(20.0*AUDIOOUTPUT_FADE_TIME_MS*m_sampleRate_kHz));
 
+        PaError err = paNotInitialized;
+        if (m_exclusiveMode.enable)
+        {
+            err = openExclusiveStream(numCh, sampleFormat, sRate);
+            if (paNoError != err)
+            {
+                qCWarning(audioOutput) << "Failed to open exclusive audio stream:" << Pa_GetErrorText(err) << "using shared mode";
+                m_outStream = nullptr;
+            }
+        }
+        if (paNoError != err)
+        {
 #ifdef Q_OS_LINUX
-        /* Open an audio I/O stream. */
-        PaError err = Pa_OpenDefaultStream( &m_outStream,
-                                           0,              /* no input channels */
-                                           numCh,          /* stereo output */
-                                           paInt16,        /* 16 bit floating point output */
-                                           sRate,
-                                           m_bufferFrames, /* frames per buffer, i.e. the number
-                                                           of sample frames that PortAudio will
-                                                           request from the callback. Many apps
-                                                           may want to use
-                                                           paFramesPerBufferUnspecified, which
-                                                           tells PortAudio to pick the best,
-                                                           possibly changing, buffer size.*/
-                                           portAudioCb,    /* callback */
-                                           (void *) this);
+            /* Open an audio I/O stream. */
+            err = Pa_OpenDefaultStream( &m_outStream,
+                                               0,              /* no input channels */
+                                               numCh,          /* stereo output */
+                                               sampleFormat,   /* 16 bit integer or 32 bit floating point output */
+                                               sRate,
+                                               m_bufferFrames, /* frames per buffer, i.e. the number
+                                                               of sample frames that PortAudio will
+                                                               request from the callback. Many apps
+                                                               may want to use
+                                                               paFramesPerBufferUnspecified, which
+                                                               tells PortAudio to pick the best,
+                                                               possibly changing, buffer size.*/
+                                               portAudioCb,    /* callback */
+                                               (void *) this);
 #else
-        PaStreamParameters outputParameters;
-        outputParameters.device = getCurrentDeviceIdx();
-        outputParameters.channelCount = numCh;
-        outputParameters.sampleFormat = paInt16;
-        outputParameters.suggestedLatency = Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
-        outputParameters.hostApiSpecificStreamInfo = nullptr;
-
-        /* Open an audio I/O stream. */
-        PaError err = Pa_OpenStream(&m_outStream,
-                                    nullptr, // no input
-                                    &outputParameters,
-                                    sRate,
-                                    m_bufferFrames, /* frames per buffer, i.e. the number
-                                                           of sample frames that PortAudio will
-                                                           request from the callback. Many apps
-                                                           may want to use
-                                                           paFramesPerBufferUnspecified, which
-                                                           tells PortAudio to pick the best,
-                                                           possibly changing, buffer size.*/
-                                    paNoFlag,
-                                    portAudioCb,    /* callback */
-                                    (void *) this);
+            PaStreamParameters outputParameters;
+            outputParameters.device = getCurrentDeviceIdx();
+            outputParameters.channelCount = numCh;
+            outputParameters.sampleFormat = sampleFormat;
+            outputParameters.suggestedLatency = Pa_GetDeviceInfo(outputParameters.device)->defaultLowOutputLatency;
+            outputParameters.hostApiSpecificStreamInfo = nullptr;
+
+            /* Open an audio I/O stream. */
+            err = Pa_OpenStream(&m_outStream,
+                                        nullptr, // no input
+                                        &outputParameters,
+                                        sRate,
+                                        m_bufferFrames, /* frames per buffer, i.e. the number
+                                                               of sample frames that PortAudio will
+                                                               request from the callback. Many apps
+                                                               may want to use
+                                                               paFramesPerBufferUnspecified, which
+                                                               tells PortAudio to pick the best,
+                                                               possibly changing, buffer size.*/
+                                        paNoFlag,
+                                        portAudioCb,    /* callback */
+                                        (void *) this);
 
 #endif
+        }
         if (paNoError != err)
         {
             throw std::runtime_error(std::string(Q_FUNC_INFO) + "PortAudio error:" + Pa_GetErrorText( err ) );
@@ -178,6 +216,10 @@ void AudioOutputPa::start(audioFifo_t *buffer)
     }
 
     m_inFifoPtr = buffer;
+    m_activeFifoPtr = buffer;
+    m_crossfade.request(nullptr);
+    m_currentVolume = m_linearVolume;
+    m_jitterBuffer.reset(m_sampleRate_kHz, m_numChannels);
     m_playbackState = AudioOutputPlaybackState::Muted;
     m_cbRequest &= ~(Request::Stop | Request::Restart);  // reset stop and restart bits
 
@@ -194,18 +236,67 @@ void AudioOutputPa::restart(audioFifo_t *buffer)
     if (nullptr != m_outStream)
     {
         m_restartFifoPtr = buffer;
+        m_activeFifoPtr = buffer;
         m_cbRequest |= Request::Restart;  // set restart bit
     }
 }
 
 void AudioOutputPa::stop()
 {
+    m_crossfade.reset();
     if (nullptr != m_outStream)
     {
         m_cbRequest |= Request::Stop;     // set stop bit
     }
 }
 
+void AudioOutputPa::crossfade(audioFifo_t *buffer)
+{
+    if (nullptr == m_crossfade.standby())
+    {   // buffer of service decoder is kept filled during announcement
+        m_crossfade.setStandby(m_activeFifoPtr);
+    }
+    else { /* announcement decoder was reconfigured, service stays in standby */ }
+    switchBuffer(buffer);
+}
+
+void AudioOutputPa::crossfadeBack()
+{
+    audioFifo_t * buffer = m_crossfade.takeStandby();
+    if (nullptr != buffer)
+    {
+        switchBuffer(buffer);
+    }
+    else { /* no crossfade before */ }
+}
+
+void AudioOutputPa::switchBuffer(audioFifo_t *buffer)
+{
+    if (nullptr == m_outStream)
+    {
+        start(buffer);
+    }
+    else if ((buffer->sampleRate/1000 == m_sampleRate_kHz) && (buffer->numChannels == m_numChannels)
+             && !(m_cbRequest & (Request::Stop | Request::Restart)))
+    {   // callback switches to new buffer when it is filled
+        m_activeFifoPtr = buffer;
+        m_crossfade.request(buffer);
+    }
+    else
+    {   // different stream parameters => stream is restarted, standby buffer is still drained
+        restart(buffer);
+    }
+}
+
+uint32_t AudioOutputPa::playbackLevelMs() const
+{
+    if (m_jitterBuffer.isEnabled())
+    {
+        return m_jitterBuffer.targetFrames() / m_sampleRate_kHz;
+    }
+    return 7*AUDIOOUTPUT_FADE_TIME_MS;   // unmute threshold
+}
+
 void AudioOutputPa::mute(bool on)
 {
     if (on)
@@ -225,27 +316,170 @@ void AudioOutputPa::setVolume(int value)
                                            QAudio::LinearVolumeScale);
 }
 
+void AudioOutputPa::setExclusiveMode(const ExclusiveMode &mode)
+{
+    m_exclusiveMode = mode;
+    m_exclusiveMode.periodMs = qMax(1, mode.periodMs);
+    m_exclusiveMode.numPeriods = qMax(2, mode.numPeriods);
+    m_reloadDevice = true;          // stream is reopened on next start
+}
+
+PaError AudioOutputPa::openExclusiveStream(uint8_t numCh, PaSampleFormat sampleFormat, uint32_t sRate)
+{
+    PaStreamParameters outputParameters;
+    outputParameters.channelCount = numCh;
+    outputParameters.sampleFormat = sampleFormat;
+
+    // callback size stays AUDIOOUTPUT_FADE_TIME_MS (mute ramp), periods define host buffer only
+    outputParameters.suggestedLatency = (m_exclusiveMode.periodMs * m_exclusiveMode.numPeriods) * 0.001;
+
+#if AUDIOOUTPUTPA_HAVE_WASAPI
+    // exclusive mode is supported only by WASAPI devices
+    outputParameters.device = paNoDevice;
+    PaDeviceIndex sharedIdx = getCurrentDeviceIdx();
+    QString name = QString(Pa_GetDeviceInfo(sharedIdx)->name).trimmed();
+    for (int d = 0; d < Pa_GetDeviceCount(); ++d)
+    {
+        const PaDeviceInfo * devInfo = Pa_GetDeviceInfo(d);
+        if ((paWASAPI == Pa_GetHostApiInfo(devInfo->hostApi)->type) && (devInfo->maxOutputChannels > 1)
+            && QString(devInfo->name).trimmed().startsWith(name, Qt::CaseInsensitive))
+        {
+            outputParameters.device = d;
+            break;
+        }
+    }
+    if (paNoDevice == outputParameters.device)
+    {
+        return paInvalidDevice;
+    }
+
+    PaWasapiStreamInfo wasapiInfo;
+    memset(&wasapiInfo, 0, sizeof(wasapiInfo));
+    wasapiInfo.size = sizeof(PaWasapiStreamInfo);
+    wasapiInfo.hostApiType = paWASAPI;
+    wasapiInfo.version = 1;
+    wasapiInfo.flags = paWinWasapiExclusive | paWinWasapiThreadPriority;
+    wasapiInfo.threadPriority = eThreadPriorityProAudio;
+    outputParameters.hostApiSpecificStreamInfo = &wasapiInfo;
+#elif AUDIOOUTPUTPA_HAVE_ALSA
+    // hw device without plug layer, PortAudio uses mmap access when device supports it
+    PaAlsaStreamInfo alsaInfo;
+    PaAlsa_InitializeStreamInfo(&alsaInfo);
+    alsaInfo.deviceString = m_exclusiveMode.alsaDevice.constData();
+    PaAlsa_SetNumPeriods(m_exclusiveMode.numPeriods);
+    outputParameters.device = paUseHostApiSpecificDeviceSpecification;
+    outputParameters.hostApiSpecificStreamInfo = &alsaInfo;
+#elif AUDIOOUTPUTPA_HAVE_COREAUDIO
+    // device sample rate and buffer size are changed to stream parameters, SRC in CoreAudio is not allowed
+    PaMacCoreStreamInfo macInfo;
+    PaMacCore_SetupStreamInfo(&macInfo, paMacCoreChangeDeviceParameters | paMacCoreFailIfConversionRequired);
+    outputParameters.device = getCurrentDeviceIdx();
+    outputParameters.hostApiSpecificStreamInfo = &macInfo;
+#else
+    return paHostApiNotFound;
+#endif
+
+    qCInfo(audioOutput, "Opening exclusive audio stream: %d x %d ms", m_exclusiveMode.numPeriods, m_exclusiveMode.periodMs);
+    PaError err = Pa_OpenStream(&m_outStream, nullptr, &outputParameters, sRate, m_bufferFrames, paNoFlag, portAudioCb, (void *) this);
+#if AUDIOOUTPUTPA_HAVE_ALSA
+    if (paNoError == err)
+    {
+        PaAlsa_EnableRealtimeScheduling(m_outStream, 1);
+    }
+#endif
+    return err;
+}
+
+void AudioOutputPa::setFloatOutput(bool ena)
+{
+    if (ena != m_floatOutputRequest)
+    {
+        m_floatOutputRequest = ena;
+        m_reloadDevice = true;          // stream is reopened on next start
+    }
+}
+
 int AudioOutputPa::portAudioCb( const void *inputBuffer, void *outputBuffer, unsigned long nBufferFrames,
                              const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void *ctx)
 {
     Q_UNUSED(inputBuffer);
-    Q_UNUSED(timeInfo);
 
+    ThreadPriority::update(ThreadClass::Output);    // PortAudio callback thread
+    uint64_t startUs = Diagnostics::timestampUs();
+
+    // capture time of the first sample played in this buffer
+    audioFifo_t * fifo = static_cast<AudioOutputPa*>(ctx)->m_inFifoPtr;
+    uint64_t captureUs = (nullptr != fifo) ? fifo->captureUs() : 0;
 #ifdef AUDIOOUTPUT_RAW_FILE_OUT
-    int ret = static_cast<AudioOutputPa*>(ctx)->portAudioCbPrivate(outputBuffer, nBufferFrames);
+    int ret = static_cast<AudioOutputPa*>(ctx)->renderOutput(outputBuffer, nBufferFrames);
     if (static_cast<AudioOutputPa*>(ctx)->m_rawOut)
     {
-        fwrite(outputBuffer, sizeof(int16_t), nBufferFrames * static_cast<AudioOutputPa*>(ctx)->m_numChannels, static_cast<AudioOutputPa*>(ctx)->m_rawOut);
+        size_t sampleSize = static_cast<AudioOutputPa*>(ctx)->m_floatOutput ? sizeof(float) : sizeof(audioSample_t);
+        fwrite(outputBuffer, sampleSize, nBufferFrames * static_cast<AudioOutputPa*>(ctx)->m_numChannels, static_cast<AudioOutputPa*>(ctx)->m_rawOut);
     }
-    return ret;
 #else
     if (statusFlags)
     {
         qCWarning(audioOutput) << "Port Audio statusFlags =" << statusFlags;
     }
 
-    return static_cast<AudioOutputPa*>(ctx)->portAudioCbPrivate(outputBuffer, nBufferFrames);
+    int ret = static_cast<AudioOutputPa*>(ctx)->renderOutput(outputBuffer, nBufferFrames);
 #endif
+    Diagnostics::getInstance()->addDelay(DiagnosticsMetric::AudioCallbackTime, startUs);
+
+    if ((0 != captureUs) && (AudioOutputPlaybackState::Playing == static_cast<AudioOutputPa*>(ctx)->m_playbackState))
+    {   // buffer is played when it reaches DAC
+        double dacUs = (timeInfo->outputBufferDacTime - timeInfo->currentTime) * 1e6;
+        uint64_t latencyUs = startUs - captureUs + ((dacUs > 0) ? uint64_t(dacUs) : 0);
+        Diagnostics::getInstance()->add(DiagnosticsMetric::EndToEndLatency, latencyUs / 1000);
+    }
+    else { /* silence or unknown capture time */ }
+    return ret;
+}
+
+int AudioOutputPa::renderOutput(void *outputBuffer, unsigned long nBufferFrames)
+{
+    // samples are prepared as int16 without volume, volume is applied in one pass at the end
+    audioSample_t * buffer = (audioSample_t *) outputBuffer;
+#if !HAVE_AUDIO_FLOAT32
+    if (m_floatOutput)
+    {
+        Q_ASSERT(nBufferFrames * m_numChannels <= m_renderBuffer.size());
+        buffer = m_renderBuffer.data();
+    }
+#endif
+
+    // announcement: service buffer is kept at playback level
+    uint32_t levelMs = playbackLevelMs();
+    m_crossfade.drainStandby(m_inFifoPtr, levelMs);
+
+    int ret = portAudioCbPrivate(buffer, nBufferFrames);
+
+    if ((paContinue == ret) && !(m_cbRequest & (Request::Stop | Request::Restart))
+        && m_crossfade.process(m_inFifoPtr, buffer, nBufferFrames, levelMs, AudioOutputPlaybackState::Playing == m_playbackState))
+    {   // playing from another buffer now, announcement state is updated in HMI
+        m_jitterBuffer.reset(m_sampleRate_kHz, m_numChannels);
+        emit audioOutputRestart();
+    }
+    else { /* no switch */ }
+
+    // gain is changed linearly over the buffer to avoid clicks when volume changes
+    float volume = m_linearVolume;
+#if !HAVE_AUDIO_FLOAT32
+    if (m_floatOutput)
+    {
+        AudioKernels::scaleRampFloat(buffer, (float *) outputBuffer, nBufferFrames, m_numChannels, m_currentVolume, volume);
+    }
+    else
+#endif
+    if ((1.0 != volume) || (1.0 != m_currentVolume))
+    {
+        AudioKernels::scaleRamp(buffer, buffer, nBufferFrames, m_numChannels, m_currentVolume, volume);
+    }
+    else { /* unity gain */ }
+    m_currentVolume = volume;
+
+    return ret;
 }
 
 int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferFrames)
@@ -253,9 +487,8 @@ int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferF
     //qDebug() << Q_FUNC_INFO << QThread::currentThreadId();
 
     // read samples from input buffer
-    m_inFifoPtr->mutex.lock();
-    uint64_t count = m_inFifoPtr->count;
-    m_inFifoPtr->mutex.unlock();
+    uint64_t count = m_inFifoPtr->availableBytes();
+    Diagnostics::getInstance()->add(DiagnosticsMetric::AudioFifoLevel, count / (m_bytesPerFrame * m_sampleRate_kHz));
 
     uint64_t bytesToRead = m_bytesPerFrame * nBufferFrames;
     uint32_t availableSamples = nBufferFrames;
@@ -263,10 +496,19 @@ int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferF
     // is any bit is set then mute is requested (mute | stop | restart)
     unsigned int request = m_cbRequest;
 
+    // adaptive jitter buffer keeps fill level around target latency
+    bool jitterBufferEna = m_jitterBuffer.isEnabled();
+    uint64_t unmuteThreshold = 7*bytesToRead;
+    if (jitterBufferEna)
+    {
+        m_jitterBuffer.update(count / m_bytesPerFrame, nBufferFrames);
+        unmuteThreshold = m_jitterBuffer.targetFrames() * m_bytesPerFrame;
+    }
+
     if (AudioOutputPlaybackState::Muted == m_playbackState)
     {   // muted
         // condition to unmute is enough samples && !muteFlag
-        if (count > 7*bytesToRead)
+        if (count > unmuteThreshold)
         {   // enough samples => reading data from input fifo
             if (Request::None != request)
             {   // staying muted -> setting output buffer to 0
@@ -274,10 +516,7 @@ int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferF
 
                 // shifting buffer pointers
                 m_inFifoPtr->tail = (m_inFifoPtr->tail + bytesToRead) % AUDIO_FIFO_SIZE;
-                m_inFifoPtr->mutex.lock();
-                m_inFifoPtr->count -= bytesToRead;
-                m_inFifoPtr->countChanged.wakeAll();
-                m_inFifoPtr->mutex.unlock();
+                m_inFifoPtr->commitRead(bytesToRead);
 
                 if (request & (Request::Stop | Request::Restart))
                 {   // stop or restart requested ==> finish playback
@@ -291,87 +530,22 @@ int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferF
 
             // at this point we have enough sample to unmute and there is no request => preparing data
             uint64_t bytesToEnd = AUDIO_FIFO_SIZE - m_inFifoPtr->tail;
-            if (bytesToEnd < bytesToRead)
+            if (jitterBufferEna)
+            {   // no resampling, only to continue from current samples
+                readResampled(outputBuffer, nBufferFrames, nBufferFrames);
+            }
+            else if (bytesToEnd < bytesToRead)
             {
-                float volume = m_linearVolume;
-                if (volume > 0.9)
-                {   // only copy here
-                    memcpy((uint8_t*)outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
-                    memcpy((uint8_t*)outputBuffer + bytesToEnd, m_inFifoPtr->buffer, (bytesToRead - bytesToEnd));
-                    m_inFifoPtr->tail = bytesToRead - bytesToEnd;
-                }
-                else
-                {
-                    //memcpy((uint8_t*)outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
-                    int16_t * inDataPtr = (int16_t *) (m_inFifoPtr->buffer+m_inFifoPtr->tail);
-                    int16_t * outDataPtr = (int16_t *) outputBuffer;
-                    // each sample is int16 => 2 bytes per samples
-                    uint_fast32_t numSamples = (bytesToEnd >> 1);
-
-                    Q_ASSERT(numSamples*sizeof(int16_t) == bytesToEnd);
-
-                    for (uint_fast32_t n = 0; n < numSamples; ++n)
-                    {
-#if AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND
-                        *outDataPtr++ = int16_t(std::lroundf(volume * *inDataPtr++));
-#else
-                        *outDataPtr++ = int16_t(volume * *inDataPtr++);
-#endif
-                    }
-
-                    //memcpy((uint8_t*)outputBuffer + bytesToEnd, m_inFifoPtr->buffer, (bytesToRead - bytesToEnd));
-                    inDataPtr = (int16_t *) m_inFifoPtr->buffer;
-                    outDataPtr = (int16_t *) ((uint8_t*)outputBuffer + bytesToEnd);
-                    // each sample is int16 => 2 bytes per samples
-                    numSamples = ((bytesToRead - bytesToEnd) >> 1);
-
-                    Q_ASSERT(numSamples*sizeof(int16_t) == (bytesToRead - bytesToEnd));
-
-                    for (uint_fast32_t n = 0; n < numSamples; ++n)
-                    {
-#if AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND
-                        *outDataPtr++ = int16_t(std::lroundf(volume * *inDataPtr++));
-#else
-                        *outDataPtr++ = int16_t(volume * *inDataPtr++);
-#endif
-                    }
-                    m_inFifoPtr->tail = bytesToRead - bytesToEnd;
-                }
+                memcpy((uint8_t*)outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
+                memcpy((uint8_t*)outputBuffer + bytesToEnd, m_inFifoPtr->buffer, (bytesToRead - bytesToEnd));
+                m_inFifoPtr->tail = bytesToRead - bytesToEnd;
             }
             else
             {
-                float volume = m_linearVolume;
-                if (volume > 0.9)
-                {  // only copy here
-                    memcpy((uint8_t*) outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToRead);
-                    m_inFifoPtr->tail += bytesToRead;
-                }
-                else
-                {
-                    //memcpy((uint8_t*) outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToRead);
-                    int16_t * inDataPtr = (int16_t *) (m_inFifoPtr->buffer+m_inFifoPtr->tail);
-                    int16_t * outDataPtr = (int16_t *) outputBuffer;
-                    // each sample is int16 => 2 bytes per samples
-                    uint_fast32_t numSamples = (bytesToRead >> 1);
-
-                    Q_ASSERT(numSamples*sizeof(int16_t) == bytesToRead);
-
-                    for (uint_fast32_t n = 0; n < numSamples; ++n)
-                    {
-#if AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND
-                        *outDataPtr++ = int16_t(std::lroundf(volume * *inDataPtr++));
-#else
-                        *outDataPtr++ = int16_t(volume * *inDataPtr++);
-#endif
-                    }
-
-                    m_inFifoPtr->tail += bytesToRead;
-                }
+                memcpy((uint8_t*) outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToRead);
+                m_inFifoPtr->tail += bytesToRead;
             }
-            m_inFifoPtr->mutex.lock();
-            m_inFifoPtr->count -= bytesToRead;
-            m_inFifoPtr->countChanged.wakeAll();
-            m_inFifoPtr->mutex.unlock();
+            m_inFifoPtr->commitRead(bytesToRead);
 
             // unmute request
             request = Request::None;
@@ -394,6 +568,13 @@ int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferF
     {   // (AudioOutputPlaybackState::Muted != m_playbackState)
         // cannot be anything else than Muted or Playing ==> playing
 
+        // input samples needed for this buffer, jitter buffer compensates drift by resampling
+        uint32_t inputFrames = jitterBufferEna ? m_jitterBuffer.inputFrames(nBufferFrames) : nBufferFrames;
+        if (count < inputFrames * m_bytesPerFrame)
+        {   // no compensation in this buffer
+            inputFrames = nBufferFrames;
+        }
+
         // condition to mute is not enough samples || muteFlag
         if (count < bytesToRead)
         {   // not enough samples -> reading what we have and filling rest with zeros
@@ -415,172 +596,48 @@ int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferF
             uint64_t bytesToEnd = AUDIO_FIFO_SIZE - m_inFifoPtr->tail;
             if (bytesToEnd < count)
             {
-                float volume = m_linearVolume;
-                if (volume > 0.9)
-                {   // only copy here
-                    memcpy((uint8_t*)outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
-                    memcpy((uint8_t*)outputBuffer + bytesToEnd, m_inFifoPtr->buffer, (count - bytesToEnd));
-                    m_inFifoPtr->tail = count - bytesToEnd;
-                }
-                else
-                {
-                    //memcpy((uint8_t*)outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
-                    int16_t * inDataPtr = (int16_t *) (m_inFifoPtr->buffer+m_inFifoPtr->tail);
-                    int16_t * outDataPtr = (int16_t *) outputBuffer;
-                    // each sample is int16 => 2 bytes per samples
-                    uint_fast32_t numSamples = (bytesToEnd >> 1);
-
-                    Q_ASSERT(numSamples*sizeof(int16_t) == bytesToEnd);
-
-                    for (uint_fast32_t n = 0; n < numSamples; ++n)
-                    {
-#if AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND
-                        *outDataPtr++ = int16_t(std::lroundf(volume * *inDataPtr++));
-#else
-                        *outDataPtr++ = int16_t(volume * *inDataPtr++);
-#endif
-                    }
-                    //memcpy((uint8_t*)outputBuffer + bytesToEnd, m_inFifoPtr->buffer, (count - bytesToEnd));
-                    inDataPtr = (int16_t *) m_inFifoPtr->buffer;
-                    // each sample is int16 => 2 bytes per samples
-                    numSamples = ((count - bytesToEnd) >> 1);
-
-                    Q_ASSERT(numSamples*sizeof(int16_t) == (count - bytesToEnd));
-
-                    for (uint_fast32_t n = 0; n < numSamples; ++n)
-                    {
-#if AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND
-                        *outDataPtr++ = int16_t(std::lroundf(volume * *inDataPtr++));
-#else
-                        *outDataPtr++ = int16_t(volume * *inDataPtr++);
-#endif
-                    }
-                    m_inFifoPtr->tail = count - bytesToEnd;
-                }
+                memcpy((uint8_t*)outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
+                memcpy((uint8_t*)outputBuffer + bytesToEnd, m_inFifoPtr->buffer, (count - bytesToEnd));
+                m_inFifoPtr->tail = count - bytesToEnd;
             }
             else
             {
-                float volume = m_linearVolume;
-                if (volume > 0.9)
-                {   // only copy here
-                    memcpy((uint8_t*) outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, count);
-                    m_inFifoPtr->tail += count;
-                }
-                else
-                {
-                    //memcpy((uint8_t*) outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, count);
-                    int16_t * inDataPtr = (int16_t *) (m_inFifoPtr->buffer+m_inFifoPtr->tail);
-                    int16_t * outDataPtr = (int16_t *) outputBuffer;
-                    // each sample is int16 => 2 bytes per samples
-                    uint_fast32_t numSamples = (count >> 1);
-
-                    Q_ASSERT(numSamples*sizeof(int16_t) == count);
-
-                    for (uint_fast32_t n = 0; n < numSamples; ++n)
-                    {
-#if AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND
-                        *outDataPtr++ = int16_t(std::lroundf(volume * *inDataPtr++));
-#else
-                        *outDataPtr++ = int16_t(volume * *inDataPtr++);
-#endif
-                    }
-                    m_inFifoPtr->tail += count;
-                }
+                memcpy((uint8_t*) outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, count);
+                m_inFifoPtr->tail += count;
             }
             // set rest of the samples to be 0
             memset((uint8_t*)outputBuffer+count, 0, bytesToRead-count);
 
-            m_inFifoPtr->mutex.lock();
-            m_inFifoPtr->count -= count;
-            m_inFifoPtr->countChanged.wakeAll();
-            m_inFifoPtr->mutex.unlock();
+            m_inFifoPtr->commitRead(count);
 
             // request to apply mute ramp
             request = Request::Mute;
         }
+        else if (jitterBufferEna)
+        {   // enough sample available -> resampling
+            readResampled(outputBuffer, nBufferFrames, inputFrames);
+            m_inFifoPtr->commitRead(inputFrames * m_bytesPerFrame);
+
+            if (Request::None == request)
+            {   // done
+                return paContinue;
+            }
+        }
         else
         {   // enough sample available -> reading samples
             uint64_t bytesToEnd = AUDIO_FIFO_SIZE - m_inFifoPtr->tail;
             if (bytesToEnd < bytesToRead)
             {
-                float volume = m_linearVolume;
-                if (volume > 0.9)
-                {   // only copy here
-                    memcpy((uint8_t*)outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
-                    memcpy((uint8_t*)outputBuffer + bytesToEnd, m_inFifoPtr->buffer, (bytesToRead - bytesToEnd));
-                    m_inFifoPtr->tail = bytesToRead - bytesToEnd;
-                }
-                else
-                {
-                    //memcpy((uint8_t*)outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
-                    int16_t * inDataPtr = (int16_t *) (m_inFifoPtr->buffer+m_inFifoPtr->tail);
-                    int16_t * outDataPtr = (int16_t *) outputBuffer;
-                    // each sample is int16 => 2 bytes per samples
-                    uint_fast32_t numSamples = (bytesToEnd >> 1);
-
-                    Q_ASSERT(numSamples*sizeof(int16_t) == bytesToEnd);
-
-                    for (uint_fast32_t n = 0; n < numSamples; ++n)
-                    {
-#if AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND
-                        *outDataPtr++ = int16_t(std::lroundf(volume * *inDataPtr++));
-#else
-                        *outDataPtr++ = int16_t(volume * *inDataPtr++);
-#endif
-                    }
-
-                    //memcpy((uint8_t*)outputBuffer + bytesToEnd, m_inFifoPtr->buffer, (bytesToRead - bytesToEnd));
-                    inDataPtr = (int16_t *) m_inFifoPtr->buffer;
-                    outDataPtr = (int16_t *) ((uint8_t*)outputBuffer + bytesToEnd);
-                    // each sample is int16 => 2 bytes per samples
-                    numSamples = ((bytesToRead - bytesToEnd) >> 1);
-
-                    Q_ASSERT(numSamples*sizeof(int16_t) == (bytesToRead - bytesToEnd));
-
-                    for (uint_fast32_t n = 0; n < numSamples; ++n)
-                    {
-#if AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND
-                        *outDataPtr++ = int16_t(std::lroundf(volume * *inDataPtr++));
-#else
-                        *outDataPtr++ = int16_t(volume * *inDataPtr++);
-#endif
-                    }
-                    m_inFifoPtr->tail = bytesToRead - bytesToEnd;
-                }
+                memcpy((uint8_t*)outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
+                memcpy((uint8_t*)outputBuffer + bytesToEnd, m_inFifoPtr->buffer, (bytesToRead - bytesToEnd));
+                m_inFifoPtr->tail = bytesToRead - bytesToEnd;
             }
             else
             {
-                float volume = m_linearVolume;
-                if (volume > 0.9)
-                {
-                    memcpy((uint8_t*) outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToRead);
-                    m_inFifoPtr->tail += bytesToRead;
-                }
-                else
-                {
-                    //memcpy((uint8_t*) outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToRead);
-                    int16_t * inDataPtr = (int16_t *) (m_inFifoPtr->buffer+m_inFifoPtr->tail);
-                    int16_t * outDataPtr = (int16_t *) outputBuffer;
-                    // each sample is int16 => 2 bytes per samples
-                    uint_fast32_t numSamples = (bytesToRead >> 1);
-
-                    Q_ASSERT(numSamples*sizeof(int16_t) == bytesToRead);
-
-                    for (uint_fast32_t n = 0; n < numSamples; ++n)
-                    {
-#if AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND
-                        *outDataPtr++ = int16_t(std::lroundf(volume * *inDataPtr++));
-#else
-                        *outDataPtr++ = int16_t(volume * *inDataPtr++);
-#endif
-                    }
-                    m_inFifoPtr->tail += bytesToRead;
-                }
+                memcpy((uint8_t*) outputBuffer, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToRead);
+                m_inFifoPtr->tail += bytesToRead;
             }
-            m_inFifoPtr->mutex.lock();
-            m_inFifoPtr->count -= bytesToRead;
-            m_inFifoPtr->countChanged.wakeAll();
-            m_inFifoPtr->mutex.unlock();
+            m_inFifoPtr->commitRead(bytesToRead);
 
 //            if ((Request::Restart & request) && (count >= 4*bytesToRead))
 //            {   // removing restart flag ==> play all samples we have
@@ -604,12 +661,12 @@ int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferF
 
         float coe = 2.0 - m_muteFactor;
         float gain = AUDIOOUTPUT_FADE_MIN_LIN;
-        int16_t * dataPtr = (int16_t *) outputBuffer;
+        audioSample_t * dataPtr = (audioSample_t *) outputBuffer;
         for (uint_fast32_t n = 0; n < availableSamples; ++n)
         {
             for (uint_fast8_t c = 0; c < m_numChannels; ++c)
             {
-                *dataPtr = int16_t(std::lroundf(gain * *dataPtr));
+                *dataPtr = audioSampleRound(gain * *dataPtr);
                 dataPtr++;
             }
             gain = gain * coe;  // after by purpose
@@ -632,13 +689,13 @@ int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferF
 
         float gain = 1.0;
 
-        int16_t * dataPtr = (int16_t *) outputBuffer;
+        audioSample_t * dataPtr = (audioSample_t *) outputBuffer;
         for (uint_fast32_t n = 0; n < availableSamples; ++n)
         {
             gain = gain * coe;  // before by purpose
             for (uint_fast8_t c = 0; c < m_numChannels; ++c)
             {
-                *dataPtr = int16_t(std::lroundf(gain * *dataPtr));
+                *dataPtr = audioSampleRound(gain * *dataPtr);
                 dataPtr++;
             }
         }
@@ -654,6 +711,25 @@ int AudioOutputPa::portAudioCbPrivate(void *outputBuffer, unsigned long nBufferF
     return paContinue;
 }
 
+void AudioOutputPa::readResampled(void *outputBuffer, uint32_t numOutFrames, uint32_t numInFrames)
+{   // FIFO read is committed by caller
+    uint64_t bytesToRead = numInFrames * m_bytesPerFrame;
+    uint8_t * inDataPtr = (uint8_t *) m_jitterBuffer.inputBuffer();
+    uint64_t bytesToEnd = AUDIO_FIFO_SIZE - m_inFifoPtr->tail;
+    if (bytesToEnd < bytesToRead)
+    {
+        memcpy(inDataPtr, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
+        memcpy(inDataPtr + bytesToEnd, m_inFifoPtr->buffer, (bytesToRead - bytesToEnd));
+        m_inFifoPtr->tail = bytesToRead - bytesToEnd;
+    }
+    else
+    {
+        memcpy(inDataPtr, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToRead);
+        m_inFifoPtr->tail += bytesToRead;
+    }
+    m_jitterBuffer.process((audioSample_t *) outputBuffer, numInFrames, numOutFrames, 1.0);   // volume is applied by renderOutput()
+}
+
 void AudioOutputPa::portAudioStreamFinishedCb(void *ctx)
 {
     //qDebug() << Q_FUNC_INFO << QThread::currentThreadId();
@@ -696,17 +772,26 @@ void AudioOutputPa::onStreamFinished()
         }
         m_outStream = nullptr;
 
-        err = Pa_Terminate();
-        if (paNoError != err)
+        // device enumeration is slow on some systems, PortAudio is reinitialized only when device list changed
+        // or when stream finished because of device problem
+        if (m_reinitPa || !m_deviceSwitch)
         {
-            qCCritical(audioOutput) << "Pa_Terminate error:" << Pa_GetErrorText(err);
-        }
+            m_reinitPa = false;
+            err = Pa_Terminate();
+            if (paNoError != err)
+            {
+                qCCritical(audioOutput) << "Pa_Terminate error:" << Pa_GetErrorText(err);
+            }
 
-        err = Pa_Initialize();
-        if (paNoError != err)
-        {
-            qCCritical(audioOutput) << "Pa_Initialize error:" << Pa_GetErrorText(err);
+            err = Pa_Initialize();
+            if (paNoError != err)
+            {
+                qCCritical(audioOutput) << "Pa_Initialize error:" << Pa_GetErrorText(err);
+            }
         }
+        m_deviceSwitch = false;
+
+        // only output stream is reopened, FIFO and decoder are not touched
         m_reloadDevice = true;
         start(m_inFifoPtr);
     }
@@ -738,6 +823,7 @@ void AudioOutputPa::setAudioDevice(const QByteArray & deviceId)
 
     if (nullptr != m_outStream)
     {
+        m_deviceSwitch = true;
         PaError err = Pa_AbortStream(m_outStream);
         if (paNoError != err)
         {
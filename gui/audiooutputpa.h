@@ -34,33 +34,51 @@
 #include <QTimer>
 #include <QAudioSink>
 #include <QMediaDevices>
+#include <vector>
 
 #include "audiooutput.h"
 #include "audiofifo.h"
+#include "audiojitterbuffer.h"
 #include "portaudio.h"
 
-#define AUDIOOUTPUT_PORTAUDIO_VOLUME_ROUND      1
-
 // port audio allows to set number of samples in callback
 // this number must be aligned between AUDIOOUTPUT_FADE_TIME_MS and AUDIO_FIFO_CHUNK_MS
 #if (AUDIOOUTPUT_FADE_TIME_MS != AUDIO_FIFO_CHUNK_MS)
 #error "(AUDIOOUTPUT_FADE_TIME_MS != AUDIO_FIFO_CHUNK_MS)"
 #endif
 
+// exclusive mode bypasses system mixer: WASAPI exclusive on Windows, ALSA hw device on Linux
+// and CoreAudio with device parameters changed to stream format on macOS
+#define AUDIOOUTPUTPA_EXCLUSIVE_PERIOD_MS   (10)   // default host buffer period
+#define AUDIOOUTPUTPA_EXCLUSIVE_PERIODS     (3)    // default number of host buffer periods
+
 class AudioOutputPa : public AudioOutput
 {
     Q_OBJECT
 
 public:
+    struct ExclusiveMode
+    {
+        bool enable = false;
+        int periodMs = AUDIOOUTPUTPA_EXCLUSIVE_PERIOD_MS;
+        int numPeriods = AUDIOOUTPUTPA_EXCLUSIVE_PERIODS;
+        QByteArray alsaDevice = "hw:0,0";       // Linux only, ALSA device string
+    };
+
     AudioOutputPa(QObject *parent = nullptr);
     ~AudioOutputPa();
 
     void start(audioFifo_t *buffer) override;
     void restart(audioFifo_t *buffer) override;
     void stop() override;
+    void crossfade(audioFifo_t *buffer) override;
+    void crossfadeBack() override;
     void mute(bool on) override;
     void setVolume(int value) override;
     void setAudioDevice(const QByteArray & deviceId) override;
+    void setTargetLatency(int latencyMs) override { m_jitterBuffer.setTargetLatency(latencyMs); }
+    void setFloatOutput(bool ena);    // float32 samples to device, applied when stream is opened
+    void setExclusiveMode(const ExclusiveMode & mode);   // applied when stream is opened
 
 private:
     enum Request
@@ -75,16 +93,30 @@ private:
     PaStream * m_outStream = nullptr;
     audioFifo_t * m_inFifoPtr = nullptr;
     audioFifo_t * m_restartFifoPtr = nullptr;
+    audioFifo_t * m_activeFifoPtr = nullptr;     // last buffer requested to play (GUI thread)
+    AudioOutputCrossfade m_crossfade;
     uint8_t m_numChannels;
     uint32_t m_sampleRate_kHz;
     unsigned int m_bufferFrames;
     uint8_t m_bytesPerFrame;
     float m_muteFactor;
     std::atomic<float> m_linearVolume;
+    float m_currentVolume;                  // volume applied to last buffer, callback only
+    bool m_floatOutput = false;             // int16 samples are converted to paFloat32 stream format
+    bool m_floatOutputRequest = false;
+    std::vector<int16_t> m_renderBuffer;    // int16 samples before conversion to float32
     AudioOutputPlaybackState m_playbackState;
     bool m_reloadDevice = false;
+    bool m_deviceSwitch = false;            // stream was aborted to change device
+    bool m_reinitPa = false;                // system device list changed, PortAudio has to be reinitialized
+    ExclusiveMode m_exclusiveMode;
+    AudioJitterBuffer m_jitterBuffer;
 
+    int renderOutput(void *outputBuffer, unsigned long nBufferFrames);
     int portAudioCbPrivate(void *outputBuffer, unsigned long nBufferFrames);
+    void readResampled(void *outputBuffer, uint32_t numOutFrames, uint32_t numInFrames);
+    uint32_t playbackLevelMs() const;
+    void switchBuffer(audioFifo_t *buffer);
     void portAudioStreamFinishedPrivateCb() { emit streamFinished(); }
 
     static int portAudioCb(const void *inputBuffer, void *outputBuffer, unsigned long nBufferFrames,
@@ -97,6 +129,7 @@ private:
 
     void onStreamFinished();
     PaDeviceIndex getCurrentDeviceIdx();
+    PaError openExclusiveStream(uint8_t numCh, PaSampleFormat sampleFormat, uint32_t sRate);
 
 signals:
     void streamFinished();     // this signal is emited from portAudioStreamFinishedCb   
@@ -29,8 +29,11 @@
 #include <QThread>
 #include <QAudioSink>
 #include <QAudioDevice>
+#include <algorithm>
 
 #include "audiooutputqt.h"
+#include "diagnostics.h"
+#include "threadpriority.h"
 
 Q_LOGGING_CATEGORY(audioOutput, "AudioOutput", QtInfoMsg)
 
@@ -40,6 +43,12 @@ AudioOutputQt::AudioOutputQt(QObject *parent) : AudioOutput(parent)
     m_ioDevice = nullptr;
     m_linearVolume = 1.0;
     m_ioDevice = new AudioIODevice();
+    m_ioDevice->setBufferSwitchedCallback([this]() { emit audioOutputRestart(); });
+
+    // timer is child object => it is moved to audio output thread together with this object
+    m_pushTimer = new QTimer(this);
+    m_pushTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_pushTimer, &QTimer::timeout, this, &AudioOutputQt::pushPeriods);
 }
 
 AudioOutputQt::~AudioOutputQt()
@@ -60,7 +69,11 @@ void AudioOutputQt::start(audioFifo_t *buffer)
 
     QAudioFormat format;
     format.setSampleRate(sRate);
+#if HAVE_AUDIO_FLOAT32
+    format.setSampleFormat(QAudioFormat::Float);
+#else
     format.setSampleFormat(QAudioFormat::Int16);
+#endif
     format.setChannelCount(numCh);
     if (numCh > 1)
     {
@@ -77,6 +90,7 @@ void AudioOutputQt::start(audioFifo_t *buffer)
         format = m_currentAudioDevice.preferredFormat();
     }
 
+    stopPush();
     if (nullptr != m_audioSink)
     {
         // audioSink exists --> delete
@@ -89,18 +103,85 @@ void AudioOutputQt::start(audioFifo_t *buffer)
 
     // set buffer size to 2* AUDIO_FIFO_CHUNK_MS ms
     // this is causing problem on Windows
-    //m_audioSink->setBufferSize(2 * AUDIO_FIFO_CHUNK_MS * sRate/1000 * numCh * sizeof(int16_t));
+    //m_audioSink->setBufferSize(2 * AUDIO_FIFO_CHUNK_MS * sRate/1000 * numCh * sizeof(audioSample_t));
+    m_pushBytesPerMs = sRate/1000 * numCh * sizeof(audioSample_t);
+    if (m_pushMode.enable)
+    {   // sink buffer holds configured number of periods
+        m_pushBuffer.resize(m_pushMode.periodMs * m_pushBytesPerMs);
+        m_audioSink->setBufferSize(m_pushMode.numPeriods * m_pushBuffer.size());
+    }
+#ifndef Q_OS_WIN
+    else if (m_targetLatencyMs > 0)
+    {   // sink buffer adds to latency of jitter buffer
+        m_audioSink->setBufferSize(2 * AUDIO_FIFO_CHUNK_MS * sRate/1000 * numCh * sizeof(audioSample_t));
+    }
+#endif
 
     connect(m_audioSink, &QAudioSink::stateChanged, this, &AudioOutputQt::handleStateChanged);
 
     m_audioSink->setVolume(m_linearVolume);
     m_currentFifoPtr = buffer;
+    m_ioDevice->crossfade().request(nullptr);
 
     // start IO device
     m_ioDevice->close();
     m_ioDevice->setBuffer(m_currentFifoPtr);
     m_ioDevice->start();
-    m_audioSink->start(m_ioDevice);
+    if (m_pushMode.enable)
+    {   // sink buffer is filled immediately, then it is topped up twice per period
+        m_pushDevice = m_audioSink->start();
+        pushPeriods();
+        m_pushTimer->start(std::max(1, m_pushMode.periodMs / 2));
+    }
+    else
+    {
+        m_audioSink->start(m_ioDevice);
+    }
+
+    // end-to-end latency includes audio sink buffer
+    m_ioDevice->setOutputLatency(uint64_t(m_audioSink->bufferSize()) * 1000 / m_pushBytesPerMs);
+}
+
+void AudioOutputQt::setPushMode(const PushMode &mode)
+{
+    m_pushMode = mode;
+    m_pushMode.periodMs = std::clamp(mode.periodMs, 5, 200);
+    m_pushMode.numPeriods = std::clamp(mode.numPeriods, 2, 16);
+    if (m_pushMode.enable)
+    {
+        qCInfo(audioOutput, "Push mode: %d periods of %d ms", m_pushMode.numPeriods, m_pushMode.periodMs);
+    }
+}
+
+void AudioOutputQt::pushPeriods()
+{
+    if ((nullptr == m_pushDevice) || (nullptr == m_audioSink))
+    {
+        return;
+    }
+
+    qint64 bytesFree = m_audioSink->bytesFree();
+    Diagnostics::getInstance()->add(DiagnosticsMetric::AudioSinkLevel, (m_audioSink->bufferSize() - bytesFree) / m_pushBytesPerMs);
+
+    // only whole periods are written, IO device handles mute, crossfade and jitter buffer as in pull mode
+    qint64 periodBytes = m_pushBuffer.size();
+    while (bytesFree >= periodBytes)
+    {
+        qint64 len = m_ioDevice->readData(m_pushBuffer.data(), periodBytes);
+        if (len <= 0)
+        {   // stop was requested and audio is muted => sink goes to idle state when its buffer is played
+            m_pushTimer->stop();
+            return;
+        }
+        m_pushDevice->write(m_pushBuffer.data(), len);
+        bytesFree -= len;
+    }
+}
+
+void AudioOutputQt::stopPush()
+{
+    m_pushTimer->stop();
+    m_pushDevice = nullptr;
 }
 
 void AudioOutputQt::restart(audioFifo_t *buffer)
@@ -121,6 +202,44 @@ void AudioOutputQt::restart(audioFifo_t *buffer)
     else { /* do nothing */ }
 }
 
+void AudioOutputQt::crossfade(audioFifo_t *buffer)
+{
+    if (nullptr == m_ioDevice->crossfade().standby())
+    {   // buffer of service decoder is kept filled during announcement
+        m_ioDevice->crossfade().setStandby(m_currentFifoPtr);
+    }
+    else { /* announcement decoder was reconfigured, service stays in standby */ }
+    switchBuffer(buffer);
+}
+
+void AudioOutputQt::crossfadeBack()
+{
+    audioFifo_t * buffer = m_ioDevice->crossfade().takeStandby();
+    if (nullptr != buffer)
+    {
+        switchBuffer(buffer);
+    }
+    else { /* no crossfade before */ }
+}
+
+void AudioOutputQt::switchBuffer(audioFifo_t *buffer)
+{
+    if ((nullptr == m_audioSink) || (nullptr == m_currentFifoPtr))
+    {
+        start(buffer);
+    }
+    else if ((buffer->sampleRate == m_currentFifoPtr->sampleRate) && (buffer->numChannels == m_currentFifoPtr->numChannels)
+             && (nullptr == m_restartFifoPtr))
+    {   // IO device switches to new buffer when it is filled
+        m_currentFifoPtr = buffer;
+        m_ioDevice->crossfade().request(buffer);
+    }
+    else
+    {   // different stream parameters => audio is restarted, standby buffer is still drained
+        restart(buffer);
+    }
+}
+
 void AudioOutputQt::mute(bool on)
 {
     m_ioDevice->mute(on);
@@ -137,6 +256,12 @@ void AudioOutputQt::setVolume(int value)
     }
 }
 
+void AudioOutputQt::setTargetLatency(int latencyMs)
+{
+    m_targetLatencyMs = latencyMs;
+    m_ioDevice->setTargetLatency(latencyMs);
+}
+
 void AudioOutputQt::setAudioDevice(const QByteArray & deviceId)
 {
     if ((!deviceId.isEmpty()) && (deviceId == m_currentAudioDevice.id()))
@@ -151,7 +276,7 @@ void AudioOutputQt::setAudioDevice(const QByteArray & deviceId)
             m_currentAudioDevice = dev;
             emit audioDeviceChanged(m_currentAudioDevice.id());
             // change output device to newly selected
-            restart(m_currentFifoPtr);
+            switchDevice();
             return;
         }
     }
@@ -160,11 +285,41 @@ void AudioOutputQt::setAudioDevice(const QByteArray & deviceId)
     m_currentAudioDevice = m_devices->defaultAudioOutput();
     emit audioDeviceChanged(m_currentAudioDevice.id());
     // change output device to newly selected
-    restart(m_currentFifoPtr);
+    switchDevice();
+}
+
+void AudioOutputQt::switchDevice()
+{   // only audio sink is recreated, FIFO content and decoder state are kept
+    if ((nullptr == m_audioSink) || (nullptr == m_currentFifoPtr) || (nullptr != m_restartFifoPtr)
+        || (QAudio::StoppedState == m_audioSink->state()))
+    {   // not playing or restart is pending => new device is used when sink is created
+        return;
+    }
+
+    if (!m_ioDevice->isMuted())
+    {   // delay switch until audio is muted
+        m_switchDevice = true;
+        m_ioDevice->stop();
+        return;
+    }
+    else
+    { /* were are already muted - doSwitchDevice now */ }
+
+    doSwitchDevice();
+}
+
+void AudioOutputQt::doSwitchDevice()
+{
+    m_switchDevice = false;
+    stopPush();
+    m_audioSink->stop();
+    start(m_currentFifoPtr);
 }
 
 void AudioOutputQt::stop()
 {
+    m_switchDevice = false;
+    m_ioDevice->crossfade().reset();
     if (nullptr != m_audioSink)
     {
         if (!m_ioDevice->isMuted())
@@ -182,6 +337,7 @@ void AudioOutputQt::stop()
 
 void AudioOutputQt::doStop()
 {
+    stopPush();
     m_audioSink->stop();
     m_ioDevice->close();
 }
@@ -189,6 +345,7 @@ void AudioOutputQt::doStop()
 void AudioOutputQt::doRestart(audioFifo_t *buffer)
 {
     m_restartFifoPtr = nullptr;
+    stopPush();
     m_audioSink->stop();
     emit audioOutputRestart();
     start(buffer);
@@ -200,16 +357,25 @@ void AudioOutputQt::handleStateChanged(QAudio::State newState)
     switch (newState)
     {
     case QAudio::ActiveState:
-        // do nothing
+        m_reopenCntr = 0;
         break;
     case QAudio::IdleState:
         // no more data
-        if (m_ioDevice->isMuted())
+        if (m_pushTimer->isActive() && (QAudio::Error::NoError == m_audioSink->error()))
+        {   // push mode: periods were not written in time, sink continues when next period is written
+            m_underrunCntr += 1;
+            qCWarning(audioOutput) << "Audio sink underrun, total underruns:" << m_underrunCntr;
+        }
+        else if (m_ioDevice->isMuted())
         {   // this is correct state when stop is requested
             if (nullptr != m_restartFifoPtr)
             {   // restart was requested
                 doRestart(m_restartFifoPtr);
             }
+            else if (m_switchDevice)
+            {   // device change was requested
+                doSwitchDevice();
+            }
             else
             {   // stop was requested
                 doStop();
@@ -222,6 +388,12 @@ void AudioOutputQt::handleStateChanged(QAudio::State newState)
                 qCWarning(audioOutput) << "Audio going to Idle state unexpectly, trying to restart...";
                 doRestart(m_currentFifoPtr);
             }
+            else if (m_reopenCntr < AUDIOOUTPUTQT_REOPEN_MAX)
+            {   // device error (e.g. device was disconnected) -> reopening sink, device is updated when device list changes
+                m_reopenCntr += 1;
+                qCWarning(audioOutput) << "Audio going to Idle state unexpectly, error code:" << m_audioSink->error() << "reopening device...";
+                doSwitchDevice();
+            }
             else
             {   // some error -> doing stop
                 qCWarning(audioOutput) << "Audio going to Idle state unexpectly, error code:" << m_audioSink->error();
@@ -232,6 +404,12 @@ void AudioOutputQt::handleStateChanged(QAudio::State newState)
         break;
     case QAudio::StoppedState:
         // Stopped for other reasons
+        if ((QAudio::Error::NoError != m_audioSink->error()) && (m_reopenCntr < AUDIOOUTPUTQT_REOPEN_MAX))
+        {   // device error (e.g. device was disconnected) -> reopening sink
+            m_reopenCntr += 1;
+            qCWarning(audioOutput) << "Audio stopped unexpectly, error code:" << m_audioSink->error() << "reopening device...";
+            doSwitchDevice();
+        }
         break;
 
     default:
@@ -250,7 +428,9 @@ void AudioIODevice::setBuffer(audioFifo_t * buffer)
 
     m_sampleRate_kHz = buffer->sampleRate / 1000;
     m_numChannels = buffer->numChannels;
-    m_bytesPerFrame = m_numChannels * sizeof(int16_t);
+    m_bytesPerFrame = m_numChannels * sizeof(audioSample_t);
+    m_jitterBuffer.reset(m_sampleRate_kHz, m_numChannels);
+    m_crossfade.reserve(AUDIOOUTPUT_FADE_TIME_MS * m_sampleRate_kHz * m_numChannels);
 
     // mute ramp is exponential
     // value are precalculated to save MIPS in runtime
@@ -276,6 +456,49 @@ void AudioIODevice::stop()
 }
 
 qint64 AudioIODevice::readData(char *data, qint64 len)
+{
+    ThreadPriority::update(ThreadClass::Output);
+    uint64_t startUs = Diagnostics::timestampUs();
+
+    // announcement: service buffer is kept at playback level
+    uint32_t levelMs = playbackLevelMs();
+    m_crossfade.drainStandby(m_inFifoPtr, levelMs);
+
+    // capture time of the first sample played in this buffer
+    uint64_t captureUs = m_inFifoPtr->captureUs();
+
+    qint64 ret = readDataPrivate(data, len);
+    if ((ret > 0) && (0 != captureUs) && !isMuted())
+    {
+        Diagnostics::getInstance()->add(DiagnosticsMetric::EndToEndLatency, (startUs - captureUs + m_outputLatencyUs) / 1000);
+    }
+    else { /* silence or unknown capture time */ }
+
+    if ((ret > 0) && !m_stopFlag
+        && m_crossfade.process(m_inFifoPtr, (audioSample_t *) data, ret / m_bytesPerFrame, levelMs, !isMuted()))
+    {   // playing from another buffer now, announcement state is updated in HMI
+        m_jitterBuffer.reset(m_sampleRate_kHz, m_numChannels);
+        if (m_onBufferSwitched)
+        {
+            m_onBufferSwitched();
+        }
+    }
+    else { /* no switch */ }
+
+    Diagnostics::getInstance()->addDelay(DiagnosticsMetric::AudioCallbackTime, startUs);
+    return ret;
+}
+
+uint32_t AudioIODevice::playbackLevelMs() const
+{
+    if (m_jitterBuffer.isEnabled())
+    {
+        return m_jitterBuffer.targetFrames() / m_sampleRate_kHz;
+    }
+    return 500;   // unmute threshold
+}
+
+qint64 AudioIODevice::readDataPrivate(char *data, qint64 len)
 {
     if (m_doStop || (0 == len))
     {
@@ -283,9 +506,8 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
     }
 
     // read samples from input buffer
-    m_inFifoPtr->mutex.lock();
-    uint64_t count = m_inFifoPtr->count;
-    m_inFifoPtr->mutex.unlock();
+    uint64_t count = m_inFifoPtr->availableBytes();
+    Diagnostics::getInstance()->add(DiagnosticsMetric::AudioFifoLevel, count / (m_bytesPerFrame * m_sampleRate_kHz));
 
     bool muteRequest = m_muteFlag || m_stopFlag;
     m_doStop = m_stopFlag;
@@ -294,12 +516,26 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
 
     uint64_t numSamples = len / m_bytesPerFrame;
 
+    // adaptive jitter buffer keeps fill level around target latency
+    bool jitterBufferEna = m_jitterBuffer.isEnabled();
+    uint64_t unmuteThreshold = 500*m_sampleRate_kHz*m_bytesPerFrame;    // 800ms of signal
+    if (jitterBufferEna)
+    {
+        if (numSamples > m_jitterBuffer.maxOutputFrames())
+        {   // only part of requested data is provided
+            numSamples = m_jitterBuffer.maxOutputFrames();
+        }
+        bytesToRead = numSamples * m_bytesPerFrame;
+        m_jitterBuffer.update(count / m_bytesPerFrame, numSamples);
+        unmuteThreshold = m_jitterBuffer.targetFrames() * m_bytesPerFrame;
+    }
+
     //qDebug() << Q_FUNC_INFO << len << count;
 
     if (AudioOutputPlaybackState::Muted == m_playbackState)
     {   // muted
         // condition to unmute is enough samples
-        if (count > 500*m_sampleRate_kHz*m_bytesPerFrame)    // 800ms of signal
+        if (count > unmuteThreshold)
         {   // enough samples => reading data from input fifo
             if (muteRequest)
             {   // staying muted -> setting output buffer to 0
@@ -307,10 +543,7 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
 
                 // shifting buffer pointers
                 m_inFifoPtr->tail = (m_inFifoPtr->tail + bytesToRead) % AUDIO_FIFO_SIZE;
-                m_inFifoPtr->mutex.lock();
-                m_inFifoPtr->count -= bytesToRead;
-                m_inFifoPtr->countChanged.wakeAll();
-                m_inFifoPtr->mutex.unlock();
+                m_inFifoPtr->commitRead(bytesToRead);
 
                 // done
                 return bytesToRead;
@@ -331,10 +564,7 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
                 m_inFifoPtr->tail += bytesToRead;
             }
 
-            m_inFifoPtr->mutex.lock();
-            m_inFifoPtr->count -= bytesToRead;
-            m_inFifoPtr->countChanged.wakeAll();
-            m_inFifoPtr->mutex.unlock();
+            m_inFifoPtr->commitRead(bytesToRead);
 
             // unmute request
             muteRequest = false;
@@ -385,10 +615,7 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
             //                    m_inFifoPtr->tail += bytesToRead;
             //                }
 
-            //                m_inFifoPtr->mutex.lock();
-            //                m_inFifoPtr->count -= bytesToRead;
-            //                m_inFifoPtr->countChanged.wakeAll();
-            //                m_inFifoPtr->mutex.unlock();
+            //                m_inFifoPtr->commitRead(bytesToRead);
 
             //                return bytesToRead;
             //            }
@@ -409,16 +636,44 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
             // set rest of the samples to be 0
             memset((uint8_t*)data+count, 0, bytesToRead-count);
 
-            m_inFifoPtr->mutex.lock();
-            m_inFifoPtr->count -= count;
-            m_inFifoPtr->countChanged.wakeAll();
-            m_inFifoPtr->mutex.unlock();
+            m_inFifoPtr->commitRead(count);
 
             numSamples = count / m_bytesPerFrame;
 
             // request to apply mute ramp
             muteRequest = true;  // mute
         }
+        else if (jitterBufferEna)
+        {   // enough sample available -> resampling
+            uint32_t inputFrames = m_jitterBuffer.inputFrames(numSamples);
+            if (count < inputFrames * m_bytesPerFrame)
+            {   // no compensation in this buffer
+                inputFrames = numSamples;
+            }
+            uint64_t bytesToResample = inputFrames * m_bytesPerFrame;
+            uint8_t * inDataPtr = (uint8_t *) m_jitterBuffer.inputBuffer();
+            uint64_t bytesToEnd = AUDIO_FIFO_SIZE - m_inFifoPtr->tail;
+            if (bytesToEnd < bytesToResample)
+            {
+                memcpy(inDataPtr, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToEnd);
+                memcpy(inDataPtr + bytesToEnd, m_inFifoPtr->buffer, (bytesToResample - bytesToEnd));
+                m_inFifoPtr->tail = bytesToResample - bytesToEnd;
+            }
+            else
+            {
+                memcpy(inDataPtr, m_inFifoPtr->buffer+m_inFifoPtr->tail, bytesToResample);
+                m_inFifoPtr->tail += bytesToResample;
+            }
+            m_inFifoPtr->commitRead(bytesToResample);
+
+            // volume is applied by audio sink
+            m_jitterBuffer.process((audioSample_t *) data, inputFrames, numSamples, 1.0f);
+
+            if (!muteRequest)
+            {   // done
+                return bytesToRead;
+            }
+        }
         else
         {   // enough sample available -> reading samples
             uint64_t bytesToEnd = AUDIO_FIFO_SIZE - m_inFifoPtr->tail;
@@ -434,10 +689,7 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
                 m_inFifoPtr->tail += bytesToRead;
             }
 
-            m_inFifoPtr->mutex.lock();
-            m_inFifoPtr->count -= bytesToRead;
-            m_inFifoPtr->countChanged.wakeAll();
-            m_inFifoPtr->mutex.unlock();
+            m_inFifoPtr->commitRead(bytesToRead);
 
             if (!muteRequest)
             {   // done
@@ -464,12 +716,12 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
         }
 
         float gain = AUDIOOUTPUT_FADE_MIN_LIN;
-        int16_t * dataPtr = (int16_t *) data;
+        audioSample_t * dataPtr = (audioSample_t *) data;
         for (uint_fast32_t n = 0; n < numSamples; ++n)
         {
             for (uint_fast8_t c = 0; c < m_numChannels; ++c)
             {
-                *dataPtr = int16_t(qRound(gain * *dataPtr));
+                *dataPtr = audioSampleRound(gain * *dataPtr);
                 dataPtr++;
             }
             gain = gain * coe;  // after by purpose
@@ -486,13 +738,13 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
             float gain = 1.0;
             float coe = powf(10, AUDIOOUTPUT_FADE_MIN_DB/(20.0*numSamples));
 
-            int16_t * dataPtr = (int16_t *) data;
+            audioSample_t * dataPtr = (audioSample_t *) data;
             for (uint_fast32_t n = 0; n < numSamples; ++n)
             {
                 gain = gain * coe;  // before by purpose
                 for (uint_fast8_t c = 0; c < m_numChannels; ++c)
                 {
-                    *dataPtr = int16_t(qRound(gain * *dataPtr));
+                    *dataPtr = audioSampleRound(gain * *dataPtr);
                     dataPtr++;
                 }
             }
@@ -502,13 +754,13 @@ qint64 AudioIODevice::readData(char *data, qint64 len)
             float gain = 1.0;
             float coe = m_muteFactor;
 
-            int16_t * dataPtr = (int16_t *) data;
+            audioSample_t * dataPtr = (audioSample_t *) data;
             for (uint_fast32_t n = 0; n < AUDIOOUTPUT_FADE_TIME_MS*m_sampleRate_kHz; ++n)
             {
                 gain = gain * coe;  // before by purpose
                 for (uint_fast8_t c = 0; c < m_numChannels; ++c)
                 {
-                    *dataPtr = int16_t(qRound(gain * *dataPtr));
+                    *dataPtr = audioSampleRound(gain * *dataPtr);
                     dataPtr++;
                 }
             }
@@ -530,9 +782,7 @@ qint64 AudioIODevice::writeData(const char *data, qint64 len)
 
 qint64 AudioIODevice::bytesAvailable() const
 {
-    m_inFifoPtr->mutex.lock();
-    int64_t count = m_inFifoPtr->count;
-    m_inFifoPtr->mutex.unlock();
+    int64_t count = m_inFifoPtr->availableBytes();
 
     return count;
 }
@@ -34,9 +34,19 @@
 #include <QTimer>
 #include <QAudioSink>
 #include <QMediaDevices>
+#include <functional>
+#include <vector>
 
 #include "audiooutput.h"
 #include "audiofifo.h"
+#include "audiojitterbuffer.h"
+
+#define AUDIOOUTPUTQT_REOPEN_MAX  (3)     // attempts to reopen audio sink after device error
+
+// push mode: periods of fixed size are written to audio sink from audio output thread
+// instead of audio sink pulling data from IO device in small chunks
+#define AUDIOOUTPUTQT_PUSH_PERIOD_MS  (20)    // default period
+#define AUDIOOUTPUTQT_PUSH_PERIODS    (4)     // default number of periods in audio sink buffer
 
 class AudioIODevice;
 
@@ -45,15 +55,26 @@ class AudioOutputQt : public AudioOutput
     Q_OBJECT
 
 public:
+    struct PushMode
+    {
+        bool enable = false;
+        int periodMs = AUDIOOUTPUTQT_PUSH_PERIOD_MS;
+        int numPeriods = AUDIOOUTPUTQT_PUSH_PERIODS;
+    };
+
     AudioOutputQt(QObject *parent = nullptr);
     ~AudioOutputQt();
 
     void start(audioFifo_t *buffer) override;
     void restart(audioFifo_t *buffer) override;
     void stop() override;
+    void crossfade(audioFifo_t *buffer) override;
+    void crossfadeBack() override;
     void mute(bool on) override;
     void setVolume(int value) override;
     void setAudioDevice(const QByteArray & deviceId) override;
+    void setTargetLatency(int latencyMs) override;
+    void setPushMode(const PushMode & mode);     // applied when audio sink is started
 
 private:
     // Qt audio
@@ -62,11 +83,28 @@ private:
     float m_linearVolume;
     audioFifo_t * m_currentFifoPtr = nullptr;
     audioFifo_t * m_restartFifoPtr = nullptr;
+    int m_targetLatencyMs = 0;
+    bool m_switchDevice = false;        // sink is recreated for new device when muted
+    int m_reopenCntr = 0;               // attempts to reopen sink after error
+
+    // push mode
+    PushMode m_pushMode;
+    QIODevice * m_pushDevice = nullptr;     // owned by audio sink
+    QTimer * m_pushTimer;
+    std::vector<char> m_pushBuffer;         // one period
+    uint32_t m_pushBytesPerMs = 0;
+    uint64_t m_underrunCntr = 0;
+
+    void pushPeriods();
+    void stopPush();
 
     void handleStateChanged(QAudio::State newState);
     int64_t bytesAvailable();
     void doStop();
     void doRestart(audioFifo_t *buffer);
+    void switchDevice();
+    void doSwitchDevice();
+    void switchBuffer(audioFifo_t *buffer);
 };
 
 
@@ -84,7 +122,11 @@ public:
     qint64 bytesAvailable() const override;
 
     void mute(bool on);
+    void setTargetLatency(int latencyMs) { m_jitterBuffer.setTargetLatency(latencyMs); }
     bool isMuted() const { return AudioOutputPlaybackState::Muted == m_playbackState; }
+    AudioOutputCrossfade & crossfade() { return m_crossfade; }
+    void setBufferSwitchedCallback(const std::function<void()> & cb) { m_onBufferSwitched = cb; }
+    void setOutputLatency(uint32_t latencyUs) { m_outputLatencyUs = latencyUs; }    // latency of audio sink buffer
 
 private:
     audioFifo_t * m_inFifoPtr = nullptr;
@@ -94,9 +136,16 @@ private:
     uint8_t m_numChannels;
     float m_muteFactor;
     bool m_doStop = false;
+    AudioJitterBuffer m_jitterBuffer;
+    AudioOutputCrossfade m_crossfade;
+    std::function<void()> m_onBufferSwitched;
+
+    uint32_t playbackLevelMs() const;
+    qint64 readDataPrivate(char *data, qint64 len);
 
     std::atomic<bool> m_muteFlag  = false;
     std::atomic<bool> m_stopFlag  = false;
+    std::atomic<uint32_t> m_outputLatencyUs = 0;
 };
 
 #endif // AUDIOOUTPUTQT_H
@@ -0,0 +1,228 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QThreadPool>
+#include <QThread>
+#include <QLoggingCategory>
+#include <cmath>
+#include <memory>
+#include "audiorecencoder.h"
+#include "audiorecflac.h"
+
+Q_LOGGING_CATEGORY(audioRecEncoder, "AudioRecEncoder", QtInfoMsg)
+
+// one pool for all recorders, one core is left for decoding
+// static initialization is thread safe, pool waits for remaining tasks when it is destroyed at exit
+static QThreadPool * encoderPool()
+{
+    static const std::unique_ptr<QThreadPool> pool = []() {
+        std::unique_ptr<QThreadPool> p(new QThreadPool());
+        p->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+        p->setObjectName("audioRecEncoder");
+        return p;
+    }();
+    return pool.get();
+}
+
+AudioRecEncoder::AudioRecEncoder()
+{}
+
+AudioRecEncoder::~AudioRecEncoder()
+{
+    delete m_currentChunk;
+
+    // tasks of this encoder are drained before its members are destroyed
+    QMutexLocker locker(&m_mutex);
+    while (m_numRunning > 0)
+    {
+        m_doneCondition.wait(&m_mutex);
+    }
+    qDeleteAll(m_chunks);
+    m_chunks.clear();
+}
+
+void AudioRecEncoder::start(int sampleRateHz)
+{
+    finish();
+    std::vector<uint8_t> data;
+    while (takeEncoded(data))
+    {   // data of previous stream are discarded
+    }
+
+    m_sampleRateHz = sampleRateHz;
+    m_nextFrame = 0;
+    m_encodedSamples = 0;
+    m_droppedSamples = 0;
+    m_isDropping = false;
+
+    QMutexLocker locker(&m_mutex);
+    m_minFrameSize = 0;
+    m_maxFrameSize = 0;
+}
+
+void AudioRecEncoder::write(const audioSample_t *data, size_t numSamples)
+{
+    const size_t chunkSamples = 2 * AUDIORECENCODER_CHUNK_FRAMES * AUDIORECFLAC_BLOCK_SIZE;
+    while (numSamples > 0)
+    {
+        if (nullptr == m_currentChunk)
+        {
+            m_mutex.lock();
+            bool isFull = (m_chunks.size() >= AUDIORECENCODER_MAX_CHUNKS);
+            m_mutex.unlock();
+            if (isFull)
+            {   // encoding is too slow, decoding has priority
+                m_droppedSamples += numSamples / 2;
+                if (!m_isDropping)
+                {
+                    qCWarning(audioRecEncoder) << "Encoder does not keep up, dropping recorded audio";
+                    m_isDropping = true;
+                }
+                return;
+            }
+            m_isDropping = false;
+            m_currentChunk = new Chunk;
+            m_currentChunk->firstFrame = m_nextFrame;
+            m_currentChunk->pcm.reserve(chunkSamples);
+        }
+
+        size_t num = qMin(numSamples, chunkSamples - m_currentChunk->pcm.size());
+        m_currentChunk->pcm.insert(m_currentChunk->pcm.end(), data, data + num);
+        data += num;
+        numSamples -= num;
+
+        if (m_currentChunk->pcm.size() >= chunkSamples)
+        {
+            submitCurrentChunk();
+        }
+    }
+}
+
+bool AudioRecEncoder::takeEncoded(std::vector<uint8_t> &data)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_chunks.isEmpty() || !m_chunks.head()->isDone)
+    {
+        return false;
+    }
+
+    Chunk * chunk = m_chunks.dequeue();
+    locker.unlock();
+
+    data.swap(chunk->encoded);
+    delete chunk;
+    return true;
+}
+
+void AudioRecEncoder::finish()
+{
+    submitCurrentChunk();
+
+    QMutexLocker locker(&m_mutex);
+    while (m_numRunning > 0)
+    {
+        m_doneCondition.wait(&m_mutex);
+    }
+}
+
+QByteArray AudioRecEncoder::streamHeader() const
+{
+    QMutexLocker locker(&m_mutex);
+    std::vector<uint8_t> header = AudioRecFlac::streamHeader(m_sampleRateHz, m_encodedSamples, m_minFrameSize, m_maxFrameSize);
+    return QByteArray(reinterpret_cast<const char *>(header.data()), header.size());
+}
+
+void AudioRecEncoder::submitCurrentChunk()
+{
+    if ((nullptr == m_currentChunk) || m_currentChunk->pcm.empty())
+    {
+        delete m_currentChunk;
+        m_currentChunk = nullptr;
+        return;
+    }
+
+    // partial chunk is submitted only when stream ends, its last frame is shorter
+    size_t samplesPerChannel = m_currentChunk->pcm.size() / 2;
+    m_nextFrame += (samplesPerChannel + AUDIORECFLAC_BLOCK_SIZE - 1) / AUDIORECFLAC_BLOCK_SIZE;
+    m_encodedSamples += samplesPerChannel;
+
+    Chunk * chunk = m_currentChunk;
+    m_currentChunk = nullptr;
+
+    m_mutex.lock();
+    m_chunks.enqueue(chunk);
+    m_numRunning += 1;
+    m_mutex.unlock();
+
+    encoderPool()->start([this, chunk]() { encodeChunk(chunk); });
+}
+
+void AudioRecEncoder::encodeChunk(Chunk *chunk)
+{
+    QThread::currentThread()->setPriority(QThread::LowPriority);
+
+    std::vector<int32_t> left(AUDIORECFLAC_BLOCK_SIZE);
+    std::vector<int32_t> right(AUDIORECFLAC_BLOCK_SIZE);
+    size_t samplesPerChannel = chunk->pcm.size() / 2;
+    const audioSample_t * in = chunk->pcm.data();
+    chunk->encoded.reserve(chunk->pcm.size() * sizeof(int16_t) * 2 / 3);
+    uint32_t frame = chunk->firstFrame;
+    for (size_t pos = 0; pos < samplesPerChannel; pos += AUDIORECFLAC_BLOCK_SIZE)
+    {
+        uint32_t blockSize = uint32_t(qMin(samplesPerChannel - pos, size_t(AUDIORECFLAC_BLOCK_SIZE)));
+        for (uint32_t n = 0; n < blockSize; ++n)
+        {
+#if HAVE_AUDIO_FLOAT32
+            // FLAC stream is 16 bit
+            left[n] = qBound(-32768L, std::lrintf(*in++ * 32768.0f), 32767L);
+            right[n] = qBound(-32768L, std::lrintf(*in++ * 32768.0f), 32767L);
+#else
+            left[n] = *in++;
+            right[n] = *in++;
+#endif
+        }
+        size_t frameStart = chunk->encoded.size();
+        AudioRecFlac::encodeFrame(left.data(), right.data(), blockSize, frame++, m_sampleRateHz, chunk->encoded);
+        uint32_t frameSize = uint32_t(chunk->encoded.size() - frameStart);
+        if ((0 == chunk->minFrameSize) || (frameSize < chunk->minFrameSize))
+        {
+            chunk->minFrameSize = frameSize;
+        }
+        chunk->maxFrameSize = qMax(chunk->maxFrameSize, frameSize);
+    }
+    chunk->pcm.clear();
+    chunk->pcm.shrink_to_fit();
+
+    QMutexLocker locker(&m_mutex);
+    if ((0 == m_minFrameSize) || (chunk->minFrameSize < m_minFrameSize))
+    {
+        m_minFrameSize = chunk->minFrameSize;
+    }
+    m_maxFrameSize = qMax(m_maxFrameSize, chunk->maxFrameSize);
+    chunk->isDone = true;
+    m_numRunning -= 1;
+    m_doneCondition.wakeAll();
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIORECENCODER_H
+#define AUDIORECENCODER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QByteArray>
+#include <vector>
+
+#include "audiofifo.h"
+
+#define AUDIORECENCODER_CHUNK_FRAMES  (16)   // FLAC frames encoded by one job (~1.4 s @ 48 kHz)
+#define AUDIORECENCODER_MAX_CHUNKS    (16)   // chunks waiting for encoding or for caller, audio is dropped when exceeded
+
+// FLAC encoding of decoded audio on worker pool shared by all recorders
+// caller (audio decoder thread) only copies interleaved stereo samples to chunks, complete chunks are encoded
+// in parallel and encoded data are taken by caller in stream order, caller never waits except in finish()
+class AudioRecEncoder
+{
+public:
+    AudioRecEncoder();
+    ~AudioRecEncoder();     // waits for running jobs
+
+    void start(int sampleRateHz);
+
+    // interleaved stereo samples, numSamples is number of values (L and R)
+    void write(const audioSample_t * data, size_t numSamples);
+
+    // next encoded chunk in stream order if it is ready, returns false otherwise
+    bool takeEncoded(std::vector<uint8_t> & data);
+
+    // last partial chunk is encoded, waits for all jobs
+    // encoded data have to be taken by takeEncoded() afterwards
+    void finish();
+
+    // "fLaC" + STREAMINFO with number of encoded samples, written to beginning of file when recording stops
+    QByteArray streamHeader() const;
+
+    uint64_t droppedSamples() const { return m_droppedSamples; }
+
+private:
+    struct Chunk
+    {
+        uint32_t firstFrame;
+        std::vector<audioSample_t> pcm;
+        std::vector<uint8_t> encoded;
+        uint32_t minFrameSize = 0;
+        uint32_t maxFrameSize = 0;
+        bool isDone = false;
+    };
+
+    // caller side
+    int m_sampleRateHz = 48000;
+    Chunk * m_currentChunk = nullptr;
+    uint32_t m_nextFrame = 0;
+    uint64_t m_encodedSamples = 0;
+    uint64_t m_droppedSamples = 0;
+    bool m_isDropping = false;
+
+    // shared with jobs
+    mutable QMutex m_mutex;
+    QWaitCondition m_doneCondition;
+    QQueue<Chunk *> m_chunks;       // submitted chunks in stream order
+    int m_numRunning = 0;
+    uint32_t m_minFrameSize = 0;
+    uint32_t m_maxFrameSize = 0;
+
+    void submitCurrentChunk();
+    void encodeChunk(Chunk * chunk);
+};
+
+#endif // AUDIORECENCODER_H
@@ -0,0 +1,469 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdlib>
+#include "audiorecflac.h"
+
+namespace
+{
+
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t> & out) : m_out(out) { }
+
+    // bits <= 32
+    void put(uint32_t value, uint32_t bits)
+    {
+        m_acc = (m_acc << bits) | (value & ((uint64_t(1) << bits) - 1));
+        m_bits += bits;
+        while (m_bits >= 8)
+        {
+            m_bits -= 8;
+            m_out.push_back(uint8_t(m_acc >> m_bits));
+        }
+        m_acc &= (uint64_t(1) << m_bits) - 1;
+    }
+
+    void putRice(uint32_t value, uint32_t k)
+    {
+        uint32_t q = value >> k;
+        while (q >= 32)
+        {
+            put(0, 32);
+            q -= 32;
+        }
+        if (q + 1 + k <= 32)
+        {   // unary part, stop bit and remainder at once
+            put((uint32_t(1) << k) | (value & ((uint32_t(1) << k) - 1)), q + 1 + k);
+        }
+        else
+        {
+            put(1, q + 1);
+            put(value, k);
+        }
+    }
+
+    void putUtf8(uint32_t value)
+    {   // frame number, UTF-8 like coding
+        if (value < 0x80)
+        {
+            put(value, 8);
+            return;
+        }
+        int numBytes = (value < 0x800) ? 2 : (value < 0x10000) ? 3 : (value < 0x200000) ? 4 : (value < 0x4000000) ? 5 : 6;
+        put((0xFF00 >> numBytes) | (value >> (6 * (numBytes - 1))), 8);
+        for (int n = numBytes - 2; n >= 0; --n)
+        {
+            put(0x80 | ((value >> (6 * n)) & 0x3F), 8);
+        }
+    }
+
+    void alignToByte()
+    {
+        if (m_bits > 0)
+        {
+            put(0, 8 - m_bits);
+        }
+    }
+
+private:
+    std::vector<uint8_t> & m_out;
+    uint64_t m_acc = 0;
+    uint32_t m_bits = 0;
+};
+
+uint8_t crc8(const uint8_t * data, size_t len)
+{   // polynomial x^8 + x^2 + x + 1
+    uint8_t crc = 0;
+    for (size_t n = 0; n < len; ++n)
+    {
+        crc ^= data[n];
+        for (int b = 0; b < 8; ++b)
+        {
+            crc = (crc & 0x80) ? uint8_t((crc << 1) ^ 0x07) : uint8_t(crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint16_t crc16(const uint8_t * data, size_t len)
+{   // polynomial x^16 + x^15 + x^2 + 1
+    uint16_t crc = 0;
+    for (size_t n = 0; n < len; ++n)
+    {
+        crc ^= uint16_t(data[n]) << 8;
+        for (int b = 0; b < 8; ++b)
+        {
+            crc = (crc & 0x8000) ? uint16_t((crc << 1) ^ 0x8005) : uint16_t(crc << 1);
+        }
+    }
+    return crc;
+}
+
+inline uint32_t zigzag(int32_t r)
+{
+    return (uint32_t(r) << 1) ^ uint32_t(r >> 31);
+}
+
+// sums of absolute residuals of fixed predictors 0..4, used to select order
+void fixedResidualSums(const int32_t * x, uint32_t n, uint64_t sums[AUDIORECFLAC_MAX_FIXED_ORDER + 1])
+{
+    for (int o = 0; o <= AUDIORECFLAC_MAX_FIXED_ORDER; ++o)
+    {
+        sums[o] = 0;
+    }
+    for (uint32_t i = AUDIORECFLAC_MAX_FIXED_ORDER; i < n; ++i)
+    {
+        int64_t e0 = x[i];
+        int64_t e1 = e0 - x[i-1];
+        int64_t e2 = e1 - (int64_t(x[i-1]) - x[i-2]);
+        int64_t e3 = e2 - (int64_t(x[i-1]) - 2 * int64_t(x[i-2]) + x[i-3]);
+        int64_t e4 = e3 - (int64_t(x[i-1]) - 3 * int64_t(x[i-2]) + 3 * int64_t(x[i-3]) - x[i-4]);
+        sums[0] += std::llabs(e0);
+        sums[1] += std::llabs(e1);
+        sums[2] += std::llabs(e2);
+        sums[3] += std::llabs(e3);
+        sums[4] += std::llabs(e4);
+    }
+}
+
+int bestFixedOrder(const uint64_t sums[AUDIORECFLAC_MAX_FIXED_ORDER + 1])
+{
+    int order = 0;
+    for (int o = 1; o <= AUDIORECFLAC_MAX_FIXED_ORDER; ++o)
+    {
+        if (sums[o] < sums[order])
+        {
+            order = o;
+        }
+    }
+    return order;
+}
+
+void fixedResidual(const int32_t * x, uint32_t n, int order, int32_t * r)
+{
+    for (uint32_t i = order; i < n; ++i)
+    {
+        switch (order)
+        {
+        case 0: r[i - order] = x[i]; break;
+        case 1: r[i - order] = x[i] - x[i-1]; break;
+        case 2: r[i - order] = x[i] - 2*x[i-1] + x[i-2]; break;
+        case 3: r[i - order] = x[i] - 3*x[i-1] + 3*x[i-2] - x[i-3]; break;
+        default: r[i - order] = x[i] - 4*x[i-1] + 6*x[i-2] - 4*x[i-3] + x[i-4]; break;
+        }
+    }
+}
+
+// estimated bits of Rice partition, parameter is returned in k
+uint64_t riceCost(uint64_t sum, uint32_t num, uint32_t & k)
+{
+    uint64_t best = UINT64_MAX;
+    for (uint32_t p = 0; p <= AUDIORECFLAC_MAX_RICE_PARAM; ++p)
+    {
+        uint64_t bits = uint64_t(num) * (p + 1) + (sum >> p);
+        if (bits < best)
+        {
+            best = bits;
+            k = p;
+        }
+    }
+    return best + 4;
+}
+
+struct RiceCoding
+{
+    uint32_t partitionOrder = 0;
+    uint32_t params[1 << AUDIORECFLAC_MAX_PARTITION];
+    uint64_t bits = UINT64_MAX;
+};
+
+// partition order and Rice parameters with minimal size
+// sums of the finest partitioning are merged for lower orders
+void selectRiceCoding(const uint32_t * u, uint32_t blockSize, int order, RiceCoding & coding)
+{
+    uint32_t maxOrder = 0;
+    while ((maxOrder < AUDIORECFLAC_MAX_PARTITION) && (0 == (blockSize & ((2u << maxOrder) - 1)))
+           && ((blockSize >> (maxOrder + 1)) > uint32_t(order)))
+    {
+        ++maxOrder;
+    }
+
+    uint64_t sums[1 << AUDIORECFLAC_MAX_PARTITION];
+    uint32_t numPartitions = 1u << maxOrder;
+    uint32_t partitionSize = blockSize >> maxOrder;
+    const uint32_t * ptr = u;
+    for (uint32_t p = 0; p < numPartitions; ++p)
+    {
+        uint32_t num = (0 == p) ? partitionSize - order : partitionSize;
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < num; ++i)
+        {
+            sum += ptr[i];
+        }
+        sums[p] = sum;
+        ptr += num;
+    }
+
+    for (int po = int(maxOrder); po >= 0; --po)
+    {
+        uint32_t parts = 1u << po;
+        uint32_t size = blockSize >> po;
+        uint32_t params[1 << AUDIORECFLAC_MAX_PARTITION];
+        uint64_t bits = 4;     // partition order
+        for (uint32_t p = 0; p < parts; ++p)
+        {
+            bits += riceCost(sums[p], (0 == p) ? size - order : size, params[p]);
+        }
+        if (bits < coding.bits)
+        {
+            coding.bits = bits;
+            coding.partitionOrder = po;
+            for (uint32_t p = 0; p < parts; ++p)
+            {
+                coding.params[p] = params[p];
+            }
+        }
+        if (po > 0)
+        {   // merge pairs for lower order
+            for (uint32_t p = 0; p < parts / 2; ++p)
+            {
+                sums[p] = sums[2*p] + sums[2*p + 1];
+            }
+        }
+    }
+}
+
+void encodeSubframe(BitWriter & bw, const int32_t * x, uint32_t n, uint32_t bps, std::vector<int32_t> & residual, std::vector<uint32_t> & u)
+{
+    bool isConstant = true;
+    for (uint32_t i = 1; (i < n) && isConstant; ++i)
+    {
+        isConstant = (x[i] == x[0]);
+    }
+    if (isConstant)
+    {   // typically digital silence
+        bw.put(0, 8);                  // zero pad, type 000000 (constant), no wasted bits
+        bw.put(uint32_t(x[0]), bps);
+        return;
+    }
+
+    int order = 0;
+    RiceCoding coding;
+    if (n > AUDIORECFLAC_MAX_FIXED_ORDER)
+    {
+        uint64_t sums[AUDIORECFLAC_MAX_FIXED_ORDER + 1];
+        fixedResidualSums(x, n, sums);
+        order = bestFixedOrder(sums);
+
+        residual.resize(n);
+        u.resize(n);
+        fixedResidual(x, n, order, residual.data());
+        for (uint32_t i = 0; i < n - order; ++i)
+        {
+            u[i] = zigzag(residual[i]);
+        }
+        selectRiceCoding(u.data(), n, order, coding);
+    }
+    else { /* too short for predictor, verbatim */ }
+
+    if ((UINT64_MAX == coding.bits) || (uint64_t(order) * bps + 2 + coding.bits >= uint64_t(n) * bps))
+    {   // verbatim
+        bw.put(0x02, 8);               // zero pad, type 000001 (verbatim), no wasted bits
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            bw.put(uint32_t(x[i]), bps);
+        }
+        return;
+    }
+
+    bw.put((0x08 | order) << 1, 8);    // zero pad, type 001xxx (fixed), no wasted bits
+    for (int i = 0; i < order; ++i)
+    {   // warm-up samples
+        bw.put(uint32_t(x[i]), bps);
+    }
+    bw.put(0, 2);                      // Rice coding with 4 bit parameters
+    bw.put(coding.partitionOrder, 4);
+    uint32_t parts = 1u << coding.partitionOrder;
+    uint32_t size = n >> coding.partitionOrder;
+    const uint32_t * ptr = u.data();
+    for (uint32_t p = 0; p < parts; ++p)
+    {
+        uint32_t k = coding.params[p];
+        uint32_t num = (0 == p) ? size - order : size;
+        bw.put(k, 4);
+        for (uint32_t i = 0; i < num; ++i)
+        {
+            bw.putRice(ptr[i], k);
+        }
+        ptr += num;
+    }
+}
+
+uint64_t estimateBits(const int32_t * x, uint32_t n)
+{
+    if (n <= AUDIORECFLAC_MAX_FIXED_ORDER)
+    {
+        return 0;
+    }
+    uint64_t sums[AUDIORECFLAC_MAX_FIXED_ORDER + 1];
+    fixedResidualSums(x, n, sums);
+    return sums[bestFixedOrder(sums)];
+}
+
+uint32_t sampleRateCode(uint32_t sampleRate)
+{
+    switch (sampleRate)
+    {
+    case 8000: return 0x4;
+    case 16000: return 0x5;
+    case 22050: return 0x6;
+    case 24000: return 0x7;
+    case 32000: return 0x8;
+    case 44100: return 0x9;
+    case 48000: return 0xA;
+    case 96000: return 0xB;
+    default: return 0x0;       // from STREAMINFO
+    }
+}
+
+uint32_t blockSizeCode(uint32_t blockSize)
+{
+    for (uint32_t code = 8; code <= 15; ++code)
+    {   // 256 * 2^(n-8)
+        if (blockSize == (256u << (code - 8)))
+        {
+            return code;
+        }
+    }
+    return 0x7;                // 16 bit (blocksize - 1) follows
+}
+
+} // namespace
+
+void AudioRecFlac::encodeFrame(const int32_t *left, const int32_t *right, uint32_t blockSize, uint32_t frameNumber,
+                               uint32_t sampleRate, std::vector<uint8_t> &out)
+{
+    // stereo decorrelation: mid = (L+R) >> 1, side = L - R
+    std::vector<int32_t> mid(blockSize);
+    std::vector<int32_t> side(blockSize);
+    for (uint32_t i = 0; i < blockSize; ++i)
+    {
+        mid[i] = (left[i] + right[i]) >> 1;
+        side[i] = left[i] - right[i];
+    }
+    uint64_t bitsL = estimateBits(left, blockSize);
+    uint64_t bitsR = estimateBits(right, blockSize);
+    uint64_t bitsM = estimateBits(mid.data(), blockSize);
+    uint64_t bitsS = estimateBits(side.data(), blockSize);
+
+    enum { LeftRight = 0x1, LeftSide = 0x8, SideRight = 0x9, MidSide = 0xA };
+    uint32_t assignment = LeftRight;
+    uint64_t best = bitsL + bitsR;
+    if (bitsL + bitsS < best) { best = bitsL + bitsS; assignment = LeftSide; }
+    if (bitsS + bitsR < best) { best = bitsS + bitsR; assignment = SideRight; }
+    if (bitsM + bitsS < best) { best = bitsM + bitsS; assignment = MidSide; }
+
+    size_t frameStart = out.size();
+    BitWriter bw(out);
+
+    // frame header
+    uint32_t bsCode = blockSizeCode(blockSize);
+    uint32_t srCode = sampleRateCode(sampleRate);
+    bw.put(0x3FFE, 14);                // sync code
+    bw.put(0, 1);                      // reserved
+    bw.put(0, 1);                      // fixed block size
+    bw.put(bsCode, 4);
+    bw.put(srCode, 4);
+    bw.put(assignment, 4);
+    bw.put(0x4, 3);                    // 16 bits per sample
+    bw.put(0, 1);                      // reserved
+    bw.putUtf8(frameNumber);
+    if (0x7 == bsCode)
+    {
+        bw.put(blockSize - 1, 16);
+    }
+    bw.put(crc8(out.data() + frameStart, out.size() - frameStart), 8);
+
+    // subframes, side channel has one bit more
+    std::vector<int32_t> residual;
+    std::vector<uint32_t> u;
+    switch (assignment)
+    {
+    case LeftSide:
+        encodeSubframe(bw, left, blockSize, 16, residual, u);
+        encodeSubframe(bw, side.data(), blockSize, 17, residual, u);
+        break;
+    case SideRight:
+        encodeSubframe(bw, side.data(), blockSize, 17, residual, u);
+        encodeSubframe(bw, right, blockSize, 16, residual, u);
+        break;
+    case MidSide:
+        encodeSubframe(bw, mid.data(), blockSize, 16, residual, u);
+        encodeSubframe(bw, side.data(), blockSize, 17, residual, u);
+        break;
+    default:
+        encodeSubframe(bw, left, blockSize, 16, residual, u);
+        encodeSubframe(bw, right, blockSize, 16, residual, u);
+        break;
+    }
+
+    // frame footer
+    bw.alignToByte();
+    uint16_t crc = crc16(out.data() + frameStart, out.size() - frameStart);
+    bw.put(crc, 16);
+}
+
+std::vector<uint8_t> AudioRecFlac::streamHeader(uint32_t sampleRate, uint64_t totalSamples, uint32_t minFrameSize, uint32_t maxFrameSize)
+{
+    std::vector<uint8_t> header;
+    header.reserve(AUDIORECFLAC_HEADER_SIZE);
+    BitWriter bw(header);
+    bw.put(0x664C6143, 32);            // "fLaC"
+
+    // metadata block header: last block, type 0 (STREAMINFO), 34 bytes
+    bw.put(1, 1);
+    bw.put(0, 7);
+    bw.put(34, 24);
+
+    // STREAMINFO
+    bw.put(AUDIORECFLAC_BLOCK_SIZE, 16);    // min block size (last frame is not included)
+    bw.put(AUDIORECFLAC_BLOCK_SIZE, 16);    // max block size
+    bw.put(minFrameSize, 24);
+    bw.put(maxFrameSize, 24);
+    bw.put(sampleRate, 20);
+    bw.put(2 - 1, 3);                       // channels
+    bw.put(16 - 1, 5);                      // bits per sample
+    bw.put(uint32_t(totalSamples >> 32) & 0xF, 4);
+    bw.put(uint32_t(totalSamples), 32);
+    for (int n = 0; n < 4; ++n)
+    {   // MD5 not computed
+        bw.put(0, 32);
+    }
+
+    return header;
+}
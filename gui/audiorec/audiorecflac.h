@@ -0,0 +1,55 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIORECFLAC_H
+#define AUDIORECFLAC_H
+
+#include <cstdint>
+#include <vector>
+
+#define AUDIORECFLAC_BLOCK_SIZE        (4096)   // samples per channel in FLAC frame (fixed block size stream)
+#define AUDIORECFLAC_MAX_FIXED_ORDER   (4)      // fixed predictor orders 0..4
+#define AUDIORECFLAC_MAX_PARTITION     (8)      // maximal Rice partition order
+#define AUDIORECFLAC_MAX_RICE_PARAM    (14)     // 4 bit parameter, 15 is escape code
+#define AUDIORECFLAC_HEADER_SIZE       (42)     // "fLaC" marker + STREAMINFO metadata block
+
+// minimal FLAC encoder of 16 bit stereo audio
+// frames use fixed predictors with Rice coded residual (as libFLAC compression levels 0-2)
+// and the best of left/right, left/side, side/right and mid/side channel decorrelation
+// frames are independent, so that they can be encoded in parallel
+class AudioRecFlac
+{
+public:
+    // encodes one frame of deinterleaved 16 bit samples and appends it to out
+    // blockSize can be smaller than AUDIORECFLAC_BLOCK_SIZE only for the last frame of the stream
+    static void encodeFrame(const int32_t * left, const int32_t * right, uint32_t blockSize, uint32_t frameNumber,
+                            uint32_t sampleRate, std::vector<uint8_t> & out);
+
+    // "fLaC" + STREAMINFO, it is rewritten when stream is complete (frame sizes of 0 mean unknown)
+    static std::vector<uint8_t> streamHeader(uint32_t sampleRate, uint64_t totalSamples, uint32_t minFrameSize, uint32_t maxFrameSize);
+};
+
+#endif // AUDIORECFLAC_H
@@ -26,6 +26,8 @@
 
 #include <QLoggingCategory>
 #include "audiorecmanager.h"
+#include "coarseclock.h"
+#include "ensemblelistitem.h"
 
 Q_LOGGING_CATEGORY(audioRecMgr, "AudioRecSchedule", QtInfoMsg)
 
@@ -35,6 +37,8 @@ AudioRecManager::AudioRecManager(AudioRecScheduleModel *model, SLModel *slModel,
     m_isAudioRecordingActive = false;
     m_haveTimeConnection = false;
     m_haveAudio = false;
+    m_isRecorderArmed = false;
+    m_selectionFrequency = 0;
     m_scheduleTimeSecSinceEpoch = 0;
     m_scheduledRecordingState = ScheduledRecordingState::StateIdle;
 
@@ -42,6 +46,7 @@ AudioRecManager::AudioRecManager(AudioRecScheduleModel *model, SLModel *slModel,
     m_model->setSlModel(m_slModel);
 
     connect(this, &AudioRecManager::startRecording, m_recorder, &AudioRecorder::start, Qt::QueuedConnection);
+    connect(this, &AudioRecManager::startRecordingAt, m_recorder, &AudioRecorder::startAt, Qt::QueuedConnection);
     connect(this, &AudioRecManager::stopRecording, m_recorder, &AudioRecorder::stop, Qt::QueuedConnection);
     connect(m_recorder, &AudioRecorder::recordingStarted, this, &AudioRecManager::onAudioRecordingStarted, Qt::QueuedConnection);
     connect(m_recorder, &AudioRecorder::recordingStopped, this, &AudioRecManager::onAudioRecordingStopped, Qt::QueuedConnection);
@@ -49,23 +54,30 @@ AudioRecManager::AudioRecManager(AudioRecScheduleModel *model, SLModel *slModel,
 
     connect(m_model, &QAbstractItemModel::modelReset, this,  &AudioRecManager::onModelReset);
     connect(m_model, &QAbstractItemModel::rowsRemoved, this,  &AudioRecManager::onModelRowsRemoved);           
+    connect(m_model, &QAbstractItemModel::rowsInserted, this,  &AudioRecManager::onModelRowsInserted);
+    connect(m_model, &QAbstractItemModel::dataChanged, this,  &AudioRecManager::onModelDataChanged);
 }
 
-void AudioRecManager::timerEvent(QTimerEvent *event)
+void AudioRecManager::onClockTick()
 {
-    Q_UNUSED(event);
     //qDebug() << EPGTime::getInstance()->currentTime() << QDateTime::currentDateTime();
     if (m_scheduleTimeSecSinceEpoch != 0)
     {        
         switch (m_scheduledRecordingState) {
         case StateIdle:
         {
+            if (m_scheduleTimeSecSinceEpoch - QDateTime::currentDateTime().toSecsSinceEpoch() > COUNTDOWN_SEC)
+            {   // timer is limited to one day, schedule is still too far
+                armTimer(m_scheduleTimeSecSinceEpoch - COUNTDOWN_SEC);
+                break;
+            }
+
             // check that service is available
             const ServiceList * slPtr = m_slModel->getServiceList();
             const auto it = slPtr->findService(m_currentItem.serviceId());
             if (it == slPtr->serviceListEnd())
             {   // service not found => cancelling the schedule
-                m_timer.stop();
+                stopClock();
                 m_scheduledRecordingState = ScheduledRecordingState::StateIdle;
                 m_scheduleTimeSecSinceEpoch = 0;
                 if (!m_model->isEmpty())
@@ -75,11 +87,11 @@ void AudioRecManager::timerEvent(QTimerEvent *event)
             }
             else
             {
-                m_timer.start(1000, Qt::PreciseTimer, this);
+                startClock(1000, true);
 
                 int numSec = m_scheduleTimeSecSinceEpoch - QDateTime::currentDateTime().toSecsSinceEpoch();
                 qCInfo(audioRecMgr) << "Recording countdown" <<  numSec << "sec:" << m_currentItem.name();
-                emit audioRecordingCountdown(numSec-SERVICESELECTION_SEC);
+                emit audioRecordingCountdown(numSec - selectionAdvanceSec(serviceFrequency(m_currentItem.serviceId())));
                 m_scheduledRecordingState = ScheduledRecordingState::StateCountdown;
             }
             break;
@@ -87,8 +99,8 @@ void AudioRecManager::timerEvent(QTimerEvent *event)
         case StateCountdown:
         {
             int numSec = m_scheduleTimeSecSinceEpoch - QDateTime::currentDateTime().toSecsSinceEpoch();
-            if (numSec <= SERVICESELECTION_SEC)
-            {
+            if (numSec <= selectionAdvanceSec(serviceFrequency(m_currentItem.serviceId())))
+            {   // tuning, sync and decoder start are done before start time
                 emit stopRecording();
                 m_scheduledRecordingState = ScheduledRecordingState::StateServiceSelection;
             }
@@ -101,7 +113,7 @@ void AudioRecManager::timerEvent(QTimerEvent *event)
             const auto it = slPtr->findService(m_currentItem.serviceId());
             if (it == slPtr->serviceListEnd())
             {   // service not found => cancelling the schedule
-                m_timer.stop();
+                stopClock();
                 m_scheduledRecordingState = ScheduledRecordingState::StateIdle;
                 m_scheduleTimeSecSinceEpoch = 0;
                 if (!m_model->isEmpty())
@@ -111,6 +123,9 @@ void AudioRecManager::timerEvent(QTimerEvent *event)
             }
             else
             {
+                m_selectionFrequency = serviceFrequency(m_currentItem.serviceId());
+                m_selectionTimer.start();
+                m_isRecorderArmed = false;
                 emit requestServiceSelection(m_currentItem.serviceId());
                 m_scheduledRecordingState = ScheduledRecordingState::StateReady;
                 emit audioRecordingProgress(0, -1);
@@ -120,18 +135,27 @@ void AudioRecManager::timerEvent(QTimerEvent *event)
         case StateReady:
         {
             int numSec = m_scheduleTimeSecSinceEpoch - QDateTime::currentDateTime().toSecsSinceEpoch();
-            if ((numSec <= STARTADVANCE_SEC) && (m_serviceId == m_currentItem.serviceId()) && m_haveAudio)
+            if (!m_isRecorderArmed && (m_serviceId == m_currentItem.serviceId()) && m_haveAudio)
+            {   // audio is decoded, recorder starts file exactly at start time
+                qCInfo(audioRecMgr) << "Recording armed:" << m_currentItem.name();
+                emit startRecordingAt((m_scheduleTimeSecSinceEpoch - STARTADVANCE_SEC) * 1000);
+                m_isRecorderArmed = true;
+            }
+            if ((numSec <= STARTADVANCE_SEC) && m_isRecorderArmed)
             {
                 qCInfo(audioRecMgr) << "Recording started:" << m_currentItem.name();
-                emit startRecording();
+                m_isRecorderArmed = false;
                 m_model->setData(m_model->index(0,0), true, Qt::EditRole);
                 m_scheduleTimeSecSinceEpoch = m_currentItem.endTime().toSecsSinceEpoch();
                 m_scheduledRecordingState = ScheduledRecordingState::StateRecording;
+
+                // no polling during recording, timer expires at the end
+                armTimer(m_scheduleTimeSecSinceEpoch, true);
             }
             else if (QDateTime::currentDateTime().toSecsSinceEpoch() >= m_currentItem.endTime().toSecsSinceEpoch())
             {   // stop
                 emit audioRecordingStopped();
-                m_timer.stop();
+                stopClock();
                 m_scheduledRecordingState = ScheduledRecordingState::StateIdle;
                 m_scheduleTimeSecSinceEpoch = 0;
                 if (!m_model->isEmpty())
@@ -147,7 +171,7 @@ void AudioRecManager::timerEvent(QTimerEvent *event)
             if (numSec <= 0) {
                 qCInfo(audioRecMgr) << "Recording finished:" << m_currentItem.name();
                 emit stopRecording();
-                m_timer.stop();
+                stopClock();
                 m_scheduledRecordingState = ScheduledRecordingState::StateIdle;
                 m_scheduleTimeSecSinceEpoch = 0;
                 if (!m_model->isEmpty())
@@ -155,14 +179,17 @@ void AudioRecManager::timerEvent(QTimerEvent *event)
                     m_model->removeRows(0,1);
                 }
             }
-
+            else
+            {   // end time was updated
+                armTimer(m_scheduleTimeSecSinceEpoch, true);
+            }
         }
         break;
         }
     }
     else
     {
-        m_timer.stop();
+        stopClock();
     }
 }
 
@@ -170,15 +197,46 @@ void AudioRecManager::onAudioServiceSelection(const RadioControlServiceComponent
 {
     m_serviceId = ServiceListId(s);
     m_haveAudio = false;
+
+    // recorder is disarmed by service change, it is armed again when audio of scheduled service is available
+    if (m_isRecorderArmed && (ScheduledRecordingState::StateReady == m_scheduledRecordingState))
+    {
+        emit stopRecording();
+    }
+    m_isRecorderArmed = false;
+}
+
+int AudioRecManager::selectionAdvanceSec(uint32_t frequency) const
+{
+    const auto it = m_timeToAudioMs.constFind(frequency);
+    if (it == m_timeToAudioMs.cend())
+    {   // not measured yet
+        return SERVICESELECTION_SEC;
+    }
+    int advanceSec = int((*it + 999) / 1000) + AUDIORECMANAGER_WARMUP_MARGIN_SEC;
+    return qBound(int(SERVICESELECTION_SEC), advanceSec, AUDIORECMANAGER_WARMUP_MAX_SEC);
+}
+
+uint32_t AudioRecManager::serviceFrequency(const ServiceListId &id) const
+{
+    const ServiceList * slPtr = m_slModel->getServiceList();
+    const auto it = slPtr->findService(id);
+    if (it == slPtr->serviceListEnd())
+    {
+        return 0;
+    }
+    const EnsembleListItem * ens = (*it)->getEnsemble();
+    return (nullptr != ens) ? ens->frequency() : 0;
 }
 
 void AudioRecManager::stopCurrentSchedule()
 {
-    m_timer.stop();
-    if (m_scheduledRecordingState == ScheduledRecordingState::StateRecording)
+    stopClock();
+    if ((m_scheduledRecordingState == ScheduledRecordingState::StateRecording) || m_isRecorderArmed)
     {
         emit stopRecording();
     }
+    m_isRecorderArmed = false;
     m_scheduleTimeSecSinceEpoch = 0;
     m_scheduledRecordingState = ScheduledRecordingState::StateIdle;
 }
@@ -231,6 +289,11 @@ void AudioRecManager::requestCancelSchedule()
     if (m_scheduledRecordingState != ScheduledRecordingState::StateIdle)
     {
         qCInfo(audioRecMgr) << "Recording cancelled:" << m_currentItem.name();
+        if (m_isRecorderArmed && (m_scheduledRecordingState != ScheduledRecordingState::StateRecording))
+        {   // file was not started yet
+            emit stopRecording();
+        }
+        m_isRecorderArmed = false;
         m_scheduledRecordingState = ScheduledRecordingState::StateIdle;
         m_scheduleTimeSecSinceEpoch = 0;
         m_model->removeRows(0,1);
@@ -241,6 +304,21 @@ void AudioRecManager::requestCancelSchedule()
 void AudioRecManager::setHaveAudio(bool newHaveAudio)
 {
     m_haveAudio = newHaveAudio;
+    if (m_haveAudio && m_selectionTimer.isValid() && (m_serviceId == m_currentItem.serviceId()))
+    {   // time to first audio after scheduled service selection, slow decay of worst case
+        qint64 elapsedMs = m_selectionTimer.elapsed();
+        qint64 & timeMs = m_timeToAudioMs[m_selectionFrequency];
+        timeMs = qMax(elapsedMs, timeMs - timeMs / 8);
+        m_selectionTimer.invalidate();
+        qCDebug(audioRecMgr) << "Time to audio" << elapsedMs << "ms, frequency" << m_selectionFrequency << "kHz";
+    }
+    else { /* not scheduled service selection */ }
+}
+
+void AudioRecManager::setSegmenting(int segmentMin, int retentionHours, bool preallocate)
+{   // recorder lives in audio decoder thread
+    AudioRecorder * recorder = m_recorder;
+    QMetaObject::invokeMethod(m_recorder, [=]() { recorder->setSegmenting(segmentMin, retentionHours, preallocate); }, Qt::QueuedConnection);
 }
 
 void AudioRecManager::updateScheduledRecording()
@@ -252,29 +330,36 @@ void AudioRecManager::updateScheduledRecording()
     else
     {   // there is something in schedule => get first item
         const AudioRecScheduleItem item = m_model->itemAtIndex(m_model->index(0,0, QModelIndex()));
+        bool isSameItem = (item.serviceId() == m_currentItem.serviceId()) && (item.startTime() == m_currentItem.startTime());
         if (m_scheduledRecordingState == ScheduledRecordingState::StateRecording)
         {
-            if ((item.serviceId() == m_currentItem.serviceId()) && (item.startTime() == m_currentItem.startTime()))
+            if (isSameItem)
             {   // the same item -> update end time
                 qCDebug(audioRecMgr) << "Updating end time";
                 m_currentItem = item;
                 m_scheduleTimeSecSinceEpoch = m_currentItem.endTime().toSecsSinceEpoch();
+                armTimer(m_scheduleTimeSecSinceEpoch, true);
                 return;
             }
         }
+        else if ((0 != m_scheduleTimeSecSinceEpoch) && isSameItem && (item.durationSec() == m_currentItem.durationSec()))
+        {   // change of other items, next event is still the same
+            return;
+        }
+        else { /* new first item */ }
 
         stopCurrentSchedule();
         m_currentItem = item;
         m_scheduleTimeSecSinceEpoch = m_currentItem.startTime().toSecsSinceEpoch();
         qint64 now = QDateTime::currentDateTime().toSecsSinceEpoch();
         qint64 secToSchedule = m_scheduleTimeSecSinceEpoch - now - COUNTDOWN_SEC;
-        if ((secToSchedule > 0) && (secToSchedule < 24*60*60))  // less than 1 day
-        {   // run timer
-            m_timer.start(secToSchedule*1000, Qt::VeryCoarseTimer, this);
+        if (secToSchedule > 0)
+        {   // single timer for the next event
+            armTimer(m_scheduleTimeSecSinceEpoch - COUNTDOWN_SEC);
         }
-        else if (secToSchedule <= 0)
+        else
         {   // run callback immediately
-            timerEvent(nullptr);
+            onClockTick();
         }
     }
 }
@@ -286,6 +371,54 @@ void AudioRecManager::onModelReset()
 
 void AudioRecManager::onModelRowsRemoved(const QModelIndex &, int first, int last)
 {
-    updateScheduledRecording();
+    Q_UNUSED(last);
+    if (0 == first)
+    {   // first item was removed
+        updateScheduledRecording();
+    }
+    else { /* next event is not affected */ }
+}
+
+void AudioRecManager::onModelRowsInserted(const QModelIndex &, int first, int last)
+{
+    Q_UNUSED(last);
+    if (0 == first)
+    {   // new first item
+        updateScheduledRecording();
+    }
+    else { /* next event is not affected */ }
+}
+
+void AudioRecManager::onModelDataChanged(const QModelIndex &topLeft, const QModelIndex &, const QList<int> &roles)
+{
+    if ((0 == topLeft.row()) && !roles.contains(Qt::DecorationRole))
+    {   // first item was edited
+        updateScheduledRecording();
+    }
+    else { /* next event is not affected */ }
+}
+
+void AudioRecManager::armTimer(qint64 secSinceEpoch, bool precise)
+{
+    qint64 secToEvent = secSinceEpoch - QDateTime::currentDateTime().toSecsSinceEpoch();
+    if (secToEvent < 0)
+    {
+        secToEvent = 0;
+    }
+    else if (secToEvent > AUDIORECMANAGER_TIMER_MAX_SEC)
+    {   // timer is checked again when it expires
+        secToEvent = AUDIORECMANAGER_TIMER_MAX_SEC;
+    }
+    startClock(secToEvent*1000, precise);
+}
+
+void AudioRecManager::startClock(int intervalMs, bool precise)
+{   // far events share wakeups with other subscribers of the clock
+    CoarseClock::getInstance()->start(this, intervalMs, [this]() { onClockTick(); }, precise ? 0 : COARSECLOCK_SLACK_MS);
+}
+
+void AudioRecManager::stopClock()
+{
+    CoarseClock::getInstance()->stop(this);
 }
 
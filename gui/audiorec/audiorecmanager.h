@@ -28,9 +28,18 @@
 #define AUDIORECMANAGER_H
 
 #include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
 #include "audiorecschedulemodel.h"
 #include "audiorecorder.h"
 
+#define AUDIORECMANAGER_TIMER_MAX_SEC  (24*60*60)   // longer time to next event is split
+
+// service is selected ahead of scheduled start by measured time to first audio of the frequency + margin
+// recorder is armed with start time when audio is decoded, file starts with first AU after start time
+#define AUDIORECMANAGER_WARMUP_MARGIN_SEC  (5)
+#define AUDIORECMANAGER_WARMUP_MAX_SEC     (25)     // shorter than countdown
+
 class AudioRecManager : public QObject
 {
     Q_OBJECT
@@ -47,6 +56,7 @@ public:
     void requestCancelSchedule();
 
     void setHaveAudio(bool newHaveAudio);
+    void setSegmenting(int segmentMin, int retentionHours, bool preallocate);
 
 signals:
     void audioRecordingCountdown(int numSec);
@@ -57,19 +67,15 @@ signals:
 
     // used to communicate with worker
     void startRecording();
+    void startRecordingAt(qint64 msecsSinceEpoch);
     void stopRecording();
 
-protected:
-    void timerEvent(QTimerEvent *);
-
 private:
     enum { COUNTDOWN_SEC = 30,
            SERVICESELECTION_SEC = 10,
            STARTADVANCE_SEC = 0};
     enum ScheduledRecordingState {StateIdle, StateCountdown, StateServiceSelection, StateReady, StateRecording} m_scheduledRecordingState;
 
-    QBasicTimer m_timer;
-
     SLModel * m_slModel;
     AudioRecScheduleModel * m_model;    
     AudioRecorder * m_recorder;
@@ -83,10 +89,25 @@ private:
     // this information is required to start scheduled recoding
     ServiceListId m_serviceId;
     bool m_haveAudio;
+    bool m_isRecorderArmed;
+
+    // time from service selection to first audio per frequency [ms]
+    QHash<uint32_t, qint64> m_timeToAudioMs;
+    QElapsedTimer m_selectionTimer;
+    uint32_t m_selectionFrequency;
+
+    int selectionAdvanceSec(uint32_t frequency) const;
+    uint32_t serviceFrequency(const ServiceListId & id) const;
 
     void updateScheduledRecording();
     void onModelReset();
     void onModelRowsRemoved(const QModelIndex &, int first, int last);
+    void onModelRowsInserted(const QModelIndex &, int first, int last);
+    void onModelDataChanged(const QModelIndex & topLeft, const QModelIndex &, const QList<int> & roles);
+    void onClockTick();
+    void startClock(int intervalMs, bool precise = false);
+    void stopClock();
+    void armTimer(qint64 secSinceEpoch, bool precise = false);
     void onAudioRecordingStarted(const QString &filename);
     void onAudioRecordingStopped();
     void stopCurrentSchedule();
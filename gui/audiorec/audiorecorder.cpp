@@ -28,21 +28,40 @@
 #include <QDebug>
 #include <QLoggingCategory>
 #include <QRegularExpression>
+#include <QDataStream>
 #include "audiorecorder.h"
+#include "audiorecflac.h"
 
 Q_LOGGING_CATEGORY(audioRecorder, "AudioRecorder", QtInfoMsg)
 
+std::atomic<AudioRecorder::OutputFormat> AudioRecorder::m_outputFormat(AudioRecorder::OutputFormat::Wav);
+
 AudioRecorder::AudioRecorder(QObject *parent) : QObject{parent},
     m_sid(0),
+    m_recordingState(RecordingState::Stopped),
     m_doOutputRecording(false),
-    m_file(nullptr)
+    m_bitRateKbps(0),
+    m_segmentMin(0),
+    m_retentionHours(0),
+    m_preallocate(false),
+    m_segmentEndMs(0),
+    m_startAtMs(0)
 {    
+    // file is written in writer thread, decoder thread only copies data to its buffers
+    m_writer = new AudioRecWriter(this);
+    connect(m_writer, &AudioRecWriter::writeError, this, &AudioRecorder::stop, Qt::QueuedConnection);
+
+    // FLAC is encoded on worker pool
+    m_encoder = new AudioRecEncoder();
+
     m_recordingPath = QStandardPaths::writableLocation(QStandardPaths::MusicLocation);
 }
 
 AudioRecorder::~AudioRecorder()
 {
     stop();
+    delete m_writer;    // waits until all data is written
+    delete m_encoder;
 }
 
 QString AudioRecorder::recordingPath() const
@@ -63,9 +82,17 @@ void AudioRecorder::setAudioService(const RadioControlServiceComponent &s)
         stop();
         m_sid = s.SId;
         m_serviceName = s.label;
+        m_bitRateKbps = s.streamAudioData.bitRate;
     }
 }
 
+void AudioRecorder::setSegmenting(int segmentMin, int retentionHours, bool preallocate)
+{
+    m_segmentMin = qMax(0, segmentMin);
+    m_retentionHours = qMax(0, retentionHours);
+    m_preallocate = preallocate;
+}
+
 void AudioRecorder::setDataFormat(int sampleRateKHz, bool isAAC)
 {
     if (RecordingState::Stopped != m_recordingState)
@@ -77,59 +104,78 @@ void AudioRecorder::setDataFormat(int sampleRateKHz, bool isAAC)
     m_isAAC = isAAC;
 }
 
-void AudioRecorder::writeWavHeader()
+QByteArray AudioRecorder::wavHeader() const
 {
-    QDataStream out(m_file);
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
     out.setByteOrder(QDataStream::LittleEndian);
 
     // RIFF chunk
     out.writeRawData("RIFF", 4);
-    out << quint32(0);                // Placeholder for the RIFF chunk size (filled by close())
+    out << quint32(m_bytesWritten - 8);   // RIFF chunk size
     out.writeRawData("WAVE", 4);
 
     // Format description chunk
     out.writeRawData("fmt ", 4);
     out << quint32(16);               // "fmt " chunk size (always 16 for PCM)
+#if HAVE_AUDIO_FLOAT32
+    out << quint16(3);                // data format (3 => IEEE float)
+#else
     out << quint16(1);                // data format (1 => PCM)
+#endif
     out << quint16(2);                // num channels
     out << quint32(m_sampleRateKHz * 1000);
-    out << quint32(m_sampleRateKHz * 1000 * 2 * sizeof(int16_t));   // bytes per second
-    out << quint16(2 * sizeof(int16_t));                                       // Block align
-    out << quint16(sizeof(int16_t) * 8);                                       // Significant Bits Per Sample
+    out << quint32(m_sampleRateKHz * 1000 * 2 * sizeof(audioSample_t));   // bytes per second
+    out << quint16(2 * sizeof(audioSample_t));                                       // Block align
+    out << quint16(sizeof(audioSample_t) * 8);                                       // Significant Bits Per Sample
 
     // Data chunk
     out.writeRawData("data", 4);
-    out << quint32(0);                                     // Placeholder for the data chunk size (filled by close())
+    out << quint32(m_bytesWritten - 44);                   // data chunk size
 
-    Q_ASSERT(m_file->pos() == 44);                         // Must be 44 for WAV PCM
+    Q_ASSERT(header.size() == 44);                         // Must be 44 for WAV PCM
+
+    return header;
 }
 
-void AudioRecorder::writeWav(const int16_t *data, size_t numSamples)
+void AudioRecorder::writeWav(const audioSample_t *data, size_t numSamples)
 {
-    qint64 bytesWritten = m_file->write(reinterpret_cast<const char *>(data), sizeof(int16_t) * numSamples);
-    if (bytesWritten != sizeof(uint16_t) * numSamples)
-    {
-        qCWarning(audioRecorder) << "Error while recoding WAV data";
-        stop();
-        return;
-    }
+    qint64 bytesWritten = sizeof(audioSample_t) * numSamples;
+    m_writer->write(data, bytesWritten);
     m_bytesWritten += bytesWritten;
-    m_timeWrittenMs += bytesWritten / (2 * sizeof(int16_t) * m_sampleRateKHz);
+    m_timeWrittenMs += bytesWritten / (2 * sizeof(audioSample_t) * m_sampleRateKHz);
     if (m_timeWrittenMs >= (m_timeSec + 1) * 1000) {
         m_timeSec += 1;
         emit recordingProgress(m_bytesWritten, m_timeSec);
     }
 }
 
-void AudioRecorder::writeMP2(const std::vector<uint8_t> &data)
+void AudioRecorder::writeFlac(const audioSample_t *data, size_t numSamples)
 {
-    qint64 bytesWritten = m_file->write(reinterpret_cast<const char *>(data.data()), sizeof(uint8_t) * data.size());
-    if (bytesWritten != sizeof(uint8_t) * data.size())
+    m_encoder->write(data, numSamples);
+    writeEncoded();
+
+    m_timeWrittenMs += numSamples / (2 * m_sampleRateKHz);
+    if (m_timeWrittenMs >= (m_timeSec + 1) * 1000) {
+        m_timeSec += 1;
+        emit recordingProgress(m_bytesWritten, m_timeSec);
+    }
+}
+
+void AudioRecorder::writeEncoded()
+{   // chunks encoded so far are passed to writer in stream order
+    std::vector<uint8_t> encoded;
+    while (m_encoder->takeEncoded(encoded))
     {
-        qCWarning(audioRecorder) << "Error while recoding MP2 data";
-        stop();
-        return;
+        m_writer->write(encoded.data(), encoded.size());
+        m_bytesWritten += encoded.size();
     }
+}
+
+void AudioRecorder::writeMP2(const std::vector<uint8_t> &data)
+{
+    qint64 bytesWritten = sizeof(uint8_t) * data.size();
+    m_writer->write(data.data(), bytesWritten);
     m_bytesWritten += bytesWritten;
     m_timeWrittenMs += (m_sampleRateKHz == 24 ? 48 : 24);
 
@@ -140,6 +186,22 @@ void AudioRecorder::writeMP2(const std::vector<uint8_t> &data)
 }
 
 void AudioRecorder::writeAAC(const std::vector<uint8_t> &data, const dabsdrAudioFrameHeader_t &aacHeader)
+{
+    std::vector<uint8_t> frame;
+    int timeMs = frameAAC(data, aacHeader, frame);
+
+    m_writer->write(frame.data(), frame.size());
+    m_bytesWritten += frame.size();
+
+    m_timeWrittenMs += timeMs;
+
+    if (m_timeWrittenMs >= (m_timeSec + 1) * 1000) {
+        m_timeSec += 1;
+        emit recordingProgress(m_bytesWritten, m_timeSec);
+    }
+}
+
+int AudioRecorder::frameAAC(const std::vector<uint8_t> &data, const dabsdrAudioFrameHeader_t &aacHeader, std::vector<uint8_t> &frame)
 {
     uint8_t adts_sfreqidx;
     uint8_t audioFs;
@@ -254,87 +316,45 @@ void AudioRecorder::writeAAC(const std::vector<uint8_t> &data, const dabsdrAudio
     aac_header[1] |= (len >> 8) & 0x1F;
     aac_header[2] = len & 0xFF;
 
-    qint64 bytesWritten = m_file->write(reinterpret_cast<const char *>(aac_header), sizeof(uint8_t) * (9 + aacHeader.bits.sbr_flag + au_size_255));
+    // whole LATM frame is assembled in memory and passed to writer at once
+    int headerSize = 9 + aacHeader.bits.sbr_flag + au_size_255;
+    qint64 bytesWritten = headerSize + au_size + 1;
+    frame.resize(bytesWritten);
+    memcpy(frame.data(), aac_header, headerSize);
 
     uint8_t byte = *aac_header_ptr;
     const uint8_t * auPtr = &data[0]; //&buffer[mscDataPtr->au_start[r]];
+    uint8_t * framePtr = &frame[headerSize];
 
     for (int i = 0; i < au_size; ++i)
     {
         byte |= (*auPtr) >> (5 + sbr_flag);
-        bytesWritten += m_file->write(reinterpret_cast<const char *>(&byte), sizeof(uint8_t));
+        *framePtr++ = byte;
         byte = (uint8_t)*auPtr++ << (3 - sbr_flag);
     }
-    bytesWritten += m_file->write(reinterpret_cast<const char *>(&byte), sizeof(uint8_t));
-
-    if (bytesWritten != sizeof(uint8_t) * (9 + aacHeader.bits.sbr_flag + au_size_255 + au_size + 1))
-    {
-        qCWarning(audioRecorder) << "Error while recoding AAC data";
-        stop();
-        return;
-    }
-    m_bytesWritten += bytesWritten;
-
-    m_timeWrittenMs += timeMs;
+    *framePtr = byte;
 
-    if (m_timeWrittenMs >= (m_timeSec + 1) * 1000) {
-        m_timeSec += 1;
-        emit recordingProgress(m_bytesWritten, m_timeSec);
-    }
+    return timeMs;
 }
 
 void AudioRecorder::start()
 {
-    static const QRegularExpression regexp( "[" + QRegularExpression::escape("/:*?\"<>|") + "]");
-    if (nullptr == m_file)
+    m_startAtMs = 0;
+    if (!m_writer->isOpen())
     {
-        QString servicename = m_serviceName;
-        servicename.replace(regexp, "_");
-        QString fileName // = m_recordingPath + "/" + QDateTime::currentDateTime().toString("yyyy-MM-dd-hhmmss");
-                    = m_recordingPath + QString("/%1_%2_%3")
-                                                             .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd-hhmmss"),
-                                                                  QString("%1").arg(m_sid.value(), 6, 16, QChar('0')).toUpper(),
-                                                                  servicename);
         if (m_doOutputRecording)
         {
-            fileName += ".wav";
-            m_recordingState = RecordingState::RecordingWav;
+            m_recordingState = (OutputFormat::Flac == m_outputFormat) ? RecordingState::RecordingFlac : RecordingState::RecordingWav;
         }
         else
         {
-            if (m_isAAC)
-            {
-                fileName += ".aac";
-                m_recordingState = RecordingState::RecordingAAC;
-            }
-            else
-            {
-                fileName += ".mp2";
-                m_recordingState = RecordingState::RecordingMP2;
-            }
+            m_recordingState = m_isAAC ? RecordingState::RecordingAAC : RecordingState::RecordingMP2;
         }
 
-        qCInfo(audioRecorder) << "Recording file:" << fileName;
-
-        m_file = new QFile(fileName);
-        if (m_file->open(QIODevice::WriteOnly))
-        {
-            m_bytesWritten = 0;
-            m_timeWrittenMs = 0;
-            m_timeSec = 0;
-            if (m_doOutputRecording)
-            {   // reserving WAV header space
-                m_file->write(QByteArray(44, '\x55'));
-                m_bytesWritten = 44;
-            }
-            emit recordingStarted(fileName);
-        }
-        else
+        if (!openFile())
         {
-            qCCritical(audioRecorder) << "Unable to open file:" << fileName;
-            delete m_file;
-            m_file = nullptr;
             m_recordingState = RecordingState::Stopped;
+            m_segmentEndMs = 0;
             emit recordingStopped();
         }
     }
@@ -342,20 +362,25 @@ void AudioRecorder::start()
     { /* file is already opened */ }
 }
 
+void AudioRecorder::startAt(qint64 msecsSinceEpoch)
+{
+    if (!m_writer->isOpen())
+    {   // decoding is running, file is started in recordData()
+        m_startAtMs = msecsSinceEpoch;
+        qCInfo(audioRecorder) << "Audio recording armed:" << QDateTime::fromMSecsSinceEpoch(msecsSinceEpoch).toString(Qt::ISODateWithMs);
+    }
+    else
+    { /* file is already opened */ }
+}
+
 void AudioRecorder::stop()
 {
-    if (nullptr != m_file)
+    m_startAtMs = 0;
+    if (m_writer->isOpen())
     {
-        if (m_doOutputRecording)
-        {
-            m_file->seek(0);
-            writeWavHeader();
-        }
-        m_file->flush();
-        m_file->close();
-        delete m_file;
-        m_file = nullptr;
+        closeFile();
         m_recordingState = RecordingState::Stopped;
+        m_segmentEndMs = 0;
         emit recordingStopped();
 
         qCInfo(audioRecorder) << "Audio recording stopped";
@@ -364,13 +389,155 @@ void AudioRecorder::stop()
     { /* file is not opened */ }
 }
 
-void AudioRecorder::recordData(const RadioControlAudioData *inData, const int16_t * outputData, size_t numOutputSamples)
+bool AudioRecorder::openFile()
 {
+    static const QRegularExpression regexp( "[" + QRegularExpression::escape("/:*?\"<>|") + "]");
+
+    QDateTime currentTime = QDateTime::currentDateTime();
+    QString servicename = m_serviceName;
+    servicename.replace(regexp, "_");
+    QString fileName // = m_recordingPath + "/" + QDateTime::currentDateTime().toString("yyyy-MM-dd-hhmmss");
+                = m_recordingPath + QString("/%1_%2_%3")
+                                                         .arg(currentTime.toString("yyyy-MM-dd-hhmmss"),
+                                                              QString("%1").arg(m_sid.value(), 6, 16, QChar('0')).toUpper(),
+                                                              servicename);
+    switch (m_recordingState)
+    {
+    case RecordingState::RecordingWav:
+        fileName += ".wav";
+        break;
+    case RecordingState::RecordingFlac:
+        fileName += ".flac";
+        break;
+    case RecordingState::RecordingAAC:
+        fileName += ".aac";
+        break;
+    default:
+        fileName += ".mp2";
+        break;
+    }
+
+    qCInfo(audioRecorder) << "Recording file:" << fileName;
+
+    if (m_segmentMin > 0)
+    {   // segment end is aligned to local time, i.e. hourly segments start at full hour
+        qint64 segmentMs = m_segmentMin * 60 * 1000LL;
+        qint64 localMs = currentTime.toMSecsSinceEpoch() + currentTime.offsetFromUtc() * 1000LL;
+        m_segmentEndMs = currentTime.toMSecsSinceEpoch() + segmentMs - (localMs % segmentMs);
+    }
+    else
+    {
+        m_segmentEndMs = 0;
+    }
+
+    if (!m_writer->open(fileName, (m_preallocate && (m_segmentEndMs > 0)) ? fileSizeEstimate() : 0))
+    {
+        qCCritical(audioRecorder) << "Unable to open file:" << fileName;
+        return false;
+    }
+
+    m_bytesWritten = 0;
+    m_timeWrittenMs = 0;
+    m_timeSec = 0;
+    if (RecordingState::RecordingWav == m_recordingState)
+    {   // reserving WAV header space, header is written when recording stops
+        m_writer->write(QByteArray(44, '\x55').constData(), 44);
+        m_bytesWritten = 44;
+    }
+    else if (RecordingState::RecordingFlac == m_recordingState)
+    {   // the same for FLAC STREAMINFO (number of samples)
+        m_encoder->start(m_sampleRateKHz * 1000);
+        m_writer->write(m_encoder->streamHeader().constData(), AUDIORECFLAC_HEADER_SIZE);
+        m_bytesWritten = AUDIORECFLAC_HEADER_SIZE;
+    }
+    else { /* compressed audio without header */ }
+
+    if (m_retentionHours > 0)
+    {   // rotation of files of this service
+        QString nameFilter = QString("*_%1_*").arg(m_sid.value(), 6, 16, QChar('0')).toUpper();
+        m_writer->removeExpired(m_recordingPath, nameFilter, currentTime.addSecs(-3600LL * m_retentionHours));
+    }
+
+    emit recordingStarted(fileName);
+    return true;
+}
+
+void AudioRecorder::closeFile()
+{   // file is closed in writer thread when all pending data is written
+    switch (m_recordingState)
+    {
+    case RecordingState::RecordingWav:
+        m_writer->close(wavHeader());
+        break;
+    case RecordingState::RecordingFlac:
+        // waits for encoding of last chunks
+        m_encoder->finish();
+        writeEncoded();
+        if (m_encoder->droppedSamples() > 0)
+        {
+            qCWarning(audioRecorder) << m_encoder->droppedSamples() << "samples of recording were dropped by encoder";
+        }
+        m_writer->close(m_encoder->streamHeader());
+        break;
+    default:
+        m_writer->close();
+        break;
+    }
+}
+
+void AudioRecorder::nextSegment()
+{
+    closeFile();
+    if (!openFile())
+    {
+        m_recordingState = RecordingState::Stopped;
+        m_segmentEndMs = 0;
+        emit recordingStopped();
+    }
+}
+
+qint64 AudioRecorder::fileSizeEstimate() const
+{
+    qint64 durationSec = m_segmentMin * 60LL;
+    if (m_segmentEndMs > 0)
+    {   // first segment is shorter
+        durationSec = qMin(durationSec, (m_segmentEndMs - QDateTime::currentMSecsSinceEpoch()) / 1000 + 1);
+    }
+    if (m_doOutputRecording)
+    {   // upper bound for FLAC, unused space is truncated
+        return 44 + durationSec * m_sampleRateKHz * 1000 * 2 * sizeof(audioSample_t);
+    }
+
+    // LATM overhead is few bytes per AU
+    return durationSec * m_bitRateKbps * 1000 / 8 * 102 / 100;
+}
+
+void AudioRecorder::recordData(const RadioControlAudioData *inData, const audioSample_t * outputData, size_t numOutputSamples)
+{
+    if (m_startAtMs > 0)
+    {   // armed recorder, file starts on AU boundary
+        if (QDateTime::currentMSecsSinceEpoch() < m_startAtMs)
+        {
+            return;
+        }
+        start();
+    }
+    else { /* not armed */ }
+
     if (RecordingState::Stopped == m_recordingState)
     {
         return;
     }
 
+    if ((m_segmentEndMs > 0) && (QDateTime::currentMSecsSinceEpoch() >= m_segmentEndMs))
+    {   // continuous recording, segment is split on frame boundary
+        nextSegment();
+        if (RecordingState::Stopped == m_recordingState)
+        {
+            return;
+        }
+    }
+
     switch (m_recordingState) {
     case RecordingState::RecordingAAC:
         writeAAC(inData->data, inData->header);
@@ -381,6 +548,9 @@ void AudioRecorder::recordData(const RadioControlAudioData *inData, const int16_
     case RecordingState::RecordingWav:
         writeWav(outputData, numOutputSamples);
         break;
+    case RecordingState::RecordingFlac:
+        writeFlac(outputData, numOutputSamples);
+        break;
     default:
         // do nothing
         break;
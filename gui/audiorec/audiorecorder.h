@@ -28,10 +28,13 @@
 #define AUDIORECORDER_H
 
 #include <QObject>
-#include <QFile>
+#include <atomic>
 
 #include "radiocontrol.h"
+#include "audiofifo.h"
 #include "dabsdr.h"
+#include "audiorecwriter.h"
+#include "audiorecencoder.h"
 
 class AudioRecorder : public QObject
 {
@@ -42,18 +45,40 @@ public:
         Stopped = 0,
         RecordingMP2,
         RecordingAAC,
-        RecordingWav
+        RecordingWav,
+        RecordingFlac
+    };
+
+    // format of decoded audio recording
+    enum class OutputFormat
+    {
+        Wav = 0,
+        Flac
     };
 
     explicit AudioRecorder(QObject *parent = nullptr);
     ~AudioRecorder();
     QString recordingPath() const;
     void setup(const QString &recordingPath, bool doOutputRecording = false);
+
+    // common for all recorders, used when next file is opened
+    static void setOutputFormat(OutputFormat format) { m_outputFormat = format; }
+    static OutputFormat outputFormat() { return m_outputFormat; }
+
+    // continuous recording: new file is started every segmentMin minutes (aligned to local time),
+    // files of the service older than retentionHours are deleted (0 = disabled)
+    void setSegmenting(int segmentMin, int retentionHours = 0, bool preallocate = false);
     void setAudioService(const RadioControlServiceComponent & s);
     void setDataFormat(int sampleRateKHz, bool isAAC);
     void start();
     void stop();
-    void recordData(const RadioControlAudioData *inData, const int16_t *outputData, size_t numOutputSamples);
+
+    // file is opened with first AU decoded at or after msecsSinceEpoch (scheduled recording)
+    void startAt(qint64 msecsSinceEpoch);
+    void recordData(const RadioControlAudioData *inData, const audioSample_t *outputData, size_t numOutputSamples);
+
+    // AU is framed to LOAS/LATM (AudioSyncStream) with in-band StreamMuxConfig, returns AU duration in ms
+    static int frameAAC(const std::vector<uint8_t> &data, const dabsdrAudioFrameHeader_t &aacHeader, std::vector<uint8_t> &frame);
 
 signals:
     void recordingStarted(const QString & filename);
@@ -62,7 +87,9 @@ signals:
 
 private:
     QString m_recordingPath;
-    QFile * m_file;
+    AudioRecWriter * m_writer;
+    AudioRecEncoder * m_encoder;
+    static std::atomic<OutputFormat> m_outputFormat;
     DabSId m_sid;
     QString m_serviceName;
     RecordingState m_recordingState;
@@ -72,11 +99,23 @@ private:
     size_t m_timeWrittenMs;
     int m_sampleRateKHz;
     bool m_isAAC;
+    int m_bitRateKbps;
+    int m_segmentMin;
+    int m_retentionHours;
+    bool m_preallocate;
+    qint64 m_segmentEndMs;        // msecs since epoch, 0 when segmenting is disabled
+    qint64 m_startAtMs;           // msecs since epoch, 0 when recorder is not armed
 
     void writeMP2(const std::vector<uint8_t> & data);
     void writeAAC(const std::vector<uint8_t> &data, const dabsdrAudioFrameHeader_t &aacHeader);
-    void writeWav(const int16_t * data, size_t numSamples);
-    void writeWavHeader();
+    void writeWav(const audioSample_t * data, size_t numSamples);
+    void writeFlac(const audioSample_t * data, size_t numSamples);
+    void writeEncoded();
+    QByteArray wavHeader() const;
+    bool openFile();
+    void closeFile();
+    void nextSegment();
+    qint64 fileSizeEstimate() const;
 };
 
 #endif // AUDIORECORDER_H
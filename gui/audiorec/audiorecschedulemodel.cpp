@@ -25,6 +25,7 @@
  */
 
 #include <QTime>
+#include <algorithm>
 #include <QBrush>
 #include <QPixmap>
 #include "audiorecschedulemodel.h"
@@ -140,13 +141,21 @@ Qt::ItemFlags AudioRecScheduleModel::flags(const QModelIndex &index) const
 bool AudioRecScheduleModel::removeRows(int position, int rows, const QModelIndex &index)
 {
     Q_UNUSED(index);
-    beginResetModel();
+    if ((rows <= 0) || (position < 0) || (position + rows > m_modelData.size()))
+    {
+        return false;
+    }
+
+    beginRemoveRows(QModelIndex(), position, position + rows - 1);
     for (int row = 0; row < rows; ++row)
     {
         m_modelData.removeAt(position);
+        m_maxEndSec.removeAt(position);
     }
-    sortFindConflicts();
-    endResetModel();
+    endRemoveRows();
+
+    // items after removed ones are still sorted, only conflicts can change
+    updateConflicts(position);
     return true;
 }
 
@@ -157,18 +166,32 @@ const QList<AudioRecScheduleItem> &AudioRecScheduleModel::getSchedule() const
 
 void AudioRecScheduleModel::insertItem(const AudioRecScheduleItem &item)
 {
-    beginResetModel();
-    m_modelData.append(item);
-    sortFindConflicts();
-    endResetModel();
+    // list is kept sorted => binary search of position
+    int row = std::upper_bound(m_modelData.cbegin(), m_modelData.cend(), item) - m_modelData.cbegin();
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_modelData.insert(row, item);
+    m_maxEndSec.insert(row, -1);     // not valid yet
+    endInsertRows();
+
+    updateConflicts(row);
 }
 
-void AudioRecScheduleModel::replaceItemAtIndex(const QModelIndex & index, const AudioRecScheduleItem & item)
+void AudioRecScheduleModel::replaceItemAtIndex(const QModelIndex & idx, const AudioRecScheduleItem & item)
 {
-    beginResetModel();
-    m_modelData[index.row()] = item;
-    sortFindConflicts();
-    endResetModel();
+    int row = idx.row();
+    if (((0 == row) || !(item < m_modelData.at(row-1)))
+        && ((m_modelData.size()-1 == row) || !(m_modelData.at(row+1) < item)))
+    {   // order is not changed
+        m_modelData[row] = item;
+        emit dataChanged(index(row, 0), index(row, NumColumns-1), {Qt::DisplayRole, Qt::EditRole});
+        updateConflicts(row);
+    }
+    else
+    {   // start time was changed => item is moved to new position
+        removeRows(row, 1);
+        insertItem(item);
+    }
 }
 
 const AudioRecScheduleItem &AudioRecScheduleModel::itemAtIndex(const QModelIndex &index) const
@@ -197,8 +220,7 @@ void AudioRecScheduleModel::load(QSettings &settings)
         m_modelData.append(item);
     }
     settings.endArray();
-    cleanup(QDateTime::currentDateTime());
-    sortFindConflicts();
+    cleanup(QDateTime::currentDateTime());   // this sorts items and finds conflicts
     endResetModel();
 }
 
@@ -232,6 +254,7 @@ void AudioRecScheduleModel::cleanup(const QDateTime &currentTime)
             ++it;
         }
     }
+    sortFindConflicts();
     endResetModel();
 }
 
@@ -239,28 +262,66 @@ void AudioRecScheduleModel::clear()
 {
     beginResetModel();
     m_modelData.clear();
+    m_maxEndSec.clear();
     endResetModel();
 }
 
 void AudioRecScheduleModel::sortFindConflicts()
-{
+{   // full update, used for bulk changes only
     std::sort(m_modelData.begin(), m_modelData.end());
-    QDateTime endTime;
-    endTime.setSecsSinceEpoch(0);
-    for (auto & item : m_modelData) {
-        if (item.startTime() >= endTime)
-        {
-            item.setHasConflict(false);
-            endTime = item.endTime();
-        }
-        else
+    m_maxEndSec.fill(-1, m_modelData.size());
+    for (int row = 0; row < m_modelData.size(); ++row)
+    {
+        m_modelData[row].setHasConflict(isConflict(row));
+        m_maxEndSec[row] = maxEnd(row);
+    }
+}
+
+void AudioRecScheduleModel::updateConflicts(int row)
+{
+    // item conflicts when it starts before the end of any previous item
+    // propagation stops when maximal end time up to the item does not change
+    int firstChanged = -1;
+    int lastChanged = -1;
+    for ( ; row < m_modelData.size(); ++row)
+    {
+        bool conflict = isConflict(row);
+        if (conflict != m_modelData.at(row).hasConflict())
         {
-            item.setHasConflict(true);
-            if (item.endTime() > endTime) {
-                endTime = item.endTime();
+            m_modelData[row].setHasConflict(conflict);
+            if (firstChanged < 0)
+            {
+                firstChanged = row;
             }
+            lastChanged = row;
         }
+        qint64 end = maxEnd(row);
+        if (end == m_maxEndSec.at(row))
+        {   // following items are not affected
+            break;
+        }
+        m_maxEndSec[row] = end;
+    }
+
+    if (firstChanged >= 0)
+    {
+        emit dataChanged(index(firstChanged, ColState), index(lastChanged, ColState), {Qt::DecorationRole});
+    }
+}
+
+bool AudioRecScheduleModel::isConflict(int row) const
+{
+    return (row > 0) && (m_modelData.at(row).startTime().toSecsSinceEpoch() < m_maxEndSec.at(row-1));
+}
+
+qint64 AudioRecScheduleModel::maxEnd(int row) const
+{
+    qint64 end = m_modelData.at(row).endTime().toSecsSinceEpoch();
+    if ((row > 0) && (m_maxEndSec.at(row-1) > end))
+    {
+        end = m_maxEndSec.at(row-1);
     }
+    return end;
 }
 
 bool AudioRecScheduleModel::setData(const QModelIndex &index, const QVariant &value, int role)
@@ -49,7 +49,7 @@ public:
     bool setData(const QModelIndex &index, const QVariant &value, int role) override;
 
     void insertItem(const AudioRecScheduleItem & item);
-    void replaceItemAtIndex(const QModelIndex & index, const AudioRecScheduleItem & item);
+    void replaceItemAtIndex(const QModelIndex & idx, const AudioRecScheduleItem & item);
     const AudioRecScheduleItem & itemAtIndex(const QModelIndex & index) const;
     void setSlModel(SLModel *newSlModel);
     void load(QSettings & settings);
@@ -62,10 +62,14 @@ private:
     enum { NumColumns = 6 };
     enum { ColState, ColLabel, ColStartTime, ColEndTime, ColDuration, ColService };
 
-    QList<AudioRecScheduleItem> m_modelData;
+    QList<AudioRecScheduleItem> m_modelData;   // sorted by start time (recorded item first)
+    QList<qint64> m_maxEndSec;                 // maximal end time of items up to the row (secs since epoch)
     SLModel * m_slModel;
 
     void sortFindConflicts();
+    void updateConflicts(int row);
+    bool isConflict(int row) const;
+    qint64 maxEnd(int row) const;
 };
 
 #endif // AUDIORECSCHEDULEMODEL_H
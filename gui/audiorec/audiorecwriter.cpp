@@ -0,0 +1,290 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include <QDir>
+#include "audiorecwriter.h"
+
+Q_LOGGING_CATEGORY(audioRecWriter, "AudioRecWriter", QtInfoMsg)
+
+AudioRecWriter::AudioRecWriter(QObject *parent) : QThread(parent)
+{
+    for (int n = 0; n < AUDIORECWRITER_NUM_BUFFERS; ++n)
+    {
+        m_freeBuffers.append(&m_bufferPool[n]);
+    }
+}
+
+AudioRecWriter::~AudioRecWriter()
+{
+    if (isOpen())
+    {
+        close();
+    }
+
+    m_mutex.lock();
+    m_exitRequest = true;
+    m_jobCondition.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+}
+
+bool AudioRecWriter::open(const QString &fileName, qint64 preallocateBytes)
+{
+    if (isOpen())
+    {
+        close();
+    }
+
+    m_file = new QFile(fileName);
+    if (!m_file->open(QIODevice::WriteOnly))
+    {
+        delete m_file;
+        m_file = nullptr;
+        return false;
+    }
+
+    m_droppedBytes = 0;
+    m_isDropping = false;
+    m_flushTimer.start();
+
+    if (!isRunning())
+    {
+        start(QThread::LowPriority);
+    }
+
+    if (preallocateBytes > 0)
+    {   // continuous recording, long files are less fragmented
+        Job job;
+        job.type = JobType::Preallocate;
+        job.file = m_file;
+        job.size = preallocateBytes;
+        enqueue(job);
+    }
+    return true;
+}
+
+void AudioRecWriter::write(const void *data, qint64 len)
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    const char * dataPtr = static_cast<const char *>(data);
+    while (len > 0)
+    {
+        if ((nullptr == m_currentBuffer) && !takeFreeBuffer())
+        {   // storage is too slow, decoding has priority
+            m_droppedBytes += len;
+            if (!m_isDropping)
+            {
+                qCWarning(audioRecWriter) << "All buffers are waiting for storage, dropping recorded data";
+                m_isDropping = true;
+            }
+            return;
+        }
+
+        qint64 space = AUDIORECWRITER_BUFFER_SIZE - m_currentBuffer->size();
+        qint64 chunk = qMin(space, len);
+        m_currentBuffer->insert(m_currentBuffer->end(), dataPtr, dataPtr + chunk);
+        dataPtr += chunk;
+        len -= chunk;
+
+        if (m_currentBuffer->size() >= AUDIORECWRITER_BUFFER_SIZE)
+        {
+            submitCurrentBuffer();
+        }
+    }
+
+    if ((nullptr != m_currentBuffer) && (m_flushTimer.elapsed() >= AUDIORECWRITER_FLUSH_MS))
+    {   // limit amount of data that is lost when application crashes
+        submitCurrentBuffer();
+    }
+}
+
+void AudioRecWriter::close(const QByteArray &header)
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    submitCurrentBuffer();
+
+    Job job;
+    job.type = JobType::Close;
+    job.file = m_file;
+    job.header = header;
+    enqueue(job);
+    m_file = nullptr;
+
+    if (m_droppedBytes > 0)
+    {
+        qCWarning(audioRecWriter) << m_droppedBytes << "bytes of recording were dropped";
+    }
+}
+
+void AudioRecWriter::submitCurrentBuffer()
+{
+    if ((nullptr == m_currentBuffer) || m_currentBuffer->empty())
+    {   // nothing to write
+        return;
+    }
+
+    Job job;
+    job.type = JobType::Write;
+    job.file = m_file;
+    job.buffer = m_currentBuffer;
+    enqueue(job);
+    m_currentBuffer = nullptr;
+    m_flushTimer.start();
+}
+
+void AudioRecWriter::removeExpired(const QString &dirPath, const QString &nameFilter, const QDateTime &expiration)
+{
+    if (!isRunning())
+    {
+        start(QThread::LowPriority);
+    }
+
+    Job job;
+    job.type = JobType::RemoveExpired;
+    job.dirPath = dirPath;
+    job.nameFilter = nameFilter;
+    job.expiration = expiration;
+    enqueue(job);
+}
+
+void AudioRecWriter::enqueue(const Job &job)
+{
+    QMutexLocker locker(&m_mutex);
+    m_jobs.enqueue(job);
+    m_jobCondition.wakeOne();
+}
+
+bool AudioRecWriter::takeFreeBuffer()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_freeBuffers.isEmpty())
+    {
+        return false;
+    }
+
+    m_currentBuffer = m_freeBuffers.takeLast();
+    m_currentBuffer->clear();
+    m_currentBuffer->reserve(AUDIORECWRITER_BUFFER_SIZE);
+    if (m_isDropping)
+    {
+        qCInfo(audioRecWriter) << "Storage caught up," << m_droppedBytes << "bytes dropped so far";
+        m_isDropping = false;
+    }
+    return true;
+}
+
+void AudioRecWriter::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (true)
+    {
+        if (m_jobs.isEmpty())
+        {
+            if (m_exitRequest)
+            {
+                break;
+            }
+            m_jobCondition.wait(&m_mutex);
+            continue;
+        }
+
+        Job job = m_jobs.dequeue();
+
+        // file is written without lock, caller can fill other buffers meanwhile
+        locker.unlock();
+        bool isError = false;
+        switch (job.type)
+        {
+        case JobType::Write:
+        {
+            qint64 bytes = job.buffer->size();
+            isError = (job.file->write(job.buffer->data(), bytes) != bytes);
+        }
+            break;
+        case JobType::Preallocate:
+            if (!job.file->resize(job.size))
+            {
+                qCWarning(audioRecWriter) << "Unable to preallocate" << job.size << "bytes for" << job.file->fileName();
+            }
+            break;
+        case JobType::Close:
+        {   // file position is at the end of written data
+            job.file->flush();
+            qint64 size = job.file->pos();
+            if (job.file->size() > size)
+            {   // preallocated space was not used
+                job.file->resize(size);
+            }
+            if (!job.header.isEmpty())
+            {
+                job.file->seek(0);
+                isError = (job.file->write(job.header) != job.header.size());
+            }
+            job.file->flush();
+            job.file->close();
+            delete job.file;
+        }
+            break;
+        case JobType::RemoveExpired:
+        {
+            QDir dir(job.dirPath);
+            const QFileInfoList files = dir.entryInfoList(QStringList() << job.nameFilter, QDir::Files, QDir::Time | QDir::Reversed);
+            for (const auto & fileInfo : files)
+            {
+                if (fileInfo.lastModified() >= job.expiration)
+                {   // sorted from oldest
+                    break;
+                }
+                qCInfo(audioRecWriter) << "Removing expired recording:" << fileInfo.fileName();
+                QFile::remove(fileInfo.absoluteFilePath());
+            }
+        }
+            break;
+        }
+        locker.relock();
+
+        if (JobType::Write == job.type)
+        {
+            m_freeBuffers.append(job.buffer);
+        }
+
+        if (isError)
+        {
+            qCWarning(audioRecWriter) << "Error while writing recording";
+            emit writeError();
+        }
+    }
+}
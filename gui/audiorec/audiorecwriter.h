@@ -0,0 +1,116 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIORECWRITER_H
+#define AUDIORECWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QQueue>
+#include <QDateTime>
+#include <vector>
+
+#define AUDIORECWRITER_BUFFER_SIZE    (256*1024)   // bytes in one buffer
+#define AUDIORECWRITER_NUM_BUFFERS    (32)         // 8 MB of data can wait for storage (~40 s of 48 kHz WAV)
+#define AUDIORECWRITER_FLUSH_MS       (2000)       // partially filled buffer is passed to writer after this time
+
+// Buffered file writer used by audio recorder
+// data are collected in large buffers by caller (audio decoder thread) and written to file in writer thread,
+// slow storage never blocks the caller, data are dropped when all buffers are waiting for write
+class AudioRecWriter : public QThread
+{
+    Q_OBJECT
+public:
+    explicit AudioRecWriter(QObject *parent = nullptr);
+    ~AudioRecWriter();      // waits for pending data
+
+    // preallocateBytes reserves file size in advance, file is truncated to written size when closed
+    bool open(const QString & fileName, qint64 preallocateBytes = 0);
+    bool isOpen() const { return nullptr != m_file; }
+
+    // copies data to current buffer, never blocks
+    void write(const void * data, qint64 len);
+
+    // pending data are written and file is closed in writer thread
+    // header is written to the beginning of file before closing (if not empty)
+    void close(const QByteArray & header = QByteArray());
+
+    // files in dirPath matching nameFilter and modified before expiration are deleted in writer thread
+    void removeExpired(const QString & dirPath, const QString & nameFilter, const QDateTime & expiration);
+
+    qint64 droppedBytes() const { return m_droppedBytes; }
+
+signals:
+    void writeError();
+
+protected:
+    void run() override;
+
+private:
+    enum class JobType
+    {
+        Write,
+        Preallocate,
+        Close,
+        RemoveExpired
+    };
+
+    struct Job
+    {
+        JobType type;
+        QFile * file = nullptr;
+        std::vector<char> * buffer = nullptr;     // Write
+        qint64 size = 0;                          // Preallocate
+        QByteArray header;                        // Close
+        QString dirPath;                          // RemoveExpired
+        QString nameFilter;
+        QDateTime expiration;
+    };
+
+    // caller side
+    QFile * m_file = nullptr;
+    std::vector<char> * m_currentBuffer = nullptr;
+    QElapsedTimer m_flushTimer;
+    qint64 m_droppedBytes = 0;
+    bool m_isDropping = false;
+
+    // shared
+    QMutex m_mutex;
+    QWaitCondition m_jobCondition;
+    QQueue<Job> m_jobs;
+    QList<std::vector<char> *> m_freeBuffers;
+    std::vector<char> m_bufferPool[AUDIORECWRITER_NUM_BUFFERS];
+    bool m_exitRequest = false;
+
+    void submitCurrentBuffer();
+    void enqueue(const Job & job);
+    bool takeFreeBuffer();
+};
+
+#endif // AUDIORECWRITER_H
@@ -0,0 +1,161 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AUDIORESAMPLER_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define AUDIORESAMPLER_NEON 1
+#endif
+
+#include "audioresampler.h"
+
+AudioResampler::AudioResampler()
+{
+    // Kaiser windowed sinc, output for fractional position f between x[TAPS/2 - 1] and x[TAPS/2]
+    auto besselI0 = [](float x) {
+        float sum = 1.0f;
+        float term = 1.0f;
+        for (int k = 1; k < 20; ++k)
+        {
+            term *= (x / (2.0f * k)) * (x / (2.0f * k));
+            sum += term;
+        }
+        return sum;
+    };
+    const float i0Beta = besselI0(AUDIO_RESAMPLER_KAISER_BETA);
+    const float halfLen = AUDIO_RESAMPLER_TAPS / 2.0f;
+
+    for (int p = 0; p <= AUDIO_RESAMPLER_PHASES; ++p)
+    {
+        float f = float(p) / AUDIO_RESAMPLER_PHASES;
+        float sum = 0.0f;
+        for (int k = 0; k < AUDIO_RESAMPLER_TAPS; ++k)
+        {
+            float t = k - (AUDIO_RESAMPLER_TAPS / 2 - 1) - f;    // distance from interpolated position
+            float x = float(M_PI) * AUDIO_RESAMPLER_CUTOFF * t;
+            float sinc = (std::fabs(x) < 1e-6f) ? 1.0f : std::sin(x) / x;
+            float r = t / halfLen;
+            float w = (std::fabs(r) < 1.0f) ? besselI0(AUDIO_RESAMPLER_KAISER_BETA * std::sqrt(1.0f - r * r)) / i0Beta : 0.0f;
+            m_coef[p][k] = sinc * w;
+            sum += m_coef[p][k];
+        }
+        for (int k = 0; k < AUDIO_RESAMPLER_TAPS; ++k)
+        {   // unity DC gain
+            m_coef[p][k] /= sum;
+        }
+    }
+}
+
+void AudioResampler::reset(uint8_t numChannels, uint32_t maxInputFrames)
+{
+    m_numChannels = std::min(numChannels, uint8_t(AUDIO_RESAMPLER_MAX_CHANNELS));
+    for (int c = 0; c < AUDIO_RESAMPLER_MAX_CHANNELS; ++c)
+    {
+        m_buffer[c].assign(AUDIO_RESAMPLER_TAPS + maxInputFrames, 0.0f);
+    }
+}
+
+float AudioResampler::dot(const float *x, const float *c0, const float *c1, float a) const
+{
+#if AUDIORESAMPLER_SSE2
+    __m128 va = _mm_set1_ps(a);
+    __m128 acc = _mm_setzero_ps();
+    for (int k = 0; k < AUDIO_RESAMPLER_TAPS; k += 4)
+    {
+        __m128 h0 = _mm_load_ps(c0 + k);
+        __m128 h = _mm_add_ps(h0, _mm_mul_ps(va, _mm_sub_ps(_mm_load_ps(c1 + k), h0)));
+        acc = _mm_add_ps(acc, _mm_mul_ps(h, _mm_loadu_ps(x + k)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return _mm_cvtss_f32(acc);
+#elif AUDIORESAMPLER_NEON
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (int k = 0; k < AUDIO_RESAMPLER_TAPS; k += 4)
+    {
+        float32x4_t h0 = vld1q_f32(c0 + k);
+        float32x4_t h = vmlaq_n_f32(h0, vsubq_f32(vld1q_f32(c1 + k), h0), a);
+        acc = vmlaq_f32(acc, h, vld1q_f32(x + k));
+    }
+    return vaddvq_f32(acc);
+#else
+    float acc = 0.0f;
+    for (int k = 0; k < AUDIO_RESAMPLER_TAPS; ++k)
+    {
+        acc += (c0[k] + a * (c1[k] - c0[k])) * x[k];
+    }
+    return acc;
+#endif
+}
+
+void AudioResampler::process(const audioSample_t *in, uint32_t numInFrames, audioSample_t *out, uint32_t numOutFrames, float volume)
+{
+    const float scale = volume;
+    for (uint_fast8_t c = 0; c < m_numChannels; ++c)
+    {   // deinterleave after history
+        float * buf = m_buffer[c].data() + AUDIO_RESAMPLER_TAPS;
+        const audioSample_t * inPtr = in + c;
+        for (uint32_t n = 0; n < numInFrames; ++n)
+        {
+            buf[n] = *inPtr;
+            inPtr += m_numChannels;
+        }
+    }
+
+    // output frame n is at position (n + 1) * step => last input frame is always reached
+    double step = double(numInFrames) / numOutFrames;
+    for (uint32_t n = 0; n < numOutFrames; ++n)
+    {
+        double pos = (n + 1) * step;
+        uint32_t idx = uint32_t(pos);
+        double fracPhase = (pos - idx) * AUDIO_RESAMPLER_PHASES;
+        uint32_t phase = uint32_t(fracPhase);
+        float a = float(fracPhase - phase);
+        if (idx >= numInFrames)
+        {   // last output frame
+            idx = numInFrames;
+            phase = 0;
+            a = 0.0f;
+        }
+        const float * c0 = m_coef[phase];
+        const float * c1 = m_coef[phase + 1];
+        for (uint_fast8_t c = 0; c < m_numChannels; ++c)
+        {
+            float y = scale * dot(m_buffer[c].data() + idx, c0, c1, a);
+            *out++ = audioSampleRound(y);
+        }
+    }
+
+    for (uint_fast8_t c = 0; c < m_numChannels; ++c)
+    {   // keep history for next call
+        memmove(m_buffer[c].data(), m_buffer[c].data() + numInFrames, AUDIO_RESAMPLER_TAPS * sizeof(float));
+    }
+}
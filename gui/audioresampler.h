@@ -0,0 +1,64 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIORESAMPLER_H
+#define AUDIORESAMPLER_H
+
+#include <cstdint>
+#include <vector>
+#include "audiofifo.h"
+
+#define AUDIO_RESAMPLER_TAPS          (16)      // filter length per phase, must be multple of 4
+#define AUDIO_RESAMPLER_PHASES       (128)      // number of polyphase branches
+#define AUDIO_RESAMPLER_CUTOFF      (0.90f)     // cutoff frequency relative to fs/2
+#define AUDIO_RESAMPLER_KAISER_BETA  (7.0f)
+#define AUDIO_RESAMPLER_MAX_CHANNELS   (2)
+
+// fractional polyphase resampler for audio output clock drift compensation
+// ratio is close to 1, coefficients between two phases are linearly interpolated
+class AudioResampler
+{
+public:
+    AudioResampler();
+    void reset(uint8_t numChannels, uint32_t maxInputFrames);
+
+    // numInFrames of interleaved input are converted to numOutFrames of interleaved output, volume is applied
+    // group delay of AUDIO_RESAMPLER_TAPS/2 input frames
+    void process(const audioSample_t * in, uint32_t numInFrames, audioSample_t * out, uint32_t numOutFrames, float volume);
+
+private:
+    uint8_t m_numChannels = 2;
+
+    // phase AUDIO_RESAMPLER_PHASES is the same as phase 0 shifted by one sample
+    alignas(16) float m_coef[AUDIO_RESAMPLER_PHASES + 1][AUDIO_RESAMPLER_TAPS];
+
+    // deinterleaved samples, first AUDIO_RESAMPLER_TAPS samples are history from previous call
+    std::vector<float> m_buffer[AUDIO_RESAMPLER_MAX_CHANNELS];
+
+    float dot(const float * x, const float * c0, const float * c1, float a) const;
+};
+
+#endif // AUDIORESAMPLER_H
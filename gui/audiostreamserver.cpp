@@ -0,0 +1,375 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include "audiostreamserver.h"
+#include "audiorecorder.h"
+
+Q_LOGGING_CATEGORY(audioStreamServer, "AudioStreamServer", QtInfoMsg)
+
+std::atomic<AudioStreamServer *> AudioStreamServer::m_instancePtr { nullptr };
+
+AudioStreamServer::AudioStreamServer(QObject *parent) : QObject(parent)
+{
+    m_rtpSeq = uint16_t(QRandomGenerator::global()->generate());
+    m_rtpTimestamp = QRandomGenerator::global()->generate();
+    m_rtpSsrc = QRandomGenerator::global()->generate();
+
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &AudioStreamServer::onNewConnection);
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setInterval(AUDIOSTREAMSERVER_FLUSH_PERIOD_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &AudioStreamServer::onFlushTimeout);
+}
+
+AudioStreamServer::~AudioStreamServer()
+{
+    stop();
+}
+
+bool AudioStreamServer::start(quint16 port)
+{
+    if (!m_server->listen(QHostAddress::Any, port))
+    {
+        qCWarning(audioStreamServer) << "Unable to listen on port" << port << ":" << m_server->errorString();
+        return false;
+    }
+    qCInfo(audioStreamServer) << "Listening on port" << port;
+
+    m_instancePtr = this;
+    m_flushTimer->start();
+    return true;
+}
+
+void AudioStreamServer::stop()
+{
+    m_instancePtr = nullptr;
+    m_flushTimer->stop();
+
+    auto closeClient = [this](QTcpSocket * client) {
+        client->disconnect(this);
+        client->abort();
+        client->deleteLater();
+    };
+    for (auto client : std::as_const(m_pendingRequests))
+    {
+        closeClient(client);
+    }
+    m_pendingRequests.clear();
+    for (auto & stream : m_streams)
+    {
+        for (auto client : stream.clients)
+        {
+            closeClient(client);
+        }
+    }
+    m_streams.clear();
+    m_server->close();
+
+    QMutexLocker locker(&m_mutex);
+    m_pending.clear();
+}
+
+void AudioStreamServer::setRtpDestination(const QString &destination)
+{
+    int sep = destination.lastIndexOf(':');
+    QHostAddress address(destination.left(sep));
+    int port = destination.mid(sep + 1).toInt();
+    if (destination.isEmpty() || (sep <= 0) || address.isNull() || (port <= 0) || (port > 0xFFFF))
+    {
+        if (!destination.isEmpty())
+        {
+            qCWarning(audioStreamServer) << "Invalid RTP destination" << destination;
+        }
+        delete m_rtpSocket;
+        m_rtpSocket = nullptr;
+        return;
+    }
+
+    m_rtpAddress = address;
+    m_rtpPort = port;
+    if (nullptr == m_rtpSocket)
+    {
+        m_rtpSocket = new QUdpSocket(this);
+    }
+    qCInfo(audioStreamServer) << "RTP stream to" << destination;
+}
+
+void AudioStreamServer::feedService(const RadioControlServiceComponent &s)
+{
+    AudioStreamServer * server = m_instancePtr.load(std::memory_order_acquire);
+    if ((nullptr != server) && s.isAudioService())
+    {
+        QMutexLocker locker(&server->m_mutex);
+        server->m_currentSId = s.SId.value();
+        server->m_currentLabel = s.label;
+        server->m_currentIsAAC = (DabAudioDataSCty::DABPLUS_AUDIO == s.streamAudioData.scType);
+    }
+}
+
+void AudioStreamServer::feedAU(const RadioControlAudioData *inData)
+{
+    AudioStreamServer * server = m_instancePtr.load(std::memory_order_acquire);
+    if (nullptr != server)
+    {
+        server->frameAU(inData);
+    }
+}
+
+void AudioStreamServer::frameAU(const RadioControlAudioData *inData)
+{
+    Frame frame;
+    if (DabAudioDataSCty::DABPLUS_AUDIO == inData->ASCTy)
+    {
+        if (inData->header.bits.conceal)
+        {   // frame is not valid
+            return;
+        }
+        std::vector<uint8_t> loas;
+        frame.durationMs = AudioRecorder::frameAAC(inData->data, inData->header, loas);
+        frame.data = QByteArray(reinterpret_cast<const char *>(loas.data()), loas.size());
+        frame.isAAC = true;
+    }
+    else if ((DabAudioDataSCty::DAB_AUDIO == inData->ASCTy) && (inData->data.size() > 4))
+    {   // MP2 frame is sent as it is, 1152 samples @ 48kHz (MPEG-1) or 24kHz (MPEG-2)
+        frame.durationMs = (inData->data[1] & 0x08) ? 24 : 48;
+        frame.data = QByteArray(reinterpret_cast<const char *>(inData->data.data()), inData->data.size());
+        frame.isAAC = false;
+    }
+    else
+    {   // not audio
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if ((0 == m_currentSId) || (m_pending.size() >= AUDIOSTREAMSERVER_MAX_PENDING))
+    {   // no service or flush timer did not run
+        m_droppedFrames += (0 != m_currentSId);
+        return;
+    }
+    frame.sid = m_currentSId;
+    m_pending.append(frame);
+}
+
+void AudioStreamServer::onNewConnection()
+{
+    while (m_server->hasPendingConnections())
+    {
+        QTcpSocket * client = m_server->nextPendingConnection();
+        int numClients = m_pendingRequests.size();
+        for (const auto & stream : std::as_const(m_streams))
+        {
+            numClients += stream.clients.size();
+        }
+        if (numClients >= AUDIOSTREAMSERVER_MAX_CLIENTS)
+        {
+            qCWarning(audioStreamServer) << "Too many clients, rejecting" << client->peerAddress().toString();
+            client->abort();
+            client->deleteLater();
+            continue;
+        }
+
+        connect(client, &QTcpSocket::readyRead, this, [this, client]() { onClientReadyRead(client); });
+        connect(client, &QTcpSocket::disconnected, this, &AudioStreamServer::onClientDisconnected);
+        m_pendingRequests.insert(client);
+    }
+}
+
+void AudioStreamServer::onClientReadyRead(QTcpSocket *client)
+{
+    if (!m_pendingRequests.contains(client))
+    {   // already streaming, anything from client is ignored
+        client->readAll();
+        return;
+    }
+    if (!client->canReadLine())
+    {   // waiting for request line
+        return;
+    }
+
+    // request line: GET <path> HTTP/1.x, rest of the request is ignored
+    QList<QByteArray> request = client->readLine().trimmed().split(' ');
+    client->readAll();
+    m_pendingRequests.remove(client);
+
+    uint32_t currentSId;
+    QString currentLabel;
+    bool currentIsAAC;
+    {
+        QMutexLocker locker(&m_mutex);
+        currentSId = m_currentSId;
+        currentLabel = m_currentLabel;
+        currentIsAAC = m_currentIsAAC;
+    }
+
+    // "/" is current service, otherwise SId (with or without ECC) in hex
+    QByteArray status = "200 OK";
+    uint32_t sid = 0;
+    if ((request.size() < 2) || (request.at(0) != "GET"))
+    {
+        status = "405 Method Not Allowed";
+    }
+    else
+    {
+        QByteArray path = request.at(1).mid(1);
+        bool isOk = true;
+        uint32_t requested = path.isEmpty() ? currentSId : path.toUInt(&isOk, 16);
+        if (isOk && (0 != requested))
+        {
+            for (auto it = m_streams.cbegin(); it != m_streams.cend(); ++it)
+            {
+                if ((it.key() == requested) || (DabSId(it.key()).progSId() == requested))
+                {
+                    sid = it.key();
+                    break;
+                }
+            }
+            if ((0 == sid) && (0 != currentSId) && ((currentSId == requested) || (DabSId(currentSId).progSId() == requested)))
+            {   // no frame was received yet
+                sid = currentSId;
+            }
+        }
+        if (0 == sid)
+        {
+            status = "404 Not Found";
+        }
+    }
+
+    if (0 == sid)
+    {
+        client->write("HTTP/1.0 " + status + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        client->disconnectFromHost();
+        return;
+    }
+
+    if (!m_streams.contains(sid))
+    {   // no frame was received yet
+        m_streams[sid].label = currentLabel;
+        m_streams[sid].isAAC = currentIsAAC;
+    }
+    Stream & stream = m_streams[sid];
+
+    QByteArray response = "HTTP/1.0 200 OK\r\n"
+                          "Content-Type: " + QByteArray(stream.isAAC ? "audio/aacp" : "audio/mpeg") + "\r\n"
+                          "icy-name: " + stream.label.trimmed().toUtf8() + "\r\n"
+                          "Cache-Control: no-cache\r\n"
+                          "Connection: close\r\n\r\n";
+    client->write(response);
+    stream.clients.append(client);
+
+    qCInfo(audioStreamServer) << "Client" << client->peerAddress().toString() << "listens to" << QString("%1").arg(sid, 4, 16, QChar('0')).toUpper()
+                              << stream.label;
+}
+
+void AudioStreamServer::onClientDisconnected()
+{
+    QTcpSocket * client = qobject_cast<QTcpSocket *>(sender());
+    if (nullptr == client)
+    {
+        return;
+    }
+    m_pendingRequests.remove(client);
+    for (auto & stream : m_streams)
+    {
+        stream.clients.removeAll(client);
+    }
+    client->deleteLater();
+}
+
+void AudioStreamServer::onFlushTimeout()
+{
+    QList<Frame> frames;
+    uint32_t currentSId;
+    QString currentLabel;
+    uint64_t dropped;
+    {
+        QMutexLocker locker(&m_mutex);
+        frames.swap(m_pending);
+        currentSId = m_currentSId;
+        currentLabel = m_currentLabel;
+        dropped = m_droppedFrames;
+        m_droppedFrames = 0;
+    }
+    if (dropped > 0)
+    {
+        qCWarning(audioStreamServer) << "Dropped" << dropped << "frames";
+    }
+
+    // frames for all listeners of the service are assembled once
+    // frames can belong to previous service when service was changed since last flush
+    QHash<uint32_t, QByteArray> chunks;
+    for (const auto & frame : std::as_const(frames))
+    {
+        chunks[frame.sid].append(frame.data);
+        Stream & stream = m_streams[frame.sid];
+        stream.isAAC = frame.isAAC;
+        if (frame.sid == currentSId)
+        {
+            stream.label = currentLabel;
+        }
+        if (nullptr != m_rtpSocket)
+        {
+            sendRtp(frame);
+        }
+    }
+
+    for (auto it = chunks.cbegin(); it != chunks.cend(); ++it)
+    {
+        for (auto client : std::as_const(m_streams[it.key()].clients))
+        {
+            if (client->bytesToWrite() > AUDIOSTREAMSERVER_CLIENT_MAX_QUEUE)
+            {   // slow client, whole frames are dropped so that stream stays decodable
+                continue;
+            }
+            client->write(it.value());   // data are implicitly shared
+        }
+    }
+}
+
+void AudioStreamServer::sendRtp(const Frame &frame)
+{
+    // RTP header: V=2, marker is set for every packet (complete frame)
+    QByteArray packet(12, 0);
+    packet[0] = char(0x80);
+    packet[1] = char(0x80 | (frame.isAAC ? AUDIOSTREAMSERVER_RTP_PT_LATM : AUDIOSTREAMSERVER_RTP_PT_MPA));
+    qToBigEndian<quint16>(m_rtpSeq++, packet.data() + 2);
+    qToBigEndian<quint32>(m_rtpTimestamp, packet.data() + 4);
+    qToBigEndian<quint32>(m_rtpSsrc, packet.data() + 8);
+    if (frame.isAAC)
+    {   // AudioMuxElement with in-band configuration (cpresent=1) => LOAS sync and length are removed
+        packet.append(frame.data.constData() + 3, frame.data.size() - 3);
+    }
+    else
+    {   // RFC 2250: MBZ and fragment offset, frame is never fragmented
+        packet.append(4, 0);
+        packet.append(frame.data);
+    }
+    m_rtpSocket->writeDatagram(packet, m_rtpAddress, m_rtpPort);
+    m_rtpTimestamp += frame.durationMs * (AUDIOSTREAMSERVER_RTP_CLOCK / 1000);
+}
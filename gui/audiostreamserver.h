@@ -0,0 +1,121 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIOSTREAMSERVER_H
+#define AUDIOSTREAMSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QMutex>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <atomic>
+
+#include "radiocontrol.h"
+
+// original AUs of decoded service are forwarded without decoding or transcoding
+//   HTTP (Icecast style): GET / or GET /<SId> (hex), MP2 as audio/mpeg, HE-AAC as LOAS/LATM (audio/aacp)
+//   RTP: current service is sent to configured destination, MP2 as RFC 2250 (PT 14), AAC as MP4A-LATM RFC 3016 (PT 96)
+// every AU is framed once and the same send buffer is shared by all listeners of the service
+#define AUDIOSTREAMSERVER_PORT_DEFAULT      (8000)
+#define AUDIOSTREAMSERVER_FLUSH_PERIOD_MS   (20)
+#define AUDIOSTREAMSERVER_MAX_CLIENTS       (64)
+#define AUDIOSTREAMSERVER_CLIENT_MAX_QUEUE  (256*1024)   // ~10 sec at 192kbps, slow client drops frames above this
+#define AUDIOSTREAMSERVER_MAX_PENDING       (512)        // frames pending when flush timer is late
+#define AUDIOSTREAMSERVER_RTP_PT_MPA        (14)
+#define AUDIOSTREAMSERVER_RTP_PT_LATM       (96)
+#define AUDIOSTREAMSERVER_RTP_CLOCK         (90000)
+
+class AudioStreamServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AudioStreamServer(QObject *parent = nullptr);
+    ~AudioStreamServer();
+
+    bool start(quint16 port);
+    void stop();
+
+    // RTP destination "host:port", empty string disables RTP
+    void setRtpDestination(const QString & destination);
+
+    // called from audio decoder thread, return immediately when server is not running
+    static void feedService(const RadioControlServiceComponent & s);
+    static void feedAU(const RadioControlAudioData * inData);
+
+private:
+    static std::atomic<AudioStreamServer *> m_instancePtr;
+
+    struct Frame
+    {
+        QByteArray data;        // MP2 frame or LOAS frame
+        uint32_t sid;
+        bool isAAC;
+        int durationMs;
+    };
+
+    struct Stream
+    {
+        QString label;
+        bool isAAC = false;
+        QList<QTcpSocket *> clients;
+    };
+
+    QTcpServer * m_server;
+    QTimer * m_flushTimer;
+    QHash<uint32_t, Stream> m_streams;              // SId -> stream
+    QSet<QTcpSocket *> m_pendingRequests;           // connected clients waiting for request line
+
+    // RTP
+    QUdpSocket * m_rtpSocket = nullptr;
+    QHostAddress m_rtpAddress;
+    quint16 m_rtpPort = 0;
+    uint16_t m_rtpSeq;
+    uint32_t m_rtpTimestamp;
+    uint32_t m_rtpSsrc;
+
+    // shared with audio decoder thread
+    QMutex m_mutex;
+    uint32_t m_currentSId = 0;
+    QString m_currentLabel;
+    bool m_currentIsAAC = false;
+    QList<Frame> m_pending;
+    uint64_t m_droppedFrames = 0;
+
+    void frameAU(const RadioControlAudioData * inData);
+    void onNewConnection();
+    void onClientReadyRead(QTcpSocket * client);
+    void onClientDisconnected();
+    void onFlushTimeout();
+    void sendRtp(const Frame & frame);
+};
+
+#endif // AUDIOSTREAMSERVER_H
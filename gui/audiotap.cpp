@@ -0,0 +1,106 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstring>
+#include "audiotap.h"
+
+AudioTap::AudioTap()
+{
+    m_buffer.assign(AUDIO_TAP_SIZE, 0);
+}
+
+void AudioTap::setFormat(uint32_t sampleRate, uint8_t numChannels)
+{
+    m_sampleRate.store(sampleRate, std::memory_order_relaxed);
+    m_numChannels.store(numChannels, std::memory_order_relaxed);
+    m_generation.fetch_add(1, std::memory_order_release);
+}
+
+void AudioTap::write(const audioSample_t *data, uint32_t numSamples)
+{
+    uint64_t pos = m_writePos.load(std::memory_order_relaxed);
+    uint32_t idx = pos % AUDIO_TAP_SIZE;
+    uint32_t samplesToEnd = AUDIO_TAP_SIZE - idx;
+    if (samplesToEnd < numSamples)
+    {
+        memcpy(&m_buffer[idx], data, samplesToEnd * sizeof(audioSample_t));
+        memcpy(&m_buffer[0], data + samplesToEnd, (numSamples - samplesToEnd) * sizeof(audioSample_t));
+    }
+    else
+    {
+        memcpy(&m_buffer[idx], data, numSamples * sizeof(audioSample_t));
+    }
+    m_writePos.store(pos + numSamples, std::memory_order_release);
+}
+
+uint32_t AudioTap::read(AudioTapCursor &cursor, audioSample_t *data, uint32_t maxSamples) const
+{
+    uint32_t generation = m_generation.load(std::memory_order_acquire);
+    uint64_t writePos = m_writePos.load(std::memory_order_acquire);
+    if (cursor.generation != generation)
+    {   // new stream -> consumer starts from current position
+        cursor.generation = generation;
+        cursor.pos = writePos;
+        return 0;
+    }
+
+    // oldest samples can be overwritten by producer while consumer copies
+    const uint64_t validSamples = AUDIO_TAP_SIZE - AUDIO_TAP_GUARD;
+    if (writePos - cursor.pos > validSamples)
+    {   // overrun
+        cursor.pos = writePos - validSamples;
+        cursor.overruns += 1;
+    }
+
+    uint32_t channels = std::max(uint8_t(1), numChannels());
+    uint32_t numSamples = std::min(uint64_t(maxSamples), writePos - cursor.pos);
+    numSamples -= numSamples % channels;  // whole frames only
+    if (0 == numSamples)
+    {
+        return 0;
+    }
+
+    uint32_t idx = cursor.pos % AUDIO_TAP_SIZE;
+    uint32_t samplesToEnd = AUDIO_TAP_SIZE - idx;
+    if (samplesToEnd < numSamples)
+    {
+        memcpy(data, &m_buffer[idx], samplesToEnd * sizeof(audioSample_t));
+        memcpy(data + samplesToEnd, &m_buffer[0], (numSamples - samplesToEnd) * sizeof(audioSample_t));
+    }
+    else
+    {
+        memcpy(data, &m_buffer[idx], numSamples * sizeof(audioSample_t));
+    }
+
+    // check that copied samples were not overwritten in the meantime
+    if ((m_writePos.load(std::memory_order_acquire) + AUDIO_TAP_GUARD - cursor.pos > AUDIO_TAP_SIZE) || (m_generation.load(std::memory_order_acquire) != generation))
+    {   // samples are not valid, trying again in next call
+        cursor.overruns += 1;
+        return 0;
+    }
+    cursor.pos += numSamples;
+    return numSamples;
+}
@@ -0,0 +1,73 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIOTAP_H
+#define AUDIOTAP_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "audiofifo.h"
+
+#define AUDIO_TAP_MS        (4000)                  // history available to consumers
+#define AUDIO_TAP_SIZE      (48 * AUDIO_TAP_MS * 2) // samples, 48kHz stereo
+#define AUDIO_TAP_GUARD     (48 * 200 * 2)          // samples that can be overwritten while consumer copies
+
+// position of one consumer in the tap
+struct AudioTapCursor
+{
+    uint64_t pos = 0;
+    uint32_t generation = 0;    // 0 = not synchronized yet
+    uint64_t overruns = 0;      // number of times consumer lost samples
+};
+
+// single producer multi consumer broadcast of decoded PCM (interleaved samples)
+// producer (audio decoder) copies samples once and never waits for consumers
+// every consumer has its own cursor, slow consumer detects overrun and continues from oldest valid samples
+class AudioTap
+{
+public:
+    AudioTap();
+
+    // producer side
+    void setFormat(uint32_t sampleRate, uint8_t numChannels);     // starts new stream
+    void write(const audioSample_t * data, uint32_t numSamples);
+
+    // consumer side, can be called from any thread
+    // returns number of samples copied to data, cursor is moved to the beginning of current stream when format changes
+    uint32_t read(AudioTapCursor & cursor, audioSample_t * data, uint32_t maxSamples) const;
+    uint32_t sampleRate() const { return m_sampleRate.load(std::memory_order_acquire); }
+    uint8_t numChannels() const { return m_numChannels.load(std::memory_order_acquire); }
+
+private:
+    std::vector<audioSample_t> m_buffer;
+    std::atomic<uint64_t> m_writePos { 0 };         // total samples written
+    std::atomic<uint32_t> m_generation { 0 };       // incremented with every format change
+    std::atomic<uint32_t> m_sampleRate { 0 };
+    std::atomic<uint8_t> m_numChannels { 0 };
+};
+
+#endif // AUDIOTAP_H
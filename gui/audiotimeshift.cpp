@@ -0,0 +1,214 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstring>
+#include "audiotimeshift.h"
+
+void AudioTimeshift::setup(int durationSec, int bitRateKbps)
+{
+    if (durationSec <= 0)
+    {   // disabled
+        std::vector<uint8_t>().swap(m_data);
+        std::vector<Entry>().swap(m_entries);
+        reset();
+        return;
+    }
+
+    // buffer is only growing, service switch does not reallocate it
+    size_t dataSize = static_cast<size_t>(durationSec) * bitRateKbps * 1000 / 8 * AUDIO_TIMESHIFT_BITRATE_MARGIN / 100;
+    size_t numEntries = static_cast<size_t>(durationSec) * 1000 / AUDIO_TIMESHIFT_MIN_AU_MS + 1;
+    if (dataSize > m_data.size())
+    {
+        m_data.resize(dataSize);
+    }
+    if (numEntries > m_entries.size())
+    {
+        m_entries.resize(numEntries);
+    }
+    reset();
+}
+
+void AudioTimeshift::reset()
+{
+    m_writeBytes = 0;
+    m_head = 0;
+    m_tail = 0;
+    m_playIdx = 0;
+    m_streamTimeMs = 0;
+    m_isLive = true;
+}
+
+void AudioTimeshift::store(const RadioControlAudioData *inData, int sampleRateKHz)
+{
+    uint32_t len = inData->data.size();
+    if (!isEnabled() || (len > m_data.size()))
+    {
+        return;
+    }
+
+    // remove oldest AUs that would be overwritten
+    while ((m_tail < m_head)
+           && (((m_head - m_tail) >= m_entries.size()) || ((m_writeBytes + len - entry(m_tail).offset) > m_data.size())))
+    {
+        m_tail += 1;
+    }
+    if (m_playIdx < m_tail)
+    {   // paused for too long, play position moves with oldest AU
+        m_playIdx = m_tail;
+    }
+
+    Entry & e = m_entries[m_head % m_entries.size()];
+    e.offset = m_writeBytes;
+    e.timeMs = m_streamTimeMs;
+    e.len = len;
+    e.durationMs = auDurationMs(inData, sampleRateKHz);
+    e.id = inData->id;
+    e.ASCTy = inData->ASCTy;
+    e.header = inData->header;
+
+    // copy to ring, it can wrap
+    size_t pos = m_writeBytes % m_data.size();
+    size_t firstPart = std::min(static_cast<size_t>(len), m_data.size() - pos);
+    memcpy(&m_data[pos], inData->data.data(), firstPart);
+    if (firstPart < len)
+    {
+        memcpy(&m_data[0], inData->data.data() + firstPart, len - firstPart);
+    }
+
+    m_writeBytes += len;
+    m_streamTimeMs += e.durationMs;
+    m_head += 1;
+    if (m_isLive)
+    {
+        m_playIdx = m_head;
+    }
+}
+
+void AudioTimeshift::setShifted()
+{
+    if (isEnabled())
+    {
+        m_isLive = false;
+    }
+}
+
+void AudioTimeshift::goLive()
+{
+    m_isLive = true;
+    m_playIdx = m_head;
+}
+
+bool AudioTimeshift::seek(int offsetMs)
+{
+    if (!isEnabled() || (m_tail == m_head))
+    {   // nothing stored
+        return true;
+    }
+    m_isLive = false;
+
+    uint64_t currentMs = (m_playIdx < m_head) ? entry(m_playIdx).timeMs : m_streamTimeMs;
+    if (offsetMs < 0)
+    {
+        uint64_t targetMs = (currentMs > static_cast<uint64_t>(-offsetMs)) ? (currentMs + offsetMs) : 0;
+        while ((m_playIdx > m_tail) && ((entry(m_playIdx - 1).timeMs + entry(m_playIdx - 1).durationMs) > targetMs))
+        {   // play position moves to AU containing target time
+            m_playIdx -= 1;
+        }
+    }
+    else
+    {
+        uint64_t targetMs = currentMs + offsetMs;
+        while ((m_playIdx < m_head) && (entry(m_playIdx).timeMs < targetMs))
+        {
+            m_playIdx += 1;
+        }
+        if (m_playIdx >= m_head)
+        {   // there is nothing newer than live stream
+            goLive();
+        }
+    }
+    return m_isLive;
+}
+
+bool AudioTimeshift::read(RadioControlAudioData *outData)
+{
+    if (m_isLive || (m_playIdx >= m_head))
+    {
+        goLive();
+        return false;
+    }
+
+    const Entry & e = entry(m_playIdx);
+    outData->id = e.id;
+    outData->ASCTy = e.ASCTy;
+    outData->header = e.header;
+    outData->captureUs = 0;        // delayed stream has no end-to-end latency
+    outData->data.resize(e.len);
+
+    size_t pos = e.offset % m_data.size();
+    size_t firstPart = std::min(static_cast<size_t>(e.len), m_data.size() - pos);
+    memcpy(outData->data.data(), &m_data[pos], firstPart);
+    if (firstPart < e.len)
+    {
+        memcpy(outData->data.data() + firstPart, &m_data[0], e.len - firstPart);
+    }
+
+    m_playIdx += 1;
+    return true;
+}
+
+int AudioTimeshift::delayMs() const
+{
+    if (m_isLive || (m_playIdx >= m_head))
+    {
+        return 0;
+    }
+    return m_streamTimeMs - entry(m_playIdx).timeMs;
+}
+
+int AudioTimeshift::bufferedMs() const
+{
+    if (m_tail == m_head)
+    {
+        return 0;
+    }
+    return m_streamTimeMs - entry(m_tail).timeMs;
+}
+
+uint16_t AudioTimeshift::auDurationMs(const RadioControlAudioData *inData, int sampleRateKHz)
+{
+    if (DabAudioDataSCty::DAB_AUDIO == inData->ASCTy)
+    {   // 1152 samples per frame
+        return (24 == sampleRateKHz) ? 48 : 24;
+    }
+
+    // AAC frame length is given by superframe rate and SBR
+    if (inData->header.bits.sbr_flag)
+    {
+        return inData->header.bits.dac_rate ? 40 : 60;
+    }
+    return inData->header.bits.dac_rate ? 20 : 30;
+}
@@ -0,0 +1,97 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIOTIMESHIFT_H
+#define AUDIOTIMESHIFT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "radiocontrol.h"
+
+#define AUDIO_TIMESHIFT_DEFAULT_MIN     (30)   // default timeshift buffer length
+#define AUDIO_TIMESHIFT_SKIP_SEC        (10)   // skip back/forward step
+#define AUDIO_TIMESHIFT_MIN_AU_MS       (20)   // shortest AU (AAC 48 kHz without SBR), used to size AU index
+#define AUDIO_TIMESHIFT_BITRATE_MARGIN (110)   // [%] of nominal bitrate reserved for data
+
+// ring buffer of compressed AUs for last N minutes of current service
+// AUs are stored in one preallocated byte ring with separate index => no allocation in steady state
+// playback position is moved in stream time, AU at play position is read back for decoding
+// used from audio decoder thread only
+class AudioTimeshift
+{
+public:
+    // durationSec = 0 disables the buffer and releases memory
+    void setup(int durationSec, int bitRateKbps);
+    bool isEnabled() const { return !m_data.empty(); }
+    void reset();
+
+    // copies AU to ring, oldest AUs are overwritten
+    // sampleRateKHz is current output sample rate, it is needed for MP2 frame duration
+    void store(const RadioControlAudioData * inData, int sampleRateKHz);
+
+    // playback is delayed (paused or rewound)
+    bool isShifted() const { return !m_isLive; }
+    void setShifted();              // play position stays where live stream is now
+    void goLive();
+
+    // relative move of play position in ms, negative = back
+    // returns true when play position reached live stream
+    bool seek(int offsetMs);
+
+    // reads AU at play position and moves to next one
+    // returns false when play position reached live stream (buffer is then live again)
+    bool read(RadioControlAudioData * outData);
+
+    int delayMs() const;
+    int bufferedMs() const;
+
+private:
+    struct Entry
+    {
+        uint64_t offset;           // absolute byte position in data ring
+        uint64_t timeMs;           // stream time at beginning of AU
+        uint32_t len;
+        uint16_t durationMs;
+        dabsdrDecoderId_t id;
+        DabAudioDataSCty ASCTy;
+        dabsdrAudioFrameHeader_t header;
+    };
+
+    std::vector<uint8_t> m_data;
+    std::vector<Entry> m_entries;
+    uint64_t m_writeBytes = 0;     // absolute number of bytes written
+    uint64_t m_head = 0;           // absolute index of next entry
+    uint64_t m_tail = 0;           // absolute index of oldest entry
+    uint64_t m_playIdx = 0;        // absolute index of next entry to play
+    uint64_t m_streamTimeMs = 0;   // stream time of next entry
+    bool m_isLive = true;
+
+    const Entry & entry(uint64_t idx) const { return m_entries[idx % m_entries.size()]; }
+    static uint16_t auDurationMs(const RadioControlAudioData * inData, int sampleRateKHz);
+};
+
+#endif // AUDIOTIMESHIFT_H
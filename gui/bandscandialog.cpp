@@ -29,6 +29,10 @@
 #include "bandscandialog.h"
 #include "ui_bandscandialog.h"
 #include "dabtables.h"
+#include "signaldetector.h"
+
+#define BANDSCANDIALOG_DETECTOR_POLL_MS  (50)
+#define BANDSCANDIALOG_PRIMARY_RECEIVER  (0)
 
 BandScanDialog::BandScanDialog(QWidget *parent, bool autoStart, Qt::WindowFlags f) :
     QDialog(parent, f),
@@ -47,12 +51,21 @@ BandScanDialog::BandScanDialog(QWidget *parent, bool autoStart, Qt::WindowFlags
     m_buttonStop->setDefault(true);
     connect(ui->buttonBox, &QDialogButtonBox::rejected, this, &BandScanDialog::stopPressed);
 
+    // scan can be limited to part of the band, channels are shared by all receivers
+    for (int n = 0; n < DabTables::numChannels(); ++n)
+    {
+        ui->firstChannelCombo->addItem(DabTables::channelLabel(n), DabTables::channelFrequency(n));
+        ui->lastChannelCombo->addItem(DabTables::channelLabel(n), DabTables::channelFrequency(n));
+    }
+    ui->firstChannelCombo->setCurrentIndex(0);
+    ui->lastChannelCombo->setCurrentIndex(ui->lastChannelCombo->count()-1);
+
     ui->numEnsemblesFoundLabel->setText(QString("%1").arg(m_numEnsemblesFound));
     ui->numServicesFoundLabel->setText(QString("%1").arg(m_numServicesFound));
     ui->progressBar->setMinimum(0);
-    ui->progressBar->setMaximum(DabTables::channelList.size());
+    ui->progressBar->setMaximum(DabTables::numChannels());
     ui->progressBar->setValue(0);
-    ui->progressLabel->setText(QString("0 / %1").arg(DabTables::channelList.size()));
+    ui->progressLabel->setText(QString("0 / %1").arg(DabTables::numChannels()));
     ui->progressChannel->setText(tr("None"));
 
     ui->progressLabel->setVisible(false);
@@ -78,6 +91,12 @@ BandScanDialog::~BandScanDialog()
         m_timer->stop();
         delete m_timer;
     }
+    if (nullptr != m_detectorTimer)
+    {
+        m_detectorTimer->stop();
+        delete m_detectorTimer;
+    }
+    SignalDetector::getInstance()->stop();
 
     delete ui;
 }
@@ -91,9 +110,16 @@ void BandScanDialog::stopPressed()
         // 2. wait for sync (timer or event)
         // 4. wait for ensemble (timer or event)
         // 5. wait for services (timer)
+        // 6. wait for other receivers
+        if (BandScanState::WaitForReceivers == m_state)
+        {   // primary receiver is not tuning
+            done(BandScanDialogResult::Interrupted);
+            return;
+        }
         if (m_timer->isActive())
         {   // state 2, 3, 4
             m_timer->stop();
+            m_detectorTimer->stop();
             done(BandScanDialogResult::Interrupted);
         }
         // timer not running -> state 1
@@ -109,6 +135,24 @@ void BandScanDialog::startScan()
 {
     m_isScanning = true;
 
+    int first = ui->firstChannelCombo->currentIndex();
+    int last = ui->lastChannelCombo->currentIndex();
+    if (first > last)
+    {
+        std::swap(first, last);
+    }
+    m_channelList.clear();
+    m_channelIdx = 0;
+    m_activeChannels.clear();
+    for (int n = first; n <= last; ++n)
+    {
+        m_channelList.append(ui->firstChannelCombo->itemData(n).toUInt());
+    }
+    ui->firstChannelCombo->setEnabled(false);
+    ui->lastChannelCombo->setEnabled(false);
+    ui->progressBar->setMaximum(m_channelList.size());
+    ui->progressLabel->setText(QString("0 / %1").arg(m_channelList.size()));
+
     ui->scanningLabel->setText(tr("Scanning channel:"));
     ui->progressLabel->setVisible(true);
     ui->progressChannel->setVisible(true);
@@ -120,6 +164,10 @@ void BandScanDialog::startScan()
     m_timer = new QTimer(this);
     connect(m_timer, &QTimer::timeout, this, &BandScanDialog::scanStep);
 
+    m_detectorTimer = new QTimer(this);
+    m_detectorTimer->setInterval(BANDSCANDIALOG_DETECTOR_POLL_MS);
+    connect(m_detectorTimer, &QTimer::timeout, this, &BandScanDialog::onDetectorTimeout);
+
     m_state = BandScanState::Init;
 
     // using timer for mainwindow to cleanup and tune to 0 potentially (no timeout in case)
@@ -129,33 +177,93 @@ void BandScanDialog::startScan()
 
 void BandScanDialog::scanStep()
 {
-    if (BandScanState::Init == m_state)
-    {  // first step
-       m_channelIt = DabTables::channelList.constBegin();
+    uint32_t freq = takeChannel(BANDSCANDIALOG_PRIMARY_RECEIVER);
+    if (0 == freq)
+    {   // no channel left for primary receiver
+        if (m_activeChannels.isEmpty())
+        {   // scan finished
+            done(BandScanDialogResult::Done);
+        }
+        else
+        {   // waiting for channels scanned by other receivers
+            m_timer->stop();
+            m_detectorTimer->stop();
+            m_state = BandScanState::WaitForReceivers;
+        }
+        return;
     }
-    else
-    {  // next step
-       ++m_channelIt;
+
+    m_state = BandScanState::WaitForTune;
+    emit tuneChannel(freq);
+}
+
+uint32_t BandScanDialog::takeChannel(int receiver)
+{
+    // previous channel of receiver is finished
+    m_activeChannels.remove(receiver);
+
+    uint32_t freq = 0;
+    if ((BandScanState::Interrupted != m_state) && (m_channelIdx < m_channelList.size()))
+    {
+        freq = m_channelList.at(m_channelIdx++);
+        m_activeChannels.insert(receiver, freq);
+
+        ui->progressBar->setValue(m_channelIdx);
+        ui->progressLabel->setText(QString("%1 / %2")
+                                   .arg(m_channelIdx)
+                                   .arg(m_channelList.size()));
     }
+    else { /* all channels are taken */ }
 
-    if (DabTables::channelList.constEnd() == m_channelIt)
+    updateActiveChannels();
+    if (BANDSCANDIALOG_PRIMARY_RECEIVER != receiver)
     {
-        // scan finished
-        done(BandScanDialogResult::Done);
-        return;
+        checkReceiversFinished();
     }
+    else { /* primary receiver is handled by scanStep() */ }
 
-    ui->progressBar->setValue(ui->progressBar->value()+1);
-    ui->progressLabel->setText(QString("%1 / %2")
-                               .arg(ui->progressBar->value())
-                               .arg(DabTables::channelList.size()));
-    ui->progressChannel->setText(m_channelIt.value());
-    m_state = BandScanState::WaitForTune;
-    emit tuneChannel(m_channelIt.key());
+    return freq;
+}
+
+void BandScanDialog::releaseReceiver(int receiver)
+{   // receiver is lost, its channel is not scanned
+    m_activeChannels.remove(receiver);
+    updateActiveChannels();
+    checkReceiversFinished();
+}
+
+void BandScanDialog::updateActiveChannels()
+{
+    QStringList channels;
+    for (const auto freq : std::as_const(m_activeChannels))
+    {
+        channels.append(DabTables::channelName(freq));
+    }
+    ui->progressChannel->setText(channels.isEmpty() ? tr("None") : channels.join(", "));
+}
+
+void BandScanDialog::checkReceiversFinished()
+{
+    if ((BandScanState::WaitForReceivers == m_state) && m_activeChannels.isEmpty())
+    {   // called from EnsembleMonitor, dialog is finished from event loop
+        m_state = BandScanState::Idle;
+        QTimer::singleShot(0, this, [this]() { done(BandScanDialogResult::Done); });
+    }
+    else { /* primary receiver or other receivers still scanning */ }
+}
+
+void BandScanDialog::onReceiverEnsembleFound(int, uint32_t)
+{
+    ui->numEnsemblesFoundLabel->setText(QString("%1").arg(++m_numEnsemblesFound));
 }
 
 void BandScanDialog::onTuneDone(uint32_t freq)
 {
+    if (BandScanState::WaitForReceivers == m_state)
+    {   // primary receiver finished already
+        return;
+    }
+
     if (BandScanState::Init == m_state)
     {
         if (m_timer->isActive())
@@ -172,7 +280,28 @@ void BandScanDialog::onTuneDone(uint32_t freq)
     {   // tuned to some frequency -> wait for sync
         m_state = BandScanState::WaitForSync;
         m_timer->start(3000);
+
+        // empty channel is rejected by detector before sync timeout
+        SignalDetector::getInstance()->start();
+        m_detectorTimer->start();
+    }
+}
+
+void BandScanDialog::onDetectorTimeout()
+{
+    SignalDetectorResult result = SignalDetector::getInstance()->result();
+    if (SignalDetectorResult::Pending == result)
+    {   // not decided yet
+        return;
+    }
+
+    m_detectorTimer->stop();
+    if ((SignalDetectorResult::Absent == result) && (BandScanState::WaitForSync == m_state))
+    {   // no DAB signal -> next channel
+        m_timer->stop();
+        scanStep();
     }
+    else { /* DAB signal detected or synchronized already -> waiting for sync or ensemble */ }
 }
 
 void BandScanDialog::onSyncStatus(uint8_t sync, float)
@@ -182,6 +311,8 @@ void BandScanDialog::onSyncStatus(uint8_t sync, float)
         if (BandScanState::WaitForSync == m_state)
         {   // if we are waiting for sync (move to next step)
             m_timer->stop();
+            m_detectorTimer->stop();
+            SignalDetector::getInstance()->stop();
             m_state = BandScanState::WaitForEnsemble;
             m_timer->start(6000);
         }
@@ -190,7 +321,7 @@ void BandScanDialog::onSyncStatus(uint8_t sync, float)
 
 void BandScanDialog::onEnsembleFound(const RadioControlEnsemble &)
 {
-    if (BandScanState::Idle == m_state)
+    if ((BandScanState::Idle == m_state) || (BandScanState::WaitForReceivers == m_state))
     {   // do nothing
         return;
     }
@@ -32,6 +32,7 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QDialogButtonBox>
+#include <QMap>
 
 #include "radiocontrol.h"
 #include "servicelistid.h"
@@ -57,6 +58,7 @@ enum class BandScanState
     WaitForSync,
     WaitForEnsemble,
     WaitForServices,
+    WaitForReceivers,    // primary receiver finished, other receivers still scanning
     Interrupted
 };
 
@@ -74,6 +76,11 @@ public:
     void onServiceFound(const ServiceListId &);
     void onServiceListComplete(const RadioControlEnsemble &);
 
+    // channels are shared by primary receiver (0) and receivers of EnsembleMonitor
+    uint32_t takeChannel(int receiver);   // returns 0 when all channels are taken
+    void releaseReceiver(int receiver);
+    void onReceiverEnsembleFound(int receiver, uint32_t freq);
+
 signals:
     void scanStarts();
     void tuneChannel(uint32_t freq);
@@ -83,17 +90,23 @@ private:
     QPushButton * m_buttonStart;
     QPushButton * m_buttonStop;
     QTimer * m_timer = nullptr;
+    QTimer * m_detectorTimer = nullptr;   // polling of signal detector result
 
     bool m_isScanning = false;
     BandScanState m_state = BandScanState::Idle;
 
     int m_numEnsemblesFound = 0;
     int m_numServicesFound = 0;
-    dabChannelList_t::ConstIterator m_channelIt;
+    QList<uint32_t> m_channelList;   // channels to be scanned
+    int m_channelIdx = 0;            // next channel to be taken
+    QMap<int, uint32_t> m_activeChannels;  // receiver -> channel being scanned
 
     void startScan();
     void scanStep();
     void stopPressed();
+    void onDetectorTimeout();
+    void updateActiveChannels();
+    void checkReceiversFinished();
 };
 
 #endif // BANDSCANDIALOG_H
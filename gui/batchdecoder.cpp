@@ -0,0 +1,385 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QDir>
+#include <QTextStream>
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QRegularExpression>
+
+#include "batchdecoder.h"
+#include "audiodecoder.h"
+#include "audiorecorder.h"
+#include "slideshowapp.h"
+#include "spiapp.h"
+#include "dldecoder.h"
+#include "subscriptionmanager.h"
+#include "audiodecoderbenchmark.h"
+
+Q_LOGGING_CATEGORY(batchDecoder, "BatchDecoder", QtInfoMsg)
+
+BatchDecoder::BatchDecoder(const QString &outputPath, QObject *parent) : QObject(parent)
+    , m_outputPath(outputPath)
+    , m_sampleFormat(RawFileInputFormat::SAMPLE_FORMAT_U8)
+{
+    m_radioControl = new RadioControl();
+    m_radioControlThread = new QThread(this);
+    m_radioControlThread->setObjectName("radioControlThr");
+    m_radioControl->moveToThread(m_radioControlThread);
+    connect(m_radioControlThread, &QThread::finished, m_radioControl, &QObject::deleteLater);
+    m_radioControlThread->start();
+
+    m_audioRecorder = new AudioRecorder();
+    m_audioDecoder = new AudioDecoder(m_audioRecorder);
+    m_audioDecoderThread = new QThread(this);
+    m_audioDecoderThread->setObjectName("audioDecoderThr");
+    m_audioDecoder->moveToThread(m_audioDecoderThread);
+    m_audioRecorder->moveToThread(m_audioDecoderThread);
+    connect(m_audioDecoderThread, &QThread::finished, m_audioDecoder, &QObject::deleteLater);
+    connect(m_audioDecoderThread, &QThread::finished, m_audioRecorder, &QObject::deleteLater);
+    m_audioDecoderThread->start();
+
+    m_audioDrain = new AudioFifoDrain(this);
+
+    m_slideShowApp = new SlideShowApp();
+    m_slideShowApp->setObjectStoreEnabled(false);   // output shall contain only decoded data
+    m_slideShowApp->moveToThread(m_radioControlThread);
+    connect(m_radioControlThread, &QThread::finished, m_slideShowApp, &QObject::deleteLater);
+
+    m_spiApp = new SPIApp();
+    m_spiApp->setObjectStoreEnabled(false);
+    m_spiApp->moveToThread(m_radioControlThread);
+    connect(m_radioControlThread, &QThread::finished, m_spiApp, &QObject::deleteLater);
+
+    m_dlDecoder = new DLDecoder(this);
+
+    m_inputDevice = new RawFileInput();
+    m_inputDevice->setFastReplay(true);
+
+    m_subscriptionManager = new SubscriptionManager(m_radioControl, this);
+}
+
+BatchDecoder::~BatchDecoder()
+{
+    delete m_inputDevice;
+    delete m_subscriptionManager;
+
+    m_radioControlThread->quit();  // this deletes radioControl and user applications
+    m_radioControlThread->wait();
+    delete m_radioControlThread;
+
+    m_audioDecoderThread->quit();  // this deletes audiodecoder and recorder
+    m_audioDecoderThread->wait();
+    delete m_audioDecoderThread;
+
+    m_audioDrain->finish();
+
+    if (nullptr != m_dlFile)
+    {
+        m_dlFile->close();
+        delete m_dlFile;
+    }
+
+    if (nullptr != m_audioDataDumpFile)
+    {
+        m_audioDataDumpFile->close();
+        delete m_audioDataDumpFile;
+    }
+}
+
+void BatchDecoder::setFile(const QString &fileName, const RawFileInputFormat &sampleFormat)
+{
+    m_fileName = fileName;
+    m_sampleFormat = sampleFormat;
+}
+
+bool BatchDecoder::start()
+{
+    if (!m_radioControl->init())
+    {
+        qCCritical(batchDecoder) << "RadioControl() init failed";
+        return false;
+    }
+
+    QDir dir;
+    if (!dir.mkpath(m_outputPath) || !dir.mkpath(m_outputPath + "/Audio") || !dir.mkpath(m_outputPath + "/EPG"))
+    {
+        qCCritical(batchDecoder) << "Unable to create output directory:" << m_outputPath;
+        return false;
+    }
+
+    m_dlFile = new QFile(m_outputPath + "/DL.txt");
+    if (!m_dlFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        qCCritical(batchDecoder) << "Unable to open file:" << m_dlFile->fileName();
+        delete m_dlFile;
+        m_dlFile = nullptr;
+        return false;
+    }
+
+    if (!m_audioDataDumpFileName.isEmpty())
+    {
+        m_audioDataDumpFile = new QFile(m_audioDataDumpFileName);
+        if (!m_audioDataDumpFile->open(QIODevice::WriteOnly))
+        {
+            qCCritical(batchDecoder) << "Unable to open file:" << m_audioDataDumpFileName;
+            delete m_audioDataDumpFile;
+            m_audioDataDumpFile = nullptr;
+            return false;
+        }
+        m_audioDataDumpStream.setDevice(m_audioDataDumpFile);
+        AudioDataCorpus::writeHeader(m_audioDataDumpStream);
+    }
+
+    m_inputDevice->setFile(m_fileName, m_sampleFormat);
+    if (!m_inputDevice->openDevice())
+    {
+        return false;
+    }
+
+    const InputDeviceDescription & desc = m_inputDevice->deviceDescription();
+    // XML or WAV header overrides format from command line, it is applied when file is opened
+    m_frequency = (desc.rawFile.frequency_kHz > 0) ? desc.rawFile.frequency_kHz : BATCHDECODER_FREQ_DEFAULT;
+
+    // tuning procedure
+    connect(m_radioControl, &RadioControl::tuneInputDevice, m_inputDevice, &InputDevice::tune, Qt::QueuedConnection);
+    connect(m_inputDevice, &InputDevice::tuned, m_radioControl, &RadioControl::start, Qt::QueuedConnection);
+    connect(m_inputDevice, &InputDevice::error, this, &BatchDecoder::onInputDeviceError, Qt::QueuedConnection);
+    connect(m_inputDevice, &RawFileInput::fileProgress, this, [this](int msec) { m_processedMsec = msec; });
+    connect(this, &BatchDecoder::serviceRequest, m_radioControl, &RadioControl::tuneService, Qt::QueuedConnection);
+    connect(this, &BatchDecoder::exit, m_radioControl, &RadioControl::exit, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::tuneDone, this, &BatchDecoder::onTuneDone, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::dabTime, this, [this](const QDateTime & dateAndTime) { m_dabTime = dateAndTime; }, Qt::QueuedConnection);
+
+    // service list
+    connect(m_radioControl, &RadioControl::serviceListEntry, this, &BatchDecoder::onServiceListEntry, Qt::BlockingQueuedConnection);
+    connect(m_radioControl, &RadioControl::serviceListComplete, this, &BatchDecoder::onServiceListComplete, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::audioServiceSelection, this, &BatchDecoder::onAudioServiceSelection, Qt::QueuedConnection);
+
+    // audio
+    if (nullptr != m_audioDataDumpFile)
+    {   // direct connection in dabsdr thread, it must be connected before decoder that releases data
+        connect(m_radioControl, &RadioControl::audioData, this, [this](RadioControlAudioData *inData) {
+            AudioDataCorpus::write(m_audioDataDumpStream, inData);
+        }, Qt::DirectConnection);
+    }
+    connect(m_radioControl, &RadioControl::audioData, m_audioDecoder, &AudioDecoder::decodeData, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::audioServiceSelection, m_audioDecoder, &AudioDecoder::start, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::stopAudio, m_audioDecoder, &AudioDecoder::stop, Qt::QueuedConnection);
+    connect(m_audioDecoder, &AudioDecoder::startAudio, m_audioDrain, &AudioFifoDrain::start, Qt::QueuedConnection);
+    connect(m_audioDecoder, &AudioDecoder::switchAudio, m_audioDrain, &AudioFifoDrain::start, Qt::QueuedConnection);
+    connect(m_audioDecoder, &AudioDecoder::stopAudio, m_audioDrain, &AudioFifoDrain::stop, Qt::QueuedConnection);
+    // new file is started for every audio format, direct connection - recorder lives in decoder thread
+    connect(m_audioDecoder, &AudioDecoder::audioParametersInfo, m_audioRecorder, [this]() { m_audioRecorder->start(); }, Qt::DirectConnection);
+    connect(m_audioRecorder, &AudioRecorder::recordingStarted, this, [](const QString & filename) {
+        qCInfo(batchDecoder) << "Audio:" << filename;
+    }, Qt::QueuedConnection);
+    QMetaObject::invokeMethod(m_audioRecorder, [this]() { m_audioRecorder->setup(m_outputPath + "/Audio", m_doOutputRecording); }, Qt::QueuedConnection);
+
+    // DL
+    connect(m_radioControl, &RadioControl::dlDataGroup_Service, m_dlDecoder, &DLDecoder::newDataGroup, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::audioServiceSelection, m_dlDecoder, &DLDecoder::reset, Qt::QueuedConnection);
+    connect(m_dlDecoder, &DLDecoder::dlComplete, this, &BatchDecoder::onDLComplete);
+
+    // user applications
+    SetupDialog::Settings::UADumpSettings dumpSettings;
+    dumpSettings.folder = m_outputPath;
+    dumpSettings.overwriteEna = true;
+    dumpSettings.slsEna = true;
+    dumpSettings.spiEna = true;
+    dumpSettings.slsPattern = "SLS/{serviceId}/{contentNameWithExt}";
+    dumpSettings.spiPattern = "SPI/{ensId}/{scId}_{directoryId}/{contentName}";
+
+    connect(m_radioControl, &RadioControl::audioServiceSelection, m_slideShowApp, &SlideShowApp::start);
+    connect(m_radioControl, &RadioControl::userAppData_Service, m_slideShowApp, &SlideShowApp::onUserAppData);
+    connect(m_radioControl, &RadioControl::ensembleInformation, m_slideShowApp, &UserApplication::setEnsId);
+    connect(m_radioControl, &RadioControl::audioServiceSelection, m_slideShowApp, &UserApplication::setAudioServiceId);
+    QMetaObject::invokeMethod(m_slideShowApp, [this, dumpSettings]() { m_slideShowApp->setDataDumping(dumpSettings); }, Qt::QueuedConnection);
+
+    connect(m_radioControl, &RadioControl::userAppData_Service, m_spiApp, &SPIApp::onUserAppData);
+    connect(m_radioControl, &RadioControl::audioServiceSelection,  m_spiApp, &SPIApp::start);
+    connect(m_radioControl, &RadioControl::ensembleInformation, m_spiApp, &UserApplication::setEnsId);
+    connect(m_radioControl, &RadioControl::audioServiceSelection, m_spiApp, &UserApplication::setAudioServiceId);
+    connect(m_spiApp, &SPIApp::xmlDocument, this, &BatchDecoder::onXmlDocument, Qt::QueuedConnection);
+    QMetaObject::invokeMethod(m_spiApp, [this]() { m_spiApp->setPIXmlOutput(true); }, Qt::QueuedConnection);  // programme information is stored as XML
+    connect(this, &BatchDecoder::spiApplicationEnabled, m_radioControl, &RadioControl::onSpiApplicationEnabled, Qt::QueuedConnection);
+    connect(this, &BatchDecoder::spiApplicationEnabled, m_spiApp, &SPIApp::enable, Qt::QueuedConnection);
+    QMetaObject::invokeMethod(m_spiApp, [this, dumpSettings]() { m_spiApp->setDataDumping(dumpSettings); }, Qt::QueuedConnection);
+    emit spiApplicationEnabled(true);
+
+    // other service components
+    m_subscriptionManager->setDataDumping(dumpSettings);
+    m_subscriptionManager->setAudioRecording(m_outputPath + "/Audio", m_doOutputRecording);
+
+    qCInfo(batchDecoder) << "Decoding" << m_fileName << "to" << m_outputPath;
+    m_elapsedTimer.start();
+
+    // service is selected when service list is complete if not requested
+    m_currentSId = m_requestedSId;
+    emit serviceRequest(m_frequency, m_requestedSId, 0);
+
+    return true;
+}
+
+void BatchDecoder::onServiceListEntry(const RadioControlEnsemble &ens, const RadioControlServiceComponent &s)
+{
+    Q_UNUSED(ens);
+    if (s.isAudioService() && (s.SCIdS == 0))
+    {
+        m_audioServices.append(s);
+    }
+    else if (s.isDataPacketService())
+    {
+        m_dataServices.append(s);
+    }
+    else { /* not supported */ }
+}
+
+void BatchDecoder::onServiceListComplete(const RadioControlEnsemble &ens)
+{
+    qCInfo(batchDecoder) << "Ensemble:" << ens.label << "services:" << m_audioServices.size();
+    if (0 == m_currentSId)
+    {   // service was not requested, first audio service is selected
+        if (!m_audioServices.isEmpty())
+        {
+            m_currentSId = m_audioServices.at(0).SId.value();
+            emit serviceRequest(m_frequency, m_currentSId, 0);
+        }
+        else
+        {
+            qCWarning(batchDecoder) << "No audio service found";
+        }
+    }
+    else { /* service already selected */ }
+
+    if (m_subscribeAll)
+    {   // all packet data components and one more audio service (limited by number of audio decoders)
+        for (const auto & s : std::as_const(m_dataServices))
+        {
+            m_subscriptionManager->subscribe(s.SId.value(), s.SCIdS);
+        }
+        for (const auto & s : std::as_const(m_audioServices))
+        {
+            if (s.SId.value() != m_currentSId)
+            {
+                m_subscriptionManager->subscribe(s.SId.value(), s.SCIdS);
+                break;
+            }
+        }
+    }
+}
+
+void BatchDecoder::onAudioServiceSelection(const RadioControlServiceComponent &s)
+{
+    qCInfo(batchDecoder) << "Service:" << s.label << QString("%1").arg(s.SId.value(), 6, 16, QChar('0')).toUpper();
+}
+
+void BatchDecoder::onTuneDone(uint32_t freq)
+{
+    if ((0 == freq) && m_exitRequested)
+    {   // processing in IDLE
+        emit exit();
+
+        qint64 elapsed = m_elapsedTimer.elapsed();
+        qCInfo(batchDecoder) << "Decoded" << m_processedMsec / 1000.0 << "sec in" << elapsed / 1000.0 << "sec,"
+                             << "speed" << ((elapsed > 0) ? (m_processedMsec * 1.0 / elapsed) : 0.0) << "x";
+
+        emit finished(0);
+    }
+}
+
+void BatchDecoder::onDLComplete(const QString &dl)
+{
+    if (nullptr != m_dlFile)
+    {
+        QTextStream out(m_dlFile);
+        out << (m_dabTime.isValid() ? m_dabTime.toString(Qt::ISODate) : QString("-")) << '\t'
+            << QString("%1").arg(m_currentSId, 6, 16, QChar('0')).toUpper() << '\t'
+            << QString(dl).replace(QChar('\n'), QChar(' ')) << '\n';
+    }
+}
+
+void BatchDecoder::onXmlDocument(const QString &xml, const QString &scopeId, uint16_t decoderId)
+{
+    Q_UNUSED(decoderId);
+
+    static const QRegularExpression regexp( "[" + QRegularExpression::escape("/:*?\"<>|.") + "]");
+    QString name = scopeId;
+    name.replace(regexp, "_");
+
+    QFile file(m_outputPath + QString("/EPG/%1_%2.xml").arg(name).arg(m_xmlCntr++, 4, 10, QChar('0')));
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        file.write(xml.toUtf8());
+        file.close();
+    }
+    else
+    {
+        qCWarning(batchDecoder) << "Unable to write file:" << file.fileName();
+    }
+}
+
+void BatchDecoder::onInputDeviceError(const InputDeviceErrorCode errCode)
+{
+    if (InputDeviceErrorCode::EndOfFile == errCode)
+    {   // file was read, wait until DAB processing consumes all samples in input FIFO
+        if (nullptr == m_drainTimer)
+        {
+            m_drainAvailable = m_inputDevice->fifo()->available();
+            m_drainTimer = new QTimer(this);
+            connect(m_drainTimer, &QTimer::timeout, this, &BatchDecoder::onDrainTimeout);
+            m_drainTimer->start(BATCHDECODER_DRAIN_PERIOD_MS);
+        }
+    }
+    else
+    {
+        qCWarning(batchDecoder) << "Input device error:" << int(errCode);
+        finish();
+    }
+}
+
+void BatchDecoder::onDrainTimeout()
+{
+    uint64_t available = m_inputDevice->fifo()->available();
+    if (available == m_drainAvailable)
+    {   // no progress, remaining samples are not enough for DAB processing
+        m_drainTimer->stop();
+        finish();
+    }
+    else
+    {
+        m_drainAvailable = available;
+    }
+}
+
+void BatchDecoder::finish()
+{
+    if (!m_exitRequested)
+    {
+        m_exitRequested = true;
+        emit serviceRequest(0, 0, 0);
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BATCHDECODER_H
+#define BATCHDECODER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <atomic>
+
+#include "radiocontrol.h"
+#include "audiofifo.h"
+#include "inputdevice.h"
+#include "rawfileinput.h"
+
+#define BATCHDECODER_FREQ_DEFAULT     227360   // used when raw file does not contain frequency [kHz]
+#define BATCHDECODER_DRAIN_PERIOD_MS     200   // input FIFO drain check period after end of file
+
+class AudioDecoder;
+class AudioRecorder;
+class SlideShowApp;
+class SPIApp;
+class DLDecoder;
+class SubscriptionManager;
+
+// headless decoding of raw file at maximum speed
+// audio, slides, DL texts and EPG are dumped to output directory
+class BatchDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BatchDecoder(const QString & outputPath, QObject *parent = nullptr);
+    ~BatchDecoder();
+    void setFile(const QString & fileName, const RawFileInputFormat & sampleFormat);
+    void setService(uint32_t SId) { m_requestedSId = SId; }
+    void setOutputRecording(bool ena) { m_doOutputRecording = ena; }
+    void setSubscribeAll(bool ena) { m_subscribeAll = ena; }
+    void setAudioDataDump(const QString & fileName) { m_audioDataDumpFileName = fileName; }
+    bool start();
+
+signals:
+    void serviceRequest(uint32_t freq, uint32_t SId, uint8_t SCIdS);
+    void spiApplicationEnabled(bool ena);
+    void exit();
+    void finished(int exitCode);
+
+private:
+    QString m_outputPath;
+    QString m_fileName;
+    RawFileInputFormat m_sampleFormat;
+    uint32_t m_requestedSId = 0;
+    bool m_doOutputRecording = false;
+    bool m_subscribeAll = false;
+    QString m_audioDataDumpFileName;
+
+    QThread * m_radioControlThread;
+    QThread * m_audioDecoderThread;
+    RadioControl * m_radioControl;
+    AudioDecoder * m_audioDecoder;
+    AudioRecorder * m_audioRecorder;
+    AudioFifoDrain * m_audioDrain;
+    SlideShowApp * m_slideShowApp;
+    SPIApp * m_spiApp;
+    DLDecoder * m_dlDecoder;
+    RawFileInput * m_inputDevice;
+    SubscriptionManager * m_subscriptionManager;
+
+    uint32_t m_frequency = 0;
+    uint32_t m_currentSId = 0;
+    bool m_exitRequested = false;
+    QList<RadioControlServiceComponent> m_audioServices;
+    QList<RadioControlServiceComponent> m_dataServices;
+    QDateTime m_dabTime;
+    QFile * m_dlFile = nullptr;
+    QFile * m_audioDataDumpFile = nullptr;
+    QDataStream m_audioDataDumpStream;
+    int m_xmlCntr = 0;
+    QTimer * m_drainTimer = nullptr;
+    uint64_t m_drainAvailable = 0;
+    int m_processedMsec = 0;
+    QElapsedTimer m_elapsedTimer;
+
+    void onServiceListEntry(const RadioControlEnsemble & ens, const RadioControlServiceComponent & s);
+    void onServiceListComplete(const RadioControlEnsemble & ens);
+    void onAudioServiceSelection(const RadioControlServiceComponent & s);
+    void onTuneDone(uint32_t freq);
+    void onDLComplete(const QString & dl);
+    void onXmlDocument(const QString & xml, const QString & scopeId, uint16_t decoderId);
+    void onInputDeviceError(const InputDeviceErrorCode errCode);
+    void onDrainTimeout();
+    void finish();
+};
+
+#endif // BATCHDECODER_H
@@ -0,0 +1,190 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QFile>
+#include <QTextStream>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <chrono>
+
+#include "audiodecoderbenchmark.h"
+#include "audiodecoder.h"
+#include "audiorecorder.h"
+
+Q_LOGGING_CATEGORY(audioDecoderBenchmark, "AudioDecoderBenchmark", QtInfoMsg)
+
+void AudioDataCorpus::writeHeader(QDataStream &out)
+{
+    out << quint32(AUDIO_DATA_CORPUS_MAGIC) << quint32(AUDIO_DATA_CORPUS_VERSION);
+}
+
+void AudioDataCorpus::write(QDataStream &out, const RadioControlAudioData *inData)
+{
+    out << quint8(inData->ASCTy) << quint8(inData->header.raw) << quint16(inData->data.size());
+    out.writeRawData(reinterpret_cast<const char *>(inData->data.data()), inData->data.size());
+}
+
+bool AudioDataCorpus::readHeader(QDataStream &in)
+{
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+
+    return (QDataStream::Ok == in.status()) && (AUDIO_DATA_CORPUS_MAGIC == magic) && (AUDIO_DATA_CORPUS_VERSION == version);
+}
+
+bool AudioDataCorpus::read(QDataStream &in, RadioControlAudioData *outData)
+{
+    quint8 ascty;
+    quint8 header;
+    quint16 len;
+    in >> ascty >> header >> len;
+    if (QDataStream::Ok != in.status())
+    {
+        return false;
+    }
+
+    outData->ASCTy = static_cast<DabAudioDataSCty>(ascty);
+    outData->header.raw = header;
+    outData->data.resize(len);
+
+    return (len == in.readRawData(reinterpret_cast<char *>(outData->data.data()), len));
+}
+
+AudioDecoderBenchmark::AudioDecoderBenchmark(QObject *parent) : QObject(parent)
+{ }
+
+bool AudioDecoderBenchmark::loadCorpus(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCCritical(audioDecoderBenchmark) << "Unable to open file:" << fileName;
+        return false;
+    }
+
+    QDataStream in(&file);
+    if (!AudioDataCorpus::readHeader(in))
+    {
+        qCCritical(audioDecoderBenchmark) << "Not an audio data corpus:" << fileName;
+        return false;
+    }
+
+    RadioControlAudioData record;
+    while (AudioDataCorpus::read(in, &record))
+    {
+        m_corpus.push_back({ record.ASCTy, record.header, record.data });
+    }
+
+    if (m_corpus.empty())
+    {
+        qCCritical(audioDecoderBenchmark) << "Audio data corpus is empty:" << fileName;
+        return false;
+    }
+
+    return true;
+}
+
+int AudioDecoderBenchmark::run(const QString &fileName)
+{
+    if (!loadCorpus(fileName))
+    {
+        return 1;
+    }
+
+    AudioRecorder recorder;
+    AudioDecoder decoder(&recorder);
+    decoder.setNoiseConcealment(AUDIO_DECODER_BENCHMARK_NOISE_LEVEL);
+
+    // decoder is called synchronously, output FIFO is emptied after every AU outside of measurement
+    connect(&decoder, &AudioDecoder::startAudio, this, [this](audioFifo_t *buffer) { m_outFifoPtr = buffer; }, Qt::DirectConnection);
+    connect(&decoder, &AudioDecoder::switchAudio, this, [this](audioFifo_t *buffer) { m_outFifoPtr = buffer; }, Qt::DirectConnection);
+    connect(&decoder, &AudioDecoder::stopAudio, this, [this]() { m_outFifoPtr = nullptr; }, Qt::DirectConnection);
+
+    RadioControlServiceComponent sc;
+    sc.SId.set(0);
+    sc.SCIdS = 0;
+    sc.TMId = DabTMId::StreamAudio;
+    sc.streamAudioData.scType = m_corpus.front().ASCTy;
+    sc.streamAudioData.bitRate = 0;
+    decoder.start(sc);
+
+    std::vector<uint32_t> timeNs;
+    timeNs.reserve(std::max(AUDIO_DECODER_BENCHMARK_MIN_AU, int(m_corpus.size())));
+    double audioSec = 0.0;
+    while (timeNs.size() < AUDIO_DECODER_BENCHMARK_MIN_AU)
+    {
+        for (const auto & record : m_corpus)
+        {
+            RadioControlAudioData * pAudioData = RadioControlAudioDataPool::getInstance()->acquire();
+            pAudioData->id = DABSDR_ID_AUDIO_PRIMARY;
+            pAudioData->ASCTy = record.ASCTy;
+            pAudioData->header = record.header;
+            pAudioData->data.assign(record.data.cbegin(), record.data.cend());
+
+            auto start = std::chrono::steady_clock::now();
+            decoder.decodeData(pAudioData);
+            timeNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+            if (nullptr != m_outFifoPtr)
+            {
+                int64_t bytes = m_outFifoPtr->availableBytes();
+                audioSec += double(bytes) / (m_outFifoPtr->sampleRate * m_outFifoPtr->numChannels * sizeof(audioSample_t));
+                m_outFifoPtr->commitRead(bytes);
+            }
+        }
+    }
+    decoder.stop();
+
+    double totalSec = 0.0;
+    for (const auto & t : timeNs)
+    {
+        totalSec += t * 1e-9;
+    }
+    std::sort(timeNs.begin(), timeNs.end());
+
+#if HAVE_FDKAAC
+    const char * aacBackend = "FDK-AAC";
+#else
+    const char * aacBackend = "FAAD2";
+#endif
+    int numMP2 = std::count_if(m_corpus.cbegin(), m_corpus.cend(), [](const Record & r) { return DabAudioDataSCty::DAB_AUDIO == r.ASCTy; });
+
+    QTextStream out(stdout);
+    out << "Corpus:        " << fileName << " (" << m_corpus.size() << " AUs, " << numMP2 << " MP2)\n";
+    out << "AAC decoder:   " << aacBackend << "\n";
+    out << "Decoded AUs:   " << timeNs.size() << "\n";
+    out << "Mean [us/AU]:  " << QString::number(totalSec * 1e6 / timeNs.size(), 'f', 1) << "\n";
+    out << "P50 [us/AU]:   " << QString::number(timeNs[timeNs.size() / 2] * 1e-3, 'f', 1) << "\n";
+    out << "P99 [us/AU]:   " << QString::number(timeNs[timeNs.size() * 99 / 100] * 1e-3, 'f', 1) << "\n";
+    out << "Max [us/AU]:   " << QString::number(timeNs.back() * 1e-3, 'f', 1) << "\n";
+    if (totalSec > 0)
+    {
+        out << "Realtime:      " << QString::number(audioSec / totalSec, 'f', 1) << " x\n";
+    }
+
+    return 0;
+}
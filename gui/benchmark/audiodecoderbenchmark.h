@@ -0,0 +1,80 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef AUDIODECODERBENCHMARK_H
+#define AUDIODECODERBENCHMARK_H
+
+#include <QObject>
+#include <QDataStream>
+#include <vector>
+
+#include "radiocontrol.h"
+#include "audiofifo.h"
+
+#define AUDIO_DATA_CORPUS_MAGIC      (0x41554443)  // "AUDC"
+#define AUDIO_DATA_CORPUS_VERSION    (1)
+
+#define AUDIO_DECODER_BENCHMARK_MIN_AU       (20000)  // corpus is replayed repeatedly until this number of AUs is decoded
+#define AUDIO_DECODER_BENCHMARK_NOISE_LEVEL  (25)     // noise concealment level used for FAAD2 [-dBFS]
+
+// serialized stream of RadioControlAudioData used as replay corpus
+// file starts with magic and version, then records follow: [ASCTy (uint8), header (uint8), length (uint16), AU data]
+class AudioDataCorpus
+{
+public:
+    static void writeHeader(QDataStream & out);
+    static void write(QDataStream & out, const RadioControlAudioData * inData);
+
+    // returns false if file is not valid corpus
+    static bool readHeader(QDataStream & in);
+    // returns false at the end of stream
+    static bool read(QDataStream & in, RadioControlAudioData * outData);
+};
+
+// offline replay of audio corpus through AudioDecoder, reports decoding time per AU
+class AudioDecoderBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AudioDecoderBenchmark(QObject *parent = nullptr);
+
+    // returns exit code
+    int run(const QString & fileName);
+
+private:
+    struct Record
+    {
+        DabAudioDataSCty ASCTy;
+        dabsdrAudioFrameHeader_t header;
+        std::vector<uint8_t> data;
+    };
+    std::vector<Record> m_corpus;
+    audioFifo_t * m_outFifoPtr = nullptr;
+
+    bool loadCorpus(const QString & fileName);
+};
+
+#endif // AUDIODECODERBENCHMARK_H
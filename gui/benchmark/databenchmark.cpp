@@ -0,0 +1,244 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Benchmark of data decoders on recorded data groups (file written when DataGroupRecording/file is set in ini)
+//   usage: AbracaDABraDataBench <recording> [duration_ms]
+// recording is replayed repeatedly into new decoder instances at full speed on single core,
+// results are data groups per second, MB/s and heap allocations per data group
+// use -platform offscreen on headless machine
+
+#include <QGuiApplication>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include "datagrouprecorder.h"
+#include "dldecoder.h"
+#include "motdecoder.h"
+#include "slideshowapp.h"
+#include "spiapp.h"
+
+#define BENCHMARK_DURATION_MS   (1000)
+
+Q_LOGGING_CATEGORY(metadataManager, "MetadataManager", QtWarningMsg)
+
+// heap allocations are counted for whole process
+static std::atomic<uint64_t> numAllocations(0);
+
+void * operator new(std::size_t size)
+{
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void * ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+struct Result
+{
+    double dataGroupsPerSec;
+    double bytesPerSec;
+    double allocationsPerDataGroup;
+};
+
+struct Corpus
+{
+    QList<QByteArray> dataGroups;
+    QList<quint16> SCIds;
+    qint64 numBytes = 0;
+};
+
+// replays corpus repeatedly for given duration, fcn processes whole corpus once
+template<typename F> static Result runDecoder(F fcn, const Corpus & corpus, int durationMs)
+{
+    fcn();  // warm up
+    QCoreApplication::processEvents();
+
+    uint64_t numPasses = 0;
+    uint64_t allocations = numAllocations.load();
+    auto start = std::chrono::steady_clock::now();
+    auto stop = start + std::chrono::milliseconds(durationMs);
+    auto now = start;
+    do
+    {
+        fcn();
+        numPasses += 1;
+        now = std::chrono::steady_clock::now();
+    } while (now < stop);
+    allocations = numAllocations.load() - allocations;
+
+    double sec = std::chrono::duration<double>(now - start).count();
+    double numDataGroups = double(numPasses) * corpus.dataGroups.size();
+    QCoreApplication::processEvents();
+
+    return { numDataGroups / sec, numPasses * corpus.numBytes / sec, allocations / numDataGroups };
+}
+
+static void printResult(QTextStream & out, const QString & name, const Result & res)
+{
+    out << name.leftJustified(32)
+        << QString::number(res.dataGroupsPerSec * 1e-3, 'f', 1).rightJustified(10) << " kDG/s"
+        << QString::number(res.bytesPerSec * 1e-6, 'f', 2).rightJustified(10) << " MB/s"
+        << QString::number(res.allocationsPerDataGroup, 'f', 1).rightJustified(10) << " alloc/DG\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication a(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList args = a.arguments();
+    if (args.size() < 2)
+    {
+        out << "usage: " << QFileInfo(args.at(0)).fileName() << " <recording> [duration_ms]\n";
+        return 1;
+    }
+
+    int durationMs = BENCHMARK_DURATION_MS;
+    if (args.size() > 2)
+    {
+        durationMs = std::max(100, args.at(2).toInt());
+    }
+
+    // recording is loaded to memory first so that storage is not measured
+    QList<DataGroupRecorder::Record> records;
+    if (!DataGroupRecorder::load(args.at(1), records))
+    {
+        out << "Unable to load recording " << args.at(1) << "\n";
+        return 1;
+    }
+
+    // SPI is decoded only for service, the same as in application
+    Corpus dl, sls, spi;
+    for (const auto & rec : std::as_const(records))
+    {
+        Corpus * corpus = nullptr;
+        if (DataGroupRecorder::Type::DynamicLabel == rec.type)
+        {
+            corpus = &dl;
+        }
+        else if (DabUserApplicationType::SlideShow == static_cast<DabUserApplicationType>(rec.userAppType))
+        {
+            corpus = &sls;
+        }
+        else if ((DabUserApplicationType::SPI == static_cast<DabUserApplicationType>(rec.userAppType)) && (0 == rec.instance))
+        {
+            corpus = &spi;
+        }
+        else
+        {   // not supported
+            continue;
+        }
+        corpus->dataGroups.append(rec.data);
+        corpus->SCIds.append(rec.SCId);
+        corpus->numBytes += rec.data.size();
+    }
+    out << "Recording: " << records.size() << " records, DL " << dl.dataGroups.size() << ", SLS " << sls.dataGroups.size()
+        << ", SPI " << spi.dataGroups.size() << " data groups\n";
+
+    out << QString("Decoder").leftJustified(32) << QString("Throughput").rightJustified(16)
+        << QString("Allocations").rightJustified(28) << "\n";
+
+    if (!dl.dataGroups.isEmpty())
+    {
+        printResult(out, "DLDecoder", runDecoder([&]() {
+            DLDecoder decoder;
+            for (const auto & dg : std::as_const(dl.dataGroups))
+            {
+                decoder.newDataGroup(dg);
+            }
+        }, dl, durationMs));
+    }
+
+    // MOT decoder only and complete application including slide processing
+    for (const Corpus * corpus : { &sls, &spi })
+    {
+        if (corpus->dataGroups.isEmpty())
+        {
+            continue;
+        }
+        QString name = (corpus == &sls) ? "SLS" : "SPI";
+        printResult(out, "MOTDecoder [" + name + "]", runDecoder([&]() {
+            MOTDecoder decoder;
+            for (const auto & dg : std::as_const(corpus->dataGroups))
+            {
+                decoder.newDataGroup(dg);
+            }
+        }, *corpus, durationMs));
+    }
+
+    if (!sls.dataGroups.isEmpty())
+    {
+        RadioControlUserAppData data = { };
+        data.userAppType = DabUserApplicationType::SlideShow;
+        printResult(out, "SlideShowApp", runDecoder([&]() {
+            SlideShowApp app;
+            app.setObjectStoreEnabled(false);
+            app.start();
+            for (const auto & dg : std::as_const(sls.dataGroups))
+            {
+                data.data = dg;
+                app.onUserAppData(data);
+            }
+        }, sls, durationMs));
+    }
+
+    if (!spi.dataGroups.isEmpty())
+    {
+        RadioControlUserAppData data = { };
+        data.userAppType = DabUserApplicationType::SPI;
+        printResult(out, "SPIApp", runDecoder([&]() {
+            SPIApp app;
+            app.setObjectStoreEnabled(false);
+            app.start();
+            for (int n = 0; n < spi.dataGroups.size(); ++n)
+            {   // MOT decoder is created for each data channel
+                data.SCId = spi.SCIds.at(n);
+                data.data = spi.dataGroups.at(n);
+                app.onUserAppData(data);
+            }
+        }, spi, durationMs));
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Benchmark of input sample processing hot loops
+//   usage: AbracaDABraBench [duration_ms]
+// results are in IQ samples per second on single core, each kernel is processing one input chunk at a time
+
+#include <QCoreApplication>
+#include <QTextStream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "inputdevice.h"
+#include "inputdevicesrc.h"
+#include "inputdevicekernels.h"
+
+#define BENCHMARK_DURATION_MS   (1000)
+#define BENCHMARK_BLOCK_IQ      (16*16384)      // samples processed in one call (RTL-SDR transfer size)
+#define BENCHMARK_SYMBOL_IQ     (2552)          // samples read by demodulator in one call (T_S)
+
+// runs fcn repeatedly for given duration, fcn returns number of processed IQ samples
+template<typename F> static double runKernel(F fcn, int durationMs)
+{
+    fcn();  // warm up
+
+    auto start = std::chrono::steady_clock::now();
+    auto stop = start + std::chrono::milliseconds(durationMs);
+    uint64_t numSamples = 0;
+    auto now = start;
+    do
+    {
+        numSamples += fcn();
+        now = std::chrono::steady_clock::now();
+    } while (now < stop);
+
+    return numSamples / std::chrono::duration<double>(now - start).count();
+}
+
+static void printResult(QTextStream & out, const QString & name, double samplesPerSec)
+{
+    out << name.leftJustified(40) << QString::number(samplesPerSec * 1e-6, 'f', 2).rightJustified(10) << " MS/s"
+        << QString::number(samplesPerSec / 2048e3, 'f', 1).rightJustified(10) << " x realtime\n";
+    out.flush();
+}
+
+static void benchmarkConvertU8(QTextStream & out, int durationMs)
+{
+    std::vector<uint8_t> in(2*BENCHMARK_BLOCK_IQ);
+    std::vector<float> outData(2*BENCHMARK_BLOCK_IQ);
+    for (auto & val : in)
+    {
+        val = std::rand() & 0xFF;
+    }
+    const float dc[2] = { 0.1f, -0.1f };
+    float level = 0.0;
+
+    double rate = runKernel([&]() {
+        int32_t sum[2] = { 0, 0 };
+        InputDeviceKernels::convertU8(in.data(), outData.data(), 2*BENCHMARK_BLOCK_IQ, dc, sum, level, 0.01f, 0.0001f);
+        return BENCHMARK_BLOCK_IQ;
+    }, durationMs);
+    printResult(out, QString("convertU8 [%1]").arg(InputDeviceKernels::implementationName()), rate);
+}
+
+static void benchmarkSRC(QTextStream & out, const QString & name, float inputSampleRate, bool s16, int durationMs)
+{
+    InputDeviceSRC src(inputSampleRate);
+    if (s16 && !src.hasS16Input())
+    {
+        out << name.leftJustified(40) << "not supported\n";
+        return;
+    }
+
+    std::vector<float> inF(2*BENCHMARK_BLOCK_IQ);
+    std::vector<int16_t> inS16(2*BENCHMARK_BLOCK_IQ);
+    std::vector<float> outData(2*BENCHMARK_BLOCK_IQ);
+    for (int n = 0; n < 2*BENCHMARK_BLOCK_IQ; ++n)
+    {
+        float val = std::sin(n * 0.01f) * 0.5f + (std::rand() % 1000) * 1e-4f;
+        inF[n] = val;
+        inS16[n] = int16_t(val * 16384);
+    }
+
+    double rate = runKernel([&]() {
+        if (s16)
+        {
+            src.process(inS16.data(), BENCHMARK_BLOCK_IQ, outData.data());
+        }
+        else
+        {
+            src.process(inF.data(), BENCHMARK_BLOCK_IQ, outData.data());
+        }
+        return BENCHMARK_BLOCK_IQ;
+    }, durationMs);
+    printResult(out, name, rate);
+}
+
+static void benchmarkFifo(QTextStream & out, int durationMs)
+{
+    // FIFO of receiver 0, the same as used by InputDevice
+    fifo_t & inputBuffer = *inputFifo(0);
+
+    // producer fills FIFO as fast as possible, consumer reads symbols like demodulator does
+    std::atomic<bool> stop(false);
+    std::thread producer([&]() {
+        const uint64_t bytes = BENCHMARK_BLOCK_IQ * 2 * sizeof(float);
+        while (!stop)
+        {
+            inputBuffer.waitForSpace(bytes);
+            std::memset(inputBuffer.reserve(), 0, bytes);
+            inputBuffer.commitWrite(bytes);
+        }
+    });
+
+    std::vector<float> buffer(2*BENCHMARK_SYMBOL_IQ);
+    double rate = runKernel([&]() {
+        for (int n = 0; n < INPUT_CHUNK_IQ_SAMPLES / BENCHMARK_SYMBOL_IQ; ++n)
+        {
+            getSamples(buffer.data(), BENCHMARK_SYMBOL_IQ);
+        }
+        return INPUT_CHUNK_IQ_SAMPLES / BENCHMARK_SYMBOL_IQ * BENCHMARK_SYMBOL_IQ;
+    }, durationMs);
+
+    // free whole FIFO, producer is woken up if blocked and it finishes
+    stop = true;
+    inputBuffer.commitRead(inputBuffer.available());
+    producer.join();
+    inputBuffer.reset();
+
+    printResult(out, "FIFO getSamples (memset producer)", rate);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    int durationMs = BENCHMARK_DURATION_MS;
+    if (argc > 1)
+    {
+        durationMs = std::max(100, atoi(argv[1]));
+    }
+
+    QTextStream out(stdout);
+    out << QString("Kernel").leftJustified(40) << QString("Throughput").rightJustified(15) << "\n";
+
+    benchmarkConvertU8(out, durationMs);
+    benchmarkSRC(out, "SRC DS2 4096kHz [float]", 4096e3, false, durationMs);
+    benchmarkSRC(out, "SRC DS2 4096kHz [int16]", 4096e3, true, durationMs);
+    benchmarkSRC(out, "SRC Farrow 2500kHz [float]", 2500e3, false, durationMs);
+    benchmarkSRC(out, "SRC Farrow 3072kHz [float]", 3072e3, false, durationMs);
+    benchmarkSRC(out, "SRC Passthrough 2048kHz [float]", 2048e3, false, durationMs);
+    benchmarkFifo(out, durationMs);
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include "servicelistbenchmark.h"
+#include "servicelist.h"
+#include "metadatamanager.h"
+#include "slmodel.h"
+#include "sltreemodel.h"
+#include "slproxymodel.h"
+
+ServiceListBenchmark::ServiceListBenchmark(QObject *parent) : QObject{parent}
+{}
+
+int ServiceListBenchmark::run(const QList<int> &numServices, int ensemblesPerService)
+{
+    // every added service is logged otherwise
+    QLoggingCategory::setFilterRules("ServiceList.info=false");
+
+    QTextStream out(stdout);
+    out << "Ensembles per service: " << ensemblesPerService << ", services per ensemble: " << SERVICELISTBENCHMARK_SERVICES_PER_ENSEMBLE << "\n";
+    out << QString("Services").leftJustified(10) << QString("Operation").leftJustified(36) << QString("Time [ms]").rightJustified(12) << "\n";
+    out.flush();
+    for (int n : numServices)
+    {
+        if (n > 0)
+        {
+            runSize(n, std::max(1, ensemblesPerService));
+        }
+    }
+    return 0;
+}
+
+void ServiceListBenchmark::fill(ServiceList *serviceList, int numServices, int ensemblesPerService) const
+{
+    // services of one ensemble are consecutive, every service is carried by ensemblesPerService ensembles
+    int numGroups = (numServices + SERVICELISTBENCHMARK_SERVICES_PER_ENSEMBLE - 1) / SERVICELISTBENCHMARK_SERVICES_PER_ENSEMBLE;
+    RadioControlServiceComponent s = { };
+    s.TMId = DabTMId::StreamAudio;
+    s.streamAudioData.scType = DabAudioDataSCty::DABPLUS_AUDIO;
+    s.streamAudioData.bitRate = 96;
+    s.ps = 1;
+
+    for (int site = 0; site < ensemblesPerService; ++site)
+    {
+        for (int g = 0; g < numGroups; ++g)
+        {
+            RadioControlEnsemble ens = { };
+            int ensIdx = site * numGroups + g;
+            ens.frequency = 174928 + 1712 * (ensIdx % 38);
+            ens.ueid = ((0xE0 + (ensIdx >> 12)) << 16) | (0xC000 + (ensIdx & 0x0FFF));
+            ens.label = QString("Ensemble %1").arg(ensIdx);
+            ens.labelShort = QString("Ens%1").arg(ensIdx);
+
+            serviceList->beginEnsembleUpdate(ens);
+            for (int n = g * SERVICELISTBENCHMARK_SERVICES_PER_ENSEMBLE; n < std::min(numServices, (g + 1) * SERVICELISTBENCHMARK_SERVICES_PER_ENSEMBLE); ++n)
+            {   // programme SId, ECC distinguishes more than 4096 services
+                s.SId.set(((0xE0 + (n >> 12)) << 16) | (0x2000 + (n & 0x0FFF)));
+                s.SCIdS = 0;
+                s.SubChId = n % SERVICELISTBENCHMARK_SERVICES_PER_ENSEMBLE;
+                s.label = QString("Service %1").arg(n, 5, 10, QChar('0'));
+                s.labelShort = QString("S%1").arg(n);
+                s.pty.s = n % 32;
+                serviceList->addService(ens, s);
+            }
+            serviceList->endEnsembleUpdate(ens);
+        }
+    }
+}
+
+void ServiceListBenchmark::runSize(int numServices, int ensemblesPerService)
+{
+    QTextStream out(stdout);
+    QElapsedTimer timer;
+    auto report = [&](const QString & operation) {
+        out << QString::number(numServices).leftJustified(10) << operation.leftJustified(36)
+            << QString::number(timer.nsecsElapsed() * 1e-6, 'f', 1).rightJustified(12) << "\n";
+        out.flush();
+    };
+
+    // service list alone
+    {
+        ServiceList serviceList;
+        timer.start();
+        fill(&serviceList, numServices, ensemblesPerService);
+        report("ServiceList::addService");
+    }
+
+    // complete stack connected the same way as in MainWindow
+    QTemporaryDir dir;
+    QSettings settings(dir.filePath("benchmark.ini"), QSettings::IniFormat);
+    ServiceList serviceList;
+    MetadataManager metadataManager(&serviceList);
+    SLModel slModel(&serviceList, &metadataManager);
+    connect(&serviceList, &ServiceList::serviceAdded, &slModel, &SLModel::addService);
+    connect(&serviceList, &ServiceList::serviceUpdated, &slModel, &SLModel::updateService);
+    connect(&serviceList, &ServiceList::serviceRemoved, &slModel, &SLModel::removeService);
+    connect(&serviceList, &ServiceList::serviceAddedToEnsemble, &slModel, &SLModel::serviceAddedToEnsemble);
+    connect(&serviceList, &ServiceList::serviceRemovedFromEnsemble, &slModel, &SLModel::serviceRemovedFromEnsemble);
+    connect(&serviceList, &ServiceList::empty, &slModel, &SLModel::clear);
+    connect(&serviceList, &ServiceList::updateStarted, &slModel, &SLModel::beginUpdate);
+    connect(&serviceList, &ServiceList::updateFinished, &slModel, &SLModel::endUpdate);
+    SLTreeModel slTreeModel(&serviceList, &metadataManager);
+    connect(&serviceList, &ServiceList::serviceAddedToEnsemble, &slTreeModel, &SLTreeModel::addEnsembleService);
+    connect(&serviceList, &ServiceList::serviceUpdatedInEnsemble, &slTreeModel, &SLTreeModel::updateEnsembleService);
+    connect(&serviceList, &ServiceList::serviceRemovedFromEnsemble, &slTreeModel, &SLTreeModel::removeEnsembleService);
+    connect(&serviceList, &ServiceList::ensembleRemoved, &slTreeModel, &SLTreeModel::removeEnsemble);
+    connect(&serviceList, &ServiceList::empty, &slTreeModel, &SLTreeModel::clear);
+    connect(&serviceList, &ServiceList::updateStarted, &slTreeModel, &SLTreeModel::beginUpdate);
+    connect(&serviceList, &ServiceList::updateFinished, &slTreeModel, &SLTreeModel::endUpdate);
+    SLProxyModel proxyModel;
+    proxyModel.setSourceModel(&slModel);
+
+    timer.start();
+    fill(&serviceList, numServices, ensemblesPerService);
+    report("addService + SLModel + SLTreeModel");
+
+    timer.start();
+    slModel.sort(0, Qt::AscendingOrder);
+    report("SLModel::sort");
+    timer.start();
+    slModel.sort(0, Qt::DescendingOrder);
+    report("SLModel::sort [reverse]");
+    timer.start();
+    slTreeModel.sort(0, Qt::AscendingOrder);
+    report("SLTreeModel::sort");
+
+    // filtering by ensemble in the middle of the list, then back to all services
+    int ueid = 0;
+    int idx = 0;
+    for (auto it = serviceList.ensembleListBegin(); it != serviceList.ensembleListEnd(); ++it)
+    {
+        if (idx++ == serviceList.numEnsembles() / 2)
+        {
+            ueid = (*it)->ueid();
+            break;
+        }
+    }
+    timer.start();
+    proxyModel.setUeidFilter(ueid);
+    report(QString("SLProxyModel ensemble [%1 rows]").arg(proxyModel.rowCount()));
+    timer.start();
+    proxyModel.setUeidFilter(0);
+    report(QString("SLProxyModel all [%1 rows]").arg(proxyModel.rowCount()));
+    timer.start();
+    proxyModel.setEmptyEpgFilter(true);
+    report(QString("SLProxyModel EPG [%1 rows]").arg(proxyModel.rowCount()));
+    proxyModel.setEmptyEpgFilter(false);
+
+    timer.start();
+    serviceList.save(settings);
+    settings.sync();
+    report("ServiceList::save");
+
+    serviceList.clear();
+    timer.start();
+    serviceList.load(settings);
+    report(QString("ServiceList::load + models [%1 services]").arg(serviceList.numServices()));
+}
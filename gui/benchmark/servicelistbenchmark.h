@@ -0,0 +1,56 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SERVICELISTBENCHMARK_H
+#define SERVICELISTBENCHMARK_H
+
+#include <QObject>
+#include <QList>
+
+#define SERVICELISTBENCHMARK_SERVICES_PER_ENSEMBLE  (16)   // services carried by one synthetic ensemble
+#define SERVICELISTBENCHMARK_ENSEMBLES_PER_SERVICE  (4)    // transmitter sites carrying the same service
+
+class ServiceList;
+class MetadataManager;
+
+// scalability benchmark of service list stack using synthetic bouquets
+// every service is carried by several ensembles, sizes are numbers of services
+// reports time of ServiceList::addService(), save() and load(), model insertion, sort and proxy filtering
+class ServiceListBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ServiceListBenchmark(QObject *parent = nullptr);
+
+    // returns exit code
+    int run(const QList<int> & numServices, int ensemblesPerService = SERVICELISTBENCHMARK_ENSEMBLES_PER_SERVICE);
+
+private:
+    void runSize(int numServices, int ensemblesPerService);
+    void fill(ServiceList * serviceList, int numServices, int ensemblesPerService) const;
+};
+
+#endif // SERVICELISTBENCHMARK_H
@@ -0,0 +1,166 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Benchmark of binary SPI decoding on corpus of real objects (files dumped by SPI application)
+//   usage: AbracaDABraSpiBench <directory> [duration_ms]
+// every file in directory is decoded as binary programme information, results are in MB/s on single core
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include "spiepgdecoder.h"
+
+#define BENCHMARK_DURATION_MS   (1000)
+
+Q_LOGGING_CATEGORY(spiApp, "SPIApp", QtWarningMsg)
+Q_LOGGING_CATEGORY(metadataManager, "MetadataManager", QtWarningMsg)
+
+// runs fcn repeatedly for given duration, fcn returns number of processed bytes
+template<typename F> static double runDecoder(F fcn, int durationMs)
+{
+    fcn();  // warm up
+
+    auto start = std::chrono::steady_clock::now();
+    auto stop = start + std::chrono::milliseconds(durationMs);
+    uint64_t numBytes = 0;
+    auto now = start;
+    do
+    {
+        numBytes += fcn();
+        now = std::chrono::steady_clock::now();
+    } while (now < stop);
+
+    return numBytes / std::chrono::duration<double>(now - start).count();
+}
+
+static void printResult(QTextStream & out, const QString & name, double bytesPerSec)
+{
+    out << name.leftJustified(40) << QString::number(bytesPerSec * 1e-6, 'f', 2).rightJustified(10) << " MB/s\n";
+    out.flush();
+}
+
+static void benchmarkTokens(QTextStream & out, int durationMs)
+{   // typical tokenized programme description
+    const QByteArray token1("Radio Programme ");
+    const QByteArray token2(" with the latest news and weather ");
+    SPITokenTable table;
+    table.insert(0x01, (const uint8_t *) token1.constData(), token1.size());
+    table.insert(0x02, (const uint8_t *) token2.constData(), token2.size());
+    QByteArray str;
+    for (int n = 0; n < 8; ++n)
+    {
+        str.append("\x01Morning show\x02 and music ");
+    }
+    QByteArray plain(str.size(), 'x');
+
+    printResult(out, "Token expansion [tokenized]", runDecoder([&]() {
+        uint64_t bytes = 0;
+        for (int n = 0; n < 1000; ++n)
+        {
+            bytes += table.getString((const uint8_t *) str.constData(), str.size()).size();
+        }
+        return bytes;
+    }, durationMs));
+    printResult(out, "Token expansion [no token]", runDecoder([&]() {
+        uint64_t bytes = 0;
+        for (int n = 0; n < 1000; ++n)
+        {
+            bytes += table.getString((const uint8_t *) plain.constData(), plain.size()).size();
+        }
+        return bytes;
+    }, durationMs));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+
+    if (argc < 2)
+    {
+        out << "usage: " << QFileInfo(argv[0]).fileName() << " <directory> [duration_ms]\n";
+        return 1;
+    }
+
+    int durationMs = BENCHMARK_DURATION_MS;
+    if (argc > 2)
+    {
+        durationMs = std::max(100, atoi(argv[2]));
+    }
+
+    // corpus is loaded to memory first so that storage is not measured
+    QList<QByteArray> corpus;
+    qint64 corpusBytes = 0;
+    QDir directory(argv[1]);
+    const QStringList files = directory.entryList(QDir::Files);
+    for (const QString & fileName : files)
+    {
+        QFile file(directory.absoluteFilePath(fileName));
+        if (file.open(QIODevice::ReadOnly))
+        {
+            corpus.append(file.readAll());
+            corpusBytes += corpus.last().size();
+        }
+    }
+
+    out << QString("Decoder").leftJustified(40) << QString("Throughput").rightJustified(15) << "\n";
+    benchmarkTokens(out, durationMs);
+
+    if (corpus.isEmpty())
+    {
+        out << "No files found in " << argv[1] << "\n";
+        return 1;
+    }
+
+    SPIEpgDecoder decoder;
+    int numProgrammes = 0;
+    for (const auto & data : std::as_const(corpus))
+    {
+        const auto scheduleList = decoder.decode(data, QString(), QDateTime());
+        for (const auto & schedule : scheduleList)
+        {
+            numProgrammes += schedule.items.size();
+        }
+    }
+    out << "Corpus: " << corpus.size() << " files, " << corpusBytes << " bytes, " << numProgrammes << " programmes\n";
+
+    printResult(out, "Binary PI decoding", runDecoder([&]() {
+        for (const auto & data : std::as_const(corpus))
+        {
+            decoder.decode(data, QString(), QDateTime());
+        }
+        return corpusBytes;
+    }, durationMs));
+
+    return 0;
+}
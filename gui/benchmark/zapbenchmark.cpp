@@ -0,0 +1,377 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTextStream>
+#include <QLoggingCategory>
+
+#include "zapbenchmark.h"
+#include "audiodecoder.h"
+#include "audiorecorder.h"
+#include "slideshowapp.h"
+
+Q_LOGGING_CATEGORY(zapBenchmark, "ZapBenchmark", QtInfoMsg)
+
+ZapBenchmark::ZapBenchmark(QObject *parent) : QObject(parent)
+{   // processing chain is created in start(), input FIFO must not be allocated before it is configured
+    m_chunkMs.append(InputDevice::fifoConfig().chunkMs);
+    m_numChunks.append(InputDevice::fifoConfig().numChunks);
+}
+
+ZapBenchmark::~ZapBenchmark()
+{
+    delete m_inputDevice;
+
+    if (nullptr != m_radioControlThread)
+    {
+        m_radioControlThread->quit();  // this deletes radioControl and slideshow
+        m_radioControlThread->wait();
+        delete m_radioControlThread;
+    }
+
+    if (nullptr != m_audioDecoderThread)
+    {
+        m_audioDecoderThread->quit();  // this deletes audiodecoder and recorder
+        m_audioDecoderThread->wait();
+        delete m_audioDecoderThread;
+    }
+
+    if (nullptr != m_audioDrain)
+    {
+        m_audioDrain->finish();
+    }
+}
+
+void ZapBenchmark::setInputConfigs(const QList<int> &chunkMs, const QList<int> &numChunks)
+{
+    if (!chunkMs.isEmpty())
+    {
+        m_chunkMs = chunkMs;
+    }
+    if (!numChunks.isEmpty())
+    {
+        m_numChunks = numChunks;
+    }
+}
+
+bool ZapBenchmark::start(const QStringList &arguments)
+{
+    if (m_files.isEmpty())
+    {
+        qCCritical(zapBenchmark) << "No input file";
+        return false;
+    }
+
+    if ((m_chunkMs.size() > 1) || (m_numChunks.size() > 1))
+    {   // every configuration runs in separate process
+        int exitCode = runChildren(arguments);
+        QMetaObject::invokeMethod(this, [this, exitCode]() { emit finished(exitCode); }, Qt::QueuedConnection);
+        return true;
+    }
+
+    InputFifoConfig config = InputDevice::fifoConfig();
+    config.chunkMs = m_chunkMs.at(0);
+    config.numChunks = m_numChunks.at(0);
+    InputDevice::setFifoConfig(config);
+
+    QTextStream out(stdout);
+    out << header() << Qt::endl;
+
+    return startMeasurement();
+}
+
+int ZapBenchmark::runChildren(const QStringList &arguments)
+{
+    // configuration lists are removed from arguments and replaced by single values
+    QStringList childArgs;
+    for (int n = 1; n < arguments.size(); ++n)
+    {
+        const QString & arg = arguments.at(n);
+        if ((arg == "--zap-chunk") || (arg == "--zap-fifo"))
+        {
+            n += 1;   // skip value
+        }
+        else if (arg.startsWith("--zap-chunk=") || arg.startsWith("--zap-fifo="))
+        { /* skip */ }
+        else
+        {
+            childArgs.append(arg);
+        }
+    }
+
+    QTextStream out(stdout);
+    out << header() << Qt::endl;
+
+    int exitCode = 0;
+    for (int chunkMs : std::as_const(m_chunkMs))
+    {
+        for (int numChunks : std::as_const(m_numChunks))
+        {
+            QProcess child;
+            child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+            child.start(QCoreApplication::applicationFilePath(), QStringList(childArgs)
+                                                                     << "--zap-chunk" << QString::number(chunkMs)
+                                                                     << "--zap-fifo" << QString::number(numChunks));
+            if (!child.waitForFinished(ZAPBENCHMARK_CHILD_TIMEOUT_MS))
+            {
+                qCWarning(zapBenchmark) << "Configuration" << chunkMs << "ms x" << numChunks << "did not finish";
+                child.kill();
+                child.waitForFinished();
+                exitCode = 1;
+                continue;
+            }
+
+            const QList<QByteArray> lines = child.readAllStandardOutput().split('\n');
+            for (const auto & line : lines)
+            {   // child header is skipped
+                if (!line.isEmpty() && !line.startsWith('#'))
+                {
+                    out << line << Qt::endl;
+                }
+            }
+            if ((QProcess::NormalExit != child.exitStatus()) || (0 != child.exitCode()))
+            {
+                exitCode = 1;
+            }
+        }
+    }
+    return exitCode;
+}
+
+bool ZapBenchmark::startMeasurement()
+{
+    m_radioControl = new RadioControl();
+    m_radioControlThread = new QThread(this);
+    m_radioControlThread->setObjectName("radioControlThr");
+    m_radioControl->moveToThread(m_radioControlThread);
+    connect(m_radioControlThread, &QThread::finished, m_radioControl, &QObject::deleteLater);
+    m_radioControlThread->start();
+
+    m_audioRecorder = new AudioRecorder();
+    m_audioDecoder = new AudioDecoder(m_audioRecorder);
+    m_audioDecoderThread = new QThread(this);
+    m_audioDecoderThread->setObjectName("audioDecoderThr");
+    m_audioDecoder->moveToThread(m_audioDecoderThread);
+    m_audioRecorder->moveToThread(m_audioDecoderThread);
+    connect(m_audioDecoderThread, &QThread::finished, m_audioDecoder, &QObject::deleteLater);
+    connect(m_audioDecoderThread, &QThread::finished, m_audioRecorder, &QObject::deleteLater);
+    m_audioDecoderThread->start();
+
+    m_audioDrain = new AudioFifoDrain(this);
+
+    m_slideShowApp = new SlideShowApp();
+    m_slideShowApp->setObjectStoreEnabled(false);
+    m_slideShowApp->moveToThread(m_radioControlThread);
+    connect(m_radioControlThread, &QThread::finished, m_slideShowApp, &QObject::deleteLater);
+
+    m_inputDevice = new RawFileInput();
+    m_inputDevice->setFastReplay(m_fastReplay);
+
+    if (!m_radioControl->init())
+    {
+        qCCritical(zapBenchmark) << "RadioControl() init failed";
+        return false;
+    }
+
+    // tuning procedure
+    connect(m_radioControl, &RadioControl::tuneInputDevice, m_inputDevice, &InputDevice::tune, Qt::QueuedConnection);
+    connect(m_inputDevice, &InputDevice::tuned, m_radioControl, &RadioControl::start, Qt::QueuedConnection);
+    connect(m_inputDevice, &InputDevice::error, this, &ZapBenchmark::onInputDeviceError, Qt::QueuedConnection);
+    connect(this, &ZapBenchmark::serviceRequest, m_radioControl, &RadioControl::tuneService, Qt::QueuedConnection);
+    connect(this, &ZapBenchmark::exit, m_radioControl, &RadioControl::exit, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::tuneDone, this, &ZapBenchmark::onTuneDone, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::signalState, this, &ZapBenchmark::onSignalState, Qt::QueuedConnection);
+
+    // milestones
+    connect(m_radioControl, &RadioControl::ensembleInformation, this, [this]() { setMilestone(MilestoneEnsemble); }, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::serviceListEntry, this, &ZapBenchmark::onServiceListEntry, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::serviceListComplete, this, &ZapBenchmark::onServiceListComplete, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::audioServiceSelection, this, [this]() { setMilestone(MilestoneService); }, Qt::QueuedConnection);
+    connect(m_audioDecoder, &AudioDecoder::startAudio, this, [this]() { setMilestone(MilestoneAudio); }, Qt::QueuedConnection);
+    connect(m_slideShowApp, &SlideShowApp::currentSlide, this, [this]() { setMilestone(MilestoneSlide); }, Qt::QueuedConnection);
+
+    // audio is decoded and discarded
+    connect(m_radioControl, &RadioControl::audioData, m_audioDecoder, &AudioDecoder::decodeData, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::audioServiceSelection, m_audioDecoder, &AudioDecoder::start, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::stopAudio, m_audioDecoder, &AudioDecoder::stop, Qt::QueuedConnection);
+    connect(m_audioDecoder, &AudioDecoder::startAudio, m_audioDrain, &AudioFifoDrain::start, Qt::QueuedConnection);
+    connect(m_audioDecoder, &AudioDecoder::switchAudio, m_audioDrain, &AudioFifoDrain::start, Qt::QueuedConnection);
+    connect(m_audioDecoder, &AudioDecoder::stopAudio, m_audioDrain, &AudioFifoDrain::stop, Qt::QueuedConnection);
+
+    // slideshow
+    connect(m_radioControl, &RadioControl::audioServiceSelection, m_slideShowApp, &SlideShowApp::start);
+    connect(m_radioControl, &RadioControl::userAppData_Service, m_slideShowApp, &SlideShowApp::onUserAppData);
+    connect(m_radioControl, &RadioControl::ensembleInformation, m_slideShowApp, &UserApplication::setEnsId);
+    connect(m_radioControl, &RadioControl::audioServiceSelection, m_slideShowApp, &UserApplication::setAudioServiceId);
+
+    m_timeoutTimer = new QTimer(this);
+    m_timeoutTimer->setSingleShot(true);
+    connect(m_timeoutTimer, &QTimer::timeout, this, &ZapBenchmark::finishFile);
+
+    nextFile();
+
+    return true;
+}
+
+void ZapBenchmark::nextFile()
+{
+    m_fileIdx += 1;
+    if (m_fileIdx >= m_files.size())
+    {   // all files measured
+        m_exitRequested = true;
+        emit exit();
+        emit finished(0);
+        return;
+    }
+
+    m_inputDevice->setFile(m_files.at(m_fileIdx), m_sampleFormat);
+    if (!m_inputDevice->openDevice())
+    {
+        nextFile();
+        return;
+    }
+
+    const InputDeviceDescription & desc = m_inputDevice->deviceDescription();
+    // XML or WAV header overrides format from command line, it is applied when file is opened
+    m_frequency = (desc.rawFile.frequency_kHz > 0) ? desc.rawFile.frequency_kHz : ZAPBENCHMARK_FREQ_DEFAULT;
+
+    for (int m = 0; m < MilestoneNum; ++m)
+    {
+        m_milestone[m] = -1;
+    }
+    m_firstAudioSId = 0;
+    m_currentSId = m_requestedSId;
+    m_measuring = true;
+    m_timeoutTimer->start(ZAPBENCHMARK_TIMEOUT_MS);
+    m_elapsedTimer.start();
+
+    // service is selected when service list is complete if not requested
+    emit serviceRequest(m_frequency, m_requestedSId, 0);
+}
+
+void ZapBenchmark::finishFile()
+{
+    if (!m_measuring)
+    {
+        return;
+    }
+    m_measuring = false;
+    m_timeoutTimer->stop();
+
+    QTextStream out(stdout);
+    out << QFileInfo(m_files.at(m_fileIdx)).fileName() << '\t'
+        << InputDevice::fifoConfig().chunkMs << '\t'
+        << InputDevice::fifoConfig().numChunks;
+    for (int m = 0; m < MilestoneNum; ++m)
+    {   // missing milestone is reported as "-"
+        out << '\t' << ((m_milestone[m] >= 0) ? QString::number(m_milestone[m]) : QString("-"));
+    }
+    out << Qt::endl;
+
+    // going to idle, next file is started when tuning is done
+    emit serviceRequest(0, 0, 0);
+}
+
+void ZapBenchmark::setMilestone(Milestone m)
+{
+    if (m_measuring && (m_milestone[m] < 0))
+    {
+        m_milestone[m] = m_elapsedTimer.elapsed();
+
+        if ((m_milestone[MilestoneAudio] >= 0) && (m_milestone[MilestoneSlide] >= 0))
+        {   // all milestones reached (audio implies ensemble info and service)
+            finishFile();
+        }
+    }
+}
+
+void ZapBenchmark::onTuneDone(uint32_t freq)
+{
+    if (0 == freq)
+    {
+        if (!m_measuring && !m_exitRequested)
+        {   // previous file finished
+            nextFile();
+        }
+    }
+    else
+    {
+        setMilestone(MilestoneTune);
+    }
+}
+
+void ZapBenchmark::onSignalState(uint8_t sync, float snr)
+{
+    Q_UNUSED(snr);
+    if (uint8_t(DabSyncLevel::FullSync) == sync)
+    {
+        setMilestone(MilestoneSync);
+    }
+}
+
+void ZapBenchmark::onServiceListEntry(const RadioControlEnsemble &ens, const RadioControlServiceComponent &s)
+{
+    Q_UNUSED(ens);
+    if (m_measuring && (0 == m_firstAudioSId) && s.isAudioService() && (s.SCIdS == 0))
+    {
+        m_firstAudioSId = s.SId.value();
+    }
+}
+
+void ZapBenchmark::onServiceListComplete(const RadioControlEnsemble &ens)
+{
+    Q_UNUSED(ens);
+    if (m_measuring && (0 == m_currentSId))
+    {   // service was not requested, first audio service is selected
+        if (0 != m_firstAudioSId)
+        {
+            m_currentSId = m_firstAudioSId;
+            emit serviceRequest(m_frequency, m_currentSId, 0);
+        }
+        else
+        {
+            qCWarning(zapBenchmark) << "No audio service found in" << m_files.at(m_fileIdx);
+        }
+    }
+    else { /* service already selected */ }
+}
+
+void ZapBenchmark::onInputDeviceError(const InputDeviceErrorCode errCode)
+{
+    if (InputDeviceErrorCode::EndOfFile != errCode)
+    {
+        qCWarning(zapBenchmark) << "Input device error:" << int(errCode);
+    }
+    else { /* file is shorter than measurement */ }
+    finishFile();
+}
+
+QString ZapBenchmark::header()
+{
+    return QString("# file\tchunk_ms\tfifo_chunks\ttune_ms\tsync_ms\tensemble_ms\tservice_ms\taudio_ms\tslide_ms");
+}
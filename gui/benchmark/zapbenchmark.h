@@ -0,0 +1,130 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef ZAPBENCHMARK_H
+#define ZAPBENCHMARK_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include "radiocontrol.h"
+#include "audiofifo.h"
+#include "inputdevice.h"
+#include "rawfileinput.h"
+
+#define ZAPBENCHMARK_FREQ_DEFAULT       227360   // used when raw file does not contain frequency [kHz]
+#define ZAPBENCHMARK_TIMEOUT_MS        (30000)   // measurement of one file is finished after this time
+#define ZAPBENCHMARK_CHILD_TIMEOUT_MS (600000)   // maximum duration of one input configuration run
+
+class AudioDecoder;
+class AudioRecorder;
+class SlideShowApp;
+
+// zapping latency benchmark
+// raw files are replayed one by one through RawFileInput -> RadioControl -> AudioDecoder and time
+// from tune request to sync, ensemble information, service selection, first audio and first slide is reported
+// input FIFO can be configured only once per process => every input configuration runs in child process
+class ZapBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ZapBenchmark(QObject *parent = nullptr);
+    ~ZapBenchmark();
+    void setFiles(const QStringList & files) { m_files = files; }
+    void setFileFormat(const RawFileInputFormat & sampleFormat) { m_sampleFormat = sampleFormat; }
+    void setService(uint32_t SId) { m_requestedSId = SId; }
+    void setFastReplay(bool ena) { m_fastReplay = ena; }
+
+    // lists of input chunk sizes [ms] and FIFO capacities [chunks], all combinations are measured
+    void setInputConfigs(const QList<int> & chunkMs, const QList<int> & numChunks);
+
+    // returns false if benchmark cannot be started, finished() is emitted at the end otherwise
+    bool start(const QStringList & arguments);
+
+signals:
+    void serviceRequest(uint32_t freq, uint32_t SId, uint8_t SCIdS);
+    void exit();
+    void finished(int exitCode);
+
+private:
+    enum Milestone
+    {
+        MilestoneTune = 0,
+        MilestoneSync,
+        MilestoneEnsemble,
+        MilestoneService,
+        MilestoneAudio,
+        MilestoneSlide,
+        MilestoneNum
+    };
+
+    QStringList m_files;
+    RawFileInputFormat m_sampleFormat = RawFileInputFormat::SAMPLE_FORMAT_U8;
+    uint32_t m_requestedSId = 0;
+    bool m_fastReplay = false;
+    QList<int> m_chunkMs;
+    QList<int> m_numChunks;
+
+    QThread * m_radioControlThread = nullptr;
+    QThread * m_audioDecoderThread = nullptr;
+    RadioControl * m_radioControl = nullptr;
+    AudioDecoder * m_audioDecoder = nullptr;
+    AudioRecorder * m_audioRecorder = nullptr;
+    AudioFifoDrain * m_audioDrain = nullptr;
+    SlideShowApp * m_slideShowApp = nullptr;
+    RawFileInput * m_inputDevice = nullptr;
+    QTimer * m_timeoutTimer = nullptr;
+
+    int m_fileIdx = -1;
+    uint32_t m_frequency = 0;
+    uint32_t m_currentSId = 0;
+    uint32_t m_firstAudioSId = 0;
+    bool m_measuring = false;
+    bool m_exitRequested = false;
+    qint64 m_milestone[MilestoneNum];
+    QElapsedTimer m_elapsedTimer;
+
+    // parent process
+    int runChildren(const QStringList & arguments);
+
+    // child process
+    bool startMeasurement();
+    void nextFile();
+    void finishFile();
+    void setMilestone(Milestone m);
+    void onTuneDone(uint32_t freq);
+    void onSignalState(uint8_t sync, float snr);
+    void onServiceListEntry(const RadioControlEnsemble & ens, const RadioControlServiceComponent & s);
+    void onServiceListComplete(const RadioControlEnsemble & ens);
+    void onInputDeviceError(const InputDeviceErrorCode errCode);
+
+    static QString header();
+};
+
+#endif // ZAPBENCHMARK_H
@@ -0,0 +1,156 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <limits>
+#include "coarseclock.h"
+
+CoarseClock* CoarseClock::m_instancePtr = nullptr;
+
+CoarseClock *CoarseClock::getInstance()
+{
+    if (m_instancePtr == nullptr)
+    {
+        m_instancePtr = new CoarseClock();
+        return m_instancePtr;
+    }
+    else
+    {
+        return m_instancePtr;
+    }
+}
+
+CoarseClock::CoarseClock() : QObject(nullptr)
+{
+    m_elapsed.start();
+    m_dabTimeMs = 0;
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &CoarseClock::onTimeout);
+}
+
+void CoarseClock::start(QObject *owner, int intervalMs, const std::function<void()> &callback, int slackMs)
+{
+    Q_ASSERT(owner->thread() == thread());
+
+    if (!m_subscribers.contains(owner))
+    {
+        connect(owner, &QObject::destroyed, this, [this, owner]() { stop(owner); });
+    }
+    else { /* replacing deadline */ }
+
+    m_subscribers[owner] = { nowMs() + intervalMs, intervalMs, qMax(0, slackMs), callback };
+    reschedule();
+}
+
+void CoarseClock::stop(QObject *owner)
+{
+    if (m_subscribers.remove(owner))
+    {
+        disconnect(owner, &QObject::destroyed, this, nullptr);
+        reschedule();
+    }
+    else { /* not subscribed */ }
+}
+
+void CoarseClock::onDabTime(const QDateTime &d)
+{
+    m_dabTime = d;
+    m_dabTimeMs = nowMs();
+}
+
+QDateTime CoarseClock::dabTime() const
+{
+    if (m_dabTime.isValid())
+    {
+        return m_dabTime.addMSecs(nowMs() - m_dabTimeMs);
+    }
+    return QDateTime();
+}
+
+void CoarseClock::reschedule()
+{
+    if (m_subscribers.isEmpty())
+    {   // nothing is due, no wakeups
+        m_timer.stop();
+        return;
+    }
+
+    // wakeup is postponed as late as the tightest tolerance allows
+    qint64 wakeupMs = std::numeric_limits<qint64>::max();
+    int minSlackMs = std::numeric_limits<int>::max();
+    for (auto it = m_subscribers.cbegin(); it != m_subscribers.cend(); ++it)
+    {
+        wakeupMs = qMin(wakeupMs, it->deadlineMs + it->slackMs);
+        minSlackMs = qMin(minSlackMs, it->slackMs);
+    }
+
+    Qt::TimerType type = Qt::CoarseTimer;
+    if (0 == minSlackMs)
+    {
+        type = Qt::PreciseTimer;
+    }
+    else if (minSlackMs >= 1000)
+    {
+        type = Qt::VeryCoarseTimer;
+    }
+    else { /* coarse timer tolerance is 5% */ }
+
+    m_timer.setTimerType(type);
+    m_timer.start(static_cast<int>(qMax(qint64(0), wakeupMs - nowMs())));
+}
+
+void CoarseClock::onTimeout()
+{
+    // serve all subscribers due at this wakeup, including those within their tolerance
+    qint64 now = nowMs();
+    QList<QObject *> due;
+    for (auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it)
+    {
+        if (it->deadlineMs <= now + it->slackMs)
+        {
+            due.append(it.key());
+            if (0 == it->slackMs)
+            {   // precise subscriber keeps its phase
+                it->deadlineMs = qMax(it->deadlineMs + it->intervalMs, now);
+            }
+            else
+            {
+                it->deadlineMs = now + it->intervalMs;
+            }
+        }
+    }
+
+    // callbacks can start or stop subscriptions
+    for (QObject * owner : due)
+    {
+        auto it = m_subscribers.constFind(owner);
+        if (it != m_subscribers.cend())
+        {
+            std::function<void()> callback = it->callback;
+            callback();
+        }
+    }
+    reschedule();
+}
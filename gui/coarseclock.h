@@ -0,0 +1,84 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef COARSECLOCK_H
+#define COARSECLOCK_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <functional>
+
+#define COARSECLOCK_SLACK_MS  (1000)    // default tolerance of subscriber deadline
+
+// singleton class
+// shared clock of GUI thread, subscribers register repeating deadlines with tolerance
+// all deadlines that fit into the tolerance window of the earliest one are served by single wakeup
+// timer is stopped when nothing is scheduled
+// DAB time is extrapolated from last dabTime using monotonic clock
+class CoarseClock : public QObject
+{
+    Q_OBJECT
+public:
+    CoarseClock(const CoarseClock& obj) = delete;   // deleting copy constructor
+    static CoarseClock *getInstance();
+
+    // repeating deadline of owner, replaces previous one, semantics is the same as QBasicTimer::start()
+    // owner must live in GUI thread, subscription is removed when owner is destroyed
+    void start(QObject * owner, int intervalMs, const std::function<void()> & callback, int slackMs = COARSECLOCK_SLACK_MS);
+    void stop(QObject * owner);
+    bool isActive(QObject * owner) const { return m_subscribers.contains(owner); }
+
+    qint64 nowMs() const { return m_elapsed.elapsed(); }
+
+    void onDabTime(const QDateTime & d);
+    bool haveDabTime() const { return m_dabTime.isValid(); }
+    QDateTime dabTime() const;
+
+private:
+    CoarseClock();
+    void reschedule();
+    void onTimeout();
+
+    struct Subscriber
+    {
+        qint64 deadlineMs;
+        int intervalMs;
+        int slackMs;
+        std::function<void()> callback;
+    };
+
+    static CoarseClock * m_instancePtr;
+    QHash<QObject *, Subscriber> m_subscribers;
+    QTimer m_timer;
+    QElapsedTimer m_elapsed;
+    QDateTime m_dabTime;      // last received DAB time
+    qint64 m_dabTimeMs;       // monotonic time of m_dabTime
+};
+
+#endif // COARSECLOCK_H
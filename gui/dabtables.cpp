@@ -25,58 +25,136 @@
  */
 
 #include <QDebug>
+#include <QHash>
+#include <cstring>
+#include <string>
 #include "dabtables.h"
 
-const QMap<uint32_t, QString> DabTables::channelList =
+// DAB band III channels sorted by frequency
+struct DabChannel
 {
-    {174928 , "5A"},
-    {176640 , "5B"},
-    {178352 , "5C"},
-    {180064 , "5D"},
-    {181936 , "6A"},
-    {183648 , "6B"},
-    {185360 , "6C"},
-    {187072 , "6D"},
-    {188928 , "7A"},
-    {190640 , "7B"},
-    {192352 , "7C"},
-    {194064 , "7D"},
-    {195936 , "8A"},
-    {197648 , "8B"},
-    {199360 , "8C"},
-    {201072 , "8D"},
-    {202928 , "9A"},
-    {204640 , "9B"},
-    {206352 , "9C"},
-    {208064 , "9D"},
-    {209936 , "10A"},
-    {211648 , "10B"},
-    {213360 , "10C"},
-    {215072 , "10D"},
+    uint32_t frequency;     // kHz
+    char16_t name[4];
+};
+static constexpr DabChannel dabChannels[] =
+{
+    {174928 , u"5A"},
+    {176640 , u"5B"},
+    {178352 , u"5C"},
+    {180064 , u"5D"},
+    {181936 , u"6A"},
+    {183648 , u"6B"},
+    {185360 , u"6C"},
+    {187072 , u"6D"},
+    {188928 , u"7A"},
+    {190640 , u"7B"},
+    {192352 , u"7C"},
+    {194064 , u"7D"},
+    {195936 , u"8A"},
+    {197648 , u"8B"},
+    {199360 , u"8C"},
+    {201072 , u"8D"},
+    {202928 , u"9A"},
+    {204640 , u"9B"},
+    {206352 , u"9C"},
+    {208064 , u"9D"},
+    {209936 , u"10A"},
     #if RADIO_CONTROL_N_CHANNELS_ENABLE
-    {210096 , "10N"},
+    {210096 , u"10N"},
     #endif
-    {216928 , "11A"},
-    {218640 , "11B"},
-    {220352 , "11C"},
-    {222064 , "11D"},
+    {211648 , u"10B"},
+    {213360 , u"10C"},
+    {215072 , u"10D"},
+    {216928 , u"11A"},
     #if RADIO_CONTROL_N_CHANNELS_ENABLE
-    {217088 , "11N"},
+    {217088 , u"11N"},
     #endif
-    {223936 , "12A"},
-    {225648 , "12B"},
-    {227360 , "12C"},
-    {229072 , "12D"},
+    {218640 , u"11B"},
+    {220352 , u"11C"},
+    {222064 , u"11D"},
+    {223936 , u"12A"},
     #if RADIO_CONTROL_N_CHANNELS_ENABLE
-    {224096 , "12N"},
+    {224096 , u"12N"},
     #endif
-    {230784 , "13A"},
-    {232496 , "13B"},
-    {234208 , "13C"},
-    {235776 , "13D"},
-    {237488 , "13E"},
-    {239200 , "13F"}
+    {225648 , u"12B"},
+    {227360 , u"12C"},
+    {229072 , u"12D"},
+    {230784 , u"13A"},
+    {232496 , u"13B"},
+    {234208 , u"13C"},
+    {235776 , u"13D"},
+    {237488 , u"13E"},
+    {239200 , u"13F"}
+};
+static constexpr int numDabChannels = sizeof(dabChannels)/sizeof(dabChannels[0]);
+
+// all channel frequencies are multiples of 16 kHz => direct index table is generated at compile time
+#define DABTABLES_CHANNEL_GRID_KHZ  (16)
+static constexpr uint32_t dabChannelFirstFreq = dabChannels[0].frequency;
+static constexpr int dabChannelIndexSize = (dabChannels[numDabChannels-1].frequency - dabChannelFirstFreq) / DABTABLES_CHANNEL_GRID_KHZ + 1;
+struct DabChannelIndex
+{
+    int8_t idx[dabChannelIndexSize];
 };
+static constexpr DabChannelIndex makeDabChannelIndex()
+{
+    DabChannelIndex index = {};
+    for (int n = 0; n < dabChannelIndexSize; ++n)
+    {
+        index.idx[n] = -1;
+    }
+    for (int n = 0; n < numDabChannels; ++n)
+    {
+        index.idx[(dabChannels[n].frequency - dabChannelFirstFreq) / DABTABLES_CHANNEL_GRID_KHZ] = n;
+    }
+    return index;
+}
+static constexpr bool checkDabChannels()
+{
+    for (int n = 0; n < numDabChannels; ++n)
+    {
+        if ((0 != (dabChannels[n].frequency % DABTABLES_CHANNEL_GRID_KHZ))
+            || ((n > 0) && (dabChannels[n].frequency <= dabChannels[n-1].frequency)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(checkDabChannels(), "DAB channels must be sorted and aligned to 16 kHz grid");
+static constexpr DabChannelIndex dabChannelIndex = makeDabChannelIndex();
+
+int DabTables::numChannels()
+{
+    return numDabChannels;
+}
+
+uint32_t DabTables::channelFrequency(int idx)
+{
+    return dabChannels[idx].frequency;
+}
+
+QString DabTables::channelLabel(int idx)
+{   // static data, no copy
+    const char16_t * name = dabChannels[idx].name;
+    return QString::fromRawData(reinterpret_cast<const QChar *>(name), std::char_traits<char16_t>::length(name));
+}
+
+int DabTables::channelIndex(uint32_t frequency)
+{
+    if ((frequency < dabChannelFirstFreq) || (0 != (frequency % DABTABLES_CHANNEL_GRID_KHZ)))
+    {
+        return -1;
+    }
+    uint32_t n = (frequency - dabChannelFirstFreq) / DABTABLES_CHANNEL_GRID_KHZ;
+    return (n < uint32_t(dabChannelIndexSize)) ? dabChannelIndex.idx[n] : -1;
+}
+
+QString DabTables::channelName(uint32_t frequency)
+{
+    int idx = channelIndex(frequency);
+    return (idx >= 0) ? channelLabel(idx) : QString();
+}
 
 const uint16_t DabTables::ebuLatin2UCS2[] =
 {   /* UCS2 == UTF16 for Basic Multilingual Plane 0x0000-0xFFFF */
@@ -122,40 +200,91 @@ const uint16_t DabTables::ebuLatin2UCS2[] =
 
 QString DabTables::convertToQString(const char *c, uint8_t charset, uint8_t len)
 {
-    QString out;
+    // length of input data in bytes
+    int dataLen;
     switch (static_cast<DabCharset>(charset))
     {
     case DabCharset::UTF8:
-        out = out.fromUtf8(c);
+        dataLen = strlen(c);
+        break;
+    case DabCharset::EBULATIN:
+        dataLen = qstrnlen(c, len);
         break;
     case DabCharset::UCS2:
+    case DabCharset::LATIN1:
+        dataLen = len;
+        break;
+    default:
+        // do noting, unsupported charset
+        qDebug("ERROR: Charset %d is not supported", charset);
+        return QString();
+    }
+
+    if (dataLen > DABTABLES_LABEL_CACHE_MAXLEN)
+    {
+        return convert(c, static_cast<DabCharset>(charset), dataLen);
+    }
+
+    // labels and DL messages repeat all the time, converted strings are cached per thread
+    // and returned as implicitly shared copy
+    struct LabelCacheEntry
     {
-        uint8_t ucsLen = len/2+1;
-        char16_t * temp = new char16_t[ucsLen];
-        // BOM = 0xFEFF, DAB label is in big endian, writing it byte by byte
-        uint8_t * bomPtr = (uint8_t *) temp;
-        *bomPtr++ = 0xFE;
-        *bomPtr++ = 0xFF;
-        memcpy(temp+1, c, len);
-        out = out.fromUtf16(temp, ucsLen);
-        delete [] temp;
+        size_t hash = 0;
+        uint8_t charset = 0xFF;
+        QByteArray data;
+        QString str;
+    };
+    static thread_local LabelCacheEntry cache[DABTABLES_LABEL_CACHE_SIZE];
+
+    size_t hash = qHash(QByteArrayView(c, dataLen), charset);
+    LabelCacheEntry & entry = cache[hash & (DABTABLES_LABEL_CACHE_SIZE - 1)];
+    if ((entry.hash == hash) && (entry.charset == charset) && (entry.data.size() == dataLen)
+        && (0 == memcmp(entry.data.constData(), c, dataLen)))
+    {
+        return entry.str;
+    }
+
+    entry.hash = hash;
+    entry.charset = charset;
+    entry.data = QByteArray(c, dataLen);
+    entry.str = convert(c, static_cast<DabCharset>(charset), dataLen);
+    return entry.str;
+}
+
+QString DabTables::convert(const char *c, DabCharset charset, int len)
+{
+    QString out;
+    switch (charset)
+    {
+    case DabCharset::UTF8:
+        out = QString::fromUtf8(c, len);
+        break;
+    case DabCharset::UCS2:
+    {   // DAB label is in big endian, decoded directly to string buffer
+        out.resize(len/2);
+        QChar * outPtr = out.data();
+        const uint8_t * inPtr = reinterpret_cast<const uint8_t *>(c);
+        for (int n = 0; n < len/2; ++n)
+        {
+            outPtr[n] = QChar(char16_t((inPtr[2*n] << 8) | inPtr[2*n+1]));
+        }
     }
         break;
     case DabCharset::EBULATIN:        
-    {
-        int n = 0;
-        while (*c && (n++ < len))
+    {   // table lookup to preallocated buffer, EBU Latin differs from ASCII (0x24, 0x5C, 0x5E, 0x60, 0x7B-0x7F)
+        out.resize(len);
+        QChar * outPtr = out.data();
+        const uint8_t * inPtr = reinterpret_cast<const uint8_t *>(c);
+        for (int n = 0; n < len; ++n)
         {
-            out.append(QChar(ebuLatin2UCS2[uint8_t(*c++)]));
+            outPtr[n] = QChar(ebuLatin2UCS2[inPtr[n]]);
         }
     }
         break;
     case DabCharset::LATIN1:
-        out = out.fromLatin1(c, len);
+        out = QString::fromLatin1(c, len);
         break;
     default:
-        // do noting, unsupported charset
-        qDebug("ERROR: Charset %d is not supported", charset);
         break;
     }
 
@@ -232,8 +361,8 @@ QString DabTables::getPtyName(const uint8_t pty)
         case 27: return QString(QObject::tr("Oldies Music"));
         case 28: return QString(QObject::tr("Folk Music"));
         case 29: return QString(QObject::tr("Documentary"));
-        case 30: return QString("");
-        case 31: return QString("");
+        case 30: return QStringLiteral("");
+        case 31: return QStringLiteral("");
         default: return QString(QObject::tr("None"));
     };
 }
@@ -242,38 +371,38 @@ QString DabTables::getPtyNameEnglish(const uint8_t pty)
 {
     switch (pty)
     {
-        case 1: return QString("News");
-        case 2: return QString("Current Affairs");
-        case 3: return QString("Information");
-        case 4: return QString("Sport");
-        case 5: return QString("Education");
-        case 6: return QString("Drama");
-        case 7: return QString("Culture");
-        case 8: return QString("Science");
-        case 9: return QString("Varied");
-        case 10: return QString("Pop Music");
-        case 11: return QString("Rock Music");
-        case 12: return QString("Easy Listening Music");
-        case 13: return QString("Light Classical");
-        case 14: return QString("Serious Classical");
-        case 15: return QString("Other Music");
-        case 16: return QString("Weather/meteorology");
-        case 17: return QString("Finance/Business");
-        case 18: return QString("Children's programmes");
-        case 19: return QString("Social Affairs");
-        case 20: return QString("Religion");
-        case 21: return QString("Phone In");
-        case 22: return QString("Travel");
-        case 23: return QString("Leisure");
-        case 24: return QString("Jazz Music");
-        case 25: return QString("Country Music");
-        case 26: return QString("National Music");
-        case 27: return QString("Oldies Music");
-        case 28: return QString("Folk Music");
-        case 29: return QString("Documentary");
-        case 30: return QString("");
-        case 31: return QString("");
-        default: return QString("None");
+        case 1: return QStringLiteral("News");
+        case 2: return QStringLiteral("Current Affairs");
+        case 3: return QStringLiteral("Information");
+        case 4: return QStringLiteral("Sport");
+        case 5: return QStringLiteral("Education");
+        case 6: return QStringLiteral("Drama");
+        case 7: return QStringLiteral("Culture");
+        case 8: return QStringLiteral("Science");
+        case 9: return QStringLiteral("Varied");
+        case 10: return QStringLiteral("Pop Music");
+        case 11: return QStringLiteral("Rock Music");
+        case 12: return QStringLiteral("Easy Listening Music");
+        case 13: return QStringLiteral("Light Classical");
+        case 14: return QStringLiteral("Serious Classical");
+        case 15: return QStringLiteral("Other Music");
+        case 16: return QStringLiteral("Weather/meteorology");
+        case 17: return QStringLiteral("Finance/Business");
+        case 18: return QStringLiteral("Children's programmes");
+        case 19: return QStringLiteral("Social Affairs");
+        case 20: return QStringLiteral("Religion");
+        case 21: return QStringLiteral("Phone In");
+        case 22: return QStringLiteral("Travel");
+        case 23: return QStringLiteral("Leisure");
+        case 24: return QStringLiteral("Jazz Music");
+        case 25: return QStringLiteral("Country Music");
+        case 26: return QStringLiteral("National Music");
+        case 27: return QStringLiteral("Oldies Music");
+        case 28: return QStringLiteral("Folk Music");
+        case 29: return QStringLiteral("Documentary");
+        case 30: return QStringLiteral("");
+        case 31: return QStringLiteral("");
+        default: return QStringLiteral("None");
     };
 }
 
@@ -393,111 +522,111 @@ QString DabTables::getLangNameEnglish(int lang)
 {
     switch (lang)
     {
-        case 0x00: return QString("Unknown/NA");
-        case 0x01: return QString("Albanian");
-        case 0x02: return QString("Breton");
-        case 0x03: return QString("Catalan");
-        case 0x04: return QString("Croatian");
-        case 0x05: return QString("Welsh");
-        case 0x06: return QString("Czech");
-        case 0x07: return QString("Danish");
-        case 0x08: return QString("German");
-        case 0x09: return QString("English");
-        case 0x0A: return QString("Spanish");
-        case 0x0B: return QString("Esperanto");
-        case 0x0C: return QString("Estonian");
-        case 0x0D: return QString("Basque");
-        case 0x0E: return QString("Faroese");
-        case 0x0F: return QString("French");
-        case 0x10: return QString("Frisian");
-        case 0x11: return QString("Irish");
-        case 0x12: return QString("Gaelic");
-        case 0x13: return QString("Galician");
-        case 0x14: return QString("Icelandic");
-        case 0x15: return QString("Italian");
-        case 0x16: return QString("Lappish");
-        case 0x17: return QString("Latin");
-        case 0x18: return QString("Latvian");
-        case 0x19: return QString("Luxembourgian");
-        case 0x1A: return QString("Lithuanian");
-        case 0x1B: return QString("Hungarian");
-        case 0x1C: return QString("Maltese");
-        case 0x1D: return QString("Dutch");
-        case 0x1E: return QString("Norwegian");
-        case 0x1F: return QString("Occitan");
-        case 0x20: return QString("Polish");
-        case 0x21: return QString("Portuguese");
-        case 0x22: return QString("Romanian");
-        case 0x23: return QString("Romansh");
-        case 0x24: return QString("Serbian");
-        case 0x25: return QString("Slovak");
-        case 0x26: return QString("Slovene");
-        case 0x27: return QString("Finnish");
-        case 0x28: return QString("Swedish");
-        case 0x29: return QString("Turkish");
-        case 0x2A: return QString("Flemish");
-        case 0x2B: return QString("Walloon");
-        case 0x40: return QString("Background sound/clean feed");
-        case 0x45: return QString("Zulu");
-        case 0x46: return QString("Vietnamese");
-        case 0x47: return QString("Uzbek");
-        case 0x48: return QString("Urdu");
-        case 0x49: return QString("Ukranian");
-        case 0x4A: return QString("Thai");
-        case 0x4B: return QString("Telugu");
-        case 0x4C: return QString("Tatar");
-        case 0x4D: return QString("Tamil");
-        case 0x4E: return QString("Tadzhik");
-        case 0x4F: return QString("Swahili");
-        case 0x50: return QString("Sranan Tongo");
-        case 0x51: return QString("Somali");
-        case 0x52: return QString("Sinhalese");
-        case 0x53: return QString("Shona");
-        case 0x54: return QString("Serbo-Croat");
-        case 0x55: return QString("Rusyn");
-        case 0x56: return QString("Russian");
-        case 0x57: return QString("Quechua");
-        case 0x58: return QString("Pushtu");
-        case 0x59: return QString("Punjabi");
-        case 0x5A: return QString("Persian");
-        case 0x5B: return QString("Papiamento");
-        case 0x5C: return QString("Oriya");
-        case 0x5D: return QString("Nepali");
-        case 0x5E: return QString("Ndebele");
-        case 0x5F: return QString("Marathi");
-        case 0x60: return QString("Moldavian");
-        case 0x61: return QString("Malaysian");
-        case 0x62: return QString("Malagasay");
-        case 0x63: return QString("Macedonian");
-        case 0x64: return QString("Laotian");
-        case 0x65: return QString("Korean");
-        case 0x66: return QString("Khmer");
-        case 0x67: return QString("Kazakh");
-        case 0x68: return QString("Kannada");
-        case 0x69: return QString("Japanese");
-        case 0x6A: return QString("Indonesian");
-        case 0x6B: return QString("Hindi");
-        case 0x6C: return QString("Hebrew");
-        case 0x6D: return QString("Hausa");
-        case 0x6E: return QString("Gurani");
-        case 0x6F: return QString("Gujurati");
-        case 0x70: return QString("Greek");
-        case 0x71: return QString("Georgian");
-        case 0x72: return QString("Fulani");
-        case 0x73: return QString("Dari");
-        case 0x74: return QString("Chuvash");
-        case 0x75: return QString("Chinese");
-        case 0x76: return QString("Burmese");
-        case 0x77: return QString("Bulgarian");
-        case 0x78: return QString("Bengali");
-        case 0x79: return QString("Belorussian");
-        case 0x7A: return QString("Bambora");
-        case 0x7B: return QString("Azerbaijani");
-        case 0x7C: return QString("Assamese");
-        case 0x7D: return QString("Armenian");
-        case 0x7E: return QString("Arabic");
-        case 0x7F: return QString("Amharic");
-        default: return QString("Unknown");
+        case 0x00: return QStringLiteral("Unknown/NA");
+        case 0x01: return QStringLiteral("Albanian");
+        case 0x02: return QStringLiteral("Breton");
+        case 0x03: return QStringLiteral("Catalan");
+        case 0x04: return QStringLiteral("Croatian");
+        case 0x05: return QStringLiteral("Welsh");
+        case 0x06: return QStringLiteral("Czech");
+        case 0x07: return QStringLiteral("Danish");
+        case 0x08: return QStringLiteral("German");
+        case 0x09: return QStringLiteral("English");
+        case 0x0A: return QStringLiteral("Spanish");
+        case 0x0B: return QStringLiteral("Esperanto");
+        case 0x0C: return QStringLiteral("Estonian");
+        case 0x0D: return QStringLiteral("Basque");
+        case 0x0E: return QStringLiteral("Faroese");
+        case 0x0F: return QStringLiteral("French");
+        case 0x10: return QStringLiteral("Frisian");
+        case 0x11: return QStringLiteral("Irish");
+        case 0x12: return QStringLiteral("Gaelic");
+        case 0x13: return QStringLiteral("Galician");
+        case 0x14: return QStringLiteral("Icelandic");
+        case 0x15: return QStringLiteral("Italian");
+        case 0x16: return QStringLiteral("Lappish");
+        case 0x17: return QStringLiteral("Latin");
+        case 0x18: return QStringLiteral("Latvian");
+        case 0x19: return QStringLiteral("Luxembourgian");
+        case 0x1A: return QStringLiteral("Lithuanian");
+        case 0x1B: return QStringLiteral("Hungarian");
+        case 0x1C: return QStringLiteral("Maltese");
+        case 0x1D: return QStringLiteral("Dutch");
+        case 0x1E: return QStringLiteral("Norwegian");
+        case 0x1F: return QStringLiteral("Occitan");
+        case 0x20: return QStringLiteral("Polish");
+        case 0x21: return QStringLiteral("Portuguese");
+        case 0x22: return QStringLiteral("Romanian");
+        case 0x23: return QStringLiteral("Romansh");
+        case 0x24: return QStringLiteral("Serbian");
+        case 0x25: return QStringLiteral("Slovak");
+        case 0x26: return QStringLiteral("Slovene");
+        case 0x27: return QStringLiteral("Finnish");
+        case 0x28: return QStringLiteral("Swedish");
+        case 0x29: return QStringLiteral("Turkish");
+        case 0x2A: return QStringLiteral("Flemish");
+        case 0x2B: return QStringLiteral("Walloon");
+        case 0x40: return QStringLiteral("Background sound/clean feed");
+        case 0x45: return QStringLiteral("Zulu");
+        case 0x46: return QStringLiteral("Vietnamese");
+        case 0x47: return QStringLiteral("Uzbek");
+        case 0x48: return QStringLiteral("Urdu");
+        case 0x49: return QStringLiteral("Ukranian");
+        case 0x4A: return QStringLiteral("Thai");
+        case 0x4B: return QStringLiteral("Telugu");
+        case 0x4C: return QStringLiteral("Tatar");
+        case 0x4D: return QStringLiteral("Tamil");
+        case 0x4E: return QStringLiteral("Tadzhik");
+        case 0x4F: return QStringLiteral("Swahili");
+        case 0x50: return QStringLiteral("Sranan Tongo");
+        case 0x51: return QStringLiteral("Somali");
+        case 0x52: return QStringLiteral("Sinhalese");
+        case 0x53: return QStringLiteral("Shona");
+        case 0x54: return QStringLiteral("Serbo-Croat");
+        case 0x55: return QStringLiteral("Rusyn");
+        case 0x56: return QStringLiteral("Russian");
+        case 0x57: return QStringLiteral("Quechua");
+        case 0x58: return QStringLiteral("Pushtu");
+        case 0x59: return QStringLiteral("Punjabi");
+        case 0x5A: return QStringLiteral("Persian");
+        case 0x5B: return QStringLiteral("Papiamento");
+        case 0x5C: return QStringLiteral("Oriya");
+        case 0x5D: return QStringLiteral("Nepali");
+        case 0x5E: return QStringLiteral("Ndebele");
+        case 0x5F: return QStringLiteral("Marathi");
+        case 0x60: return QStringLiteral("Moldavian");
+        case 0x61: return QStringLiteral("Malaysian");
+        case 0x62: return QStringLiteral("Malagasay");
+        case 0x63: return QStringLiteral("Macedonian");
+        case 0x64: return QStringLiteral("Laotian");
+        case 0x65: return QStringLiteral("Korean");
+        case 0x66: return QStringLiteral("Khmer");
+        case 0x67: return QStringLiteral("Kazakh");
+        case 0x68: return QStringLiteral("Kannada");
+        case 0x69: return QStringLiteral("Japanese");
+        case 0x6A: return QStringLiteral("Indonesian");
+        case 0x6B: return QStringLiteral("Hindi");
+        case 0x6C: return QStringLiteral("Hebrew");
+        case 0x6D: return QStringLiteral("Hausa");
+        case 0x6E: return QStringLiteral("Gurani");
+        case 0x6F: return QStringLiteral("Gujurati");
+        case 0x70: return QStringLiteral("Greek");
+        case 0x71: return QStringLiteral("Georgian");
+        case 0x72: return QStringLiteral("Fulani");
+        case 0x73: return QStringLiteral("Dari");
+        case 0x74: return QStringLiteral("Chuvash");
+        case 0x75: return QStringLiteral("Chinese");
+        case 0x76: return QStringLiteral("Burmese");
+        case 0x77: return QStringLiteral("Bulgarian");
+        case 0x78: return QStringLiteral("Bengali");
+        case 0x79: return QStringLiteral("Belorussian");
+        case 0x7A: return QStringLiteral("Bambora");
+        case 0x7B: return QStringLiteral("Azerbaijani");
+        case 0x7C: return QStringLiteral("Assamese");
+        case 0x7D: return QStringLiteral("Armenian");
+        case 0x7E: return QStringLiteral("Arabic");
+        case 0x7F: return QStringLiteral("Amharic");
+        default: return QStringLiteral("Unknown");
     }
 }
 
@@ -794,242 +923,242 @@ QString DabTables::getCountryNameEnglish(uint32_t SId)
         case 0xA0A:
         case 0xA0B:
         case 0xA0D:
-        case 0xA0E: return QString("USA/Puerto Rico");
+        case 0xA0E: return QStringLiteral("USA/Puerto Rico");
         case 0xA1B:
         case 0xA1C:
         case 0xA1D:
-        case 0xA1E: return QString("Canada");
-        case 0xA1F: return QString("Greenland");
-        case 0xA21: return QString("Anguilla");
-        case 0xA22: return QString("Antigua and Barbuda");
-        case 0xA23: return QString("Ecuador");
-        case 0xA24: return QString("Falkland Islands");
-        case 0xA25: return QString("Barbados");
-        case 0xA26: return QString("Belize");
-        case 0xA27: return QString("Cayman Islands");
-        case 0xA28: return QString("Costa Rica");
-        case 0xA29: return QString("Cuba");
-        case 0xA2A: return QString("Argentina");
-        case 0xA2B: return QString("Brazil");
-        case 0xA2C: return QString("Bermuda");
-        case 0xA2D: return QString("Netherlands Antilles");
-        case 0xA2E: return QString("Guadeloupe");
-        case 0xA2F: return QString("Bahamas");
-        case 0xA31: return QString("Bolivia");
-        case 0xA32: return QString("Colombia");
-        case 0xA33: return QString("Jamaica");
-        case 0xA34: return QString("Martinique");
-        case 0xA36: return QString("Paraguay");
-        case 0xA37: return QString("Nicaragua");
-        case 0xA39: return QString("Panama");
-        case 0xA3A: return QString("Dominica");
-        case 0xA3B: return QString("Dominican Republic");
-        case 0xA3C: return QString("Chile");
-        case 0xA3D: return QString("Grenada");
-        case 0xA3E: return QString("Turks and Caicos islands");
-        case 0xA3F: return QString("Guyana");
-        case 0xA41: return QString("Guatemala");
-        case 0xA42: return QString("Honduras");
-        case 0xA43: return QString("Aruba");
-        case 0xA45: return QString("Montserrat");
-        case 0xA46: return QString("Trinidad and Tobago");
-        case 0xA47: return QString("Peru");
-        case 0xA48: return QString("Surinam");
-        case 0xA49: return QString("Uruguay");
-        case 0xA4A: return QString("St. Kitts");
-        case 0xA4B: return QString("St. Lucia");
-        case 0xA4C: return QString("El Salvador");
-        case 0xA4D: return QString("Haiti");
-        case 0xA4E: return QString("Venezuela");
-        case 0xA5B: return QString("Mexico");
-        case 0xA5C: return QString("St. Vincent");
+        case 0xA1E: return QStringLiteral("Canada");
+        case 0xA1F: return QStringLiteral("Greenland");
+        case 0xA21: return QStringLiteral("Anguilla");
+        case 0xA22: return QStringLiteral("Antigua and Barbuda");
+        case 0xA23: return QStringLiteral("Ecuador");
+        case 0xA24: return QStringLiteral("Falkland Islands");
+        case 0xA25: return QStringLiteral("Barbados");
+        case 0xA26: return QStringLiteral("Belize");
+        case 0xA27: return QStringLiteral("Cayman Islands");
+        case 0xA28: return QStringLiteral("Costa Rica");
+        case 0xA29: return QStringLiteral("Cuba");
+        case 0xA2A: return QStringLiteral("Argentina");
+        case 0xA2B: return QStringLiteral("Brazil");
+        case 0xA2C: return QStringLiteral("Bermuda");
+        case 0xA2D: return QStringLiteral("Netherlands Antilles");
+        case 0xA2E: return QStringLiteral("Guadeloupe");
+        case 0xA2F: return QStringLiteral("Bahamas");
+        case 0xA31: return QStringLiteral("Bolivia");
+        case 0xA32: return QStringLiteral("Colombia");
+        case 0xA33: return QStringLiteral("Jamaica");
+        case 0xA34: return QStringLiteral("Martinique");
+        case 0xA36: return QStringLiteral("Paraguay");
+        case 0xA37: return QStringLiteral("Nicaragua");
+        case 0xA39: return QStringLiteral("Panama");
+        case 0xA3A: return QStringLiteral("Dominica");
+        case 0xA3B: return QStringLiteral("Dominican Republic");
+        case 0xA3C: return QStringLiteral("Chile");
+        case 0xA3D: return QStringLiteral("Grenada");
+        case 0xA3E: return QStringLiteral("Turks and Caicos islands");
+        case 0xA3F: return QStringLiteral("Guyana");
+        case 0xA41: return QStringLiteral("Guatemala");
+        case 0xA42: return QStringLiteral("Honduras");
+        case 0xA43: return QStringLiteral("Aruba");
+        case 0xA45: return QStringLiteral("Montserrat");
+        case 0xA46: return QStringLiteral("Trinidad and Tobago");
+        case 0xA47: return QStringLiteral("Peru");
+        case 0xA48: return QStringLiteral("Surinam");
+        case 0xA49: return QStringLiteral("Uruguay");
+        case 0xA4A: return QStringLiteral("St. Kitts");
+        case 0xA4B: return QStringLiteral("St. Lucia");
+        case 0xA4C: return QStringLiteral("El Salvador");
+        case 0xA4D: return QStringLiteral("Haiti");
+        case 0xA4E: return QStringLiteral("Venezuela");
+        case 0xA5B: return QStringLiteral("Mexico");
+        case 0xA5C: return QStringLiteral("St. Vincent");
         case 0xA5D:
         case 0xA5E:
-        case 0xA5F: return QString("Mexico");
-        //case 0xA5F: return QString("Virgin islands (British)");
+        case 0xA5F: return QStringLiteral("Mexico");
+        //case 0xA5F: return QStringLiteral("Virgin islands (British)");
         case 0xA63:
         case 0xA6C:
-        case 0xA6D: return QString("Brazil");
-        case 0xA6F: return QString("St. Pierre and Miquelon");
+        case 0xA6D: return QStringLiteral("Brazil");
+        case 0xA6F: return QStringLiteral("St. Pierre and Miquelon");
 
-        case 0xD01: return QString("Cameroon");
-        case 0xD02: return QString("Central African Republic");
-        case 0xD03: return QString("Djibouti");
-        case 0xD04: return QString("Madagascar");
-        case 0xD05: return QString("Mali");
-        case 0xD06: return QString("Angola");
-        case 0xD07: return QString("Equatorial Guinea");
-        case 0xD08: return QString("Gabon");
-        case 0xD09: return QString("Republic of Guinea");
-        case 0xD0A: return QString("South Africa");
-        case 0xD0B: return QString("Burkina Faso");
-        case 0xD0C: return QString("Congo");
-        case 0xD0D: return QString("Togo");
-        case 0xD0E: return QString("Benin");
-        case 0xD0F: return QString("Malawi");
-        case 0xD11: return QString("Namibia");
-        case 0xD12: return QString("Liberia");
-        case 0xD13: return QString("Ghana");
-        case 0xD14: return QString("Mauritania");
-        case 0xD15: return QString("Sao Tome and Principe");
-        case 0xD16: return QString("Cape Verde");
-        case 0xD17: return QString("Senegal");
-        case 0xD18: return QString("Gambia");
-        case 0xD19: return QString("Burundi");
-        case 0xD1A: return QString("Ascension Island");
-        case 0xD1B: return QString("Botswana");
-        case 0xD1C: return QString("Comoros");
-        case 0xD1D: return QString("Tanzania");
-        case 0xD1E: return QString("Ethiopia");
-        case 0xD1F: return QString("Nigeria");
-        case 0xD21: return QString("Sierra Leone");
-        case 0xD22: return QString("Zimbabwe");
-        case 0xD23: return QString("Mozambique");
-        case 0xD24: return QString("Uganda");
-        case 0xD25: return QString("Swaziland");
-        case 0xD26: return QString("Kenya");
-        case 0xD27: return QString("Somalia");
-        case 0xD28: return QString("Niger");
-        case 0xD29: return QString("Chad");
-        case 0xD2A: return QString("Guinea-Bissau");
-        case 0xD2B: return QString("Zaire");
-        case 0xD2C: return QString("Cote d'Ivoire");
-        case 0xD2D: return QString("Zanzibar");
-        case 0xD2E: return QString("Zambia");
-        case 0xD33: return QString("Western Sahara");
-        case 0xD35: return QString("Rwanda");
-        case 0xD36: return QString("Lesotho");
-        case 0xD38: return QString("Seychelles");
-        case 0xD3A: return QString("Mauritius");
-        case 0xD3C: return QString("Sudan");
+        case 0xD01: return QStringLiteral("Cameroon");
+        case 0xD02: return QStringLiteral("Central African Republic");
+        case 0xD03: return QStringLiteral("Djibouti");
+        case 0xD04: return QStringLiteral("Madagascar");
+        case 0xD05: return QStringLiteral("Mali");
+        case 0xD06: return QStringLiteral("Angola");
+        case 0xD07: return QStringLiteral("Equatorial Guinea");
+        case 0xD08: return QStringLiteral("Gabon");
+        case 0xD09: return QStringLiteral("Republic of Guinea");
+        case 0xD0A: return QStringLiteral("South Africa");
+        case 0xD0B: return QStringLiteral("Burkina Faso");
+        case 0xD0C: return QStringLiteral("Congo");
+        case 0xD0D: return QStringLiteral("Togo");
+        case 0xD0E: return QStringLiteral("Benin");
+        case 0xD0F: return QStringLiteral("Malawi");
+        case 0xD11: return QStringLiteral("Namibia");
+        case 0xD12: return QStringLiteral("Liberia");
+        case 0xD13: return QStringLiteral("Ghana");
+        case 0xD14: return QStringLiteral("Mauritania");
+        case 0xD15: return QStringLiteral("Sao Tome and Principe");
+        case 0xD16: return QStringLiteral("Cape Verde");
+        case 0xD17: return QStringLiteral("Senegal");
+        case 0xD18: return QStringLiteral("Gambia");
+        case 0xD19: return QStringLiteral("Burundi");
+        case 0xD1A: return QStringLiteral("Ascension Island");
+        case 0xD1B: return QStringLiteral("Botswana");
+        case 0xD1C: return QStringLiteral("Comoros");
+        case 0xD1D: return QStringLiteral("Tanzania");
+        case 0xD1E: return QStringLiteral("Ethiopia");
+        case 0xD1F: return QStringLiteral("Nigeria");
+        case 0xD21: return QStringLiteral("Sierra Leone");
+        case 0xD22: return QStringLiteral("Zimbabwe");
+        case 0xD23: return QStringLiteral("Mozambique");
+        case 0xD24: return QStringLiteral("Uganda");
+        case 0xD25: return QStringLiteral("Swaziland");
+        case 0xD26: return QStringLiteral("Kenya");
+        case 0xD27: return QStringLiteral("Somalia");
+        case 0xD28: return QStringLiteral("Niger");
+        case 0xD29: return QStringLiteral("Chad");
+        case 0xD2A: return QStringLiteral("Guinea-Bissau");
+        case 0xD2B: return QStringLiteral("Zaire");
+        case 0xD2C: return QStringLiteral("Cote d'Ivoire");
+        case 0xD2D: return QStringLiteral("Zanzibar");
+        case 0xD2E: return QStringLiteral("Zambia");
+        case 0xD33: return QStringLiteral("Western Sahara");
+        case 0xD35: return QStringLiteral("Rwanda");
+        case 0xD36: return QStringLiteral("Lesotho");
+        case 0xD38: return QStringLiteral("Seychelles");
+        case 0xD3A: return QStringLiteral("Mauritius");
+        case 0xD3C: return QStringLiteral("Sudan");
 
-        case 0xE01: return QString("Germany");
-        case 0xE02: return QString("Algeria");
-        case 0xE03: return QString("Andorra");
-        case 0xE04: return QString("Israel");
-        case 0xE05: return QString("Italy");
-        case 0xE06: return QString("Belgium");
-        case 0xE07: return QString("Russian Federation");
-        case 0xE08: return QString("Palestine");
-        case 0xE09: return QString("Albania");
-        case 0xE0A: return QString("Austria");
-        case 0xE0B: return QString("Hungary");
-        case 0xE0C: return QString("Malta");
-        case 0xE0D: return QString("Germany");
-        case 0xE0F: return QString("Egypt");
-        case 0xE11: return QString("Greece");
-        case 0xE12: return QString("Cyprus");
-        case 0xE13: return QString("San Marino");
-        case 0xE14: return QString("Switzerland");
-        case 0xE15: return QString("Jordan");
-        case 0xE16: return QString("Finland");
-        case 0xE17: return QString("Luxembourg");
-        case 0xE18: return QString("Bulgaria");
-        case 0xE19: return QString("Denmark");
-        //case 0xE19: return QString("Faroe");
-        case 0xE1A: return QString("Gibraltar");
-        case 0xE1B: return QString("Iraq");
-        case 0xE1C: return QString("United Kingdom");
-        case 0xE1D: return QString("Libya");
-        case 0xE1E: return QString("Romania");
-        case 0xE1F: return QString("France");
-        case 0xE21: return QString("Morocco");
-        case 0xE22: return QString("Czech Republic");
-        case 0xE23: return QString("Poland");
-        case 0xE24: return QString("Vatican");
-        case 0xE25: return QString("Slovakia");
-        case 0xE26: return QString("Syria");
-        case 0xE27: return QString("Tunisia");
-        case 0xE29: return QString("Liechtenstein");
-        case 0xE2A: return QString("Iceland");
-        case 0xE2B: return QString("Monaco");
-        case 0xE2C: return QString("Lithuania");
-        case 0xE2D: return QString("Serbia");
-        case 0xE2E: return QString("Spain");
-        //case 0xE2E: return QString("Canary Islands");
-        case 0xE2F: return QString("Norway");
-        case 0xE31: return QString("Montenegro");
-        case 0xE32: return QString("Ireland");
-        case 0xE33: return QString("Turkey");
-        case 0xE35: return QString("Tajikistan");
-        case 0xE38: return QString("Netherlands");
-        case 0xE39: return QString("Latvia");
-        case 0xE3A: return QString("Lebanon");
-        case 0xE3B: return QString("Azerbaijan");
-        case 0xE3C: return QString("Croatia");
-        case 0xE3D: return QString("Kazakhstan");
-        case 0xE3E: return QString("Sweden");
-        case 0xE3F: return QString("Belarus");
-        case 0xE41: return QString("Moldova");
-        case 0xE42: return QString("Estonia");
-        case 0xE43: return QString("Macedonia");
-        case 0xE46: return QString("Ukraine");
-        case 0xE47: return QString("Kosovo");
-        //case 0xE48: return QString("Azores");
-        //case 0xE48: return QString("Madeira");
-        case 0xE48: return QString("Portugal");
-        case 0xE49: return QString("Slovenia");
-        case 0xE4A: return QString("Armenia");
-        case 0xE4B: return QString("Uzbekistan");
-        case 0xE4C: return QString("Georgia");
-        case 0xE4E: return QString("Turkmenistan");
-        case 0xE4F: return QString("Bosnia Herzegovina");
-        case 0xE53: return QString("Kyrgyzstan");
+        case 0xE01: return QStringLiteral("Germany");
+        case 0xE02: return QStringLiteral("Algeria");
+        case 0xE03: return QStringLiteral("Andorra");
+        case 0xE04: return QStringLiteral("Israel");
+        case 0xE05: return QStringLiteral("Italy");
+        case 0xE06: return QStringLiteral("Belgium");
+        case 0xE07: return QStringLiteral("Russian Federation");
+        case 0xE08: return QStringLiteral("Palestine");
+        case 0xE09: return QStringLiteral("Albania");
+        case 0xE0A: return QStringLiteral("Austria");
+        case 0xE0B: return QStringLiteral("Hungary");
+        case 0xE0C: return QStringLiteral("Malta");
+        case 0xE0D: return QStringLiteral("Germany");
+        case 0xE0F: return QStringLiteral("Egypt");
+        case 0xE11: return QStringLiteral("Greece");
+        case 0xE12: return QStringLiteral("Cyprus");
+        case 0xE13: return QStringLiteral("San Marino");
+        case 0xE14: return QStringLiteral("Switzerland");
+        case 0xE15: return QStringLiteral("Jordan");
+        case 0xE16: return QStringLiteral("Finland");
+        case 0xE17: return QStringLiteral("Luxembourg");
+        case 0xE18: return QStringLiteral("Bulgaria");
+        case 0xE19: return QStringLiteral("Denmark");
+        //case 0xE19: return QStringLiteral("Faroe");
+        case 0xE1A: return QStringLiteral("Gibraltar");
+        case 0xE1B: return QStringLiteral("Iraq");
+        case 0xE1C: return QStringLiteral("United Kingdom");
+        case 0xE1D: return QStringLiteral("Libya");
+        case 0xE1E: return QStringLiteral("Romania");
+        case 0xE1F: return QStringLiteral("France");
+        case 0xE21: return QStringLiteral("Morocco");
+        case 0xE22: return QStringLiteral("Czech Republic");
+        case 0xE23: return QStringLiteral("Poland");
+        case 0xE24: return QStringLiteral("Vatican");
+        case 0xE25: return QStringLiteral("Slovakia");
+        case 0xE26: return QStringLiteral("Syria");
+        case 0xE27: return QStringLiteral("Tunisia");
+        case 0xE29: return QStringLiteral("Liechtenstein");
+        case 0xE2A: return QStringLiteral("Iceland");
+        case 0xE2B: return QStringLiteral("Monaco");
+        case 0xE2C: return QStringLiteral("Lithuania");
+        case 0xE2D: return QStringLiteral("Serbia");
+        case 0xE2E: return QStringLiteral("Spain");
+        //case 0xE2E: return QStringLiteral("Canary Islands");
+        case 0xE2F: return QStringLiteral("Norway");
+        case 0xE31: return QStringLiteral("Montenegro");
+        case 0xE32: return QStringLiteral("Ireland");
+        case 0xE33: return QStringLiteral("Turkey");
+        case 0xE35: return QStringLiteral("Tajikistan");
+        case 0xE38: return QStringLiteral("Netherlands");
+        case 0xE39: return QStringLiteral("Latvia");
+        case 0xE3A: return QStringLiteral("Lebanon");
+        case 0xE3B: return QStringLiteral("Azerbaijan");
+        case 0xE3C: return QStringLiteral("Croatia");
+        case 0xE3D: return QStringLiteral("Kazakhstan");
+        case 0xE3E: return QStringLiteral("Sweden");
+        case 0xE3F: return QStringLiteral("Belarus");
+        case 0xE41: return QStringLiteral("Moldova");
+        case 0xE42: return QStringLiteral("Estonia");
+        case 0xE43: return QStringLiteral("Macedonia");
+        case 0xE46: return QStringLiteral("Ukraine");
+        case 0xE47: return QStringLiteral("Kosovo");
+        //case 0xE48: return QStringLiteral("Azores");
+        //case 0xE48: return QStringLiteral("Madeira");
+        case 0xE48: return QStringLiteral("Portugal");
+        case 0xE49: return QStringLiteral("Slovenia");
+        case 0xE4A: return QStringLiteral("Armenia");
+        case 0xE4B: return QStringLiteral("Uzbekistan");
+        case 0xE4C: return QStringLiteral("Georgia");
+        case 0xE4E: return QStringLiteral("Turkmenistan");
+        case 0xE4F: return QStringLiteral("Bosnia Herzegovina");
+        case 0xE53: return QStringLiteral("Kyrgyzstan");
 
-        case 0xF01: return QString("Australia: Capital Cities (commercial and community broadcasters)");
-        case 0xF02: return QString("Australia: Regional New South Wales and ACT");
-        case 0xF03: return QString("Australia: Capital Cities (national broadcasters)");
-        case 0xF04: return QString("Australia: Regional Queensland");
-        case 0xF05: return QString("Australia: Regional South Australia and Northern Territory");
-        case 0xF06: return QString("Australia: Regional Western Australia");
-        case 0xF07: return QString("Australia: Regional Victoria and Tasmania");
-        case 0xF08: return QString("Australia: Regional (future)");
-        case 0xF09: return QString("Saudi Arabia");
-        case 0xF0A: return QString("Afghanistan");
-        case 0xF0B: return QString("Myanmar (Burma)");
-        case 0xF0C: return QString("China");
-        case 0xF0D: return QString("Korea (North)");
-        case 0xF0E: return QString("Bahrain");
-        case 0xF0F: return QString("Malaysia");
-        case 0xF11: return QString("Kiribati");
-        case 0xF12: return QString("Bhutan");
-        case 0xF13: return QString("Bangladesh");
-        case 0xF14: return QString("Pakistan");
-        case 0xF15: return QString("Fiji");
-        case 0xF16: return QString("Oman");
-        case 0xF17: return QString("Nauru");
-        case 0xF18: return QString("Iran");
-        case 0xF19: return QString("New Zealand");
-        case 0xF1A: return QString("Solomon Islands");
-        case 0xF1B: return QString("Brunei Darussalam");
-        case 0xF1C: return QString("Sri Lanka");
-        case 0xF1D: return QString("Taiwan");
-        case 0xF1E: return QString("Korea (South)");
-        case 0xF1F: return QString("Hong Kong");
-        case 0xF21: return QString("Kuwait");
-        case 0xF22: return QString("Qatar");
-        case 0xF23: return QString("Cambodia");
-        case 0xF24: return QString("Western Samoa");
-        case 0xF25: return QString("India");
-        case 0xF26: return QString("Macau");
-        case 0xF27: return QString("Vietnam");
-        case 0xF28: return QString("Philippines");
-        case 0xF29: return QString("Japan");
-        case 0xF2A: return QString("Singapore");
-        case 0xF2B: return QString("Maldives");
-        case 0xF2C: return QString("Indonesia");
-        case 0xF2D: return QString("United Arab Emirates");
-        case 0xF2E: return QString("Nepal");
-        case 0xF2F: return QString("Vanuatu");
-        case 0xF31: return QString("Laos");
-        case 0xF32: return QString("Thailand");
-        case 0xF33: return QString("Tonga");
-        case 0xF39: return QString("Papua New Guinea");
-        case 0xF3B: return QString("Yemen");
-        case 0xF3E: return QString("Micronesia");
-        case 0xF3F: return QString("Mongolia");
+        case 0xF01: return QStringLiteral("Australia: Capital Cities (commercial and community broadcasters)");
+        case 0xF02: return QStringLiteral("Australia: Regional New South Wales and ACT");
+        case 0xF03: return QStringLiteral("Australia: Capital Cities (national broadcasters)");
+        case 0xF04: return QStringLiteral("Australia: Regional Queensland");
+        case 0xF05: return QStringLiteral("Australia: Regional South Australia and Northern Territory");
+        case 0xF06: return QStringLiteral("Australia: Regional Western Australia");
+        case 0xF07: return QStringLiteral("Australia: Regional Victoria and Tasmania");
+        case 0xF08: return QStringLiteral("Australia: Regional (future)");
+        case 0xF09: return QStringLiteral("Saudi Arabia");
+        case 0xF0A: return QStringLiteral("Afghanistan");
+        case 0xF0B: return QStringLiteral("Myanmar (Burma)");
+        case 0xF0C: return QStringLiteral("China");
+        case 0xF0D: return QStringLiteral("Korea (North)");
+        case 0xF0E: return QStringLiteral("Bahrain");
+        case 0xF0F: return QStringLiteral("Malaysia");
+        case 0xF11: return QStringLiteral("Kiribati");
+        case 0xF12: return QStringLiteral("Bhutan");
+        case 0xF13: return QStringLiteral("Bangladesh");
+        case 0xF14: return QStringLiteral("Pakistan");
+        case 0xF15: return QStringLiteral("Fiji");
+        case 0xF16: return QStringLiteral("Oman");
+        case 0xF17: return QStringLiteral("Nauru");
+        case 0xF18: return QStringLiteral("Iran");
+        case 0xF19: return QStringLiteral("New Zealand");
+        case 0xF1A: return QStringLiteral("Solomon Islands");
+        case 0xF1B: return QStringLiteral("Brunei Darussalam");
+        case 0xF1C: return QStringLiteral("Sri Lanka");
+        case 0xF1D: return QStringLiteral("Taiwan");
+        case 0xF1E: return QStringLiteral("Korea (South)");
+        case 0xF1F: return QStringLiteral("Hong Kong");
+        case 0xF21: return QStringLiteral("Kuwait");
+        case 0xF22: return QStringLiteral("Qatar");
+        case 0xF23: return QStringLiteral("Cambodia");
+        case 0xF24: return QStringLiteral("Western Samoa");
+        case 0xF25: return QStringLiteral("India");
+        case 0xF26: return QStringLiteral("Macau");
+        case 0xF27: return QStringLiteral("Vietnam");
+        case 0xF28: return QStringLiteral("Philippines");
+        case 0xF29: return QStringLiteral("Japan");
+        case 0xF2A: return QStringLiteral("Singapore");
+        case 0xF2B: return QStringLiteral("Maldives");
+        case 0xF2C: return QStringLiteral("Indonesia");
+        case 0xF2D: return QStringLiteral("United Arab Emirates");
+        case 0xF2E: return QStringLiteral("Nepal");
+        case 0xF2F: return QStringLiteral("Vanuatu");
+        case 0xF31: return QStringLiteral("Laos");
+        case 0xF32: return QStringLiteral("Thailand");
+        case 0xF33: return QStringLiteral("Tonga");
+        case 0xF39: return QStringLiteral("Papua New Guinea");
+        case 0xF3B: return QStringLiteral("Yemen");
+        case 0xF3E: return QStringLiteral("Micronesia");
+        case 0xF3F: return QStringLiteral("Mongolia");
 
-        default: return QString("Unknown");
+        default: return QStringLiteral("Unknown");
         }
 }
 
@@ -1059,23 +1188,24 @@ QString DabTables::getAnnouncementNameEnglish(DabAnnouncement announcement)
     // ETSI TS 101 756 V2.4.1 [Table 15]
     switch (announcement)
     {
-    case DabAnnouncement::Alarm:     return QString("Alarm");
-    case DabAnnouncement::Traffic:   return QString("Traffic News");
-    case DabAnnouncement::Transport: return QString("Transport News");
-    case DabAnnouncement::Warning:   return QString("Warning");
-    case DabAnnouncement::News:      return QString("News");
-    case DabAnnouncement::Weather:   return QString("Weather");
-    case DabAnnouncement::Event:     return QString("Event");
-    case DabAnnouncement::Special:   return QString("Special event");
-    case DabAnnouncement::Programme: return QString("Radio Info");
-    case DabAnnouncement::Sport:     return QString("Sport news");
-    case DabAnnouncement::Financial: return QString("Financial news");
-    case DabAnnouncement::AlarmTest: return QString("Alarm Test");
-    default:                         return QString("Unknown");
+    case DabAnnouncement::Alarm:     return QStringLiteral("Alarm");
+    case DabAnnouncement::Traffic:   return QStringLiteral("Traffic News");
+    case DabAnnouncement::Transport: return QStringLiteral("Transport News");
+    case DabAnnouncement::Warning:   return QStringLiteral("Warning");
+    case DabAnnouncement::News:      return QStringLiteral("News");
+    case DabAnnouncement::Weather:   return QStringLiteral("Weather");
+    case DabAnnouncement::Event:     return QStringLiteral("Event");
+    case DabAnnouncement::Special:   return QStringLiteral("Special event");
+    case DabAnnouncement::Programme: return QStringLiteral("Radio Info");
+    case DabAnnouncement::Sport:     return QStringLiteral("Sport news");
+    case DabAnnouncement::Financial: return QStringLiteral("Financial news");
+    case DabAnnouncement::AlarmTest: return QStringLiteral("Alarm Test");
+    default:                         return QStringLiteral("Unknown");
     }
 }
 
-const QList<uint16_t> DabTables::ASwValues =
+// ASw flag of announcement type, index is DabAnnouncement
+static constexpr uint16_t aswValues[] =
 {
     (1 << static_cast<int>(DabAnnouncement::Alarm)),
     (1 << static_cast<int>(DabAnnouncement::Traffic)),
@@ -1090,18 +1220,30 @@ const QList<uint16_t> DabTables::ASwValues =
     (1 << static_cast<int>(DabAnnouncement::Financial)),
 };
 
+int DabTables::aswIndex(uint16_t aswFlags)
+{
+    for (int n = 0; n < int(sizeof(aswValues)/sizeof(aswValues[0])); ++n)
+    {
+        if (aswValues[n] == aswFlags)
+        {
+            return n;
+        }
+    }
+    return -1;
+}
+
 QString DabTables::getUserApplicationName(DabUserApplicationType type)
 {
     switch (type)
     {
-    case DabUserApplicationType::SlideShow: return QString("SlideShow");
-    case DabUserApplicationType::TPEG: return QString("TPEG");
-    case DabUserApplicationType::SPI: return QString("SPI");
-    case DabUserApplicationType::DMB: return QString("DMB");
-    case DabUserApplicationType::Filecasting: return QString("Filecasting");
-    case DabUserApplicationType::FIS: return QString("FIS");
-    case DabUserApplicationType::Journaline: return QString("Journaline");
-    default: return QString("Unknown");
+    case DabUserApplicationType::SlideShow: return QStringLiteral("SlideShow");
+    case DabUserApplicationType::TPEG: return QStringLiteral("TPEG");
+    case DabUserApplicationType::SPI: return QStringLiteral("SPI");
+    case DabUserApplicationType::DMB: return QStringLiteral("DMB");
+    case DabUserApplicationType::Filecasting: return QStringLiteral("Filecasting");
+    case DabUserApplicationType::FIS: return QStringLiteral("FIS");
+    case DabUserApplicationType::Journaline: return QStringLiteral("Journaline");
+    default: return QStringLiteral("Unknown");
     }
 }
 
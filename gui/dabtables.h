@@ -32,6 +32,9 @@
 #include <QMap>
 #include <QDateTime>
 
+#define DABTABLES_LABEL_CACHE_SIZE    (256)     // must be power of 2, entries per thread
+#define DABTABLES_LABEL_CACHE_MAXLEN  (128)     // longer strings are converted without cache
+
 enum class DabProtectionLevel
 {
     PROTECTION_LEVEL_UNDEFINED = 0,
@@ -128,16 +131,19 @@ enum class DabAnnouncement
     Undefined
 };
 
-typedef QMap<uint32_t, QString> dabChannelList_t;
-
 class DabTables
 {
 public:
     //DabTables();
     enum {NUM_PTY = 32};
-    static const dabChannelList_t channelList;
+    // DAB channels (frequency in kHz), lookup tables are generated at compile time
+    static int numChannels();
+    static uint32_t channelFrequency(int idx);
+    static QString channelLabel(int idx);
+    static int channelIndex(uint32_t frequency);        // -1 if frequency is not DAB channel
+    static QString channelName(uint32_t frequency);     // empty if frequency is not DAB channel
     static const uint16_t ebuLatin2UCS2[];
-    static const QList<uint16_t> ASwValues;
+    static int aswIndex(uint16_t aswFlags);             // DabAnnouncement or -1
     static QString convertToQString(const char *c, uint8_t charset, uint8_t len = 16);
     static QDateTime dabTimeToUTC(uint32_t dateHoursMinutes, uint16_t secMsec);
     static QString getPtyName(const uint8_t pty);
@@ -149,6 +155,9 @@ public:
     static QString getAnnouncementName(DabAnnouncement announcement);
     static QString getAnnouncementNameEnglish(DabAnnouncement announcement);
     static QString getUserApplicationName(DabUserApplicationType type);
+
+private:
+    static QString convert(const char *c, DabCharset charset, int len);
 };
 
 #endif // DABTABLES_H
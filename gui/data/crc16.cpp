@@ -0,0 +1,79 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "crc16.h"
+
+#define CRC16_POLY  (0x1021)
+
+const Crc16::Tables Crc16::m_tables;
+
+Crc16::Tables::Tables()
+{
+    for (int b = 0; b < 256; ++b)
+    {
+        uint16_t crc = uint16_t(b << 8);
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x8000) ? uint16_t((crc << 1) ^ CRC16_POLY) : uint16_t(crc << 1);
+        }
+        t[0][b] = crc;
+    }
+    for (int k = 1; k < 8; ++k)
+    {   // table k = byte followed by k zero bytes
+        for (int b = 0; b < 256; ++b)
+        {
+            t[k][b] = uint16_t(t[k-1][b] << 8) ^ t[0][t[k-1][b] >> 8];
+        }
+    }
+}
+
+uint16_t Crc16::calc(const uint8_t *data, int len, uint16_t crc)
+{
+    const uint16_t (*t)[256] = m_tables.t;
+    while (len >= 8)
+    {   // first two bytes are combined with CRC, every byte is shifted through remaining bytes by its table
+        uint16_t x = crc ^ uint16_t((data[0] << 8) | data[1]);
+        crc = t[7][x >> 8] ^ t[6][x & 0xFF] ^ t[5][data[2]] ^ t[4][data[3]]
+              ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8;
+        len -= 8;
+    }
+    while (len-- > 0)
+    {
+        crc = uint16_t(crc << 8) ^ t[0][(crc >> 8) ^ *data++];
+    }
+    return crc;
+}
+
+bool Crc16::check(const uint8_t *data, int len)
+{
+    if (len < 2)
+    {
+        return false;
+    }
+    uint16_t invTxCRC = ~((uint16_t(data[len-2]) << 8) | data[len-1]);
+    return calc(data, len-2) == invTxCRC;
+}
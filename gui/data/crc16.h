@@ -0,0 +1,52 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <cstdint>
+
+// CRC-16 according to [ETSI EN 300 401, 5.3.3.4], polynomial x^16 + x^12 + x^5 + 1, initial value 0xFFFF
+// CRC is transmitted inverted in last two bytes (MSB first)
+// slicing-by-8: 8 bytes are processed per iteration using 8 lookup tables (4 kB)
+class Crc16
+{
+public:
+    static uint16_t calc(const uint8_t * data, int len, uint16_t crc = 0xFFFF);
+
+    // data includes 2 bytes of inverted CRC at the end
+    static bool check(const uint8_t * data, int len);
+
+private:
+    struct Tables
+    {
+        uint16_t t[8][256];
+        Tables();
+    };
+    static const Tables m_tables;
+};
+
+#endif // CRC16_H
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include "datagrouprecorder.h"
+
+Q_LOGGING_CATEGORY(dataGroupRecorder, "DataGroupRecorder", QtInfoMsg)
+
+bool DataGroupRecorder::open(const QString &fileName)
+{
+    close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly))
+    {
+        qCWarning(dataGroupRecorder) << "Unable to create file" << fileName;
+        return false;
+    }
+    m_out.setDevice(&m_file);
+    m_out << quint32(DATAGROUPRECORDER_MAGIC) << quint16(DATAGROUPRECORDER_VERSION);
+    m_timer.start();
+    qCInfo(dataGroupRecorder) << "Recording data groups to" << fileName;
+    return true;
+}
+
+void DataGroupRecorder::close()
+{
+    if (m_file.isOpen())
+    {
+        m_out.setDevice(nullptr);
+        m_file.close();
+    }
+}
+
+void DataGroupRecorder::record(Type type, int instance, const QByteArray &data, uint16_t SCId, uint16_t userAppType)
+{
+    if (!m_file.isOpen())
+    {
+        return;
+    }
+    m_out << quint8(type) << quint8(instance) << quint16(SCId) << quint16(userAppType) << qint64(m_timer.elapsed()) << data;
+}
+
+bool DataGroupRecorder::load(const QString &fileName, QList<Record> &records)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic;
+    quint16 version;
+    in >> magic >> version;
+    if ((QDataStream::Ok != in.status()) || (DATAGROUPRECORDER_MAGIC != magic) || (DATAGROUPRECORDER_VERSION != version))
+    {
+        return false;
+    }
+
+    while (!in.atEnd())
+    {
+        Record rec;
+        quint8 type;
+        in >> type >> rec.instance >> rec.SCId >> rec.userAppType >> rec.timeMs >> rec.data;
+        if (QDataStream::Ok != in.status())
+        {   // truncated recording, records read so far are valid
+            break;
+        }
+        rec.type = static_cast<Type>(type);
+        records.append(rec);
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef DATAGROUPRECORDER_H
+#define DATAGROUPRECORDER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QList>
+
+#define DATAGROUPRECORDER_MAGIC     0x47444443   // "CDDG"
+#define DATAGROUPRECORDER_VERSION   1
+
+// Recording of user application data and DL data groups during reception
+// Recorded file is replayed offline into data decoders by benchmark, see benchmark/databenchmark.cpp
+class DataGroupRecorder
+{
+public:
+    enum class Type : quint8
+    {
+        UserAppData = 0,
+        DynamicLabel = 1,
+    };
+
+    struct Record
+    {
+        Type type;
+        quint8 instance;       // 0 = service, 1 = announcement
+        quint16 SCId;          // user application data only
+        quint16 userAppType;   // user application data only
+        qint64 timeMs;         // time since start of recording
+        QByteArray data;
+    };
+
+    ~DataGroupRecorder() { close(); }
+
+    bool open(const QString & fileName);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    void record(Type type, int instance, const QByteArray & data, uint16_t SCId = 0, uint16_t userAppType = 0);
+
+    // loads whole recording, returns false if file is not valid recording
+    static bool load(const QString & fileName, QList<Record> & records);
+
+private:
+    QFile m_file;
+    QDataStream m_out;
+    QElapsedTimer m_timer;
+};
+
+#endif // DATAGROUPRECORDER_H
@@ -25,6 +25,7 @@
  */
 
 #include "dldecoder.h"
+#include "crc16.h"
 #include "dabtables.h"
 #include <QString>
 #include <QDebug>
@@ -50,31 +51,22 @@ void DLDecoder::reset()
     message.clear();
     itemToggle = -1;
     itemRunnning = -1;
+    resetRepeatFilter();
 
     emit resetTerminal();
 }
 
-bool DLDecoder::crc16check(const QByteArray & data)
+void DLDecoder::resetRepeatFilter()
 {
-    uint16_t crc = 0xFFFF;
-    uint16_t mask = 0x1020;
-
-    for (int n = 0; n < data.size()-2; ++n)
-    {
-        for (int bit = 7; bit >= 0; --bit)
-        {
-            uint16_t in = (data[n] >> bit) & 0x1;
-            uint16_t tmp = in ^ ((crc>>15) & 0x1);
-            crc <<= 1;
-
-            crc ^= (tmp * mask);
-            crc += tmp;
-        }
-    }
-
-    uint16_t invTxCRC = ~(uint16_t(data[data.size()-2] << 8) | uint8_t(data[data.size()-1]));
+    lastLabel.clear();
+    lastCharset = 0xFF;
+    lastMessage.clear();
+    lastCommand.clear();
+}
 
-    return (crc == invTxCRC);
+bool DLDecoder::crc16check(const QByteArray & data)
+{
+    return Crc16::check(reinterpret_cast<const uint8_t *>(data.constData()), data.size());
 }
 
 void DLDecoder::newDataGroup(const QByteArray & dataGroup)
@@ -88,6 +80,7 @@ void DLDecoder::newDataGroup(const QByteArray & dataGroup)
             // [ETSI EN 300 401 V2.1.1]
             // [0 0 0 1: clear display command - remove the dynamic label message from the display;]
             qCDebug(dlDecoder) << "Clear display command";
+            resetRepeatFilter();
             emit resetTerminal();
             break;
         case 0b0010:
@@ -129,8 +122,19 @@ void DLDecoder::newDataGroup(const QByteArray & dataGroup)
     {
         if (assembleDL(dataGroup))
         {   // message is complete
-            message = DabTables::convertToQString(label.data(), charset, label.size());
-            emit dlComplete(message);
+            if ((label == lastLabel) && (charset == lastCharset))
+            {   // the same message repeated
+                message = lastMessage;
+            }
+            else
+            {
+                message = DabTables::convertToQString(label.data(), charset, label.size());
+                lastLabel = label;
+                lastCharset = charset;
+                lastMessage = message;
+                lastCommand.clear();      // DL+ tags refer to new message
+                emit dlComplete(message);
+            }
             int8_t t = (dataGroup.at(0) & 0x80) != 0;
 #if DLDECODER_VERBOSE>1
             if (t != labelToggle)
@@ -265,6 +269,12 @@ void DLDecoder::parseDLPlusCommand()
             break;
         }
 
+        if (dlCommand == lastCommand)
+        {   // the same tags were already emitted
+            break;
+        }
+        lastCommand = dlCommand;
+
         int_fast8_t itToggle = (dlCommand.at(0) >> 3) & 0x1;
         int_fast8_t itRunning = (dlCommand.at(0) >> 2) & 0x1;
         int_fast8_t numTags = (dlCommand.at(0) & 0x03) + 1;
@@ -144,6 +144,9 @@ public slots:
     void newDataGroup(const QByteArray & dataGroup);
     void reset();
 
+    // next message is emitted even if it is repeated (display was cleared outside of decoder)
+    void resetRepeatFilter();
+
 signals:
     void resetTerminal();
     void dlItemRunning(bool);
@@ -165,6 +168,12 @@ private:
     QByteArray dlCommand;
     QString message;
 
+    // repeated messages and commands are not converted and emitted again
+    QByteArray lastLabel;
+    uint8_t lastCharset;
+    QString lastMessage;
+    QByteArray lastCommand;
+
     bool crc16check(const QByteArray & data);
 
     bool assembleDL(const QByteArray &dataGroup);
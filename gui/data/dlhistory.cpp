@@ -0,0 +1,130 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QFile>
+#include <QTextStream>
+
+#include "dlhistory.h"
+
+void DLHistory::addMessage(const ServiceListId &id, const QString &message)
+{
+    if (!id.isValid() || message.isEmpty())
+    {
+        return;
+    }
+
+    ServiceHistory & history = m_services[id.value()];
+    size_t hash = qHash(message);
+    if (history.recentHashes.contains(hash))
+    {   // repetition in carousel
+        return;
+    }
+    history.recentHashes.append(hash);
+    if (history.recentHashes.size() > DLHISTORY_RECENT)
+    {
+        history.recentHashes.removeFirst();
+    }
+
+    DLHistoryItem item;
+    item.time = QDateTime::currentDateTime();
+    item.message = message;
+    history.items.append(item);
+    if (history.items.size() > DLHISTORY_MAX_ITEMS)
+    {
+        history.items.removeFirst();
+    }
+}
+
+void DLHistory::addObject(const ServiceListId &id, const DLPlusObject &object)
+{
+    if ((DLPlusContentType::ITEM_TITLE != object.getType()) && (DLPlusContentType::ITEM_ARTIST != object.getType()))
+    {   // only song information is stored
+        return;
+    }
+
+    auto it = m_services.find(id.value());
+    if ((m_services.end() == it) || it->items.isEmpty())
+    {   // DL+ tags always refer to message received before
+        return;
+    }
+
+    // tags belong to last message
+    DLHistoryItem & item = it->items.last();
+    if (DLPlusContentType::ITEM_TITLE == object.getType())
+    {
+        item.title = object.getTag();
+    }
+    else
+    {
+        item.artist = object.getTag();
+    }
+}
+
+QList<DLHistoryItem> DLHistory::items(const ServiceListId &id) const
+{
+    return m_services.value(id.value()).items;
+}
+
+QList<DLHistoryItem> DLHistory::songs(const ServiceListId &id) const
+{
+    QList<DLHistoryItem> songList;
+    for (const auto & item : m_services.value(id.value()).items)
+    {
+        if (item.title.isEmpty())
+        {
+            continue;
+        }
+        if (!songList.isEmpty() && (songList.last().title == item.title) && (songList.last().artist == item.artist))
+        {   // the same song with different message
+            continue;
+        }
+        songList.append(item);
+    }
+    return songList;
+}
+
+bool DLHistory::save(const ServiceListId &id, const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return false;
+    }
+
+    auto quoted = [](QString str) { return "\"" + str.replace('"', "\"\"") + "\""; };
+
+    QTextStream out(&file);
+    out << "time,title,artist,message\n";
+    for (const auto & item : m_services.value(id.value()).items)
+    {
+        QString message = item.message;
+        message.replace(QChar(0x0A), ' ').remove(QChar(0x0B)).remove(QChar(0x1F));
+        out << item.time.toString(Qt::ISODate) << ','
+            << quoted(item.title) << ',' << quoted(item.artist) << ','
+            << quoted(message) << '\n';
+    }
+    return (QTextStream::Ok == out.status());
+}
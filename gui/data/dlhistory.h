@@ -0,0 +1,70 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef DLHISTORY_H
+#define DLHISTORY_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "dldecoder.h"
+#include "servicelistid.h"
+
+#define DLHISTORY_MAX_ITEMS  (1000)     // per service, oldest items are removed
+#define DLHISTORY_RECENT     (8)        // messages in carousel that are not stored again
+
+struct DLHistoryItem
+{
+    QDateTime time;         // first reception
+    QString message;
+    QString title;          // DL+ ITEM_TITLE
+    QString artist;         // DL+ ITEM_ARTIST
+};
+
+// per service history of DL messages, messages repeated in carousel are stored only once
+// items with DL+ title form log of played songs
+class DLHistory
+{
+public:
+    void addMessage(const ServiceListId & id, const QString & message);
+    void addObject(const ServiceListId & id, const DLPlusObject & object);
+    void clear(const ServiceListId & id) { m_services.remove(id.value()); }
+
+    QList<DLHistoryItem> items(const ServiceListId & id) const;
+    QList<DLHistoryItem> songs(const ServiceListId & id) const;
+    bool save(const ServiceListId & id, const QString & fileName) const;     // CSV
+
+private:
+    struct ServiceHistory
+    {
+        QList<DLHistoryItem> items;
+        QList<size_t> recentHashes;     // newest last
+    };
+    QHash<uint64_t, ServiceHistory> m_services;
+};
+
+#endif // DLHISTORY_H
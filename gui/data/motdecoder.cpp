@@ -73,7 +73,7 @@ void MOTDecoder::newDataGroup(const QByteArray &dataGroup)
     qCDebug(motDecoder) << Q_FUNC_INFO << "Data group len=" << dataGroup.size();
 
     MSCDataGroup mscDataGroup(dataGroup);
-    if (!mscDataGroup.isValid())
+    if (!mscDataGroup.isValid() || (mscDataGroup.dataFieldSize() < 2))
     {   // data group was not valid - wrong CRC, or length
         return;
     }
@@ -81,7 +81,7 @@ void MOTDecoder::newDataGroup(const QByteArray &dataGroup)
     { /* datagroup was valid */ }
 
     // unsigned required
-    const uint8_t * dataFieldPtr = reinterpret_cast<const uint8_t *>(mscDataGroup.dataFieldConstBegin());
+    const uint8_t * dataFieldPtr = mscDataGroup.dataField();
 
     // [ETSI EN 301 234, 5.1.1 Segmentation header]
     uint8_t repetitionCount = (*dataFieldPtr >> 5) & 0x7;
@@ -90,6 +90,11 @@ void MOTDecoder::newDataGroup(const QByteArray &dataGroup)
     // Only the last segment may have a smaller size (to carry the remaining bytes of the MOT entity).
     uint16_t segmentSize = (*dataFieldPtr++ << 8) & 0x1FFF;
     segmentSize += *dataFieldPtr++;
+    if (segmentSize > mscDataGroup.dataFieldSize() - 2)
+    {   // segment would be read beyond data group
+        qCDebug(motDecoder) << "Segment size" << segmentSize << "exceeds data field size" << mscDataGroup.dataFieldSize();
+        return;
+    }
 
     qCDebug(motDecoder) << "Data group type =" << mscDataGroup.getType();
     qCDebug(motDecoder) << "Segment number = "<< mscDataGroup.getSegmentNum() << ", last = " << mscDataGroup.getLastFlag();
@@ -28,6 +28,8 @@
 #include "dabtables.h"
 #include <QDebug>
 #include <QLoggingCategory>
+#include <QPair>
+#include <algorithm>
 Q_LOGGING_CATEGORY(motObject, "MOTObject", QtInfoMsg)
 
 MOTEntity::MOTEntity()
@@ -45,89 +47,137 @@ bool MOTEntity::isComplete() const
     { /* last segment was already received and we know expected size => we could have complete entity */ }
 
     // lets check if all segments were received
-
-    // [ETSI EN 301 234, 5.1 Segmentation of MOT entities]
-    // MOT entities will be split up in segments with equal size. Only the last segment may have a smaller size
-    // (to carry the remaining bytes of the MOT entity). Every MOT entity (e.g. every MOT body) can use a different segmentation size.
-    int lastSegmentSize = m_segments.last().size();
-
-    if (m_numSegments != m_segments.size())
-    {
-        qCWarning(motObject) << "numSegments != segments.size()";
-    }
-
-    for (int n = 0; n < m_numSegments-1; ++n)
-    {
-        if (m_segments.at(n).size() < lastSegmentSize)
-        {  // some segment is smaller than last segment thus not received
-            return false;
-        }
-    }
-    return true;
+    return (m_numReceived == m_numSegments);
 }
 
-int MOTEntity::size()
+int MOTEntity::size() const
 {
-    int receivedSize = 0;
-    for (int n = 0; n < m_numSegments; ++n)
-    {
-        receivedSize += m_segments[n].size();
-    }
-
-    return receivedSize;
+    return m_data.size();
 }
 
 void MOTEntity::addSegment(const uint8_t * segment, uint16_t segmentNum, uint16_t segmentSize, bool lastFlag)
 {
-    if ((segmentNum >= 8192) || (segmentSize == 0))
+    if ((segmentNum >= MOTENTITY_MAX_SEGMENTS) || (segmentSize == 0))
     {
         return;
     }
     else
     { /* continue with adding */ }
 
+    if ((segmentNum < m_segmentMap.size()) && m_segmentMap.testBit(segmentNum))
+    {   // segment was already received before
+        return;
+    }
+    else
+    { /* new segment */ }
+
+    // [ETSI EN 301 234, 5.1 Segmentation of MOT entities]
+    // MOT entities will be split up in segments with equal size. Only the last segment may have a smaller size
+    // (to carry the remaining bytes of the MOT entity). Every MOT entity (e.g. every MOT body) can use a different segmentation size.
     if (lastFlag)
     {   // current segment is marked as last, thus we know number of segments
+        if (((m_numSegments >= 0) && (m_numSegments != segmentNum+1)) || (m_segmentMap.size() > segmentNum+1)
+            || ((m_segmentSize >= 0) && (segmentSize > m_segmentSize)))
+        {   // segments do not match => entity has changed
+            reset();
+        }
+        else
+        { /* do nothing */ }
+
         m_numSegments = segmentNum+1;
+        if ((segmentNum > 0) && (m_segmentSize < 0))
+        {   // position of the last segment is not known yet
+            m_pendingLastSegment = QByteArray((const char *)segment, segmentSize);
+            m_numReceived += 1;
+            m_segmentMap.resize(m_numSegments);
+            m_segmentMap.setBit(segmentNum);
+            return;
+        }
+        else
+        { /* segment position is known */ }
     }
     else
-    { /* do nothing */ }
+    {
+        if ((m_segmentSize >= 0) && (m_segmentSize != segmentSize))
+        {   // segmentation has changed => entity has changed
+            reset();
+        }
+        else if ((m_numSegments >= 0) && (segmentNum >= m_numSegments-1))
+        {   // unexpected segment number
+            return;
+        }
+        else
+        { /* do nothing */ }
 
-    // all segments have the same size only the last can be shorter
-    if (segmentNum > m_segments.size())
-    {   // insert empty items
-        for (int n = m_segments.size(); n<segmentNum; ++n)
-        {
-            m_segments.append(QByteArray());
+        if (m_segmentSize < 0)
+        {   // first segment that is not last determines segment size
+            m_segmentSize = segmentSize;
+            if (!m_pendingLastSegment.isEmpty())
+            {
+                if (m_pendingLastSegment.size() <= m_segmentSize)
+                {
+                    copySegment(reinterpret_cast<const uint8_t *>(m_pendingLastSegment.constData()), m_numSegments-1, m_pendingLastSegment.size());
+                    m_pendingLastSegment.clear();
+                }
+                else
+                {   // last segment is longer than others => entity has changed
+                    reset();
+                    m_segmentSize = segmentSize;
+                }
+            }
         }
     }
+
+    if (!((segmentNum < m_segmentMap.size()) && m_segmentMap.testBit(segmentNum)))
+    {
+        m_numReceived += 1;
+    }
+    copySegment(segment, segmentNum, segmentSize);
+}
+
+void MOTEntity::copySegment(const uint8_t *segment, uint16_t segmentNum, uint16_t segmentSize)
+{
+    int offset = (segmentNum > 0) ? (segmentNum * m_segmentSize) : 0;
+    if (segmentNum == m_numSegments-1)
+    {   // last segment defines entity size
+        m_data.resize(offset + segmentSize);
+    }
+    else if (m_data.size() < offset + segmentSize)
+    {
+        m_data.resize(offset + segmentSize);
+    }
     else
-    { /* do nothing - segment is somewhere in the middle */ }
+    { /* buffer is large enough */ }
+    memcpy(m_data.data() + offset, segment, segmentSize);
 
-    if (segmentNum < m_segments.size())
+    if (m_segmentMap.size() <= segmentNum)
     {
-        if (m_segments.at(segmentNum).size() != segmentSize)
-        {   // current segment size is diffrent than recieved size, it could happen when no segment #segmentNum was received yet
-            m_segments.replace(segmentNum, QByteArray((const char *)segment, segmentSize));
-        }
-        else
-        { /* do nothing - segment was already received before */ }
+        m_segmentMap.resize(segmentNum+1);
     }
-    else if (segmentNum == m_segments.size())
-    {   // add segment to the end
-        m_segments.append(QByteArray((const char *)segment, segmentSize));
+    m_segmentMap.setBit(segmentNum);
+}
+
+void MOTEntity::reserve(int size)
+{
+    if (size > m_data.capacity())
+    {   // avoid detaching already shared data
+        m_data.reserve(size);
     }
 }
 
 void MOTEntity::reset()
 {
-    m_segments.clear();
+    m_data.clear();
+    m_segmentMap.clear();
+    m_pendingLastSegment.clear();
     m_numSegments = -1;
+    m_numReceived = 0;
+    m_segmentSize = -1;
 }
 
 QByteArray MOTEntity::getData() const
 {
-    return m_segments.join();
+    return m_data;
 }
 
 
@@ -316,6 +366,9 @@ bool MOTObject::addSegment(const uint8_t * segment, uint16_t segmentNum, uint16_
         if (d->m_header.isComplete())
         {   // header is complete -> lets set parameters for the object
             d->parseHeader();
+
+            // body size is known => buffer is allocated only once
+            d->m_body.reserve(d->m_bodySize);
 //            if (!parseHeader(d->header.getData()))
 //            {   // something is wrong - header could not be parsed, objects is not complete
 //                d->objectIsComplete = false;
@@ -611,6 +664,7 @@ bool MOTDirectory::parse(const QByteArray &dirData)
 //=================================================================================
 MOTObjectCache::MOTObjectCache()
 {
+    m_accessCntr = 0;
 }
 
 MOTObjectCache::~MOTObjectCache()
@@ -621,53 +675,145 @@ MOTObjectCache::~MOTObjectCache()
 void MOTObjectCache::clear()
 {
     m_cache.clear();
+    m_index.clear();
+    m_memory.set(0);
+}
+
+void MOTObjectCache::updateMemory()
+{
+    qint64 memorySize = 0;
+    for (const auto & obj : m_cache)
+    {
+        memorySize += obj.size();
+    }
+    m_memory.set(memorySize);
+}
+
+int MOTObjectCache::indexOf(uint16_t transportId)
+{
+    m_stats.numLookups += 1;
+    QHash<uint16_t, IndexEntry>::iterator it = m_index.find(transportId);
+    if (m_index.end() != it)
+    {
+        it->lastAccess = ++m_accessCntr;
+        return it->idx;
+    }
+    m_stats.numMisses += 1;
+    return -1;
+}
+
+void MOTObjectCache::rebuildIndex()
+{
+    QHash<uint16_t, IndexEntry> index;
+    index.reserve(m_cache.size());
+    for (int n = 0; n < m_cache.size(); ++n)
+    {
+        uint16_t id = m_cache.at(n).getId();
+        index.insert(id, IndexEntry{n, m_index.value(id, IndexEntry{n, m_accessCntr}).lastAccess});
+    }
+    m_index = index;
 }
 
 MOTObjectCache::iterator MOTObjectCache::findMotObj(uint16_t transportId)
 {
-    MOTObjectCache::iterator it;
-    for (it = m_cache.begin(); it < m_cache.end(); ++it)
+    int idx = indexOf(transportId);
+    if (idx < 0)
     {
-        if (it->getId() == transportId)
-        {
-            return it;
-        }
+        return m_cache.end();
     }
-    return it;
+    return m_cache.begin() + idx;
 }
 
 MOTObjectCache::const_iterator MOTObjectCache::cfindMotObj(uint16_t transportId)
 {
-    MOTObjectCache::const_iterator it;
-    for (it = m_cache.cbegin(); it < m_cache.cend(); ++it)
+    int idx = indexOf(transportId);
+    if (idx < 0)
     {
-        if (it->getId() == transportId)
-        {
-            return it;
-        }
+        return m_cache.cend();
     }
-    return it;
+    return m_cache.cbegin() + idx;
 }
 
 
 void MOTObjectCache::deleteMotObj(uint16_t transportId)
 {
-    for (int n = 0; n<m_cache.size(); ++n)
+    int idx = m_index.value(transportId, IndexEntry{-1, 0}).idx;
+    if (idx >= 0)
     {
-        if (m_cache[n].getId() == transportId)
-        {
-            m_cache.removeAt(n);
-            return;
+        m_cache.removeAt(idx);
+        m_index.remove(transportId);
+        if (idx < m_cache.size())
+        {   // indexes of following objects have changed
+            rebuildIndex();
         }
+        updateMemory();
     }
 }
 
 MOTObjectCache::iterator MOTObjectCache::addMotObj(const MOTObject & obj)
 {
+    if (m_index.contains(obj.getId()))
+    {   // this should not happen, object is replaced
+        deleteMotObj(obj.getId());
+    }
+
+    // new object is a good moment to check memory budget
+    evict();
+
     m_cache.append(obj);
+    m_index.insert(obj.getId(), IndexEntry{int(m_cache.size()-1), ++m_accessCntr});
     return --(m_cache.end());
 }
 
+void MOTObjectCache::evict()
+{
+    qint64 memorySize = 0;
+    QList<QPair<uint32_t, uint16_t>> candidates;
+    for (const auto & obj : m_cache)
+    {
+        memorySize += obj.size();
+        if (!obj.isComplete() && !obj.hasHeader())
+        {
+            candidates.append(qMakePair(m_index.value(obj.getId()).lastAccess, obj.getId()));
+        }
+    }
+
+    // objects grow by received segments => memory usage is updated here when next object is added
+    m_memory.set(memorySize);
+    if (memorySize <= MOTOBJECTCACHE_MEMORY_BUDGET)
+    {   // nothing to do
+        return;
+    }
+
+    // least recently used first
+    std::sort(candidates.begin(), candidates.end());
+    bool removed = false;
+    for (const auto & candidate : candidates)
+    {
+        int idx = m_index.value(candidate.second).idx;
+        int objSize = m_cache.at(idx).size();
+        m_cache.removeAt(idx);
+        m_index.remove(candidate.second);
+        rebuildIndex();
+        removed = true;
+
+        m_stats.numEvicted += 1;
+        m_stats.bytesEvicted += objSize;
+        memorySize -= objSize;
+        if (memorySize <= MOTOBJECTCACHE_MEMORY_BUDGET)
+        {
+            break;
+        }
+    }
+    m_memory.set(memorySize);
+
+    if (removed)
+    {
+        qCDebug(motObject) << "MOT cache eviction: evicted" << m_stats.numEvicted << "objects /" << m_stats.bytesEvicted << "bytes in total, lookups"
+                           << m_stats.numLookups << "misses" << m_stats.numMisses;
+    }
+}
+
 void MOTObjectCache::markAllObsolete()
 {
     for (int n = 0; n<m_cache.size(); ++n)
@@ -678,14 +824,10 @@ void MOTObjectCache::markAllObsolete()
 
 MOTObjectCache::iterator MOTObjectCache::markObjObsolete(uint16_t transportId, bool obsolete)
 {
-    MOTObjectCache::iterator it;
-    for (it = m_cache.begin(); it < m_cache.end(); ++it)
+    MOTObjectCache::iterator it = findMotObj(transportId);
+    if (m_cache.end() != it)
     {
-        if (it->getId() == transportId)
-        {
-            it->setObsolete(obsolete);
-            return it;
-        }
+        it->setObsolete(obsolete);
     }
     return it;
 }
@@ -693,16 +835,23 @@ MOTObjectCache::iterator MOTObjectCache::markObjObsolete(uint16_t transportId, b
 void MOTObjectCache::deleteObsolete()
 {
     QList<MOTObject>::iterator it = m_cache.begin();
+    bool removed = false;
     while (it != m_cache.end())
     {
         if (it->isObsolete())
         {
+            m_index.remove(it->getId());
             it = m_cache.erase(it);
+            removed = true;
         }
         else
         {
             ++it;
         }
     }
+    if (removed)
+    {
+        rebuildIndex();
+        updateMemory();
+    }
 }
-
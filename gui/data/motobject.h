@@ -28,24 +28,39 @@
 #define MOTOBJECT_H
 
 #include <QObject>
-#include <QByteArrayList>
+#include <QByteArray>
+#include <QBitArray>
 #include <QHash>
 #include <QSharedData>
+#include "diagnostics.h"
 
 #define MOTOBJECT_VERBOSE 0
+#define MOTENTITY_MAX_SEGMENTS 8192
+#define MOTOBJECTCACHE_MEMORY_BUDGET (16*1024*1024)  // bytes
 
+// MOT entity is reassembled directly into one contiguous buffer,
+// received segments are tracked in bitmap
 class MOTEntity
 {
 public:
     MOTEntity();
     bool isComplete() const;
-    int size();
+    int size() const;
     void addSegment(const uint8_t * segment, uint16_t segmentNum, uint16_t segmentSize, bool lastFlag);
+    void reserve(int size);
+
+    // returns implicitly shared buffer, no data is copied
     QByteArray getData() const;
     void reset();
 private:
-    QByteArrayList m_segments;
+    QByteArray m_data;
+    QBitArray m_segmentMap;
+    QByteArray m_pendingLastSegment;    // last segment received before segment size is known
     int_fast32_t m_numSegments;
+    int_fast32_t m_numReceived;
+    int_fast32_t m_segmentSize;
+
+    void copySegment(const uint8_t * segment, uint16_t segmentNum, uint16_t segmentSize);
 };
 
 class MOTObjectData : public QSharedData
@@ -82,7 +97,12 @@ public:
     uint16_t getId() const { return d->m_id; }
     bool addSegment(const uint8_t *segment, uint16_t segmentNum, uint16_t segmentSize, bool lastFlag, bool isHeader = false);
     bool isComplete() const { return d->m_objectIsComplete; };
+
+    // returns implicitly shared body, no data is copied
     QByteArray getBody() const;
+    QByteArray getHeader() const { return d->m_header.getData(); }
+    bool hasHeader() const { return d->m_header.isComplete(); }
+    int size() const { return d->m_header.size() + d->m_body.size(); }   // received bytes
     bool isObsolete() const { return d->m_objectIsObsolete; }
     void setObsolete(bool obsolete) { d->m_objectIsObsolete = obsolete; };
 
@@ -103,10 +123,19 @@ private:
 class MOTObjectCache
 {
 public:   
+    struct Statistics
+    {
+        uint32_t numLookups = 0;
+        uint32_t numMisses = 0;
+        uint32_t numEvicted = 0;
+        uint64_t bytesEvicted = 0;
+    };
+
     MOTObjectCache();
     ~MOTObjectCache();
     void clear();
     int size() const { return m_cache.size(); }
+    const Statistics & statistics() const { return m_stats; }
 
     // iterator access
     typedef QList<MOTObject>::iterator iterator;
@@ -127,6 +156,25 @@ public:
     MOTObjectCache::const_iterator cend() const { return m_cache.cend(); }
 private:
     QList<MOTObject> m_cache;
+
+    // index to m_cache and last access stamp for each transport ID
+    struct IndexEntry
+    {
+        int idx;
+        uint32_t lastAccess;
+    };
+    QHash<uint16_t, IndexEntry> m_index;
+    uint32_t m_accessCntr;
+    Statistics m_stats;
+    DiagnosticsMemoryCounter m_memory { DiagnosticsMemory::MotCache };
+
+    int indexOf(uint16_t transportId);
+    void updateMemory();
+    void rebuildIndex();
+
+    // LRU eviction of incomplete objects without header when memory budget is exceeded
+    // complete objects and objects with header (e.g. from MOT directory) are never evicted
+    void evict();
 };
 
 
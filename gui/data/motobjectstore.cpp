@@ -0,0 +1,220 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QLoggingCategory>
+#include "motobjectstore.h"
+
+Q_DECLARE_LOGGING_CATEGORY(motObject)
+
+MOTObjectStore::MOTObjectStore(const QString &appName, int maxObjects) : m_appName(appName), m_maxObjects(maxObjects)
+{
+}
+
+void MOTObjectStore::open(uint32_t ueid, uint32_t sid, uint16_t channelId)
+{
+    close();
+
+    m_path = QString("%1/MOT/%2/%3_%4_%5/").arg(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), m_appName)
+                 .arg(ueid, 6, 16, QChar('0')).arg(sid, 8, 16, QChar('0')).arg(channelId, 4, 16, QChar('0'));
+    QDir dir;
+    dir.mkpath(m_path);
+
+    QDir directory(m_path);
+    const QFileInfoList fileList = directory.entryInfoList({"*.mot"}, QDir::Files, QDir::Time | QDir::Reversed);
+    for (const QFileInfo & fileInfo : fileList)
+    {
+        if (!load(fileInfo.absoluteFilePath()))
+        {   // file is not valid
+            qCDebug(motObject) << "Removing invalid MOT object file" << fileInfo.fileName();
+            directory.remove(fileInfo.fileName());
+        }
+    }
+    qCDebug(motObject) << "MOT object store" << m_path << "loaded" << m_objects.size() << "objects";
+}
+
+void MOTObjectStore::close()
+{
+    m_path.clear();
+    m_objects.clear();
+    m_contentNames.clear();
+}
+
+QList<MOTObject> MOTObjectStore::objects() const
+{
+    QList<MOTObject> list;
+    for (const QString & contentName : m_contentNames)
+    {
+        list.append(*m_objects.constFind(contentName));
+    }
+    return list;
+}
+
+QByteArray MOTObjectStore::getBody(const QString &contentName) const
+{
+    const auto it = m_objects.constFind(contentName);
+    if (m_objects.cend() != it)
+    {
+        return it->getBody();
+    }
+    return QByteArray();
+}
+
+bool MOTObjectStore::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic;
+    quint16 version;
+    quint16 transportId;
+    QByteArray header;
+    QByteArray body;
+    in >> magic >> version >> transportId >> header >> body;
+    file.close();
+
+    if ((QDataStream::Ok != in.status()) || (MOTOBJECTSTORE_MAGIC != magic) || (MOTOBJECTSTORE_VERSION != version)
+        || header.isEmpty() || (header.size() > MOTOBJECTSTORE_SEGMENT_SIZE))
+    {
+        return false;
+    }
+
+    // object is reassembled the same way as from the broadcast
+    MOTObject obj(transportId);
+    obj.addSegment(reinterpret_cast<const uint8_t *>(header.constData()), 0, header.size(), true, true);
+    int numSegments = (body.size() + MOTOBJECTSTORE_SEGMENT_SIZE - 1) / MOTOBJECTSTORE_SEGMENT_SIZE;
+    for (int n = 0; n < numSegments; ++n)
+    {
+        int offset = n * MOTOBJECTSTORE_SEGMENT_SIZE;
+        obj.addSegment(reinterpret_cast<const uint8_t *>(body.constData()) + offset, n,
+                       qMin(MOTOBJECTSTORE_SEGMENT_SIZE, int(body.size()) - offset), (n == numSegments-1));
+    }
+
+    if (!obj.isComplete() || (QFileInfo(fileName).fileName() != QFileInfo(this->fileName(obj.getContentName())).fileName()))
+    {   // something is wrong
+        return false;
+    }
+
+    m_objects.insert(obj.getContentName(), obj);
+    m_contentNames.append(obj.getContentName());
+
+    return true;
+}
+
+void MOTObjectStore::store(const MOTObject &obj)
+{
+    if (!isOpen() || !obj.isComplete() || obj.getContentName().isEmpty())
+    {
+        return;
+    }
+
+    const QByteArray header = obj.getHeader();
+    const auto objIt = m_objects.constFind(obj.getContentName());
+    if ((m_objects.cend() != objIt) && (objIt->getHeader() == header))
+    {   // the same object is already stored
+        m_contentNames.removeOne(obj.getContentName());
+        m_contentNames.append(obj.getContentName());
+        return;
+    }
+
+    QSaveFile file(fileName(obj.getContentName()));
+    if (file.open(QIODevice::WriteOnly))
+    {
+        QDataStream out(&file);
+        out << quint32(MOTOBJECTSTORE_MAGIC) << quint16(MOTOBJECTSTORE_VERSION) << quint16(obj.getId()) << header << obj.getBody();
+        if (!file.commit())
+        {
+            qCWarning(motObject) << "Failed to store MOT object" << obj.getContentName();
+            return;
+        }
+    }
+    else
+    {
+        qCWarning(motObject) << "Failed to store MOT object" << obj.getContentName();
+        return;
+    }
+
+    m_objects.insert(obj.getContentName(), obj);
+    m_contentNames.removeOne(obj.getContentName());
+    m_contentNames.append(obj.getContentName());
+
+    while ((m_maxObjects > 0) && (m_contentNames.size() > m_maxObjects))
+    {   // remove oldest object
+        remove(m_contentNames.first());
+    }
+}
+
+void MOTObjectStore::remove(const QString &contentName)
+{
+    if (isOpen() && m_objects.contains(contentName))
+    {
+        QFile::remove(fileName(contentName));
+        m_objects.remove(contentName);
+        m_contentNames.removeOne(contentName);
+    }
+}
+
+void MOTObjectStore::invalidate(MOTObjectCache::const_iterator begin, MOTObjectCache::const_iterator end)
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    QHash<QString, QByteArray> dirHeaders;
+    for (auto it = begin; it != end; ++it)
+    {
+        if (it->hasHeader())
+        {
+            dirHeaders.insert(it->getContentName(), it->getHeader());
+        }
+    }
+
+    const QStringList contentNames = m_contentNames;
+    for (const QString & contentName : contentNames)
+    {
+        if (dirHeaders.value(contentName) != m_objects.constFind(contentName)->getHeader())
+        {   // object was removed from directory or it has changed
+            qCDebug(motObject) << "Stored MOT object" << contentName << "is not valid anymore";
+            remove(contentName);
+        }
+    }
+}
+
+QString MOTObjectStore::fileName(const QString &contentName) const
+{
+    return m_path + QCryptographicHash::hash(contentName.toUtf8(), QCryptographicHash::Sha1).toHex() + ".mot";
+}
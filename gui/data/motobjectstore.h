@@ -0,0 +1,77 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MOTOBJECTSTORE_H
+#define MOTOBJECTSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include "motobject.h"
+
+#define MOTOBJECTSTORE_MAGIC        0x5354434D   // "MCTS"
+#define MOTOBJECTSTORE_VERSION      1
+#define MOTOBJECTSTORE_SEGMENT_SIZE 8189         // maximal MOT segment size (13 bits)
+
+// Persistent storage of complete MOT objects
+// Objects are stored in cache directory for each scope (ensemble, service, user application channel)
+// and they are identified by content name, stored object is replaced when MOT header changes.
+class MOTObjectStore
+{
+public:
+    MOTObjectStore(const QString & appName, int maxObjects = -1);
+
+    // opens store for the scope and loads stored objects
+    void open(uint32_t ueid, uint32_t sid, uint16_t channelId);
+    void close();
+    bool isOpen() const { return !m_path.isEmpty(); }
+
+    // returns stored objects, oldest first
+    QList<MOTObject> objects() const;
+
+    // returns body of stored object or empty array if not found
+    QByteArray getBody(const QString & contentName) const;
+
+    // stores complete object, nothing is written if the same object is already stored
+    void store(const MOTObject & obj);
+    void remove(const QString & contentName);
+
+    // removes objects that are not in MOT directory or that have changed
+    void invalidate(MOTObjectCache::const_iterator begin, MOTObjectCache::const_iterator end);
+
+private:
+    QString m_appName;
+    QString m_path;
+    int m_maxObjects;
+    QHash<QString, MOTObject> m_objects;    // content name -> stored object
+    QStringList m_contentNames;             // oldest first
+
+    QString fileName(const QString & contentName) const;
+    bool load(const QString & fileName);
+};
+
+#endif // MOTOBJECTSTORE_H
@@ -26,11 +26,17 @@
 
 #include <QDebug>
 #include "mscdatagroup.h"
+#include "crc16.h"
 
 MSCDataGroup::MSCDataGroup(const QByteArray &dataGroup)
+    : MSCDataGroup(reinterpret_cast<const uint8_t *>(dataGroup.constData()), dataGroup.size())
+{
+}
+
+MSCDataGroup::MSCDataGroup(const uint8_t *data, int size)
 {
     m_isValid = false;
-    if (dataGroup.size() <= 0)
+    if (size <= 0)
     {  // no data
         return;
     }
@@ -38,11 +44,11 @@ MSCDataGroup::MSCDataGroup(const QByteArray &dataGroup)
     { /* data available */ }
 
     // some data available => first check header
-    const uint8_t * inputDataPtr = (const uint8_t *) dataGroup.constBegin();
+    const uint8_t * inputDataPtr = data;
     bool crcFlag = (*inputDataPtr & 0x40) != 0;
     if (crcFlag)  // bit 6
     {   // if CRC present, do check CRC16 according to [ETSI EN 300 401, 5.3.3.4]
-        if (!crc16check(dataGroup))
+        if (!Crc16::check(data, size))
         {
             qDebug() << "CRC failed";
             return;
@@ -69,7 +75,7 @@ MSCDataGroup::MSCDataGroup(const QByteArray &dataGroup)
         // Extension field: this 16-bit field shall be used to carry information for CA on data group level
         // (see ETSI TS 102 367 [4]). For other Data group types, the Extension field is reserved for future
         // additions to the Data group header.
-        m_extensionField = (*inputDataPtr << 8) | (*inputDataPtr+1);
+        m_extensionField = (*inputDataPtr << 8) | *(inputDataPtr+1);
         inputDataPtr += 2;
     }
     else
@@ -105,7 +111,8 @@ MSCDataGroup::MSCDataGroup(const QByteArray &dataGroup)
 
         if (m_lengthIndicator - m_transportIdFlag * 2 > 0)
         {   // end user address field is present
-            m_endUserAddrField = QByteArray((const char *) inputDataPtr, (m_lengthIndicator - m_transportIdFlag * 2));
+            m_endUserAddrField = inputDataPtr;
+            m_endUserAddrFieldSize = m_lengthIndicator - m_transportIdFlag * 2;
             inputDataPtr += m_lengthIndicator - m_transportIdFlag * 2;
         }
         else
@@ -115,16 +122,21 @@ MSCDataGroup::MSCDataGroup(const QByteArray &dataGroup)
     {  }
 
     // inputDataPtr -> beginning of MSC data group data field
-    int dataFieldSize = dataGroup.size() - (inputDataPtr - (const uint8_t *) dataGroup.constBegin()) - crcFlag * 2;
+    int dataFieldSize = size - (inputDataPtr - data) - crcFlag * 2;
+    if (dataFieldSize < 0)
+    {   // header is longer than data group
+        return;
+    }
 
-    m_dataField = QByteArray((const char *) inputDataPtr,  dataFieldSize);
+    m_dataField = inputDataPtr;
+    m_dataFieldSize = dataFieldSize;
 
     m_isValid = true;
 }
 
 QByteArray::const_iterator MSCDataGroup::dataFieldConstBegin() const
 {
-    return m_dataField.constBegin();
+    return reinterpret_cast<QByteArray::const_iterator>(m_dataField);
 }
 
 uint8_t MSCDataGroup::getType() const
@@ -151,26 +163,3 @@ bool MSCDataGroup::isValid() const
 {
     return m_isValid;
 }
-
-bool MSCDataGroup::crc16check(const QByteArray & data)
-{
-    uint16_t crc = 0xFFFF;
-    uint16_t mask = 0x1020;
-
-    for (int n = 0; n < data.size()-2; ++n)
-    {
-        for (int bit = 7; bit >= 0; --bit)
-        {
-            uint16_t in = (data[n] >> bit) & 0x1;
-            uint16_t tmp = in ^ ((crc>>15) & 0x1);
-            crc <<= 1;
-
-            crc ^= (tmp * mask);
-            crc += tmp;
-        }
-    }
-
-    uint16_t invTxCRC = ~((uint16_t(data[data.size()-2]) << 8) | uint8_t(data[data.size()-1]));
-
-    return (crc == invTxCRC);
-}
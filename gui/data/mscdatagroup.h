@@ -28,12 +28,18 @@
 #define MSCDATAGROUP_H
 
 #include <QByteArray>
+#include <cstdint>
 
+// view of MSC data group, header is parsed in place and data field points into input buffer
+// input buffer must stay valid as long as data field is accessed
 class MSCDataGroup
 {
 public:
     explicit MSCDataGroup(const QByteArray &dataGroup);
+    MSCDataGroup(const uint8_t * data, int size);
     QByteArray::const_iterator dataFieldConstBegin() const;
+    const uint8_t * dataField() const { return m_dataField; }
+    int dataFieldSize() const { return m_dataFieldSize; }
 
     uint8_t getType() const;
     uint16_t getSegmentNum() const;
@@ -55,10 +61,10 @@ private:
     bool m_transportIdFlag;
     uint8_t m_lengthIndicator;
     uint16_t m_transportId;
-    QByteArray m_endUserAddrField;
-    QByteArray m_dataField;
-
-    bool crc16check(const QByteArray &data);
+    const uint8_t * m_endUserAddrField = nullptr;
+    int m_endUserAddrFieldSize = 0;
+    const uint8_t * m_dataField = nullptr;
+    int m_dataFieldSize = 0;
 };
 
 #endif // MSCDATAGROUP_H
@@ -27,24 +27,39 @@
 #include "dabtables.h"
 #include "slideshowapp.h"
 #include <QDir>
+#include <QCryptographicHash>
 #include <QLoggingCategory>
 #include <QStandardPaths>
 #include <QRegularExpression>
 
 Q_LOGGING_CATEGORY(slideShowApp, "SlideShowApp", QtInfoMsg)
 
-SlideShowApp::SlideShowApp(QObject *parent) : UserApplication(parent)
+SlideShowApp::SlideShowApp(QObject *parent) : UserApplication(parent), m_objectStore("SLS", SLIDESHOWAPP_STORE_MAX_OBJECTS)
 {
     m_decoder = nullptr;
     m_dumpEna = false;
+    m_isRestoring = false;
+    m_decoderGeneration = 0;
+    m_cacheBytes = 0;
+    m_spillDir = nullptr;
+
+    m_decoderPool = new QThreadPool(this);
+    m_decoderPool->setMaxThreadCount(SLIDESHOWAPP_DECODER_THREADS);
 }
 
 SlideShowApp::~SlideShowApp()
 {
+    m_decoderPool->clear();
+    m_decoderPool->waitForDone();
+
     if (nullptr != m_decoder)
     {
         delete m_decoder;
     }
+    if (nullptr != m_spillDir)
+    {
+        delete m_spillDir;
+    }
 }
 
 void SlideShowApp::start()
@@ -71,9 +86,22 @@ void SlideShowApp::stop()
         m_decoder = nullptr;
     }
     m_isRunning = false;
+    m_objectStore.close();
+
+    // slides being decoded belong to previous service
+    m_decoderPool->clear();
+    m_decoderGeneration += 1;
 
     // clear cache
     m_cache.clear();
+    m_cacheLru.clear();
+    m_cacheBytes = 0;
+    m_memory.set(0);
+    if (nullptr != m_spillDir)
+    {   // removes released slides
+        delete m_spillDir;
+        m_spillDir = nullptr;
+    }
 
     // clear categories
     m_catSls.clear();
@@ -88,6 +116,20 @@ void SlideShowApp::restart()
     start();
 }
 
+void SlideShowApp::restoreSlides()
+{
+    m_objectStore.open(m_ueid, m_SId.value(), 0);
+
+    // slides are processed as received from broadcast, oldest first
+    m_isRestoring = true;
+    const QList<MOTObject> objList = m_objectStore.objects();
+    for (const auto & obj : objList)
+    {
+        onNewMOTObject(obj);
+    }
+    m_isRestoring = false;
+}
+
 void SlideShowApp::setDataDumping(const SetupDialog::Settings::UADumpSettings &settings)
 {
     m_dumpEna = settings.slsEna;
@@ -111,6 +153,11 @@ void SlideShowApp::onUserAppData(const RadioControlUserAppData & data)
     {
         // application is running and user application type matches
         // data is for this application
+        if (m_objectStoreEna && !m_objectStore.isOpen() && (0 != m_ueid) && (0 != m_SId.value()))
+        {   // first data for the service => show slides from previous reception
+            restoreSlides();
+        }
+
         // send data to decoder
         m_decoder->newDataGroup(data.data);
     }
@@ -313,20 +360,49 @@ void SlideShowApp::onNewMOTObject(const MOTObject & obj)
     // required for dumping functionality
     slide.setTransportID(obj.getId());
 
-    // we can try to load data to Slide
-    if (!slide.setPixmap(obj.getBody()))
-    {   // loading of data failed
-        return;
-    }
-    else
-    { /* slide body is correct */ }
+    // image is decoded in worker thread, slide is processed when it is ready
+    const int generation = m_decoderGeneration;
+    const bool isRestored = m_isRestoring;
+    m_decoderPool->start([this, slide, obj, generation, isRestored]() mutable {
+        // we can try to load data to Slide
+        if (!slide.setImage(obj.getBody()))
+        {   // loading of data failed
+            return;
+        }
+        else
+        { /* slide body is correct */ }
+
+        QMetaObject::invokeMethod(this, [this, slide, obj, generation, isRestored]() {
+            if (generation == m_decoderGeneration)
+            {
+                processSlide(slide, obj, isRestored);
+            }
+            else
+            { /* application was stopped meanwhile */ }
+        }, Qt::QueuedConnection);
+    });
+}
 
+void SlideShowApp::processSlide(const Slide & slide, const MOTObject & obj, bool isRestored)
+{
     // dump slide if requested
-    if (m_dumpEna)
+    if (m_dumpEna && !isRestored)
     {
         dumpSlide(slide);
     }
 
+    if (!isRestored)
+    {   // keep slide for next reception
+        if (slide.isDecategorizeRequested())
+        {
+            m_objectStore.remove(slide.getContentName());
+        }
+        else
+        {
+            m_objectStore.store(obj);
+        }
+    }
+
     // now we have parsed params -> check for potential request to decategorize
     if (slide.isDecategorizeRequested())
     {   // decategorize
@@ -347,7 +423,7 @@ void SlideShowApp::onNewMOTObject(const MOTObject & obj)
             removeSlideFromCategory(*cacheIt);
 
             // delete slide from cache
-            m_cache.erase(cacheIt);
+            eraseSlide(slide.getContentName());
         }
         else
         { /* item was is not in cache - do nothing */ }
@@ -377,7 +453,7 @@ void SlideShowApp::onNewMOTObject(const MOTObject & obj)
                 removeSlideFromCategory(*cacheIt);
 
                 // delete old slide from cache
-                m_cache.erase(cacheIt);
+                eraseSlide(slide.getContentName());
             }
             else
             {   // new slide is identical - emit it for SLS
@@ -389,7 +465,7 @@ void SlideShowApp::onNewMOTObject(const MOTObject & obj)
         { /* item was is not in cache yet */ }
 
         // adding new slide to cache
-        m_cache.insert(slide.getContentName(), slide);
+        insertSlide(slide);
 #if (USER_APPLICATION_VERBOSE > 1)
         qCDebug(slideShowApp) << "Cache contains" << m_cache.size() << "slides";
 #endif
@@ -512,18 +588,7 @@ void SlideShowApp::dumpSlide(const Slide &slide)
     filename.replace("{contentNameWithExt}", contentName);
 
     //qDebug() << filename << m_dumpPath + filename;
-    QFile file(m_dumpPath + filename);
-    if (!file.exists() || m_dumpOverwrite)
-    {   // file does not exist of overwriting is enabled == > store file
-        QDir dir;
-        dir.mkpath(QFileInfo(file).absolutePath());
-        if (file.open(QIODevice::WriteOnly))
-        {
-            qCInfo(slideShowApp) << "Storing slide:" << file.fileName();
-            file.write(slide.getRawData());
-            file.close();
-        }
-    }
+    m_dumpQueue.enqueue(m_dumpPath + filename, slide.getRawData(), m_dumpOverwrite);
 }
 
 void SlideShowApp::getCurrentCatSlide(int catId)
@@ -531,10 +596,10 @@ void SlideShowApp::getCurrentCatSlide(int catId)
     QHash<int, SlideShowApp::Category>::const_iterator catSlsIt = m_catSls.constFind(catId);
     if (catSlsIt != m_catSls.cend())
     { // category found
-        QHash<QString, Slide>::const_iterator cacheIt = m_cache.constFind(catSlsIt->getCurrentSlide());
-        if (m_cache.cend() != cacheIt)
+        Slide slide = getSlide(catSlsIt->getCurrentSlide());
+        if (!slide.isEmpty())
         {   // found in cache
-            emit catSlide(cacheIt.value(), catId, catSlsIt->getCurrentIndex(), catSlsIt->size());
+            emit catSlide(slide, catId, catSlsIt->getCurrentIndex(), catSlsIt->size());
         }
         else
         { /* not found in cache - this should not happen */ }
@@ -550,10 +615,10 @@ void SlideShowApp::getNextCatSlide(int catId, bool forward)
     QHash<int, SlideShowApp::Category>::iterator catSlsIt = m_catSls.find(catId);
     if (catSlsIt != m_catSls.end())
     { // category found
-        QHash<QString, Slide>::const_iterator cacheIt = m_cache.constFind(catSlsIt->getNextSlide(forward));
-        if (m_cache.cend() != cacheIt)
+        Slide slide = getSlide(catSlsIt->getNextSlide(forward));
+        if (!slide.isEmpty())
         {   // found in cache
-            emit catSlide(cacheIt.value(), catId, catSlsIt->getCurrentIndex(), catSlsIt->size());
+            emit catSlide(slide, catId, catSlsIt->getCurrentIndex(), catSlsIt->size());
         }
         else
         { /* not found in cache - this should not happen */ }
@@ -564,26 +629,139 @@ void SlideShowApp::getNextCatSlide(int catId, bool forward)
     }
 }
 
+void SlideShowApp::insertSlide(const Slide &slide)
+{
+    m_cache.insert(slide.getContentName(), slide);
+    m_cacheLru.append(slide.getContentName());
+    m_cacheBytes += slide.memorySize();
+
+    releaseSlides();
+}
+
+void SlideShowApp::eraseSlide(const QString &contentName)
+{
+    QHash<QString, Slide>::iterator it = m_cache.find(contentName);
+    if (m_cache.end() != it)
+    {
+        m_cacheBytes -= it->memorySize();
+        m_cache.erase(it);
+        m_memory.set(m_cacheBytes);
+    }
+    else
+    { /* not in cache */ }
+
+    m_cacheLru.removeOne(contentName);
+    if (nullptr != m_spillDir)
+    {
+        QFile::remove(spillFileName(contentName));
+    }
+}
+
+Slide SlideShowApp::getSlide(const QString &contentName)
+{
+    QHash<QString, Slide>::iterator it = m_cache.find(contentName);
+    if (m_cache.end() == it)
+    {   // not found in cache
+        return Slide();
+    }
+    else
+    { /* found */ }
+
+    if (!it->isLoaded())
+    {   // slide was released => load it back from disk
+        QFile file(spillFileName(contentName));
+        if (file.open(QIODevice::ReadOnly) && it->setImage(file.readAll()))
+        {
+            m_cacheBytes += it->memorySize();
+        }
+        else
+        {
+            qCWarning(slideShowApp) << "Failed to load released slide" << contentName;
+        }
+    }
+    else
+    { /* slide is in memory */ }
+
+    m_cacheLru.removeOne(contentName);
+    m_cacheLru.append(contentName);
+    Slide slide = *it;
+
+    releaseSlides();
+
+    return slide;
+}
+
+void SlideShowApp::releaseSlides()
+{
+    // least recently used slides are released first, the most recent one is always kept
+    for (int n = 0; (m_cacheBytes > SLIDESHOWAPP_CACHE_MEMORY_BUDGET) && (n < m_cacheLru.size() - 1); ++n)
+    {
+        QHash<QString, Slide>::iterator it = m_cache.find(m_cacheLru.at(n));
+        if ((m_cache.end() != it) && it->isLoaded() && spillSlide(*it))
+        {
+            m_cacheBytes -= it->memorySize();
+            it->release();
+        }
+        else
+        { /* already released or cannot be written */ }
+    }
+    m_memory.set(m_cacheBytes);
+}
+
+bool SlideShowApp::spillSlide(const Slide &slide)
+{
+    if (nullptr == m_spillDir)
+    {
+        m_spillDir = new QTemporaryDir();
+    }
+    if (!m_spillDir->isValid())
+    {   // slide stays in memory
+        return false;
+    }
+
+    QFile file(spillFileName(slide.getContentName()));
+    if (file.exists())
+    {   // original was written when slide was released before
+        return true;
+    }
+    if (file.open(QIODevice::WriteOnly) && (file.write(slide.getRawData()) == slide.getRawData().size()))
+    {
+        return true;
+    }
+
+    qCWarning(slideShowApp) << "Failed to release slide" << slide.getContentName();
+    file.remove();
+    return false;
+}
+
+QString SlideShowApp::spillFileName(const QString &contentName) const
+{
+    return m_spillDir->filePath(QCryptographicHash::hash(contentName.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
 SlideData::SlideData()
 {
-    pixmap = QPixmap(0,0);         // this creates NULL pixmap
+    image = QImage();              // this creates NULL image
     contentName = QString("");
     categoryTitle = QString("");
     clickThroughURL = QString("");
     alternativeLocationURL = QString("");
     format = QString("");
+    transportID = 0;
     categoryID = 0;
     slideID = 0;
     numBytes = 0;
 }
 
-SlideData::SlideData(const SlideData & other) :
-    pixmap(other.pixmap),
+SlideData::SlideData(const SlideData & other) : QSharedData(other),
+    image(other.image),
+    rawData(other.rawData),
     contentName(other.contentName),
     categoryTitle(other.categoryTitle),
     clickThroughURL(other.clickThroughURL),
     alternativeLocationURL(other.alternativeLocationURL),
     format(other.format),
+    transportID(other.transportID),
     categoryID(other.categoryID),
     slideID(other.slideID),
     numBytes(other.numBytes)
@@ -597,14 +775,25 @@ Slide::Slide()
 
 QPixmap Slide::getPixmap() const
 {
-    return d->pixmap;
+    return QPixmap::fromImage(d->image);
 }
 
-bool Slide::setPixmap(const QByteArray &data)
+const QImage &Slide::getImage() const
+{
+    return d->image;
+}
+
+bool Slide::setImage(const QByteArray &data)
 {
     d->numBytes = data.size();
     d->rawData = data;
-    return d->pixmap.loadFromData(data);
+    return d->image.loadFromData(data);
+}
+
+void Slide::release()
+{
+    d->image = QImage();
+    d->rawData.clear();
 }
 
 const QString &Slide::getContentName() const
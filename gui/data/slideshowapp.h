@@ -29,11 +29,21 @@
 
 #include <QObject>
 #include <QPixmap>
+#include <QImage>
 #include <QHash>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTemporaryDir>
 #include <QSharedData>
 #include "radiocontrol.h"
 #include "motdecoder.h"
+#include "motobjectstore.h"
 #include "userapplication.h"
+#include "diagnostics.h"
+
+#define SLIDESHOWAPP_STORE_MAX_OBJECTS 32   // max number of slides stored for each service
+#define SLIDESHOWAPP_DECODER_THREADS    1   // single thread keeps slides in order of reception
+#define SLIDESHOWAPP_CACHE_MEMORY_BUDGET (4*1024*1024)  // slides over budget are released to disk, least recently used first
 
 
 class SlideData : public QSharedData
@@ -43,7 +53,7 @@ public:
     SlideData(const SlideData & other);
     ~SlideData() {}
 
-    QPixmap pixmap;
+    QImage image;
     QByteArray rawData;
     QString contentName;
     QString categoryTitle;
@@ -62,8 +72,11 @@ public:
     Slide();
     Slide(const Slide &other) : d (other.d) { }
 
+    // conversion to pixmap shall be done in GUI thread only
     QPixmap getPixmap() const;
-    bool setPixmap(const QByteArray &data);
+    const QImage & getImage() const;
+    // image decoding is thread safe, it can be done in worker thread
+    bool setImage(const QByteArray &data);
 
     const QString &getContentName() const;
     void setContentName(const QString &newContentName);
@@ -95,6 +108,11 @@ public:
     bool isDecategorizeRequested() const;
     bool isEmpty() const { return d->contentName.isEmpty(); }
 
+    // image and raw data can be released from memory, other parameters are kept
+    bool isLoaded() const { return !d->image.isNull(); }
+    qint64 memorySize() const { return d->image.sizeInBytes() + d->rawData.size(); }
+    void release();
+
     bool operator==(const Slide & other) const;
 
 private:
@@ -141,7 +159,25 @@ signals:
 private:
     MOTDecoder * m_decoder;
     QHash<QString, Slide> m_cache;
+    QStringList m_cacheLru;                 // content names, most recently used last
+    qint64 m_cacheBytes;
+    DiagnosticsMemoryCounter m_memory { DiagnosticsMemory::SlideCache };
+    QTemporaryDir * m_spillDir;
     QHash<int, Category> m_catSls;
+    MOTObjectStore m_objectStore;
+    bool m_isRestoring;
+    QThreadPool * m_decoderPool;
+    int m_decoderGeneration;
+
+    void restoreSlides();
+    void processSlide(const Slide & slide, const MOTObject & obj, bool isRestored);
+
+    void insertSlide(const Slide & slide);
+    void eraseSlide(const QString & contentName);
+    Slide getSlide(const QString & contentName);
+    void releaseSlides();
+    bool spillSlide(const Slide & slide);
+    QString spillFileName(const QString & contentName) const;
 
     void addSlideToCategory(const Slide & slide);
     void removeSlideFromCategory(const Slide & slide);
@@ -25,6 +25,8 @@
  */
 
 #include "spiapp.h"
+#include "spiepgdecoder.h"
+#include "motobjectstore.h"
 #include <QDir>
 #include <QStandardPaths>
 #include <QSaveFile>
@@ -32,34 +34,44 @@
 #include <QNetworkReply>
 #include <QNetworkDiskCache>
 #include <QNetworkProxyFactory>
+#include <cstdio>
 #include <QLoggingCategory>
 #include <QJsonDocument>
 #include <QFile>
+#include <QDataStream>
 
 Q_LOGGING_CATEGORY(spiApp, "SPIApp", QtInfoMsg)
 
 SPIApp::SPIApp(QObject *parent) : UserApplication(parent)
 {
     //m_decoder = nullptr;
-    m_dnsLookup = nullptr;
     m_netAccessManager = nullptr;
     m_useInternet = false;
     m_enaRadioDNS = false;
     m_useDoH = false;
+    m_piXmlOutputEna = false;
+    m_isRestoring = false;
+    loadDnsCache();
+
+    m_epgDecoderPool = new QThreadPool(this);
+    m_epgDecoderPool->setMaxThreadCount(SPI_APP_EPG_DECODER_THREADS);
 }
 
 SPIApp::~SPIApp()
 {
+    // wait for running EPG decoding tasks
+    m_epgDecoderPool->clear();
+    m_epgDecoderPool->waitForDone();
+
     // delete all decoders
     for (const auto & decoder : m_decoderMap)
     {
         delete decoder;
     }
     m_decoderMap.clear();
-    if (nullptr != m_dnsLookup)
-    {
-        delete m_dnsLookup;
-    }
+    qDeleteAll(m_objectStoreMap);
+    m_objectStoreMap.clear();
+    saveDnsCache();
     if (nullptr != m_netAccessManager)
     {
         delete m_netAccessManager;
@@ -75,12 +87,6 @@ void SPIApp::start()
     else
     { /* not running */ }
 
-    if (nullptr == m_dnsLookup)
-    {
-        m_dnsLookup = new QDnsLookup();
-        connect(m_dnsLookup, &QDnsLookup::finished, this, &SPIApp::handleRadioDNSLookup);
-    }
-
     if (nullptr == m_netAccessManager)
     {
         m_netAccessManager = new QNetworkAccessManager();
@@ -115,9 +121,11 @@ void SPIApp::stop()
     if (nullptr != decoderPtr)
     {
         m_parsedDirectoryIds.remove(decoderPtr->getDirectoryId());
+        m_processedObjects.remove(0xFFFF);
         delete decoderPtr;
         m_decoderMap.remove(0xFFFF);
     }
+    delete m_objectStoreMap.take(0xFFFF);
 
     m_motObjRequestList.clear();
 
@@ -138,10 +146,15 @@ void SPIApp::reset()
         delete decoder;
     }
     m_downloadReqQueue.clear();
+    m_activeDownloads.clear();
     m_radioDnsDownloadQueue.clear();
+    abortDnsLookups();
     m_motObjRequestList.clear();
     m_decoderMap.clear();
+    qDeleteAll(m_objectStoreMap);
+    m_objectStoreMap.clear();
     m_parsedDirectoryIds.clear();
+    m_processedObjects.clear();
     m_isRunning = false;
 
     // ask HMI to clear data
@@ -200,8 +213,26 @@ void SPIApp::onUserAppData(const RadioControlUserAppData & data)
             connect(decoderPtr, &MOTDecoder::newMOTDirectory, this, &SPIApp::onNewMOTDirectory);
             connect(decoderPtr, &MOTDecoder::newMOTObjectInDirectory, this, &SPIApp::onNewMOTObjectInDirectory);
             m_decoderMap[data.SCId] = decoderPtr;
+            m_processedObjects.remove(data.SCId);
 
             qCDebug(spiApp) << "Adding MOT decoder for SCID" << data.SCId;
+
+            // objects from previous reception are processed immediately, they are invalidated when MOT directory is received
+            if (m_objectStoreEna && (0 != m_ueid) && (0 != m_SId.value()))
+            {
+                MOTObjectStore * store = new MOTObjectStore("SPI");
+                store->open(m_ueid, m_SId.value(), data.SCId);
+                m_objectStoreMap[data.SCId] = store;
+
+                m_isRestoring = true;
+                const QList<MOTObject> objList = store->objects();
+                for (const auto & obj : objList)
+                {
+                    updateObjectSignature(data.SCId, obj);
+                    processObject(data.SCId, obj);
+                }
+                m_isRestoring = false;
+            }
         }
 
         // send data to decoder
@@ -230,17 +261,45 @@ void SPIApp::onNewMOTDirectory()
         return;
     }
 
+    MOTObjectStore * store = m_objectStoreMap.value(decoderId, nullptr);
+    if (nullptr != store)
+    {   // remove stored objects that are not valid anymore
+        store->invalidate(decoderPtr->directoryBegin(), decoderPtr->directoryEnd());
+    }
+
     MOTObjectCache::const_iterator objIt;
     qCDebug(spiApp, "%d: Processing MOT directory", decoderId);
 
+    // objects removed from directory are forgotten
+    QHash<uint16_t, size_t> & processedObjects = m_processedObjects[decoderId];
+    QHash<uint16_t, size_t> directoryObjects;
+    for (objIt = decoderPtr->directoryBegin(); objIt != decoderPtr->directoryEnd(); ++objIt)
+    {
+        const auto it = processedObjects.constFind(objIt->getId());
+        if (processedObjects.cend() != it)
+        {
+            directoryObjects.insert(it.key(), it.value());
+        }
+    }
+    processedObjects = directoryObjects;
+
+    int numUnchanged = 0;
     for (objIt = decoderPtr->directoryBegin(); objIt != decoderPtr->directoryEnd(); ++objIt)    
     {
         if (objIt->isComplete())
         {
-            qCDebug(spiApp, "%d:     Object %d -> %s [complete]", decoderId, objIt->getId(), objIt->getContentName().toLocal8Bit().data());
-            processObject(decoderId, objIt);
+            if (updateObjectSignature(decoderId, *objIt))
+            {
+                qCDebug(spiApp, "%d:     Object %d -> %s [complete]", decoderId, objIt->getId(), objIt->getContentName().toLocal8Bit().data());
+                processObject(decoderId, *objIt);
+            }
+            else
+            {
+                numUnchanged += 1;
+            }
         }
     }
+    qCDebug(spiApp, "%d: %d objects not changed since previous directory", decoderId, numUnchanged);
 
     if (decoderPtr->directoryIsComplete())
     {
@@ -276,7 +335,10 @@ void SPIApp::onNewMOTObjectInDirectory(const QString &contentName)
     MOTObjectCache::const_iterator objIt = decoderPtr->find(contentName);
     if (objIt != decoderPtr->directoryEnd())
     {
-        processObject(decoderId, objIt);
+        if (updateObjectSignature(decoderId, *objIt))
+        {
+            processObject(decoderId, *objIt);
+        }
         if (decoderPtr->directoryIsComplete())
         {
             m_parsedDirectoryIds[decoderId] = decoderPtr->getDirectoryId();
@@ -294,42 +356,51 @@ void SPIApp::onNewMOTObjectInDirectory(const QString &contentName)
     }
 }
 
-void SPIApp::processObject(uint16_t decoderId, MOTObjectCache::const_iterator objIt)
+void SPIApp::processObject(uint16_t decoderId, const MOTObject & obj)
 {
-    qCDebug(spiApp) << "Processing object:" << objIt->getContentName();
+    qCDebug(spiApp) << "Processing object:" << obj.getContentName();
 
-    if (m_dumpEna)
+    if (!m_isRestoring)
+    {   // store received object
+        MOTObjectStore * store = m_objectStoreMap.value(decoderId, nullptr);
+        if (nullptr != store)
+        {
+            store->store(obj);
+        }
+    }
+
+    if (m_dumpEna && !m_isRestoring)
     {
-        dumpFile(decoderId, objIt->getId(), objIt->getContentName(), objIt->getBody());
+        dumpFile(decoderId, obj.getId(), obj.getContentName(), obj.getBody());
     }
 
-    switch (objIt->getContentType())
+    switch (obj.getContentType())
     {
     case 2:
     {   // logos
-        if (m_motObjRequestList[decoderId].contains(objIt->getContentName()))
+        if (m_motObjRequestList[decoderId].contains(obj.getContentName()))
         {
-            qCDebug(spiApp) << "Found requested file" << objIt->getContentName();
-            emit requestedFile(objIt->getBody(), m_motObjRequestList[decoderId][objIt->getContentName()]);
-            m_motObjRequestList[decoderId].remove(objIt->getContentName());
+            qCDebug(spiApp) << "Found requested file" << obj.getContentName();
+            emit requestedFile(obj.getBody(), m_motObjRequestList[decoderId][obj.getContentName()]);
+            m_motObjRequestList[decoderId].remove(obj.getContentName());
         }
     }
     break;
     case 7:
     {   // SPI content type/subtype values
-        switch (objIt->getContentSubType())
+        switch (obj.getContentSubType())
         {
         case 0:
-            qCDebug(spiApp) << "\tService Information" << objIt->getContentName();
-            parseBinaryInfo(decoderId, *objIt);
+            qCDebug(spiApp) << "\tService Information" << obj.getContentName();
+            parseBinaryInfo(decoderId, obj);
             break;
         case 1:
-            qCDebug(spiApp) << "\tProgramme Information" << objIt->getContentName();
-            parseBinaryInfo(decoderId, *objIt);
+            qCDebug(spiApp) << "\tProgramme Information" << obj.getContentName();
+            parseBinaryInfo(decoderId, obj);
             break;
         case 2:
-            qCDebug(spiApp) << "\tGroup Information" << objIt->getContentName();
-            parseBinaryInfo(decoderId, *objIt);
+            qCDebug(spiApp) << "\tGroup Information" << obj.getContentName();
+            parseBinaryInfo(decoderId, obj);
             break;
         default:
             // not supported
@@ -341,6 +412,20 @@ void SPIApp::processObject(uint16_t decoderId, MOTObjectCache::const_iterator ob
     }
 }
 
+bool SPIApp::updateObjectSignature(uint16_t decoderId, const MOTObject &obj)
+{   // returns true if object is new or it changed since it was processed
+    // header contains content name and all parameters, body is compared as well because it can change without new version
+    size_t signature = qHashMulti(0, obj.getHeader(), obj.getBody());
+    QHash<uint16_t, size_t> & processedObjects = m_processedObjects[decoderId];
+    QHash<uint16_t, size_t>::iterator it = processedObjects.find(obj.getId());
+    if ((processedObjects.end() != it) && (it.value() == signature))
+    {
+        return false;
+    }
+    processedObjects.insert(obj.getId(), signature);
+    return true;
+}
+
 void SPIApp::dumpFile(uint16_t decoderId, int transportId, QString contentName, const QByteArray & data)
 {
     QString filename = m_dumpPattern;
@@ -355,18 +440,7 @@ void SPIApp::dumpFile(uint16_t decoderId, int transportId, QString contentName,
     contentName.replace(regexp, "_");
     filename.replace("{contentName}", contentName);
 
-    QFile file(m_dumpPath + filename);
-    if (!file.exists() || m_dumpOverwrite)
-    {   // file does not exist of overwriting is enabled == > store file
-        QDir dir;
-        dir.mkpath(QFileInfo(file).absolutePath());
-        if (file.open(QIODevice::WriteOnly))
-        {
-            qCInfo(spiApp) << "Storing file:" << file.fileName();
-            file.write(data);
-            file.close();
-        }
-    }
+    m_dumpQueue.enqueue(m_dumpPath + filename, data, m_dumpOverwrite);
 }
 
 void SPIApp::onFileRequest(uint16_t decoderId, const QString &url, const QString &requestId)
@@ -387,6 +461,18 @@ void SPIApp::onFileRequest(uint16_t decoderId, const QString &url, const QString
                 return;
             }
         }
+
+        // try object from previous reception
+        MOTObjectStore * store = m_objectStoreMap.value(decoderId, nullptr);
+        if (nullptr != store)
+        {
+            const QByteArray body = store->getBody(filename);
+            if (!body.isEmpty())
+            {
+                emit requestedFile(body, requestId);
+                return;
+            }
+        }
     }
     // not found
     if (decoderId != SPI_APP_INVALID_DECODER_ID)
@@ -478,6 +564,29 @@ void SPIApp::parseBinaryInfo(uint16_t decoderId, const MOTObject &motObj)
     }
 
     const QByteArray data = motObj.getBody();
+
+    bool isDecoded = false;
+    if ((motObj.getContentSubType() == 1) && !m_piXmlOutputEna)
+    {   // programme information is decoded directly to EPG items in worker thread
+        // this avoids creating XML document that would be parsed again by MetadataManager
+        const QDateTime scopeStartTime = QDateTime::fromString(scopeStart, Qt::ISODate);
+        m_epgDecoderPool->start([this, data, scopeId, scopeStartTime]() {
+            SPIEpgDecoder decoder;
+            QList<SPIEpgSchedule> scheduleList = decoder.decode(data, scopeId, scopeStartTime);
+            if (!scheduleList.isEmpty())
+            {
+                emit epgSchedule(scheduleList);
+            }
+        });
+        isDecoded = true;
+
+        if (!m_dumpEna)
+        {   // XML is not needed
+            return;
+        }
+        else { /* XML is created for dump file */ }
+    }
+
     m_xmldocument.clear();
     m_tokenTable.clear();
     QDomProcessingInstruction header = m_xmldocument.createProcessingInstruction("xml", "version=\"1.0\" encoding=\"utf-8\"");
@@ -526,7 +635,10 @@ void SPIApp::parseBinaryInfo(uint16_t decoderId, const MOTObject &motObj)
         dumpFile(decoderId, motObj.getId(), motObj.getContentName()+".xml", m_xmldocument.toByteArray());
     }
 
-    emit xmlDocument(m_xmldocument.toString(), scopeId, decoderId);
+    if (!isDecoded)
+    {
+        emit xmlDocument(m_xmldocument.toString(), scopeId, decoderId);
+    }
 }
 
 
@@ -624,8 +736,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             {
                 uint8_t tokenId = *dataPtr++;
                 uint8_t tokenLen = *dataPtr++;
-                QString token = QString::fromUtf8((const char *)dataPtr, tokenLen);
-                m_tokenTable.insert(tokenId, token);
+                m_tokenTable.insert(tokenId, dataPtr, tokenLen);
                 bytesRead += tokenLen+2;
                 dataPtr += tokenLen;
             }
@@ -780,16 +891,16 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             case SPIElement::serviceInformation::attribute::version:
                 // ETSI TS 102 371 V3.2.1 (2016-05) [4.8.3 version]
                 // Encoded as a 16-bit unsigned integer.
-                setAttribute_uint16(parentElement, "version", dataPtr, len);
+                setAttribute_uint16(parentElement, QStringLiteral("version"), dataPtr, len);
                 break;
             case SPIElement::serviceInformation::attribute::creationTime:
-                setAttribute_timePoint(parentElement, "creationTime", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("creationTime"), dataPtr, len);
                 break;
             case SPIElement::serviceInformation::attribute::originator:
-                setAttribute_string(parentElement, "originator", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("originator"), dataPtr, len, false);
                 break;
             case SPIElement::serviceInformation::attribute::serviceProvider:
-                setAttribute_string(parentElement, "serviceProvider", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("serviceProvider"), dataPtr, len, false);
                 break;
             }
             break;
@@ -801,7 +912,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::shortName::attribute(tag))
             {
             case SPIElement::shortName::attribute::xml_lang:
-                setAttribute_string(parentElement, "xml:lang", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("xml:lang"), dataPtr, len, false);
                 break;
             }
             break;
@@ -809,7 +920,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::mediumName::attribute(tag))
             {
             case SPIElement::mediumName::attribute::xml_lang:
-                setAttribute_string(parentElement, "xml:lang", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("xml:lang"), dataPtr, len, false);
                 break;
             }
             break;
@@ -817,7 +928,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::longName::attribute(tag))
             {
             case SPIElement::longName::attribute::xml_lang:
-                setAttribute_string(parentElement, "xml:lang", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("xml:lang"), dataPtr, len, false);
                 break;
             }
             break;
@@ -825,7 +936,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::shortDescription::attribute(tag))
             {
             case SPIElement::shortDescription::attribute::xml_lang:
-                setAttribute_string(parentElement, "xml:lang", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("xml:lang"), dataPtr, len, false);
                 break;
             }
             break;
@@ -833,7 +944,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::longDescription::attribute(tag))
             {
             case SPIElement::longDescription::attribute::xml_lang:
-                setAttribute_string(parentElement, "xml:lang", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("xml:lang"), dataPtr, len, false);
                 break;
             }
             break;
@@ -907,7 +1018,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::keywords::attribute(tag))
             {
             case SPIElement::keywords::attribute::xml_lang:
-                setAttribute_string(parentElement, "xml:lang", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("xml:lang"), dataPtr, len, false);
                 break;
             }
             break;
@@ -915,15 +1026,15 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::memberOf::attribute(tag))
             {
             case SPIElement::memberOf::attribute::id:
-                setAttribute_string(parentElement, "id", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("id"), dataPtr, len, false);
                 break;
             case SPIElement::memberOf::attribute::shortId:
                 // ETSI TS 102 371 V3.2.1 (2016-05) [4.7.2]
                 // All attributes defined as shortCRID type are encoded as a 24-bit unsigned integer.
-                setAttribute_uint24(parentElement, "shortId", dataPtr, len);
+                setAttribute_uint24(parentElement, QStringLiteral("shortId"), dataPtr, len);
                 break;
             case SPIElement::memberOf::attribute::index:
-                setAttribute_uint16(parentElement, "index", dataPtr, len);
+                setAttribute_uint16(parentElement, QStringLiteral("index"), dataPtr, len);
                 break;
             }
             break;
@@ -931,19 +1042,19 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::link::attribute(tag))
             {
             case SPIElement::link::attribute::uri:
-                setAttribute_string(parentElement, "uri", dataPtr, len, true);
+                setAttribute_string(parentElement, QStringLiteral("uri"), dataPtr, len, true);
                 break;
             case SPIElement::link::attribute::mimeValue:
-                setAttribute_string(parentElement, "mimeValue", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("mimeValue"), dataPtr, len, false);
                 break;
             case SPIElement::link::attribute::xml_lang:
-                setAttribute_string(parentElement, "xml:lang", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("xml:lang"), dataPtr, len, false);
                 break;
             case SPIElement::link::attribute::description:
-                setAttribute_string(parentElement, "description", dataPtr, len, true);
+                setAttribute_string(parentElement, QStringLiteral("description"), dataPtr, len, true);
                 break;
             case SPIElement::link::attribute::expiryTime:
-                setAttribute_timePoint(parentElement, "expiryTime", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("expiryTime"), dataPtr, len);
                 break;
             }
             break;
@@ -957,17 +1068,17 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::programme_programmeEvent::attribute(tag))
             {
             case SPIElement::programme_programmeEvent::attribute::id:
-                setAttribute_string(parentElement, "id", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("id"), dataPtr, len, false);
                 break;
             case SPIElement::programme_programmeEvent::attribute::shortId:
                 // ETSI TS 102 371 V3.2.1 (2016-05) [4.7.2]
                 // All attributes defined as shortCRID type are encoded as a 24-bit unsigned integer.
-                setAttribute_uint24(parentElement, "shortId", dataPtr, len);
+                setAttribute_uint24(parentElement, QStringLiteral("shortId"), dataPtr, len);
                 break;
             case SPIElement::programme_programmeEvent::attribute::version:
                 // ETSI TS 102 371 V3.2.1 (2016-05) [4.8.3 version]
                 // Encoded as a 16-bit unsigned integer.
-                setAttribute_uint16(parentElement, "version", dataPtr, len);
+                setAttribute_uint16(parentElement, QStringLiteral("version"), dataPtr, len);
                 break;
             case SPIElement::programme_programmeEvent::attribute::recommendation:
                 switch (*dataPtr)
@@ -992,7 +1103,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
                 }
                 break;
             case SPIElement::programme_programmeEvent::attribute::xml_lang:
-                setAttribute_string(parentElement, "xml:lang", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("xml:lang"), dataPtr, len, false);
                 break;
             }
             break;
@@ -1003,13 +1114,13 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             case SPIElement::programmeGroups_schedule::attribute::version:
                 // ETSI TS 102 371 V3.2.1 (2016-05) [4.8.3 version]
                 // Encoded as a 16-bit unsigned integer.
-                setAttribute_uint16(parentElement, "version", dataPtr, len);
+                setAttribute_uint16(parentElement, QStringLiteral("version"), dataPtr, len);
                 break;
             case SPIElement::programmeGroups_schedule::attribute::creationTime:
-                setAttribute_timePoint(parentElement, "creationTime", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("creationTime"), dataPtr, len);
                 break;
             case SPIElement::programmeGroups_schedule::attribute::originator:
-                setAttribute_string(parentElement, "originator", dataPtr, len, true);
+                setAttribute_string(parentElement, QStringLiteral("originator"), dataPtr, len, true);
                 break;
             }
             break;
@@ -1017,17 +1128,17 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::programmeGroup::attribute(tag))
             {
             case SPIElement::programmeGroup::attribute::id:
-                setAttribute_string(parentElement, "id", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("id"), dataPtr, len, false);
                 break;
             case SPIElement::programmeGroup::attribute::shortId:
                 // ETSI TS 102 371 V3.2.1 (2016-05) [4.7.2]
                 // All attributes defined as shortCRID type are encoded as a 24-bit unsigned integer.
-                setAttribute_uint24(parentElement, "shortId", dataPtr, len);
+                setAttribute_uint24(parentElement, QStringLiteral("shortId"), dataPtr, len);
                 break;
             case SPIElement::programmeGroup::attribute::version:
                 // ETSI TS 102 371 V3.2.1 (2016-05) [4.8.3 version]
                 // Encoded as a 16-bit unsigned integer.
-                setAttribute_uint16(parentElement, "version", dataPtr, len);
+                setAttribute_uint16(parentElement, QStringLiteral("version"), dataPtr, len);
                 break;
             case SPIElement::programmeGroup::attribute::type:
                 switch (*dataPtr)
@@ -1061,7 +1172,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             case SPIElement::programmeGroup::attribute::numOfItems:
                 // ETSI TS 102 371 V3.2.1 (2016-05) [4.8.4 numOfItems]
                 // Encoded as a 16-bit unsigned integer.
-                setAttribute_uint16(parentElement, "numOfItems", dataPtr, len);
+                setAttribute_uint16(parentElement, QStringLiteral("numOfItems"), dataPtr, len);
                 break;
             }
             break;
@@ -1069,10 +1180,10 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::scope::attribute(tag))
             {
             case SPIElement::scope::attribute::startTime:
-                setAttribute_timePoint(parentElement, "startTime", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("startTime"), dataPtr, len);
                 break;
             case SPIElement::scope::attribute::stopTime:
-                setAttribute_timePoint(parentElement, "stopTime", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("stopTime"), dataPtr, len);
                 break;
             }
             break;
@@ -1082,7 +1193,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             case SPIElement::serviceScope::attribute::id:
                 // When the domain of the id attribute matches the delivery system, it shall be encoded according to clause 4.7.6.
                 // ==> bearerURI DAB
-                setAttribute_dabBearerURI(parentElement, "id", dataPtr, len);
+                setAttribute_dabBearerURI(parentElement, QStringLiteral("id"), dataPtr, len);
                 break;
             }
             break;
@@ -1104,7 +1215,7 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             case SPIElement::service::attribute::version:
                 // ETSI TS 102 371 V3.2.1 (2016-05) [4.8.3 version]
                 // Encoded as a 16-bit unsigned integer.
-                setAttribute_uint16(parentElement, "version", dataPtr, len);
+                setAttribute_uint16(parentElement, QStringLiteral("version"), dataPtr, len);
                 break;
             }
             break;
@@ -1121,10 +1232,10 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             case SPIElement::bearer::attribute::id:
                 // When the domain of the id attribute matches the delivery system, it shall be encoded according to clause 4.7.6.
                 // ==> bearerURI DAB
-                setAttribute_dabBearerURI(parentElement, "id", dataPtr, len);
+                setAttribute_dabBearerURI(parentElement, QStringLiteral("id"), dataPtr, len);
                 break;
             case SPIElement::bearer::attribute::url:
-                setAttribute_string(parentElement, "url", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("url"), dataPtr, len, false);
                 break;
             }
 
@@ -1134,13 +1245,13 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::multimedia::attribute(tag))
             {
             case SPIElement::multimedia::attribute::mimeValue:
-                setAttribute_string(parentElement, "mimeValue", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("mimeValue"), dataPtr, len, false);
                 break;
             case SPIElement::multimedia::attribute::xml_lang:
-                setAttribute_string(parentElement, "xml:lang", dataPtr, len, false);
+                setAttribute_string(parentElement, QStringLiteral("xml:lang"), dataPtr, len, false);
                 break;
             case SPIElement::multimedia::attribute::url:
-                setAttribute_string(parentElement, "url", dataPtr, len, true);
+                setAttribute_string(parentElement, QStringLiteral("url"), dataPtr, len, true);
                 break;
             case SPIElement::multimedia::attribute::type:
                 switch (*dataPtr)
@@ -1158,10 +1269,10 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
 
                 break;
             case SPIElement::multimedia::attribute::width:
-                setAttribute_uint16(parentElement, "width", dataPtr, len);
+                setAttribute_uint16(parentElement, QStringLiteral("width"), dataPtr, len);
                 break;
             case SPIElement::multimedia::attribute::height:
-                setAttribute_uint16(parentElement, "height", dataPtr, len);
+                setAttribute_uint16(parentElement, QStringLiteral("height"), dataPtr, len);
                 break;
             }
             break;
@@ -1170,16 +1281,16 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::time_relativeTime::attribute(tag))
             {
             case SPIElement::time_relativeTime::attribute::time:
-                setAttribute_timePoint(parentElement, "time", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("time"), dataPtr, len);
                 break;
             case SPIElement::time_relativeTime::attribute::duration:
-                setAttribute_duration(parentElement, "duration", dataPtr, len);
+                setAttribute_duration(parentElement, QStringLiteral("duration"), dataPtr, len);
                 break;
             case SPIElement::time_relativeTime::attribute::actualTime:
-                setAttribute_timePoint(parentElement, "actualTime", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("actualTime"), dataPtr, len);
                 break;
             case SPIElement::time_relativeTime::attribute::actualDuration:
-                setAttribute_duration(parentElement, "actualDuration", dataPtr, len);
+                setAttribute_duration(parentElement, QStringLiteral("actualDuration"), dataPtr, len);
                 break;
             }
             break;
@@ -1187,10 +1298,10 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::radiodns::attribute(tag))
             {
             case SPIElement::radiodns::attribute::fqdn:
-                setAttribute_string(parentElement, "fqdn", dataPtr, len, true);
+                setAttribute_string(parentElement, QStringLiteral("fqdn"), dataPtr, len, true);
                 break;
             case SPIElement::radiodns::attribute::serviceIdentifier:
-                setAttribute_string(parentElement, "serviceIdentifier", dataPtr, len, true);
+                setAttribute_string(parentElement, QStringLiteral("serviceIdentifier"), dataPtr, len, true);
                 break;
             }
             break;
@@ -1198,10 +1309,10 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::geolocation::attribute(tag))
             {
             case SPIElement::geolocation::attribute::xml_id:
-                setAttribute_string(parentElement, "xml:id", dataPtr, len, true);
+                setAttribute_string(parentElement, QStringLiteral("xml:id"), dataPtr, len, true);
                 break;
             case SPIElement::geolocation::attribute::ref:
-                setAttribute_string(parentElement, "ref", dataPtr, len, true);
+                setAttribute_string(parentElement, QStringLiteral("ref"), dataPtr, len, true);
                 break;
             }
             break;
@@ -1217,13 +1328,13 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::presentationTime::attribute(tag))
             {
             case SPIElement::presentationTime::attribute::start:
-                setAttribute_timePoint(parentElement, "start", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("start"), dataPtr, len);
                 break;
             case SPIElement::presentationTime::attribute::end:
-                setAttribute_timePoint(parentElement, "end", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("end"), dataPtr, len);
                 break;
             case SPIElement::presentationTime::attribute::duration:
-                setAttribute_duration(parentElement, "duration", dataPtr, len);
+                setAttribute_duration(parentElement, QStringLiteral("duration"), dataPtr, len);
                 break;
             }
             break;
@@ -1231,10 +1342,10 @@ uint32_t SPIApp::parseTag(const uint8_t * dataPtr, QDomElement & parentElement,
             switch (SPIElement::acquisitionTime::attribute(tag))
             {
             case SPIElement::acquisitionTime::attribute::start:
-                setAttribute_timePoint(parentElement, "start", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("start"), dataPtr, len);
                 break;
             case SPIElement::acquisitionTime::attribute::end:
-                setAttribute_timePoint(parentElement, "end", dataPtr, len);
+                setAttribute_timePoint(parentElement, QStringLiteral("end"), dataPtr, len);
                 break;
             }
             break;
@@ -1262,78 +1373,19 @@ const uint8_t *SPIApp::parseAttributes(const uint8_t *attrPtr, uint8_t tag, int
 }
 
 QString SPIApp::getString(const uint8_t *dataPtr, int len, bool doReplaceTokens)
-{
-    QString str = QString::fromUtf8((const char *) dataPtr, len);
-
-    if (!doReplaceTokens)
-    {   // we are done
-        return str;
-    }
-    else { /* need to replace tokens */ }
-
-    // replace tokens with strings
-    QHash<uint8_t, QString>::const_iterator it = m_tokenTable.constBegin();
-    while (it != m_tokenTable.cend())
-    {
-        str = str.replace(QChar(it.key()), it.value());
-        ++it;
-    }
-
-    return str;
+{   // tokens are expanded in one pass
+    return m_tokenTable.getString(dataPtr, len, doReplaceTokens);
 }
 
 void SPIApp::setAttribute_string(QDomElement & element, const QString & name, const uint8_t *dataPtr, int len, bool doReplaceTokens)
 {
-    QString str = getString(dataPtr, len, doReplaceTokens);
-    element.setAttribute(name, str);
+    element.setAttribute(name, m_tokenTable.getString(dataPtr, len, doReplaceTokens));
 }
 
 QString SPIApp::getTime(const uint8_t *dataPtr, int len)
 {
-    if (len < 4)
-    {   // not enough data
-        qCDebug(spiApp) << "not enough data";
-
-        return QString();
-    }
-    else { /* enough data */}
-
-    // QString dbg;
-    // for (int n = 0; n<len; ++n)
-    // {
-    //     dbg += QString("%1").arg(static_cast<int>(dataPtr[n]), 2, 16, QChar('0'));
-    // }
-
-    uint32_t dateHoursMinutes = *dataPtr++;
-    dateHoursMinutes = (dateHoursMinutes << 8) + *dataPtr++;
-    dateHoursMinutes = (dateHoursMinutes << 8) + *dataPtr++;
-    dateHoursMinutes = (dateHoursMinutes << 8) + *dataPtr++;
-
-    uint16_t secMsec = 0;
-    if (dateHoursMinutes & (1 << 11))
-    {   // UTC flag
-        secMsec = *dataPtr << 8;
-        dataPtr += 2;  // rfu
-    }
-    else { /* short form */ }
-
-    int8_t lto = 0;
-    if (dateHoursMinutes & (1 << 12))
-    {   // LTO flag
-        lto = *dataPtr & 0x1F;
-        if (*dataPtr & (1 << 5))
-        {
-            lto = -lto;
-        }
-        else { /* positive */ }
-    }
-    else { /* no LTO */ }
-
-    // construct time
-    QDateTime dateAndTime = DabTables::dabTimeToUTC(dateHoursMinutes, secMsec).toOffsetFromUtc(60*(lto * 30));
-
     // convert to string
-    return dateAndTime.toString(Qt::ISODateWithMs);
+    return SPIEpgDecoder::getDateTime(dataPtr, len).toString(Qt::ISODateWithMs);
 }
 
 QString SPIApp::getDoubleList(const uint8_t *dataPtr, int len)
@@ -1346,6 +1398,7 @@ QString SPIApp::getDoubleList(const uint8_t *dataPtr, int len)
     // representing the value of longitude multiplied by 46 000 (i.e. in 1/46 000 of a degree, ca. 2,4 m).
 
     QString doubleList;
+    doubleList.reserve((len / 6) * 24);
 
     while (len >= 6)
     {
@@ -1363,7 +1416,7 @@ QString SPIApp::getDoubleList(const uint8_t *dataPtr, int len)
 
         len -= 6;
 
-        doubleList += QString("%1 %2 ").arg(lat).arg(lon);
+        doubleList.append(QString::number(lat)).append(QLatin1Char(' ')).append(QString::number(lon)).append(QLatin1Char(' '));
     }
 
     return doubleList;
@@ -1429,50 +1482,15 @@ void SPIApp::setAttribute_duration(QDomElement &element, const QString &name, co
     uint16_t numSec = *dataPtr++;
     numSec = (numSec << 8) | *dataPtr++;
 
-    QTime time = QTime(0, 0).addSecs(numSec);
-    element.setAttribute(name, QString("PT%1H%2M%3S").arg(time.hour()).arg(time.minute()).arg(time.second()));
+    // formatted to stack buffer, only attribute value is allocated
+    char buf[24];
+    int n = std::snprintf(buf, sizeof(buf), "PT%dH%dM%dS", numSec / 3600, (numSec / 60) % 60, numSec % 60);
+    element.setAttribute(name, QString::fromLatin1(buf, n));
 }
 
 QString SPIApp::getBearerURI(const uint8_t *dataPtr, int len)
 {
-    if (len >= 6)
-    {
-        uint8_t longSId = *dataPtr & 0x10;
-
-        uint8_t scids = *dataPtr++ & 0x0F;
-        uint8_t ecc = *dataPtr++;
-        uint16_t eid = *dataPtr++;
-        eid = (eid << 8) | *dataPtr++;
-        if (longSId)
-        {  // long SId
-            if (len >= 8)
-            {
-                uint32_t sid = *dataPtr++;
-                sid = (sid << 8) | *dataPtr++;
-                sid = (sid << 8) | *dataPtr++;
-                sid = (sid << 8) | *dataPtr;
-                return QString("dab:%1%2.%3.%4.%5")
-                    .arg((sid >> 20) & 0x0F, 1, 16)
-                    .arg(ecc, 2, 16, QChar('0'))
-                    .arg(eid, 4, 16, QChar('0'))
-                    .arg(sid, 8, 16, QChar('0'))
-                    .arg(scids);
-            }
-            else { /* not enough data */ }
-        }
-        else
-        {  // short SId
-            uint32_t sid = *dataPtr++;
-            sid = (sid << 8) | *dataPtr;
-            return QString("dab:%1%2.%3.%4.%5")
-                .arg((sid >> 12) & 0x0F, 1, 16)
-                .arg(ecc, 2, 16, QChar('0'))
-                .arg(eid, 4, 16, QChar('0'))
-                .arg(sid, 4, 16, QChar('0'))
-                .arg(scids);
-        }
-    }
-    return QString();
+    return SPIEpgDecoder::getBearerURI(dataPtr, len);
 }
 
 void SPIApp::setAttribute_dabBearerURI(QDomElement &element, const QString &name, const uint8_t *dataPtr, int len)
@@ -1486,61 +1504,213 @@ void SPIApp::setAttribute_dabBearerURI(QDomElement &element, const QString &name
 
 }
 
-void SPIApp::radioDNSLookup(const QString &fqdn)
+void SPIApp::radioDNSLookup(const QString &fqdn, bool isPriority)
 {
     if (m_useDoH)
     {   // DNS over http
         QString cnameUrl = QString("https://dns.google/resolve?name=%1&type=CNAME").arg(fqdn);
         qCDebug(spiApp) << "DNS CNAME query:" << cnameUrl;
         downloadFile(cnameUrl, "DOH_CNAME", false);
+        return;
     }
-    else {
-        if (m_dnsCache.contains(fqdn))
-        {   // we have record in cache
-            if (!m_radioDnsDownloadQueue.isEmpty())
-            {   // take record from the queue
-                QString file = m_radioDnsDownloadQueue.dequeue().second;
-
-                if (!m_dnsCache[fqdn].isEmpty())
-                {   // valid address
-                    downloadFile(QString("%1/radiodns/spi/3.1/%3").arg(m_dnsCache[fqdn]).arg(file), "XML|"+file);
-                }
-                else
-                {
-                    qCDebug(spiApp) << "Invalid DNS record for" << fqdn << file;
-                }
 
-                // next dns lookup
-                if (!m_radioDnsDownloadQueue.isEmpty()) {
-                    QString fqdn = m_radioDnsDownloadQueue.head().first;
-                    radioDNSLookup(fqdn);
-                }
+    for (const auto & lookup : std::as_const(m_activeDnsLookups))
+    {
+        if (lookup.fqdn == fqdn)
+        {   // already being resolved
+            return;
+        }
+    }
 
-            }
+    int idx = m_dnsLookupQueue.indexOf(fqdn);
+    if (idx >= 0)
+    {   // already waiting
+        if (isPriority && (idx > 0))
+        {
+            m_dnsLookupQueue.move(idx, 0);
+        }
+        return;
+    }
+
+    if (isPriority)
+    {
+        m_dnsLookupQueue.prepend(fqdn);
+    }
+    else
+    {
+        m_dnsLookupQueue.append(fqdn);
+    }
+    startDnsLookups();
+}
+
+void SPIApp::startDnsLookups()
+{
+    while ((m_activeDnsLookups.size() < SPI_APP_MAX_DNS_LOOKUPS) && !m_dnsLookupQueue.isEmpty())
+    {
+        QString fqdn = m_dnsLookupQueue.takeFirst();
+        QDnsLookup * lookup = new QDnsLookup(QDnsLookup::CNAME, fqdn, this);
+        connect(lookup, &QDnsLookup::finished, this, [this, lookup]() { handleRadioDNSLookup(lookup); });
+        m_activeDnsLookups.insert(lookup, DnsLookup{fqdn, UINT32_MAX});
+        lookup->lookup();
+    }
+}
+
+void SPIApp::abortDnsLookups()
+{
+    m_dnsLookupQueue.clear();
+    for (auto it = m_activeDnsLookups.cbegin(); it != m_activeDnsLookups.cend(); ++it)
+    {
+        QDnsLookup * lookup = it.key();
+        disconnect(lookup, nullptr, this, nullptr);
+        lookup->abort();
+        lookup->deleteLater();
+    }
+    m_activeDnsLookups.clear();
+}
+
+void SPIApp::finishDnsLookup(QDnsLookup *lookup, const QString &address, uint32_t ttl)
+{
+    QString fqdn = m_activeDnsLookups.take(lookup).fqdn;
+    lookup->deleteLater();
+
+    onRadioDNSResolved(fqdn, address, ttl);
+
+    if (m_dnsLookupQueue.isEmpty() && m_activeDnsLookups.isEmpty())
+    {   // all pending FQDNs resolved, cache is stored to be available after restart
+        saveDnsCache();
+    }
+    else
+    {
+        startDnsLookups();
+    }
+}
+
+void SPIApp::requestRadioDNSFile(const QString &fqdn, const QString &file, bool isPriority)
+{
+    if (m_useDoH)
+    {   // DNS over http resolves SI only
+        radioDNSLookup(fqdn);
+        return;
+    }
+
+    QHash<QString, DnsCacheEntry>::const_iterator it = m_dnsCache.constFind(fqdn);
+    if ((m_dnsCache.cend() != it) && (it->expires > QDateTime::currentDateTimeUtc()))
+    {   // we have valid record in cache, no lookup needed
+        if (!it->address.isEmpty())
+        {
+            downloadFile(QString("%1/radiodns/spi/3.1/%2").arg(it->address, file), "XML|"+file, false, isPriority);
         }
         else
         {
-            m_dnsLookup->setType(QDnsLookup::CNAME);
-            m_dnsLookup->setName(fqdn);
-            m_dnsLookup->lookup();
+            qCDebug(spiApp) << "Invalid DNS record for" << fqdn << file;
         }
+        return;
     }
+
+    // request waits until FQDN is resolved, lookups of different FQDNs run in parallel
+    m_radioDnsDownloadQueue.append({fqdn, file, isPriority});
+    radioDNSLookup(fqdn, isPriority);
 }
 
-void SPIApp::getSI(const ServiceListId &servId, const uint32_t & ueid)
+void SPIApp::onRadioDNSResolved(const QString &fqdn, const QString &address, uint32_t ttl)
 {
-    if (m_useInternet && m_enaRadioDNS)
-    {   // query RadioDNS
-        if (m_radioDnsDownloadQueue.isEmpty())
+    // empty address is cached as well to avoid repeated lookups of services without RadioDNS
+    m_dnsCache[fqdn] = DnsCacheEntry{address, QDateTime::currentDateTimeUtc().addSecs(ttl)};
+    m_dnsCacheChanged = true;
+
+    // all requests waiting for this FQDN are served now
+    QList<RadioDNSRequest> queue;
+    for (const auto & request : std::as_const(m_radioDnsDownloadQueue))
+    {
+        if (request.fqdn == fqdn)
         {
-            m_radioDnsDownloadQueue.enqueue({radioDNSFQDN(servId, ueid), "SI.xml"});
-            radioDNSLookup(radioDNSFQDN(servId, ueid));
+            if (!address.isEmpty())
+            {
+                downloadFile(QString("%1/radiodns/spi/3.1/%2").arg(address, request.file), "XML|"+request.file, false, request.isPriority);
+            }
+            else
+            {
+                qCDebug(spiApp) << "Invalid DNS record for" << fqdn << request.file;
+            }
         }
         else
         {
-            m_radioDnsDownloadQueue.enqueue({radioDNSFQDN(servId, ueid), "SI.xml"});
+            queue.append(request);
+        }
+    }
+    m_radioDnsDownloadQueue = queue;
+}
+
+void SPIApp::loadDnsCache()
+{
+    m_dnsCacheChanged = false;
+    QFile file(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/RadioDNS.cache");
+    if (!file.open(QIODevice::ReadOnly))
+    {   // no cache yet
+        return;
+    }
+
+    QDataStream in(&file);
+    quint32 magic;
+    quint16 version;
+    in >> magic >> version;
+    if ((SPI_APP_DNS_CACHE_MAGIC != magic) || (SPI_APP_DNS_CACHE_VERSION != version))
+    {
+        qCDebug(spiApp) << "Unsupported RadioDNS cache file";
+        return;
+    }
+
+    QDateTime currentTime = QDateTime::currentDateTimeUtc();
+    while (!in.atEnd() && (QDataStream::Ok == in.status()))
+    {
+        QString fqdn;
+        DnsCacheEntry entry;
+        in >> fqdn >> entry.address >> entry.expires;
+        if ((QDataStream::Ok == in.status()) && (entry.expires > currentTime))
+        {   // only valid records are used
+            m_dnsCache.insert(fqdn, entry);
         }
     }
+    qCDebug(spiApp) << "RadioDNS cache loaded," << m_dnsCache.size() << "records";
+}
+
+void SPIApp::saveDnsCache()
+{
+    if (!m_dnsCacheChanged)
+    {
+        return;
+    }
+
+    QDir().mkpath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    QSaveFile file(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/RadioDNS.cache");
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qCWarning(spiApp) << "Failed to store RadioDNS cache";
+        return;
+    }
+
+    QDataStream out(&file);
+    out << quint32(SPI_APP_DNS_CACHE_MAGIC) << quint16(SPI_APP_DNS_CACHE_VERSION);
+    QDateTime currentTime = QDateTime::currentDateTimeUtc();
+    for (auto it = m_dnsCache.cbegin(); it != m_dnsCache.cend(); ++it)
+    {
+        if (it->expires > currentTime)
+        {
+            out << it.key() << it->address << it->expires;
+        }
+    }
+    if (file.commit())
+    {
+        m_dnsCacheChanged = false;
+    }
+}
+
+void SPIApp::getSI(const ServiceListId &servId, const uint32_t & ueid)
+{
+    if (m_useInternet && m_enaRadioDNS)
+    {   // query RadioDNS
+        requestRadioDNSFile(radioDNSFQDN(servId, ueid), "SI.xml", isPriorityService(servId));
+    }
 }
 
 void SPIApp::getPI(const ServiceListId &servId, const QList<uint32_t> &ueidList, const QDate & date)
@@ -1548,19 +1718,18 @@ void SPIApp::getPI(const ServiceListId &servId, const QList<uint32_t> &ueidList,
     if (m_useInternet && m_enaRadioDNS)
     {   // query RadioDNS
         for (const auto & ueid : ueidList) {
-            if (m_radioDnsDownloadQueue.isEmpty())
-            {
-                m_radioDnsDownloadQueue.enqueue({radioDNSFQDN(servId, ueid), QString("%1/%2_PI.xml").arg(radioDNSServiceIdentifier(servId, ueid), date.toString("yyyyMMdd"))});
-                radioDNSLookup(radioDNSFQDN(servId, ueid));
-            }
-            else
-            {
-                m_radioDnsDownloadQueue.enqueue({radioDNSFQDN(servId, ueid), QString("%1/%2_PI.xml").arg(radioDNSServiceIdentifier(servId, ueid), date.toString("yyyyMMdd"))});
-            }
+            requestRadioDNSFile(radioDNSFQDN(servId, ueid),
+                                QString("%1/%2_PI.xml").arg(radioDNSServiceIdentifier(servId, ueid), date.toString("yyyyMMdd")),
+                                isPriorityService(servId));
         }
     }
 }
 
+bool SPIApp::isPriorityService(const ServiceListId &servId) const
+{   // data for currently selected service is downloaded first
+    return servId.sid() == m_SId.value();
+}
+
 QString SPIApp::radioDNSFQDN(const ServiceListId &servId, const uint32_t & ueid) const
 {
     DabSId sid(servId.sid());
@@ -1583,71 +1752,66 @@ QString SPIApp::radioDNSServiceIdentifier(const ServiceListId &servId, const uin
         .arg(sid.gcc(), 3, 16, QChar('0'));
 }
 
-void SPIApp::handleRadioDNSLookup()
+void SPIApp::handleRadioDNSLookup(QDnsLookup *lookup)
 {
+    QHash<QDnsLookup *, DnsLookup>::iterator it = m_activeDnsLookups.find(lookup);
+    if (m_activeDnsLookups.end() == it)
+    {   // do nothing, it can happen on reset
+        lookup->deleteLater();
+        return;
+    }
+
     // Check the lookup succeeded.
-    if (m_dnsLookup->error() != QDnsLookup::NoError)
+    if (lookup->error() != QDnsLookup::NoError)
     {        
-        qCWarning(spiApp) << "DNS lookup failed:" << m_dnsLookup->name();
-        if (m_dnsLookup->name().startsWith("_radioepg._tcp."))
+        qCWarning(spiApp) << "DNS lookup failed:" << lookup->name();
+        if (lookup->name().startsWith("_radioepg._tcp."))
         {   // try non TLS lookup
-            QString name = m_dnsLookup->name().replace("_radioepg._tcp.", "_radiospi._tcp.");
-            m_dnsLookup->setName(name);
-            m_dnsLookup->lookup();
+            QString name = lookup->name().replace("_radioepg._tcp.", "_radiospi._tcp.");
+            lookup->setName(name);
+            lookup->lookup();
             return;
         }
-        if (!m_radioDnsDownloadQueue.isEmpty())
-        {
-            QString fqdn = m_radioDnsDownloadQueue.dequeue().first;
-            m_dnsCache[fqdn] = "";   // invalid record in cache
-            if (!m_radioDnsDownloadQueue.isEmpty()) {
-                QString fqdn = m_radioDnsDownloadQueue.head().first;
-                radioDNSLookup(fqdn);
-            }
-        }
+        // invalid record in cache, non-existing domain is valid answer while other errors are retried sooner
+        finishDnsLookup(lookup, QString(), (QDnsLookup::NotFoundError == lookup->error()) ? SPI_APP_DNS_CACHE_MIN_TTL
+                                                                                           : SPI_APP_DNS_CACHE_ERROR_TTL);
         return;
     }
 
     // Handle the results.
-    if (m_dnsLookup->canonicalNameRecords().count() > 0)
+    if (lookup->canonicalNameRecords().count() > 0)
     {
-        const auto & record = m_dnsLookup->canonicalNameRecords().at(0);
+        const auto & record = lookup->canonicalNameRecords().at(0);
         qCDebug(spiApp) << "canonicalNameRecord:" << record.name() << record.value();
-        m_dnsLookup->setType(QDnsLookup::SRV);
+        it->ttl = qMin(it->ttl, record.timeToLive());
+        lookup->setType(QDnsLookup::SRV);
         // giving priority to non TLS (against standard)
-        m_dnsLookup->setName("_radioepg._tcp." + record.value());
-        //m_dnsLookup->setName("_radiospi._tcp." + record.value());
-        m_dnsLookup->lookup();
+        lookup->setName("_radioepg._tcp." + record.value());
+        //lookup->setName("_radiospi._tcp." + record.value());
+        lookup->lookup();
     }
-    else if (m_dnsLookup->serviceRecords().count() > 0)
+    else if (lookup->serviceRecords().count() > 0)
     {
-        const auto & record = m_dnsLookup->serviceRecords().at(0);        
+        const auto & record = lookup->serviceRecords().at(0);        
         qCDebug(spiApp) << "serviceRecord:" << record.name() << record.target() << record.port();
-        if (!m_radioDnsDownloadQueue.isEmpty())
+        QString address;
+        if (record.name().startsWith("_radiospi._tcp."))
         {
-            QPair<QString, QString> request = m_radioDnsDownloadQueue.dequeue();
-            QString fqdn = request.first;
-            QString address;
-            if (record.name().startsWith("_radiospi._tcp."))
-            {
-                address = QString("https://%1:%2").arg(record.target()).arg(record.port());
-            }
-            else
-            {
-                address = QString("http://%1:%2").arg(record.target()).arg(record.port());
-            }
-            m_dnsCache[fqdn] = address;
-            QString file = request.second;
-            downloadFile(QString("%1/radiodns/spi/3.1/%3").arg(address).arg(file), "XML|"+file);
-            if (!m_radioDnsDownloadQueue.isEmpty()) {
-                QString fqdn = m_radioDnsDownloadQueue.head().first;
-                radioDNSLookup(fqdn);
-            }
+            address = QString("https://%1:%2").arg(record.target()).arg(record.port());
+        }
+        else
+        {
+            address = QString("http://%1:%2").arg(record.target()).arg(record.port());
         }
+        finishDnsLookup(lookup, address, qMax(qMin(it->ttl, record.timeToLive()), uint32_t(SPI_APP_DNS_CACHE_MIN_TTL)));
+    }
+    else
+    {   // no record, service has no RadioDNS
+        finishDnsLookup(lookup, QString(), SPI_APP_DNS_CACHE_MIN_TTL);
     }
 }
 
-void SPIApp::downloadFile(const QString &url, const QString &requestId, bool useCache)
+void SPIApp::downloadFile(const QString &url, const QString &requestId, bool useCache, bool isPriority)
 {
     qCDebug(spiApp) << Q_FUNC_INFO << url;
     if (!m_useInternet)
@@ -1655,34 +1819,55 @@ void SPIApp::downloadFile(const QString &url, const QString &requestId, bool use
         return;
     }
 
-    if (m_downloadReqQueue.isEmpty()) {
-        m_downloadReqQueue.enqueue({url, requestId});
-
-        QNetworkRequest request;
-        if (useCache)
+    if (isPriority)
+    {   // after other priority requests
+        int n = 0;
+        while ((n < m_downloadReqQueue.size()) && m_downloadReqQueue.at(n).isPriority)
         {
-            request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+            ++n;
         }
-        request.setUrl(QUrl(url));
-        m_netAccessManager->get(request);
+        m_downloadReqQueue.insert(n, {url, requestId, useCache, isPriority});
     }
     else
     {
-        m_downloadReqQueue.enqueue({url, requestId});
+        m_downloadReqQueue.append({url, requestId, useCache, isPriority});
+    }
+
+    startDownloads();
+}
+
+void SPIApp::startDownloads()
+{
+    while ((m_activeDownloads.size() < SPI_APP_MAX_DOWNLOADS) && !m_downloadReqQueue.isEmpty())
+    {
+        DownloadRequest req = m_downloadReqQueue.takeFirst();
+
+        QNetworkRequest request;
+        if (req.useCache)
+        {
+            request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+        }
+        else
+        { /* cached file is validated by conditional request (ETag / Last-Modified) */ }
+        request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+        request.setUrl(QUrl(req.url));
+        m_activeDownloads.insert(m_netAccessManager->get(request), req);
     }
 }
 
 void SPIApp::onFileDownloaded(QNetworkReply *reply)
 {
-    if (m_downloadReqQueue.isEmpty())
+    QHash<QNetworkReply *, DownloadRequest>::iterator it = m_activeDownloads.find(reply);
+    if (m_activeDownloads.end() == it)
     {   // do nothing, it can happen on reset
         reply->deleteLater();
         return;
     }
+    QString requestId = it->requestId;
+    m_activeDownloads.erase(it);
 
     if (reply->error() == QNetworkReply::NoError)
     {
-        QString requestId = m_downloadReqQueue.head().second;
         if (requestId.startsWith("XML|")) {
             QByteArray data = reply->readAll();
             QString scopeId;
@@ -1751,14 +1936,7 @@ void SPIApp::onFileDownloaded(QNetworkReply *reply)
 
     }
 
-    m_downloadReqQueue.dequeue();
-
-    if (!m_downloadReqQueue.isEmpty()) {
-        QNetworkRequest request;
-        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
-        request.setUrl(QUrl(m_downloadReqQueue.head().first));
-        m_netAccessManager->get(request);
-    }
+    startDownloads();
 
     reply->deleteLater();
 }
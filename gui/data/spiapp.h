@@ -31,15 +31,26 @@
 #include <QDomDocument>
 #include <QDnsLookup>
 #include <QNetworkAccessManager>
-#include <QQueue>
 #include <QPair>
+#include <QDateTime>
+#include <QThreadPool>
 
 #include "servicelistid.h"
 #include "motdecoder.h"
 #include "userapplication.h"
+#include "spiepgdecoder.h"
+
+class MOTObjectStore;
 
 //#define SPI_APP_INVALID_TAG 0x7F
 #define SPI_APP_INVALID_DECODER_ID 0xF000
+#define SPI_APP_EPG_DECODER_THREADS 2
+#define SPI_APP_MAX_DOWNLOADS 4                  // number of parallel downloads
+#define SPI_APP_MAX_DNS_LOOKUPS 4                // number of parallel RadioDNS lookups
+#define SPI_APP_DNS_CACHE_MIN_TTL (6*3600)       // [sec] minimal validity of RadioDNS record
+#define SPI_APP_DNS_CACHE_ERROR_TTL (600)        // [sec] validity of failed lookup (except non-existing domain)
+#define SPI_APP_DNS_CACHE_MAGIC 0x534E4452       // "RDNS"
+#define SPI_APP_DNS_CACHE_VERSION 1
 
 class SPIApp : public UserApplication
 {
@@ -74,14 +85,19 @@ public:
     void getSI(const ServiceListId &servId, const uint32_t & ueid);
     void getPI(const ServiceListId &servId, const QList<uint32_t> &ueidList, const QDate & date);
 
+    // when enabled, programme information is emitted as XML document instead of decoded schedule
+    void setPIXmlOutput(bool ena) { m_piXmlOutputEna = ena; }
+
 signals:
     void xmlDocument(const QString &xmldocument, const QString &scopeId, uint16_t decoderId);
+    void epgSchedule(const QList<SPIEpgSchedule> & scheduleList);
     void requestedFile(const QByteArray &data, const QString &requestId);
     void radioDNSAvailable();
 private:
     QHash<uint16_t, MOTDecoder *> m_decoderMap;
 
-    void processObject(uint16_t decoderId, MOTObjectCache::const_iterator objIt);
+    void processObject(uint16_t decoderId, const MOTObject & obj);
+    bool updateObjectSignature(uint16_t decoderId, const MOTObject & obj);
     void parseBinaryInfo(uint16_t decoderId, const MOTObject & motObj);
     uint32_t parseTag(const uint8_t * dataPtr, QDomElement & parentElement, uint8_t parentTag, int maxSize);
     const uint8_t * parseAttributes(const uint8_t * attrPtr, uint8_t tag, int maxSize);
@@ -97,27 +113,73 @@ private:
     void setAttribute_duration(QDomElement & element, const QString & name, const uint8_t *dataPtr, int len);
     void setAttribute_dabBearerURI(QDomElement & element, const QString & name, const uint8_t *dataPtr, int len);
 
-    QHash<uint8_t, QString> m_tokenTable;
+    SPITokenTable m_tokenTable;
     QDomDocument m_xmldocument;
 
     QHash<uint16_t, int_fast32_t> m_parsedDirectoryIds;
 
+    // signature of header and body of processed objects for each decoder, indexed by transport ID
+    // objects that did not change between MOT directory versions are not parsed again
+    QHash<uint16_t, QHash<uint16_t, size_t>> m_processedObjects;
+
+    bool m_piXmlOutputEna;
+    bool m_isRestoring;
+    QHash<uint16_t, MOTObjectStore *> m_objectStoreMap;
+    QThreadPool * m_epgDecoderPool;
+
     // RadioDNS
     bool m_useInternet;
     bool m_enaRadioDNS;
     bool m_useDoH;
 
-    QDnsLookup * m_dnsLookup;
-    QHash<QString, QString> m_dnsCache;
+    struct DnsCacheEntry
+    {
+        QString address;        // empty for services without RadioDNS
+        QDateTime expires;
+    };
+    struct RadioDNSRequest
+    {
+        QString fqdn;
+        QString file;
+        bool isPriority;
+    };
+    struct DnsLookup
+    {
+        QString fqdn;
+        uint32_t ttl;           // minimum of CNAME chain
+    };
+    struct DownloadRequest
+    {
+        QString url;
+        QString requestId;
+        bool useCache;
+        bool isPriority;
+    };
+
+    QHash<QDnsLookup *, DnsLookup> m_activeDnsLookups;
+    QStringList m_dnsLookupQueue;                   // FQDNs waiting for lookup, priority first
+    QHash<QString, DnsCacheEntry> m_dnsCache;
+    bool m_dnsCacheChanged;
     QNetworkAccessManager *m_netAccessManager;
-    QQueue<QPair<QString, QString>> m_downloadReqQueue;
-    QQueue<QPair<QString, QString>> m_radioDnsDownloadQueue;
+    QList<DownloadRequest> m_downloadReqQueue;      // waiting requests, priority requests first
+    QHash<QNetworkReply *, DownloadRequest> m_activeDownloads;
+    QList<RadioDNSRequest> m_radioDnsDownloadQueue; // requests waiting for DNS resolution
     QHash<uint16_t, QHash<QString, QString>> m_motObjRequestList;
-    void radioDNSLookup(const QString & fqdn);
+    void radioDNSLookup(const QString & fqdn, bool isPriority = false);
+    void startDnsLookups();
+    void abortDnsLookups();
+    void finishDnsLookup(QDnsLookup * lookup, const QString & address, uint32_t ttl);
+    void requestRadioDNSFile(const QString & fqdn, const QString & file, bool isPriority);
+    void onRadioDNSResolved(const QString & fqdn, const QString & address, uint32_t ttl);
+    void loadDnsCache();
+    void saveDnsCache();
+    bool isPriorityService(const ServiceListId &servId) const;
     QString radioDNSFQDN(const ServiceListId &servId, const uint32_t &ueid) const;
     QString radioDNSServiceIdentifier(const ServiceListId &servId, const uint32_t & ueid) const;
-    void handleRadioDNSLookup();
-    void downloadFile(const QString &url, const QString &requestId, bool useCache = true);
+    void handleRadioDNSLookup(QDnsLookup * lookup);
+    // useCache = true loads file from cache without validation, otherwise cached file is validated on server
+    void downloadFile(const QString &url, const QString &requestId, bool useCache = true, bool isPriority = false);
+    void startDownloads();
     void onFileDownloaded(QNetworkReply *reply);        
     void dumpFile(uint16_t decoderId, int transportId, QString contentName, const QByteArray &data);
 };
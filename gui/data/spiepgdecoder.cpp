@@ -0,0 +1,550 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include "spiepgdecoder.h"
+#include "spiapp.h"
+#include "dabtables.h"
+
+Q_DECLARE_LOGGING_CATEGORY(spiApp)
+
+QList<SPIEpgSchedule> SPIEpgDecoder::decode(const QByteArray &data, const QString &scopeId, const QDateTime &scopeStart)
+{
+    QList<SPIEpgSchedule> scheduleList;
+    m_tokenTable.clear();
+
+    const uint8_t * dataPtr = reinterpret_cast<const uint8_t *>(data.constData());
+    uint8_t tag;
+    int len;
+    int headerSize = readTag(dataPtr, data.size(), tag, len);
+    if ((0 == headerSize) || (SPIElement::Tag::epg != SPIElement::Tag(tag)))
+    {   // not programme information
+        qCDebug(spiApp) << "Unexpected binary PI object";
+        return scheduleList;
+    }
+
+    dataPtr += headerSize;
+    while (len > 0)
+    {
+        int childLen;
+        headerSize = readTag(dataPtr, len, tag, childLen);
+        if (0 == headerSize)
+        {   // not enough data
+            break;
+        }
+        const uint8_t * childPtr = dataPtr + headerSize;
+        switch (SPIElement::Tag(tag))
+        {
+        case SPIElement::Tag::tokenTable:
+            parseTokenTable(childPtr, childLen);
+            break;
+        case SPIElement::Tag::schedule:
+        {
+            SPIEpgSchedule schedule;
+            // ETSI TS 102 371 V3.2.1 (2016-05) [6.4.6 ScopeStart] MOT parameters are used when scope element is not present
+            // this can only apply to first schedule
+            parseSchedule(childPtr, childLen, schedule, scopeId, scheduleList.isEmpty() ? scopeStart : QDateTime());
+            scheduleList.append(schedule);
+        }
+        break;
+        default:
+            // not needed for EPG
+            break;
+        }
+        dataPtr += headerSize + childLen;
+        len -= headerSize + childLen;
+    }
+
+    return scheduleList;
+}
+
+int SPIEpgDecoder::readTag(const uint8_t *dataPtr, int maxSize, uint8_t &tag, int &len) const
+{
+    if (maxSize < 2)
+    {   // not enough data
+        return 0;
+    }
+
+    tag = *dataPtr++;
+    len = *dataPtr++;
+    int headerSize = 2;
+
+    if (0xFE == len)
+    {
+        if (maxSize < 4)
+        {   // not enough data
+            return 0;
+        }
+        len = *dataPtr++;
+        len = (len << 8) | *dataPtr++;
+        headerSize += 2;
+    }
+    else if (0xFF == len)
+    {
+        if (maxSize < 5)
+        {   // not enough data
+            return 0;
+        }
+        len = *dataPtr++;
+        len = (len << 8) | *dataPtr++;
+        len = (len << 8) | *dataPtr++;
+        headerSize += 3;
+    }
+    else
+    { /* len < 0xFE */ }
+
+    if (maxSize < len + headerSize)
+    {   // not enough data
+        return 0;
+    }
+
+    return headerSize;
+}
+
+void SPIEpgDecoder::parseTokenTable(const uint8_t *dataPtr, int len)
+{
+    m_tokenTable.clear();
+    while (len >= 2)
+    {
+        uint8_t tokenId = *dataPtr++;
+        uint8_t tokenLen = *dataPtr++;
+        len -= 2;
+        if (tokenLen > len)
+        {   // not enough data
+            break;
+        }
+        m_tokenTable.insert(tokenId, dataPtr, tokenLen);
+        dataPtr += tokenLen;
+        len -= tokenLen;
+    }
+}
+
+void SPIEpgDecoder::parseSchedule(const uint8_t *dataPtr, int len, SPIEpgSchedule &schedule, const QString & scopeId, const QDateTime & scopeStart)
+{
+    bool hasScope = false;
+    while (len > 0)
+    {
+        uint8_t tag;
+        int childLen;
+        int headerSize = readTag(dataPtr, len, tag, childLen);
+        if (0 == headerSize)
+        {   // not enough data
+            break;
+        }
+        const uint8_t * childPtr = dataPtr + headerSize;
+        switch (SPIElement::Tag(tag))
+        {
+        case SPIElement::Tag::scope:
+            if (!hasScope)
+            {   // only first scope element is used
+                hasScope = true;
+                parseScope(childPtr, childLen, schedule);
+            }
+            break;
+        case SPIElement::Tag::programme:
+            parseProgramme(childPtr, childLen, schedule.items);
+            break;
+        default:
+            // not needed for EPG
+            break;
+        }
+        dataPtr += headerSize + childLen;
+        len -= headerSize + childLen;
+    }
+
+    if (!hasScope)
+    {   // scope not found using MOT objects params
+        schedule.scopeStart = scopeStart;
+    }
+    schedule.scopeIdList.append(scopeId);
+}
+
+void SPIEpgDecoder::parseScope(const uint8_t *dataPtr, int len, SPIEpgSchedule &schedule)
+{
+    while (len > 0)
+    {
+        uint8_t tag;
+        int childLen;
+        int headerSize = readTag(dataPtr, len, tag, childLen);
+        if (0 == headerSize)
+        {   // not enough data
+            break;
+        }
+        const uint8_t * childPtr = dataPtr + headerSize;
+        if (SPIElement::scope::attribute::startTime == SPIElement::scope::attribute(tag))
+        {
+            schedule.scopeStart = getDateTime(childPtr, childLen);
+        }
+        else if (SPIElement::Tag::serviceScope == SPIElement::Tag(tag))
+        {
+            uint8_t attrTag;
+            int attrLen;
+            int attrHeaderSize = readTag(childPtr, childLen, attrTag, attrLen);
+            if ((0 != attrHeaderSize) && (SPIElement::serviceScope::attribute::id == SPIElement::serviceScope::attribute(attrTag)))
+            {
+                QString id = getBearerURI(childPtr + attrHeaderSize, attrLen);
+                if (!id.isEmpty())
+                {
+                    schedule.scopeIdList.append(id);
+                }
+            }
+        }
+        else { /* not needed for EPG */ }
+
+        dataPtr += headerSize + childLen;
+        len -= headerSize + childLen;
+    }
+}
+
+void SPIEpgDecoder::parseProgramme(const uint8_t *dataPtr, int len, QList<EPGModelItem> &items)
+{
+    Programme programme;
+    while (len > 0)
+    {
+        uint8_t tag;
+        int childLen;
+        int headerSize = readTag(dataPtr, len, tag, childLen);
+        if (0 == headerSize)
+        {   // not enough data
+            break;
+        }
+        const uint8_t * childPtr = dataPtr + headerSize;
+        if (tag < 0x80)
+        {   // element tags
+            switch (SPIElement::Tag(tag))
+            {
+            case SPIElement::Tag::longName:
+                programme.longName = getText(childPtr, childLen);
+                break;
+            case SPIElement::Tag::mediumName:
+                programme.mediumName = getText(childPtr, childLen);
+                break;
+            case SPIElement::Tag::shortName:
+                programme.shortName = getText(childPtr, childLen);
+                break;
+            case SPIElement::Tag::mediaDescription:
+                parseMediaDescription(childPtr, childLen, programme);
+                break;
+            case SPIElement::Tag::location:
+                // ETSI TS 102 818 V3.3.1 (2020-08) [7.8]
+                // The location element may appear zero or more times within a programme or programmeEvent element.
+                parseLocation(childPtr, childLen, programme);
+                break;
+            default:
+                // not needed for EPG
+                break;
+            }
+        }
+        else if (SPIElement::programme_programmeEvent::attribute::shortId == SPIElement::programme_programmeEvent::attribute(tag))
+        {   // ETSI TS 102 371 V3.2.1 (2016-05) [4.7.2]
+            // All attributes defined as shortCRID type are encoded as a 24-bit unsigned integer.
+            if (childLen >= 3)
+            {
+                programme.shortId = getUint(childPtr, 3);
+            }
+        }
+        else { /* other attributes are not needed */ }
+
+        dataPtr += headerSize + childLen;
+        len -= headerSize + childLen;
+    }
+
+    for (const auto & time : programme.timeList)
+    {
+        EPGModelItem item;
+        item.setStartTime(time.first);
+        item.setDurationSec(time.second);
+        item.setShortId(programme.shortId);
+        item.setLongName(programme.longName);
+        item.setMediumName(programme.mediumName);
+        item.setShortName(programme.shortName);
+        item.setShortDescription(programme.shortDescription);
+        item.setLongDescription(programme.longDescription);
+        items.append(item);
+    }
+}
+
+void SPIEpgDecoder::parseLocation(const uint8_t *dataPtr, int len, Programme &programme)
+{
+    while (len > 0)
+    {
+        uint8_t tag;
+        int childLen;
+        int headerSize = readTag(dataPtr, len, tag, childLen);
+        if (0 == headerSize)
+        {   // not enough data
+            break;
+        }
+        if (SPIElement::Tag::time == SPIElement::Tag(tag))
+        {
+            QDateTime startTime;
+            int duration = -1;
+            const uint8_t * attrPtr = dataPtr + headerSize;
+            int attrsLen = childLen;
+            while (attrsLen > 0)
+            {
+                uint8_t attrTag;
+                int attrLen;
+                int attrHeaderSize = readTag(attrPtr, attrsLen, attrTag, attrLen);
+                if (0 == attrHeaderSize)
+                {   // not enough data
+                    break;
+                }
+                switch (SPIElement::time_relativeTime::attribute(attrTag))
+                {
+                case SPIElement::time_relativeTime::attribute::time:
+                    startTime = getDateTime(attrPtr + attrHeaderSize, attrLen);
+                    break;
+                case SPIElement::time_relativeTime::attribute::duration:
+                    // ETSI TS 102 371 V3.2.1 (2016-05) [4.7.5 Duration type]
+                    // All attributes defined as duration type are encoded as a 16-bit unsigned integer
+                    if (attrLen >= 2)
+                    {
+                        duration = getUint(attrPtr + attrHeaderSize, 2);
+                    }
+                    break;
+                default:
+                    break;
+                }
+                attrPtr += attrHeaderSize + attrLen;
+                attrsLen -= attrHeaderSize + attrLen;
+            }
+
+            if (duration >= 0)
+            {   // time without duration is not valid
+                programme.timeList.append(qMakePair(startTime, duration));
+            }
+        }
+        else { /* not needed for EPG */ }
+
+        dataPtr += headerSize + childLen;
+        len -= headerSize + childLen;
+    }
+}
+
+void SPIEpgDecoder::parseMediaDescription(const uint8_t *dataPtr, int len, Programme &programme)
+{
+    while (len > 0)
+    {
+        uint8_t tag;
+        int childLen;
+        int headerSize = readTag(dataPtr, len, tag, childLen);
+        if (0 == headerSize)
+        {   // not enough data
+            break;
+        }
+        switch (SPIElement::Tag(tag))
+        {
+        case SPIElement::Tag::shortDescription:
+            programme.shortDescription = getText(dataPtr + headerSize, childLen).replace(QChar('\\'), QChar()).trimmed();
+            break;
+        case SPIElement::Tag::longDescription:
+            programme.longDescription = getText(dataPtr + headerSize, childLen).replace(QChar('\\'), QChar()).trimmed();
+            break;
+        default:
+            // not needed for EPG
+            break;
+        }
+        dataPtr += headerSize + childLen;
+        len -= headerSize + childLen;
+    }
+}
+
+QString SPIEpgDecoder::getText(const uint8_t *dataPtr, int len)
+{   // text of element is concatenation of all its CDATA children
+    QString text;
+    while (len > 0)
+    {
+        uint8_t tag;
+        int childLen;
+        int headerSize = readTag(dataPtr, len, tag, childLen);
+        if (0 == headerSize)
+        {   // not enough data
+            break;
+        }
+        if (SPIElement::Tag::CDATA == SPIElement::Tag(tag))
+        {
+            text += m_tokenTable.getString(dataPtr + headerSize, childLen, true);
+        }
+        dataPtr += headerSize + childLen;
+        len -= headerSize + childLen;
+    }
+    return text;
+}
+
+void SPITokenTable::clear()
+{
+    if (0 == m_numTokens)
+    {
+        return;
+    }
+    for (auto & token : m_tokens)
+    {
+        token.clear();
+    }
+    m_numTokens = 0;
+}
+
+void SPITokenTable::insert(uint8_t tokenId, const uint8_t *dataPtr, int len)
+{
+    if ((tokenId >= SPI_TOKEN_TABLE_SIZE) || (0 == len))
+    {   // could not be distinguished from UTF-8 data
+        qCDebug(spiApp) << "Unsupported token ID" << tokenId;
+        return;
+    }
+    if (m_tokens[tokenId].isEmpty())
+    {
+        m_numTokens += 1;
+    }
+    m_tokens[tokenId] = QByteArray((const char *) dataPtr, len);
+}
+
+QString SPITokenTable::getString(const uint8_t *dataPtr, int len, bool doReplaceTokens) const
+{
+    const uint8_t * endPtr = dataPtr + len;
+    const uint8_t * ptr = dataPtr;
+    if (doReplaceTokens && (m_numTokens > 0))
+    {   // find first token
+        while ((ptr < endPtr) && ((*ptr >= SPI_TOKEN_TABLE_SIZE) || m_tokens[*ptr].isEmpty()))
+        {
+            ++ptr;
+        }
+    }
+    else
+    {
+        ptr = endPtr;
+    }
+    if (ptr == endPtr)
+    {   // no token, most of strings
+        return QString::fromUtf8((const char *) dataPtr, len);
+    }
+
+    // copy runs of text between tokens
+    m_buffer.resize(0);
+    const uint8_t * runPtr = dataPtr;
+    for ( ; ptr < endPtr; ++ptr)
+    {
+        if ((*ptr < SPI_TOKEN_TABLE_SIZE) && !m_tokens[*ptr].isEmpty())
+        {
+            m_buffer.append((const char *) runPtr, ptr - runPtr);
+            m_buffer.append(m_tokens[*ptr]);
+            runPtr = ptr + 1;
+        }
+        else { /* text */ }
+    }
+    m_buffer.append((const char *) runPtr, endPtr - runPtr);
+
+    return QString::fromUtf8(m_buffer);
+}
+
+QDateTime SPIEpgDecoder::getDateTime(const uint8_t *dataPtr, int len)
+{
+    if (len < 4)
+    {   // not enough data
+        qCDebug(spiApp) << "not enough data";
+        return QDateTime();
+    }
+    else { /* enough data */}
+
+    uint32_t dateHoursMinutes = *dataPtr++;
+    dateHoursMinutes = (dateHoursMinutes << 8) + *dataPtr++;
+    dateHoursMinutes = (dateHoursMinutes << 8) + *dataPtr++;
+    dateHoursMinutes = (dateHoursMinutes << 8) + *dataPtr++;
+
+    uint16_t secMsec = 0;
+    if (dateHoursMinutes & (1 << 11))
+    {   // UTC flag
+        secMsec = *dataPtr << 8;
+        dataPtr += 2;  // rfu
+    }
+    else { /* short form */ }
+
+    int8_t lto = 0;
+    if (dateHoursMinutes & (1 << 12))
+    {   // LTO flag
+        lto = *dataPtr & 0x1F;
+        if (*dataPtr & (1 << 5))
+        {
+            lto = -lto;
+        }
+        else { /* positive */ }
+    }
+    else { /* no LTO */ }
+
+    // construct time
+    return DabTables::dabTimeToUTC(dateHoursMinutes, secMsec).toOffsetFromUtc(60*(lto * 30));
+}
+
+QString SPIEpgDecoder::getBearerURI(const uint8_t *dataPtr, int len)
+{
+    if (len >= 6)
+    {
+        uint8_t longSId = *dataPtr & 0x10;
+        uint8_t scids = *dataPtr++ & 0x0F;
+        uint8_t ecc = *dataPtr++;
+        uint16_t eid = *dataPtr++;
+        eid = (eid << 8) | *dataPtr++;
+        if (longSId)
+        {  // long SId
+            if (len >= 8)
+            {
+                uint32_t sid = *dataPtr++;
+                sid = (sid << 8) | *dataPtr++;
+                sid = (sid << 8) | *dataPtr++;
+                sid = (sid << 8) | *dataPtr;
+                return QString("dab:%1%2.%3.%4.%5")
+                    .arg((sid >> 20) & 0x0F, 1, 16)
+                    .arg(ecc, 2, 16, QChar('0'))
+                    .arg(eid, 4, 16, QChar('0'))
+                    .arg(sid, 8, 16, QChar('0'))
+                    .arg(scids);
+            }
+            else { /* not enough data */ }
+        }
+        else
+        {  // short SId
+            uint32_t sid = *dataPtr++;
+            sid = (sid << 8) | *dataPtr;
+            return QString("dab:%1%2.%3.%4.%5")
+                .arg((sid >> 12) & 0x0F, 1, 16)
+                .arg(ecc, 2, 16, QChar('0'))
+                .arg(eid, 4, 16, QChar('0'))
+                .arg(sid, 4, 16, QChar('0'))
+                .arg(scids);
+        }
+    }
+    return QString();
+}
+
+uint32_t SPIEpgDecoder::getUint(const uint8_t *dataPtr, int len)
+{
+    uint32_t val = 0;
+    for (int n = 0; n < len; ++n)
+    {
+        val = (val << 8) | *dataPtr++;
+    }
+    return val;
+}
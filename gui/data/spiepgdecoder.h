@@ -0,0 +1,106 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPIEPGDECODER_H
+#define SPIEPGDECODER_H
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QByteArray>
+#include "epgmodelitem.h"
+
+#define SPI_TOKEN_TABLE_SIZE (0x80)     // token IDs are ASCII control codes (0x01-0x13 used)
+
+struct SPIEpgSchedule
+{
+    QStringList scopeIdList;    // serviceScope bearer URIs in order of appearance, MOT ScopeID is the last one
+    QDateTime scopeStart;
+    QList<EPGModelItem> items;  // start time is in time zone of the binary object
+};
+Q_DECLARE_METATYPE(SPIEpgSchedule)
+
+// Token table of binary encoded SPI object (ETSI TS 102 371 [4.9])
+// Tokens are single bytes that never occur inside UTF-8 multibyte sequence, string is expanded in one pass
+// to reused buffer and decoded from UTF-8 only once.
+class SPITokenTable
+{
+public:
+    void clear();
+    void insert(uint8_t tokenId, const uint8_t * dataPtr, int len);
+
+    // decodes UTF-8 string, tokens are replaced when doReplaceTokens is set
+    QString getString(const uint8_t * dataPtr, int len, bool doReplaceTokens = true) const;
+
+private:
+    QByteArray m_tokens[SPI_TOKEN_TABLE_SIZE];   // UTF-8, indexed by token ID
+    int m_numTokens = 0;
+    mutable QByteArray m_buffer;                 // expanded string, capacity is kept
+};
+
+// Streaming decoder of binary encoded programme information (ETSI TS 102 371)
+// Only elements needed for EPG are decoded, all others are skipped without creating any intermediate document.
+// Decoder does not use any shared state so that it can run in worker thread.
+class SPIEpgDecoder
+{
+public:
+    QList<SPIEpgSchedule> decode(const QByteArray & data, const QString & scopeId, const QDateTime & scopeStart);
+
+    // helpers shared with SPIApp
+    static QDateTime getDateTime(const uint8_t *dataPtr, int len);
+    static QString getBearerURI(const uint8_t *dataPtr, int len);
+    static uint32_t getUint(const uint8_t *dataPtr, int len);
+
+private:
+    struct Programme
+    {
+        int shortId = 0;
+        QList<QPair<QDateTime, int>> timeList;    // start time and duration
+        QString longName;
+        QString mediumName;
+        QString shortName;
+        QString shortDescription;
+        QString longDescription;
+    };
+
+    SPITokenTable m_tokenTable;
+
+    // returns size of tag header or 0 if there is not enough data
+    int readTag(const uint8_t *dataPtr, int maxSize, uint8_t & tag, int & len) const;
+
+    void parseTokenTable(const uint8_t *dataPtr, int len);
+    void parseSchedule(const uint8_t *dataPtr, int len, SPIEpgSchedule & schedule, const QString & scopeId, const QDateTime & scopeStart);
+    void parseScope(const uint8_t *dataPtr, int len, SPIEpgSchedule & schedule);
+    void parseProgramme(const uint8_t *dataPtr, int len, QList<EPGModelItem> & items);
+    void parseLocation(const uint8_t *dataPtr, int len, Programme & programme);
+    void parseMediaDescription(const uint8_t *dataPtr, int len, Programme & programme);
+    QString getText(const uint8_t *dataPtr, int len);
+};
+
+#endif // SPIEPGDECODER_H
@@ -0,0 +1,157 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include "uadumpqueue.h"
+
+Q_LOGGING_CATEGORY(uaDump, "UADump", QtInfoMsg)
+
+UADumpQueue::UADumpQueue()
+{
+    m_isScheduled = false;
+    m_isDropping = false;
+
+    // single thread keeps files in order of reception
+    m_pool.setMaxThreadCount(1);
+}
+
+UADumpQueue::~UADumpQueue()
+{
+    m_pool.waitForDone();
+}
+
+void UADumpQueue::enqueue(const QString &fileName, const QByteArray &data, bool overwrite)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QHash<QString, Item>::iterator it = m_pending.find(fileName);
+    if (m_pending.end() != it)
+    {   // file is still waiting => only newest data is written
+        m_stats.pendingBytes += data.size() - it->data.size();
+        it->data = data;
+        it->overwrite = it->overwrite || overwrite;
+        m_stats.numCoalesced += 1;
+        return;
+    }
+    else
+    { /* new file */ }
+
+    if (m_stats.pendingBytes + data.size() > UADUMPQUEUE_MAX_PENDING_BYTES)
+    {   // storage is too slow, data group processing has priority
+        m_stats.numDropped += 1;
+        if (!m_isDropping)
+        {
+            qCWarning(uaDump) << "Dump queue is full, dropping files";
+            m_isDropping = true;
+        }
+        return;
+    }
+    else
+    { /* space available */ }
+
+    m_pending.insert(fileName, Item{data, overwrite});
+    m_order.append(fileName);
+    m_stats.numQueued += 1;
+    m_stats.pendingBytes += data.size();
+    m_stats.maxPendingBytes = qMax(m_stats.maxPendingBytes, m_stats.pendingBytes);
+
+    if (!m_isScheduled)
+    {
+        m_isScheduled = true;
+        m_pool.start([this]() { process(); });
+    }
+    else
+    { /* worker is running */ }
+}
+
+UADumpQueue::Statistics UADumpQueue::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void UADumpQueue::process()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_order.isEmpty())
+    {
+        QString fileName = m_order.takeFirst();
+        Item item = m_pending.take(fileName);
+
+        // file is written without lock, new files can be queued meanwhile
+        locker.unlock();
+        bool isWritten = write(fileName, item);
+        locker.relock();
+
+        m_stats.pendingBytes -= item.data.size();
+        if (isWritten)
+        {
+            m_stats.numWritten += 1;
+        }
+        else
+        {
+            m_stats.numFailed += 1;
+        }
+    }
+
+    if (m_isDropping)
+    {
+        qCInfo(uaDump) << "Dump queue is empty," << m_stats.numDropped << "files dropped so far";
+        m_isDropping = false;
+    }
+    else
+    { /* nothing was dropped */ }
+
+    m_isScheduled = false;
+}
+
+bool UADumpQueue::write(const QString &fileName, const Item &item) const
+{
+    QFile file(fileName);
+    if (!file.exists() || item.overwrite)
+    {   // file does not exist of overwriting is enabled == > store file
+        QDir dir;
+        dir.mkpath(QFileInfo(file).absolutePath());
+        if (file.open(QIODevice::WriteOnly))
+        {
+            qCInfo(uaDump) << "Storing file:" << file.fileName();
+            file.write(item.data);
+            file.close();
+        }
+        else
+        {
+            qCWarning(uaDump) << "Failed to store file:" << file.fileName();
+            return false;
+        }
+    }
+    else
+    { /* file exists */ }
+
+    return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UADUMPQUEUE_H
+#define UADUMPQUEUE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+
+#define UADUMPQUEUE_MAX_PENDING_BYTES (32*1024*1024)   // new files are dropped when more data is waiting for write
+
+// Background writer of user application data dumps
+// Files are written in worker thread so that data group processing is never blocked by file I/O.
+// Pending file is replaced when newer data with the same file name is queued.
+class UADumpQueue
+{
+public:
+    struct Statistics
+    {
+        quint64 numQueued = 0;
+        quint64 numCoalesced = 0;    // pending file replaced by newer data
+        quint64 numDropped = 0;      // files dropped because of full queue
+        quint64 numWritten = 0;
+        quint64 numFailed = 0;
+        qint64 pendingBytes = 0;
+        qint64 maxPendingBytes = 0;
+    };
+
+    UADumpQueue();
+    ~UADumpQueue();    // waits for pending files
+
+    // queues file for writing, existing file is kept when overwrite is false
+    void enqueue(const QString & fileName, const QByteArray & data, bool overwrite);
+    Statistics statistics() const;
+
+private:
+    struct Item
+    {
+        QByteArray data;
+        bool overwrite;
+    };
+
+    QThreadPool m_pool;
+    mutable QMutex m_mutex;
+    QHash<QString, Item> m_pending;
+    QStringList m_order;             // file names in order of reception
+    Statistics m_stats;
+    bool m_isScheduled;
+    bool m_isDropping;
+
+    void process();
+    bool write(const QString & fileName, const Item & item) const;
+};
+
+#endif // UADUMPQUEUE_H
@@ -32,5 +32,7 @@ UserApplication::UserApplication(QObject *parent) :
     QObject(parent)
 {    
     m_isRunning = false;
+    m_ueid = 0;
+    m_objectStoreEna = true;
 }
 
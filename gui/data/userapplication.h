@@ -31,6 +31,7 @@
 #include "setupdialog.h"
 #include "radiocontrol.h"
 #include "motobject.h"
+#include "uadumpqueue.h"
 
 #define USER_APPLICATION_VERBOSE 1
 
@@ -51,6 +52,12 @@ public:
     virtual void setDataDumping(const SetupDialog::Settings::UADumpSettings & settings) = 0;
     void setEnsId(const RadioControlEnsemble &ens) { m_ueid = ens.ueid; }
     void setAudioServiceId(const RadioControlServiceComponent &s) { m_SId = s.SId; }
+
+    // objects from previous reception are stored in cache directory and restored on next reception
+    void setObjectStoreEnabled(bool ena) { m_objectStoreEna = ena; }
+
+    // dump files are written in background
+    UADumpQueue::Statistics dumpStatistics() const { return m_dumpQueue.statistics(); }
 signals:
     void resetTerminal();
 
@@ -62,6 +69,8 @@ protected:
     QString m_dumpPattern;
     uint32_t m_ueid;
     DabSId m_SId;
+    bool m_objectStoreEna;
+    UADumpQueue m_dumpQueue;
 };
 
 #endif // USERAPPLICATION_H
@@ -0,0 +1,326 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QObject>
+#include <QJsonArray>
+#include <algorithm>
+#include <chrono>
+
+#include "diagnostics.h"
+
+Diagnostics * Diagnostics::m_instancePtr = nullptr;
+
+Diagnostics *Diagnostics::getInstance()
+{
+    if (m_instancePtr == nullptr)
+    {
+        m_instancePtr = new Diagnostics();
+    }
+    return m_instancePtr;
+}
+
+uint64_t Diagnostics::timestampUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Diagnostics::reset()
+{
+    for (auto & histogram : m_histograms)
+    {
+        histogram.reset();
+    }
+    for (auto & counter : m_counters)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    for (int s = 0; s < int(DiagnosticsMemory::NumMemory); ++s)
+    {   // high-water mark restarts from current usage
+        m_memoryPeak[s].store(m_memory[s].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+void Diagnostics::addMemory(DiagnosticsMemory subsystem, int64_t bytes)
+{
+    int64_t value = m_memory[int(subsystem)].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    int64_t peak = m_memoryPeak[int(subsystem)].load(std::memory_order_relaxed);
+    while ((value > peak) && !m_memoryPeak[int(subsystem)].compare_exchange_weak(peak, value, std::memory_order_relaxed))
+    { /* multiple writers */ }
+}
+
+QString Diagnostics::counterName(DiagnosticsCounter counter)
+{
+    switch (counter)
+    {
+    case DiagnosticsCounter::InputFifoOverflows: return "input_fifo_overflows";
+    case DiagnosticsCounter::InputDroppedSamples: return "input_dropped_samples";
+    case DiagnosticsCounter::InputConsumerStalls: return "input_consumer_stalls";
+    case DiagnosticsCounter::InputFifoUnderflows: return "input_fifo_underflows";
+    default: return "unknown";
+    }
+}
+
+QString Diagnostics::counterDescription(DiagnosticsCounter counter)
+{
+    switch (counter)
+    {
+    case DiagnosticsCounter::InputFifoOverflows: return QObject::tr("Input FIFO overflows");
+    case DiagnosticsCounter::InputDroppedSamples: return QObject::tr("Dropped input samples");
+    case DiagnosticsCounter::InputConsumerStalls: return QObject::tr("DAB processing stalls");
+    case DiagnosticsCounter::InputFifoUnderflows: return QObject::tr("Input FIFO underflows");
+    default: return QString();
+    }
+}
+
+QString Diagnostics::memoryName(DiagnosticsMemory subsystem)
+{
+    switch (subsystem)
+    {
+    case DiagnosticsMemory::InputFifo: return "input_fifo";
+    case DiagnosticsMemory::AudioFifo: return "audio_fifo";
+    case DiagnosticsMemory::MotCache: return "mot_cache";
+    case DiagnosticsMemory::SlideCache: return "slide_cache";
+    case DiagnosticsMemory::EpgModel: return "epg_model";
+    case DiagnosticsMemory::LogModel: return "log_model";
+    case DiagnosticsMemory::Metadata: return "metadata";
+    default: return "unknown";
+    }
+}
+
+QString Diagnostics::memoryDescription(DiagnosticsMemory subsystem)
+{
+    switch (subsystem)
+    {
+    case DiagnosticsMemory::InputFifo: return QObject::tr("Input FIFO");
+    case DiagnosticsMemory::AudioFifo: return QObject::tr("Audio FIFOs");
+    case DiagnosticsMemory::MotCache: return QObject::tr("MOT object cache");
+    case DiagnosticsMemory::SlideCache: return QObject::tr("Slide cache");
+    case DiagnosticsMemory::EpgModel: return QObject::tr("EPG");
+    case DiagnosticsMemory::LogModel: return QObject::tr("Log");
+    case DiagnosticsMemory::Metadata: return QObject::tr("Service metadata");
+    default: return QString();
+    }
+}
+
+void DiagnosticsMemoryCounter::set(int64_t bytes)
+{
+    if (bytes != m_bytes)
+    {
+        Diagnostics::getInstance()->addMemory(m_subsystem, bytes - m_bytes);
+        m_bytes = bytes;
+    }
+}
+
+QString Diagnostics::metricName(DiagnosticsMetric metric)
+{
+    switch (metric)
+    {
+    case DiagnosticsMetric::InputFifoLevel: return "input_fifo_level_samples";
+    case DiagnosticsMetric::EventQueueDelay: return "event_queue_delay_us";
+    case DiagnosticsMetric::AudioDataQueueDelay: return "audio_data_queue_delay_us";
+    case DiagnosticsMetric::AudioDecodeTime: return "audio_decode_time_us";
+    case DiagnosticsMetric::AudioFifoLevel: return "audio_fifo_level_ms";
+    case DiagnosticsMetric::AudioCallbackTime: return "audio_callback_time_us";
+    case DiagnosticsMetric::NetworkChunkTime: return "network_chunk_time_ms";
+    case DiagnosticsMetric::NetworkRecvCalls: return "network_recv_calls";
+    case DiagnosticsMetric::AudioSinkLevel: return "audio_sink_level_ms";
+    case DiagnosticsMetric::EndToEndLatency: return "end_to_end_latency_ms";
+    default: return "unknown";
+    }
+}
+
+QString Diagnostics::metricDescription(DiagnosticsMetric metric)
+{
+    switch (metric)
+    {
+    case DiagnosticsMetric::InputFifoLevel: return QObject::tr("Input FIFO level");
+    case DiagnosticsMetric::EventQueueDelay: return QObject::tr("DAB event queue delay");
+    case DiagnosticsMetric::AudioDataQueueDelay: return QObject::tr("Audio data queue delay");
+    case DiagnosticsMetric::AudioDecodeTime: return QObject::tr("Audio decoding time");
+    case DiagnosticsMetric::AudioFifoLevel: return QObject::tr("Audio FIFO level");
+    case DiagnosticsMetric::AudioCallbackTime: return QObject::tr("Audio output callback time");
+    case DiagnosticsMetric::NetworkChunkTime: return QObject::tr("Network input chunk receive time");
+    case DiagnosticsMetric::NetworkRecvCalls: return QObject::tr("Network input reads per chunk");
+    case DiagnosticsMetric::AudioSinkLevel: return QObject::tr("Audio sink buffer level");
+    case DiagnosticsMetric::EndToEndLatency: return QObject::tr("End-to-end latency");
+    default: return QString();
+    }
+}
+
+QString Diagnostics::metricUnit(DiagnosticsMetric metric)
+{
+    switch (metric)
+    {
+    case DiagnosticsMetric::InputFifoLevel: return "samples";
+    case DiagnosticsMetric::AudioFifoLevel: return "ms";
+    case DiagnosticsMetric::NetworkChunkTime: return "ms";
+    case DiagnosticsMetric::NetworkRecvCalls: return "calls";
+    case DiagnosticsMetric::AudioSinkLevel: return "ms";
+    case DiagnosticsMetric::EndToEndLatency: return "ms";
+    default: return "us";
+    }
+}
+
+QJsonObject Diagnostics::toJson() const
+{
+    QJsonObject json;
+    for (int m = 0; m < int(DiagnosticsMetric::NumMetrics); ++m)
+    {
+        const DiagnosticsHistogram & h = m_histograms[m];
+        QJsonObject obj;
+        obj["unit"] = metricUnit(DiagnosticsMetric(m));
+        obj["count"] = qint64(h.count());
+        obj["sum"] = qint64(h.sum());
+        obj["max"] = qint64(h.max());
+        obj["p50"] = qint64(h.quantile(0.5));
+        obj["p99"] = qint64(h.quantile(0.99));
+        QJsonArray bins;
+        for (int n = 0; n < DIAGNOSTICS_HISTOGRAM_BINS; ++n)
+        {
+            bins.append(qint64(h.bin(n)));
+        }
+        obj["bins"] = bins;
+        json[metricName(DiagnosticsMetric(m))] = obj;
+    }
+
+    QJsonObject memoryJson;
+    for (int s = 0; s < int(DiagnosticsMemory::NumMemory); ++s)
+    {
+        QJsonObject obj;
+        obj["bytes"] = qint64(memory(DiagnosticsMemory(s)));
+        obj["peak"] = qint64(memoryPeak(DiagnosticsMemory(s)));
+        memoryJson[memoryName(DiagnosticsMemory(s))] = obj;
+    }
+    json["memory"] = memoryJson;
+
+    QJsonObject countersJson;
+    for (int c = 0; c < int(DiagnosticsCounter::NumCounters); ++c)
+    {
+        countersJson[counterName(DiagnosticsCounter(c))] = qint64(counter(DiagnosticsCounter(c)));
+    }
+    json["counters"] = countersJson;
+    return json;
+}
+
+QByteArray Diagnostics::toPrometheus() const
+{
+    QByteArray out;
+    for (int m = 0; m < int(DiagnosticsMetric::NumMetrics); ++m)
+    {
+        const DiagnosticsHistogram & h = m_histograms[m];
+        QByteArray name = "abracadabra_" + metricName(DiagnosticsMetric(m)).toLatin1();
+        out += "# HELP " + name + " " + metricDescription(DiagnosticsMetric(m)).toUtf8() + "\n";
+        out += "# TYPE " + name + " histogram\n";
+
+        uint64_t cumulative = 0;
+        int lastBin = DIAGNOSTICS_HISTOGRAM_BINS - 1;
+        while ((lastBin > 0) && (0 == h.bin(lastBin)))
+        {   // empty bins at the end are not exported
+            lastBin -= 1;
+        }
+        for (int n = 0; n <= lastBin; ++n)
+        {
+            cumulative += h.bin(n);
+            out += name + "_bucket{le=\"" + QByteArray::number(qulonglong(DiagnosticsHistogram::binUpperBound(n))) + "\"} "
+                   + QByteArray::number(qulonglong(cumulative)) + "\n";
+        }
+        out += name + "_bucket{le=\"+Inf\"} " + QByteArray::number(qulonglong(h.count())) + "\n";
+        out += name + "_sum " + QByteArray::number(qulonglong(h.sum())) + "\n";
+        out += name + "_count " + QByteArray::number(qulonglong(h.count())) + "\n";
+    }
+
+    out += "# HELP abracadabra_memory_bytes Memory used by subsystem\n";
+    out += "# TYPE abracadabra_memory_bytes gauge\n";
+    for (int s = 0; s < int(DiagnosticsMemory::NumMemory); ++s)
+    {
+        out += "abracadabra_memory_bytes{subsystem=\"" + memoryName(DiagnosticsMemory(s)).toLatin1() + "\"} "
+               + QByteArray::number(qlonglong(memory(DiagnosticsMemory(s)))) + "\n";
+    }
+    out += "# HELP abracadabra_memory_peak_bytes High-water mark of memory used by subsystem\n";
+    out += "# TYPE abracadabra_memory_peak_bytes gauge\n";
+    for (int s = 0; s < int(DiagnosticsMemory::NumMemory); ++s)
+    {
+        out += "abracadabra_memory_peak_bytes{subsystem=\"" + memoryName(DiagnosticsMemory(s)).toLatin1() + "\"} "
+               + QByteArray::number(qlonglong(memoryPeak(DiagnosticsMemory(s)))) + "\n";
+    }
+    for (int c = 0; c < int(DiagnosticsCounter::NumCounters); ++c)
+    {
+        QByteArray name = "abracadabra_" + counterName(DiagnosticsCounter(c)).toLatin1() + "_total";
+        out += "# HELP " + name + " " + counterDescription(DiagnosticsCounter(c)).toUtf8() + "\n";
+        out += "# TYPE " + name + " counter\n";
+        out += name + " " + QByteArray::number(qulonglong(counter(DiagnosticsCounter(c)))) + "\n";
+    }
+    return out;
+}
+
+void DiagnosticsHistogram::add(uint64_t value)
+{
+    int n = 0;
+    uint64_t v = value;
+    while ((v > 0) && (n < DIAGNOSTICS_HISTOGRAM_BINS - 1))
+    {
+        v >>= 1;
+        n += 1;
+    }
+    m_bins[n].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    if (value > m_max.load(std::memory_order_relaxed))
+    {   // single writer => no CAS loop needed
+        m_max.store(value, std::memory_order_relaxed);
+    }
+}
+
+void DiagnosticsHistogram::reset()
+{
+    for (auto & bin : m_bins)
+    {
+        bin.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t DiagnosticsHistogram::quantile(float q) const
+{
+    uint64_t total = count();
+    if (0 == total)
+    {
+        return 0;
+    }
+    uint64_t threshold = uint64_t(q * total);
+    uint64_t cumulative = 0;
+    for (int n = 0; n < DIAGNOSTICS_HISTOGRAM_BINS; ++n)
+    {
+        cumulative += bin(n);
+        if (cumulative > threshold)
+        {
+            return std::min(binUpperBound(n), max());
+        }
+    }
+    return max();
+}
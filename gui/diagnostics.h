@@ -0,0 +1,160 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <QString>
+#include <QJsonObject>
+#include <atomic>
+#include <cstdint>
+
+#define DIAGNOSTICS_HISTOGRAM_BINS  (32)    // bin n contains values in range [2^(n-1), 2^n)
+
+enum class DiagnosticsMetric
+{
+    InputFifoLevel = 0,     // IQ samples in input FIFO when dabsdr requests samples
+    EventQueueDelay,        // dabsdr notification to RadioControl processing [us]
+    AudioDataQueueDelay,    // AU from dabsdr callback to AudioDecoder [us]
+    AudioDecodeTime,        // AU decoding including write to audio FIFO [us]
+    AudioFifoLevel,         // audio FIFO fill level in audio output callback [ms]
+    AudioCallbackTime,      // audio output callback duration [us]
+    NetworkChunkTime,       // time to receive one input chunk from network device [ms]
+    NetworkRecvCalls,       // recv() calls needed for one input chunk (>1 means short read)
+    AudioSinkLevel,         // Qt audio sink buffer level before periods are pushed [ms], 0 is underrun
+    EndToEndLatency,        // input sample capture to audio output device [ms]
+    NumMetrics
+};
+
+// event counters, incremented from any thread
+enum class DiagnosticsCounter
+{
+    InputFifoOverflows = 0, // input chunks that did not fit into input FIFO
+    InputDroppedSamples,    // IQ samples dropped because of input FIFO overflow
+    InputConsumerStalls,    // input FIFO became full (DAB processing does not keep up)
+    InputFifoUnderflows,    // DAB processing waited for input samples longer than expected
+    NumCounters
+};
+
+enum class DiagnosticsMemory
+{
+    InputFifo = 0,          // input sample FIFOs of all receivers
+    AudioFifo,              // audio decoder output FIFOs
+    MotCache,               // MOT objects being reassembled
+    SlideCache,             // decoded slides kept in memory
+    EpgModel,               // EPG programme items
+    LogModel,               // log messages
+    Metadata,               // service information and decoded logos
+    NumMemory
+};
+
+// lock-free histogram, every metric is updated from one thread (relaxed atomics are enough)
+// and it can be read from any thread at any time
+class DiagnosticsHistogram
+{
+public:
+    void add(uint64_t value);
+    void reset();
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    uint64_t bin(int n) const { return m_bins[n].load(std::memory_order_relaxed); }
+    static uint64_t binUpperBound(int n) { return (n > 0) ? (uint64_t(1) << n) - 1 : 0; }
+
+    // upper bound of bin where quantile is reached
+    uint64_t quantile(float q) const;
+
+private:
+    std::atomic<uint64_t> m_bins[DIAGNOSTICS_HISTOGRAM_BINS] = {};
+    std::atomic<uint64_t> m_count { 0 };
+    std::atomic<uint64_t> m_sum { 0 };
+    std::atomic<uint64_t> m_max { 0 };
+};
+
+// owned by instance of subsystem, reports its current memory usage
+// destructor removes remaining bytes from the subsystem total
+class DiagnosticsMemoryCounter
+{
+public:
+    explicit DiagnosticsMemoryCounter(DiagnosticsMemory subsystem) : m_subsystem(subsystem) { }
+    DiagnosticsMemoryCounter(const DiagnosticsMemoryCounter & obj) = delete;
+    ~DiagnosticsMemoryCounter() { set(0); }
+    void set(int64_t bytes);
+    int64_t bytes() const { return m_bytes; }
+
+private:
+    DiagnosticsMemory m_subsystem;
+    int64_t m_bytes = 0;
+};
+
+// singleton class
+// always-on receiver pipeline instrumentation
+class Diagnostics
+{
+public:
+    Diagnostics(const Diagnostics & obj) = delete;   // deleting copy constructor
+    static Diagnostics * getInstance();
+
+    // monotonic time [us]
+    static uint64_t timestampUs();
+
+    void add(DiagnosticsMetric metric, uint64_t value) { m_histograms[int(metric)].add(value); }
+    void addDelay(DiagnosticsMetric metric, uint64_t startUs) { add(metric, timestampUs() - startUs); }
+    const DiagnosticsHistogram & histogram(DiagnosticsMetric metric) const { return m_histograms[int(metric)]; }
+    void reset();
+
+    void count(DiagnosticsCounter counter, uint64_t n = 1) { m_counters[int(counter)].fetch_add(n, std::memory_order_relaxed); }
+    uint64_t counter(DiagnosticsCounter counter) const { return m_counters[int(counter)].load(std::memory_order_relaxed); }
+    static QString counterName(DiagnosticsCounter counter);
+    static QString counterDescription(DiagnosticsCounter counter);
+
+    // memory accounting, subsystems are updated from different threads
+    void addMemory(DiagnosticsMemory subsystem, int64_t bytes);
+    int64_t memory(DiagnosticsMemory subsystem) const { return m_memory[int(subsystem)].load(std::memory_order_relaxed); }
+    int64_t memoryPeak(DiagnosticsMemory subsystem) const { return m_memoryPeak[int(subsystem)].load(std::memory_order_relaxed); }
+    static QString memoryName(DiagnosticsMemory subsystem);
+    static QString memoryDescription(DiagnosticsMemory subsystem);
+
+    static QString metricName(DiagnosticsMetric metric);
+    static QString metricDescription(DiagnosticsMetric metric);
+    static QString metricUnit(DiagnosticsMetric metric);
+
+    // machine readable export
+    QJsonObject toJson() const;
+    QByteArray toPrometheus() const;
+
+private:
+    Diagnostics() = default;
+    static Diagnostics * m_instancePtr;
+
+    DiagnosticsHistogram m_histograms[int(DiagnosticsMetric::NumMetrics)];
+    std::atomic<uint64_t> m_counters[int(DiagnosticsCounter::NumCounters)] = {};
+    std::atomic<int64_t> m_memory[int(DiagnosticsMemory::NumMemory)] = {};
+    std::atomic<int64_t> m_memoryPeak[int(DiagnosticsMemory::NumMemory)] = {};
+};
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,171 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QHeaderView>
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QJsonDocument>
+
+#include "diagnosticsdialog.h"
+#include "diagnostics.h"
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Diagnostics"));
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+
+    m_table = new QTableWidget(int(DiagnosticsMetric::NumMetrics), 7, this);
+    m_table->setHorizontalHeaderLabels({ tr("Metric"), tr("Unit"), tr("Count"), tr("Mean"), tr("P50"), tr("P99"), tr("Max") });
+    m_table->verticalHeader()->setVisible(false);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    for (int m = 0; m < int(DiagnosticsMetric::NumMetrics); ++m)
+    {
+        m_table->setItem(m, 0, new QTableWidgetItem(Diagnostics::metricDescription(DiagnosticsMetric(m))));
+        m_table->setItem(m, 1, new QTableWidgetItem(Diagnostics::metricUnit(DiagnosticsMetric(m))));
+        for (int c = 2; c < m_table->columnCount(); ++c)
+        {
+            QTableWidgetItem * item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            m_table->setItem(m, c, item);
+        }
+    }
+
+    m_memoryTable = new QTableWidget(int(DiagnosticsMemory::NumMemory), 3, this);
+    m_memoryTable->setHorizontalHeaderLabels({ tr("Memory"), tr("Current"), tr("Peak") });
+    m_memoryTable->verticalHeader()->setVisible(false);
+    m_memoryTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_memoryTable->setSelectionMode(QAbstractItemView::NoSelection);
+    m_memoryTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_memoryTable->horizontalHeader()->setStretchLastSection(true);
+    for (int s = 0; s < int(DiagnosticsMemory::NumMemory); ++s)
+    {
+        m_memoryTable->setItem(s, 0, new QTableWidgetItem(Diagnostics::memoryDescription(DiagnosticsMemory(s))));
+        for (int c = 1; c < m_memoryTable->columnCount(); ++c)
+        {
+            QTableWidgetItem * item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            m_memoryTable->setItem(s, c, item);
+        }
+    }
+
+    m_counterTable = new QTableWidget(int(DiagnosticsCounter::NumCounters), 2, this);
+    m_counterTable->setHorizontalHeaderLabels({ tr("Event"), tr("Count") });
+    m_counterTable->verticalHeader()->setVisible(false);
+    m_counterTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_counterTable->setSelectionMode(QAbstractItemView::NoSelection);
+    m_counterTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_counterTable->horizontalHeader()->setStretchLastSection(true);
+    for (int c = 0; c < int(DiagnosticsCounter::NumCounters); ++c)
+    {
+        m_counterTable->setItem(c, 0, new QTableWidgetItem(Diagnostics::counterDescription(DiagnosticsCounter(c))));
+        QTableWidgetItem * item = new QTableWidgetItem();
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        m_counterTable->setItem(c, 1, item);
+    }
+
+    QPushButton * resetButton = new QPushButton(tr("Reset"), this);
+    connect(resetButton, &QPushButton::clicked, this, [this]() { Diagnostics::getInstance()->reset(); updateTable(); });
+    QPushButton * copyButton = new QPushButton(tr("Copy JSON"), this);
+    connect(copyButton, &QPushButton::clicked, this, &DiagnosticsDialog::copyToClipboard);
+
+    QHBoxLayout * buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(resetButton);
+    buttonLayout->addWidget(copyButton);
+
+    QVBoxLayout * layout = new QVBoxLayout(this);
+    layout->addWidget(m_table);
+    layout->addWidget(m_memoryTable);
+    layout->addWidget(m_counterTable);
+    layout->addLayout(buttonLayout);
+
+    m_timer = new QTimer(this);
+    m_timer->setInterval(DIAGNOSTICSDIALOG_UPDATE_PERIOD_MS);
+    connect(m_timer, &QTimer::timeout, this, &DiagnosticsDialog::updateTable);
+
+    resize(640, 480);
+}
+
+void DiagnosticsDialog::showEvent(QShowEvent *event)
+{
+    updateTable();
+    m_timer->start();
+    QDialog::showEvent(event);
+}
+
+void DiagnosticsDialog::hideEvent(QHideEvent *event)
+{
+    m_timer->stop();
+    QDialog::hideEvent(event);
+}
+
+void DiagnosticsDialog::updateTable()
+{
+    const Diagnostics * diag = Diagnostics::getInstance();
+    for (int m = 0; m < int(DiagnosticsMetric::NumMetrics); ++m)
+    {
+        const DiagnosticsHistogram & h = diag->histogram(DiagnosticsMetric(m));
+        uint64_t count = h.count();
+        m_table->item(m, 2)->setText(QString::number(count));
+        m_table->item(m, 3)->setText((count > 0) ? QString::number(double(h.sum()) / count, 'f', 1) : QString("-"));
+        m_table->item(m, 4)->setText(QString::number(h.quantile(0.5)));
+        m_table->item(m, 5)->setText(QString::number(h.quantile(0.99)));
+        m_table->item(m, 6)->setText(QString::number(h.max()));
+    }
+    for (int s = 0; s < int(DiagnosticsMemory::NumMemory); ++s)
+    {
+        m_memoryTable->item(s, 1)->setText(formatBytes(diag->memory(DiagnosticsMemory(s))));
+        m_memoryTable->item(s, 2)->setText(formatBytes(diag->memoryPeak(DiagnosticsMemory(s))));
+    }
+    for (int c = 0; c < int(DiagnosticsCounter::NumCounters); ++c)
+    {
+        m_counterTable->item(c, 1)->setText(QString::number(diag->counter(DiagnosticsCounter(c))));
+    }
+}
+
+QString DiagnosticsDialog::formatBytes(int64_t bytes)
+{
+    if (bytes < 1024)
+    {
+        return QString("%1 B").arg(bytes);
+    }
+    if (bytes < 1024*1024)
+    {
+        return QString("%1 kB").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    return QString("%1 MB").arg(bytes / (1024.0*1024.0), 0, 'f', 1);
+}
+
+void DiagnosticsDialog::copyToClipboard()
+{
+    QGuiApplication::clipboard()->setText(QJsonDocument(Diagnostics::getInstance()->toJson()).toJson());
+}
@@ -0,0 +1,101 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include <QJsonDocument>
+
+#include "diagnosticsserver.h"
+#include "diagnostics.h"
+
+Q_LOGGING_CATEGORY(diagnostics, "Diagnostics", QtInfoMsg)
+
+DiagnosticsServer::DiagnosticsServer(QObject *parent) : QObject(parent)
+{
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &DiagnosticsServer::onNewConnection);
+}
+
+bool DiagnosticsServer::listen(uint16_t port)
+{
+    // only local access, metrics are expected to be scraped by local agent
+    if (!m_server->listen(QHostAddress::LocalHost, port))
+    {
+        qCWarning(diagnostics) << "Unable to listen on port" << port << ":" << m_server->errorString();
+        return false;
+    }
+    qCInfo(diagnostics) << "Diagnostics available at http://localhost:" << port << "/metrics";
+    return true;
+}
+
+void DiagnosticsServer::onNewConnection()
+{
+    while (m_server->hasPendingConnections())
+    {
+        QTcpSocket * socket = m_server->nextPendingConnection();
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void DiagnosticsServer::onReadyRead(QTcpSocket *socket)
+{
+    if (!socket->canReadLine())
+    {   // waiting for request line
+        return;
+    }
+
+    // request line: GET <path> HTTP/1.x, rest of the request is ignored
+    QList<QByteArray> request = socket->readLine().trimmed().split(' ');
+    socket->readAll();
+
+    QByteArray body;
+    QByteArray contentType;
+    QByteArray status = "200 OK";
+    if ((request.size() < 2) || (request.at(0) != "GET"))
+    {
+        status = "405 Method Not Allowed";
+    }
+    else if (request.at(1) == "/metrics")
+    {
+        body = Diagnostics::getInstance()->toPrometheus();
+        contentType = "text/plain; version=0.0.4";
+    }
+    else
+    {
+        body = QJsonDocument(Diagnostics::getInstance()->toJson()).toJson(QJsonDocument::Compact);
+        contentType = "application/json";
+    }
+
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    if (!contentType.isEmpty())
+    {
+        response += "Content-Type: " + contentType + "\r\n";
+    }
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                "Connection: close\r\n\r\n" + body;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
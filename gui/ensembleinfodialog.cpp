@@ -25,12 +25,17 @@
  */
 
 #include <QFileDialog>
+#include <QDir>
 #include <QScrollBar>
 #include <QDateTime>
 #include <QDebug>
 #include <QMenu>
+#include <QTextCursor>
+#include <QTextDocument>
 
 #include "ensembleinfodialog.h"
+#include "signaltelemetry.h"
+#include "spectrumwidget.h"
 #include "ui_ensembleinfodialog.h"
 
 EnsembleInfoDialog::EnsembleInfoDialog(QWidget *parent) :
@@ -56,6 +61,10 @@ EnsembleInfoDialog::EnsembleInfoDialog(QWidget *parent) :
     ui->serviceFrame->setMinimumWidth(minWidth);
     ui->signalFrame->setMinimumWidth(minWidth);
 
+    // spectrum below info frames, input tap is running only while dialog is visible
+    m_spectrumWidget = new SpectrumWidget(this);
+    ui->verticalLayout->insertWidget(1, m_spectrumWidget);
+
     ui->FIBframe->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui->FIBframe, &QWidget::customContextMenuRequested, this, &EnsembleInfoDialog::fibFrameContextMenu);
 
@@ -107,12 +116,20 @@ EnsembleInfoDialog::~EnsembleInfoDialog()
     delete ui;
 }
 
-void EnsembleInfoDialog::refreshEnsembleConfiguration(const QString & txt)
+void EnsembleInfoDialog::refreshEnsembleConfiguration(const RadioControlEnsembleConfiguration & config)
 {    
-    if (isVisible())
+    if (!isVisible())
+    {   // full configuration is requested when dialog is shown
+        return;
+    }
+
+    if (config.reset)
     {
-        ui->ensStructureTextEdit->setHtml(txt);
-        if (txt.isEmpty())
+        ui->ensStructureTextEdit->clear();
+        m_ensembleFrame = nullptr;
+        m_serviceFrames.clear();
+
+        if (config.ensemble.isEmpty())
         {   // empty ensemble configuration means tuning to new frequency
             clearSignalInfo();
             clearServiceInfo();
@@ -121,23 +138,74 @@ void EnsembleInfoDialog::refreshEnsembleConfiguration(const QString & txt)
             resetMscStat();
 
             ui->ensStructureTextEdit->setDocumentTitle("");
+            return;
         }
-        else
-        {
-            ui->ensStructureTextEdit->setDocumentTitle(tr("Ensemble information"));
+    }
 
-            int minWidth = ui->ensStructureTextEdit->document()->idealWidth()
-                           + ui->ensStructureTextEdit->contentsMargins().left()
-                           + ui->ensStructureTextEdit->contentsMargins().right()
-                           + ui->ensStructureTextEdit->verticalScrollBar()->width();
+    QTextDocument * doc = ui->ensStructureTextEdit->document();
+    if (nullptr == m_ensembleFrame)
+    {
+        QTextCursor cursor(doc->rootFrame()->firstCursorPosition());
+        m_ensembleFrame = cursor.insertFrame(QTextFrameFormat());
+    }
+    setFrameHtml(m_ensembleFrame, config.ensemble);
 
-            if (minWidth > 1000)
+    for (const auto & sid : config.removed)
+    {
+        QTextFrame * frame = m_serviceFrames.take(sid);
+        if (nullptr != frame)
+        {
+            removeFrame(frame);
+        }
+    }
+
+    for (auto it = config.services.cbegin(); it != config.services.cend(); ++it)
+    {
+        auto frameIt = m_serviceFrames.find(it.key());
+        if (m_serviceFrames.end() == frameIt)
+        {   // new service is inserted in SId order
+            QTextCursor cursor(doc);
+            auto nextIt = m_serviceFrames.upperBound(it.key());
+            if (m_serviceFrames.end() != nextIt)
+            {
+                cursor.setPosition((*nextIt)->firstPosition() - 1);
+            }
+            else
             {
-                minWidth = 1000;
+                cursor.setPosition(doc->rootFrame()->lastPosition());
             }
-            ui->ensStructureTextEdit->setMinimumWidth(minWidth);
+            frameIt = m_serviceFrames.insert(it.key(), cursor.insertFrame(QTextFrameFormat()));
         }
+        setFrameHtml(*frameIt, it.value());
     }
+
+    ui->ensStructureTextEdit->setDocumentTitle(tr("Ensemble information"));
+
+    int minWidth = doc->idealWidth()
+                   + ui->ensStructureTextEdit->contentsMargins().left()
+                   + ui->ensStructureTextEdit->contentsMargins().right()
+                   + ui->ensStructureTextEdit->verticalScrollBar()->width();
+
+    if (minWidth > 1000)
+    {
+        minWidth = 1000;
+    }
+    ui->ensStructureTextEdit->setMinimumWidth(minWidth);
+}
+
+void EnsembleInfoDialog::setFrameHtml(QTextFrame *frame, const QString &html)
+{
+    QTextCursor cursor = frame->firstCursorPosition();
+    cursor.setPosition(frame->lastPosition(), QTextCursor::KeepAnchor);
+    cursor.insertHtml(html);
+}
+
+void EnsembleInfoDialog::removeFrame(QTextFrame *frame)
+{   // selection including frame boundaries removes the frame
+    QTextCursor cursor(frame->document());
+    cursor.setPosition(frame->firstPosition() - 1);
+    cursor.setPosition(frame->lastPosition() + 1, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
 }
 
 void EnsembleInfoDialog::updateSnr(uint8_t, float snr)
@@ -255,10 +323,11 @@ void EnsembleInfoDialog::resetMscStat()
 void EnsembleInfoDialog::newFrequency(quint32 f)
 {
     m_frequency = f;
+    m_spectrumWidget->setFrequency(m_frequency);
     if (m_frequency)
     {
         ui->freq->setText(QString::number(m_frequency) + " kHz");
-        ui->channel->setText(DabTables::channelList.value(m_frequency));
+        ui->channel->setText(DabTables::channelName(m_frequency));
     }
     else
     {
@@ -315,12 +384,27 @@ void EnsembleInfoDialog::fibFrameContextMenu(const QPoint& pos)
     menu.addSeparator();
     QAction * fibResetAction = menu.addAction(tr("Reset FIB statistics"));
     QAction * mscResetAction = menu.addAction(tr("Reset MSC statistics"));
+    menu.addSeparator();
+    QAction * saveHistoryAction = menu.addAction(tr("Save signal history..."));
+    saveHistoryAction->setEnabled(SignalTelemetry::getInstance()->historySize() > 0);
     QAction * selectedItem = menu.exec(globalPos);
     if (nullptr == selectedItem)
     {  // nothing was chosen
        return;
     }
 
+    if (selectedItem == saveHistoryAction)
+    {   // SNR, frequency offset and error counters of last hours
+        QString fileName = QFileDialog::getSaveFileName(this, tr("Save signal history"),
+                                                        QDir::homePath() + "/" + QString("signal_%1.csv").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hhmmss")),
+                                                        tr("CSV files (*.csv)"));
+        if (!fileName.isEmpty() && !SignalTelemetry::getInstance()->saveHistory(fileName))
+        {
+            qWarning() << "Failed to save signal history to" << fileName;
+        }
+        return;
+    }
+
     if (selectedItem == mscResetAction)
     {   // msc reset
         resetMscStat();
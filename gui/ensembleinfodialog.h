@@ -29,8 +29,11 @@
 
 #include <QDialog>
 #include <QCloseEvent>
+#include <QTextFrame>
 #include "radiocontrol.h"
 
+class SpectrumWidget;
+
 namespace Ui {
 class EnsembleInfoDialog;
 }
@@ -42,7 +45,7 @@ class EnsembleInfoDialog : public QDialog
 public:
     explicit EnsembleInfoDialog(QWidget *parent = nullptr);
     ~EnsembleInfoDialog();
-    void refreshEnsembleConfiguration(const QString & txt);
+    void refreshEnsembleConfiguration(const RadioControlEnsembleConfiguration & config);
     void updateSnr(uint8_t, float snr);
     void updateFreqOffset(float offset);
 
@@ -70,6 +73,7 @@ protected:
     void closeEvent(QCloseEvent *event) override;
 private:
     Ui::EnsembleInfoDialog *ui;
+    SpectrumWidget * m_spectrumWidget;
 
     bool m_isRecordingActive = false;
     quint32 m_frequency;
@@ -79,12 +83,18 @@ private:
     quint32 m_crcCounter;
     quint32 m_crcErrorCounter;
 
+    // ensemble configuration document, one frame per service
+    QTextFrame * m_ensembleFrame = nullptr;
+    QMap<uint32_t, QTextFrame *> m_serviceFrames;
+
     void onRecordingButtonClicked();
     void fibFrameContextMenu(const QPoint &pos);
     void clearServiceInfo();
     void clearSignalInfo();
     void clearFreqInfo();
     void showRecordingStat(bool ena);
+    void setFrameHtml(QTextFrame * frame, const QString & html);
+    void removeFrame(QTextFrame * frame);
 };
 
 #endif // ENSEMBLEINFODIALOG_H
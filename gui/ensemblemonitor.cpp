@@ -0,0 +1,690 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QSettings>
+#include <QLoggingCategory>
+#include <algorithm>
+#include "ensemblemonitor.h"
+#include "servicelist.h"
+#include "dabtables.h"
+#include "config.h"
+#include "rtlsdrinput.h"
+#include "rtltcpinput.h"
+#if HAVE_AIRSPY
+#include "airspyinput.h"
+#endif
+#if HAVE_SOAPYSDR
+#include "soapysdrinput.h"
+#endif
+
+Q_LOGGING_CATEGORY(ensembleMonitor, "EnsembleMonitor", QtInfoMsg)
+
+EnsembleMonitor::EnsembleMonitor(ServiceList *serviceList, QObject *parent) : QObject(parent)
+{
+    m_serviceList = serviceList;
+}
+
+EnsembleMonitor::~EnsembleMonitor()
+{
+    removeAll();
+}
+
+void EnsembleMonitor::loadSettings(QSettings &settings)
+{
+    // [EnsembleMonitor]
+    // 1\device=rtlsdr
+    // 1\args=00000002
+    // 1\frequency=227360
+    // 2\device=rtltcp
+    // 2\args=192.168.1.10:1234
+    // 2\scan=true            ; background scan of all channels
+    // 2\period=30            ; pause between scans [min]
+    // 3\device=airspy
+    // 3\channels=225648,227360,229072   ; wideband capture, each channel is decoded by own receiver
+    int num = settings.beginReadArray("EnsembleMonitor");
+    for (int n = 0; n < num; ++n)
+    {
+        settings.setArrayIndex(n);
+        EnsembleMonitorReceiverConfig config;
+        QString device = settings.value("device", "").toString().toLower();
+        if ("rtlsdr" == device)
+        {
+            config.id = InputDeviceId::RTLSDR;
+        }
+        else if ("rtltcp" == device)
+        {
+            config.id = InputDeviceId::RTLTCP;
+        }
+        else if ("airspy" == device)
+        {
+            config.id = InputDeviceId::AIRSPY;
+        }
+        else if ("soapysdr" == device)
+        {
+            config.id = InputDeviceId::SOAPYSDR;
+        }
+        else
+        {
+            qCWarning(ensembleMonitor) << "Unknown device" << device;
+            continue;
+        }
+        config.device = settings.value("args", "").toString();
+        config.frequency = settings.value("frequency", 0).toUInt();
+        config.scan = settings.value("scan", false).toBool();
+        config.scanPeriodMin = settings.value("period", ENSEMBLEMONITOR_SCAN_PERIOD_MIN).toInt();
+        if (config.scanPeriodMin < 1)
+        {
+            config.scanPeriodMin = 1;
+        }
+        const QStringList channels = settings.value("channels").toStringList();
+        for (const auto & ch : channels)
+        {
+            uint32_t frequency = ch.trimmed().toUInt();
+            if (0 != frequency)
+            {
+                config.channels.append(frequency);
+            }
+            else { /* empty or invalid entry */ }
+        }
+        if (!config.channels.isEmpty() && (InputDeviceId::AIRSPY != config.id))
+        {
+            qCWarning(ensembleMonitor) << "Channels are supported only by Airspy wideband capture";
+            config.channels.clear();
+        }
+        else { /* OK */ }
+
+        addReceiver(config);
+    }
+    settings.endArray();
+}
+
+bool EnsembleMonitor::addReceiver(const EnsembleMonitorReceiverConfig &config)
+{
+    if (!config.channels.isEmpty())
+    {   // several receivers fed by one device
+        return addChannelizer(config);
+    }
+
+    if ((0 == config.frequency) && !config.scan)
+    {
+        qCWarning(ensembleMonitor) << "Frequency not set";
+        return false;
+    }
+
+    int idx = freeReceiverIdx();
+    if (idx < 0)
+    {
+        qCWarning(ensembleMonitor) << "Too many receivers, maximum is" << ENSEMBLEMONITOR_MAX_RECEIVERS;
+        return false;
+    }
+
+    InputDevice * inputDevice = createInputDevice(config);
+    if (nullptr == inputDevice)
+    {
+        qCWarning(ensembleMonitor) << "Input device not supported" << int(config.id);
+        return false;
+    }
+
+    Receiver * rx = startReceiver(idx, config, inputDevice);
+    if (nullptr == rx)
+    {
+        return false;
+    }
+
+    if (!rx->inputDevice->openDevice())
+    {
+        qCWarning(ensembleMonitor) << "Receiver" << idx << ": unable to open input device" << config.device;
+        stopReceiver(rx);
+        return false;
+    }
+
+    setDefaultGain(rx);
+
+    if (config.scan)
+    {
+        qCInfo(ensembleMonitor, "Receiver %d: %s, background scan every %d min", idx, rx->inputDevice->deviceDescription().device.name.toUtf8().constData(),
+               config.scanPeriodMin);
+    }
+    else
+    {
+        qCInfo(ensembleMonitor, "Receiver %d: %s, %.3f MHz", idx, rx->inputDevice->deviceDescription().device.name.toUtf8().constData(),
+               config.frequency/1000.0);
+    }
+
+    return true;
+}
+
+bool EnsembleMonitor::addChannelizer(const EnsembleMonitorReceiverConfig &config)
+{
+#if HAVE_AIRSPY
+    if (config.channels.size() > ENSEMBLEMONITOR_MAX_RECEIVERS - m_receivers.size())
+    {
+        qCWarning(ensembleMonitor) << "Too many receivers, maximum is" << ENSEMBLEMONITOR_MAX_RECEIVERS;
+        return false;
+    }
+
+    // LO in the middle of channels, all channels are selected digitally
+    auto minmax = std::minmax_element(config.channels.cbegin(), config.channels.cend());
+    AirspyInput * device = new AirspyInput(false, true);
+    device->setSerial(config.device);
+    device->setCenterFrequency((*minmax.first + *minmax.second) / 2);
+
+    // channels have fixed frequency
+    EnsembleMonitorReceiverConfig channelConfig = config;
+    channelConfig.channels.clear();
+    channelConfig.scan = false;
+    channelConfig.frequency = config.channels.at(0);
+
+    // first channel owns the device
+    Receiver * source = startReceiver(freeReceiverIdx(), channelConfig, device);
+    if (nullptr == source)
+    {
+        return false;
+    }
+    source->channelizer = true;
+    if (!device->openDevice())
+    {
+        qCWarning(ensembleMonitor) << "Receiver" << source->idx << ": unable to open input device" << config.device;
+        stopReceiver(source);
+        return false;
+    }
+    setDefaultGain(source);
+
+    for (int n = 1; n < config.channels.size(); ++n)
+    {
+        AirspyChannelInput * channel = device->addChannel();
+        if (nullptr == channel)
+        {   // wideband capture not available
+            break;
+        }
+
+        channelConfig.frequency = config.channels.at(n);
+        Receiver * rx = startReceiver(freeReceiverIdx(), channelConfig, channel);
+        if (nullptr == rx)
+        {
+            break;
+        }
+        rx->channelizer = true;
+        rx->sourceIdx = source->idx;
+        rx->inputDevice->openDevice();
+    }
+
+    qCInfo(ensembleMonitor, "Receiver %d: %s, wideband capture of %d channels, LO %.3f MHz", source->idx,
+           device->deviceDescription().device.name.toUtf8().constData(), int(config.channels.size()), (*minmax.first + *minmax.second) / 2000.0);
+    return true;
+#else
+    (void) config;
+    qCWarning(ensembleMonitor) << "Wideband capture requires Airspy support";
+    return false;
+#endif
+}
+
+EnsembleMonitor::Receiver *EnsembleMonitor::startReceiver(int idx, const EnsembleMonitorReceiverConfig &config, InputDevice *inputDevice)
+{
+    inputDevice->setReceiver(idx);
+
+    Receiver * rx = new Receiver;
+    rx->idx = idx;
+    rx->config = config;
+    rx->inputDevice = inputDevice;
+
+    // DAB processing on own thread, the same way as primary receiver
+    rx->radioControl = new RadioControl();
+    rx->radioControlThread = new QThread(this);
+    rx->radioControlThread->setObjectName(QString("radioControlThr%1").arg(idx));
+    rx->radioControl->moveToThread(rx->radioControlThread);
+    connect(rx->radioControlThread, &QThread::finished, rx->radioControl, &QObject::deleteLater);
+    rx->radioControlThread->start();
+
+    if (!rx->radioControl->init(idx))
+    {
+        delete rx->inputDevice;
+        rx->radioControlThread->quit();
+        rx->radioControlThread->wait();
+        delete rx->radioControlThread;
+        delete rx;
+        return nullptr;
+    }
+
+    // no audio is decoded, ensemble is only monitored
+    connect(rx->radioControl, &RadioControl::ensembleInformation, m_serviceList, &ServiceList::beginEnsembleUpdate, Qt::QueuedConnection);
+    connect(rx->radioControl, &RadioControl::ensembleReconfiguration, m_serviceList, &ServiceList::beginEnsembleUpdate, Qt::QueuedConnection);
+    connect(rx->radioControl, &RadioControl::serviceListComplete, m_serviceList, &ServiceList::endEnsembleUpdate, Qt::QueuedConnection);
+    connect(rx->radioControl, &RadioControl::serviceListEntry, this, [this](const RadioControlEnsemble &ens, const RadioControlServiceComponent &slEntry) {
+        if (slEntry.TMId == DabTMId::StreamAudio)
+        {   // data services not supported, the same as primary receiver
+            m_serviceList->addService(ens, slEntry);
+        }
+    }, Qt::QueuedConnection);
+    connect(rx->radioControl, &RadioControl::signalState, this, [this, idx](uint8_t sync, float snr) { onSignalState(idx, sync, snr); },
+            Qt::QueuedConnection);
+    // channel is changed when ensemble is complete or on timeout
+    // fixed receiver scans only during band scan, events are ignored otherwise (scan state is Idle)
+    connect(rx->radioControl, &RadioControl::tuneDone, this, [this, idx](uint32_t freq) { onTuneDone(idx, freq); }, Qt::QueuedConnection);
+    connect(rx->radioControl, &RadioControl::ensembleInformation, this, [this, idx]() { onEnsembleInformation(idx); }, Qt::QueuedConnection);
+    connect(rx->radioControl, &RadioControl::serviceListComplete, this, [this, idx]() { onServiceListComplete(idx); }, Qt::QueuedConnection);
+    rx->scanTimer = new QTimer(this);
+    rx->scanTimer->setSingleShot(true);
+    connect(rx->scanTimer, &QTimer::timeout, this, [this, idx]() { onScanTimeout(idx); });
+
+    // tuning procedure
+    connect(rx->radioControl, &RadioControl::tuneInputDevice, rx->inputDevice, &InputDevice::tune, Qt::QueuedConnection);
+    connect(rx->inputDevice, &InputDevice::tuned, rx->radioControl, &RadioControl::start, Qt::QueuedConnection);
+    // receiver is identified by index, queued events may come after receiver was stopped
+    connect(rx->inputDevice, &InputDevice::deviceReady, this, [this, idx]() { onInputDeviceReady(idx); }, Qt::QueuedConnection);
+    connect(rx->inputDevice, &InputDevice::error, this, [this, idx](const InputDeviceErrorCode errCode) { onInputDeviceError(idx, errCode); },
+            Qt::QueuedConnection);
+
+    m_receivers.append(rx);
+
+    return rx;
+}
+
+void EnsembleMonitor::setDefaultGain(Receiver *rx)
+{   // default gain settings, the same as defaults of primary receiver
+    switch (rx->config.id)
+    {
+    case InputDeviceId::RTLSDR:
+        dynamic_cast<RtlSdrInput*>(rx->inputDevice)->setGainMode(RtlGainMode::Software);
+        break;
+    case InputDeviceId::RTLTCP:
+        dynamic_cast<RtlTcpInput*>(rx->inputDevice)->setGainMode(RtlGainMode::Software);
+        break;
+#if HAVE_AIRSPY
+    case InputDeviceId::AIRSPY:
+    {
+        AirspyGainStr gain = { AirpyGainMode::Hybrid, 9, 0, 0, 5, true, true };
+        dynamic_cast<AirspyInput*>(rx->inputDevice)->setGainMode(gain);
+    }
+        break;
+#endif
+#if HAVE_SOAPYSDR
+    case InputDeviceId::SOAPYSDR:
+        dynamic_cast<SoapySdrInput*>(rx->inputDevice)->setGainMode(SoapyGainMode::Hardware);
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+void EnsembleMonitor::removeAll()
+{
+    while (!m_receivers.isEmpty())
+    {
+        stopReceiver(m_receivers.last());
+    }
+}
+
+InputDevice *EnsembleMonitor::createInputDevice(const EnsembleMonitorReceiverConfig &config) const
+{
+    switch (config.id)
+    {
+    case InputDeviceId::RTLSDR:
+    {
+        RtlSdrInput * inputDevice = new RtlSdrInput();
+        inputDevice->setSerial(config.device);
+        return inputDevice;
+    }
+    case InputDeviceId::RTLTCP:
+    {
+        RtlTcpInput * inputDevice = new RtlTcpInput();
+        int port = 1234;
+        QString address = config.device;
+        int portPos = address.lastIndexOf(':');
+        if (portPos > 0)
+        {
+            port = address.mid(portPos + 1).toInt();
+            address = address.left(portPos);
+        }
+        else { /* default rtl_tcp port */ }
+        inputDevice->setTcpIp(address, port);
+        return inputDevice;
+    }
+#if HAVE_AIRSPY
+    case InputDeviceId::AIRSPY:
+    {
+        AirspyInput * inputDevice = new AirspyInput(true);
+        inputDevice->setSerial(config.device);
+        return inputDevice;
+    }
+#endif
+#if HAVE_SOAPYSDR
+    case InputDeviceId::SOAPYSDR:
+    {
+        SoapySdrInput * inputDevice = new SoapySdrInput();
+        inputDevice->setDevArgs(config.device);
+        return inputDevice;
+    }
+#endif
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+void EnsembleMonitor::onInputDeviceReady(int idx)
+{
+    Receiver * rx = receiver(idx);
+    if ((nullptr == rx) || rx->bandScan)
+    {   // already stopped or band scan started before device was ready
+        return;
+    }
+
+    if (rx->config.scan)
+    {   // first scan starts immediately
+        rx->scanChannelIdx = -1;
+        rx->scanNumEnsembles = 0;
+        scanStep(rx);
+    }
+    else
+    {   // receiver stays on its frequency, no service is selected
+        tune(rx, rx->config.frequency);
+    }
+}
+
+void EnsembleMonitor::tune(Receiver *rx, uint32_t frequency)
+{
+    rx->frequency = frequency;
+    RadioControl * radioControl = rx->radioControl;
+    QMetaObject::invokeMethod(radioControl, [radioControl, frequency]() { radioControl->tuneService(frequency, 0, 0); }, Qt::QueuedConnection);
+}
+
+bool EnsembleMonitor::isScanned(uint32_t frequency) const
+{
+    if (frequency == m_primaryFrequency)
+    {
+        return false;
+    }
+    for (const auto rx : m_receivers)
+    {
+        if (!rx->config.scan && (rx->config.frequency == frequency))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EnsembleMonitor::scanStep(Receiver *rx)
+{
+    uint32_t frequency;
+    if (rx->bandScan)
+    {   // channel from common band scan list
+        frequency = m_bandScanNextChannel(rx->idx);
+        if (0 == frequency)
+        {   // all channels are taken
+            qCInfo(ensembleMonitor) << "Receiver" << rx->idx << ": band scan finished," << rx->scanNumEnsembles << "ensembles found";
+            rx->bandScan = false;
+            resumeReceiver(rx);
+            return;
+        }
+        else { /* channel to scan */ }
+    }
+    else
+    {
+        do
+        {
+            ++rx->scanChannelIdx;
+        } while ((rx->scanChannelIdx < DabTables::numChannels()) && !isScanned(DabTables::channelFrequency(rx->scanChannelIdx)));
+
+        if (rx->scanChannelIdx >= DabTables::numChannels())
+        {   // cycle finished, device is idle till next one
+            qCInfo(ensembleMonitor) << "Receiver" << rx->idx << ": background scan finished," << rx->scanNumEnsembles << "ensembles found";
+            emit scanFinished(rx->idx, rx->scanNumEnsembles);
+
+            rx->scanState = Receiver::ScanState::Idle;
+            tune(rx, 0);
+            rx->scanTimer->start(rx->config.scanPeriodMin * 60 * 1000);
+            return;
+        }
+        frequency = DabTables::channelFrequency(rx->scanChannelIdx);
+    }
+
+    rx->scanState = Receiver::ScanState::WaitForTune;
+    tune(rx, frequency);
+    rx->scanTimer->start(ENSEMBLEMONITOR_SCAN_SYNC_MS);   // input device does not respond
+}
+
+void EnsembleMonitor::resumeReceiver(Receiver *rx)
+{
+    rx->scanTimer->stop();
+    rx->scanState = Receiver::ScanState::Idle;
+    if (rx->config.scan)
+    {   // service list was refreshed by band scan, next background scan after regular pause
+        tune(rx, 0);
+        rx->scanTimer->start(rx->config.scanPeriodMin * 60 * 1000);
+    }
+    else
+    {   // back to fixed frequency
+        tune(rx, rx->config.frequency);
+    }
+}
+
+int EnsembleMonitor::startBandScan(const std::function<uint32_t (int)> &nextChannel)
+{
+    m_bandScanNextChannel = nextChannel;
+    int num = 0;
+    for (const auto rx : m_receivers)
+    {
+        if (rx->channelizer)
+        {   // channels are bound to LO of wideband device
+            continue;
+        }
+
+        // current channel or background scan cycle is abandoned
+        rx->bandScan = true;
+        rx->scanTimer->stop();
+        rx->scanNumEnsembles = 0;
+        scanStep(rx);
+        ++num;
+    }
+
+    if (num > 0)
+    {
+        qCInfo(ensembleMonitor) << "Band scan shared with" << num << "receivers";
+    }
+    else { /* primary receiver only */ }
+
+    return num;
+}
+
+void EnsembleMonitor::stopBandScan()
+{
+    m_bandScanNextChannel = nullptr;
+    for (const auto rx : m_receivers)
+    {
+        if (rx->bandScan)
+        {   // interrupted
+            rx->bandScan = false;
+            resumeReceiver(rx);
+        }
+        else { /* already finished */ }
+    }
+}
+
+void EnsembleMonitor::onScanTimeout(int idx)
+{
+    Receiver * rx = receiver(idx);
+    if (nullptr == rx)
+    {   // already stopped
+        return;
+    }
+
+    if (Receiver::ScanState::Idle == rx->scanState)
+    {   // next cycle
+        rx->scanChannelIdx = -1;
+        rx->scanNumEnsembles = 0;
+    }
+    else { /* no signal, ensemble or complete service list on current channel */ }
+    scanStep(rx);
+}
+
+void EnsembleMonitor::onTuneDone(int idx, uint32_t frequency)
+{
+    Receiver * rx = receiver(idx);
+    if ((nullptr == rx) || (Receiver::ScanState::WaitForTune != rx->scanState) || (frequency != rx->frequency))
+    {   // stopped or late event
+        return;
+    }
+
+    rx->scanState = Receiver::ScanState::WaitForSync;
+    rx->scanTimer->start(ENSEMBLEMONITOR_SCAN_SYNC_MS);
+}
+
+void EnsembleMonitor::onSignalState(int idx, uint8_t sync, float snr)
+{
+    Receiver * rx = receiver(idx);
+    if (nullptr == rx)
+    {   // already stopped
+        return;
+    }
+
+    emit receiverState(idx, rx->frequency, sync, snr);
+
+    if ((Receiver::ScanState::WaitForSync == rx->scanState) && (DabSyncLevel::NullSync <= DabSyncLevel(sync)))
+    {
+        rx->scanState = Receiver::ScanState::WaitForEnsemble;
+        rx->scanTimer->start(ENSEMBLEMONITOR_SCAN_ENSEMBLE_MS);
+    }
+    else { /* fixed frequency or not waiting for sync */ }
+}
+
+void EnsembleMonitor::onEnsembleInformation(int idx)
+{
+    Receiver * rx = receiver(idx);
+    if ((nullptr == rx) || (Receiver::ScanState::Idle == rx->scanState) || (Receiver::ScanState::WaitForServices == rx->scanState))
+    {   // stopped, idle or reconfiguration
+        return;
+    }
+
+    rx->scanNumEnsembles += 1;
+    if (rx->bandScan)
+    {
+        emit bandScanEnsembleFound(idx, rx->frequency);
+    }
+    else { /* background scan */ }
+    rx->scanState = Receiver::ScanState::WaitForServices;
+    rx->scanTimer->start(ENSEMBLEMONITOR_SCAN_SERVICES_MS);
+}
+
+void EnsembleMonitor::onServiceListComplete(int idx)
+{
+    Receiver * rx = receiver(idx);
+    if ((nullptr == rx) || (Receiver::ScanState::WaitForServices != rx->scanState))
+    {   // stopped or not scanning
+        return;
+    }
+
+    // service list was updated by endEnsembleUpdate() => next channel
+    scanStep(rx);
+}
+
+void EnsembleMonitor::onInputDeviceError(int idx, const InputDeviceErrorCode errCode)
+{
+    Receiver * rx = receiver(idx);
+    if (nullptr == rx)
+    {   // already stopped
+        return;
+    }
+
+    qCWarning(ensembleMonitor) << "Receiver" << idx << ": input device error" << int(errCode);
+
+    emit receiverError(idx, errCode);
+    if (rx->bandScan)
+    {   // band scan does not wait for this receiver
+        emit bandScanReceiverStopped(idx);
+    }
+    else { /* not scanning */ }
+    for (const auto channelRx : std::as_const(m_receivers))
+    {
+        if (channelRx->sourceIdx == idx)
+        {   // channels of wideband capture are lost together with the device
+            emit receiverError(channelRx->idx, errCode);
+        }
+        else { /* other device */ }
+    }
+    stopReceiver(rx);
+}
+
+void EnsembleMonitor::stopReceiver(Receiver *rx)
+{
+    // channels of wideband capture are stopped before the device
+    QList<Receiver *> channels;
+    for (const auto channelRx : std::as_const(m_receivers))
+    {
+        if (channelRx->sourceIdx == rx->idx)
+        {
+            channels.append(channelRx);
+        }
+        else { /* other device */ }
+    }
+    for (const auto channelRx : channels)
+    {
+        stopReceiver(channelRx);
+    }
+
+    m_receivers.removeOne(rx);
+
+    // no more signals from this receiver
+    disconnect(rx->radioControl, nullptr, this, nullptr);
+    disconnect(rx->radioControl, nullptr, m_serviceList, nullptr);
+    disconnect(rx->inputDevice, nullptr, this, nullptr);
+    delete rx->scanTimer;
+
+    // input device first, then DAB processing (the same order as MainWindow)
+    delete rx->inputDevice;
+    QMetaObject::invokeMethod(rx->radioControl, &RadioControl::exit, Qt::BlockingQueuedConnection);
+    rx->radioControlThread->quit();  // this deletes radioControl
+    rx->radioControlThread->wait();
+    delete rx->radioControlThread;
+
+    delete rx;
+}
+
+EnsembleMonitor::Receiver *EnsembleMonitor::receiver(int idx) const
+{
+    for (const auto rx : m_receivers)
+    {
+        if (rx->idx == idx)
+        {
+            return rx;
+        }
+    }
+    return nullptr;
+}
+
+int EnsembleMonitor::freeReceiverIdx() const
+{
+    for (int idx = 1; idx < INPUT_MAX_RECEIVERS; ++idx)
+    {
+        if (nullptr == receiver(idx))
+        {
+            return idx;
+        }
+    }
+    return -1;
+}
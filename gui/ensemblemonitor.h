@@ -0,0 +1,143 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef ENSEMBLEMONITOR_H
+#define ENSEMBLEMONITOR_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QList>
+#include <functional>
+#include "inputdevice.h"
+#include "radiocontrol.h"
+
+class ServiceList;
+class QSettings;
+
+// receiver 0 is used by MainWindow, monitor runs remaining receivers
+#define ENSEMBLEMONITOR_MAX_RECEIVERS (INPUT_MAX_RECEIVERS - 1)
+
+// background scan: receiver cycles through all channels, pause between cycles is configurable
+#define ENSEMBLEMONITOR_SCAN_PERIOD_MIN   (30)     // default pause between scan cycles
+#define ENSEMBLEMONITOR_SCAN_SYNC_MS      (3000)   // channel timeouts, the same as in BandScanDialog
+#define ENSEMBLEMONITOR_SCAN_ENSEMBLE_MS  (6000)
+#define ENSEMBLEMONITOR_SCAN_SERVICES_MS  (8000)
+
+struct EnsembleMonitorReceiverConfig
+{
+    InputDeviceId id = InputDeviceId::UNDEFINED;  // RTLSDR, RTLTCP, AIRSPY or SOAPYSDR
+    QString device;          // RTL-SDR & Airspy: USB serial, RTL-TCP: address:port, SoapySDR: device args
+    uint32_t frequency = 0;  // kHz, not used in scan mode
+    bool scan = false;       // background scan of all channels instead of fixed frequency
+    int scanPeriodMin = ENSEMBLEMONITOR_SCAN_PERIOD_MIN;
+    QList<uint32_t> channels; // Airspy only: channels of one wideband capture, each decoded by own receiver
+};
+
+// additional input devices, each with own DAB processing on own thread
+// tuned to fixed frequency, ensembles are added to common service list
+// audio & user applications are decoded by primary receiver only, service from monitored ensemble is selected by tuning
+// receiver in scan mode refreshes service list in background, channel of primary receiver and
+// frequencies of fixed receivers are skipped (they update service list themselves)
+// during band scan all receivers take channels from common list together with primary receiver,
+// regular operation is resumed when the list is empty
+// wideband Airspy capture can feed several receivers (channelizer), these receivers are bound to LO
+// of the device and they do not take part in band scan
+class EnsembleMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EnsembleMonitor(ServiceList * serviceList, QObject *parent = nullptr);
+    ~EnsembleMonitor();
+
+    // receivers are configured only from ini file
+    void loadSettings(QSettings & settings);
+    bool addReceiver(const EnsembleMonitorReceiverConfig & config);
+    void removeAll();
+    int numReceivers() const { return m_receivers.size(); }
+
+    // frequency of primary receiver, it is skipped by background scan
+    void setPrimaryFrequency(uint32_t frequency) { m_primaryFrequency = frequency; }
+
+    // nextChannel returns next channel for receiver or 0 when all channels are taken
+    // returns number of receivers taking part in band scan
+    int startBandScan(const std::function<uint32_t(int)> & nextChannel);
+    void stopBandScan();
+
+signals:
+    void receiverState(int receiver, uint32_t frequency, uint8_t sync, float snr);
+    void receiverError(int receiver, const InputDeviceErrorCode errCode);
+    void scanFinished(int receiver, int numEnsembles);
+    void bandScanEnsembleFound(int receiver, uint32_t frequency);
+    void bandScanReceiverStopped(int receiver);   // receiver was lost during band scan, its channel is not finished
+
+private:
+    struct Receiver
+    {
+        int idx;                      // receiver index (FIFO and input function of DAB processing)
+        EnsembleMonitorReceiverConfig config;
+        InputDevice * inputDevice;
+        RadioControl * radioControl;
+        QThread * radioControlThread;
+        uint32_t frequency = 0;       // current frequency
+
+        // background scan
+        enum class ScanState { Idle, WaitForTune, WaitForSync, WaitForEnsemble, WaitForServices };
+        ScanState scanState = ScanState::Idle;
+        int scanChannelIdx = 0;
+        int scanNumEnsembles = 0;
+        QTimer * scanTimer = nullptr;
+        bool bandScan = false;        // channels are taken from band scan list
+        bool channelizer = false;     // receiver is fed by wideband capture
+        int sourceIdx = -1;           // receiver owning wideband device, -1 if this receiver owns its device
+    };
+
+    ServiceList * m_serviceList;
+    QList<Receiver *> m_receivers;
+    uint32_t m_primaryFrequency = 0;
+    std::function<uint32_t(int)> m_bandScanNextChannel;
+
+    InputDevice * createInputDevice(const EnsembleMonitorReceiverConfig & config) const;
+    Receiver * startReceiver(int idx, const EnsembleMonitorReceiverConfig & config, InputDevice * inputDevice);
+    bool addChannelizer(const EnsembleMonitorReceiverConfig & config);
+    void setDefaultGain(Receiver * rx);
+    void onInputDeviceReady(int idx);
+    void onInputDeviceError(int idx, const InputDeviceErrorCode errCode);
+    void tune(Receiver * rx, uint32_t frequency);
+    bool isScanned(uint32_t frequency) const;
+    void scanStep(Receiver * rx);
+    void resumeReceiver(Receiver * rx);
+    void onScanTimeout(int idx);
+    void onTuneDone(int idx, uint32_t frequency);
+    void onSignalState(int idx, uint8_t sync, float snr);
+    void onEnsembleInformation(int idx);
+    void onServiceListComplete(int idx);
+    void stopReceiver(Receiver * rx);
+    Receiver * receiver(int idx) const;
+    int freeReceiverIdx() const;
+};
+
+#endif // ENSEMBLEMONITOR_H
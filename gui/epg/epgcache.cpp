@@ -0,0 +1,243 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QLoggingCategory>
+#include <algorithm>
+#include "epgcache.h"
+
+Q_DECLARE_LOGGING_CATEGORY(metadataManager)
+
+bool EPGCache::write(const QString &fileName, const QList<EPGModelItem> &items)
+{
+    QByteArray data = serialize(items);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qCWarning(metadataManager) << "Unable to write EPG cache file" << fileName;
+        return false;
+    }
+
+    bool ok = (file.write(data) == data.size());
+    file.close();
+
+    if (!ok)
+    {   // do not leave incomplete file
+        qCWarning(metadataManager) << "Failed to write EPG cache file" << fileName;
+        file.remove();
+    }
+    return ok;
+}
+
+QByteArray EPGCache::serialize(const QList<EPGModelItem> &items)
+{
+    static_assert(sizeof(Header) == 24, "Unexpected EPG cache header size");
+    static_assert(sizeof(Record) == 56, "Unexpected EPG cache record size");
+
+    // sort by start time to allow lookup
+    QList<const EPGModelItem *> sorted;
+    sorted.reserve(items.size());
+    for (const auto & item : items)
+    {
+        if (item.isValid())
+        {
+            sorted.append(&item);
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const EPGModelItem * a, const EPGModelItem * b) {
+        return a->startTimeSecSinceEpoch() < b->startTimeSecSinceEpoch();
+    });
+
+    QList<Record> records(sorted.size());
+    QString stringTable;
+    for (int n = 0; n < sorted.size(); ++n)
+    {
+        const EPGModelItem * item = sorted.at(n);
+        Record & rec = records[n];
+        rec.startTimeSecSinceEpoch = item->startTimeSecSinceEpoch();
+        rec.durationSec = item->durationSec();
+        rec.shortId = item->shortId();
+
+        const QString strings[EPGCACHE_NUM_STRINGS] = {
+            item->longName(), item->mediumName(), item->shortName(), item->longDescription(), item->shortDescription()
+        };
+        for (int s = 0; s < EPGCACHE_NUM_STRINGS; ++s)
+        {
+            rec.strOffset[s] = stringTable.size();
+            rec.strLength[s] = strings[s].size();
+            stringTable.append(strings[s]);
+        }
+    }
+
+    Header header;
+    header.magic = EPGCACHE_MAGIC;
+    header.version = EPGCACHE_VERSION;
+    header.recordSize = sizeof(Record);
+    header.numRecords = records.size();
+    header.stringTableOffset = sizeof(Header) + records.size() * sizeof(Record);
+    header.stringTableSize = stringTable.size();
+    header.reserved = 0;
+
+    QByteArray data;
+    data.reserve(header.stringTableOffset + stringTable.size() * sizeof(QChar));
+    data.append(reinterpret_cast<const char *>(&header), sizeof(Header));
+    data.append(reinterpret_cast<const char *>(records.constData()), records.size() * sizeof(Record));
+    data.append(reinterpret_cast<const char *>(stringTable.constData()), stringTable.size() * sizeof(QChar));
+    return data;
+}
+
+const uchar * EPGCache::mapFile(QFile &file)
+{   // returns mapped file with valid header or nullptr
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return nullptr;
+    }
+
+    qint64 size = file.size();
+    if (size < qint64(sizeof(Header)))
+    {
+        return nullptr;
+    }
+
+    const uchar * data = file.map(0, size);
+    if (nullptr == data)
+    {
+        return nullptr;
+    }
+
+    const Header * header = reinterpret_cast<const Header *>(data);
+    const qint64 stringTableEnd = qint64(header->stringTableOffset) + qint64(header->stringTableSize) * sizeof(QChar);
+    if ((EPGCACHE_MAGIC != header->magic) || (EPGCACHE_VERSION != header->version) || (sizeof(Record) != header->recordSize)
+        || (qint64(sizeof(Header) + qint64(header->numRecords) * sizeof(Record)) != header->stringTableOffset)
+        || (stringTableEnd > size))
+    {
+        qCDebug(metadataManager) << "Invalid EPG cache file" << file.fileName();
+        file.unmap(const_cast<uchar *>(data));
+        return nullptr;
+    }
+    return data;
+}
+
+bool EPGCache::read(const QString &fileName, int ltoSec, QList<EPGModelItem *> &items, bool lazyLongDescription)
+{
+    QFile file(fileName);
+    const uchar * data = mapFile(file);
+    if (nullptr == data)
+    {
+        return false;
+    }
+
+    const Header * header = reinterpret_cast<const Header *>(data);
+    const Record * records = reinterpret_cast<const Record *>(data + sizeof(Header));
+    const QChar * stringTable = reinterpret_cast<const QChar *>(data + header->stringTableOffset);
+    items.reserve(items.size() + header->numRecords);
+    for (uint32_t n = 0; n < header->numRecords; ++n)
+    {
+        const Record & rec = records[n];
+        QString strings[EPGCACHE_NUM_STRINGS];
+        bool valid = true;
+        for (int s = 0; s < EPGCACHE_NUM_STRINGS; ++s)
+        {
+            if (qint64(rec.strOffset[s]) + rec.strLength[s] > header->stringTableSize)
+            {
+                valid = false;
+                break;
+            }
+            if (!lazyLongDescription || (StringIdx::LongDescription != s))
+            {
+                strings[s] = QString(stringTable + rec.strOffset[s], rec.strLength[s]);
+            }
+            else { /* read when needed */ }
+        }
+        if (!valid)
+        {
+            continue;
+        }
+
+        EPGModelItem * item = new EPGModelItem;
+        item->setStartTime(QDateTime::fromSecsSinceEpoch(rec.startTimeSecSinceEpoch).toUTC().toOffsetFromUtc(ltoSec));
+        item->setDurationSec(rec.durationSec);
+        item->setShortId(rec.shortId);
+        item->setLongName(strings[StringIdx::LongName]);
+        item->setMediumName(strings[StringIdx::MediumName]);
+        item->setShortName(strings[StringIdx::ShortName]);
+        if (lazyLongDescription && (rec.strLength[StringIdx::LongDescription] > 0))
+        {
+            item->setLongDescriptionFile(fileName);
+        }
+        else
+        {
+            item->setLongDescription(strings[StringIdx::LongDescription]);
+        }
+        item->setShortDescription(strings[StringIdx::ShortDescription]);
+        items.append(item);
+    }
+
+    file.unmap(const_cast<uchar *>(data));
+    file.close();
+
+    return true;
+}
+
+QString EPGCache::readLongDescription(const QString &fileName, qint64 startTimeSecSinceEpoch)
+{   // file can be rewritten since item was loaded => record is found by start time
+    QFile file(fileName);
+    const uchar * data = mapFile(file);
+    if (nullptr == data)
+    {
+        return QString();
+    }
+
+    const Header * header = reinterpret_cast<const Header *>(data);
+    const Record * records = reinterpret_cast<const Record *>(data + sizeof(Header));
+    const Record * it = std::lower_bound(records, records + header->numRecords, startTimeSecSinceEpoch,
+                                         [](const Record & rec, qint64 t) { return rec.startTimeSecSinceEpoch < t; });
+    QString str;
+    if ((records + header->numRecords != it) && (it->startTimeSecSinceEpoch == startTimeSecSinceEpoch)
+        && (qint64(it->strOffset[StringIdx::LongDescription]) + it->strLength[StringIdx::LongDescription] <= header->stringTableSize))
+    {
+        const QChar * stringTable = reinterpret_cast<const QChar *>(data + header->stringTableOffset);
+        str = QString(stringTable + it->strOffset[StringIdx::LongDescription], it->strLength[StringIdx::LongDescription]);
+    }
+    else { /* not found */ }
+
+    file.unmap(const_cast<uchar *>(data));
+    return str;
+}
+
+bool EPGCache::isValid(const QString &fileName, const QString &xmlFileName)
+{
+    QFileInfo cacheInfo(fileName);
+    if (!cacheInfo.exists())
+    {
+        return false;
+    }
+    QFileInfo xmlInfo(xmlFileName);
+    return !xmlInfo.exists() || (cacheInfo.lastModified() >= xmlInfo.lastModified());
+}
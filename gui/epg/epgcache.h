@@ -0,0 +1,96 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EPGCACHE_H
+#define EPGCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QFile>
+#include "epgmodelitem.h"
+
+// binary EPG cache file structure (little endian, all records 8 bytes aligned):
+// [header][record 0]...[record N-1][string table (UTF-16)]
+// records are sorted by start time
+#define EPGCACHE_MAGIC     0x43475045   // "EPGC"
+#define EPGCACHE_VERSION   1
+#define EPGCACHE_NUM_STRINGS 5
+
+class EPGCache
+{
+public:
+    // writes items to file, returns false on failure
+    static bool write(const QString & fileName, const QList<EPGModelItem> & items);
+
+    // cache file content, used when file is written asynchronously
+    static QByteArray serialize(const QList<EPGModelItem> & items);
+
+    // maps file and creates items, start time is converted to offset from UTC ltoSec
+    // long descriptions are not loaded when lazyLongDescription is set, item reads it from file when needed
+    // returns false when file does not exist or is not valid cache file
+    static bool read(const QString & fileName, int ltoSec, QList<EPGModelItem *> & items, bool lazyLongDescription = false);
+
+    // long description of programme starting at given time, empty if not found
+    static QString readLongDescription(const QString & fileName, qint64 startTimeSecSinceEpoch);
+
+    // returns true if cache file exists and is not older than source XML file
+    static bool isValid(const QString & fileName, const QString & xmlFileName);
+
+private:
+    static const uchar * mapFile(QFile & file);
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t recordSize;
+        uint32_t numRecords;
+        uint32_t stringTableOffset;     // bytes from file begin
+        uint32_t stringTableSize;       // number of UTF-16 code units
+        uint32_t reserved;
+    };
+
+    struct Record
+    {
+        int64_t startTimeSecSinceEpoch;
+        int32_t durationSec;
+        int32_t shortId;
+        uint32_t strOffset[EPGCACHE_NUM_STRINGS];    // UTF-16 code units from string table begin
+        uint32_t strLength[EPGCACHE_NUM_STRINGS];
+    };
+
+    enum StringIdx
+    {
+        LongName = 0,
+        MediumName,
+        ShortName,
+        LongDescription,
+        ShortDescription,
+    };
+};
+
+#endif // EPGCACHE_H
@@ -248,3 +248,41 @@ void EPGDialog::scheduleRecording()
         emit scheduleAudioRecording(item);
     }
 }
+
+LogoImageResponse::LogoImageResponse(const MetadataManager *metadataManager, const QString &id, const QSize &requestedSize)
+    : m_metadataManager(metadataManager)
+    , m_id(static_cast<uint64_t>(id.toULongLong()))
+    , m_requestedSize(requestedSize)
+{
+    // response is deleted by QML engine
+    setAutoDelete(false);
+}
+
+QQuickTextureFactory *LogoImageResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+void LogoImageResponse::run()
+{
+    m_image = m_metadataManager->logoImage(m_id, MetadataManager::MetadataRole::SmallLogo, m_requestedSize);
+    if (m_image.isNull())
+    {   // transparent placeholder
+        m_image = QImage(m_requestedSize.width() > 0 ? m_requestedSize.width() : 32,
+                         m_requestedSize.height() > 0 ? m_requestedSize.height() : 32, QImage::Format_ARGB32_Premultiplied);
+        m_image.fill(Qt::transparent);
+    }
+    emit finished();
+}
+
+LogoProvider::LogoProvider(const MetadataManager *metadataManager) : m_metadataManager(metadataManager)
+{
+    m_pool.setMaxThreadCount(EPGDIALOG_LOGO_THREADS);
+}
+
+QQuickImageResponse *LogoProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    LogoImageResponse * response = new LogoImageResponse(m_metadataManager, id, requestedSize);
+    m_pool.start(response);
+    return response;
+}
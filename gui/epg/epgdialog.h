@@ -29,6 +29,8 @@
 
 #include <QDialog>
 #include <QQuickImageProvider>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QQuickView>
 #include <QItemSelectionModel>
 #include "audiorecscheduleitem.h"
@@ -36,6 +38,8 @@
 #include "slmodel.h"
 #include "slproxymodel.h"
 
+#define EPGDIALOG_LOGO_THREADS  (2)   // threads decoding logos for QML
+
 namespace Ui {
 class EPGDialog;
 }
@@ -105,34 +109,32 @@ private:
 };
 
 
-// this class serves as simple image provider for EPG QML using MatedataManager as backend
-class LogoProvider : public QQuickImageProvider
+// logo request of EPG QML, logo is decoded in provider thread pool
+class LogoImageResponse : public QQuickImageResponse, public QRunnable
 {
 public:
-    explicit LogoProvider(MetadataManager * metadataManager) : QQuickImageProvider(QQuickImageProvider::Pixmap)
-        , m_metadataManager(metadataManager) {};
-
-    QPixmap requestPixmap(const QString &id, QSize *size, const QSize &requestedSize) override
-    {
-        QPixmap logo = m_metadataManager->data(ServiceListId(static_cast<uint64_t>(id.toUInt())),
-                                               MetadataManager::MetadataRole::SmallLogo).value<QPixmap>();
-        if (logo.isNull())
-        {
-            logo = QPixmap(requestedSize.width() > 0 ? requestedSize.width() : 32,
-                           requestedSize.height() > 0 ? requestedSize.height() : 32);
-            logo.fill(QColor(0,0,0,0));
-        }
-
-        if (size)
-        {
-            *size = QSize(logo.width(), logo.height());
-        }
-
-        return logo;
-    }
+    LogoImageResponse(const MetadataManager * metadataManager, const QString &id, const QSize &requestedSize);
+    QQuickTextureFactory * textureFactory() const override;
+    void run() override;
 
 private:
-    MetadataManager * m_metadataManager;
+    const MetadataManager * m_metadataManager;
+    ServiceListId m_id;
+    QSize m_requestedSize;
+    QImage m_image;
+};
+
+// asynchronous image provider for EPG QML using MetadataManager as backend
+// requests never block render thread
+class LogoProvider : public QQuickAsyncImageProvider
+{
+public:
+    explicit LogoProvider(const MetadataManager * metadataManager);
+    QQuickImageResponse * requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+private:
+    const MetadataManager * m_metadataManager;
+    QThreadPool m_pool;
 };
 
 
@@ -0,0 +1,165 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include "epgfilewriter.h"
+
+Q_DECLARE_LOGGING_CATEGORY(metadataManager)
+
+EPGFileWriter::EPGFileWriter(QObject *parent) : QThread(parent)
+{ }
+
+EPGFileWriter::~EPGFileWriter()
+{
+    m_mutex.lock();
+    m_exitRequest = true;
+    m_jobCondition.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+}
+
+void EPGFileWriter::write(const QString &fileName, const QByteArray &data, const QString &notOlderThanFileName)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_jobs.isEmpty())
+    {   // first file of the batch
+        m_writeDeadline.setRemainingTime(EPGFILEWRITER_DELAY_MS);
+    }
+    if (!m_jobs.contains(fileName))
+    {
+        m_jobOrder.append(fileName);
+    }
+    else
+    {   /* newer version replaces pending one */ }
+
+    m_jobs[fileName] = Job{data, notOlderThanFileName};
+    m_jobCondition.wakeOne();
+}
+
+void EPGFileWriter::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_jobs.isEmpty() && !m_isWriting)
+    {
+        return;
+    }
+
+    m_flushRequest = true;
+    m_jobCondition.wakeOne();
+    while (!m_jobs.isEmpty() || m_isWriting)
+    {
+        m_doneCondition.wait(&m_mutex);
+    }
+    m_flushRequest = false;
+}
+
+void EPGFileWriter::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (true)
+    {
+        if (m_jobs.isEmpty())
+        {
+            if (m_exitRequest)
+            {
+                break;
+            }
+            m_jobCondition.wait(&m_mutex);
+            continue;
+        }
+
+        if (!m_exitRequest && !m_flushRequest && !m_writeDeadline.hasExpired())
+        {   // waiting for repeated versions
+            m_jobCondition.wait(&m_mutex, m_writeDeadline);
+            continue;
+        }
+
+        QStringList order;
+        QHash<QString, Job> jobs;
+        order.swap(m_jobOrder);
+        jobs.swap(m_jobs);
+        m_isWriting = true;
+
+        // files are written without lock, new versions are collected meanwhile
+        locker.unlock();
+        for (const QString & fileName : std::as_const(order))
+        {
+            writeFile(fileName, jobs.value(fileName));
+        }
+        locker.relock();
+
+        m_isWriting = false;
+        m_doneCondition.wakeAll();
+    }
+}
+
+void EPGFileWriter::writeFile(const QString &fileName, const Job &job)
+{
+    QByteArray hash = QCryptographicHash::hash(job.data, QCryptographicHash::Md5);
+    QFileInfo fileInfo(fileName);
+    if (fileInfo.exists())
+    {
+        auto it = m_fileHash.constFind(fileName);
+        if (it == m_fileHash.cend())
+        {   // file from previous run
+            QFile file(fileName);
+            if (file.open(QIODevice::ReadOnly))
+            {
+                it = m_fileHash.insert(fileName, QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5));
+                file.close();
+            }
+        }
+
+        if ((it != m_fileHash.cend()) && (*it == hash)
+            && (job.notOlderThanFileName.isEmpty() || !QFileInfo::exists(job.notOlderThanFileName)
+                || (fileInfo.lastModified() >= QFileInfo(job.notOlderThanFileName).lastModified())))
+        {   // do nothing, file is the same
+            qCDebug(metadataManager) << fileName << "is the same";
+            return;
+        }
+        else
+        {   /* different file => overwrite */ }
+    }
+
+    QDir dir;
+    dir.mkpath(fileInfo.absolutePath());
+
+    // file is replaced in one step, reader never sees incomplete file
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || (file.write(job.data) != job.data.size()) || !file.commit())
+    {
+        qCWarning(metadataManager) << "Unable to write EPG file" << fileName;
+        m_fileHash.remove(fileName);
+        return;
+    }
+    m_fileHash[fileName] = hash;
+}
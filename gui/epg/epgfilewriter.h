@@ -0,0 +1,81 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EPGFILEWRITER_H
+#define EPGFILEWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QStringList>
+
+#define EPGFILEWRITER_DELAY_MS     (2000)   // versions of the same file received within this time are written once
+
+// EPG cache files (XML and binary cache) are written in writer thread
+// pending version of the file is replaced by newer one, file is written atomically and only when content changed
+class EPGFileWriter : public QThread
+{
+    Q_OBJECT
+public:
+    explicit EPGFileWriter(QObject *parent = nullptr);
+    ~EPGFileWriter();      // writes pending files
+
+    // file is also rewritten when it is older than notOlderThanFileName (binary cache must not be older than XML)
+    void write(const QString & fileName, const QByteArray & data, const QString & notOlderThanFileName = QString());
+
+    // waits until all pending files are written
+    void flush();
+
+protected:
+    void run() override;
+
+private:
+    struct Job
+    {
+        QByteArray data;
+        QString notOlderThanFileName;
+    };
+
+    // shared
+    QMutex m_mutex;
+    QWaitCondition m_jobCondition;
+    QWaitCondition m_doneCondition;
+    QStringList m_jobOrder;                 // files are written in order of first request
+    QHash<QString, Job> m_jobs;
+    QDeadlineTimer m_writeDeadline;
+    bool m_isWriting = false;
+    bool m_flushRequest = false;
+    bool m_exitRequest = false;
+
+    // writer thread
+    QHash<QString, QByteArray> m_fileHash;  // MD5 of file content on disk
+
+    void writeFile(const QString & fileName, const Job & job);
+};
+
+#endif // EPGFILEWRITER_H
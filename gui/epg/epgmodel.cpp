@@ -24,6 +24,7 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
 #include <QLoggingCategory>
 #include "epgmodel.h"
 #include "epgtime.h"
@@ -158,28 +159,210 @@ void EPGModel::setServiceId(const ServiceListId &newServiceId)
 
 bool EPGModel::addItem(EPGModelItem *item)
 {
-    if (item->isValid())
+    return addItems(QList<EPGModelItem *>{item});
+}
+
+bool EPGModel::addItems(const QList<EPGModelItem *> &itemList)
+{
+    QList<EPGModelItem *> items;
+    items.reserve(itemList.size());
+    for (auto & item : itemList)
     {
-        if (m_startTimeList.contains(item->startTime()))
-        {   // already in list
-            if (item->shortId() != m_startTimeList[item->startTime()]) {
-                qCDebug(metadataManager) << "Unexpected EPG item ID" << item->shortId() << "start time:" << item->startTime();
+        if (item->isValid())
+        {
+            item->internStrings(m_strings);
+            items.append(item);
+        }
+        else
+        {
+            qCDebug(metadataManager) << "Invalid item:" << item->shortId();
+            delete item;
+        }
+    }
+    std::stable_sort(items.begin(), items.end(), [](const EPGModelItem * a, const EPGModelItem * b) {
+        return a->startTimeSecSinceEpoch() < b->startTimeSecSinceEpoch();
+    });
+
+    // new items following each other in the same gap of the list are inserted together
+    bool ret = false;
+    int runRow = -1;
+    QList<EPGModelItem *> run;
+    auto insertRun = [this, &run, &runRow, &ret]() {
+        if (!run.isEmpty())
+        {
+            beginInsertRows(QModelIndex(), runRow, runRow + run.size() - 1);
+            for (int n = 0; n < run.size(); ++n)
+            {
+                m_itemList.insert(runRow + n, run.at(n));
             }
+            endInsertRows();
+            run.clear();
+            ret = true;
+        }
+    };
+
+    for (auto & item : items)
+    {
+        if (!run.isEmpty() && (run.last()->startTimeSecSinceEpoch() == item->startTimeSecSinceEpoch()))
+        {   // duplicate start time in received data
             delete item;
-            return false;
+            continue;
         }
 
-        // we are here if item was not in list
-        beginInsertRows(QModelIndex(), m_itemList.size(), m_itemList.size());
-        m_startTimeList[item->startTime()] = item->shortId();
-        m_itemList.append(item);
-        endInsertRows();
+        int row = lowerBound(item->startTimeSecSinceEpoch());
+        bool isNew = (row >= m_itemList.size()) || (m_itemList.at(row)->startTimeSecSinceEpoch() != item->startTimeSecSinceEpoch());
+        bool isConflicting = (row < m_itemList.size()) && (m_itemList.at(row)->startTimeSecSinceEpoch() < item->endTimeSecSinceEpoch());
+        if (isNew && !isConflicting && (run.isEmpty() || (runRow == row)))
+        {
+            runRow = row;
+            run.append(item);
+        }
+        else
+        {
+            insertRun();
+            ret = updateItem(item) || ret;
+        }
+    }
+    insertRun();
+
+    if (ret)
+    {
+        updateMemory();
+    }
 
-        return true;
+    return ret;
+}
+
+bool EPGModel::removeItemsBefore(qint64 secSinceEpoch)
+{
+    int numRows = 0;
+    while ((numRows < m_itemList.size()) && (m_itemList.at(numRows)->endTimeSecSinceEpoch() <= secSinceEpoch))
+    {
+        ++numRows;
+    }
+    if (0 == numRows)
+    {
+        return false;
+    }
+
+    beginRemoveRows(QModelIndex(), 0, numRows - 1);
+    for (int n = 0; n < numRows; ++n)
+    {
+        delete m_itemList.at(n);
+    }
+    m_itemList.remove(0, numRows);
+    endRemoveRows();
+
+    // strings used only by removed items are released
+    m_strings.clear();
+    for (auto & item : m_itemList)
+    {
+        item->internStrings(m_strings);
+    }
+    updateMemory();
+
+    return true;
+}
+
+void EPGModel::updateMemory()
+{
+    qint64 memorySize = 0;
+    for (const auto & item : std::as_const(m_itemList))
+    {
+        memorySize += item->memorySize();
+    }
+    for (const auto & str : std::as_const(m_strings))
+    {
+        memorySize += sizeof(QString) + sizeof(QChar) * str.size();
+    }
+    m_memory.set(memorySize);
+}
+
+const EPGModelItem *EPGModel::itemAt(qint64 secSinceEpoch) const
+{
+    // last programme starting before or at given time
+    int row = lowerBound(secSinceEpoch + 1) - 1;
+    if ((row >= 0) && (m_itemList.at(row)->endTimeSecSinceEpoch() > secSinceEpoch))
+    {
+        return m_itemList.at(row);
+    }
+    return nullptr;
+}
+
+const EPGModelItem *EPGModel::nextItem(qint64 secSinceEpoch) const
+{
+    int row = lowerBound(secSinceEpoch + 1);
+    if (row < m_itemList.size())
+    {
+        return m_itemList.at(row);
+    }
+    return nullptr;
+}
+
+void EPGModel::dateRows(const QDate &date, int &firstRow, int &lastRow) const
+{
+    auto first = std::lower_bound(m_itemList.cbegin(), m_itemList.cend(), date,
+                                  [](const EPGModelItem * item, const QDate & d) { return item->startTime().date() < d; });
+    auto last = std::upper_bound(first, m_itemList.cend(), date,
+                                 [](const QDate & d, const EPGModelItem * item) { return d < item->startTime().date(); });
+    firstRow = first - m_itemList.cbegin();
+    lastRow = last - m_itemList.cbegin();
+}
+
+int EPGModel::lowerBound(qint64 startTimeSecSinceEpoch) const
+{
+    auto it = std::lower_bound(m_itemList.cbegin(), m_itemList.cend(), startTimeSecSinceEpoch,
+                               [](const EPGModelItem * item, qint64 t) { return item->startTimeSecSinceEpoch() < t; });
+    return it - m_itemList.cbegin();
+}
+
+bool EPGModel::updateItem(EPGModelItem *item)
+{
+    int row = lowerBound(item->startTimeSecSinceEpoch());
+    bool isNew = (row >= m_itemList.size()) || (m_itemList.at(row)->startTimeSecSinceEpoch() != item->startTimeSecSinceEpoch());
+    if (!isNew && (*m_itemList.at(row) == *item))
+    {   // already in list
+        delete item;
+        return false;
     }
     else
+    { /* new or changed programme */ }
+
+    // programmes starting during new or changed programme were rescheduled => remove them
+    int firstRow = isNew ? row : row + 1;
+    int lastRow = firstRow;
+    while ((lastRow < m_itemList.size()) && (m_itemList.at(lastRow)->startTimeSecSinceEpoch() < item->endTimeSecSinceEpoch()))
     {
-        qCDebug(metadataManager) << "Invalid item:" << item->shortId();
+        ++lastRow;
     }
-    return false;
+    if (lastRow > firstRow)
+    {
+        beginRemoveRows(QModelIndex(), firstRow, lastRow - 1);
+        for (int n = firstRow; n < lastRow; ++n)
+        {
+            delete m_itemList.at(n);
+        }
+        m_itemList.remove(firstRow, lastRow - firstRow);
+        endRemoveRows();
+    }
+    else
+    { /* no conflict */ }
+
+    if (isNew)
+    {
+        beginInsertRows(QModelIndex(), row, row);
+        m_itemList.insert(row, item);
+        endInsertRows();
+    }
+    else
+    {   // same start time => programme was updated
+        if (item->shortId() != m_itemList.at(row)->shortId()) {
+            qCDebug(metadataManager) << "Unexpected EPG item ID" << item->shortId() << "start time:" << item->startTime();
+        }
+        delete m_itemList.at(row);
+        m_itemList[row] = item;
+        emit dataChanged(index(row), index(row));
+    }
+
+    return true;
 }
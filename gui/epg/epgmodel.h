@@ -35,6 +35,7 @@
 #include <qqml.h>
 #endif
 #include "epgmodelitem.h"
+#include "diagnostics.h"
 
 enum EPGModelRoles {
     ShortIdRole = Qt::UserRole,
@@ -66,14 +67,32 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     int rowCount(const QModelIndex &parent = QModelIndex()) const { return m_itemList.count(); }
     QHash<int, QByteArray> roleNames() const;
+    // items are kept sorted by start time, model takes ownership of items
+    // returns true if model was changed
     bool addItem(EPGModelItem *item);
+    bool addItems(const QList<EPGModelItem *> &itemList);
+
+    // removes programmes that ended before given time, returns true if model was changed
+    bool removeItemsBefore(qint64 secSinceEpoch);
+
+    // programme running at given time and programme following it, nullptr if not available
+    const EPGModelItem * itemAt(qint64 secSinceEpoch) const;
+    const EPGModelItem * nextItem(qint64 secSinceEpoch) const;
+
+    // rows of programmes starting at given date [firstRow, lastRow), items are sorted so the range is contiguous
+    void dateRows(const QDate & date, int & firstRow, int & lastRow) const;
     ServiceListId serviceId() const;
     void setServiceId(const ServiceListId &newServiceId);
 
 private:
-    QHash<QDateTime, int> m_startTimeList;
     QList<EPGModelItem *> m_itemList;
+    QSet<QString> m_strings;        // names and descriptions repeat every day, items share one copy
     ServiceListId m_serviceId;
+    DiagnosticsMemoryCounter m_memory { DiagnosticsMemory::EpgModel };
+
+    int lowerBound(qint64 startTimeSecSinceEpoch) const;
+    bool updateItem(EPGModelItem *item);
+    void updateMemory();
 };
 
 #endif // EPGMODEL_H
@@ -25,9 +25,26 @@
  */
 
 #include "epgmodelitem.h"
+#include "epgcache.h"
 
 EPGModelItem::EPGModelItem() {}
 
+qint64 EPGModelItem::memorySize() const
+{
+    return sizeof(EPGModelItem);
+}
+
+void EPGModelItem::internStrings(QSet<QString> &pool)
+{
+    for (QString * str : { &m_longName, &m_mediumName, &m_shortName, &m_longDescription, &m_longDescriptionFile, &m_shortDescription })
+    {
+        if (!str->isEmpty())
+        {
+            *str = *pool.insert(*str);
+        }
+    }
+}
+
 QString EPGModelItem::longName() const
 {
     return m_longName;
@@ -104,12 +121,23 @@ void EPGModelItem::setDurationSec(int newDurationSec)
 
 QString EPGModelItem::longDescription() const
 {
+    if (!m_longDescriptionFile.isEmpty())
+    {   // not kept in memory
+        return EPGCache::readLongDescription(m_longDescriptionFile, m_startTimeSecSinceEpoch);
+    }
     return m_longDescription;
 }
 
 void EPGModelItem::setLongDescription(const QString &newLongDescription)
 {
     m_longDescription = newLongDescription;
+    m_longDescriptionFile.clear();
+}
+
+void EPGModelItem::setLongDescriptionFile(const QString &cacheFileName)
+{
+    m_longDescription.clear();
+    m_longDescriptionFile = cacheFileName;
 }
 
 QString EPGModelItem::shortDescription() const
@@ -150,3 +178,15 @@ qint64 EPGModelItem::endTimeSecSinceEpoch() const
 {
     return m_startTimeSecSinceEpoch + m_durationSec;
 }
+
+bool EPGModelItem::operator==(const EPGModelItem &other) const
+{
+    return (m_startTimeSecSinceEpoch == other.m_startTimeSecSinceEpoch)
+           && (m_durationSec == other.m_durationSec)
+           && (m_shortId == other.m_shortId)
+           && (m_longName == other.m_longName)
+           && (m_mediumName == other.m_mediumName)
+           && (m_shortName == other.m_shortName)
+           && (longDescription() == other.longDescription())
+           && (m_shortDescription == other.m_shortDescription);
+}
@@ -29,6 +29,7 @@
 
 #include <QString>
 #include <QDateTime>
+#include <QSet>
 
 class EPGModelItem
 {
@@ -36,6 +37,12 @@ public:
     EPGModelItem();
     //~EPGModelItem() { }
 
+    // estimated object size [bytes], strings are shared in model and counted there
+    qint64 memorySize() const;
+
+    // strings are replaced by equal strings from pool so that repeated names use one copy
+    void internStrings(QSet<QString> & pool);
+
     QString longName() const;
     void setLongName(const QString &newLongName);
 
@@ -51,8 +58,10 @@ public:
     int durationSec() const;
     void setDurationSec(int newDurationSec);
 
+    // long description can be stored in binary EPG cache only, then it is read when requested
     QString longDescription() const;
     void setLongDescription(const QString &newLongDescription);
+    void setLongDescriptionFile(const QString &cacheFileName);
 
     QString shortDescription() const;
     void setShortDescription(const QString &newShortDescription);
@@ -67,6 +76,8 @@ public:
     int shortId() const;
     void setShortId(int newShortId);
 
+    bool operator==(const EPGModelItem & other) const;
+
 private:
     QString m_longName;
     QString m_mediumName;
@@ -75,6 +86,7 @@ private:
     qint64 m_startTimeSecSinceEpoch;
     int m_durationSec;
     QString m_longDescription;
+    QString m_longDescriptionFile;      // binary cache, empty if description is in memory
     QString m_shortDescription;
     int m_shortId;
 };
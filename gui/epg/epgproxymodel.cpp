@@ -35,8 +35,50 @@ EPGProxyModel::EPGProxyModel(QObject *parent)
 bool EPGProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
     QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
-    QDate date = sourceModel()->data(index, EPGModelRoles::StartTimeRole).value<QDateTime>().date();
-    return date == m_dateFilter;
+    const EPGModel * epgModel = qobject_cast<const EPGModel *>(sourceModel());
+    if (nullptr != epgModel)
+    {   // programmes of one day are contiguous rows
+        if (!m_dateRowsValid)
+        {
+            epgModel->dateRows(m_dateFilter, m_firstRow, m_lastRow);
+            m_dateRowsValid = true;
+        }
+        if ((sourceRow < m_firstRow) || (sourceRow >= m_lastRow))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        QDate date = sourceModel()->data(index, EPGModelRoles::StartTimeRole).value<QDateTime>().date();
+        if (date != m_dateFilter)
+        {
+            return false;
+        }
+    }
+
+    return (sourceModel()->data(index, EPGModelRoles::EndTimeSecRole).toInt() > m_windowStartSec)
+           && (sourceModel()->data(index, EPGModelRoles::StartTimeSecRole).toInt() < m_windowEndSec);
+}
+
+void EPGProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    for (const auto & connection : std::as_const(m_sourceConnections))
+    {
+        disconnect(connection);
+    }
+    m_sourceConnections.clear();
+    invalidateDateRows();
+
+    // rows are shifted before proxy filters inserted rows or removes rows
+    if (nullptr != sourceModel)
+    {
+        m_sourceConnections << connect(sourceModel, &QAbstractItemModel::rowsAboutToBeInserted, this, &EPGProxyModel::invalidateDateRows)
+                            << connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &EPGProxyModel::invalidateDateRows)
+                            << connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, &EPGProxyModel::invalidateDateRows)
+                            << connect(sourceModel, &QAbstractItemModel::layoutAboutToBeChanged, this, &EPGProxyModel::invalidateDateRows);
+    }
+    QSortFilterProxyModel::setSourceModel(sourceModel);
 }
 
 QDate EPGProxyModel::dateFilter() const
@@ -49,6 +91,35 @@ void EPGProxyModel::setDateFilter(const QDate &newDateFilter)
     if (m_dateFilter == newDateFilter)
         return;
     m_dateFilter = newDateFilter;
+    invalidateDateRows();
     invalidateFilter();
     emit dateFilterChanged();
 }
+
+int EPGProxyModel::windowStartSec() const
+{
+    return m_windowStartSec;
+}
+
+void EPGProxyModel::setWindowStartSec(int newWindowStartSec)
+{
+    if (m_windowStartSec == newWindowStartSec)
+        return;
+    m_windowStartSec = newWindowStartSec;
+    invalidateFilter();
+    emit windowChanged();
+}
+
+int EPGProxyModel::windowEndSec() const
+{
+    return m_windowEndSec;
+}
+
+void EPGProxyModel::setWindowEndSec(int newWindowEndSec)
+{
+    if (m_windowEndSec == newWindowEndSec)
+        return;
+    m_windowEndSec = newWindowEndSec;
+    invalidateFilter();
+    emit windowChanged();
+}
@@ -36,19 +36,38 @@ class EPGProxyModel : public QSortFilterProxyModel
     Q_OBJECT
     QML_ELEMENT
     Q_PROPERTY(QDate dateFilter READ dateFilter WRITE setDateFilter NOTIFY dateFilterChanged FINAL)
+    Q_PROPERTY(int windowStartSec READ windowStartSec WRITE setWindowStartSec NOTIFY windowChanged FINAL)
+    Q_PROPERTY(int windowEndSec READ windowEndSec WRITE setWindowEndSec NOTIFY windowChanged FINAL)
 public:
     explicit EPGProxyModel(QObject *parent = nullptr);
 
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
 
     QDate dateFilter() const;
     void setDateFilter(const QDate &newDateFilter);
 
+    // only programmes intersecting time window are accepted [seconds since midnight]
+    int windowStartSec() const;
+    void setWindowStartSec(int newWindowStartSec);
+    int windowEndSec() const;
+    void setWindowEndSec(int newWindowEndSec);
+
 signals:
     void dateFilterChanged();
+    void windowChanged();
 
 private:
     QDate m_dateFilter;
+    int m_windowStartSec = 0;
+    int m_windowEndSec = 24*3600;
+
+    // source rows of date filter, found in EPGModel when needed and invalidated when source rows change
+    mutable bool m_dateRowsValid = false;
+    mutable int m_firstRow = 0;
+    mutable int m_lastRow = 0;
+    QList<QMetaObject::Connection> m_sourceConnections;
+    void invalidateDateRows() { m_dateRowsValid = false; }
 };
 
 #endif // EPGPROXYMODEL_H
@@ -25,6 +25,7 @@
  */
 
 #include "epgtime.h"
+#include "coarseclock.h"
 
 EPGTime* EPGTime ::m_instancePtr = nullptr;
 
@@ -43,16 +44,13 @@ EPGTime *EPGTime::getInstance()
 
 EPGTime::EPGTime() : QObject(nullptr)
 {
-    m_minuteTimer = new QTimer();
-    m_minuteTimer->setInterval(1000*60); // 1 minute
     m_isLiveBroadcasting = true;
     m_secSinceEpoch = 0;
 }
 
 EPGTime::~EPGTime()
 {
-    m_minuteTimer->stop();
-    delete m_minuteTimer;
+    CoarseClock::getInstance()->stop(this);
 }
 
 void EPGTime::setTime(const QDateTime & time)
@@ -95,8 +93,9 @@ void EPGTime::setTime(const QDateTime & time)
 void EPGTime::onTimerTimeout()
 {
     if (m_currentTime.isValid())
-    {
-        setTime(m_currentTime.addSecs(60));
+    {   // no DAB time for 1 minute, extrapolated from last one
+        QDateTime t = CoarseClock::getInstance()->dabTime();
+        setTime(t.isValid() ? t : m_currentTime.addSecs(60));
     }
 }
 
@@ -126,7 +125,7 @@ void EPGTime::onDabTime(const QDateTime &d)
 {
     setTime(d);
     //setTime(QDateTime::currentDateTime());
-    m_minuteTimer->start();
+    CoarseClock::getInstance()->start(this, 1000*60, [this]() { onTimerTimeout(); });  // 1 minute
 }
 
 qint64 EPGTime::secSinceEpoch() const
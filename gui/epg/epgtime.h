@@ -29,7 +29,6 @@
 
 #include <QObject>
 #include <QDateTime>
-#include <QTimer>
 #include <QTimeZone>
 
 // singleton class
@@ -85,7 +84,6 @@ private:
     static EPGTime * m_instancePtr;
     QDateTime m_currentTime;
     int m_ltoSec;
-    QTimer * m_minuteTimer;
     qint64 m_secSinceEpoch;
     bool m_isLiveBroadcasting;
     QString m_currentDateString;
@@ -27,21 +27,33 @@
 #include <QDir>
 #include <QDebug>
 #include <QLoggingCategory>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include "airspyinput.h"
+#include "inputdevicekernels.h"
+#include "threadpriority.h"
 
 Q_LOGGING_CATEGORY(airspyInput, "AirspyInput", QtInfoMsg)
 
-AirspyInput::AirspyInput(bool try4096kHz, QObject *parent) : InputDevice(parent)
+AirspyInput::AirspyInput(bool try4096kHz, bool wideband, QObject *parent) : InputDevice(parent)
 {
     m_deviceDescription.id = InputDeviceId::AIRSPY;
 
-    m_try4096kHz = try4096kHz;
+    m_try4096kHz = try4096kHz && !wideband;
+    m_wideband = wideband;
     m_device = nullptr;
     m_isRecording = false;
+    m_recordFifo = nullptr;
+    m_recordThread = nullptr;
     m_signalLevelEmitCntr = 0;
     m_src = nullptr;
-    m_filterOutBuffer = nullptr;
+    m_sampleTypeS16 = false;
+    m_sampleTypeReal = false;
     m_frequency = 0;
+    m_loFrequency = 0;
+    m_centerFrequency = 0;
+    m_sampleRate = 0;
     m_biasT = false;
 
     connect(this, &AirspyInput::agcLevel, this, &AirspyInput::onAgcLevel, Qt::QueuedConnection);
@@ -57,10 +69,18 @@ AirspyInput::~AirspyInput()
         airspy_exit();
     }
 
-    if (nullptr != m_filterOutBuffer)
+    // channels are normally deleted before the device, remaining ones produce no samples
+    m_channelMutex.lock();
+    for (auto channel : std::as_const(m_channels))
     {
-        operator delete [] (m_filterOutBuffer, std::align_val_t(16));
+        channel->m_source = nullptr;
     }
+    m_channels.clear();
+    m_channelMutex.unlock();
+
+    stopRecordThread();
+    delete [] m_recordFifo;
+
     if (nullptr != m_src)
     {
         delete m_src;
@@ -69,7 +89,22 @@ AirspyInput::~AirspyInput()
 
 void AirspyInput::tune(uint32_t frequency)
 {
+    // AGC on new frequency starts from gain remembered for it
+    if (0 == m_receiver)
+    {
+        TunerStateCache::getInstance()->updateGain(((AirpyGainMode::Software == m_gainMode) || (AirpyGainMode::Hybrid == m_gainMode)) ? m_gainIdx : -1);
+        m_tunerState = TunerStateCache::getInstance()->tune(m_deviceDescription, frequency);
+    }
+    else
+    {   // cache follows primary receiver only
+        m_tunerState = TunerState();
+    }
     m_frequency = frequency;
+    if (tuneDigital(frequency))
+    {   // neighbouring channel selected without stopping RX
+        emit tuned(m_frequency);
+        return;
+    }
     if (airspy_is_streaming(m_device) || (0 == frequency))
     {   // airspy is running
         //      sequence in this case is:
@@ -85,10 +120,85 @@ void AirspyInput::tune(uint32_t frequency)
     }
 }
 
+bool AirspyInput::tuneDigital(uint32_t frequency)
+{
+    if (!m_wideband || (0 == frequency) || (0 == m_loFrequency) || (AIRSPY_TRUE != airspy_is_streaming(m_device)))
+    {
+        return false;
+    }
+
+    if (!isInCapturedBand(frequency, m_loFrequency))
+    {   // channel is out of captured band
+        return false;
+    }
+
+    qCInfo(airspyInput, "Wideband capture: %d kHz selected digitally, LO %d kHz", frequency, m_loFrequency);
+
+    // SRC picks it up with next transfer, samples from previous channel in the FIFO are dropped by DAB sync
+    m_src->setFrequencyOffset((int64_t(frequency) - int64_t(m_loFrequency)) * 1000);
+    resetAgc();
+    return true;
+}
+
+bool AirspyInput::isInCapturedBand(uint32_t frequency, uint32_t loFrequency) const
+{
+    int64_t offset = (int64_t(frequency) - int64_t(loFrequency)) * 1000;
+    return (std::abs(offset) + INPUTDEVICE_BANDWIDTH/2 <= AIRSPY_WIDEBAND_USABLE_BW * m_sampleRate / 2);
+}
+
+AirspyChannelInput *AirspyInput::addChannel()
+{
+    if (!m_wideband || (nullptr == m_device) || m_sampleTypeS16 || m_sampleTypeReal)
+    {   // channels are mixed from float IQ samples of wideband capture
+        qCWarning(airspyInput) << "Channelizer is available only with wideband capture";
+        return nullptr;
+    }
+
+    AirspyChannelInput * channel = new AirspyChannelInput(this, m_sampleRate);
+    QMutexLocker locker(&m_channelMutex);
+    m_channels.append(channel);
+    return channel;
+}
+
+void AirspyInput::removeChannel(AirspyChannelInput *channel)
+{
+    QMutexLocker locker(&m_channelMutex);
+    m_channels.removeOne(channel);
+}
+
+void AirspyInput::tuneChannel(AirspyChannelInput *channel, uint32_t frequency)
+{
+    QMutexLocker locker(&m_channelMutex);
+    channel->m_frequency = frequency;
+    applyChannelFrequency(channel);
+}
+
+void AirspyInput::applyChannelFrequency(AirspyChannelInput *channel)
+{   // channel mutex is locked by caller
+    channel->m_isActive = false;
+    if ((0 == channel->m_frequency) || (0 == m_loFrequency))
+    {   // channel is idle or device is not streaming, frequency is applied by run()
+        return;
+    }
+    if (!isInCapturedBand(channel->m_frequency, m_loFrequency))
+    {
+        qCWarning(airspyInput, "Wideband capture: channel %d kHz is out of captured band, LO %d kHz", channel->m_frequency, m_loFrequency);
+        return;
+    }
+
+    qCInfo(airspyInput, "Wideband capture: channel %d kHz for receiver %d, LO %d kHz", channel->m_frequency, channel->receiver(), m_loFrequency);
+
+    channel->m_src->reset();
+    channel->m_src->setFrequencyOffset((int64_t(channel->m_frequency) - int64_t(m_loFrequency)) * 1000);
+    channel->m_inputBuffer->startGeneration();    // samples of previous channel are dropped by consumer
+    channel->m_isActive = true;
+}
+
 bool AirspyInput::openDevice()
 {
-    // open first device
-    if (AIRSPY_SUCCESS != airspy_open(&m_device))
+    // open first device or device with requested serial number (reconnection)
+    int ret = m_serial.isEmpty() ? airspy_open(&m_device) : airspy_open_sn(&m_device, m_serial.toULongLong(nullptr, 16));
+    if (AIRSPY_SUCCESS != ret)
     {
         qCCritical(airspyInput) << "Failed opening device";
         m_device = nullptr;
@@ -114,16 +224,29 @@ bool AirspyInput::openDevice()
         qCInfo(airspyInput) << "Sample rate set to" << sampleRate << "Hz";
     }
     else
-    {   // find lowest supported sample rated that is >= 2048kHz
+    {   // find supported sample rate with the cheapest SRC (highest in wideband mode)
         uint32_t samplerateCount;
         airspy_get_samplerates(m_device, &samplerateCount, 0);
         uint32_t * samplerateArray = new uint32_t[samplerateCount];
         airspy_get_samplerates(m_device, samplerateArray, samplerateCount);
-        for (int s = 0; s < samplerateCount; ++s)
+        if (m_wideband)
         {
-            if ((samplerateArray[s] >= (2048*1000)) && (samplerateArray[s] < sampleRate))
+            sampleRate = 0;
+            for (int s = 0; s < samplerateCount; ++s)
+            {
+                if (samplerateArray[s] > sampleRate)
+                {
+                    sampleRate = samplerateArray[s];
+                }
+            }
+        }
+        else
+        {   // passthrough, halfband cascade or the lowest rate >= 2048kHz
+            std::vector<double> rates(samplerateArray, samplerateArray + samplerateCount);
+            double rate = InputDeviceSRC::preferredSampleRate(rates);
+            if (rate > 0.0)
             {
-                sampleRate = samplerateArray[s];
+                sampleRate = uint32_t(rate);
             }
         }
         delete [] samplerateArray;
@@ -140,10 +263,41 @@ bool AirspyInput::openDevice()
         }
     }
 
-    // airspy provides 49152 samples in callback in packed modes
-    // we cannot produce more samples in SRC => allocating for worst case
-    m_filterOutBuffer = new ( std::align_val_t(16) ) float[49152*2];
-    m_src = new InputDeviceSRC(sampleRate);
+    m_sampleRate = sampleRate;
+
+#if AIRSPY_SRC_REAL
+    // frequency shift and decimation of raw real samples in one pass is cheaper
+    // than libairspy IQ converter followed by halfband filter (4096kHz only)
+    if (4096*1000 == sampleRate)
+    {
+        m_src = new InputDeviceSRC(2*sampleRate, true);
+        m_sampleTypeReal = m_src->hasS16RealInput();
+        if (m_sampleTypeReal && (AIRSPY_SUCCESS != airspy_set_sample_type(m_device, AIRSPY_SAMPLE_INT16_REAL)))
+        {
+            qCWarning(airspyInput) << "Cannot set int16 real sample format, using IQ";
+            m_sampleTypeReal = false;
+        }
+        if (!m_sampleTypeReal)
+        {
+            delete m_src;
+            m_src = nullptr;
+        }
+    }
+    if (nullptr == m_src)
+#endif
+    {
+        m_src = new InputDeviceSRC(sampleRate);
+    }
+
+#if AIRSPY_SRC_INT16
+    // fixed point SRC is faster if available (4096kHz)
+    m_sampleTypeS16 = !m_sampleTypeReal && m_src->hasS16Input();
+    if (m_sampleTypeS16 && (AIRSPY_SUCCESS != airspy_set_sample_type(m_device, AIRSPY_SAMPLE_INT16_IQ)))
+    {
+        qCWarning(airspyInput) << "Cannot set int16 sample format, using float";
+        m_sampleTypeS16 = false;
+    }
+#endif
 
     // set automatic gain
     m_gainMode = AirpyGainMode::Software;
@@ -151,6 +305,13 @@ bool AirspyInput::openDevice()
 
     m_deviceDescription.device.name = "AirSpy";
 
+    airspy_read_partid_serialno_t partIdSerial;
+    if (AIRSPY_SUCCESS == airspy_board_partid_serialno_read(m_device, &partIdSerial))
+    {
+        uint64_t serial = (uint64_t(partIdSerial.serial_no[2]) << 32) | partIdSerial.serial_no[3];
+        m_deviceDescription.device.serial = QString("%1").arg(serial, 16, 16, QChar('0')).toUpper();
+    }
+
     char version[255];
     if (AIRSPY_SUCCESS == airspy_version_string_read(m_device, version, 255))
     {
@@ -172,7 +333,9 @@ bool AirspyInput::openDevice()
     {
         m_deviceDescription.device.model = "Unknown";
     }
+    // recording is taken from SRC output
     m_deviceDescription.sample.sampleRate = 2048000;
+    m_deviceDescription.sample.inputSampleRate = (2048000 != m_sampleRate) ? m_sampleRate : 0;
 #if AIRSPY_RECORD_INT16
     m_deviceDescription.sample.channelBits = sizeof(int16_t) * 8;
     m_deviceDescription.sample.containerBits = sizeof(int16_t) * 8;
@@ -183,6 +346,8 @@ bool AirspyInput::openDevice()
     m_deviceDescription.sample.channelContainer = "float";
 #endif
 
+    openFifo();
+
     emit deviceReady();
 
     return true;
@@ -191,18 +356,36 @@ bool AirspyInput::openDevice()
 void AirspyInput::run()
 {
     // Reset buffer here - airspy is not running, DAB waits for new data
-    inputBuffer.reset();
+    m_inputBuffer->reset();
 
     m_src->reset();
+    m_src->setFrequencyOffset(0);
+    m_loFrequency = 0;
 
     if (m_frequency != 0)
     {   // Tune to new frequency
-        if (AIRSPY_SUCCESS != airspy_set_freq(m_device, m_frequency*1000))
+        uint32_t loFrequency = m_frequency;
+        if (m_wideband && (0 != m_centerFrequency))
+        {   // LO shared by channels
+            if (isInCapturedBand(m_frequency, m_centerFrequency))
+            {
+                loFrequency = m_centerFrequency;
+                m_src->setFrequencyOffset((int64_t(m_frequency) - int64_t(loFrequency)) * 1000);
+            }
+            else
+            {
+                qCWarning(airspyInput, "Wideband capture: %d kHz is out of captured band, LO %d kHz is not used", m_frequency, m_centerFrequency);
+            }
+        }
+        else { /* LO follows tuned frequency */ }
+
+        if (AIRSPY_SUCCESS != airspy_set_freq(m_device, loFrequency*1000))
         {
-            qCCritical(airspyInput, "Tune to %d kHz failed", m_frequency);
+            qCCritical(airspyInput, "Tune to %d kHz failed", loFrequency);
             emit error(InputDeviceErrorCode::DeviceDisconnected);
             return;
         }
+        m_loFrequency = loFrequency;
 
         resetAgc();
 
@@ -218,6 +401,16 @@ void AirspyInput::run()
     else
     { /* tune to 0 => going to idle */  }
 
+    if (m_wideband)
+    {   // channels follow LO
+        QMutexLocker locker(&m_channelMutex);
+        for (auto channel : std::as_const(m_channels))
+        {
+            applyChannelFrequency(channel);
+        }
+    }
+    else { /* no channelizer */ }
+
     emit tuned(m_frequency);
 }
 
@@ -234,10 +427,7 @@ void AirspyInput::stop()
             qCWarning(airspyInput) << "not finished after timeout - this should not happen :-(";
 
             // reset buffer - and tell the thread it is empty - buffer will be reset in any case
-            pthread_mutex_lock(&inputBuffer.countMutex);
-            inputBuffer.count = 0;
-            pthread_cond_signal(&inputBuffer.countCondition);
-            pthread_mutex_unlock(&inputBuffer.countMutex);
+            m_inputBuffer->flush();
             QThread::msleep(2000);
         }
 
@@ -372,13 +562,13 @@ void AirspyInput::resetAgc()
     if (AirpyGainMode::Software == m_gainMode)
     {
         m_gainIdx = -1;
-        setGain((AIRSPY_SW_AGC_MAX+1)/2); // set it to the middle
+        setGain((m_tunerState.gainIdx >= 0) ? m_tunerState.gainIdx : (AIRSPY_SW_AGC_MAX+1)/2); // set it to the middle by default
         return;
     }
     if (AirpyGainMode::Hybrid == m_gainMode)
     {
         m_gainIdx = -1;
-        setGain(6);
+        setGain((m_tunerState.gainIdx >= 0) ? m_tunerState.gainIdx : 6);
     }
 }
 
@@ -400,14 +590,108 @@ void AirspyInput::onWatchdogTimeout()
     if (AIRSPY_TRUE != airspy_is_streaming(m_device))
     {
         qCCritical(airspyInput) << "watchdog timeout";
-        inputBuffer.fillDummy();
+        m_inputBuffer->fillDummy();
         emit error(InputDeviceErrorCode::NoDataAvailable);
     }
 }
 
+void AirspyInput::checkConnection()
+{   // streaming flag is cleared by libairspy on transfer error
+    if (m_watchdogTimer.isActive())
+    {
+        onWatchdogTimeout();
+    }
+}
+
 void AirspyInput::startStopRecording(bool start)
 {
-    m_isRecording = start;
+    if (start)
+    {
+        startRecordThread();
+        m_isRecording = true;
+    }
+    else
+    {   // remaining samples are written by recording thread before it finishes
+        m_isRecording = false;
+        stopRecordThread();
+    }
+}
+
+void AirspyInput::startRecordThread()
+{
+    if (nullptr != m_recordThread)
+    {   // already running
+        return;
+    }
+    if (nullptr == m_recordFifo)
+    {
+        m_recordFifo = new float[AIRSPY_RECORD_FIFO_SIZE];
+    }
+    m_recordHead = 0;
+    m_recordTail = 0;
+    m_recordDropped = 0;
+    m_recordThreadExit = false;
+    m_recordThread = new std::thread(&AirspyInput::recordThread, this);
+}
+
+void AirspyInput::stopRecordThread()
+{
+    if (nullptr != m_recordThread)
+    {
+        m_recordThreadExit = true;
+        m_recordThread->join();
+        delete m_recordThread;
+        m_recordThread = nullptr;
+    }
+    // FIFO is kept till destructor, callback may be still running
+}
+
+void AirspyInput::pushRecordBuffer(const float *buf, uint32_t len)
+{   // called from libairspy thread, no locking
+    uint32_t head = m_recordHead.load(std::memory_order_relaxed);
+    uint32_t tail = m_recordTail.load(std::memory_order_acquire);
+    if (AIRSPY_RECORD_FIFO_SIZE - (head - tail) < len)
+    {   // recording thread is too slow
+        m_recordDropped.fetch_add(len, std::memory_order_relaxed);
+        return;
+    }
+
+    uint32_t idx = head & (AIRSPY_RECORD_FIFO_SIZE - 1);
+    uint32_t firstPart = std::min(len, AIRSPY_RECORD_FIFO_SIZE - idx);
+    memcpy(m_recordFifo + idx, buf, firstPart * sizeof(float));
+    memcpy(m_recordFifo, buf + firstPart, (len - firstPart) * sizeof(float));
+    m_recordHead.store(head + len, std::memory_order_release);
+}
+
+void AirspyInput::recordThread()
+{
+    bool doExit = false;
+    while (!doExit)
+    {
+        // exit flag is read before FIFO so that all samples are written
+        doExit = m_recordThreadExit;
+        uint32_t tail = m_recordTail.load(std::memory_order_relaxed);
+        uint32_t head = m_recordHead.load(std::memory_order_acquire);
+        while (head != tail)
+        {   // contiguous part, even length is kept by producer (I and Q)
+            uint32_t idx = tail & (AIRSPY_RECORD_FIFO_SIZE - 1);
+            uint32_t len = std::min(head - tail, AIRSPY_RECORD_FIFO_SIZE - idx);
+            doRecordBuffer(m_recordFifo + idx, len);
+            tail += len;
+            m_recordTail.store(tail, std::memory_order_release);
+        }
+
+        uint32_t dropped = m_recordDropped.exchange(0);
+        if (dropped > 0)
+        {
+            qCWarning(airspyInput) << "Recording: dropping" << dropped/2 << "IQ samples...";
+        }
+
+        if (!doExit)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(AIRSPY_RECORD_PERIOD_MS));
+        }
+    }
 }
 
 void AirspyInput::setBiasT(bool ena)
@@ -435,15 +719,18 @@ void AirspyInput::setDataPacking(bool ena)
 }
 
 void AirspyInput::doRecordBuffer(const float *buf, uint32_t len)
-{
+{   // called from recording thread
 #if AIRSPY_RECORD_INT16
-    // dumping in int16
-    int16_t int16Buf[len];
-    for (int n = 0; n < len; ++n)
+    // dumping in int16, converted in blocks to keep stack usage low
+    int16_t int16Buf[4096];
+    while (len > 0)
     {
-        int16Buf[n] = *buf++ * AIRSPY_RECORD_FLOAT2INT16;
+        uint32_t blockLen = std::min(len, uint32_t(4096));
+        InputDeviceKernels::convertToS16(buf, int16Buf, blockLen, AIRSPY_RECORD_FLOAT2INT16);
+        buf += blockLen;
+        emit recordBuffer((const uint8_t *) int16Buf, blockLen * sizeof(int16_t));
+        len -= blockLen;
     }
-    emit recordBuffer((const uint8_t *) int16Buf, len * sizeof(int16_t));
 #else
     // dumping in float
     emit recordBuffer((const uint8_t *) buf, len * sizeof(float));
@@ -452,6 +739,7 @@ void AirspyInput::doRecordBuffer(const float *buf, uint32_t len)
 
 int AirspyInput::callback(airspy_transfer* transfer)
 {
+    ThreadPriority::update(ThreadClass::Input);     // libairspy thread
     static_cast<AirspyInput *>(transfer->ctx)->processInputData(transfer);
     return 0;
 }
@@ -463,23 +751,44 @@ void AirspyInput::processInputData(airspy_transfer *transfer)
         qCWarning(airspyInput) << "Dropping" << transfer->dropped_samples << "samples";
     }
 
+    if (m_wideband)
+    {   // channels first, float samples are mixed in place by SRC below
+        // every channel applies overflow policy of its own FIFO, full primary FIFO does not starve them
+        QMutexLocker locker(&m_channelMutex);
+        for (auto channel : std::as_const(m_channels))
+        {
+            channel->processInputData((const float *) transfer->samples, transfer->sample_count);
+        }
+    }
+    else { /* no channelizer */ }
+
     // len is number of I and Q samples
     // get FIFO space
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    uint64_t count = inputBuffer.count;
-    pthread_mutex_unlock(&inputBuffer.countMutex);
+    Q_ASSERT(m_inputBuffer->freeSpace() <= m_inputBuffer->size);
 
-    Q_ASSERT(count <= INPUT_FIFO_SIZE);
+    // SRC cannot produce more samples than it gets (sample rate is >= 2048kHz)
+    if (!m_inputBuffer->prepareWrite(transfer->sample_count * 2 * sizeof(float)))
+    {
+        qCWarning(airspyInput) << "Dropping" << transfer->sample_count << "IQ samples...";
+        return;
+    }
 
     // input samples are IQ = [float float] @ 4096kHz
     // going to transform them to [float float] @ 2048kHz
-    int numIQ = m_src->process((float*) transfer->samples, transfer->sample_count, m_filterOutBuffer);
-    uint64_t bytesToWrite = numIQ * 2 * sizeof(float);
-
-    if ((INPUT_FIFO_SIZE - count) < bytesToWrite)
+    // there is enough room in buffer, SRC writes directly to FIFO
+    float * outPtr = (float *) m_inputBuffer->reserve();
+    int numIQ;
+    if (m_sampleTypeReal)
+    {   // input samples are real [int16] @ 8192kHz
+        numIQ = m_src->processReal((const int16_t*) transfer->samples, transfer->sample_count, outPtr);
+    }
+    else if (m_sampleTypeS16)
+    {   // input samples are IQ = [int16 int16]
+        numIQ = m_src->process((const int16_t*) transfer->samples, transfer->sample_count, outPtr);
+    }
+    else
     {
-        qCWarning(airspyInput) << "Dropping" << transfer->sample_count << "IQ samples...";
-        return;
+        numIQ = m_src->process((float*) transfer->samples, transfer->sample_count, outPtr);
     }
 
 #if (AIRSPY_AGC_ENABLE > 0)
@@ -490,27 +799,74 @@ void AirspyInput::processInputData(airspy_transfer *transfer)
 #endif
 
     if (m_isRecording)
+    {   // converted and written in recording thread
+        pushRecordBuffer(outPtr, 2*numIQ);
+    }
+
+    m_inputBuffer->commitWrite(numIQ * 2 * sizeof(float));
+}
+
+AirspyChannelInput::AirspyChannelInput(AirspyInput *source, uint32_t sampleRate) : InputDevice(nullptr)
+{
+    m_source = source;
+    m_src = new InputDeviceSRC(sampleRate);
+    m_deviceDescription = source->deviceDescription();
+}
+
+AirspyChannelInput::~AirspyChannelInput()
+{
+    if (nullptr != m_source)
+    {   // no more samples from libairspy thread
+        m_source->removeChannel(this);
+    }
+    delete m_src;
+}
+
+bool AirspyChannelInput::openDevice()
+{
+    if (nullptr == m_source)
     {
-        doRecordBuffer(m_filterOutBuffer, 2*numIQ);
+        return false;
     }
 
-    // there is enough room in buffer
-    uint64_t bytesTillEnd = INPUT_FIFO_SIZE - inputBuffer.head;
+    m_deviceDescription.device.name = m_deviceDescription.device.name + " [channel]";
+    openFifo();
+    emit deviceReady();
+    return true;
+}
 
-    if (bytesTillEnd >= bytesToWrite)
+void AirspyChannelInput::tune(uint32_t frequency)
+{
+    if (nullptr == m_source)
+    {   // wideband device is gone
+        return;
+    }
+
+    // channel is selected digitally, device is not retuned
+    m_source->tuneChannel(this, frequency);
+    emit tuned(frequency);
+}
+
+void AirspyChannelInput::processInputData(const float *samples, uint32_t numIQ)
+{   // called from libairspy thread with channel mutex locked
+    if (!m_isActive)
     {
-        std::memcpy((inputBuffer.buffer + inputBuffer.head), (uint8_t *) m_filterOutBuffer, bytesToWrite);
-        inputBuffer.head = (inputBuffer.head + bytesToWrite);
+        return;
     }
-    else
+
+    if (!m_inputBuffer->prepareWrite(numIQ * 2 * sizeof(float)))
     {
-        std::memcpy((inputBuffer.buffer + inputBuffer.head), (uint8_t *) m_filterOutBuffer, bytesTillEnd);
-        std::memcpy((inputBuffer.buffer), ((uint8_t *) m_filterOutBuffer)+bytesTillEnd, bytesToWrite-bytesTillEnd);
-        inputBuffer.head = bytesToWrite-bytesTillEnd;
+        qCWarning(airspyInput) << "Receiver" << m_receiver << ": dropping" << numIQ << "IQ samples...";
+        return;
+    }
+
+    if (m_buffer.size() < 2 * numIQ)
+    {   // transfer size does not change, allocated only once
+        m_buffer.resize(2 * numIQ);
     }
+    memcpy(m_buffer.data(), samples, 2 * numIQ * sizeof(float));
 
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    inputBuffer.count = inputBuffer.count + bytesToWrite;
-    pthread_cond_signal(&inputBuffer.countCondition);
-    pthread_mutex_unlock(&inputBuffer.countMutex);
+    float * outPtr = (float *) m_inputBuffer->reserve();
+    int numOutIQ = m_src->process(m_buffer.data(), numIQ, outPtr);
+    m_inputBuffer->commitWrite(numOutIQ * 2 * sizeof(float));
 }
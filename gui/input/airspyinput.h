@@ -30,16 +30,33 @@
 #include <QObject>
 #include <QThread>
 #include <QTimer>
+#include <QMutex>
+#include <QList>
+#include <thread>
+#include <atomic>
+#include <vector>
 #include <libairspy/airspy.h>
 #include <libairspy/airspy_commands.h>
 #include "inputdevice.h"
+#include "tunerstatecache.h"
 #include "inputdevicesrc.h"
 
 #define AIRSPY_AGC_ENABLE  1     // enable AGC
 #define AIRSPY_RECORD_INT16  1   // record raw stream in int16 instead of float
+#define AIRSPY_SRC_INT16     1   // use int16 samples and fixed point SRC when supported (4096kHz)
+#define AIRSPY_SRC_REAL      1   // use raw int16 real samples and integrated DDC when supported (4096kHz)
 
 #define AIRSPY_RECORD_FLOAT2INT16  (16384*2)   // conversion constant to int16
 
+// recording is converted in separate thread, callback only copies SRC output to lock-free FIFO
+#define AIRSPY_RECORD_FIFO_SIZE    (1 << 20)   // floats (I and Q), power of 2, 256 ms @ 2048kHz
+#define AIRSPY_RECORD_PERIOD_MS    (20)        // FIFO polling period of recording thread
+
+// wideband capture: highest sample rate is used and channels close to LO frequency
+// are selected by digital frequency shift without retuning of device
+// channelizer: additional channels of the same capture are mixed and resampled to FIFOs of other receivers
+#define AIRSPY_WIDEBAND_USABLE_BW  (0.8)         // usable part of sample rate
+
 #define AIRSPY_SW_AGC_MIN      0
 #define AIRSPY_SW_AGC_MAX     17
 #define AIRSPY_HW_AGC_MIN      0
@@ -67,36 +84,97 @@ struct AirspyGainStr
     bool mixerAgcEna;
 };
 
+class AirspyInput;
+
+// one channel of Airspy wideband capture, it is used as input device of another receiver
+// samples are produced by libairspy thread of AirspyInput, recording is not supported
+class AirspyChannelInput : public InputDevice
+{
+    Q_OBJECT
+public:
+    ~AirspyChannelInput();
+    bool openDevice() override;
+    void tune(uint32_t frequency) override;
+    void startStopRecording(bool start) override { (void) start; }
+
+private:
+    friend class AirspyInput;
+    AirspyChannelInput(AirspyInput * source, uint32_t sampleRate);
+
+    // members are protected by channel mutex of source
+    AirspyInput * m_source;
+    InputDeviceSRC * m_src;
+    std::vector<float> m_buffer;          // copy of input samples, SRC mixes in place
+    uint32_t m_frequency = 0;
+    bool m_isActive = false;              // channel is inside of captured band
+
+    void processInputData(const float * samples, uint32_t numIQ);
+};
+
 class AirspyInput : public InputDevice
 {
     Q_OBJECT
 public:
-    explicit AirspyInput(bool try4096kHz, QObject *parent = nullptr);
+    explicit AirspyInput(bool try4096kHz, bool wideband = false, QObject *parent = nullptr);
     ~AirspyInput();
     bool openDevice() override;
     void tune(uint32_t frequency) override;
     void setGainMode(const AirspyGainStr & gain);
     void startStopRecording(bool start) override;
+    void checkConnection() override;
     void setBiasT(bool ena);
     void setDataPacking(bool ena);
+    void setSerial(const QString & serial) { m_serial = serial; }   // used by openDevice()
+
+    // wideband capture only
+    // LO frequency [kHz] shared by all channels, 0 means that LO follows tuned frequency
+    void setCenterFrequency(uint32_t frequency) { m_centerFrequency = frequency; }
+    // returns nullptr if channelizer is not available, channel is owned by caller
+    AirspyChannelInput * addChannel();
 signals:
     void agcLevel(float level);
 
 private:
+    friend class AirspyChannelInput;
+
     uint32_t m_frequency;
+    uint32_t m_loFrequency;               // kHz, device frequency in wideband mode
+    uint32_t m_centerFrequency;           // kHz, requested LO in wideband mode
+    uint32_t m_sampleRate;
+    bool m_wideband;
     bool m_biasT;
+    QString m_serial;
     struct airspy_device *m_device;
     QTimer m_watchdogTimer;
     AirpyGainMode m_gainMode = AirpyGainMode::Hybrid;
     int m_gainIdx;
+    TunerState m_tunerState;
     std::atomic<bool> m_isRecording;
+
+    // recording FIFO, head is owned by callback, tail by recording thread
+    float * m_recordFifo;
+    std::atomic<uint32_t> m_recordHead;
+    std::atomic<uint32_t> m_recordTail;
+    std::atomic<uint32_t> m_recordDropped;
+    std::atomic<bool> m_recordThreadExit;
+    std::thread * m_recordThread;
     bool m_try4096kHz;
-    float * m_filterOutBuffer;
     InputDeviceSRC * m_src;
+    bool m_sampleTypeS16;
+    bool m_sampleTypeReal;                // real samples @ 8192kHz, libairspy IQ converter is bypassed
     uint_fast8_t m_signalLevelEmitCntr;
 
+    // channelizer, list is modified from GUI thread and processed by libairspy thread
+    QMutex m_channelMutex;
+    QList<AirspyChannelInput *> m_channels;
+
     void run();           
     void stop();
+    bool tuneDigital(uint32_t frequency);
+    bool isInCapturedBand(uint32_t frequency, uint32_t loFrequency) const;
+    void tuneChannel(AirspyChannelInput * channel, uint32_t frequency);
+    void applyChannelFrequency(AirspyChannelInput * channel);
+    void removeChannel(AirspyChannelInput * channel);
     void resetAgc();
 
     // private function
@@ -107,6 +185,10 @@ private:
     void onWatchdogTimeout();
 
     void doRecordBuffer(const float *buf, uint32_t len);
+    void pushRecordBuffer(const float *buf, uint32_t len);
+    void recordThread();
+    void startRecordThread();
+    void stopRecordThread();
     void processInputData(airspy_transfer* transfer);
     static int callback(airspy_transfer* transfer);
 };
@@ -24,11 +24,147 @@
  * SOFTWARE.
  */
 
+#include <QLoggingCategory>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "inputdevice.h"
+#include "inputdevicekernels.h"
+#include "diagnostics.h"
+#include "signaldetector.h"
+#include "spectrumtap.h"
+#include "iqstreamserver.h"
+#include "threadpriority.h"
+
+Q_LOGGING_CATEGORY(inputDevice, "InputDevice", QtInfoMsg)
+
+// input FIFOs, one per receiver (input device + DAB processing)
+static fifo_t inputFifos[INPUT_MAX_RECEIVERS];
+static InputFifoConfig inputFifoConfig;
+
+void ComplexFifo::init(uint64_t bytes, bool hugePages)
+{
+    if (nullptr != buffer)
+    {   // already allocated, buffer lives till the end of application
+        return;
+    }
 
-//input FIFO
-fifo_t inputBuffer;
+    // rounding to huge page size, it is multiple of sample size and of Windows allocation granularity
+    size = (bytes + INPUT_FIFO_ALIGN - 1) / INPUT_FIFO_ALIGN * INPUT_FIFO_ALIGN;
+    mirrored = false;
+    bool isHugeTlb = false;
 
+#if defined(_WIN32)
+    (void) hugePages;   // large pages require SeLockMemoryPrivilege, not used
+    HANDLE mapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, DWORD(size >> 32), DWORD(size), NULL);
+    if (NULL != mapping)
+    {
+        for (int attempt = 0; attempt < 8; ++attempt)
+        {   // find free address range, release it and map the file twice there
+            uint8_t * addr = (uint8_t *) VirtualAlloc(NULL, 2*size, MEM_RESERVE, PAGE_NOACCESS);
+            if (NULL == addr)
+            {
+                break;
+            }
+            VirtualFree(addr, 0, MEM_RELEASE);
+
+            uint8_t * view1 = (uint8_t *) MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, addr);
+            if (view1 == addr)
+            {
+                uint8_t * view2 = (uint8_t *) MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, addr + size);
+                if (view2 == addr + size)
+                {
+                    buffer = addr;
+                    mirrored = true;
+                    break;
+                }
+                if (NULL != view2)
+                {
+                    UnmapViewOfFile(view2);
+                }
+            }
+            if (NULL != view1)
+            {
+                UnmapViewOfFile(view1);
+            }
+        }
+        CloseHandle(mapping);  // views keep the mapping alive
+    }
+#else
+#if defined(__linux__)
+    int fd = -1;
+#if defined(MFD_HUGETLB)
+    if (hugePages)
+    {   // succeeds only if huge pages are reserved in the system
+        fd = memfd_create("abracadabra-fifo", MFD_HUGETLB);
+        if ((fd >= 0) && (0 != ftruncate(fd, size)))
+        {
+            close(fd);
+            fd = -1;
+        }
+        isHugeTlb = (fd >= 0);
+    }
+#endif
+    if (fd < 0)
+    {
+        fd = memfd_create("abracadabra-fifo", 0);
+    }
+#else
+    char name[32];
+    snprintf(name, sizeof(name), "/abracadabra-fifo-%d", int(getpid()));
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    shm_unlink(name);
+#endif
+    if (fd >= 0)
+    {
+        if (isHugeTlb || (0 == ftruncate(fd, size)))
+        {   // reserve address space aligned to huge page and map the file twice there
+            uint8_t * area = (uint8_t *) mmap(NULL, 2*size + INPUT_FIFO_ALIGN, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+            if (MAP_FAILED != area)
+            {
+                uint8_t * addr = (uint8_t *) ((uintptr_t(area) + INPUT_FIFO_ALIGN - 1) & ~uintptr_t(INPUT_FIFO_ALIGN - 1));
+                if (addr > area)
+                {   // release alignment padding
+                    munmap(area, addr - area);
+                }
+                munmap(addr + 2*size, area + INPUT_FIFO_ALIGN - addr);
+                if ((MAP_FAILED != mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0))
+                    && (MAP_FAILED != mmap(addr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0)))
+                {
+                    buffer = addr;
+                    mirrored = true;
+#if defined(MADV_HUGEPAGE)
+                    if (hugePages && !isHugeTlb)
+                    {   // transparent huge pages for shared memory, if enabled in the system
+                        madvise(addr, 2*size, MADV_HUGEPAGE);
+                    }
+#endif
+                }
+                else
+                {
+                    munmap(addr, 2*size);
+                }
+            }
+        }
+        close(fd);  // mapping keeps the memory alive
+    }
+#endif
+
+    if (!mirrored)
+    {   // fallback: mirror half is maintained by copying in the (rare) wrap-around case
+        qCWarning(inputDevice) << "Unable to create mirrored input buffer, using fallback";
+        buffer = new uint8_t[2*size];
+    }
+    qCInfo(inputDevice) << "Input FIFO:" << size / (1024*1024) << "MB" << (isHugeTlb ? "(huge pages)" : "");
+}
 
 void ComplexFifo::reset()
 {
@@ -37,7 +173,15 @@ void ComplexFifo::reset()
     count = 0;
     head = 0;
     tail = 0;
+    writeTotal = 0;
+    readTotal = 0;
+    staleMark = 0;
+    timestamps.reset();
+    readCaptureUs = 0;
+    overflowResync = false;
+    isOverflowing = false;
 
+    pthread_cond_signal(&spaceCondition);
     pthread_mutex_unlock(&countMutex);
 }
 
@@ -45,79 +189,403 @@ void ComplexFifo::fillDummy()
 {
     pthread_mutex_lock(&countMutex);
 
-    count = INPUT_FIFO_SIZE;
+    count = size;
+
+    pthread_cond_signal(&dataCondition);
+    pthread_mutex_unlock(&countMutex);
+}
+
+void ComplexFifo::flush()
+{   // this unblocks producer waiting for space, data are discarded
+    pthread_mutex_lock(&countMutex);
+
+    count = 0;
 
-    pthread_cond_signal(&countCondition);
+    pthread_cond_signal(&spaceCondition);
     pthread_mutex_unlock(&countMutex);
 }
 
+void ComplexFifo::setSampleFormat(InputFifoSampleFormat format)
+{
+    sampleFormat.store(int(format), std::memory_order_release);
+    reset();
+}
+
+void ComplexFifo::waitForSpace(uint64_t bytes)
+{
+    if (size - count.load(std::memory_order_acquire) >= bytes)
+    {   // fast path
+        return;
+    }
+
+    pthread_mutex_lock(&countMutex);
+    writerWaiting = true;
+    while (size - count.load() < bytes)
+    {
+        pthread_cond_wait(&spaceCondition, &countMutex);
+    }
+    writerWaiting = false;
+    pthread_mutex_unlock(&countMutex);
+}
+
+bool ComplexFifo::prepareWrite(uint64_t bytes)
+{
+    if (freeSpace() >= bytes)
+    {   // fast path
+        isOverflowing = false;
+        return true;
+    }
+
+    Diagnostics * diag = Diagnostics::getInstance();
+    diag->count(DiagnosticsCounter::InputFifoOverflows);
+    if (!isOverflowing)
+    {   // first chunk that does not fit
+        isOverflowing = true;
+        diag->count(DiagnosticsCounter::InputConsumerStalls);
+    }
+    else { /* overflow continues */ }
+
+    switch (static_cast<InputFifoOverflowPolicy>(overflowPolicy.load(std::memory_order_relaxed)))
+    {
+    case InputFifoOverflowPolicy::Block:
+        // flush() unblocks producer with empty FIFO
+        waitForSpace(bytes);
+        return true;
+    case InputFifoOverflowPolicy::DropOldest:
+        // consumer resynchronizes on the next chunk, samples are counted when they are dropped
+        overflowResync.store(true, std::memory_order_relaxed);
+        startGeneration();
+        break;
+    case InputFifoOverflowPolicy::DropNewest:
+        break;
+    }
+    diag->count(DiagnosticsCounter::InputDroppedSamples, bytes / sampleBytes());
+    return false;
+}
+
+void ComplexFifo::commitWrite(uint64_t bytes)
+{
+    if (!mirrored && (head + bytes > size))
+    {   // copy data written beyond the end to the beginning
+        memcpy(buffer, buffer + size, head + bytes - size);
+    }
+    head = (head + bytes) % size;
+    uint64_t total = writeTotal.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    // data are committed when they are received => time of the last sample
+    timestamps.mark(total, Diagnostics::timestampUs());
+
+    count.fetch_add(bytes);
+    if (readerWaiting.load())
+    {   // reader is starving -> wake it up
+        pthread_mutex_lock(&countMutex);
+        pthread_cond_signal(&dataCondition);
+        pthread_mutex_unlock(&countMutex);
+    }
+}
+
+void ComplexFifo::write(const uint8_t *data, uint64_t bytes)
+{   // caller shall check that there is enough space
+    memcpy(reserve(), data, bytes);
+    commitWrite(bytes);
+}
+
+void ComplexFifo::startGeneration()
+{
+    staleMark.store(writeTotal.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void ComplexFifo::waitForData(uint64_t bytes)
+{
+    if (count.load(std::memory_order_acquire) >= bytes)
+    {   // fast path
+        return;
+    }
+
+    uint64_t startUs = Diagnostics::timestampUs();
+    uint64_t written = writeTotal.load(std::memory_order_relaxed);
+
+    pthread_mutex_lock(&countMutex);
+    readerWaiting = true;
+    while (count.load() < bytes)
+    {
+        pthread_cond_wait(&dataCondition, &countMutex);
+    }
+    readerWaiting = false;
+    pthread_mutex_unlock(&countMutex);
+
+    // waiting for the first samples after start or reset is not an underflow
+    if ((written > 0) && (writeTotal.load(std::memory_order_relaxed) >= written)
+        && (Diagnostics::timestampUs() - startUs > INPUT_FIFO_UNDERFLOW_MS * 1000))
+    {
+        Diagnostics::getInstance()->count(DiagnosticsCounter::InputFifoUnderflows);
+    }
+}
+
+const uint8_t * ComplexFifo::peek(uint64_t bytes)
+{   // caller shall check that there is enough data
+    if (!mirrored && (tail + bytes > size))
+    {   // copy wrapped data from the beginning beyond the end
+        memcpy(buffer + size, buffer, tail + bytes - size);
+    }
+    return buffer + tail;
+}
+
+void ComplexFifo::commitRead(uint64_t bytes)
+{
+    tail = (tail + bytes) % size;
+    uint64_t total = readTotal.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    readCaptureUs.store(timestamps.captureUs(total, INPUT_FIFO_SAMPLES_PER_US * sampleBytes()), std::memory_order_relaxed);
+
+    count.fetch_sub(bytes);
+    if (writerWaiting.load())
+    {   // writer is blocked -> wake it up
+        pthread_mutex_lock(&countMutex);
+        pthread_cond_signal(&spaceCondition);
+        pthread_mutex_unlock(&countMutex);
+    }
+}
+
+void ComplexFifo::read(uint8_t *data, uint64_t bytes)
+{   // caller shall check that there is enough data
+    memcpy(data, peek(bytes), bytes);
+    commitRead(bytes);
+}
+
+uint64_t ComplexFifo::dropStale()
+{
+    uint64_t mark = staleMark.load(std::memory_order_acquire);
+    uint64_t readPos = readTotal.load(std::memory_order_relaxed);
+    if (mark <= readPos)
+    {   // no stale data
+        return 0;
+    }
+
+    // stale data were committed before the mark was set -> they are available
+    uint64_t bytes = mark - readPos;
+    uint64_t avail = count.load(std::memory_order_acquire);
+    if (bytes > avail)
+    {   // FIFO was reset meanwhile
+        bytes = avail;
+    }
+    bytes -= bytes % sampleBytes();
+    commitRead(bytes);
+    if (overflowResync.exchange(false, std::memory_order_relaxed))
+    {   // drop-oldest overflow policy
+        Diagnostics::getInstance()->count(DiagnosticsCounter::InputDroppedSamples, bytes / sampleBytes());
+    }
+    return bytes;
+}
+
+fifo_t * inputFifo(int receiver)
+{
+    Q_ASSERT((receiver >= 0) && (receiver < INPUT_MAX_RECEIVERS));
+
+    fifo_t * fifo = &inputFifos[receiver];
+    if (nullptr == fifo->buffer)
+    {   // FIFO lives till the end of application, it is shared by all input devices of the receiver
+        fifo->init(inputFifoConfig.sizeBytes(), inputFifoConfig.hugePages);
+        fifo->count = 0;
+        fifo->head = 0;
+        fifo->tail = 0;
+        fifo->writeTotal = 0;
+        fifo->readTotal = 0;
+        fifo->staleMark = 0;
+        fifo->readCaptureUs = 0;
+        fifo->overflowPolicy = int(inputFifoConfig.overflowPolicy);
+        fifo->overflowResync = false;
+        fifo->isOverflowing = false;
+        fifo->sampleFormat = int(InputFifoSampleFormat::Float32);
+        fifo->readerWaiting = false;
+        fifo->writerWaiting = false;
+        pthread_mutex_init(&fifo->countMutex, NULL);
+        pthread_cond_init(&fifo->dataCondition, NULL);
+        pthread_cond_init(&fifo->spaceCondition, NULL);
+        Diagnostics::getInstance()->addMemory(DiagnosticsMemory::InputFifo, int64_t(fifo->size));
+    }
+    return fifo;
+}
+
 InputDevice::InputDevice(QObject *parent) : QObject(parent)
+{   // FIFO is bound by openDevice(), FIFO of other receiver can be running when device is created
+    m_inputBuffer = nullptr;
+}
+
+void InputDevice::setReceiver(int receiver)
+{
+    Q_ASSERT(nullptr == m_inputBuffer);
+    m_receiver = receiver;
+}
+
+void InputDevice::openFifo(InputFifoSampleFormat format)
+{   // FIFO is reset, producer and consumer of the receiver are not running
+    m_inputBuffer = inputFifo(m_receiver);
+    m_inputBuffer->setSampleFormat(format);
+}
+
+void InputDevice::useCompactFifo()
+{
+    openFifo(inputFifoConfig.compactSamples ? InputFifoSampleFormat::Int16 : InputFifoSampleFormat::Float32);
+}
+
+void InputDevice::setFifoConfig(const InputFifoConfig &config)
+{
+    if (nullptr != inputFifos[0].buffer)
+    {
+        qCWarning(inputDevice) << "Input FIFO is already allocated, configuration is ignored";
+        return;
+    }
+    inputFifoConfig = config;
+    if (inputFifoConfig.chunkMs <= 0)
+    {
+        inputFifoConfig.chunkMs = INPUT_CHUNK_MS;
+    }
+    if (inputFifoConfig.numChunks < 2)
+    {   // producer writes one chunk while consumer reads the other one
+        inputFifoConfig.numChunks = 2;
+    }
+}
+
+const InputFifoConfig &InputDevice::fifoConfig()
+{
+    return inputFifoConfig;
+}
+
+void InputDevice::setFifoOverflowPolicy(InputFifoOverflowPolicy policy)
 {
-    // init empty fifo
-    inputBuffer.count = 0;
-    inputBuffer.head = 0;
-    inputBuffer.tail = 0;
-    pthread_mutex_init(&inputBuffer.countMutex, NULL);
-    pthread_cond_init(&inputBuffer.countCondition, NULL);
+    inputFifoConfig.overflowPolicy = policy;
+    for (auto & fifo : inputFifos)
+    {   // producers pick it up with next chunk
+        fifo.overflowPolicy.store(int(policy), std::memory_order_relaxed);
+    }
 }
 
 InputDevice::~InputDevice()
+{   // FIFO is not released, DAB processing of the receiver may still wait for data
+}
+
+// dabsdr input function has no context => one function per receiver
+// FIFO is allocated by RadioControl::init() before DAB processing starts
+template <int N>
+static void getSamplesReceiver(float buffer[], uint16_t numSamples)
+{
+    getSamples(&inputFifos[N], buffer, numSamples);
+}
+
+template <int N>
+static void skipSamplesReceiver(float buffer[], uint16_t numSamples)
 {
-    pthread_mutex_destroy(&inputBuffer.countMutex);
-    pthread_cond_destroy(&inputBuffer.countCondition);
+    skipSamples(&inputFifos[N], buffer, numSamples);
+}
+
+static_assert(INPUT_MAX_RECEIVERS == 4, "input function tables have to be updated");
+
+static const InputSamplesFcn getSamplesFcns[INPUT_MAX_RECEIVERS] =
+{
+    getSamplesReceiver<0>, getSamplesReceiver<1>, getSamplesReceiver<2>, getSamplesReceiver<3>
+};
+
+static const InputSamplesFcn skipSamplesFcns[INPUT_MAX_RECEIVERS] =
+{
+    skipSamplesReceiver<0>, skipSamplesReceiver<1>, skipSamplesReceiver<2>, skipSamplesReceiver<3>
+};
+
+InputSamplesFcn getSamplesFcn(int receiver)
+{
+    Q_ASSERT((receiver >= 0) && (receiver < INPUT_MAX_RECEIVERS));
+    return getSamplesFcns[receiver];
+}
+
+InputSamplesFcn skipSamplesFcn(int receiver)
+{
+    Q_ASSERT((receiver >= 0) && (receiver < INPUT_MAX_RECEIVERS));
+    return skipSamplesFcns[receiver];
 }
 
 void getSamples(float buffer[], uint16_t numSamples)
 {
-    // input read -> lets store it to FIFO
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    uint64_t count = inputBuffer.count;
-    uint_fast32_t numIQ = numSamples * 2;
-    while (count < numIQ*sizeof(float))
+    getSamples(&inputFifos[0], buffer, numSamples);
+}
+
+void skipSamples(float buffer[], uint16_t numSamples)
+{
+    skipSamples(&inputFifos[0], buffer, numSamples);
+}
+
+void getSamples(fifo_t * fifo, float buffer[], uint16_t numSamples)
+{
+    ThreadPriority::update(ThreadClass::Dabsdr);    // called from dabsdr thread
+    fifo_t & inputBuffer = *fifo;
+    const InputFifoSampleFormat format = inputBuffer.format();
+    const uint64_t sampleBytes = inputBuffer.sampleBytes();
+    uint64_t bytesToRead = numSamples * sampleBytes;
+    bool isPrimary = (fifo == &inputFifos[0]);
+
+    // samples from previous channel are dropped, first sample after this is fresh
+    uint64_t dropped = inputBuffer.dropStale();
+    if (dropped > 0)
     {
-        pthread_cond_wait(&inputBuffer.countCondition, &inputBuffer.countMutex);
-        count = inputBuffer.count;
+        qCDebug(inputDevice) << "Dropped" << dropped / sampleBytes << "stale samples after retune or overflow";
     }
-    pthread_mutex_unlock(&inputBuffer.countMutex);
 
-    // there is enough samples in input buffer
-    uint64_t bytesTillEnd = INPUT_FIFO_SIZE - inputBuffer.tail;
-    if (bytesTillEnd >= numIQ*sizeof(float))
+    if (isPrimary)
     {
-        memcpy(buffer, inputBuffer.buffer + inputBuffer.tail, numIQ*sizeof(float));
-        inputBuffer.tail = (inputBuffer.tail + numIQ*sizeof(float));
+        Diagnostics::getInstance()->add(DiagnosticsMetric::InputFifoLevel, inputBuffer.available() / sampleBytes);
+    }
+    else { /* diagnostics, detector and IQ stream follow the primary receiver only */ }
+
+    // wait for enough samples in input buffer
+    inputBuffer.waitForData(bytesToRead);
+
+    if (InputFifoSampleFormat::Int16 == format)
+    {   // compact samples are converted directly to dabsdr buffer
+        const int16_t * samples = reinterpret_cast<const int16_t *>(inputBuffer.peek(bytesToRead));
+        InputDeviceKernels::convertS16(samples, buffer, 2 * numSamples, 1.0f / INPUT_FIFO_S16_SCALE);
+        inputBuffer.commitRead(bytesToRead);
     }
     else
     {
-        memcpy(buffer, inputBuffer.buffer + inputBuffer.tail, bytesTillEnd);
-        Q_ASSERT(2*sizeof(float) == 8);
-        uint64_t numIQtillEnd = bytesTillEnd >> 2;
-        memcpy(buffer+numIQtillEnd, inputBuffer.buffer, (numIQ - numIQtillEnd)*sizeof(float));
-        inputBuffer.tail = (numIQ - numIQtillEnd) * sizeof(float);
+        inputBuffer.read(reinterpret_cast<uint8_t *>(buffer), bytesToRead);
     }
 
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    inputBuffer.count = inputBuffer.count - numIQ*sizeof(float);
-    pthread_cond_signal(&inputBuffer.countCondition);
-    pthread_mutex_unlock(&inputBuffer.countMutex);
+    if (isPrimary)
+    {
+        SignalDetector::getInstance()->process(buffer, numSamples);
+        SpectrumTap::getInstance()->process(buffer, numSamples);
+        IQStreamServer::feedSamples(buffer, numSamples);
+    }
 }
 
-void skipSamples(float buffer[], uint16_t numSamples)
+void skipSamples(fifo_t * fifo, float buffer[], uint16_t numSamples)
 {
     (void) buffer;
 
-    // input read -> lets store it to FIFO
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    uint64_t count = inputBuffer.count;
-    while (count < numSamples*2*sizeof(float))
-    {
-        pthread_cond_wait(&inputBuffer.countCondition, &inputBuffer.countMutex);
-        count = inputBuffer.count;
-    }
+    fifo_t & inputBuffer = *fifo;
+    const InputFifoSampleFormat format = inputBuffer.format();
+    uint64_t bytesToSkip = numSamples * inputBuffer.sampleBytes();
+
+    inputBuffer.dropStale();
 
-    inputBuffer.tail = (inputBuffer.tail + numSamples*2*sizeof(float)) % INPUT_FIFO_SIZE;
+    // wait for enough samples in input buffer
+    inputBuffer.waitForData(bytesToSkip);
+
+    SignalDetector * detector = SignalDetector::getInstance();
+    SpectrumTap * spectrumTap = SpectrumTap::getInstance();
+    if ((fifo == &inputFifos[0]) && (detector->isRunning() || spectrumTap->isRunning() || IQStreamServer::isActive()))
+    {   // skipped samples are still needed by detector, spectrum and IQ stream clients
+        const float * samples = reinterpret_cast<const float *>(inputBuffer.peek(bytesToSkip));
+        if (InputFifoSampleFormat::Int16 == format)
+        {   // conversion buffer of dabsdr thread
+            static thread_local std::vector<float> floatSamples;
+            floatSamples.resize(2 * size_t(numSamples));
+            InputDeviceKernels::convertS16(reinterpret_cast<const int16_t *>(samples), floatSamples.data(), 2 * numSamples, 1.0f / INPUT_FIFO_S16_SCALE);
+            samples = floatSamples.data();
+        }
+        else { /* samples are used directly from FIFO */ }
+        detector->process(samples, numSamples);
+        spectrumTap->process(samples, numSamples);
+        IQStreamServer::feedSamples(samples, numSamples);
+    }
 
-    inputBuffer.count = inputBuffer.count - numSamples*2*sizeof(float);
-    pthread_cond_signal(&inputBuffer.countCondition);
-    pthread_mutex_unlock(&inputBuffer.countMutex);
+    inputBuffer.commitRead(bytesToSkip);
 }
@@ -31,34 +31,123 @@
 #include <QMutex>
 #include <QWaitCondition>
 #include <pthread.h>
+#include <atomic>
+#include "sampletimestamps.h"
 
-// this is chunk that is received from input device to be stored in input FIFO
+// this is reference chunk, time constants of input devices are derived from it
 #define INPUT_CHUNK_MS            (400)
 #define INPUT_CHUNK_IQ_SAMPLES    (2048 * INPUT_CHUNK_MS)
 
-// Input FIFO size in bytes - FIFO contains float _Complex samples => [float float]
-// total capacity is 8 input chunks
-#define INPUT_FIFO_SIZE           (INPUT_CHUNK_IQ_SAMPLES * (2*sizeof(float)) * 8)
+// Input FIFO contains float _Complex samples => [float float] or compact int16 samples => [int16 int16]
+// size is configured at runtime (InputFifoConfig) before first input device is created
+#define INPUT_FIFO_CHUNKS         (8)            // default capacity in input chunks
+#define INPUT_FIFO_LOWMEM_CHUNK_MS (100)         // low memory profile: 4 x 100 ms (~6.5 MB)
+#define INPUT_FIFO_LOWMEM_CHUNKS  (4)
+#define INPUT_FIFO_ALIGN          (2*1024*1024)  // size granularity (huge page, Windows allocation granularity)
+
+#define INPUT_MAX_RECEIVERS       (4)            // concurrently running input devices, each has own FIFO
 
 #define INPUTDEVICE_WDOG_TIMEOUT_SEC 2     // watchdog timeout in seconds (if implemented and enabled)
 
 #define INPUTDEVICE_BANDWIDTH  (1530*1000)
 
+#define INPUT_FIFO_SAMPLES_PER_US (2.048)    // 2048kHz IQ samples
+#define INPUT_FIFO_S16_SCALE      (128.0f)   // compact format: int16 value = float value * scale
+#define INPUT_FIFO_UNDERFLOW_MS   (INPUT_CHUNK_MS)   // consumer waiting longer for data is counted as underflow
+
+// producer behavior when input chunk does not fit into FIFO (DAB processing does not keep up)
+enum class InputFifoOverflowPolicy
+{
+    Block = 0,      // producer waits for space, this may stall USB transfers of the device driver
+    DropNewest,     // chunk is dropped, FIFO content is kept
+    DropOldest,     // chunk is dropped and consumer drops all older samples, it continues with fresh samples
+};
+
+// sample format of input FIFO, consumer (getSamples) converts samples to float for dabsdr
+enum class InputFifoSampleFormat
+{
+    Float32 = 0,    // [float float] = float _Complex, written by all devices
+    Int16,          // [int16 int16] scaled by INPUT_FIFO_S16_SCALE, written by devices with 8 bit samples
+};
+
+// Single producer single consumer ring buffer
+// head is owned by producer (input device thread), tail is owned by consumer (dabsdr thread)
+// count is the only shared variable, mutex and conditions are used only when one side is blocked
+// retune while producer is running: producer marks the end of stale data by startGeneration(),
+//   consumer drops all samples written before the mark when reading (no reset from producer side)
+// overflow: producer calls prepareWrite() that applies overflow policy, events are counted in Diagnostics
+// sample format: producer selects it when device is opened (FIFO is reset), all counters are in bytes
+// buffer memory is mapped twice in a row (if supported by OS) so that any region of up to
+// size bytes starting at head or tail is contiguous in memory
 struct ComplexFifo
 {
-    uint64_t count;
+    std::atomic<uint64_t> count;
     uint64_t head;
     uint64_t tail;
-    uint8_t buffer[INPUT_FIFO_SIZE];
+    uint64_t size;
+    uint8_t * buffer;
+    bool mirrored;
+
+    std::atomic<uint64_t> writeTotal;   // bytes written since reset, updated by producer
+    std::atomic<uint64_t> readTotal;    // bytes read since reset, updated by consumer
+    std::atomic<uint64_t> staleMark;    // writeTotal when current generation started
+
+    // capture time of samples: producer marks every write, consumer publishes time of samples it reads
+    SampleTimestamps timestamps;
+    std::atomic<uint64_t> readCaptureUs;    // capture time of the newest sample read by consumer [us]
 
+    std::atomic<int> overflowPolicy;        // InputFifoOverflowPolicy
+    std::atomic<bool> overflowResync;       // samples before stale mark are dropped because of overflow
+    bool isOverflowing;                     // producer owned, FIFO was full at last write
+    std::atomic<int> sampleFormat;          // InputFifoSampleFormat
+
+    std::atomic<bool> readerWaiting;
+    std::atomic<bool> writerWaiting;
     pthread_mutex_t countMutex;
-    pthread_cond_t countCondition;
+    pthread_cond_t dataCondition;
+    pthread_cond_t spaceCondition;
 
+    void init(uint64_t bytes, bool hugePages);      // buffer is allocated once for application lifetime
     void reset();
     void fillDummy();
+    void flush();
+    void setSampleFormat(InputFifoSampleFormat format);     // FIFO is reset
+    InputFifoSampleFormat format() const { return static_cast<InputFifoSampleFormat>(sampleFormat.load(std::memory_order_acquire)); }
+    uint64_t sampleBytes() const { return (InputFifoSampleFormat::Int16 == format()) ? 2*sizeof(int16_t) : 2*sizeof(float); }
+    uint64_t valueBytes() const { return sampleBytes() / 2; }     // I or Q value
+
+    // producer API
+    uint64_t freeSpace() const { return size - count.load(std::memory_order_acquire); }
+    bool prepareWrite(uint64_t bytes);                      // applies overflow policy, false if chunk shall be dropped
+    void waitForSpace(uint64_t bytes);
+    uint8_t * reserve() const { return buffer + head; }    // contiguous space of freeSpace() bytes
+    void commitWrite(uint64_t bytes);
+    void write(const uint8_t * data, uint64_t bytes);
+    void startGeneration();                                 // everything written so far is stale
+
+    // consumer API
+    uint64_t available() const { return count.load(std::memory_order_acquire); }
+    void waitForData(uint64_t bytes);
+    const uint8_t * peek(uint64_t bytes);                   // contiguous data of bytes length
+    void commitRead(uint64_t bytes);
+    void read(uint8_t * data, uint64_t bytes);
+    uint64_t dropStale();                                   // returns number of dropped bytes
 };
 typedef struct ComplexFifo fifo_t;
 
+struct InputFifoConfig
+{
+    int chunkMs = INPUT_CHUNK_MS;        // chunk written at once by file input
+    int numChunks = INPUT_FIFO_CHUNKS;   // FIFO capacity
+    bool hugePages = true;               // use huge pages where available
+    InputFifoOverflowPolicy overflowPolicy = InputFifoOverflowPolicy::DropNewest;   // live devices, raw file input always waits
+    bool compactSamples = false;         // FIFO is sized for int16 samples, RTL-SDR and RTL-TCP write int16
+                                         // devices with float samples get half of the duration
+
+    uint64_t sizeBytes() const { return uint64_t(2048) * chunkMs * numChunks * (compactSamples ? 2*sizeof(int16_t) : 2*sizeof(float)); }
+    static InputFifoConfig lowMemory() { return { INPUT_FIFO_LOWMEM_CHUNK_MS, INPUT_FIFO_LOWMEM_CHUNKS, true }; }
+};
+
 enum class InputDeviceId { UNDEFINED = 0, RTLSDR, RTLTCP, RAWFILE, AIRSPY, SOAPYSDR};
 
 enum class RtlGainMode
@@ -91,10 +180,12 @@ struct InputDeviceDescription
     {
         QString name;
         QString model;
+        QString serial;           // USB serial number (if available), used to reopen the same device
     } device;
     struct
     {
         int sampleRate;
+        int inputSampleRate = 0;  // device sample rate before SRC, 0 if stream is not resampled
         int channelBits;          // I or Q
         int containerBits;        // I or Q
         QString channelContainer; // I or Q
@@ -102,6 +193,8 @@ struct InputDeviceDescription
     struct
     {
         bool hasXmlHeader;
+        bool hasWavHeader;        // RIFF or RF64 WAVE container
+        bool isCompressed;        // chunked compressed container (see rawfilecodec.h)
         QString recorder;
         QString time;
         uint32_t frequency_kHz;
@@ -121,6 +214,20 @@ public:
     virtual bool openDevice() = 0;
     const InputDeviceDescription & deviceDescription() const { return m_deviceDescription; }
 
+    // called when some USB device was removed, device checks immediately if it is still alive
+    virtual void checkConnection() { }
+
+    // input device writes to FIFO of receiver 0 by default, other receiver has to be set before openDevice()
+    // FIFO is bound and its sample format is selected only by openDevice()
+    void setReceiver(int receiver);
+    int receiver() const { return m_receiver; }
+    fifo_t * fifo() const { return m_inputBuffer; }
+
+    // has effect only when called before first input device is created
+    static void setFifoConfig(const InputFifoConfig & config);
+    static const InputFifoConfig & fifoConfig();
+    static void setFifoOverflowPolicy(InputFifoOverflowPolicy policy);     // can be changed anytime
+
 public slots:
     virtual void tune(uint32_t freq) = 0;
     virtual void startStopRecording(bool start) = 0;
@@ -133,11 +240,30 @@ signals:
     void error(const InputDeviceErrorCode errCode = InputDeviceErrorCode::Undefined);
 
 protected:
+    // called once from openDevice(), FIFO of receiver is bound and reset to sample format of the device
+    void openFifo(InputFifoSampleFormat format = InputFifoSampleFormat::Float32);
+
+    // devices with 8 bit samples call it from openDevice() instead of openFifo()
+    void useCompactFifo();
+
     InputDeviceDescription m_deviceDescription;
+    fifo_t * m_inputBuffer;     // nullptr till openDevice()
+    int m_receiver = 0;
 };
 
-extern fifo_t inputBuffer;
+// FIFO of receiver, allocated on first use
+fifo_t * inputFifo(int receiver = 0);
+
+// input functions registered to dabsdr, one per receiver
+typedef void (*InputSamplesFcn)(float [], uint16_t);
+InputSamplesFcn getSamplesFcn(int receiver);
+InputSamplesFcn skipSamplesFcn(int receiver);
+
+// receiver 0
 void getSamples(float buffer[], uint16_t len);
 void skipSamples(float buffer[], uint16_t numSamples);
 
+void getSamples(fifo_t * fifo, float buffer[], uint16_t len);
+void skipSamples(fifo_t * fifo, float buffer[], uint16_t numSamples);
+
 #endif // INPUTDEVICE_H
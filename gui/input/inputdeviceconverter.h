@@ -0,0 +1,198 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef INPUTDEVICECONVERTER_H
+#define INPUTDEVICECONVERTER_H
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include "inputdevice.h"
+#include "inputdevicekernels.h"
+
+// converter features, selected at compile time
+#define INPUTDEVICECONVERTER_DC_REMOVAL  (0x01)   // DC offset correction across buffers
+#define INPUTDEVICECONVERTER_LEVEL       (0x02)   // signal level estimation (AGC input)
+
+#define INPUTDEVICECONVERTER_S16_BLOCK   (4096)   // values converted to float at once for compact FIFO (stays in L1 cache)
+
+// complex signed 12 bit sample, IQ pair packed in 3 bytes: [I[7:0]] [Q[3:0] I[11:8]] [Q[11:4]]
+struct InputDeviceS12Packed
+{
+    uint8_t bytes[3];
+};
+
+// Converts IQ samples from device format to float, writes them directly to input FIFO
+// T is device sample type (uint8_t, int8_t, int16_t, uint16_t, InputDeviceS12Packed or float)
+// uint16_t is offset binary, InputDeviceS12Packed pointer points to IQ pairs while len is still number of values
+// DC removal and level estimation is supported for uint8_t samples, where the state is kept between buffers
+template <typename T, uint32_t Features = 0>
+class InputDeviceConverter
+{
+    static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, int8_t>
+                  || std::is_same_v<T, int16_t> || std::is_same_v<T, uint16_t>
+                  || std::is_same_v<T, InputDeviceS12Packed> || std::is_same_v<T, float>, "Unsupported sample type");
+    static_assert(std::is_same_v<T, uint8_t> || (0 == Features), "Features are supported for uint8_t samples only");
+public:
+    // scale is used for signed samples (1/32768 for full scale int16 etc.)
+    explicit InputDeviceConverter(float scale = 1.0) : m_scale(scale) { }
+
+    void setScale(float scale) { m_scale = scale; }
+
+    // DC coefficient is per processed buffer
+    void setDcCoef(float c) { m_dcCoef = c; }
+    void setLevelCoefs(float catt, float crel) { m_levelCatt = catt; m_levelCrel = crel; }
+    void resetDc() { m_dc[0] = 0.0; m_dc[1] = 0.0; }
+    void reset() { resetDc(); m_level = 0.0; }
+    float level() const { return m_level; }
+
+    // len is number of I and Q values, it must be even for DC removal
+    void process(const T * in, float * out, uint32_t len)
+    {
+        if constexpr (std::is_same_v<T, uint8_t>)
+        {
+            int32_t sum[2] = { 0, 0 };
+            constexpr bool DC = (Features & INPUTDEVICECONVERTER_DC_REMOVAL) != 0;
+            constexpr bool LEVEL = (Features & INPUTDEVICECONVERTER_LEVEL) != 0;
+            const float dc[2] = { m_dc[0], m_dc[1] };
+            float lev = m_level;
+            InputDeviceKernels::convertU8(in, out, len, dc, sum, lev,
+                                          LEVEL ? m_levelCatt : 0.0f, LEVEL ? m_levelCrel : 0.0f);
+            if constexpr (DC)
+            {   // calculate correction values for next input buffer
+                m_dc[0] = sum[0] * m_dcCoef / (len >> 1) + dc[0] - m_dcCoef * dc[0];
+                m_dc[1] = sum[1] * m_dcCoef / (len >> 1) + dc[1] - m_dcCoef * dc[1];
+            }
+            if constexpr (LEVEL)
+            {
+                m_level = lev;
+            }
+        }
+        else if constexpr (std::is_same_v<T, int8_t>)
+        {
+            InputDeviceKernels::convertS8(in, out, len, m_scale);
+        }
+        else if constexpr (std::is_same_v<T, int16_t>)
+        {
+            InputDeviceKernels::convertS16(in, out, len, m_scale);
+        }
+        else if constexpr (std::is_same_v<T, uint16_t>)
+        {
+            InputDeviceKernels::convertU16(in, out, len, m_scale);
+        }
+        else if constexpr (std::is_same_v<T, InputDeviceS12Packed>)
+        {
+            InputDeviceKernels::convertS12P(in->bytes, out, len, m_scale);
+        }
+        else
+        {   // float
+            if (1.0f == m_scale)
+            {
+                std::memcpy(out, in, len * sizeof(float));
+            }
+            else
+            {
+                for (uint32_t n = 0; n < len; ++n)
+                {
+                    out[n] = in[n] * m_scale;
+                }
+            }
+        }
+    }
+
+    // converts uint8_t samples to compact FIFO format (int16 scaled by INPUT_FIFO_S16_SCALE)
+    // float values are produced in small blocks, DC and level state is updated per buffer as in process()
+    // len is number of I and Q values, it must be even
+    void processS16(const T * in, int16_t * out, uint32_t len)
+    {
+        static_assert(std::is_same_v<T, uint8_t>, "Compact FIFO format is supported for uint8_t samples only");
+        static_assert(0 == INPUTDEVICECONVERTER_S16_BLOCK % INPUTDEVICEKERNELS_LEVEL_BLOCK, "Block has to be multiple of level block");
+
+        float block[INPUTDEVICECONVERTER_S16_BLOCK];
+        int32_t sum[2] = { 0, 0 };
+        constexpr bool DC = (Features & INPUTDEVICECONVERTER_DC_REMOVAL) != 0;
+        constexpr bool LEVEL = (Features & INPUTDEVICECONVERTER_LEVEL) != 0;
+        const float dc[2] = { m_dc[0], m_dc[1] };
+        float lev = m_level;
+        for (uint32_t n = 0; n < len; n += INPUTDEVICECONVERTER_S16_BLOCK)
+        {
+            uint32_t blockLen = std::min(len - n, uint32_t(INPUTDEVICECONVERTER_S16_BLOCK));
+            int32_t blockSum[2] = { 0, 0 };
+            InputDeviceKernels::convertU8(in + n, block, blockLen, dc, blockSum, lev,
+                                          LEVEL ? m_levelCatt : 0.0f, LEVEL ? m_levelCrel : 0.0f);
+            InputDeviceKernels::convertToS16(block, out + n, blockLen, INPUT_FIFO_S16_SCALE);
+            sum[0] += blockSum[0];
+            sum[1] += blockSum[1];
+        }
+        if constexpr (DC)
+        {   // calculate correction values for next input buffer
+            m_dc[0] = sum[0] * m_dcCoef / (len >> 1) + dc[0] - m_dcCoef * dc[0];
+            m_dc[1] = sum[1] * m_dcCoef / (len >> 1) + dc[1] - m_dcCoef * dc[1];
+        }
+        if constexpr (LEVEL)
+        {
+            m_level = lev;
+        }
+    }
+
+    // converts to FIFO in its sample format, FIFO space has to be checked by caller
+    void processToFifo(fifo_t & fifo, const T * in, uint32_t len)
+    {
+        if constexpr (std::is_same_v<T, uint8_t>)
+        {
+            if (InputFifoSampleFormat::Int16 == fifo.format())
+            {
+                processS16(in, (int16_t *) fifo.reserve(), len);
+                return;
+            }
+        }
+        process(in, (float *) fifo.reserve(), len);
+    }
+
+    // converts to FIFO reservation, returns false if there is not enough free space
+    bool write(fifo_t & fifo, const T * in, uint32_t len)
+    {
+        const uint64_t bytes = len * (std::is_same_v<T, uint8_t> ? fifo.valueBytes() : sizeof(float));
+        if (fifo.freeSpace() < bytes)
+        {
+            return false;
+        }
+        processToFifo(fifo, in, len);
+        fifo.commitWrite(bytes);
+        return true;
+    }
+
+private:
+    float m_scale;
+    float m_dc[2] = { 0.0, 0.0 };
+    float m_dcCoef = 0.0;
+    float m_level = 0.0;
+    float m_levelCatt = 0.0;
+    float m_levelCrel = 0.0;
+};
+
+#endif // INPUTDEVICECONVERTER_H
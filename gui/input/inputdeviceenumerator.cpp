@@ -0,0 +1,167 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include <rtl-sdr.h>
+#include "config.h"
+#if HAVE_AIRSPY
+#include <libairspy/airspy.h>
+#endif
+#if HAVE_SOAPYSDR
+#include <SoapySDR/Device.hpp>
+#include <SoapySDR/Types.hpp>
+#endif
+
+#include "inputdeviceenumerator.h"
+
+Q_LOGGING_CATEGORY(inputDeviceEnumerator, "InputDeviceEnumerator", QtInfoMsg)
+
+#define INPUTDEVICEENUMERATOR_AIRSPY_MAX  (8)    // maximum number of listed Airspy devices
+
+InputDeviceEnumerator * InputDeviceEnumerator::m_instancePtr = nullptr;
+
+InputDeviceEnumerator *InputDeviceEnumerator::getInstance()
+{
+    if (m_instancePtr == nullptr)
+    {
+        m_instancePtr = new InputDeviceEnumerator();
+    }
+    return m_instancePtr;
+}
+
+InputDeviceEnumerator::InputDeviceEnumerator(QObject *parent) : QObject(parent)
+{
+}
+
+InputDeviceEnumerator::~InputDeviceEnumerator()
+{
+    if (nullptr != m_thread)
+    {   // enumeration cannot be interrupted
+        m_thread->join();
+        delete m_thread;
+    }
+}
+
+void InputDeviceEnumerator::refresh()
+{
+    if (m_isRunning)
+    {   // results will be available soon
+        return;
+    }
+
+    if (nullptr != m_thread)
+    {   // previous enumeration finished
+        m_thread->join();
+        delete m_thread;
+    }
+
+    m_isRunning = true;
+    emit enumerationStarted();
+    m_thread = new std::thread(&InputDeviceEnumerator::run, this);
+}
+
+bool InputDeviceEnumerator::devices(InputDeviceId id, QList<InputDeviceListItem> &list) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_devices.constFind(id);
+    if (it == m_devices.cend())
+    {
+        return false;
+    }
+    list = it.value();
+    return true;
+}
+
+void InputDeviceEnumerator::setDevices(InputDeviceId id, const QList<InputDeviceListItem> &list)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_devices[id] = list;
+    }
+    qCDebug(inputDeviceEnumerator) << "Device type" << int(id) << "devices found:" << list.size();
+    emit devicesFound(id);
+}
+
+void InputDeviceEnumerator::run()
+{
+    // fast enumerations first so that UI is updated progressively
+    QList<InputDeviceListItem> list;
+    uint32_t count = rtlsdr_get_device_count();
+    for (uint32_t n = 0; n < count; ++n)
+    {
+        char manufacturer[256];
+        char product[256];
+        char serial[256];
+        InputDeviceListItem item;
+        if (0 == rtlsdr_get_device_usb_strings(n, manufacturer, product, serial))
+        {
+            item.label = QString("%1 %2 [%3]").arg(manufacturer, product, serial).trimmed();
+            item.args = QString(serial);
+        }
+        else
+        {
+            item.label = QString(rtlsdr_get_device_name(n));
+        }
+        list.append(item);
+    }
+    setDevices(InputDeviceId::RTLSDR, list);
+
+#if HAVE_AIRSPY
+    list.clear();
+    uint64_t serials[INPUTDEVICEENUMERATOR_AIRSPY_MAX];
+    int airspyCount = airspy_list_devices(serials, INPUTDEVICEENUMERATOR_AIRSPY_MAX);
+    for (int n = 0; n < airspyCount; ++n)
+    {
+        QString serial = QString("%1").arg(serials[n], 16, 16, QChar('0')).toUpper();
+        list.append({ QString("Airspy [%1]").arg(serial), serial });
+    }
+    setDevices(InputDeviceId::AIRSPY, list);
+#endif
+
+#if HAVE_SOAPYSDR
+    list.clear();
+    try
+    {
+        SoapySDR::KwargsList devs = SoapySDR::Device::enumerate();
+        for (const auto & args : devs)
+        {
+            InputDeviceListItem item;
+            auto it = args.find("label");
+            item.label = QString::fromStdString((it != args.end()) ? it->second : SoapySDR::KwargsToString(args));
+            item.args = QString::fromStdString(SoapySDR::KwargsToString(args));
+            list.append(item);
+        }
+    }
+    catch (const std::exception & ex)
+    {
+        qCWarning(inputDeviceEnumerator) << "SoapySDR enumeration failed:" << ex.what();
+    }
+    setDevices(InputDeviceId::SOAPYSDR, list);
+#endif
+
+    m_isRunning = false;
+    emit enumerationFinished();
+}
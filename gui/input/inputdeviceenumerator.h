@@ -0,0 +1,82 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef INPUTDEVICEENUMERATOR_H
+#define INPUTDEVICEENUMERATOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "inputdevice.h"
+
+struct InputDeviceListItem
+{
+    QString label;     // text for user
+    QString args;      // device specific identification (serial number, SoapySDR arguments)
+};
+
+// singleton class
+// devices are enumerated in background thread, results are cached until next refresh()
+// SoapySDR loads all modules during first enumeration, this can take seconds
+// devicesFound() is emitted from enumeration thread for every device type as soon as it is done
+class InputDeviceEnumerator : public QObject
+{
+    Q_OBJECT
+public:
+    InputDeviceEnumerator(const InputDeviceEnumerator & obj) = delete;   // deleting copy constructor
+    static InputDeviceEnumerator * getInstance();
+    ~InputDeviceEnumerator();
+
+    // starts enumeration if not running
+    void refresh();
+    bool isEnumerating() const { return m_isRunning; }
+
+    // returns false if device type was not enumerated yet
+    bool devices(InputDeviceId id, QList<InputDeviceListItem> & list) const;
+
+signals:
+    void enumerationStarted();
+    void devicesFound(InputDeviceId id);
+    void enumerationFinished();
+
+private:
+    explicit InputDeviceEnumerator(QObject *parent = nullptr);
+    static InputDeviceEnumerator * m_instancePtr;
+
+    mutable std::mutex m_mutex;
+    QHash<InputDeviceId, QList<InputDeviceListItem>> m_devices;
+    std::atomic<bool> m_isRunning { false };
+    std::thread * m_thread = nullptr;
+
+    void run();
+    void setDevices(InputDeviceId id, const QList<InputDeviceListItem> & list);
+};
+
+#endif // INPUTDEVICEENUMERATOR_H
@@ -0,0 +1,613 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define INPUTDEVICEKERNELS_SSE2 1
+#if defined(__GNUC__)
+#include <immintrin.h>
+#define INPUTDEVICEKERNELS_AVX2 1
+#endif
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define INPUTDEVICEKERNELS_NEON 1
+#endif
+
+#include "inputdevicekernels.h"
+
+// signal level update with block maximum
+// release is applied once per block thus the coefficient is scaled by block size
+static inline void updateLevel(float & level, float blockMax, float catt, float crel)
+{
+    float c = crel * INPUTDEVICEKERNELS_LEVEL_BLOCK;
+    if (blockMax > level)
+    {
+        c = catt;
+    }
+    level = c * blockMax + level - c * level;
+}
+
+// generic implementation, also used for the last incomplete block
+static void convertU8_generic(const uint8_t * in, float * out, uint32_t len, const float * dc, int32_t * sum, float & level, float catt, float crel)
+{
+    int_fast32_t sumI = 0;
+    int_fast32_t sumQ = 0;
+    float lev = level;
+    float dcI = dc[0];
+    float dcQ = dc[1];
+
+    uint32_t k = 0;
+    while (k < len)
+    {
+        uint32_t blockEnd = k + INPUTDEVICEKERNELS_LEVEL_BLOCK;
+        if (blockEnd > len)
+        {
+            blockEnd = len;
+        }
+        int_fast32_t blockMax = 0;
+        for (; k < blockEnd; k += 2)
+        {
+            int_fast32_t tmpI = int_fast32_t(*in++) - 128;
+            int_fast32_t tmpQ = int_fast32_t(*in++) - 128;
+            int_fast32_t absI = std::abs(tmpI);
+            int_fast32_t absQ = std::abs(tmpQ);
+            if (absI > blockMax) { blockMax = absI; }
+            if (absQ > blockMax) { blockMax = absQ; }
+            sumI += tmpI;
+            sumQ += tmpQ;
+            *out++ = float(tmpI) - dcI;
+            *out++ = float(tmpQ) - dcQ;
+        }
+        updateLevel(lev, blockMax, catt, crel);
+    }
+
+    sum[0] += sumI;
+    sum[1] += sumQ;
+    level = lev;
+}
+
+static void convertS16_generic(const int16_t * in, float * out, uint32_t len, float scale)
+{
+    for (uint32_t k = 0; k < len; ++k)
+    {
+        *out++ = float(*in++) * scale;
+    }
+}
+
+static void convertS8_generic(const int8_t * in, float * out, uint32_t len, float scale)
+{
+    for (uint32_t k = 0; k < len; ++k)
+    {
+        *out++ = float(*in++) * scale;
+    }
+}
+
+static void convertU16_generic(const uint16_t * in, float * out, uint32_t len, float scale)
+{
+    for (uint32_t k = 0; k < len; ++k)
+    {
+        *out++ = float(int(*in++) - 32768) * scale;
+    }
+}
+
+static void convertS12P_generic(const uint8_t * in, float * out, uint32_t len, float scale)
+{
+    for (uint32_t k = 0; k < len; k += 2)
+    {   // 12 bit values are shifted to top of int16 and back to extend sign
+        uint16_t b0 = in[0];
+        uint16_t b1 = in[1];
+        uint16_t b2 = in[2];
+        *out++ = float(int16_t(uint16_t((b1 << 12) | (b0 << 4))) >> 4) * scale;
+        *out++ = float(int16_t(uint16_t((b2 << 8) | (b1 & 0xF0))) >> 4) * scale;
+        in += 3;
+    }
+}
+
+static void convertToS16_generic(const float * in, int16_t * out, uint32_t len, float scale)
+{
+    for (uint32_t k = 0; k < len; ++k)
+    {
+        float x = *in++ * scale;
+        if (x >= 32767.0f) { x = 32767.0f; }
+        if (x <= -32768.0f) { x = -32768.0f; }
+        *out++ = int16_t(x);
+    }
+}
+
+#if INPUTDEVICEKERNELS_SSE2
+static void convertU8_sse2(const uint8_t * in, float * out, uint32_t len, const float * dc, int32_t * sum, float & level, float catt, float crel)
+{
+    static_assert(INPUTDEVICEKERNELS_LEVEL_BLOCK == 32, "SSE2 kernel expects block of 32 values");
+
+    const __m128i offset = _mm_set1_epi8(char(0x80));
+    const __m128 dcIQ = _mm_setr_ps(dc[0], dc[1], dc[0], dc[1]);
+    __m128i sumIQ = _mm_setzero_si128();
+    float lev = level;
+
+    uint32_t numBlocks = len / INPUTDEVICEKERNELS_LEVEL_BLOCK;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m128i x[2];
+        x[0] = _mm_loadu_si128((const __m128i *) in);
+        x[1] = _mm_loadu_si128((const __m128i *) (in + 16));
+        in += INPUTDEVICEKERNELS_LEVEL_BLOCK;
+
+        // |x - 128| in unsigned arithmetic
+        __m128i abs0 = _mm_or_si128(_mm_subs_epu8(x[0], offset), _mm_subs_epu8(offset, x[0]));
+        __m128i abs1 = _mm_or_si128(_mm_subs_epu8(x[1], offset), _mm_subs_epu8(offset, x[1]));
+        __m128i m = _mm_max_epu8(abs0, abs1);
+        m = _mm_max_epu8(m, _mm_srli_si128(m, 8));
+        m = _mm_max_epu8(m, _mm_srli_si128(m, 4));
+        m = _mm_max_epu8(m, _mm_srli_si128(m, 2));
+        m = _mm_max_epu8(m, _mm_srli_si128(m, 1));
+        updateLevel(lev, _mm_cvtsi128_si32(m) & 0xFF, catt, crel);
+
+        for (int n = 0; n < 2; ++n)
+        {
+            __m128i s = _mm_xor_si128(x[n], offset);    // signed int8 x - 128
+            __m128i s16[2];
+            s16[0] = _mm_srai_epi16(_mm_unpacklo_epi8(s, s), 8);
+            s16[1] = _mm_srai_epi16(_mm_unpackhi_epi8(s, s), 8);
+            for (int h = 0; h < 2; ++h)
+            {
+                __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16[h], s16[h]), 16);
+                __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16[h], s16[h]), 16);
+                sumIQ = _mm_add_epi32(sumIQ, _mm_add_epi32(lo, hi));
+                _mm_storeu_ps(out, _mm_sub_ps(_mm_cvtepi32_ps(lo), dcIQ));
+                _mm_storeu_ps(out + 4, _mm_sub_ps(_mm_cvtepi32_ps(hi), dcIQ));
+                out += 8;
+            }
+        }
+    }
+
+    // lanes are [I Q I Q]
+    int32_t tmp[4];
+    _mm_storeu_si128((__m128i *) tmp, sumIQ);
+    sum[0] += tmp[0] + tmp[2];
+    sum[1] += tmp[1] + tmp[3];
+    level = lev;
+
+    uint32_t remaining = len - numBlocks * INPUTDEVICEKERNELS_LEVEL_BLOCK;
+    if (remaining > 0)
+    {
+        convertU8_generic(in, out, remaining, dc, sum, level, catt, crel);
+    }
+}
+
+static void convertS16_sse2(const int16_t * in, float * out, uint32_t len, float scale)
+{
+    const __m128 sc = _mm_set1_ps(scale);
+    uint32_t numBlocks = len / 8;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) in);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(lo), sc));
+        _mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), sc));
+        in += 8;
+        out += 8;
+    }
+    convertS16_generic(in, out, len - numBlocks * 8, scale);
+}
+
+static void convertS8_sse2(const int8_t * in, float * out, uint32_t len, float scale)
+{
+    const __m128 sc = _mm_set1_ps(scale);
+    uint32_t numBlocks = len / 16;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *) in);
+        __m128i s16[2];
+        s16[0] = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+        s16[1] = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+        for (int h = 0; h < 2; ++h)
+        {
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16[h], s16[h]), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16[h], s16[h]), 16);
+            _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(lo), sc));
+            _mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), sc));
+            out += 8;
+        }
+        in += 16;
+    }
+    convertS8_generic(in, out, len - numBlocks * 16, scale);
+}
+
+static void convertU16_sse2(const uint16_t * in, float * out, uint32_t len, float scale)
+{   // flipping MSB converts offset binary to int16
+    const __m128 sc = _mm_set1_ps(scale);
+    const __m128i msb = _mm_set1_epi16(int16_t(0x8000));
+    uint32_t numBlocks = len / 8;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *) in), msb);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(lo), sc));
+        _mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), sc));
+        in += 8;
+        out += 8;
+    }
+    convertU16_generic(in, out, len - numBlocks * 8, scale);
+}
+
+static void convertToS16_sse2(const float * in, int16_t * out, uint32_t len, float scale)
+{   // truncation and saturation
+    const __m128 sc = _mm_set1_ps(scale);
+    uint32_t numBlocks = len / 8;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m128i lo = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in), sc));
+        __m128i hi = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(in + 4), sc));
+        _mm_storeu_si128((__m128i *) out, _mm_packs_epi32(lo, hi));
+        in += 8;
+        out += 8;
+    }
+    convertToS16_generic(in, out, len - numBlocks * 8, scale);
+}
+#endif // INPUTDEVICEKERNELS_SSE2
+
+#if INPUTDEVICEKERNELS_AVX2
+__attribute__((target("avx2")))
+static void convertU8_avx2(const uint8_t * in, float * out, uint32_t len, const float * dc, int32_t * sum, float & level, float catt, float crel)
+{
+    static_assert(INPUTDEVICEKERNELS_LEVEL_BLOCK == 32, "AVX2 kernel expects block of 32 values");
+
+    const __m256i offset256 = _mm256_set1_epi8(char(0x80));
+    const __m128i offset = _mm_set1_epi8(char(0x80));
+    const __m256 dcIQ = _mm256_setr_ps(dc[0], dc[1], dc[0], dc[1], dc[0], dc[1], dc[0], dc[1]);
+    __m256i sumIQ = _mm256_setzero_si256();
+    float lev = level;
+
+    uint32_t numBlocks = len / INPUTDEVICEKERNELS_LEVEL_BLOCK;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *) in);
+
+        // |x - 128| in unsigned arithmetic
+        __m256i a = _mm256_or_si256(_mm256_subs_epu8(x, offset256), _mm256_subs_epu8(offset256, x));
+        __m128i m = _mm_max_epu8(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+        m = _mm_max_epu8(m, _mm_srli_si128(m, 8));
+        m = _mm_max_epu8(m, _mm_srli_si128(m, 4));
+        m = _mm_max_epu8(m, _mm_srli_si128(m, 2));
+        m = _mm_max_epu8(m, _mm_srli_si128(m, 1));
+        updateLevel(lev, _mm_cvtsi128_si32(m) & 0xFF, catt, crel);
+
+        for (int n = 0; n < 4; ++n)
+        {
+            __m128i s = _mm_xor_si128(_mm_loadl_epi64((const __m128i *) (in + 8*n)), offset);
+            __m256i s32 = _mm256_cvtepi8_epi32(s);
+            sumIQ = _mm256_add_epi32(sumIQ, s32);
+            _mm256_storeu_ps(out, _mm256_sub_ps(_mm256_cvtepi32_ps(s32), dcIQ));
+            out += 8;
+        }
+        in += INPUTDEVICEKERNELS_LEVEL_BLOCK;
+    }
+
+    // lanes are [I Q I Q I Q I Q]
+    int32_t tmp[8];
+    _mm256_storeu_si256((__m256i *) tmp, sumIQ);
+    sum[0] += tmp[0] + tmp[2] + tmp[4] + tmp[6];
+    sum[1] += tmp[1] + tmp[3] + tmp[5] + tmp[7];
+    level = lev;
+
+    uint32_t remaining = len - numBlocks * INPUTDEVICEKERNELS_LEVEL_BLOCK;
+    if (remaining > 0)
+    {
+        convertU8_generic(in, out, remaining, dc, sum, level, catt, crel);
+    }
+}
+
+__attribute__((target("avx2")))
+static void convertS16_avx2(const int16_t * in, float * out, uint32_t len, float scale)
+{
+    const __m256 sc = _mm256_set1_ps(scale);
+    uint32_t numBlocks = len / 16;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) in));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (in + 8)));
+        _mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), sc));
+        _mm256_storeu_ps(out + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), sc));
+        in += 16;
+        out += 16;
+    }
+    convertS16_generic(in, out, len - numBlocks * 16, scale);
+}
+
+__attribute__((target("avx2")))
+static void convertS8_avx2(const int8_t * in, float * out, uint32_t len, float scale)
+{
+    const __m256 sc = _mm256_set1_ps(scale);
+    uint32_t numBlocks = len / 16;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m256i lo = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *) in));
+        __m256i hi = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *) (in + 8)));
+        _mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), sc));
+        _mm256_storeu_ps(out + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), sc));
+        in += 16;
+        out += 16;
+    }
+    convertS8_generic(in, out, len - numBlocks * 16, scale);
+}
+
+__attribute__((target("avx2")))
+static void convertU16_avx2(const uint16_t * in, float * out, uint32_t len, float scale)
+{
+    const __m256 sc = _mm256_set1_ps(scale);
+    const __m128i msb = _mm_set1_epi16(int16_t(0x8000));
+    uint32_t numBlocks = len / 16;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m256i lo = _mm256_cvtepi16_epi32(_mm_xor_si128(_mm_loadu_si128((const __m128i *) in), msb));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm_xor_si128(_mm_loadu_si128((const __m128i *) (in + 8)), msb));
+        _mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), sc));
+        _mm256_storeu_ps(out + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), sc));
+        in += 16;
+        out += 16;
+    }
+    convertU16_generic(in, out, len - numBlocks * 16, scale);
+}
+
+__attribute__((target("avx2")))
+static void convertS12P_avx2(const uint8_t * in, float * out, uint32_t len, float scale)
+{   // 4 IQ pairs (12 bytes) per block, 16 bytes are loaded => last pairs are done by generic code
+    const __m256 sc = _mm256_set1_ps(scale);
+    // I = [b0 b1] << 4, Q = [b1 b2] & 0xFFF0, both are then shifted back with sign
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m128i maskI = _mm_set1_epi32(0x0000FFFF);
+    const __m128i maskQ = _mm_set1_epi32(int32_t(0xFFF00000));
+    uint32_t k = 0;
+    for ( ; k + 12 <= len; k += 8)
+    {
+        __m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) in), shuffle);
+        __m128i v = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(x, 4), maskI), _mm_and_si128(x, maskQ));
+        v = _mm_srai_epi16(v, 4);
+        _mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)), sc));
+        in += 12;
+        out += 8;
+    }
+    convertS12P_generic(in, out, len - k, scale);
+}
+
+__attribute__((target("avx2")))
+static void convertToS16_avx2(const float * in, int16_t * out, uint32_t len, float scale)
+{
+    const __m256 sc = _mm256_set1_ps(scale);
+    uint32_t numBlocks = len / 16;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        __m256i lo = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in), sc));
+        __m256i hi = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in + 8), sc));
+        // pack works in 128-bit lanes => restore order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256((__m256i *) out, packed);
+        in += 16;
+        out += 16;
+    }
+    convertToS16_generic(in, out, len - numBlocks * 16, scale);
+}
+#endif // INPUTDEVICEKERNELS_AVX2
+
+#if INPUTDEVICEKERNELS_NEON
+static void convertU8_neon(const uint8_t * in, float * out, uint32_t len, const float * dc, int32_t * sum, float & level, float catt, float crel)
+{
+    static_assert(INPUTDEVICEKERNELS_LEVEL_BLOCK == 32, "NEON kernel expects block of 32 values");
+
+    const uint8x16_t offset = vdupq_n_u8(0x80);
+    const float dcArray[4] = { dc[0], dc[1], dc[0], dc[1] };
+    const float32x4_t dcIQ = vld1q_f32(dcArray);
+    int32x4_t sumIQ = vdupq_n_s32(0);
+    float lev = level;
+
+    uint32_t numBlocks = len / INPUTDEVICEKERNELS_LEVEL_BLOCK;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        uint8x16_t x[2];
+        x[0] = vld1q_u8(in);
+        x[1] = vld1q_u8(in + 16);
+        in += INPUTDEVICEKERNELS_LEVEL_BLOCK;
+
+        uint8x16_t m = vmaxq_u8(vabdq_u8(x[0], offset), vabdq_u8(x[1], offset));
+        updateLevel(lev, vmaxvq_u8(m), catt, crel);
+
+        for (int n = 0; n < 2; ++n)
+        {
+            int8x16_t s = vreinterpretq_s8_u8(veorq_u8(x[n], offset));  // signed int8 x - 128
+            int16x8_t s16[2] = { vmovl_s8(vget_low_s8(s)), vmovl_s8(vget_high_s8(s)) };
+            for (int h = 0; h < 2; ++h)
+            {
+                int32x4_t lo = vmovl_s16(vget_low_s16(s16[h]));
+                int32x4_t hi = vmovl_s16(vget_high_s16(s16[h]));
+                sumIQ = vaddq_s32(sumIQ, vaddq_s32(lo, hi));
+                vst1q_f32(out, vsubq_f32(vcvtq_f32_s32(lo), dcIQ));
+                vst1q_f32(out + 4, vsubq_f32(vcvtq_f32_s32(hi), dcIQ));
+                out += 8;
+            }
+        }
+    }
+
+    // lanes are [I Q I Q]
+    sum[0] += vgetq_lane_s32(sumIQ, 0) + vgetq_lane_s32(sumIQ, 2);
+    sum[1] += vgetq_lane_s32(sumIQ, 1) + vgetq_lane_s32(sumIQ, 3);
+    level = lev;
+
+    uint32_t remaining = len - numBlocks * INPUTDEVICEKERNELS_LEVEL_BLOCK;
+    if (remaining > 0)
+    {
+        convertU8_generic(in, out, remaining, dc, sum, level, catt, crel);
+    }
+}
+
+static void convertS16_neon(const int16_t * in, float * out, uint32_t len, float scale)
+{
+    uint32_t numBlocks = len / 8;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        int16x8_t x = vld1q_s16(in);
+        vst1q_f32(out, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+        vst1q_f32(out + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+        in += 8;
+        out += 8;
+    }
+    convertS16_generic(in, out, len - numBlocks * 8, scale);
+}
+
+static void convertS8_neon(const int8_t * in, float * out, uint32_t len, float scale)
+{
+    uint32_t numBlocks = len / 16;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        int8x16_t x = vld1q_s8(in);
+        int16x8_t s16[2] = { vmovl_s8(vget_low_s8(x)), vmovl_s8(vget_high_s8(x)) };
+        for (int h = 0; h < 2; ++h)
+        {
+            vst1q_f32(out, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s16[h]))), scale));
+            vst1q_f32(out + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s16[h]))), scale));
+            out += 8;
+        }
+        in += 16;
+    }
+    convertS8_generic(in, out, len - numBlocks * 16, scale);
+}
+
+static void convertU16_neon(const uint16_t * in, float * out, uint32_t len, float scale)
+{   // flipping MSB converts offset binary to int16
+    const uint16x8_t msb = vdupq_n_u16(0x8000);
+    uint32_t numBlocks = len / 8;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        int16x8_t x = vreinterpretq_s16_u16(veorq_u16(vld1q_u16(in), msb));
+        vst1q_f32(out, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+        vst1q_f32(out + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+        in += 8;
+        out += 8;
+    }
+    convertU16_generic(in, out, len - numBlocks * 8, scale);
+}
+
+static void convertS12P_neon(const uint8_t * in, float * out, uint32_t len, float scale)
+{   // 8 IQ pairs per block, bytes are deinterleaved by structured load
+    uint32_t numBlocks = len / 16;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        uint8x8x3_t x = vld3_u8(in);
+        uint16x8_t b0 = vmovl_u8(x.val[0]);
+        uint16x8_t b1 = vmovl_u8(x.val[1]);
+        uint16x8_t b2 = vmovl_u8(x.val[2]);
+        int16x8_t i = vshrq_n_s16(vreinterpretq_s16_u16(vorrq_u16(vshlq_n_u16(b1, 12), vshlq_n_u16(b0, 4))), 4);
+        int16x8_t q = vshrq_n_s16(vreinterpretq_s16_u16(vorrq_u16(vshlq_n_u16(b2, 8), vandq_u16(b1, vdupq_n_u16(0xF0)))), 4);
+        float32x4x2_t lo = { vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(i))), scale),
+                             vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(q))), scale) };
+        float32x4x2_t hi = { vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(i))), scale),
+                             vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(q))), scale) };
+        // interleaving store restores IQ order
+        vst2q_f32(out, lo);
+        vst2q_f32(out + 8, hi);
+        in += 24;
+        out += 16;
+    }
+    convertS12P_generic(in, out, len - numBlocks * 16, scale);
+}
+
+static void convertToS16_neon(const float * in, int16_t * out, uint32_t len, float scale)
+{
+    uint32_t numBlocks = len / 8;
+    for (uint32_t b = 0; b < numBlocks; ++b)
+    {
+        int32x4_t lo = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(in), scale));
+        int32x4_t hi = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(in + 4), scale));
+        vst1q_s16(out, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+        in += 8;
+        out += 8;
+    }
+    convertToS16_generic(in, out, len - numBlocks * 8, scale);
+}
+#endif // INPUTDEVICEKERNELS_NEON
+
+InputDeviceKernels::Implementation InputDeviceKernels::selectImplementation()
+{
+#if INPUTDEVICEKERNELS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return Implementation { "AVX2", convertU8_avx2, convertS16_avx2, convertS8_avx2, convertU16_avx2, convertS12P_avx2, convertToS16_avx2 };
+    }
+#endif
+#if INPUTDEVICEKERNELS_SSE2
+    return Implementation { "SSE2", convertU8_sse2, convertS16_sse2, convertS8_sse2, convertU16_sse2, convertS12P_generic, convertToS16_sse2 };
+#elif INPUTDEVICEKERNELS_NEON
+    return Implementation { "NEON", convertU8_neon, convertS16_neon, convertS8_neon, convertU16_neon, convertS12P_neon, convertToS16_neon };
+#else
+    return Implementation { "generic", convertU8_generic, convertS16_generic, convertS8_generic, convertU16_generic, convertS12P_generic, convertToS16_generic };
+#endif
+}
+
+const InputDeviceKernels::Implementation & InputDeviceKernels::implementation()
+{   // selected on first use
+    static const Implementation impl = selectImplementation();
+    return impl;
+}
+
+void InputDeviceKernels::convertU8(const uint8_t *in, float *out, uint32_t len, const float dc[], int32_t sum[], float &level, float catt, float crel)
+{
+    implementation().convertU8(in, out, len, dc, sum, level, catt, crel);
+}
+
+void InputDeviceKernels::convertS16(const int16_t *in, float *out, uint32_t len, float scale)
+{
+    implementation().convertS16(in, out, len, scale);
+}
+
+void InputDeviceKernels::convertS8(const int8_t *in, float *out, uint32_t len, float scale)
+{
+    implementation().convertS8(in, out, len, scale);
+}
+
+void InputDeviceKernels::convertU16(const uint16_t *in, float *out, uint32_t len, float scale)
+{
+    implementation().convertU16(in, out, len, scale);
+}
+
+void InputDeviceKernels::convertS12P(const uint8_t *in, float *out, uint32_t len, float scale)
+{
+    implementation().convertS12P(in, out, len, scale);
+}
+
+void InputDeviceKernels::convertToS16(const float *in, int16_t *out, uint32_t len, float scale)
+{
+    implementation().convertToS16(in, out, len, scale);
+}
+
+const char *InputDeviceKernels::implementationName()
+{
+    return implementation().name;
+}
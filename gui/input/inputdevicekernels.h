@@ -0,0 +1,89 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef INPUTDEVICEKERNELS_H
+#define INPUTDEVICEKERNELS_H
+
+#include <cstdint>
+
+// signal level is estimated on blocks of values (I and Q), maximum of the block is used
+#define INPUTDEVICEKERNELS_LEVEL_BLOCK  32
+
+// low level sample processing used by input devices
+// implementation is selected in runtime according to CPU capabilities (SSE2, AVX2, NEON or generic C++)
+class InputDeviceKernels
+{
+public:
+    // converts uint8 IQ samples to float and subtracts DC (dc[0] = I, dc[1] = Q)
+    // sum of converted I and Q values is returned in sum[0] and sum[1] (for DC estimation)
+    // signal level is updated using rectifier with fast attack and slow release per value (catt, crel)
+    //   applied to block maximums
+    // len is number of values (I or Q), it must be even
+    static void convertU8(const uint8_t * in, float * out, uint32_t len, const float dc[2], int32_t sum[2],
+                          float & level, float catt, float crel);
+
+    // converts signed int16 / int8 IQ samples to float multiplied by scale
+    // len is number of values (I or Q)
+    static void convertS16(const int16_t * in, float * out, uint32_t len, float scale);
+    static void convertS8(const int8_t * in, float * out, uint32_t len, float scale);
+
+    // converts offset binary uint16 IQ samples to float multiplied by scale (32768 is zero)
+    // len is number of values (I or Q)
+    static void convertU16(const uint16_t * in, float * out, uint32_t len, float scale);
+
+    // converts packed signed 12 bit IQ samples to float multiplied by scale
+    // IQ pair is packed in 3 bytes: [I[7:0]] [Q[3:0] I[11:8]] [Q[11:4]]
+    // len is number of values (I or Q), it must be even
+    static void convertS12P(const uint8_t * in, float * out, uint32_t len, float scale);
+
+    // converts float values to int16 multiplied by scale with saturation (used for recording)
+    static void convertToS16(const float * in, int16_t * out, uint32_t len, float scale);
+
+    // returns name of selected implementation
+    static const char * implementationName();
+
+private:
+    typedef void (*convertU8Fcn_t)(const uint8_t *, float *, uint32_t, const float *, int32_t *, float &, float, float);
+    typedef void (*convertS16Fcn_t)(const int16_t *, float *, uint32_t, float);
+    typedef void (*convertS8Fcn_t)(const int8_t *, float *, uint32_t, float);
+    typedef void (*convertU16Fcn_t)(const uint16_t *, float *, uint32_t, float);
+    typedef void (*convertS12PFcn_t)(const uint8_t *, float *, uint32_t, float);
+    typedef void (*convertToS16Fcn_t)(const float *, int16_t *, uint32_t, float);
+    struct Implementation
+    {
+        const char * name;
+        convertU8Fcn_t convertU8;
+        convertS16Fcn_t convertS16;
+        convertS8Fcn_t convertS8;
+        convertU16Fcn_t convertU16;
+        convertS12PFcn_t convertS12P;
+        convertToS16Fcn_t convertToS16;
+    };
+    static const Implementation & implementation();
+    static Implementation selectImplementation();
+};
+
+#endif // INPUTDEVICEKERNELS_H
@@ -27,7 +27,15 @@
 #include <QDir>
 #include <QFileDialog>
 #include <QLoggingCategory>
+#include <algorithm>
+#include <cstring>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
 #include "inputdevicerecorder.h"
+#include "rawfilecodec.h"
 #include "dabtables.h"
 #include "config.h"
 
@@ -35,13 +43,25 @@ Q_LOGGING_CATEGORY(inputDeviceRecorder, "InputDeviceRecorder", QtInfoMsg)
 
 InputDeviceRecorder::InputDeviceRecorder()
 {
+#if defined(_WIN32)
     m_file = nullptr;
+    m_nextFile = nullptr;
+#else
+    m_fd = -1;
+    m_nextFd = -1;
+#endif
+    for (int n = 0; n < INPUTDEVICERECORDER_NUM_BLOCKS; ++n)
+    {
+        m_blocks[n].data = nullptr;
+        m_blocks[n].used = 0;
+    }
     m_recordingPath = QDir::homePath();
 }
 
 InputDeviceRecorder::~InputDeviceRecorder()
 {
     stop();
+    freeFlightBuffer();
 }
 
 const QString InputDeviceRecorder::recordingPath() const
@@ -54,8 +74,19 @@ void InputDeviceRecorder::setRecordingPath(const QString &recordingPath)
     m_recordingPath = recordingPath;
 }
 
+QString InputDeviceRecorder::partFileName(const QString &fileName, int part)
+{
+    QFileInfo fileInfo(fileName);
+    QString suffix = fileInfo.suffix().isEmpty() ? QString() : ("." + fileInfo.suffix());
+    return QString("%1/%2%3%4%5").arg(fileInfo.path(), fileInfo.completeBaseName(), INPUTDEVICERECORDER_PART_SUFFIX)
+        .arg(part, INPUTDEVICERECORDER_PART_DIGITS, 10, QChar('0'))
+        .arg(suffix);
+}
+
 void InputDeviceRecorder::setDeviceDescription(const InputDeviceDescription &desc)
 {
+    // description is used by flight recorder dump
+    freeFlightBuffer();
     m_deviceDescription = desc;
 
     // 1 / (2 channels(IQ) * channel containerBits/8.0 * sampleRate/1000.0)
@@ -64,22 +95,39 @@ void InputDeviceRecorder::setDeviceDescription(const InputDeviceDescription &des
     qCDebug(inputDeviceRecorder) << "name:" << m_deviceDescription.device.name;
     qCDebug(inputDeviceRecorder) << "model:" << m_deviceDescription.device.model;
     qCDebug(inputDeviceRecorder) << "sampleRate:" << m_deviceDescription.sample.sampleRate;
+    qCDebug(inputDeviceRecorder) << "inputSampleRate:" << m_deviceDescription.sample.inputSampleRate;
     qCDebug(inputDeviceRecorder) << "channelBits:" << m_deviceDescription.sample.channelBits;
     qCDebug(inputDeviceRecorder) << "channelContainer:" << m_deviceDescription.sample.channelContainer;
+
+    // buffer size depends on sample rate and format
+    allocFlightBuffer();
 }
 
 void InputDeviceRecorder::start(QWidget * callerWidget)
 {  
     std::lock_guard<std::mutex> guard(m_fileMutex);
-    if (nullptr == m_file)
+    if (!m_isActive)
     {
         // dialog needs parrent => prvided from caller widget
         QString fileName;
-        if (m_xmlHeaderEna)
+        m_isCompressed = m_compressionEna;
+        m_hasXmlHeader = m_xmlHeaderEna || m_isCompressed;   // compressed file cannot be used without header
+        if (m_isCompressed)
+        {
+            QString f = QString("%1/%2_%3.uffz").arg(m_recordingPath,
+                                                     QDateTime::currentDateTime().toString("yyyy-MM-dd_hhmmss"),
+                                                     DabTables::channelName(m_frequency));
+
+            fileName = QFileDialog::getSaveFileName(callerWidget,
+                                                    tr("Record IQ stream (Compressed)"),
+                                                    QDir::toNativeSeparators(f),
+                                                    tr("Compressed binary XML files")+" (*.uffz)");
+        }
+        else if (m_hasXmlHeader)
         {
             QString f = QString("%1/%2_%3.uff").arg(m_recordingPath,
                                                     QDateTime::currentDateTime().toString("yyyy-MM-dd_hhmmss"),
-                                                    DabTables::channelList.value(m_frequency));
+                                                    DabTables::channelName(m_frequency));
 
             fileName = QFileDialog::getSaveFileName(callerWidget,
                                                     tr("Record IQ stream (Raw File XML Header)"),
@@ -90,7 +138,7 @@ void InputDeviceRecorder::start(QWidget * callerWidget)
         {
             QString f = QString("%1/%2_%3.raw").arg(m_recordingPath,
                                                     QDateTime::currentDateTime().toString("yyyy-MM-dd_hhmmss"),
-                                                    DabTables::channelList.value(m_frequency));
+                                                    DabTables::channelName(m_frequency));
 
             fileName = QFileDialog::getSaveFileName(callerWidget,
                                                     tr("Record IQ stream"),
@@ -100,16 +148,68 @@ void InputDeviceRecorder::start(QWidget * callerWidget)
         if (!fileName.isEmpty())
         {
             m_bytesRecorded = 0;
+            m_bytesDropped = 0;
             m_recordingPath = QFileInfo(fileName).path(); // store path for next time
+            m_fileName = fileName;
+
+            // split limit is aligned to compressed chunk or IO block so that parts never split IQ sample
+            const uint64_t bytesPerSec = 2 * uint64_t(m_deviceDescription.sample.containerBits / 8) * m_deviceDescription.sample.sampleRate;
+            m_splitBytes = (m_splitSizeMB > 0) ? (uint64_t(m_splitSizeMB) << 20) : 0;
+            if (m_splitMinutes > 0)
+            {
+                uint64_t bytes = uint64_t(m_splitMinutes) * 60 * bytesPerSec;
+                m_splitBytes = (m_splitBytes > 0) ? std::min(m_splitBytes, bytes) : bytes;
+            }
+            else { /* no time limit */ }
+            if (m_splitBytes > 0)
+            {
+                uint64_t align = m_isCompressed ? (RAWFILECODEC_CHUNK_VALUES * (m_deviceDescription.sample.containerBits / 8))
+                                                : INPUTDEVICERECORDER_ALIGNMENT;
+                m_splitBytes = std::max(align, (m_splitBytes / align) * align);
+                m_part = 1;
+            }
+            else
+            {
+                m_part = 0;
+            }
 
-            m_file = fopen(QDir::toNativeSeparators(fileName).toUtf8().data(), "wb");
-            if (nullptr != m_file)
+            if (openFile((m_part > 0) ? partFileName(m_fileName, m_part) : m_fileName))
             {
-                startXmlHeader();
+                activateNextFile();
+                if ((m_part > 0) && !openFile(partFileName(m_fileName, m_part + 1)))
+                {   // retried when the part is finished
+                    qCWarning(inputDeviceRecorder) << "Unable to prepare next part of recording";
+                }
+                else { /* next part is ready */ }
+
+                for (int n = 0; n < INPUTDEVICERECORDER_NUM_BLOCKS; ++n)
+                {
+                    m_blocks[n].data = new ( std::align_val_t(INPUTDEVICERECORDER_ALIGNMENT) ) uint8_t[INPUTDEVICERECORDER_BLOCK_SIZE];
+                    m_blocks[n].used = 0;
+                }
+                m_fillIdx = 0;
+                m_writeIdx = 0;
+                m_numFull = 0;
+                m_writerExit = false;
+                m_bytesWritten = 0;
+                m_fileBytesWritten = 0;
+                m_writeError = false;
+                m_fileOffset = m_hasXmlHeader ? INPUTDEVICERECORDER_XML_PADDING : 0;
+                m_chunkBuffer.clear();
+                m_chunkIndex.clear();
+                m_startTime = QDateTime::currentDateTimeUtc();
+                startXmlHeader(m_startTime);
+                m_writerThread = new std::thread(&InputDeviceRecorder::writerThread, this);
+
+                m_progressTime = std::chrono::steady_clock::now();
+                m_isActive = true;
+
                 emit recording(true);
+                emit deviceRecording(true);
             }
             else
             {   // error
+                qCCritical(inputDeviceRecorder) << "Unable to open file:" << fileName;
                 emit recording(false);
             }
         }
@@ -126,47 +226,425 @@ void InputDeviceRecorder::start(QWidget * callerWidget)
 
 void InputDeviceRecorder::stop()
 {
-    std::lock_guard<std::mutex> guard(m_fileMutex);
-    if (nullptr != m_file)
     {
-        if (m_xmlHeaderEna)
+        std::lock_guard<std::mutex> guard(m_fileMutex);
+        if (!m_isActive)
         {
-            finishXmlHeader();
-
-            // write xml header
-            QByteArray bytearray = m_xmlHeader.toByteArray();
-            fseek(m_file, 0, SEEK_SET);
-            fwrite(bytearray.data(), 1, bytearray.size(), m_file);
+            return;
+        }
+        m_isActive = false;
 
-            // add padding
-            int paddingBytes = INPUTDEVICERECORDER_XML_PADDING - bytearray.size();
-            char * padding = new char[paddingBytes];
-            memset(padding, 0, paddingBytes);
-            fwrite(padding, 1, paddingBytes, m_file);
-            delete [] padding;
+        // last partial block
+        if (m_blocks[m_fillIdx].used > 0)
+        {
+            pushBlock(true);
         }
-        else { /* XML header is not enabled */ }
-        fflush(m_file);
-        fclose(m_file);
-        m_file = nullptr;
+    }
+
+    // wait for writer thread to write all pending blocks
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_writerExit = true;
+    }
+    m_queueCondition.notify_all();
+    m_writerThread->join();
+    delete m_writerThread;
+    m_writerThread = nullptr;
+
+    for (int n = 0; n < INPUTDEVICERECORDER_NUM_BLOCKS; ++n)
+    {
+        operator delete [] (m_blocks[n].data, std::align_val_t(INPUTDEVICERECORDER_ALIGNMENT));
+        m_blocks[n].data = nullptr;
+    }
+
+    if (m_bytesDropped > 0)
+    {
+        qCWarning(inputDeviceRecorder) << "Storage too slow," << m_bytesDropped << "bytes were not recorded";
+    }
+
+    closeFile();
+    closeNextFile();
 
-        emit recording(false);
+    emit bytesRecorded(m_bytesWritten, m_bytesWritten * m_bytes2ms);
+    emit recording(false);
+    if (!isFlightRecorderEnabled())
+    {
+        emit deviceRecording(false);
     }
+    else { /* flight recorder still needs samples */ }
 }
 
 void InputDeviceRecorder::writeBuffer(const uint8_t *buf, uint32_t len)
-{
+{   // called from input device thread, data is only copied to current block
     std::lock_guard<std::mutex> guard(m_fileMutex);
 
-    if (nullptr != m_file)
+    writeFlightBuffer(buf, len);
+
+    if (!m_isActive)
+    {
+        return;
+    }
+
+    while (len > 0)
     {
-        ssize_t bytes = fwrite(buf, 1, len, m_file);
+        Block & block = m_blocks[m_fillIdx];
+        uint32_t bytes = std::min(len, INPUTDEVICERECORDER_BLOCK_SIZE - block.used);
+        memcpy(block.data + block.used, buf, bytes);
+        block.used += bytes;
+        buf += bytes;
+        len -= bytes;
         m_bytesRecorded += bytes;
+
+        if (INPUTDEVICERECORDER_BLOCK_SIZE == block.used)
+        {
+            pushBlock(false);
+        }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_progressTime >= std::chrono::milliseconds(INPUTDEVICERECORDER_PROGRESS_MS))
+    {
+        m_progressTime = now;
         emit bytesRecorded(m_bytesRecorded, m_bytesRecorded * m_bytes2ms);
     }
 }
 
-void InputDeviceRecorder::startXmlHeader()
+void InputDeviceRecorder::pushBlock(bool waitForSpace)
+{   // m_fileMutex is locked by caller
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    if (waitForSpace)
+    {
+        m_queueCondition.wait(lock, [this]() { return m_numFull < INPUTDEVICERECORDER_NUM_BLOCKS - 1; });
+    }
+
+    if (m_numFull < INPUTDEVICERECORDER_NUM_BLOCKS - 1)
+    {   // next block is free
+        m_numFull += 1;
+        m_fillIdx = (m_fillIdx + 1) % INPUTDEVICERECORDER_NUM_BLOCKS;
+        m_blocks[m_fillIdx].used = 0;
+        lock.unlock();
+        m_queueCondition.notify_all();
+    }
+    else
+    {   // writer is still busy with all other blocks
+        // data is dropped, input device must never wait for storage
+        Block & block = m_blocks[m_fillIdx];
+        qCWarning(inputDeviceRecorder) << "Writing to file is too slow, dropping" << block.used << "bytes";
+        m_bytesDropped += block.used;
+        m_bytesRecorded -= block.used;
+        block.used = 0;
+    }
+}
+
+void InputDeviceRecorder::writerThread()
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    while (true)
+    {
+        m_queueCondition.wait(lock, [this]() { return (m_numFull > 0) || m_writerExit; });
+        if (0 == m_numFull)
+        {   // exit requested and all blocks were written
+            break;
+        }
+
+        const Block & block = m_blocks[m_writeIdx];
+        lock.unlock();
+
+        const uint8_t * data = block.data;
+        uint32_t len = block.used;
+        while ((len > 0) && !m_writeError)
+        {   // block can span two parts
+            uint32_t bytes = (m_splitBytes > 0) ? std::min<uint64_t>(len, m_splitBytes - m_fileBytesWritten) : len;
+            if (writeBlock(data, bytes))
+            {
+                m_bytesWritten += bytes;
+                m_fileBytesWritten += bytes;
+                data += bytes;
+                len -= bytes;
+            }
+            else
+            {
+                qCCritical(inputDeviceRecorder) << "Error writing to file, recording is incomplete";
+                m_writeError = true;
+            }
+
+            if ((m_splitBytes > 0) && (m_fileBytesWritten >= m_splitBytes) && !nextPart())
+            {
+                qCCritical(inputDeviceRecorder) << "Unable to open next part, recording continues in" << partFileName(m_fileName, m_part);
+                m_splitBytes = 0;
+            }
+            else { /* continue in current part */ }
+        }
+
+        lock.lock();
+        m_writeIdx = (m_writeIdx + 1) % INPUTDEVICERECORDER_NUM_BLOCKS;
+        m_numFull -= 1;
+        m_queueCondition.notify_all();
+    }
+}
+
+bool InputDeviceRecorder::openFile(const QString &fileName)
+{   // data starts after XML header, header is written when recording stops
+    // file is opened as next file, activateNextFile() makes it current
+    QByteArray path = QDir::toNativeSeparators(fileName).toUtf8();
+    int64_t dataOffset = m_hasXmlHeader ? INPUTDEVICERECORDER_XML_PADDING : 0;
+#if defined(_WIN32)
+    FILE * file = fopen(path.data(), "wb");
+    if (nullptr == file)
+    {
+        return false;
+    }
+    // blocks are large, stdio buffering would only add one more copy
+    setvbuf(file, NULL, _IONBF, 0);
+    fseek(file, dataOffset, SEEK_SET);
+    m_nextFile = file;
+#else
+    int fd;
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#if INPUTDEVICERECORDER_DIRECT_IO && defined(O_DIRECT)
+    // compressed chunks have arbitrary size, direct IO would fail on alignment
+    fd = open(path.data(), m_isCompressed ? flags : (flags | O_DIRECT), 0644);
+    if ((fd < 0) && (EINVAL == errno))
+    {   // file system does not support direct IO
+        fd = open(path.data(), flags, 0644);
+    }
+#else
+    fd = open(path.data(), flags, 0644);
+#endif
+    if (fd < 0)
+    {
+        return false;
+    }
+#if INPUTDEVICERECORDER_DIRECT_IO && defined(F_NOCACHE)
+    fcntl(fd, F_NOCACHE, 1);
+#endif
+    lseek(fd, dataOffset, SEEK_SET);
+    m_nextFd = fd;
+#endif
+    m_nextFileName = fileName;
+    return true;
+}
+
+void InputDeviceRecorder::activateNextFile()
+{
+#if defined(_WIN32)
+    m_file = m_nextFile;
+    m_nextFile = nullptr;
+#else
+    m_fd = m_nextFd;
+    m_nextFd = -1;
+#endif
+    m_nextFileName.clear();
+}
+
+bool InputDeviceRecorder::nextPart()
+{   // writer thread, current part is complete
+#if defined(_WIN32)
+    bool isOpen = (nullptr != m_nextFile);
+#else
+    bool isOpen = (m_nextFd >= 0);
+#endif
+    if (!isOpen && !openFile(partFileName(m_fileName, m_part + 1)))
+    {   // current part stays opened
+        return false;
+    }
+    else { /* next part is ready */ }
+
+    closeFile();
+    activateNextFile();
+    m_part += 1;
+    m_fileBytesWritten = 0;
+    m_fileOffset = m_hasXmlHeader ? INPUTDEVICERECORDER_XML_PADDING : 0;
+    m_chunkIndex.clear();
+
+    // time of the first sample in part
+    startXmlHeader(m_startTime.addMSecs(m_bytesWritten * m_bytes2ms));
+    qCInfo(inputDeviceRecorder) << "Recording continues in" << partFileName(m_fileName, m_part);
+
+    if (!openFile(partFileName(m_fileName, m_part + 1)))
+    {   // retried when the part is finished
+        qCWarning(inputDeviceRecorder) << "Unable to prepare next part of recording";
+    }
+    else { /* next part is ready */ }
+
+    return true;
+}
+
+void InputDeviceRecorder::closeNextFile()
+{   // pre-opened part was not used
+#if defined(_WIN32)
+    if (nullptr == m_nextFile)
+    {
+        return;
+    }
+    fclose(m_nextFile);
+    m_nextFile = nullptr;
+#else
+    if (m_nextFd < 0)
+    {
+        return;
+    }
+    close(m_nextFd);
+    m_nextFd = -1;
+#endif
+    QFile::remove(m_nextFileName);
+    m_nextFileName.clear();
+}
+
+bool InputDeviceRecorder::writeData(const uint8_t *data, uint32_t len)
+{
+#if defined(_WIN32)
+    return (len == fwrite(data, 1, len, m_file));
+#else
+    while (len > 0)
+    {
+        ssize_t bytes = ::write(m_fd, data, len);
+        if (bytes < 0)
+        {
+            int err = errno;
+            if (EINTR == err)
+            {
+                continue;
+            }
+#if defined(O_DIRECT)
+            int flags = fcntl(m_fd, F_GETFL);
+            if ((EINVAL == err) && (flags & O_DIRECT))
+            {   // size or offset not aligned for direct IO (typically last block) -> continue buffered
+                fcntl(m_fd, F_SETFL, flags & ~O_DIRECT);
+                continue;
+            }
+#endif
+            return false;
+        }
+        data += bytes;
+        len -= bytes;
+    }
+    return true;
+#endif
+}
+
+bool InputDeviceRecorder::writeBlock(const uint8_t *data, uint32_t len)
+{   // writer thread
+    if (!m_isCompressed)
+    {
+        if (!writeData(data, len))
+        {
+            return false;
+        }
+        m_fileOffset += len;
+        return true;
+    }
+
+    // complete chunks are compressed and written, remaining data waits for next block
+    const uint32_t chunkBytes = RAWFILECODEC_CHUNK_VALUES * (m_deviceDescription.sample.containerBits / 8);
+    while (len > 0)
+    {
+        uint32_t bytes = std::min<uint32_t>(len, chunkBytes - m_chunkBuffer.size());
+        m_chunkBuffer.insert(m_chunkBuffer.end(), data, data + bytes);
+        data += bytes;
+        len -= bytes;
+        if ((chunkBytes == m_chunkBuffer.size()) && !writeChunk())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool InputDeviceRecorder::writeChunk()
+{
+    const int containerBits = m_deviceDescription.sample.containerBits;
+    uint32_t numValues = m_chunkBuffer.size() / (containerBits / 8);
+    m_chunkEncoded.clear();
+    RawFileCodec::encode(m_chunkBuffer.data(), numValues, containerBits, INPUTDEVICERECORDER_COMPRESSION_DISCARD_BITS, m_chunkEncoded);
+    m_chunkBuffer.clear();
+
+    if (!writeData(m_chunkEncoded.data(), m_chunkEncoded.size()))
+    {
+        return false;
+    }
+    m_chunkIndex.push_back(m_fileOffset);
+    m_fileOffset += m_chunkEncoded.size();
+    return true;
+}
+
+void InputDeviceRecorder::closeFile()
+{
+    if (m_isCompressed && !m_writeError)
+    {   // last partial chunk, index and footer
+        if (!m_chunkBuffer.empty())
+        {
+            m_writeError = !writeChunk();
+        }
+        std::vector<uint8_t> index;
+        for (const auto & offset : m_chunkIndex)
+        {
+            for (int n = 0; n < 8; ++n)
+            {
+                index.push_back(uint8_t(offset >> (8*n)));
+            }
+        }
+        uint64_t footer[2] = { m_fileOffset, (uint64_t(RAWFILECODEC_INDEX_MAGIC) << 32) | m_chunkIndex.size() };
+        for (const auto & val : footer)
+        {
+            for (int n = 0; n < 8; ++n)
+            {
+                index.push_back(uint8_t(val >> (8*n)));
+            }
+        }
+        if (m_writeError || !writeData(index.data(), index.size()))
+        {
+            qCCritical(inputDeviceRecorder) << "Error writing compressed file index";
+        }
+    }
+
+    QByteArray bytearray;
+    if (m_hasXmlHeader)
+    {
+        finishXmlHeader();
+
+        // xml header with padding
+        bytearray = m_xmlHeader.toByteArray();
+        bytearray.append(QByteArray(INPUTDEVICERECORDER_XML_PADDING - bytearray.size(), 0));
+    }
+    else { /* XML header is not enabled */ }
+
+#if defined(_WIN32)
+    if (!bytearray.isEmpty())
+    {
+        fseek(m_file, 0, SEEK_SET);
+        fwrite(bytearray.data(), 1, bytearray.size(), m_file);
+    }
+    fflush(m_file);
+    fclose(m_file);
+    m_file = nullptr;
+#else
+    if (!bytearray.isEmpty())
+    {
+#if defined(O_DIRECT)
+        fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+#endif
+        if (bytearray.size() != pwrite(m_fd, bytearray.data(), bytearray.size(), 0))
+        {
+            qCCritical(inputDeviceRecorder) << "Error writing XML header";
+        }
+    }
+    close(m_fd);
+    m_fd = -1;
+#endif
+}
+
+void InputDeviceRecorder::startXmlHeader(const QDateTime &time)
+{
+    m_xmlHeader = createXmlHeader(time, m_isCompressed);
+}
+
+void InputDeviceRecorder::finishXmlHeader()
+{
+    appendDatablock(m_xmlHeader, m_fileBytesWritten, m_frequency);
+}
+
+QDomDocument InputDeviceRecorder::createXmlHeader(const QDateTime &time, bool isCompressed) const
 {
     QDomDocument xmlHeader;
     QDomProcessingInstruction header = xmlHeader.createProcessingInstruction("xml", "version=\"1.0\" encoding=\"utf-8\"");
@@ -184,10 +662,10 @@ void InputDeviceRecorder::startXmlHeader()
     device.setAttribute("Model", m_deviceDescription.device.model);
     root.appendChild(device);
 
-    QDomElement time = xmlHeader.createElement("Time");
-    time.setAttribute("Value", QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss"));
-    time.setAttribute("Unit", "UTC");
-    root.appendChild(time);
+    QDomElement timeElement = xmlHeader.createElement("Time");
+    timeElement.setAttribute("Value", time.toString("yyyy-MM-dd hh:mm:ss"));
+    timeElement.setAttribute("Unit", "UTC");
+    root.appendChild(timeElement);
 
     QDomElement sample = xmlHeader.createElement("Sample");
     QDomElement sampleRate = xmlHeader.createElement("Samplerate");
@@ -195,6 +673,15 @@ void InputDeviceRecorder::startXmlHeader()
     sampleRate.setAttribute("Unit", "Hz");
     sample.appendChild(sampleRate);
 
+    if (0 != m_deviceDescription.sample.inputSampleRate)
+    {   // stream was resampled to 2048kHz, original device rate is kept for information
+        QDomElement resampler = xmlHeader.createElement("Resampler");
+        resampler.setAttribute("InputRate", QString("%1").arg(m_deviceDescription.sample.inputSampleRate));
+        resampler.setAttribute("Unit", "Hz");
+        sample.appendChild(resampler);
+    }
+    else { /* native stream */ }
+
     QDomElement channels = xmlHeader.createElement("Channels");
     channels.setAttribute("Bits", QString("%1").arg(m_deviceDescription.sample.channelBits));
     channels.setAttribute("Container", m_deviceDescription.sample.channelContainer);
@@ -213,25 +700,221 @@ void InputDeviceRecorder::startXmlHeader()
     sample.appendChild(channels);
     root.appendChild(sample);
 
-    m_xmlHeader = xmlHeader;
+    if (isCompressed)
+    {
+        QDomElement compression = xmlHeader.createElement("Compression");
+        compression.setAttribute("Codec", "Rice");
+        compression.setAttribute("ChunkValues", QString("%1").arg(RAWFILECODEC_CHUNK_VALUES));
+        compression.setAttribute("DiscardBits", QString("%1").arg((16 == m_deviceDescription.sample.containerBits) ? INPUTDEVICERECORDER_COMPRESSION_DISCARD_BITS : 0));
+        root.appendChild(compression);
+    }
+
+    return xmlHeader;
 }
 
-void InputDeviceRecorder::finishXmlHeader()
+void InputDeviceRecorder::appendDatablock(QDomDocument &xmlHeader, uint64_t bytes, uint32_t frequency) const
 {
-    QDomElement datablocks = m_xmlHeader.createElement("Datablocks");
-    QDomElement datablock = m_xmlHeader.createElement("Datablock");
+    QDomElement datablocks = xmlHeader.createElement("Datablocks");
+    QDomElement datablock = xmlHeader.createElement("Datablock");
     datablock.setAttribute("Number", "1");
-    datablock.setAttribute("Count", QString("%1").arg(8 * m_bytesRecorded/m_deviceDescription.sample.containerBits));
+    datablock.setAttribute("Count", QString("%1").arg(8 * bytes/m_deviceDescription.sample.containerBits));
     datablock.setAttribute("Unit", "Channel");
     datablock.setAttribute("Offset", QString("%1").arg(INPUTDEVICERECORDER_XML_PADDING));
 
-    QDomElement frequency = m_xmlHeader.createElement("Frequency");
-    frequency.setAttribute("Value", QString("%1").arg(m_frequency));
-    frequency.setAttribute("Unit", "kHz");
-    datablock.appendChild(frequency);
-    QDomElement modulation = m_xmlHeader.createElement("Modulation");
+    QDomElement frequencyElement = xmlHeader.createElement("Frequency");
+    frequencyElement.setAttribute("Value", QString("%1").arg(frequency));
+    frequencyElement.setAttribute("Unit", "kHz");
+    datablock.appendChild(frequencyElement);
+    QDomElement modulation = xmlHeader.createElement("Modulation");
     modulation.setAttribute("Value", "DAB");
     datablock.appendChild(modulation);
     datablocks.appendChild(datablock);
-    m_xmlHeader.childNodes().at(1).appendChild(datablocks);
+    xmlHeader.childNodes().at(1).appendChild(datablocks);
+}
+
+void InputDeviceRecorder::setFlightRecorder(int seconds)
+{
+    m_flightSec = seconds;
+    bool wasEnabled = isFlightRecorderEnabled();
+    allocFlightBuffer();
+    if (wasEnabled && !isFlightRecorderEnabled() && !m_isActive)
+    {
+        emit deviceRecording(false);
+    }
+    else { /* device state is not changed */ }
+}
+
+void InputDeviceRecorder::allocFlightBuffer()
+{   // GUI thread
+    freeFlightBuffer();
+    if ((m_flightSec <= 0) || (InputDeviceId::UNDEFINED == m_deviceDescription.id) || (InputDeviceId::RAWFILE == m_deviceDescription.id))
+    {   // disabled or no live input
+        return;
+    }
+
+    // buffer keeps whole IQ samples
+    const uint64_t bytesPerSec = 2 * uint64_t(m_deviceDescription.sample.containerBits / 8) * m_deviceDescription.sample.sampleRate;
+    std::vector<uint8_t> buffer(m_flightSec * bytesPerSec);
+    {
+        std::lock_guard<std::mutex> guard(m_fileMutex);
+        m_flightBuffer.swap(buffer);
+        m_flightHead = 0;
+        m_flightPostBytes = 0;
+        m_flightState = FlightState::Filling;
+    }
+    qCInfo(inputDeviceRecorder) << "Flight recorder:" << m_flightSec << "sec," << (m_flightBuffer.size() >> 20) << "MB";
+
+    emit deviceRecording(true);
+}
+
+void InputDeviceRecorder::freeFlightBuffer()
+{   // GUI thread
+    std::thread * thread;
+    {
+        std::lock_guard<std::mutex> guard(m_fileMutex);
+        m_flightState = FlightState::Off;
+        thread = m_flightThread;
+        m_flightThread = nullptr;
+    }
+    if (nullptr != thread)
+    {   // buffer is used by dump thread
+        thread->join();
+        delete thread;
+    }
+
+    std::vector<uint8_t> buffer;
+    {
+        std::lock_guard<std::mutex> guard(m_fileMutex);
+        m_flightBuffer.swap(buffer);
+    }
+}
+
+void InputDeviceRecorder::writeFlightBuffer(const uint8_t *buf, uint32_t len)
+{   // m_fileMutex is locked by caller
+    if ((FlightState::Filling != m_flightState) && (FlightState::Triggered != m_flightState))
+    {
+        return;
+    }
+
+    const uint64_t size = m_flightBuffer.size();
+    const uint32_t inputLen = len;
+    if (len > size)
+    {   // only end of input fits to buffer
+        buf += len - size;
+        m_flightHead += len - size;
+        len = size;
+    }
+    uint64_t pos = m_flightHead % size;
+    uint32_t bytes = std::min<uint64_t>(len, size - pos);
+    memcpy(m_flightBuffer.data() + pos, buf, bytes);
+    memcpy(m_flightBuffer.data(), buf + bytes, len - bytes);
+    m_flightHead += len;
+
+    if (FlightState::Triggered == m_flightState)
+    {
+        if (m_flightPostBytes > inputLen)
+        {
+            m_flightPostBytes -= inputLen;
+        }
+        else
+        {
+            startFlightDump();
+        }
+    }
+    else { /* no event */ }
+}
+
+void InputDeviceRecorder::startFlightDump()
+{   // m_fileMutex is locked by caller
+    if (nullptr != m_flightThread)
+    {   // previous dump is finished
+        m_flightThread->join();
+        delete m_flightThread;
+    }
+    m_flightState = FlightState::Dumping;
+    m_flightThread = new std::thread(&InputDeviceRecorder::flightDumpThread, this, m_flightFileName, m_flightFrequency);
+}
+
+void InputDeviceRecorder::flightDumpThread(QString fileName, uint32_t frequency)
+{   // buffer is not modified while dumping
+    const uint64_t size = m_flightBuffer.size();
+    const uint64_t bytes = std::min(m_flightHead, size);
+    const uint64_t start = (m_flightHead - bytes) % size;
+
+    // time of first sample
+    QDomDocument xmlHeader = createXmlHeader(QDateTime::currentDateTimeUtc().addMSecs(-qint64(bytes * m_bytes2ms)), false);
+    appendDatablock(xmlHeader, bytes, frequency);
+    QByteArray header = xmlHeader.toByteArray();
+    header.append(QByteArray(INPUTDEVICERECORDER_XML_PADDING - header.size(), 0));
+
+    QFile file(fileName);
+    bool ok = file.open(QIODevice::WriteOnly);
+    ok = ok && (file.write(header) == header.size());
+    const uint64_t firstBytes = std::min(bytes, size - start);
+    ok = ok && (file.write(reinterpret_cast<const char *>(m_flightBuffer.data() + start), firstBytes) == qint64(firstBytes));
+    ok = ok && (file.write(reinterpret_cast<const char *>(m_flightBuffer.data()), bytes - firstBytes) == qint64(bytes - firstBytes));
+    file.close();
+    if (ok)
+    {
+        qCInfo(inputDeviceRecorder) << "Flight recorder saved" << bytes * m_bytes2ms << "ms to" << fileName;
+    }
+    else
+    {
+        qCCritical(inputDeviceRecorder) << "Unable to write flight recorder file:" << fileName;
+    }
+
+    std::lock_guard<std::mutex> guard(m_fileMutex);
+    if (FlightState::Dumping == m_flightState)
+    {   // samples already dumped are not used again
+        m_flightHead = 0;
+        m_flightState = FlightState::Filling;
+    }
+    else { /* flight recorder was disabled meanwhile */ }
+}
+
+void InputDeviceRecorder::triggerFlightRecorder(const QString &event)
+{   // GUI thread
+    std::lock_guard<std::mutex> guard(m_fileMutex);
+    if (FlightState::Filling != m_flightState)
+    {   // disabled or event is already being processed
+        return;
+    }
+
+    qCInfo(inputDeviceRecorder) << "Flight recorder triggered:" << event;
+    m_flightDumpTime = std::chrono::steady_clock::now();
+    m_flightFileName = QString("%1/%2_%3_%4.uff").arg(m_recordingPath,
+                                                      QDateTime::currentDateTime().toString("yyyy-MM-dd_hhmmss"),
+                                                      DabTables::channelName(m_frequency), event);
+    m_flightFrequency = m_frequency;
+    m_flightPostBytes = INPUTDEVICERECORDER_FLIGHT_POST_SEC * 2 * uint64_t(m_deviceDescription.sample.containerBits / 8) * m_deviceDescription.sample.sampleRate;
+    m_flightState = FlightState::Triggered;
+}
+
+void InputDeviceRecorder::checkSignalEvents(bool isSync, int fibErrors, int crcErrors)
+{   // GUI thread
+    bool wasSync = m_flightWasSync;
+    m_flightWasSync = isSync && !m_flightSuspended;
+    if (!isFlightRecorderEnabled() || m_flightSuspended)
+    {
+        return;
+    }
+    if ((m_flightDumpTime.time_since_epoch().count() != 0)
+        && (std::chrono::steady_clock::now() - m_flightDumpTime < std::chrono::seconds(INPUTDEVICERECORDER_FLIGHT_HOLDOFF_SEC)))
+    {   // limit number of dumps when signal is bad
+        return;
+    }
+
+    if (wasSync && !isSync)
+    {
+        triggerFlightRecorder("syncloss");
+    }
+    else if (isSync && (fibErrors >= INPUTDEVICERECORDER_FLIGHT_FIB_ERRORS))
+    {
+        triggerFlightRecorder("fib");
+    }
+    else if (isSync && (crcErrors >= INPUTDEVICERECORDER_FLIGHT_CRC_ERRORS))
+    {
+        triggerFlightRecorder("crc");
+    }
+    else { /* no event */ }
 }
@@ -29,11 +29,36 @@
 
 #include <QObject>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <vector>
 #include <QDomDocument>
+#include <QDateTime>
 #include "inputdevice.h"
 
 #define INPUTDEVICERECORDER_XML_PADDING 2048
 
+// recording is written by dedicated thread in large blocks so that slow storage does not block input device
+#define INPUTDEVICERECORDER_BLOCK_SIZE    (8*1024*1024)   // must be multiple of alignment
+#define INPUTDEVICERECORDER_NUM_BLOCKS    (2)             // double buffering
+#define INPUTDEVICERECORDER_ALIGNMENT     (4096)          // page aligned buffers
+#define INPUTDEVICERECORDER_DIRECT_IO     (1)             // bypass OS page cache if supported (O_DIRECT on Linux, F_NOCACHE on macOS)
+#define INPUTDEVICERECORDER_PROGRESS_MS   (200)           // minimum period of bytesRecorded signal
+#define INPUTDEVICERECORDER_COMPRESSION_DISCARD_BITS (0)  // int16 LSBs discarded in compressed recording (0 = lossless)
+
+// split recording: parts are named <name>_partNNN.<ext>, next part is opened in advance
+// and the stream continues in it without any sample gap
+#define INPUTDEVICERECORDER_PART_SUFFIX   "_part"
+#define INPUTDEVICERECORDER_PART_DIGITS   (3)
+
+// flight recorder: last seconds of input stream are kept in memory in device recording format,
+// buffer is dumped to file with XML header when event is triggered (sync loss, FIB or CRC errors, manual)
+#define INPUTDEVICERECORDER_FLIGHT_POST_SEC     (2)      // samples after trigger included in dump
+#define INPUTDEVICERECORDER_FLIGHT_HOLDOFF_SEC  (30)     // minimum time between dumps
+#define INPUTDEVICERECORDER_FLIGHT_FIB_ERRORS   (10)     // FIB errors in one telemetry update considered as burst
+#define INPUTDEVICERECORDER_FLIGHT_CRC_ERRORS   (5)      // audio CRC errors in one telemetry update
+
 class InputDeviceRecorder : public QObject
 {
     Q_OBJECT
@@ -46,24 +71,130 @@ public:
     void start(QWidget *callerWidget);
     void stop();
     void writeBuffer(const uint8_t *buf, uint32_t len);
-    void setCurrentFrequency(uint32_t frequency) { m_frequency = frequency; }
+    void setCurrentFrequency(uint32_t frequency) { m_frequency = frequency; m_flightSuspended = false; }
     void setXmlHeaderEnabled(bool ena) { m_xmlHeaderEna = ena; }
+    void setCompressionEnabled(bool ena) { m_compressionEna = ena; }
+
+    // recording is split to parts when size [MB] or duration [min] of sample data is reached, 0 = unlimited
+    // compressed parts are split by uncompressed data size, resulting files are smaller
+    void setSplitting(int maxSizeMB, int maxMinutes) { m_splitSizeMB = maxSizeMB; m_splitMinutes = maxMinutes; }
+
+    // flight recorder keeps last seconds of input in memory, 0 = disabled
+    void setFlightRecorder(int seconds);
+    bool isFlightRecorderEnabled() const { return !m_flightBuffer.empty(); }
+    // buffer is dumped to recording path, event is used in file name
+    void triggerFlightRecorder(const QString & event);
+    // trigger events evaluated from signal telemetry, suspended from tune request until tune is done
+    void checkSignalEvents(bool isSync, int fibErrors, int crcErrors);
+    void suspendSignalEvents() { m_flightSuspended = true; m_flightWasSync = false; }
+
+    // name of part file derived from name selected by user
+    static QString partFileName(const QString & fileName, int part);
 signals:
     void recording(bool isActive);
+    void deviceRecording(bool isActive);      // input device provides samples (recording or flight recorder)
     void bytesRecorded(uint64_t bytes, uint64_t ms);
 
 private:
+    struct Block
+    {
+        uint8_t * data;
+        uint32_t used;
+    };
+
     InputDeviceDescription m_deviceDescription;
+#if defined(_WIN32)
     FILE * m_file;
+    FILE * m_nextFile;      // pre-opened next part
+#else
+    int m_fd;
+    int m_nextFd;           // pre-opened next part
+#endif
+
+    // producer side (input device thread), protected by m_fileMutex
     std::mutex m_fileMutex;
+    bool m_isActive = false;
     uint64_t m_bytesRecorded = 0;
+    uint64_t m_bytesDropped = 0;
+    std::chrono::steady_clock::time_point m_progressTime;
+
+    // blocks are filled by producer and written by writer thread, protected by m_queueMutex
+    Block m_blocks[INPUTDEVICERECORDER_NUM_BLOCKS];
+    int m_fillIdx = 0;
+    int m_writeIdx = 0;
+    int m_numFull = 0;
+    bool m_writerExit = false;
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCondition;
+    std::thread * m_writerThread = nullptr;
+
+    // writer thread only
+    uint64_t m_bytesWritten = 0;            // all parts
+    uint64_t m_fileBytesWritten = 0;        // current part
+    uint64_t m_splitBytes = 0;              // 0 = recording is not split
+    QString m_fileName;                     // selected by user, parts are derived from it
+    QString m_nextFileName;
+    int m_part = 0;                         // current part, 0 = recording is not split
+    QDateTime m_startTime;
+    bool m_writeError = false;
+    uint64_t m_fileOffset = 0;
+    std::vector<uint8_t> m_chunkBuffer;
+    std::vector<uint8_t> m_chunkEncoded;
+    std::vector<uint64_t> m_chunkIndex;
+
     float m_bytes2ms;
     uint32_t m_frequency;
     QString m_recordingPath;
     bool m_xmlHeaderEna = true;
+    bool m_compressionEna = false;
+    int m_splitSizeMB = 0;
+    int m_splitMinutes = 0;
+    bool m_hasXmlHeader = true;     // current recording
+    bool m_isCompressed = false;    // current recording
     QDomDocument m_xmlHeader;
-    void startXmlHeader();
+    void startXmlHeader(const QDateTime & time);
     void finishXmlHeader();
+    QDomDocument createXmlHeader(const QDateTime & time, bool isCompressed) const;
+    void appendDatablock(QDomDocument & xmlHeader, uint64_t bytes, uint32_t frequency) const;
+
+    // flight recorder
+    enum class FlightState
+    {
+        Off,
+        Filling,
+        Triggered,      // collecting samples after trigger
+        Dumping         // buffer is written to file by dump thread, input is not stored
+    };
+    int m_flightSec = 0;
+    std::vector<uint8_t> m_flightBuffer;    // ring buffer, protected by m_fileMutex
+    uint64_t m_flightHead = 0;              // bytes written to buffer since reset
+    uint64_t m_flightPostBytes = 0;         // remaining bytes after trigger
+    FlightState m_flightState = FlightState::Off;
+    QString m_flightFileName;
+    uint32_t m_flightFrequency = 0;
+    std::thread * m_flightThread = nullptr;
+
+    // GUI thread
+    std::chrono::steady_clock::time_point m_flightDumpTime;
+    bool m_flightWasSync = false;
+    bool m_flightSuspended = false;
+
+    void allocFlightBuffer();
+    void freeFlightBuffer();
+    void writeFlightBuffer(const uint8_t * buf, uint32_t len);
+    void startFlightDump();
+    void flightDumpThread(QString fileName, uint32_t frequency);
+
+    bool openFile(const QString & fileName);    // opens next file
+    void activateNextFile();
+    bool nextPart();
+    void closeFile();
+    void closeNextFile();
+    void pushBlock(bool waitForSpace);
+    void writerThread();
+    bool writeBlock(const uint8_t * data, uint32_t len);
+    bool writeChunk();
+    bool writeData(const uint8_t * data, uint32_t len);
 };
 
 #endif // INPUTDEVICERECORDER_H
@@ -26,12 +26,24 @@
 
 #include <QDebug>
 #include "inputdevicesrc.h"
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define INPUTDEVICESRC_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define INPUTDEVICESRC_NEON 1
+#endif
 
-InputDeviceSRC::InputDeviceSRC(float inputSampleRate)
+InputDeviceSRC::InputDeviceSRC(float inputSampleRate, bool realInput) : m_inputSampleRate(inputSampleRate)
 {
-    if (2048e3 == inputSampleRate)
+    if (realInput && (4*2048e3 == inputSampleRate))
+    {
+        m_filter = new InputDeviceSRCFilterRealDDC();
+    }
+    else if (2048e3 == inputSampleRate)
     {
         m_filter = new InputDeviceSRCPassthrough();
     }
@@ -39,6 +51,10 @@ InputDeviceSRC::InputDeviceSRC(float inputSampleRate)
     {
         m_filter = new InputDeviceSRCFilterDS2();
     }
+    else if (numDS2Stages(inputSampleRate) > 1)
+    {   // integer ratio 2^N
+        m_filter = new InputDeviceSRCFilterDS2Cascade(numDS2Stages(inputSampleRate));
+    }
     else
     {
         m_filter = new InputDeviceSRCFilterFarrow(inputSampleRate);
@@ -50,6 +66,53 @@ InputDeviceSRC::~InputDeviceSRC()
     delete m_filter;
 }
 
+int InputDeviceSRC::numDS2Stages(double inputSampleRate)
+{
+    double rate = 2*2048e3;
+    for (int n = 1; n <= INPUTDEVICESRC_MAX_DS2_STAGES; ++n)
+    {
+        if (rate == inputSampleRate)
+        {
+            return n;
+        }
+        rate *= 2;
+    }
+    return 0;
+}
+
+double InputDeviceSRC::preferredSampleRate(const std::vector<double> &rates)
+{
+    double lowest = 0.0;
+    int stages = INPUTDEVICESRC_MAX_DS2_STAGES + 1;
+    double ds2Rate = 0.0;
+    for (double rate : rates)
+    {
+        if (2048e3 == rate)
+        {   // passthrough, nothing is better
+            return rate;
+        }
+        if (rate < 2048e3)
+        {   // not usable
+            continue;
+        }
+        int n = numDS2Stages(rate);
+        if ((n > 0) && (n < stages))
+        {   // less halfband stages
+            stages = n;
+            ds2Rate = rate;
+        }
+        if ((0.0 == lowest) || (rate < lowest))
+        {
+            lowest = rate;
+        }
+    }
+    if (ds2Rate > 0.0)
+    {
+        return ds2Rate;
+    }
+    return lowest;
+}
+
 void InputDeviceSRC::reset()
 {
     m_filter->reset();
@@ -67,18 +130,90 @@ float InputDeviceSRC::signalLevel() const
 
 int InputDeviceSRC::process(float inDataIQ[], int numInDataIQ, float outDataIQ[])
 {
+    float offset = m_requestedOffset.load();
+    if (offset != m_offset)
+    {   // new channel -> filter memory contains old one
+        m_offset = offset;
+        m_mixPhase = 0.0;
+        m_filter->reset();
+    }
+    if (0.0f != m_offset)
+    {
+        mix(inDataIQ, numInDataIQ);
+    }
     return m_filter->process(inDataIQ, numInDataIQ, outDataIQ);
 }
 
+void InputDeviceSRC::mix(float inDataIQ[], int numInDataIQ)
+{   // in place multiplication by exp(-j*2*pi*offset*n/Fs)
+    // phasor is computed by recursion and it is recalculated from phase every block to avoid amplitude drift
+    double step = -2.0 * M_PI * m_offset / m_inputSampleRate;
+    float stepI = std::cos(step);
+    float stepQ = std::sin(step);
+    float phI = std::cos(m_mixPhase);
+    float phQ = std::sin(m_mixPhase);
+    for (int n = 0; n < numInDataIQ; ++n)
+    {
+        float i = inDataIQ[2*n];
+        float q = inDataIQ[2*n+1];
+        inDataIQ[2*n] = i * phI - q * phQ;
+        inDataIQ[2*n+1] = i * phQ + q * phI;
+
+        float tmp = phI * stepI - phQ * stepQ;
+        phQ = phI * stepQ + phQ * stepI;
+        phI = tmp;
+    }
+    m_mixPhase = std::remainder(m_mixPhase + step * numInDataIQ, 2.0 * M_PI);
+}
+
+bool InputDeviceSRC::hasS16Input() const
+{
+    return m_filter->hasS16Input();
+}
+
+int InputDeviceSRC::process(const int16_t inDataIQ[], int numInDataIQ, float outDataIQ[])
+{
+    return m_filter->process(inDataIQ, numInDataIQ, outDataIQ);
+}
+
+bool InputDeviceSRC::hasS16RealInput() const
+{
+    return m_filter->hasS16RealInput();
+}
+
+int InputDeviceSRC::processReal(const int16_t inData[], int numInData, float outDataIQ[])
+{
+    return m_filter->processReal(inData, numInData, outDataIQ);
+}
+
 //===================================================================================================
 // DS2 filter designed for downsampling from 4096kHz to 2048kHz
 
 InputDeviceSRCFilterDS2::InputDeviceSRCFilterDS2()
 {
-    m_bufferI = new float[2*m_taps];
-    m_bufferQ = new float[2*m_taps];
-    m_bufferPtrI = m_bufferI;
-    m_bufferPtrQ = m_bufferQ;
+    m_bufferEven = new ( std::align_val_t(16) ) float[2*2*LEN_EVEN];
+    m_bufferOdd = new float[2*LEN_ODD];
+    m_bufferEvenS16I = new ( std::align_val_t(16) ) int16_t[2*LEN_EVEN_S16];
+    m_bufferEvenS16Q = new ( std::align_val_t(16) ) int16_t[2*LEN_EVEN_S16];
+    m_bufferOddS16 = new int16_t[2*LEN_ODD];
+
+    // folded coefficients, last pair is incomplete (odd number of coefficients)
+    for (int k = 0; k < (LEN_EVEN/2 + 1)/2; ++k)
+    {
+        m_coefFold[k][0] = m_coef[2*k];
+        m_coefFold[k][1] = m_coef[2*k];
+        m_coefFold[k][2] = (2*k+1 < LEN_EVEN/2) ? m_coef[2*k+1] : 0.0;
+        m_coefFold[k][3] = m_coefFold[k][2];
+    }
+
+    // fixed point coefficients (window is padded by 2 samples at the beginning)
+    m_coefS16[0] = 0;
+    m_coefS16[1] = 0;
+    for (int j = 0; j < LEN_EVEN; ++j)
+    {
+        int c = (j < LEN_EVEN/2) ? j : (LEN_EVEN - 1 - j);
+        m_coefS16[j + 2] = int16_t(std::lround(m_coef[c] * 32768.0));
+    }
 
     m_catt = 1 - std::exp(-1/(INPUTDEVICESRC_LEVEL_ATTACK * 2048e3));
     m_crel = 1 - std::exp(-1/(INPUTDEVICESRC_LEVEL_RELEASE * 2048e3));
@@ -88,81 +223,200 @@ InputDeviceSRCFilterDS2::InputDeviceSRCFilterDS2()
 
 InputDeviceSRCFilterDS2::~InputDeviceSRCFilterDS2()
 {
-    delete [] m_bufferI;
-    delete [] m_bufferQ;
+    operator delete [] (m_bufferEven, std::align_val_t(16));
+    delete [] m_bufferOdd;
+    operator delete [] (m_bufferEvenS16I, std::align_val_t(16));
+    operator delete [] (m_bufferEvenS16Q, std::align_val_t(16));
+    delete [] m_bufferOddS16;
 }
 
 void InputDeviceSRCFilterDS2::reset()
 {
     resetSignalLevel();
 
-    m_bufferPtrI = m_bufferI;
-    m_bufferPtrQ = m_bufferQ;
-    for (int n = 0; n < 2*m_taps; ++n)
-    {
-        m_bufferI[n] = 0;
-        m_bufferQ[n] = 0;
-    }
+    m_idxEven = 0;
+    m_idxOdd = 0;
+    m_idxEvenS16 = 0;
+    m_idxOddS16 = 0;
+    std::memset(m_bufferEven, 0, 2*2*LEN_EVEN*sizeof(float));
+    std::memset(m_bufferOdd, 0, 2*LEN_ODD*sizeof(float));
+    std::memset(m_bufferEvenS16I, 0, 2*LEN_EVEN_S16*sizeof(int16_t));
+    std::memset(m_bufferEvenS16Q, 0, 2*LEN_EVEN_S16*sizeof(int16_t));
+    std::memset(m_bufferOddS16, 0, 2*LEN_ODD*sizeof(int16_t));
 }
 
 int InputDeviceSRCFilterDS2::process(float inDataIQ[], int numInDataIQ, float outDataIQ[])
 {
     float level = m_signalLevel;
-
-    float * bufPtrI = m_bufferPtrI;
-    float * bufPtrQ = m_bufferPtrQ;
+    int idxEven = m_idxEven;
+    int idxOdd = m_idxOdd;
+    const float center = m_coef[LEN_EVEN/2];
 
     for (int n = 0; n<numInDataIQ/2; ++n)
     {
-        float * fwdI = bufPtrI;
-        float * revI = bufPtrI + m_taps;
-        float * fwdQ = bufPtrQ;
-        float * revQ = bufPtrQ + m_taps;
+        // insert even sample to delay line (twice)
+        float * evenPtr = m_bufferEven + 2*idxEven;
+        evenPtr[0] = evenPtr[2*LEN_EVEN] = *inDataIQ++;     // I
+        evenPtr[1] = evenPtr[2*LEN_EVEN + 1] = *inDataIQ++; // Q
+        if (++idxEven == LEN_EVEN)
+        {
+            idxEven = 0;
+        }
 
+        // contiguous window from the oldest to the newest sample: w[0] .. w[LEN_EVEN-1]
+        // y = sum c[j] * (w[j] + w[LEN_EVEN-1-j]) + center * odd[n-LEN_ODD]
+        const float * w = m_bufferEven + 2*idxEven;
+        const float * oddPtr = m_bufferOdd + 2*idxOdd;
+        float accI;
+        float accQ;
+#if INPUTDEVICESRC_SSE2
+        __m128 acc = _mm_setzero_ps();
+        for (int k = 0; k < (LEN_EVEN/2 + 1)/2; ++k)
+        {   // two complex taps in one step
+            __m128 fwd = _mm_loadu_ps(w + 4*k);
+            __m128 rev = _mm_loadu_ps(w + 2*(LEN_EVEN - 2 - 2*k));
+            rev = _mm_shuffle_ps(rev, rev, _MM_SHUFFLE(1, 0, 3, 2));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_add_ps(fwd, rev), _mm_load_ps(m_coefFold[k])));
+        }
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        float tmp[4];
+        _mm_storeu_ps(tmp, acc);
+        accI = tmp[0];
+        accQ = tmp[1];
+#elif INPUTDEVICESRC_NEON
+        float32x4_t acc = vdupq_n_f32(0.0);
+        for (int k = 0; k < (LEN_EVEN/2 + 1)/2; ++k)
+        {   // two complex taps in one step
+            float32x4_t fwd = vld1q_f32(w + 4*k);
+            float32x4_t rev = vld1q_f32(w + 2*(LEN_EVEN - 2 - 2*k));
+            rev = vextq_f32(rev, rev, 2);
+            acc = vmlaq_f32(acc, vaddq_f32(fwd, rev), vld1q_f32(m_coefFold[k]));
+        }
+        float32x2_t acc2 = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        accI = vget_lane_f32(acc2, 0);
+        accQ = vget_lane_f32(acc2, 1);
+#else
+        accI = 0;
+        accQ = 0;
+        for (int j = 0; j < LEN_EVEN/2; ++j)
+        {
+            accI += (w[2*j] + w[2*(LEN_EVEN-1-j)]) * m_coef[j];
+            accQ += (w[2*j+1] + w[2*(LEN_EVEN-1-j)+1]) * m_coef[j];
+        }
+#endif
+        *outDataIQ++ = accI + center * oddPtr[0];
+        *outDataIQ++ = accQ + center * oddPtr[1];
 
-        *fwdI++ = *inDataIQ;
-        *revI = *inDataIQ++;
-        *fwdQ++ = *inDataIQ;
-        *revQ = *inDataIQ++;
+        // insert odd sample to delay line
+        float inI = *inDataIQ++;
+        float inQ = *inDataIQ++;
+        m_bufferOdd[2*idxOdd] = inI;
+        m_bufferOdd[2*idxOdd + 1] = inQ;
+        if (++idxOdd == LEN_ODD)
+        {
+            idxOdd = 0;
+        }
 
-        float accI = 0;
-        float accQ = 0;
+#if (INPUTDEVICESRC_LEVEL_ESTIMATION > 0)
+        float abs2 = inI * inI + inQ * inQ;
 
-        for (int c = 0; c < (m_taps+1)/4; ++c)
+        // calculate signal level (rectifier, fast attack slow release)
+        float c = m_crel;
+        if (abs2 > level)
         {
-            accI += (*fwdI + *revI) * m_coef[c];
-            fwdI += 2;  // every other coeff is zero
-            revI -= 2;  // every other coeff is zero
-            accQ += (*fwdQ + *revQ) * m_coef[c];
-            fwdQ += 2;  // every other coeff is zero
-            revQ -= 2;  // every other coeff is zero
+            c = m_catt;
         }
+        level = c * abs2 + level - c * level;
+#endif
+    }
 
-        accI += *(fwdI-1) * m_coef[(m_taps+1)/4];
-        accQ += *(fwdQ-1) * m_coef[(m_taps+1)/4];
+    m_idxEven = idxEven;
+    m_idxOdd = idxOdd;
 
-        *outDataIQ++ = accI;
-        *outDataIQ++ = accQ;
+    // store signal level
+    m_signalLevel = level;
 
-        bufPtrQ += 1;
-        if (++bufPtrI == m_bufferI + m_taps)
-        {
-            bufPtrI = m_bufferI;
-            bufPtrQ = m_bufferQ;
-        }
+    return numInDataIQ/2;
+}
 
-#if (INPUTDEVICESRC_LEVEL_ESTIMATION > 0)
-        float abs2 = (*inDataIQ) * (*inDataIQ);  // I*I
+int InputDeviceSRCFilterDS2::process(const int16_t inDataIQ[], int numInDataIQ, float outDataIQ[])
+{
+    // input is Q15, coefficients are Q15 => accumulator is Q30
+    const float scale = 1.0 / (32768.0 * 32768.0);
+    const float scaleLevel = 1.0 / 32768.0;
+    float level = m_signalLevel;
+    int idxEven = m_idxEvenS16;
+    int idxOdd = m_idxOddS16;
 
-        // insert to delay line
-        *(bufPtrI + m_taps) = *inDataIQ;           // I
-        *bufPtrI++ = *inDataIQ++;                // I
+    for (int n = 0; n<numInDataIQ/2; ++n)
+    {
+        // insert even sample to delay line (twice)
+        m_bufferEvenS16I[idxEven] = m_bufferEvenS16I[idxEven + LEN_EVEN_S16] = *inDataIQ++;
+        m_bufferEvenS16Q[idxEven] = m_bufferEvenS16Q[idxEven + LEN_EVEN_S16] = *inDataIQ++;
+        if (++idxEven == LEN_EVEN_S16)
+        {
+            idxEven = 0;
+        }
 
-        abs2 += (*inDataIQ) * (*inDataIQ);       // Q*Q
+        // contiguous window from the oldest to the newest sample, 2 oldest samples have zero coefficient
+        const int16_t * wI = m_bufferEvenS16I + idxEven;
+        const int16_t * wQ = m_bufferEvenS16Q + idxEven;
+        int32_t accI;
+        int32_t accQ;
+#if INPUTDEVICESRC_SSE2
+        __m128i aI = _mm_setzero_si128();
+        __m128i aQ = _mm_setzero_si128();
+        for (int k = 0; k < LEN_EVEN_S16; k += 8)
+        {
+            __m128i c = _mm_load_si128((const __m128i *) (m_coefS16 + k));
+            aI = _mm_add_epi32(aI, _mm_madd_epi16(_mm_loadu_si128((const __m128i *) (wI + k)), c));
+            aQ = _mm_add_epi32(aQ, _mm_madd_epi16(_mm_loadu_si128((const __m128i *) (wQ + k)), c));
+        }
+        aI = _mm_add_epi32(aI, _mm_srli_si128(aI, 8));
+        aI = _mm_add_epi32(aI, _mm_srli_si128(aI, 4));
+        aQ = _mm_add_epi32(aQ, _mm_srli_si128(aQ, 8));
+        aQ = _mm_add_epi32(aQ, _mm_srli_si128(aQ, 4));
+        accI = _mm_cvtsi128_si32(aI);
+        accQ = _mm_cvtsi128_si32(aQ);
+#elif INPUTDEVICESRC_NEON
+        int32x4_t aI = vdupq_n_s32(0);
+        int32x4_t aQ = vdupq_n_s32(0);
+        for (int k = 0; k < LEN_EVEN_S16; k += 4)
+        {
+            int16x4_t c = vld1_s16(m_coefS16 + k);
+            aI = vmlal_s16(aI, vld1_s16(wI + k), c);
+            aQ = vmlal_s16(aQ, vld1_s16(wQ + k), c);
+        }
+        accI = vaddvq_s32(aI);
+        accQ = vaddvq_s32(aQ);
+#else
+        accI = 0;
+        accQ = 0;
+        for (int k = 0; k < LEN_EVEN_S16; ++k)
+        {
+            accI += int32_t(wI[k]) * m_coefS16[k];
+            accQ += int32_t(wQ[k]) * m_coefS16[k];
+        }
+#endif
+        // center coefficient is 0.5 => 16384 in Q15
+        const int16_t * oddPtr = m_bufferOddS16 + 2*idxOdd;
+        *outDataIQ++ = (accI + (int32_t(oddPtr[0]) << 14)) * scale;
+        *outDataIQ++ = (accQ + (int32_t(oddPtr[1]) << 14)) * scale;
+
+        // insert odd sample to delay line
+        int16_t inI = *inDataIQ++;
+        int16_t inQ = *inDataIQ++;
+        m_bufferOddS16[2*idxOdd] = inI;
+        m_bufferOddS16[2*idxOdd + 1] = inQ;
+        if (++idxOdd == LEN_ODD)
+        {
+            idxOdd = 0;
+        }
 
-        // insert to delay line
-        *(bufPtrQ + m_taps) = *inDataIQ;           // Q
-        *bufPtrQ++ = *inDataIQ++;                // Q
+#if (INPUTDEVICESRC_LEVEL_ESTIMATION > 0)
+        float fI = inI * scaleLevel;
+        float fQ = inQ * scaleLevel;
+        float abs2 = fI * fI + fQ * fQ;
 
         // calculate signal level (rectifier, fast attack slow release)
         float c = m_crel;
@@ -171,27 +425,288 @@ int InputDeviceSRCFilterDS2::process(float inDataIQ[], int numInDataIQ, float ou
             c = m_catt;
         }
         level = c * abs2 + level - c * level;
+#endif
+    }
+
+    m_idxEvenS16 = idxEven;
+    m_idxOddS16 = idxOdd;
+
+    // store signal level
+    m_signalLevel = level;
+
+    return numInDataIQ/2;
+}
+
+//===================================================================================================
+// Cascade of DS2 filters for downsampling from 2048kHz * 2^N to 2048kHz
+
+InputDeviceSRCFilterDS2Cascade::InputDeviceSRCFilterDS2Cascade(int numStages)
+{
+    for (int n = 0; n < numStages; ++n)
+    {
+        m_stages.push_back(new InputDeviceSRCFilterDS2());
+    }
+    m_hasPending.resize(numStages);
+    m_pending.resize(2*numStages);
+
+    InputDeviceSRCFilterDS2Cascade::reset();
+}
+
+InputDeviceSRCFilterDS2Cascade::~InputDeviceSRCFilterDS2Cascade()
+{
+    for (auto stage : m_stages)
+    {
+        delete stage;
+    }
+}
+
+void InputDeviceSRCFilterDS2Cascade::reset()
+{
+    resetSignalLevel();
+    for (auto stage : m_stages)
+    {
+        stage->reset();
+    }
+    std::fill(m_hasPending.begin(), m_hasPending.end(), false);
+}
+
+void InputDeviceSRCFilterDS2Cascade::ensureBuffer(int numInDataIQ)
+{   // output of the first stage is the largest intermediate block (+1 sample pending)
+    size_t size = 2*(numInDataIQ/2 + 1);
+    if (m_buffer.size() < size)
+    {
+        m_buffer.resize(size);
+    }
+}
+
+int InputDeviceSRCFilterDS2Cascade::processStage(int stage, float *inDataIQ, int numInDataIQ, float *outDataIQ)
+{   // DS2 filter writes output behind the input read position, in place processing is possible
+    InputDeviceSRCFilterDS2 * filter = m_stages[stage];
+    int numOut = 0;
+    if (m_hasPending[stage] && (numInDataIQ > 0))
+    {   // complete pair with first sample
+        float pair[4] = { m_pending[2*stage], m_pending[2*stage+1], inDataIQ[0], inDataIQ[1] };
+        numOut = filter->process(pair, 2, outDataIQ);
+        inDataIQ += 2;
+        numInDataIQ -= 1;
+        m_hasPending[stage] = false;
+    }
+    if (numInDataIQ & 1)
+    {   // last sample is kept for next block
+        m_pending[2*stage] = inDataIQ[2*(numInDataIQ-1)];
+        m_pending[2*stage+1] = inDataIQ[2*(numInDataIQ-1)+1];
+        m_hasPending[stage] = true;
+        numInDataIQ -= 1;
+    }
+    return numOut + filter->process(inDataIQ, numInDataIQ, outDataIQ + 2*numOut);
+}
+
+int InputDeviceSRCFilterDS2Cascade::process(float inDataIQ[], int numInDataIQ, float outDataIQ[])
+{
+    ensureBuffer(numInDataIQ);
+    int lastStage = m_stages.size() - 1;
+    int num = processStage(0, inDataIQ, numInDataIQ, m_buffer.data());
+    for (int stage = 1; stage < lastStage; ++stage)
+    {
+        num = processStage(stage, m_buffer.data(), num, m_buffer.data());
+    }
+    num = processStage(lastStage, m_buffer.data(), num, outDataIQ);
+
+    // level is estimated in the last stage @ 4096kHz
+    m_signalLevel = m_stages[lastStage]->signalLevel();
+    return num;
+}
+
+int InputDeviceSRCFilterDS2Cascade::process(const int16_t inDataIQ[], int numInDataIQ, float outDataIQ[])
+{   // first stage is fixed point, the rest is float
+    ensureBuffer(numInDataIQ);
+    float * buffer = m_buffer.data();
+    int num = 0;
+    if (m_hasPending[0] && (numInDataIQ > 0))
+    {
+        int16_t pair[4] = { m_pendingS16[0], m_pendingS16[1], inDataIQ[0], inDataIQ[1] };
+        num = m_stages[0]->process(pair, 2, buffer);
+        inDataIQ += 2;
+        numInDataIQ -= 1;
+        m_hasPending[0] = false;
+    }
+    if (numInDataIQ & 1)
+    {
+        m_pendingS16[0] = inDataIQ[2*(numInDataIQ-1)];
+        m_pendingS16[1] = inDataIQ[2*(numInDataIQ-1)+1];
+        m_hasPending[0] = true;
+        numInDataIQ -= 1;
+    }
+    num += m_stages[0]->process(inDataIQ, numInDataIQ, buffer + 2*num);
+
+    int lastStage = m_stages.size() - 1;
+    for (int stage = 1; stage < lastStage; ++stage)
+    {
+        num = processStage(stage, buffer, num, buffer);
+    }
+    num = processStage(lastStage, buffer, num, outDataIQ);
+
+    m_signalLevel = m_stages[lastStage]->signalLevel();
+    return num;
+}
+
+//===================================================================================================
+// Digital down-converter for real samples at 8192kHz with signal centered at 2048kHz
+
+InputDeviceSRCFilterRealDDC::InputDeviceSRCFilterRealDDC()
+{
+    m_bufferI = new ( std::align_val_t(16) ) int16_t[2*LEN_BRANCH];
+    m_bufferQ = new ( std::align_val_t(16) ) int16_t[2*LEN_BRANCH];
+
+    // lowpass designed by Kaiser window method
+    //   cutoff is Fs/8 (1024kHz), passband is 768kHz (DAB signal), stopband starts at 1280kHz
+    //   DC offset of ADC is moved to Fs/4 by mixer, this is stopband as well
+    const int numTaps = INPUTDEVICESRC_REAL_DDC_TAPS;
+    const double att = INPUTDEVICESRC_REAL_DDC_ATT;
+    const double beta = (att > 50.0) ? 0.1102 * (att - 8.7) : 0.5842 * std::pow(att - 21.0, 0.4) + 0.07886 * (att - 21.0);
+    const double fc = 0.125;
+
+    // modified Bessel function of the first kind, order 0 (power series)
+    auto besselI0 = [](double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    };
+
+    std::vector<double> h(numTaps);
+    double sum = 0.0;
+    for (int k = 0; k < numTaps; ++k)
+    {
+        double t = k - 0.5 * (numTaps - 1);
+        double r = 2.0 * t / (numTaps - 1);
+        double sinc = 2.0 * fc * ((0.0 == t) ? 1.0 : std::sin(2.0 * M_PI * fc * t) / (2.0 * M_PI * fc * t));
+        h[k] = sinc * besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+        sum += h[k];
+    }
+
+    // each branch gets only every second input sample => gain is 2 to keep the level of complex output
+    // odd taps are applied to I branch, even to Q branch (newest Q sample is one sample newer than I)
+    for (int j = 0; j < LEN_BRANCH; ++j)
+    {
+        m_coefI[LEN_BRANCH - 1 - j] = int16_t(std::clamp(std::lround(2.0 * h[2*j + 1] / sum * 32768.0), -32768L, 32767L));
+        m_coefQ[LEN_BRANCH - 1 - j] = int16_t(std::clamp(std::lround(2.0 * h[2*j] / sum * 32768.0), -32768L, 32767L));
+    }
+
+    m_catt = 1 - std::exp(-1/(INPUTDEVICESRC_LEVEL_ATTACK * 2048e3));
+    m_crel = 1 - std::exp(-1/(INPUTDEVICESRC_LEVEL_RELEASE * 2048e3));
+
+    InputDeviceSRCFilterRealDDC::reset();
+}
+
+InputDeviceSRCFilterRealDDC::~InputDeviceSRCFilterRealDDC()
+{
+    operator delete [] (m_bufferI, std::align_val_t(16));
+    operator delete [] (m_bufferQ, std::align_val_t(16));
+}
+
+void InputDeviceSRCFilterRealDDC::reset()
+{
+    resetSignalLevel();
+
+    m_idx = 0;
+    std::memset(m_bufferI, 0, 2*LEN_BRANCH*sizeof(int16_t));
+    std::memset(m_bufferQ, 0, 2*LEN_BRANCH*sizeof(int16_t));
+}
+
+int InputDeviceSRCFilterRealDDC::processReal(const int16_t inData[], int numInData, float outDataIQ[])
+{
+    // input is Q15, coefficients are Q15 => accumulator is Q30
+    const float scale = 1.0 / (32768.0 * 32768.0);
+    float level = m_signalLevel;
+    int idx = m_idx;
+
+    // saturated negation, -(-32768) does not fit to int16
+    auto neg = [](int16_t x) { return int16_t((INT16_MIN == x) ? INT16_MAX : -x); };
+
+    for (int n = 0; n < numInData/4; ++n)
+    {
+        // mixer [1 j -1 -j] applied to 4 input samples, insert to delay lines (twice)
+        int16_t i0 = *inData++;
+        int16_t q0 = *inData++;
+        int16_t i1 = neg(*inData++);
+        int16_t q1 = neg(*inData++);
+        m_bufferI[idx] = m_bufferI[idx + LEN_BRANCH] = i0;
+        m_bufferQ[idx] = m_bufferQ[idx + LEN_BRANCH] = q0;
+        m_bufferI[idx + 1] = m_bufferI[idx + 1 + LEN_BRANCH] = i1;
+        m_bufferQ[idx + 1] = m_bufferQ[idx + 1 + LEN_BRANCH] = q1;
+        idx += 2;
+        if (idx == LEN_BRANCH)
+        {
+            idx = 0;
+        }
+
+        // contiguous window from the oldest to the newest sample
+        const int16_t * wI = m_bufferI + idx;
+        const int16_t * wQ = m_bufferQ + idx;
+        int32_t accI;
+        int32_t accQ;
+#if INPUTDEVICESRC_SSE2
+        __m128i aI = _mm_setzero_si128();
+        __m128i aQ = _mm_setzero_si128();
+        for (int k = 0; k < LEN_BRANCH; k += 8)
+        {
+            aI = _mm_add_epi32(aI, _mm_madd_epi16(_mm_loadu_si128((const __m128i *) (wI + k)), _mm_load_si128((const __m128i *) (m_coefI + k))));
+            aQ = _mm_add_epi32(aQ, _mm_madd_epi16(_mm_loadu_si128((const __m128i *) (wQ + k)), _mm_load_si128((const __m128i *) (m_coefQ + k))));
+        }
+        aI = _mm_add_epi32(aI, _mm_srli_si128(aI, 8));
+        aI = _mm_add_epi32(aI, _mm_srli_si128(aI, 4));
+        aQ = _mm_add_epi32(aQ, _mm_srli_si128(aQ, 8));
+        aQ = _mm_add_epi32(aQ, _mm_srli_si128(aQ, 4));
+        accI = _mm_cvtsi128_si32(aI);
+        accQ = _mm_cvtsi128_si32(aQ);
+#elif INPUTDEVICESRC_NEON
+        int32x4_t aI = vdupq_n_s32(0);
+        int32x4_t aQ = vdupq_n_s32(0);
+        for (int k = 0; k < LEN_BRANCH; k += 4)
+        {
+            aI = vmlal_s16(aI, vld1_s16(wI + k), vld1_s16(m_coefI + k));
+            aQ = vmlal_s16(aQ, vld1_s16(wQ + k), vld1_s16(m_coefQ + k));
+        }
+        accI = vaddvq_s32(aI);
+        accQ = vaddvq_s32(aQ);
 #else
-        // insert new samples to delay line
-        *(bufPtrI + taps) = *inDataIQ;    // I
-        *bufPtrI++ = *inDataIQ++;         // I
-        *(bufPtrQ + taps) = *inDataIQ;    // Q
-        *bufPtrQ++ = *inDataIQ++;         // Q
+        accI = 0;
+        accQ = 0;
+        for (int k = 0; k < LEN_BRANCH; ++k)
+        {
+            accI += int32_t(wI[k]) * m_coefI[k];
+            accQ += int32_t(wQ[k]) * m_coefQ[k];
+        }
 #endif
-        if (bufPtrI == m_bufferI + m_taps)
+        float outI = accI * scale;
+        float outQ = accQ * scale;
+        *outDataIQ++ = outI;
+        *outDataIQ++ = outQ;
+
+#if (INPUTDEVICESRC_LEVEL_ESTIMATION > 0)
+        float abs2 = outI * outI + outQ * outQ;
+
+        // calculate signal level (rectifier, fast attack slow release)
+        float c = m_crel;
+        if (abs2 > level)
         {
-            bufPtrI = m_bufferI;
-            bufPtrQ = m_bufferQ;
+            c = m_catt;
         }
+        level = c * abs2 + level - c * level;
+#endif
     }
 
-    m_bufferPtrI = bufPtrI;
-    m_bufferPtrQ = bufPtrQ;
+    m_idx = idx;
 
     // store signal level
     m_signalLevel = level;
 
-    return numInDataIQ/2;
+    return numInData/4;
 }
 
 //===================================================================================================
@@ -202,6 +717,16 @@ InputDeviceSRCFilterFarrow::InputDeviceSRCFilterFarrow(float inputSampleRate)
     // output FS is fixed to 2048kHz
     m_R = 2048e3 / inputSampleRate;
 
+    // coefficients duplicated for interleaved IQ
+    for (int n = 0; n < NUM_POLY; ++n)
+    {
+        for (int m = 0; m < POLY_COEFS; ++m)
+        {
+            m_coefIQ[n][2*m] = m_coef[n][m];
+            m_coefIQ[n][2*m+1] = m_coef[n][m];
+        }
+    }
+
     // calculate catt and crel
     m_catt = 1 - std::exp(-1/(INPUTDEVICESRC_LEVEL_ATTACK * inputSampleRate));
     m_crel = 1 - std::exp(-1/(INPUTDEVICESRC_LEVEL_RELEASE * inputSampleRate));
@@ -219,60 +744,78 @@ void InputDeviceSRCFilterFarrow::reset()
     resetSignalLevel();
 
     m_mu = 0;
-    for (int m = 0; m < POLY_COEFS; ++m)
-    {
-        m_xI[m] = 0.0;
-        m_xQ[m] = 0.0;
-    }
-
-    for (int n = 0; n < NUM_POLY; ++n)
-    {
-        m_yI[n] = 0.0;
-        m_yQ[n] = 0.0;
-    }
+    std::memset(m_x, 0, sizeof(m_x));
+    std::memset(m_y, 0, sizeof(m_y));
 }
 
 int InputDeviceSRCFilterFarrow::process(float inDataIQ[], int numInDataIQ, float outDataIQ[])
 {
     float level = m_signalLevel;
     int numOutDataIQ = 0;
+    float mu = m_mu;
+
+#if INPUTDEVICESRC_SSE2
+    __m128 x0 = _mm_load_ps(m_x);
+    __m128 x1 = _mm_load_ps(m_x + 4);
+#elif INPUTDEVICESRC_NEON
+    float32x4_t x0 = vld1q_f32(m_x);
+    float32x4_t x1 = vld1q_f32(m_x + 4);
+#endif
 
     // do for all input samples
     do
     {
-        m_mu = m_mu - m_R;
-        if (m_mu < 0)
+        mu = mu - m_R;
+        if (mu < 0)
         {   // dump condition
-            m_mu = m_mu + 1.0;
+            mu = mu + 1.0;
+
             // calc FIR for each polynomial
+#if INPUTDEVICESRC_SSE2
+            for (int n = 0; n<NUM_POLY; ++n)
+            {
+                __m128 acc = _mm_add_ps(_mm_mul_ps(x0, _mm_load_ps(m_coefIQ[n])), _mm_mul_ps(x1, _mm_load_ps(m_coefIQ[n] + 4)));
+                acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+                __m128 y = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) &m_y[2*n]);
+                _mm_storel_pi((__m64 *) &m_y[2*n], _mm_add_ps(y, acc));
+            }
+            x0 = _mm_setzero_ps();
+            x1 = _mm_setzero_ps();
+#elif INPUTDEVICESRC_NEON
+            for (int n = 0; n<NUM_POLY; ++n)
+            {
+                float32x4_t acc = vmulq_f32(x0, vld1q_f32(m_coefIQ[n]));
+                acc = vmlaq_f32(acc, x1, vld1q_f32(m_coefIQ[n] + 4));
+                float32x2_t acc2 = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+                vst1_f32(&m_y[2*n], vadd_f32(vld1_f32(&m_y[2*n]), acc2));
+            }
+            x0 = vdupq_n_f32(0.0);
+            x1 = vdupq_n_f32(0.0);
+#else
             for (int n = 0; n<NUM_POLY; ++n)
             {
                 float accI = 0;
                 float accQ = 0;
                 for (int m = 0; m < POLY_COEFS; ++m)
                 {
-                    accI = accI + m_xI[m] * m_coef[n][m];
-                    accQ = accQ + m_xQ[m] * m_coef[n][m];
+                    accI = accI + m_x[2*m] * m_coefIQ[n][2*m];
+                    accQ = accQ + m_x[2*m+1] * m_coefIQ[n][2*m+1];
                 }
-                m_yI[n] = m_yI[n] + accI;
-                m_yQ[n] = m_yQ[n] + accQ;
+                m_y[2*n] = m_y[2*n] + accI;
+                m_y[2*n+1] = m_y[2*n+1] + accQ;
             }
-            *outDataIQ++ = m_R * m_yI[0];
-            *outDataIQ++ = m_R * m_yQ[0];
+
+            // dump xIQ
+            std::memset(m_x, 0, sizeof(m_x));
+#endif
+            *outDataIQ++ = m_R * m_y[0];
+            *outDataIQ++ = m_R * m_y[1];
             numOutDataIQ += 1;
 
             // shift delay line -> prepare for next dump
-            std::memmove(&m_yI[0], &m_yI[1], (NUM_POLY-1)*sizeof(float));
-            std::memmove(&m_yQ[0], &m_yQ[1], (NUM_POLY-1)*sizeof(float));
-            m_yI[NUM_POLY-1] = 0.0;
-            m_yQ[NUM_POLY-1] = 0.0;
-
-            // dump xIQ
-            for (int m = 0; m < POLY_COEFS; ++m)
-            {
-                m_xI[m] = 0.0;
-                m_xQ[m] = 0.0;
-            }
+            std::memmove(&m_y[0], &m_y[2], 2*(NUM_POLY-1)*sizeof(float));
+            m_y[2*(NUM_POLY-1)] = 0.0;
+            m_y[2*(NUM_POLY-1)+1] = 0.0;
         }
         else { /* continue with integration */ }
 
@@ -291,20 +834,40 @@ int InputDeviceSRCFilterFarrow::process(float inDataIQ[], int numInDataIQ, float
         level = c * abs2 + level - c * level;
 #endif
 
-        // Integrate
-        m_xI[0] += inI;
-        m_xQ[0] += inQ;
-
-        for (int m = 1; m < POLY_COEFS; ++m)
+        // Integrate: x[m] += in * mu^m
+        static_assert(POLY_COEFS == 4, "vectorized integration expects 4 polynomial coefficients");
+        float mu2 = mu * mu;
+#if INPUTDEVICESRC_SSE2
+        __m128 in = _mm_setr_ps(inI, inQ, inI, inQ);
+        x0 = _mm_add_ps(x0, _mm_mul_ps(in, _mm_setr_ps(1.0, 1.0, mu, mu)));
+        x1 = _mm_add_ps(x1, _mm_mul_ps(in, _mm_setr_ps(mu2, mu2, mu2*mu, mu2*mu)));
+#elif INPUTDEVICESRC_NEON
+        const float inArray[4] = { inI, inQ, inI, inQ };
+        const float p0[4] = { 1.0, 1.0, mu, mu };
+        const float p1[4] = { mu2, mu2, mu2*mu, mu2*mu };
+        float32x4_t in = vld1q_f32(inArray);
+        x0 = vmlaq_f32(x0, in, vld1q_f32(p0));
+        x1 = vmlaq_f32(x1, in, vld1q_f32(p1));
+#else
+        float p = 1.0;
+        for (int m = 0; m < POLY_COEFS; ++m)
         {
-            inI = inI*m_mu;
-            inQ = inQ*m_mu;
-
-            m_xI[m] += inI;
-            m_xQ[m] += inQ;
+            m_x[2*m] += inI * p;
+            m_x[2*m+1] += inQ * p;
+            p = p * mu;
         }
+#endif
     } while (--numInDataIQ > 0);
 
+#if INPUTDEVICESRC_SSE2
+    _mm_store_ps(m_x, x0);
+    _mm_store_ps(m_x + 4, x1);
+#elif INPUTDEVICESRC_NEON
+    vst1q_f32(m_x, x0);
+    vst1q_f32(m_x + 4, x1);
+#endif
+    m_mu = mu;
+
     // store signal level
     m_signalLevel = level;
 
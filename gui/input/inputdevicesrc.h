@@ -28,10 +28,15 @@
 #define INPUTDEVICESRC_H
 
 #include <cstdint>
+#include <atomic>
+#include <vector>
 
 #define INPUTDEVICESRC_LEVEL_ESTIMATION 1
 #define INPUTDEVICESRC_LEVEL_ATTACK  5e-5    // 50 usec
 #define INPUTDEVICESRC_LEVEL_RELEASE 5e-2    // 50 msec
+#define INPUTDEVICESRC_MAX_DS2_STAGES 4      // halfband cascade is used up to 2048kHz * 2^4
+#define INPUTDEVICESRC_REAL_DDC_TAPS  64     // FIR length of real input DDC (8192kHz real -> 2048kHz IQ)
+#define INPUTDEVICESRC_REAL_DDC_ATT   60.0   // [dB] stopband attenuation of real input DDC (Kaiser window)
 
 class InputDeviceSRCFilter;
 
@@ -39,16 +44,47 @@ class InputDeviceSRCFilter;
 class InputDeviceSRC
 {
 public:
-    InputDeviceSRC(float inputSampleRate);
+    // realInput: input are real samples with signal centered at inputSampleRate/4
+    //            only 8192kHz is supported, see hasS16RealInput()
+    InputDeviceSRC(float inputSampleRate, bool realInput = false);
     ~InputDeviceSRC();
+
+    // returns sample rate with the cheapest processing from the list of rates supported by device
+    //   2048kHz (passthrough) < 2048kHz * 2^N (halfband cascade) < lowest rate above 2048kHz (Farrow)
+    // returns 0 if no rate >= 2048kHz is available
+    static double preferredSampleRate(const std::vector<double> & rates);
+
+    // number of halfband stages for input rate or 0 if rate is not 2048kHz * 2^N, N >= 1
+    static int numDS2Stages(double inputSampleRate);
     void reset();
     void resetSignalLevel(float resetVal = 0.0);
     float signalLevel() const;
 
     // processing - returns number of output samples
     int process(float inDataIQ[], int numInDataIQ, float outDataIQ[]);
+
+    // frequency shift applied to input samples before resampling (float processing only)
+    // signal at inputFrequency + offsetHz is moved to DC, it can be set from any thread
+    void setFrequencyOffset(float offsetHz) { m_requestedOffset.store(offsetHz); }
+
+    // processing of int16 samples (considered as Q15) - returns number of output samples
+    // only available if hasS16Input() returns true
+    bool hasS16Input() const;
+    int process(const int16_t inDataIQ[], int numInDataIQ, float outDataIQ[]);
+
+    // processing of real int16 samples (considered as Q15) - returns number of output samples
+    // only available if hasS16RealInput() returns true
+    bool hasS16RealInput() const;
+    int processReal(const int16_t inData[], int numInData, float outDataIQ[]);
 private:
     InputDeviceSRCFilter * m_filter = nullptr;
+
+    float m_inputSampleRate;
+    std::atomic<float> m_requestedOffset { 0.0f };
+    float m_offset = 0.0f;
+    double m_mixPhase = 0.0;   // phase of mixer [rad] at the beginning of the block
+
+    void mix(float inDataIQ[], int numInDataIQ);
 };
 
 class InputDeviceSRCFilter
@@ -68,6 +104,14 @@ public:
     // processing - returns number of output samples
     virtual int process(float inDataIQ[], int numInDataIQ, float outDataIQ[]) = 0;
 
+    // fixed point processing of int16 samples - returns number of output samples
+    virtual bool hasS16Input() const { return false; }
+    virtual int process(const int16_t inDataIQ[], int numInDataIQ, float outDataIQ[]) { (void) inDataIQ; (void) numInDataIQ; (void) outDataIQ; return 0; }
+
+    // fixed point processing of real int16 samples - returns number of output samples
+    virtual bool hasS16RealInput() const { return false; }
+    virtual int processReal(const int16_t inData[], int numInData, float outDataIQ[]) { (void) inData; (void) numInData; (void) outDataIQ; return 0; }
+
 protected:
     float m_signalLevel;
 };
@@ -83,13 +127,32 @@ public:
 
     // processing -  - returns number of output samples
     int process(float inDataIQ[], int numInDataIQ, float outDataIQ[]) override;
+    bool hasS16Input() const override { return true; }
+    int process(const int16_t inDataIQ[], int numInDataIQ, float outDataIQ[]) override;
 private:
     enum { FILTER_ORDER = 42 };
 
-    float * m_bufferPtrI;
-    float * m_bufferPtrQ;
-    float * m_bufferI;
-    float * m_bufferQ;
+    // polyphase implementation
+    // even phase contains all non-zero coefficients except the center one
+    //   delay line is interleaved IQ and it is stored twice so that window is always contiguous
+    // odd phase is only delayed center sample
+    enum { LEN_EVEN = (FILTER_ORDER + 2)/2, LEN_ODD = (FILTER_ORDER + 2)/4, LEN_EVEN_S16 = LEN_EVEN + 2 };
+
+    float * m_bufferEven;
+    float * m_bufferOdd;
+    int m_idxEven;
+    int m_idxOdd;
+
+    // fixed point delay lines, I and Q are separated, length is padded to multiple of 8
+    int16_t * m_bufferEvenS16I;
+    int16_t * m_bufferEvenS16Q;
+    int16_t * m_bufferOddS16;
+    int m_idxEvenS16;
+    int m_idxOddS16;
+    alignas(16) int16_t m_coefS16[LEN_EVEN_S16];
+
+    // folded coefficients for float processing, duplicated for I and Q: [c0 c0 c1 c1], [c2 c2 c3 c3], ...
+    alignas(16) float m_coefFold[(LEN_EVEN/2 + 1)/2][4];
 
     // level filter
     float m_catt;
@@ -114,6 +177,69 @@ private:
     };
 };
 
+//===================================================================================================
+// Cascade of DS2 filters for downsampling from 2048kHz * 2^N to 2048kHz
+// odd number of samples at the input of any stage is handled by keeping the last sample for next block
+class InputDeviceSRCFilterDS2Cascade : public InputDeviceSRCFilter
+{
+public:
+    InputDeviceSRCFilterDS2Cascade(int numStages);
+    ~InputDeviceSRCFilterDS2Cascade();
+    void reset() override;
+
+    // processing - returns number of output samples
+    int process(float inDataIQ[], int numInDataIQ, float outDataIQ[]) override;
+    bool hasS16Input() const override { return true; }
+    int process(const int16_t inDataIQ[], int numInDataIQ, float outDataIQ[]) override;
+private:
+    std::vector<InputDeviceSRCFilterDS2 *> m_stages;
+    std::vector<float> m_buffer;          // intermediate stages are processed in place
+    std::vector<bool> m_hasPending;       // pending sample for each stage
+    std::vector<float> m_pending;         // [I Q] for each stage
+    int16_t m_pendingS16[2];
+
+    // processes one stage, returns number of output samples
+    int processStage(int stage, float * inDataIQ, int numInDataIQ, float * outDataIQ);
+    void ensureBuffer(int numInDataIQ);
+};
+
+//===================================================================================================
+// Digital down-converter for real samples at 8192kHz with signal centered at 2048kHz (Airspy raw samples)
+// frequency shift by Fs/4 and lowpass decimation by 4 are done in one pass:
+//   mixer sequence is [1 j -1 -j] so that even input samples contribute only to I and odd only to Q
+//   spectrum of real samples is inverted, the same mixer is used by libairspy IQ converter
+//   => FIR is split to two polyphase branches, each one running on its own delay line
+class InputDeviceSRCFilterRealDDC : public InputDeviceSRCFilter
+{
+public:
+    InputDeviceSRCFilterRealDDC();
+    ~InputDeviceSRCFilterRealDDC();
+    void reset() override;
+
+    // complex float input is not supported
+    int process(float inDataIQ[], int numInDataIQ, float outDataIQ[]) override { (void) inDataIQ; (void) numInDataIQ; (void) outDataIQ; return 0; }
+
+    // processing - returns number of output samples
+    bool hasS16RealInput() const override { return true; }
+    int processReal(const int16_t inData[], int numInData, float outDataIQ[]) override;
+private:
+    // length of each branch, multiple of 8 for SIMD
+    enum { LEN_BRANCH = INPUTDEVICESRC_REAL_DDC_TAPS/2 };
+
+    // delay lines are stored twice so that window is always contiguous
+    int16_t * m_bufferI;
+    int16_t * m_bufferQ;
+    int m_idx;
+
+    // Q15 coefficients in reversed order (window goes from the oldest to the newest sample)
+    alignas(16) int16_t m_coefI[LEN_BRANCH];
+    alignas(16) int16_t m_coefQ[LEN_BRANCH];
+
+    // level filter
+    float m_catt;
+    float m_crel;
+};
+
 //===================================================================================================
 // Transposed Farrow filter designed for downsampling from arbitrary rate to 2048kHz
 class InputDeviceSRCFilterFarrow : public InputDeviceSRCFilter
@@ -132,13 +258,15 @@ private:
     float m_catt;
     float m_crel;
 
+    // state is interleaved IQ: x = [I0 Q0 I1 Q1 ...], y = [I0 Q0 I1 Q1 ...]
     float m_mu = 0;
-    float m_xI[POLY_COEFS];
-    float m_xQ[POLY_COEFS];
-    float m_yI[NUM_POLY];
-    float m_yQ[NUM_POLY];
+    alignas(16) float m_x[2*POLY_COEFS];
+    alignas(16) float m_y[2*NUM_POLY];
     float m_R;   // FSout/FSin
 
+    // coefficients duplicated for I and Q
+    alignas(16) float m_coefIQ[NUM_POLY][2*POLY_COEFS];
+
     constexpr static const float m_coef[NUM_POLY][POLY_COEFS] =
     {
         {   0.001667349914006070960362,  0.032712194697834547085780, -0.146457831613232558609639,  0.004040531324696360060411  },
@@ -0,0 +1,292 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include <QtEndian>
+#include <cmath>
+#include "iqstreamserver.h"
+#include "rtltcpinput.h"
+
+Q_LOGGING_CATEGORY(iqStreamServer, "IQStreamServer", QtInfoMsg)
+
+std::atomic<IQStreamServer *> IQStreamServer::m_instancePtr { nullptr };
+
+IQStreamServer::IQStreamServer(QObject *parent) : QObject(parent)
+{
+    m_hasClients = false;
+    m_meanPower = 0.0f;
+    m_droppedBytes = 0;
+
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &IQStreamServer::onNewConnection);
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setInterval(IQSTREAMSERVER_FLUSH_PERIOD_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &IQStreamServer::onFlushTimeout);
+}
+
+IQStreamServer::~IQStreamServer()
+{
+    stop();
+}
+
+bool IQStreamServer::start(quint16 port)
+{
+    if (!m_server->listen(QHostAddress::Any, port))
+    {
+        qCWarning(iqStreamServer) << "Unable to listen on port" << port << ":" << m_server->errorString();
+        return false;
+    }
+    qCInfo(iqStreamServer) << "Listening on port" << port;
+
+    m_instancePtr = this;
+    m_flushTimer->start();
+    return true;
+}
+
+void IQStreamServer::stop()
+{
+    m_instancePtr = nullptr;
+    m_hasClients = false;
+    m_flushTimer->stop();
+
+    for (auto it = m_clients.cbegin(); it != m_clients.cend(); ++it)
+    {
+        it.key()->disconnect(this);
+        it.key()->abort();
+        it.key()->deleteLater();
+    }
+    m_clients.clear();
+    m_server->close();
+
+    QMutexLocker locker(&m_mutex);
+    m_pending.clear();
+}
+
+void IQStreamServer::feedSamples(const float *iq, uint16_t numSamples)
+{
+    IQStreamServer * server = m_instancePtr.load(std::memory_order_acquire);
+    if ((nullptr != server) && server->m_hasClients.load(std::memory_order_relaxed))
+    {
+        server->convert(iq, numSamples);
+    }
+}
+
+bool IQStreamServer::isActive()
+{
+    IQStreamServer * server = m_instancePtr.load(std::memory_order_acquire);
+    return (nullptr != server) && server->m_hasClients.load(std::memory_order_relaxed);
+}
+
+void IQStreamServer::convert(const float *iq, uint16_t numSamples)
+{   // input samples have device specific scale -> level is normalized
+    QMutexLocker locker(&m_mutex);
+
+    if (m_pending.size() > IQSTREAMSERVER_MAX_PENDING)
+    {   // flush timer did not run
+        m_droppedBytes += 2*numSamples;
+        return;
+    }
+
+    float power = 0.0f;
+    for (int n = 0; n < 2*numSamples; ++n)
+    {
+        power += iq[n] * iq[n];
+    }
+    power /= numSamples;
+    m_meanPower = (m_meanPower > 0.0f) ? (m_meanPower + 0.05f * (power - m_meanPower)) : power;
+    float gain = (m_meanPower > 0.0f) ? (IQSTREAMSERVER_TARGET_RMS / std::sqrt(m_meanPower)) : 0.0f;
+
+    int offset = m_pending.size();
+    m_pending.resize(offset + 2*numSamples);
+    uint8_t * out = reinterpret_cast<uint8_t *>(m_pending.data()) + offset;
+    for (int n = 0; n < 2*numSamples; ++n)
+    {
+        float val = std::round(iq[n] * gain) + 128.0f;
+        if (val < 0.0f)
+        {
+            val = 0.0f;
+        }
+        else if (val > 255.0f)
+        {
+            val = 255.0f;
+        }
+        else { /* in range */ }
+        *out++ = uint8_t(val);
+    }
+}
+
+void IQStreamServer::onNewConnection()
+{
+    while (m_server->hasPendingConnections())
+    {
+        QTcpSocket * client = m_server->nextPendingConnection();
+        if (m_clients.size() >= IQSTREAMSERVER_MAX_CLIENTS)
+        {
+            qCWarning(iqStreamServer) << "Too many clients, rejecting" << client->peerAddress().toString();
+            client->abort();
+            client->deleteLater();
+            continue;
+        }
+
+        qCInfo(iqStreamServer) << "Client connected:" << client->peerAddress().toString();
+
+        connect(client, &QTcpSocket::readyRead, this, [this, client]() { onClientReadyRead(client); });
+        connect(client, &QTcpSocket::disconnected, this, &IQStreamServer::onClientDisconnected);
+        m_clients.insert(client, Client());
+
+        // classic clients get dongle info after timeout
+        QTimer::singleShot(IQSTREAMSERVER_NEGOTIATION_MS, client, [this, client]() {
+            sendHeader(client, RTLTCP_TRANSPORT_U8);
+        });
+    }
+}
+
+void IQStreamServer::onClientReadyRead(QTcpSocket *client)
+{
+    auto it = m_clients.find(client);
+    if (m_clients.end() == it)
+    {
+        return;
+    }
+
+    // commands are 5 bytes [cmd, param (big endian)]
+    while (client->bytesAvailable() >= 5)
+    {
+        char cmd[5];
+        client->read(cmd, 5);
+        if (!it->headerSent && (uint8_t(cmd[0]) == 0x80))
+        {   // SET_TRANSPORT_FORMAT extension
+            uint32_t format = qFromBigEndian<quint32>(cmd + 1);
+            sendHeader(client, (RTLTCP_TRANSPORT_PACKED4 == format) ? RTLTCP_TRANSPORT_PACKED4 : RTLTCP_TRANSPORT_U8);
+        }
+        else { /* other commands are ignored, tuning is controlled by server */ }
+    }
+}
+
+void IQStreamServer::sendHeader(QTcpSocket *client, int transportFormat)
+{
+    auto it = m_clients.find(client);
+    if ((m_clients.end() == it) || it->headerSent)
+    {   // disconnected or already negotiated
+        return;
+    }
+
+    // rtl_tcp dongle info: magic, tuner type, gain count (big endian)
+    char header[12] = { 'R', 'T', 'L', (RTLTCP_TRANSPORT_PACKED4 == transportFormat) ? '4' : '0' };
+    qToBigEndian<quint32>(IQSTREAMSERVER_RTL_TUNER_R820T, header + 4);
+    qToBigEndian<quint32>(IQSTREAMSERVER_RTL_GAIN_COUNT, header + 8);
+    client->write(header, sizeof(header));
+
+    it->headerSent = true;
+    it->transportFormat = transportFormat;
+    m_hasClients = true;
+
+    qCInfo(iqStreamServer) << "Streaming to" << client->peerAddress().toString()
+                           << ((RTLTCP_TRANSPORT_PACKED4 == transportFormat) ? "[4-bit packed]" : "[uint8]");
+}
+
+void IQStreamServer::onClientDisconnected()
+{
+    QTcpSocket * client = qobject_cast<QTcpSocket *>(sender());
+    if (nullptr == client)
+    {
+        return;
+    }
+
+    qCInfo(iqStreamServer) << "Client disconnected:" << client->peerAddress().toString();
+    m_clients.remove(client);
+    client->deleteLater();
+
+    m_hasClients = !m_clients.isEmpty();
+}
+
+void IQStreamServer::onFlushTimeout()
+{
+    QByteArray data;
+    uint64_t dropped;
+    {
+        QMutexLocker locker(&m_mutex);
+        data.swap(m_pending);
+        dropped = m_droppedBytes;
+        m_droppedBytes = 0;
+    }
+    if (dropped > 0)
+    {
+        qCWarning(iqStreamServer) << "Dropped" << dropped / 2 << "IQ samples";
+    }
+    if (data.isEmpty())
+    {
+        return;
+    }
+
+    QByteArray packed;
+    for (auto it = m_clients.cbegin(); it != m_clients.cend(); ++it)
+    {
+        QTcpSocket * client = it.key();
+        if (!it->headerSent)
+        {   // negotiation is not finished
+            continue;
+        }
+        if (client->bytesToWrite() > IQSTREAMSERVER_CLIENT_MAX_QUEUE)
+        {   // slow client -> chunk is skipped for this client only
+            qCDebug(iqStreamServer) << "Client" << client->peerAddress().toString() << "is too slow, dropping" << data.size() / 2 << "IQ samples";
+            continue;
+        }
+        if (RTLTCP_TRANSPORT_PACKED4 == it->transportFormat)
+        {
+            if (packed.isEmpty())
+            {   // packed once for all clients
+                packed = pack4(data);
+            }
+            client->write(packed);
+        }
+        else
+        {
+            client->write(data);
+        }
+    }
+}
+
+QByteArray IQStreamServer::pack4(const QByteArray &data)
+{   // uint8 samples with TARGET_RMS level are requantized to 4-bit midrise quantizer with PACKED4_RMS level
+    // nibble n represents value (n - 7.5) steps
+    const float scale = IQSTREAMSERVER_PACKED4_RMS / IQSTREAMSERVER_TARGET_RMS;
+    QByteArray packed(data.size() / 2, Qt::Uninitialized);
+    const uint8_t * in = reinterpret_cast<const uint8_t *>(data.constData());
+    uint8_t * out = reinterpret_cast<uint8_t *>(packed.data());
+    for (int k = 0; k < packed.size(); ++k)
+    {
+        int n[2];
+        for (int c = 0; c < 2; ++c)
+        {
+            n[c] = int(std::floor((int(*in++) - 128) * scale + 8.0f));
+            n[c] = (n[c] < 0) ? 0 : ((n[c] > 15) ? 15 : n[c]);
+        }
+        *out++ = uint8_t((n[0] << 4) | n[1]);
+    }
+    return packed;
+}
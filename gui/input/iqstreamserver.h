@@ -0,0 +1,95 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef IQSTREAMSERVER_H
+#define IQSTREAMSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QMutex>
+#include <QHash>
+#include <atomic>
+
+// IQ samples received by dabsdr are re-exported in rtl_tcp format (uint8 IQ @ 2048kHz)
+// any rtl_tcp client (e.g. RtlTcpInput) can connect, tuning is controlled by this application only
+// clients can request 4-bit packed transport (see rtltcpinput.h), it halves the data rate
+#define IQSTREAMSERVER_PORT_DEFAULT        (1235)
+#define IQSTREAMSERVER_FLUSH_PERIOD_MS     (20)
+#define IQSTREAMSERVER_MAX_CLIENTS         (8)
+#define IQSTREAMSERVER_CLIENT_MAX_QUEUE    (2*1024*1024)   // 0.5 sec of data, slow client drops chunks above this
+#define IQSTREAMSERVER_MAX_PENDING         (1024*1024)     // pending data when flush timer is late
+#define IQSTREAMSERVER_TARGET_RMS          (32.0f)         // output level in uint8 steps
+#define IQSTREAMSERVER_PACKED4_RMS         (3.0f)          // output level in 4-bit steps
+#define IQSTREAMSERVER_NEGOTIATION_MS      (200)           // waiting for transport request before dongle info is sent
+#define IQSTREAMSERVER_RTL_TUNER_R820T     (5)             // tuner type reported to clients
+#define IQSTREAMSERVER_RTL_GAIN_COUNT      (29)
+
+class IQStreamServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IQStreamServer(QObject *parent = nullptr);
+    ~IQStreamServer();
+
+    bool start(quint16 port);
+    void stop();
+
+    // called from dabsdr thread for every block of samples, returns immediately when nobody is connected
+    static void feedSamples(const float * iq, uint16_t numSamples);
+    static bool isActive();
+
+private:
+    static std::atomic<IQStreamServer *> m_instancePtr;
+
+    struct Client
+    {
+        bool headerSent = false;
+        int transportFormat = 0;
+    };
+
+    QTcpServer * m_server;
+    QHash<QTcpSocket *, Client> m_clients;
+    QTimer * m_flushTimer;
+    std::atomic<bool> m_hasClients;
+
+    // shared with dabsdr thread
+    QMutex m_mutex;
+    QByteArray m_pending;
+    float m_meanPower;
+    uint64_t m_droppedBytes;
+
+    void onNewConnection();
+    void onClientDisconnected();
+    void onClientReadyRead(QTcpSocket * client);
+    void sendHeader(QTcpSocket * client, int transportFormat);
+    static QByteArray pack4(const QByteArray & data);
+    void onFlushTimeout();
+    void convert(const float * iq, uint16_t numSamples);
+};
+
+#endif // IQSTREAMSERVER_H
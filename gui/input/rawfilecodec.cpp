@@ -0,0 +1,477 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include <algorithm>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "rawfilecodec.h"
+
+Q_LOGGING_CATEGORY(rawFileCodec, "RawFileCodec", QtInfoMsg)
+
+namespace
+{
+inline void putLE(std::vector<uint8_t> & out, uint64_t val, int bytes)
+{
+    for (int n = 0; n < bytes; ++n)
+    {
+        out.push_back(uint8_t(val >> (8*n)));
+    }
+}
+
+inline uint64_t getLE(const uint8_t * in, int bytes)
+{
+    uint64_t val = 0;
+    for (int n = 0; n < bytes; ++n)
+    {
+        val |= uint64_t(in[n]) << (8*n);
+    }
+    return val;
+}
+
+inline int countLeadingZeros(uint64_t val)
+{   // val must not be 0
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse64(&idx, val);
+    return 63 - idx;
+#else
+    return __builtin_clzll(val);
+#endif
+}
+
+// MSB first bit writer
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t> & out) : m_out(out) {}
+    void put(uint32_t val, int bits)
+    {   // bits <= 32
+        m_acc = (m_acc << bits) | val;
+        m_bits += bits;
+        while (m_bits >= 8)
+        {
+            m_bits -= 8;
+            m_out.push_back(uint8_t(m_acc >> m_bits));
+        }
+    }
+    void putRice(uint32_t val, int k)
+    {   // unary coded quotient (zeros terminated by one) followed by k bits of remainder
+        uint32_t q = val >> k;
+        while (q >= 32)
+        {
+            put(0, 32);
+            q -= 32;
+        }
+        put(1, q + 1);
+        put(val & ((1u << k) - 1), k);
+    }
+    void flush()
+    {
+        if (m_bits > 0)
+        {
+            m_out.push_back(uint8_t(m_acc << (8 - m_bits)));
+            m_bits = 0;
+        }
+    }
+private:
+    std::vector<uint8_t> & m_out;
+    uint64_t m_acc = 0;
+    int m_bits = 0;
+};
+
+// MSB first bit reader, reading beyond the end is detected by overrun()
+class BitReader
+{
+public:
+    BitReader(const uint8_t * data, uint32_t bytes) : m_ptr(data), m_end(data + bytes), m_totalBits(uint64_t(bytes) * 8) {}
+    bool overrun() const { return m_consumed > m_totalBits; }
+    uint32_t get(int bits)
+    {
+        if (0 == bits)
+        {
+            return 0;
+        }
+        refill();
+        uint32_t val = uint32_t(m_acc >> (64 - bits));
+        m_acc <<= bits;
+        m_bits -= bits;
+        m_consumed += bits;
+        return val;
+    }
+    uint32_t getRice(int k)
+    {
+        uint32_t q = 0;
+        while (true)
+        {
+            refill();
+            if (0 == m_acc)
+            {   // all bits in accumulator are zeros
+                q += m_bits;
+                m_consumed += m_bits;
+                m_bits = 0;
+                if (overrun())
+                {
+                    return 0;
+                }
+                continue;
+            }
+            int zeros = countLeadingZeros(m_acc);
+            q += zeros;
+            m_acc = (63 == zeros) ? 0 : (m_acc << (zeros + 1));
+            m_bits -= zeros + 1;
+            m_consumed += zeros + 1;
+            break;
+        }
+        return (q << k) | get(k);
+    }
+private:
+    const uint8_t * m_ptr;
+    const uint8_t * m_end;
+    uint64_t m_totalBits;
+    uint64_t m_consumed = 0;
+    uint64_t m_acc = 0;    // valid bits are MSB aligned, remaining bits are zeros
+    int m_bits = 0;
+
+    void refill()
+    {
+        while (m_bits <= 56)
+        {
+            uint64_t byte = (m_ptr < m_end) ? *m_ptr++ : 0;
+            m_acc |= byte << (56 - m_bits);
+            m_bits += 8;
+        }
+    }
+};
+}
+
+void RawFileCodec::encode(const uint8_t *in, uint32_t numValues, int containerBits, int discardBits, std::vector<uint8_t> &out)
+{
+    if (8 == containerBits)
+    {   // uint8 is always lossless
+        discardBits = 0;
+    }
+
+    size_t headerPos = out.size();
+    putLE(out, RAWFILECODEC_CHUNK_MAGIC, 4);
+    putLE(out, numValues, 4);
+    putLE(out, 0, 4);   // payload size is filled at the end
+    putLE(out, containerBits, 1);
+    putLE(out, discardBits, 1);
+    putLE(out, 0, 2);
+    size_t payloadPos = out.size();
+
+    const int16_t * inS16 = reinterpret_cast<const int16_t *>(in);
+    const int32_t round = (discardBits > 0) ? (1 << (discardBits - 1)) : 0;
+    const int32_t maxVal = INT16_MAX >> discardBits;
+    uint32_t u[RAWFILECODEC_PARTITION];
+
+    BitWriter writer(out);
+    for (uint32_t start = 0; start < numValues; start += RAWFILECODEC_PARTITION)
+    {
+        uint32_t count = std::min<uint32_t>(RAWFILECODEC_PARTITION, numValues - start);
+
+        // residuals are zigzag mapped to unsigned values
+        uint64_t sum = 0;
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            int32_t r;
+            if (8 == containerBits)
+            {
+                r = int32_t(in[start + n]) - 128;
+            }
+            else
+            {
+                r = std::min((int32_t(inS16[start + n]) + round) >> discardBits, maxVal);
+            }
+            u[n] = (uint32_t(r) << 1) ^ uint32_t(r >> 31);
+            sum += u[n];
+        }
+
+        // Rice parameter estimated from mean value, neighbours are checked
+        int kEst = 0;
+        while ((kEst < containerBits) && ((uint64_t(count) << (kEst + 1)) < sum))
+        {
+            kEst += 1;
+        }
+        int bestK = RAWFILECODEC_ESCAPE;
+        uint64_t bestBits = uint64_t(count) * containerBits;
+        for (int k = std::max(0, kEst - 1); k <= std::min(containerBits, kEst + 1); ++k)
+        {
+            uint64_t bits = uint64_t(count) * (k + 1);
+            for (uint32_t n = 0; n < count; ++n)
+            {
+                bits += u[n] >> k;
+            }
+            if (bits < bestBits)
+            {
+                bestBits = bits;
+                bestK = k;
+            }
+        }
+
+        writer.put(bestK, RAWFILECODEC_PARAM_BITS);
+        if (RAWFILECODEC_ESCAPE == bestK)
+        {   // residuals stored with fixed size
+            for (uint32_t n = 0; n < count; ++n)
+            {
+                writer.put(u[n], containerBits);
+            }
+        }
+        else
+        {
+            for (uint32_t n = 0; n < count; ++n)
+            {
+                writer.putRice(u[n], bestK);
+            }
+        }
+    }
+    writer.flush();
+
+    uint32_t payloadBytes = out.size() - payloadPos;
+    for (int n = 0; n < 4; ++n)
+    {
+        out[headerPos + 8 + n] = uint8_t(payloadBytes >> (8*n));
+    }
+}
+
+bool RawFileCodec::readHeader(const uint8_t *header, uint32_t &numValues, uint32_t &payloadBytes, int &containerBits, int &discardBits)
+{
+    if (RAWFILECODEC_CHUNK_MAGIC != getLE(header, 4))
+    {
+        return false;
+    }
+    numValues = getLE(header + 4, 4);
+    payloadBytes = getLE(header + 8, 4);
+    containerBits = header[12];
+    discardBits = header[13];
+
+    return ((8 == containerBits) || (16 == containerBits)) && (discardBits < containerBits);
+}
+
+bool RawFileCodec::decode(const uint8_t *payload, uint32_t payloadBytes, uint32_t numValues, int containerBits, int discardBits, uint8_t *out)
+{
+    int16_t * outS16 = reinterpret_cast<int16_t *>(out);
+
+    BitReader reader(payload, payloadBytes);
+    for (uint32_t start = 0; start < numValues; start += RAWFILECODEC_PARTITION)
+    {
+        uint32_t count = std::min<uint32_t>(RAWFILECODEC_PARTITION, numValues - start);
+        int k = reader.get(RAWFILECODEC_PARAM_BITS);
+        if ((RAWFILECODEC_ESCAPE != k) && (k > containerBits))
+        {
+            return false;
+        }
+        for (uint32_t n = 0; n < count; ++n)
+        {
+            uint32_t u = (RAWFILECODEC_ESCAPE == k) ? reader.get(containerBits) : reader.getRice(k);
+            int32_t r = int32_t(u >> 1) ^ -int32_t(u & 1);
+            if (8 == containerBits)
+            {
+                out[start + n] = uint8_t(r + 128);
+            }
+            else
+            {
+                outS16[start + n] = int16_t(r * (1 << discardBits));
+            }
+        }
+        if (reader.overrun())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+RawFileDecoder::RawFileDecoder(QFile *inputFile) : m_inputFile(inputFile)
+{
+    qint64 dataOffset = m_inputFile->pos();
+    if (!readIndex(dataOffset))
+    {
+        qCInfo(rawFileCodec) << "RAW-FILE: Index not found, scanning chunks";
+        scanChunks(dataOffset);
+    }
+
+    if (m_chunkOffset.empty())
+    {
+        qCCritical(rawFileCodec) << "RAW-FILE: No valid compressed data found";
+        return;
+    }
+
+    // all chunks except the last one have the same size
+    uint8_t header[RAWFILECODEC_CHUNK_HEADER_SIZE];
+    uint32_t payloadBytes;
+    int discardBits;
+    m_inputFile->seek(m_chunkOffset.front());
+    if ((RAWFILECODEC_CHUNK_HEADER_SIZE != m_inputFile->read((char *) header, RAWFILECODEC_CHUNK_HEADER_SIZE))
+        || !RawFileCodec::readHeader(header, m_chunkValues, payloadBytes, m_containerBits, discardBits)
+        || (0 == m_chunkValues))
+    {
+        m_chunkOffset.clear();
+        return;
+    }
+
+    rewind();
+}
+
+bool RawFileDecoder::readIndex(qint64 dataOffset)
+{
+    qint64 fileSize = m_inputFile->size();
+    if (fileSize < dataOffset + RAWFILECODEC_FOOTER_SIZE)
+    {
+        return false;
+    }
+
+    uint8_t footer[RAWFILECODEC_FOOTER_SIZE];
+    if (!m_inputFile->seek(fileSize - RAWFILECODEC_FOOTER_SIZE)
+        || (RAWFILECODEC_FOOTER_SIZE != m_inputFile->read((char *) footer, RAWFILECODEC_FOOTER_SIZE)))
+    {
+        return false;
+    }
+
+    qint64 indexOffset = getLE(footer, 8);
+    uint32_t numChunks = getLE(footer + 8, 4);
+    if ((RAWFILECODEC_INDEX_MAGIC != getLE(footer + 12, 4))
+        || (indexOffset < dataOffset)
+        || (indexOffset + qint64(numChunks) * 8 + RAWFILECODEC_FOOTER_SIZE != fileSize))
+    {
+        return false;
+    }
+
+    QByteArray index;
+    if (m_inputFile->seek(indexOffset))
+    {
+        index = m_inputFile->read(qint64(numChunks) * 8);
+    }
+    if (index.size() != qint64(numChunks) * 8)
+    {
+        return false;
+    }
+
+    m_chunkOffset.resize(numChunks);
+    for (uint32_t n = 0; n < numChunks; ++n)
+    {
+        m_chunkOffset[n] = getLE(reinterpret_cast<const uint8_t *>(index.constData()) + 8*n, 8);
+    }
+    return true;
+}
+
+void RawFileDecoder::scanChunks(qint64 dataOffset)
+{   // recording was interrupted, chunks are found following chunk headers
+    qint64 fileSize = m_inputFile->size();
+    qint64 pos = dataOffset;
+    while (pos + RAWFILECODEC_CHUNK_HEADER_SIZE <= fileSize)
+    {
+        uint8_t header[RAWFILECODEC_CHUNK_HEADER_SIZE];
+        uint32_t numValues;
+        uint32_t payloadBytes;
+        int containerBits;
+        int discardBits;
+        if (!m_inputFile->seek(pos)
+            || (RAWFILECODEC_CHUNK_HEADER_SIZE != m_inputFile->read((char *) header, RAWFILECODEC_CHUNK_HEADER_SIZE))
+            || !RawFileCodec::readHeader(header, numValues, payloadBytes, containerBits, discardBits)
+            || (pos + RAWFILECODEC_CHUNK_HEADER_SIZE + payloadBytes > fileSize))
+        {   // end of valid data
+            break;
+        }
+        m_chunkOffset.push_back(pos);
+        pos += RAWFILECODEC_CHUNK_HEADER_SIZE + payloadBytes;
+    }
+}
+
+bool RawFileDecoder::loadChunk(size_t idx)
+{
+    while (idx < m_chunkOffset.size())
+    {
+        uint8_t header[RAWFILECODEC_CHUNK_HEADER_SIZE];
+        uint32_t numValues;
+        uint32_t payloadBytes;
+        int containerBits;
+        int discardBits;
+        if (m_inputFile->seek(m_chunkOffset[idx])
+            && (RAWFILECODEC_CHUNK_HEADER_SIZE == m_inputFile->read((char *) header, RAWFILECODEC_CHUNK_HEADER_SIZE))
+            && RawFileCodec::readHeader(header, numValues, payloadBytes, containerBits, discardBits)
+            && (numValues <= m_chunkValues) && (containerBits == m_containerBits))
+        {
+            m_payload.resize(payloadBytes);
+            m_decoded.resize(numValues * (containerBits / 8));
+            if ((payloadBytes == m_inputFile->read((char *) m_payload.data(), payloadBytes))
+                && RawFileCodec::decode(m_payload.data(), payloadBytes, numValues, containerBits, discardBits, m_decoded.data()))
+            {
+                m_decodedPos = 0;
+                m_nextChunk = idx + 1;
+                return true;
+            }
+        }
+
+        // corrupted chunk is skipped
+        qCWarning(rawFileCodec) << "RAW-FILE: Corrupted chunk" << idx;
+        idx += 1;
+    }
+
+    m_decoded.clear();
+    m_decodedPos = 0;
+    m_nextChunk = m_chunkOffset.size();
+    return false;
+}
+
+qint64 RawFileDecoder::read(uint8_t *out, qint64 maxBytes)
+{
+    qint64 bytesRead = 0;
+    while (bytesRead < maxBytes)
+    {
+        if (m_decodedPos >= qint64(m_decoded.size()))
+        {
+            if (!loadChunk(m_nextChunk))
+            {   // end of file
+                break;
+            }
+        }
+        qint64 bytes = std::min(maxBytes - bytesRead, qint64(m_decoded.size()) - m_decodedPos);
+        memcpy(out + bytesRead, m_decoded.data() + m_decodedPos, bytes);
+        bytesRead += bytes;
+        m_decodedPos += bytes;
+    }
+    return bytesRead;
+}
+
+bool RawFileDecoder::seek(uint64_t valueIdx)
+{
+    if (m_chunkOffset.empty())
+    {
+        return false;
+    }
+
+    size_t chunkIdx = valueIdx / m_chunkValues;
+    if (!loadChunk(chunkIdx) || (chunkIdx + 1 != m_nextChunk))
+    {   // out of range or chunk corrupted
+        return false;
+    }
+    m_decodedPos = std::min<qint64>((valueIdx % m_chunkValues) * (m_containerBits / 8), m_decoded.size());
+    return true;
+}
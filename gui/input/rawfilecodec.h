@@ -0,0 +1,94 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RAWFILECODEC_H
+#define RAWFILECODEC_H
+
+#include <QFile>
+#include <cstdint>
+#include <vector>
+
+// Compressed raw file container
+//   [XML header padded to RAWFILEINPUT_XML_PADDING] [chunk 0] [chunk 1] ... [index] [footer]
+//   chunk:  header (RAWFILECODEC_CHUNK_HEADER_SIZE bytes) + Rice coded payload
+//   index:  uint64 file offset of every chunk
+//   footer: uint64 index offset, uint32 number of chunks, uint32 magic
+// all values are little endian, index is optional - chunks are scanned if recording was not finished correctly
+#define RAWFILECODEC_CHUNK_MAGIC        (0x435A5149)    // "IQZC"
+#define RAWFILECODEC_INDEX_MAGIC        (0x495A5149)    // "IQZI"
+#define RAWFILECODEC_CHUNK_HEADER_SIZE  (16)
+#define RAWFILECODEC_FOOTER_SIZE        (16)
+#define RAWFILECODEC_CHUNK_VALUES       (1 << 20)       // values (I or Q) per chunk, 256 msec of 2048kHz IQ
+#define RAWFILECODEC_PARTITION          (256)           // values sharing one Rice parameter
+#define RAWFILECODEC_PARAM_BITS         (5)
+#define RAWFILECODEC_ESCAPE             ((1 << RAWFILECODEC_PARAM_BITS) - 1)   // partition is stored without coding
+
+// FLAC-style Rice coding of I/Q values, uint8 (offset 128) or int16 containers
+// int16 values can be coded near-lossless by discarding LSBs (discardBits > 0)
+class RawFileCodec
+{
+public:
+    // appends chunk (header + payload) to out
+    static void encode(const uint8_t * in, uint32_t numValues, int containerBits, int discardBits, std::vector<uint8_t> & out);
+
+    // parses chunk header, returns false if it is not valid
+    static bool readHeader(const uint8_t * header, uint32_t & numValues, uint32_t & payloadBytes, int & containerBits, int & discardBits);
+
+    // decodes payload to numValues uint8 or int16 values, returns false on corrupted data
+    static bool decode(const uint8_t * payload, uint32_t payloadBytes, uint32_t numValues, int containerBits, int discardBits, uint8_t * out);
+};
+
+// sequential and random access reading of compressed raw file
+class RawFileDecoder
+{
+public:
+    // file position shall be at the beginning of data (after XML header)
+    explicit RawFileDecoder(QFile * inputFile);
+    bool isValid() const { return !m_chunkOffset.empty(); }
+    int containerBits() const { return m_containerBits; }
+
+    // returns number of decoded bytes copied to out
+    qint64 read(uint8_t * out, qint64 maxBytes);
+    void rewind() { seek(0); }
+    // seeks to value (I or Q) index, returns false if out of range
+    bool seek(uint64_t valueIdx);
+
+private:
+    QFile * m_inputFile;
+    std::vector<qint64> m_chunkOffset;
+    uint32_t m_chunkValues = 0;
+    int m_containerBits = 8;
+    std::vector<uint8_t> m_payload;
+    std::vector<uint8_t> m_decoded;
+    qint64 m_decodedPos = 0;
+    size_t m_nextChunk = 0;
+
+    bool readIndex(qint64 dataOffset);
+    void scanChunks(qint64 dataOffset);
+    bool loadChunk(size_t idx);
+};
+
+#endif // RAWFILECODEC_H
@@ -27,9 +27,15 @@
 #include <QDebug>
 #include <QLoggingCategory>
 #include <QFile>
+#include <QFileInfo>
 #include <QDomDocument>
+#include <QtEndian>
+#include <QHash>
 #include <complex>
+#include <algorithm>
 #include "rawfileinput.h"
+#include "inputdeviceconverter.h"
+#include "threadpriority.h"
 
 Q_LOGGING_CATEGORY(rawFileInput, "RawFileInput", QtInfoMsg)
 
@@ -50,6 +56,10 @@ RawFileInput::~RawFileInput()
         m_worker->stop();
         m_worker->quit();
         m_worker->wait();
+
+        // worker uses file mapping => delete it before file is closed
+        delete m_worker;
+        m_worker = nullptr;
     }
 
     if (nullptr != m_inputFile)
@@ -76,6 +86,38 @@ bool RawFileInput::openDevice()
         return false;
     }
 
+    openFifo();
+
+    m_deviceDescription.rawFile.isCompressed = false;
+    m_deviceDescription.rawFile.hasWavHeader = false;
+    m_dataOffset = 0;
+    m_dataSize = -1;
+    m_deviceDescription.sample.inputSampleRate = 0;
+
+    // check WAV header, IQ is stored as stereo
+    QByteArray magic = m_inputFile->peek(12);
+    if ((12 == magic.size()) && (magic.startsWith("RIFF") || magic.startsWith("RF64")) && ("WAVE" == magic.mid(8, 4)))
+    {
+        m_deviceDescription.rawFile.hasXmlHeader = false;
+        if (!parseWavHeader())
+        {
+            qCCritical(rawFileInput) << "RAW-FILE: Unsupported WAV file: " << m_fileName;
+            m_inputFile->close();
+            delete m_inputFile;
+            m_inputFile = nullptr;
+
+            return false;
+        }
+        m_deviceDescription.rawFile.hasWavHeader = true;
+        m_dataOffset = m_inputFile->pos();
+        findParts();
+
+        emit fileLength(fileLengthMsec());
+        emit deviceReady();
+
+        return true;
+    }
+
     // check XML header
     QDataStream in(m_inputFile);
     QByteArray xml;
@@ -99,6 +141,7 @@ bool RawFileInput::openDevice()
     {   // not found
         m_deviceDescription.rawFile.hasXmlHeader = false;
     }
+    m_dataOffset = m_deviceDescription.rawFile.hasXmlHeader ? RAWFILEINPUT_XML_PADDING : 0;
 
     if (!m_deviceDescription.rawFile.hasXmlHeader)
     {   // header was not correctly parsed or not found
@@ -112,19 +155,9 @@ bool RawFileInput::openDevice()
         }
         else { /* seek to start OK */ }
     }
+    findParts();
 
-    switch (m_sampleFormat) {
-    case RawFileInputFormat::SAMPLE_FORMAT_U8:
-        //emit fileLength(m_inputFile->size()/(2*2048));
-        emit fileLength(m_inputFile->size() >> (1 + 11));
-        break;
-    case RawFileInputFormat::SAMPLE_FORMAT_S16:
-        //emit fileLength(m_inputFile->size()/(4*2048));
-        emit fileLength(m_inputFile->size() >> (2 + 11));
-        break;
-    default:
-        break;
-    }
+    emit fileLength(fileLengthMsec());
 
     emit deviceReady();
 
@@ -143,20 +176,161 @@ void RawFileInput::setFileFormat(const RawFileInputFormat &sampleFormat)
 
     if (nullptr != m_inputFile)
     {
-        switch (m_sampleFormat) {
-        case RawFileInputFormat::SAMPLE_FORMAT_U8:
-            //emit fileLength(m_inputFile->size()/(2*2048));
-            emit fileLength(m_inputFile->size() >> (1 + 11));
-            break;
-        case RawFileInputFormat::SAMPLE_FORMAT_S16:
-            //emit fileLength(m_inputFile->size()/(4*2048));
-            emit fileLength(m_inputFile->size() >> (2 + 11));
-            break;
-        default:
+        emit fileLength(fileLengthMsec());
+    }
+    else { /* no file opened */ }
+}
+
+int RawFileInput::fileLengthMsec() const
+{
+    qint64 dataSize = 0;
+    for (const auto & part : m_parts)
+    {
+        dataSize += part.dataBytes;
+    }
+
+    // file is always 2048kHz
+    return dataSize / (bytesPerSample(m_sampleFormat) * 2048);
+}
+
+void RawFileInput::findParts()
+{   // first part is input file
+    m_parts.clear();
+    if (m_deviceDescription.rawFile.isCompressed)
+    {   // file size does not correspond to length
+        m_parts.append({ m_fileName, qint64(m_deviceDescription.rawFile.numSamples) * bytesPerSample(m_sampleFormat) });
+    }
+    else
+    {
+        m_parts.append({ m_fileName, (m_dataSize >= 0) ? m_dataSize : (m_inputFile->size() - m_dataOffset) });
+    }
+
+    if (m_deviceDescription.rawFile.hasWavHeader)
+    {   // WAV is never split
+        return;
+    }
+
+    // following parts of split recording are played as one file
+    QFileInfo fileInfo(m_fileName);
+    QString baseName = fileInfo.completeBaseName();
+    int idx = baseName.lastIndexOf(RAWFILEINPUT_PART_SUFFIX);
+    if (idx < 0)
+    {
+        return;
+    }
+    QString numStr = baseName.mid(idx + QString(RAWFILEINPUT_PART_SUFFIX).size());
+    bool isOK = false;
+    int part = numStr.toInt(&isOK);
+    if (!isOK || numStr.isEmpty())
+    {   // not a part
+        return;
+    }
+
+    QString suffix = fileInfo.suffix().isEmpty() ? QString() : ("." + fileInfo.suffix());
+    while (true)
+    {
+        QString fileName = QString("%1/%2%3").arg(fileInfo.path(), baseName.left(idx) + RAWFILEINPUT_PART_SUFFIX)
+                               .arg(++part, numStr.size(), 10, QChar('0'))
+                           + suffix;
+        qint64 dataBytes = QFile::exists(fileName) ? partDataBytes(fileName) : -1;
+        if (dataBytes < 0)
+        {   // last part
             break;
         }
+        m_parts.append({ fileName, dataBytes });
     }
-    else { /* no file opened */ }
+    if (m_parts.size() > 1)
+    {
+        qCInfo(rawFileInput) << "RAW-FILE: Playing" << m_parts.size() << "parts of split recording";
+    }
+}
+
+qint64 RawFileInput::partDataBytes(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return -1;
+    }
+
+    if (m_deviceDescription.rawFile.isCompressed)
+    {   // length of compressed part is known only from its header
+        QByteArray xml = file.peek(RAWFILEINPUT_XML_PADDING);
+        int idx = xml.indexOf(char(0));
+        if (idx >= 0)
+        {
+            xml.truncate(idx);
+        }
+        QDomDocument xmlHeader;
+        if (!xmlHeader.setContent(xml))
+        {
+            return -1;
+        }
+        QDomElement datablock = xmlHeader.documentElement().firstChildElement("Datablocks").firstChildElement("Datablock");
+        bool isOK = false;
+        qint64 count = datablock.attribute("Count").toLongLong(&isOK);
+        return isOK ? ((count / 2) * bytesPerSample(m_sampleFormat)) : -1;
+    }
+
+    return qMax(qint64(0), file.size() - m_dataOffset);
+}
+
+int RawFileInput::bytesPerSample(const RawFileInputFormat &sampleFormat)
+{
+    switch (sampleFormat)
+    {
+    case RawFileInputFormat::SAMPLE_FORMAT_U8:
+    case RawFileInputFormat::SAMPLE_FORMAT_S8:
+        return 2 * sizeof(uint8_t);
+    case RawFileInputFormat::SAMPLE_FORMAT_S16:
+    case RawFileInputFormat::SAMPLE_FORMAT_U16:
+        return 2 * sizeof(int16_t);
+    case RawFileInputFormat::SAMPLE_FORMAT_S12P:
+        return sizeof(InputDeviceS12Packed);
+    case RawFileInputFormat::SAMPLE_FORMAT_F32:
+        return 2 * sizeof(float);
+    }
+    return 2;
+}
+
+bool RawFileInput::formatFromName(const QString &name, RawFileInputFormat &sampleFormat)
+{
+    static const QHash<QString, RawFileInputFormat> names = {
+        { "u8", RawFileInputFormat::SAMPLE_FORMAT_U8 },   { "cu8", RawFileInputFormat::SAMPLE_FORMAT_U8 },   { "uint8", RawFileInputFormat::SAMPLE_FORMAT_U8 },
+        { "s8", RawFileInputFormat::SAMPLE_FORMAT_S8 },   { "cs8", RawFileInputFormat::SAMPLE_FORMAT_S8 },   { "int8", RawFileInputFormat::SAMPLE_FORMAT_S8 },
+        { "s16", RawFileInputFormat::SAMPLE_FORMAT_S16 }, { "cs16", RawFileInputFormat::SAMPLE_FORMAT_S16 }, { "int16", RawFileInputFormat::SAMPLE_FORMAT_S16 },
+        { "u16", RawFileInputFormat::SAMPLE_FORMAT_U16 }, { "cu16", RawFileInputFormat::SAMPLE_FORMAT_U16 }, { "uint16", RawFileInputFormat::SAMPLE_FORMAT_U16 },
+        { "s12", RawFileInputFormat::SAMPLE_FORMAT_S12P }, { "cs12", RawFileInputFormat::SAMPLE_FORMAT_S12P }, { "int12", RawFileInputFormat::SAMPLE_FORMAT_S12P },
+        { "f32", RawFileInputFormat::SAMPLE_FORMAT_F32 }, { "cf32", RawFileInputFormat::SAMPLE_FORMAT_F32 }, { "float32", RawFileInputFormat::SAMPLE_FORMAT_F32 },
+        { "float", RawFileInputFormat::SAMPLE_FORMAT_F32 },
+    };
+    auto it = names.constFind(name.toLower());
+    if (names.constEnd() == it)
+    {
+        return false;
+    }
+    sampleFormat = *it;
+    return true;
+}
+
+QString RawFileInput::formatName(const RawFileInputFormat &sampleFormat)
+{
+    switch (sampleFormat)
+    {
+    case RawFileInputFormat::SAMPLE_FORMAT_U8:
+        return "uint8";
+    case RawFileInputFormat::SAMPLE_FORMAT_S8:
+        return "int8";
+    case RawFileInputFormat::SAMPLE_FORMAT_S16:
+        return "int16";
+    case RawFileInputFormat::SAMPLE_FORMAT_U16:
+        return "uint16";
+    case RawFileInputFormat::SAMPLE_FORMAT_S12P:
+        return "int12";
+    case RawFileInputFormat::SAMPLE_FORMAT_F32:
+        return "float32";
+    }
+    return "";
 }
 
 void RawFileInput::tune(uint32_t freq)
@@ -165,22 +339,60 @@ void RawFileInput::tune(uint32_t freq)
     rewind();
 
     // Reset buffer here - worker thread it not running, DAB waits for new data
-    inputBuffer.reset();
+    m_inputBuffer->reset();
 
+    m_frequency = freq;
     if (0 != freq)
     {
-        m_worker = new RawFileWorker(m_inputFile, m_sampleFormat, this);
-        connect(m_worker, &RawFileWorker::bytesRead, this, &RawFileInput::onBytesRead, Qt::QueuedConnection);
-        connect(m_worker, &RawFileWorker::endOfFile, this, &RawFileInput::onEndOfFile, Qt::QueuedConnection);        
-        connect(m_worker, &RawFileWorker::finished, m_worker, &QObject::deleteLater);
-        connect(m_worker, &RawFileWorker::destroyed, this, [=]() { m_worker = nullptr; } );
-        m_worker->start();
+        startWorker(0);
+    }
+    emit tuned(freq);
+}
+
+void RawFileInput::seek(int msec)
+{
+    if ((nullptr == m_worker) || (0 == m_frequency))
+    {   // not playing
+        return;
+    }
 
-        m_inputTimer = new QTimer(this);
+    stop();
+    rewind();
+
+    // samples before seek are discarded, DAB processing sees discontinuity and resynchronizes
+    m_inputBuffer->reset();
+
+    // file is always 2048kHz
+    uint64_t valueIdx = 2 * uint64_t(qMax(0, msec)) * 2048;
+    startWorker(valueIdx);
+    onBytesRead((valueIdx / 2) * bytesPerSample(m_sampleFormat));
+}
+
+void RawFileInput::startWorker(uint64_t valueIdx)
+{
+    m_worker = new RawFileWorker(m_inputBuffer, m_inputFile, m_sampleFormat, m_fastReplay, m_deviceDescription.rawFile.isCompressed, m_dataSize, this);
+    m_worker->setParts(m_parts);
+    m_worker->setPosition(valueIdx);
+    connect(m_worker, &RawFileWorker::bytesRead, this, &RawFileInput::onBytesRead, Qt::QueuedConnection);
+    connect(m_worker, &RawFileWorker::endOfFile, this, &RawFileInput::onEndOfFile, Qt::QueuedConnection);        
+    connect(m_worker, &RawFileWorker::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &RawFileWorker::destroyed, this, [=]() { m_worker = nullptr; } );
+    m_worker->start();
+
+    if (!m_fastReplay)
+    {   // worker is paced by timer
+        if (nullptr == m_inputTimer)
+        {
+            m_inputTimer = new QTimer(this);
+        }
+        else
+        {   // timer is reused, old worker does not exist anymore
+            m_inputTimer->disconnect();
+        }
         connect(m_inputTimer, &QTimer::timeout, m_worker, &RawFileWorker::trigger);
-        m_inputTimer->start(INPUT_CHUNK_MS);
+        m_inputTimer->start(InputDevice::fifoConfig().chunkMs);
     }
-    emit tuned(freq);
+    else { /* worker is paced by FIFO */ }
 }
 
 void RawFileInput::rewind()
@@ -190,7 +402,7 @@ void RawFileInput::rewind()
         // go to file beginning
         if (nullptr != m_inputFile)
         {
-            m_inputFile->seek(m_deviceDescription.rawFile.hasXmlHeader ? (RAWFILEINPUT_XML_PADDING) : (0));
+            m_inputFile->seek(m_dataOffset);
             emit fileProgress(0);
         }
     }
@@ -198,16 +410,7 @@ void RawFileInput::rewind()
 
 void RawFileInput::onBytesRead(quint64 bytesRead)
 {
-    switch (m_sampleFormat) {
-    case RawFileInputFormat::SAMPLE_FORMAT_U8:
-        emit fileProgress(bytesRead >> (1 + 11));
-        break;
-    case RawFileInputFormat::SAMPLE_FORMAT_S16:
-        emit fileProgress(bytesRead >> (2 + 11));
-        break;
-    default:
-        break;
-    }
+    emit fileProgress(bytesRead / (bytesPerSample(m_sampleFormat) * 2048));
 }
 
 void RawFileInput::parseXmlHeader(const QByteArray &xml)
@@ -272,6 +475,17 @@ void RawFileInput::parseXmlHeader(const QByteArray &xml)
                                 {
                                     m_deviceDescription.sample.sampleRate = 1000 * sampleRate;
                                 }
+                                if (2048000 != m_deviceDescription.sample.sampleRate)
+                                {
+                                    qCWarning(rawFileInput) << "RAW-FILE: Sample rate" << m_deviceDescription.sample.sampleRate << "Hz, only 2048000 Hz is supported";
+                                }
+                                else { /* OK, stream is passed to demodulator without SRC */ }
+                            }
+                            else if ("Resampler" == sampleElement.tagName())
+                            {   // file was recorded after SRC, informative only
+                                bool isOK = false;
+                                int inputRate = sampleElement.attribute("InputRate", "0").toInt(&isOK);
+                                m_deviceDescription.sample.inputSampleRate = isOK ? inputRate : 0;
                             }
                             else if ("Channels" == sampleElement.tagName())
                             {
@@ -285,15 +499,11 @@ void RawFileInput::parseXmlHeader(const QByteArray &xml)
                                 else { /* OK */ }
                                 m_deviceDescription.sample.channelBits = bits;
                                 m_deviceDescription.sample.channelContainer = sampleElement.attribute("Container", "uint8");
-                                if ("uint8" == m_deviceDescription.sample.channelContainer.toLower())
-                                {
-                                    m_deviceDescription.sample.containerBits = 8;
-                                    setFileFormat(RawFileInputFormat::SAMPLE_FORMAT_U8);
-                                }
-                                else if ("int16" == m_deviceDescription.sample.channelContainer.toLower())
-                                {
-                                    m_deviceDescription.sample.containerBits = 16;
-                                    setFileFormat(RawFileInputFormat::SAMPLE_FORMAT_S16);
+                                RawFileInputFormat format;
+                                if (formatFromName(m_deviceDescription.sample.channelContainer, format))
+                                {   // I or Q container
+                                    m_deviceDescription.sample.containerBits = bytesPerSample(format) * 4;
+                                    setFileFormat(format);
                                 }
                                 else
                                 {
@@ -332,6 +542,17 @@ void RawFileInput::parseXmlHeader(const QByteArray &xml)
                         sampleNode = sampleNode.nextSibling();
                     }
                 }
+                else if ("Compression" == sdrElement.tagName())
+                {
+                    if ("Rice" == sdrElement.attribute("Codec", ""))
+                    {
+                        m_deviceDescription.rawFile.isCompressed = true;
+                    }
+                    else
+                    {
+                        qCWarning(rawFileInput) << QString("RAW-FILE: Compression '%1' not supported").arg(sdrElement.attribute("Codec", ""));
+                    }
+                }
                 else if ("Datablocks" == sdrElement.tagName())
                 {
                     QDomNode datablocksNode = sdrElement.firstChild();
@@ -402,6 +623,11 @@ void RawFileInput::parseXmlHeader(const QByteArray &xml)
     qCDebug(rawFileInput) << "Device name:" << m_deviceDescription.device.name;
     qCDebug(rawFileInput) << "Device model:" << m_deviceDescription.device.model;
     qCDebug(rawFileInput) << "Samplerate [Hz]:" << m_deviceDescription.sample.sampleRate;
+    if (0 != m_deviceDescription.sample.inputSampleRate)
+    {
+        qCDebug(rawFileInput) << "Resampled from [Hz]:" << m_deviceDescription.sample.inputSampleRate;
+    }
+    else { /* native stream */ }
     qCDebug(rawFileInput) << "Container:" << QString("%1 [%2 bits], channel data %3 bits")
                                     .arg(m_deviceDescription.sample.channelContainer)
                                     .arg(m_deviceDescription.sample.containerBits)
@@ -411,6 +637,124 @@ void RawFileInput::parseXmlHeader(const QByteArray &xml)
     qCDebug(rawFileInput) << "RF [kHz]:" << m_deviceDescription.rawFile.frequency_kHz;
 }
 
+bool RawFileInput::parseWavHeader()
+{   // RIFF or RF64 (EBU Tech 3306), file is read sequentially so that it works also for pipes
+    QByteArray riff = m_inputFile->read(12);
+    const bool isRF64 = riff.startsWith("RF64");
+    quint64 rf64DataSize = 0;
+    bool hasFormat = false;
+
+    m_deviceDescription.rawFile.recorder = "N/A";
+    m_deviceDescription.rawFile.time = "N/A";
+    m_deviceDescription.rawFile.frequency_kHz = 0;
+    m_deviceDescription.device.name = "N/A";
+    m_deviceDescription.device.model = "N/A";
+
+    while (true)
+    {
+        QByteArray chunkHeader = m_inputFile->read(8);
+        if (chunkHeader.size() < 8)
+        {
+            qCWarning(rawFileInput) << "RAW-FILE: WAV data chunk not found";
+            return false;
+        }
+        const QByteArray chunkId = chunkHeader.left(4);
+        quint64 chunkSize = qFromLittleEndian<quint32>(chunkHeader.constData() + 4);
+
+        if ("data" == chunkId)
+        {   // samples follow, size is not known when recording was not finished correctly
+            if (isRF64 && (0xFFFFFFFF == chunkSize))
+            {
+                chunkSize = rf64DataSize;
+            }
+            m_dataSize = ((0 == chunkSize) || (0xFFFFFFFF == chunkSize)) ? -1 : qint64(chunkSize);
+            break;
+        }
+
+        // word aligned chunks
+        QByteArray chunk = m_inputFile->read(chunkSize + (chunkSize & 1));
+        if (chunk.size() < qint64(chunkSize))
+        {
+            qCWarning(rawFileInput) << "RAW-FILE: WAV file is truncated";
+            return false;
+        }
+        const char * data = chunk.constData();
+
+        if (("ds64" == chunkId) && (chunkSize >= 24))
+        {   // 64 bit RIFF size, data size and sample count
+            rf64DataSize = qFromLittleEndian<quint64>(data + 8);
+        }
+        else if (("fmt " == chunkId) && (chunkSize >= 16))
+        {
+            uint16_t formatTag = qFromLittleEndian<quint16>(data);
+            uint16_t numChannels = qFromLittleEndian<quint16>(data + 2);
+            uint32_t sampleRate = qFromLittleEndian<quint32>(data + 4);
+            uint16_t bitsPerSample = qFromLittleEndian<quint16>(data + 14);
+            uint16_t validBits = bitsPerSample;
+            if ((0xFFFE == formatTag) && (chunkSize >= 26))
+            {   // WAVE_FORMAT_EXTENSIBLE, format is in first bytes of subformat GUID
+                validBits = qFromLittleEndian<quint16>(data + 18);
+                formatTag = qFromLittleEndian<quint16>(data + 24);
+            }
+
+            if (2 != numChannels)
+            {
+                qCWarning(rawFileInput) << "RAW-FILE: WAV file shall have 2 channels (I and Q), found:" << numChannels;
+                return false;
+            }
+
+            RawFileInputFormat format;
+            if ((1 == formatTag) && (8 == bitsPerSample))
+            {   // PCM 8 bits is unsigned
+                format = RawFileInputFormat::SAMPLE_FORMAT_U8;
+            }
+            else if ((1 == formatTag) && (16 == bitsPerSample))
+            {
+                format = RawFileInputFormat::SAMPLE_FORMAT_S16;
+            }
+            else if ((3 == formatTag) && (32 == bitsPerSample))
+            {   // IEEE float
+                format = RawFileInputFormat::SAMPLE_FORMAT_F32;
+            }
+            else
+            {
+                qCWarning(rawFileInput) << QString("RAW-FILE: WAV format %1 with %2 bits not supported").arg(formatTag).arg(bitsPerSample);
+                return false;
+            }
+            if (2048000 != sampleRate)
+            {
+                qCWarning(rawFileInput) << "RAW-FILE: WAV sample rate" << sampleRate << "Hz, only 2048000 Hz is supported";
+            }
+
+            m_deviceDescription.sample.sampleRate = sampleRate;
+            m_deviceDescription.sample.channelBits = validBits;
+            m_deviceDescription.sample.containerBits = bitsPerSample;
+            m_deviceDescription.sample.channelContainer = formatName(format);
+            setFileFormat(format);
+            hasFormat = true;
+        }
+        else if (("auxi" == chunkId) && (chunkSize >= 36))
+        {   // SDR# auxiliary chunk: start time, stop time (SYSTEMTIME), center frequency [Hz]
+            m_deviceDescription.rawFile.frequency_kHz = qFromLittleEndian<quint32>(data + 32) / 1000;
+        }
+        else
+        { /* other chunks are skipped */ }
+    }
+
+    if (!hasFormat)
+    {
+        qCWarning(rawFileInput) << "RAW-FILE: WAV format chunk not found before data";
+        return false;
+    }
+
+    const int bps = bytesPerSample(m_sampleFormat);
+    m_deviceDescription.rawFile.numSamples = (m_dataSize >= 0) ? (m_dataSize / bps) : ((m_inputFile->size() - m_inputFile->pos()) / bps);
+
+    qCInfo(rawFileInput) << "RAW-FILE:" << (isRF64 ? "RF64" : "WAV") << "file," << m_deviceDescription.sample.channelContainer
+                         << "samples, RF [kHz]:" << m_deviceDescription.rawFile.frequency_kHz;
+    return true;
+}
+
 void RawFileInput::stop()
 {
     if (nullptr != m_inputTimer)
@@ -420,15 +764,12 @@ void RawFileInput::stop()
     if (nullptr != m_worker)
     {
         m_worker->stop();        
-        m_worker->wait(INPUT_CHUNK_MS*2);
+        m_worker->wait(InputDevice::fifoConfig().chunkMs*2);
         while (!m_worker->isFinished())
         {
             // reset buffer - and tell the thread it is empty - buffer will be reset in any case
-            pthread_mutex_lock(&inputBuffer.countMutex);
-            inputBuffer.count = 0;
-            pthread_cond_signal(&inputBuffer.countCondition);
-            pthread_mutex_unlock(&inputBuffer.countMutex);
-            m_worker->wait(INPUT_CHUNK_MS*2);
+            m_inputBuffer->flush();
+            m_worker->wait(InputDevice::fifoConfig().chunkMs*2);
         }
         delete m_worker;
         m_worker = nullptr;
@@ -436,16 +777,159 @@ void RawFileInput::stop()
 }
 
 
-RawFileWorker::RawFileWorker(QFile *inputFile, RawFileInputFormat sampleFormat, QObject *parent)
+RawFileWorker::RawFileWorker(fifo_t * fifo, QFile *inputFile, RawFileInputFormat sampleFormat, bool fastReplay, bool isCompressed,
+                             qint64 dataSize, QObject *parent)
     : QThread(parent)
-    , m_sampleFormat(sampleFormat)
+    , m_inputBuffer(fifo)
     , m_inputFile(inputFile)
+    , m_sampleFormat(sampleFormat)
+    , m_fastReplay(fastReplay)
+    , m_isCompressed(isCompressed)
 {
     m_bytesRead = 0;
     m_stopRequest = false;
+
+    // file position is set to the beginning of data, all parts have the same header size
+    m_dataOffset = m_inputFile->pos();
+    m_inputDataSize = dataSize;
+    attachFile(m_inputFile, dataSize);
+
     m_elapsedTimer.start();
 }
 
+RawFileWorker::~RawFileWorker()
+{
+    detachFile();
+    if (nullptr != m_buffer)
+    {
+        operator delete [] (m_buffer, std::align_val_t(16));
+    }
+}
+
+void RawFileWorker::attachFile(QFile *file, qint64 dataSize)
+{   // file position is at the beginning of data
+    m_file = file;
+    m_dataSize = dataSize;
+    m_dataRemaining = dataSize;
+    if (m_isCompressed)
+    {   // data is decoded chunk by chunk, file is not mapped
+        m_decoder = new RawFileDecoder(m_file);
+        return;
+    }
+
+    m_mapSize = m_file->size();
+    if (m_dataSize >= 0)
+    {   // trailing chunks (WAV) are not mapped
+        m_mapSize = qMin(m_mapSize, m_dataOffset + m_dataSize);
+    }
+    if (m_mapSize > 0)
+    {
+        m_mapPtr = m_file->map(0, m_mapSize);
+    }
+    if (nullptr != m_mapPtr)
+    {
+        m_mapPos = m_dataOffset;
+    }
+    else
+    {   // not possible to map (FIFO?), buffer is allocated when needed
+        qCInfo(rawFileInput) << "RAW-FILE: File cannot be mapped to memory, reading to buffer";
+        m_mapSize = 0;
+    }
+}
+
+void RawFileWorker::detachFile()
+{
+    delete m_decoder;
+    m_decoder = nullptr;
+    if (nullptr != m_mapPtr)
+    {
+        m_file->unmap(m_mapPtr);
+        m_mapPtr = nullptr;
+    }
+    m_mapSize = 0;
+    if (nullptr != m_partFile)
+    {
+        m_partFile->close();
+        delete m_partFile;
+        m_partFile = nullptr;
+    }
+    m_file = nullptr;
+}
+
+bool RawFileWorker::openPart(int idx)
+{
+    detachFile();
+    m_partIdx = idx;
+    if (0 == idx)
+    {   // input file is owned by RawFileInput
+        m_inputFile->seek(m_dataOffset);
+        attachFile(m_inputFile, m_inputDataSize);
+        return true;
+    }
+
+    m_partFile = new QFile(m_parts.at(idx).fileName);
+    if (!m_partFile->open(QIODevice::ReadOnly) || !m_partFile->seek(m_dataOffset))
+    {
+        qCWarning(rawFileInput) << "RAW-FILE: Unable to open file: " << m_parts.at(idx).fileName;
+        delete m_partFile;
+        m_partFile = nullptr;
+
+        // playback continues from the beginning
+        m_partIdx = 0;
+        m_inputFile->seek(m_dataOffset);
+        attachFile(m_inputFile, m_inputDataSize);
+        return false;
+    }
+    qCInfo(rawFileInput) << "RAW-FILE: Playing" << m_parts.at(idx).fileName;
+    attachFile(m_partFile, -1);
+    return true;
+}
+
+void RawFileWorker::setPosition(uint64_t valueIdx)
+{
+    qint64 offset = (valueIdx / 2) * RawFileInput::bytesPerSample(m_sampleFormat);
+
+    // find part, offset is relative to its beginning
+    qint64 partStart = 0;
+    int part = 0;
+    while ((part + 1 < m_parts.size()) && (offset - partStart >= m_parts.at(part).dataBytes))
+    {
+        partStart += m_parts.at(part++).dataBytes;
+    }
+    if ((part > 0) && openPart(part))
+    {
+        offset -= partStart;
+        valueIdx = (offset / RawFileInput::bytesPerSample(m_sampleFormat)) * 2;
+    }
+    else
+    {
+        partStart = 0;
+    }
+
+    if (nullptr != m_decoder)
+    {
+        if (!m_decoder->seek(valueIdx))
+        {   // beyond the end, reading returns end of file
+            offset = 0;
+            m_decoder->rewind();
+        }
+    }
+    else if (nullptr != m_mapPtr)
+    {
+        offset = qMin(offset, m_mapSize - m_dataOffset);
+        m_mapPos = m_dataOffset + offset;
+    }
+    else
+    {
+        if (!m_file->seek(m_dataOffset + offset))
+        {   // not seekable
+            offset = 0;
+        }
+        m_dataRemaining = (m_dataSize >= 0) ? qMax(qint64(0), m_dataSize - offset) : -1;
+    }
+    m_bytesRead = partStart + offset;
+}
+
 void RawFileWorker::trigger()
 {
     m_semaphore.release();
@@ -459,127 +943,178 @@ void RawFileWorker::stop()
 
 void RawFileWorker::run()
 {
-    while(1)
-    {
-        m_semaphore.acquire();
+    ThreadPriority::update(ThreadClass::Input);
 
-        if (m_stopRequest)
-        {   // stop request
-            return;
-        }
+    const qint64 bytesPerSample = RawFileInput::bytesPerSample(m_sampleFormat);
 
-        qint64 elapsed = m_elapsedTimer.elapsed();
-        int period = elapsed - m_lastTriggerTime;
-        m_lastTriggerTime = elapsed;
+    // pacing period can be longer than chunk => limited to half of FIFO so that waiting for space completes
+    const uint64_t chunkIQSamples = uint64_t(2048) * InputDevice::fifoConfig().chunkMs;
+    const uint64_t maxChunkIQSamples = m_inputBuffer->size / (2*sizeof(float) * 2);
 
-        uint64_t samplesRead = 0;
-        uint64_t input_chunk_iq_samples = period * 2048;
+    while(1)
+    {
+        uint64_t input_chunk_iq_samples;
+        if (m_fastReplay)
+        {   // no pacing, FIFO blocks the reading
+            if (m_stopRequest)
+            {   // stop request
+                return;
+            }
+            input_chunk_iq_samples = chunkIQSamples;
+        }
+        else
+        {
+            m_semaphore.acquire();
 
-        // get FIFO space
-        pthread_mutex_lock(&inputBuffer.countMutex);
-        uint64_t count = inputBuffer.count;
-        Q_ASSERT(count <= INPUT_FIFO_SIZE);
+            if (m_stopRequest)
+            {   // stop request
+                return;
+            }
 
-        while ((INPUT_FIFO_SIZE - count) < input_chunk_iq_samples*sizeof(float)*2)
-        {
+            qint64 elapsed = m_elapsedTimer.elapsed();
+            int period = elapsed - m_lastTriggerTime;
+            m_lastTriggerTime = elapsed;
 
-            pthread_cond_wait(&inputBuffer.countCondition, &inputBuffer.countMutex);
-            count = inputBuffer.count;
+            input_chunk_iq_samples = std::min(uint64_t(period) * 2048, maxChunkIQSamples);
         }
-        pthread_mutex_unlock(&inputBuffer.countMutex);
 
-        // there is enough room in buffer
-        uint64_t bytesTillEnd = INPUT_FIFO_SIZE - inputBuffer.head;
-
-        switch (m_sampleFormat)
-        {
-        case RawFileInputFormat::SAMPLE_FORMAT_S16:
-        {
-            int16_t * tmpBuffer = new int16_t[input_chunk_iq_samples*2];
-            uint64_t bytesRead = m_inputFile->read((char *) tmpBuffer, input_chunk_iq_samples * 2 * sizeof(int16_t));
-            m_bytesRead += bytesRead;
+        // get FIFO space
+        m_inputBuffer->waitForSpace(input_chunk_iq_samples*sizeof(float)*2);
+        if (m_stopRequest)
+        {   // stop request while waiting (FIFO was flushed)
+            return;
+        }
 
-            samplesRead = bytesRead >> 1;  // one sample is int16 (I or Q) => 2 bytes
+        // there is enough room in buffer, it is contiguous
+        float * outPtr = (float *) m_inputBuffer->reserve();
 
-            int16_t * inPtr = tmpBuffer;
-            if (bytesTillEnd >= samplesRead * sizeof(float))
-            {
-                float * outPtr = (float *)(inputBuffer.buffer + inputBuffer.head);
-                for (uint64_t k=0; k < samplesRead; k++)
-                {   // convert to float
-                    *outPtr++ = float(*inPtr++);  // I or Q
-                }
-            }
-            else
-            {
-                Q_ASSERT(sizeof(float) == 4);
-                uint64_t samplesTillEnd = (bytesTillEnd >> 2);
-                float * outPtr = (float *)(inputBuffer.buffer + inputBuffer.head);
-                for (uint64_t k=0; k < samplesTillEnd; k++)
-                {   // convert to float
-                    *outPtr++ = float(*inPtr++);  // I or Q
-                }
-                outPtr = (float *)(inputBuffer.buffer);
-                for (uint64_t k=0; k<samplesRead-samplesTillEnd; k++)
-                {   // convert to float
-                    *outPtr++ = float(*inPtr++);  // I or Q
-                }
-            }
-            delete [] tmpBuffer;
-        }
-        break;
-        case RawFileInputFormat::SAMPLE_FORMAT_U8:
-        {
-            uint8_t * tmpBuffer = new uint8_t[input_chunk_iq_samples*2];
-            uint64_t bytesRead = m_inputFile->read((char *) tmpBuffer, input_chunk_iq_samples * 2 * sizeof(uint8_t));
+        // number of values (I and Q), incomplete IQ sample at the end is dropped
+        uint64_t samplesRead = 0;
+        qint64 bytesRemaining = input_chunk_iq_samples * bytesPerSample;
+        while (bytesRemaining > 0)
+        {   // chunk continues in next part without gap
+            qint64 bytesRead = 0;
+            const uint8_t * inPtr = readChunk(bytesRemaining, bytesRead);
             m_bytesRead += bytesRead;
+            bytesRemaining -= bytesRead;
 
-            samplesRead = bytesRead;  // one sample is uint8 => 1 byte
+            uint64_t numValues = (bytesRead / bytesPerSample) * 2;
+            convert(inPtr, outPtr + samplesRead, numValues);
+            samplesRead += numValues;
 
-            uint8_t * inPtr = tmpBuffer;
-            if (bytesTillEnd >= samplesRead * sizeof(float))
-            {
-                float * outPtr = (float *)(inputBuffer.buffer + inputBuffer.head);
-                for (uint64_t k=0; k < samplesRead; k++)
-                {   // convert to float
-                    *outPtr++ = float(*inPtr++ - 128);  // I or Q
-                }
+            if ((bytesRemaining > 0) && ((m_partIdx + 1 >= m_parts.size()) || !openPart(m_partIdx + 1)))
+            {   // end of last part
+                break;
             }
-            else
-            {
-                Q_ASSERT(sizeof(float) == 4);
-                uint64_t samplesTillEnd = (bytesTillEnd >> 2);
-                float * outPtr = (float *)(inputBuffer.buffer + inputBuffer.head);
-                for (uint64_t k=0; k < samplesTillEnd; k++)
-                {   // convert to float
-                    *outPtr++ = float(*inPtr++ - 128);  // I or Q
-                }
-                outPtr = (float *)(inputBuffer.buffer);
-                for (uint64_t k=0; k<samplesRead-samplesTillEnd; k++)
-                {   // convert to float
-                    *outPtr++ = float(*inPtr++ - 128);  // I or Q
-                }
-            }
-            delete [] tmpBuffer;
-        }
-        break;
+            else { /* chunk is complete or next part is opened */ }
         }
 
-        inputBuffer.head = (inputBuffer.head + samplesRead*sizeof(float)) % INPUT_FIFO_SIZE;
-        pthread_mutex_lock(&inputBuffer.countMutex);
-        inputBuffer.count = inputBuffer.count + samplesRead*sizeof(float);
-        pthread_cond_signal(&inputBuffer.countCondition);
-        pthread_mutex_unlock(&inputBuffer.countMutex);
+        m_inputBuffer->commitWrite(samplesRead*sizeof(float));
 
         emit bytesRead(m_bytesRead);
 
         if (samplesRead < input_chunk_iq_samples*2)
         {
             qCInfo(rawFileInput) << "RAW-FILE: End of file";
-            m_inputFile->seek(0);
+            if (m_fastReplay)
+            {   // file is processed only once in fast replay
+                emit endOfFile();
+                return;
+            }
+            rewindFile();
             m_bytesRead = 0;
             emit endOfFile();
             emit bytesRead(m_bytesRead);
         }
     }
 }
+
+void RawFileWorker::convert(const uint8_t *in, float *out, uint64_t numValues) const
+{
+    switch (m_sampleFormat)
+    {
+    case RawFileInputFormat::SAMPLE_FORMAT_S16:
+        InputDeviceConverter<int16_t>().process((const int16_t *) in, out, numValues);
+        break;
+    case RawFileInputFormat::SAMPLE_FORMAT_U8:
+        // DC and level are not used here
+        InputDeviceConverter<uint8_t>().process(in, out, numValues);
+        break;
+    case RawFileInputFormat::SAMPLE_FORMAT_S8:
+        InputDeviceConverter<int8_t>().process((const int8_t *) in, out, numValues);
+        break;
+    case RawFileInputFormat::SAMPLE_FORMAT_U16:
+        InputDeviceConverter<uint16_t>().process((const uint16_t *) in, out, numValues);
+        break;
+    case RawFileInputFormat::SAMPLE_FORMAT_S12P:
+        InputDeviceConverter<InputDeviceS12Packed>().process((const InputDeviceS12Packed *) in, out, numValues);
+        break;
+    case RawFileInputFormat::SAMPLE_FORMAT_F32:
+        // native format, mapped file is copied directly to FIFO
+        InputDeviceConverter<float>().process((const float *) in, out, numValues);
+        break;
+    }
+}
+
+const uint8_t * RawFileWorker::readChunk(qint64 maxBytes, qint64 & bytesRead)
+{
+    if (nullptr != m_mapPtr)
+    {   // data are read directly from mapped file
+        bytesRead = qMin(maxBytes, m_mapSize - m_mapPos);
+        const uint8_t * ptr = m_mapPtr + m_mapPos;
+        m_mapPos += bytesRead;
+        return ptr;
+    }
+
+    if (maxBytes > m_bufferSize)
+    {   // buffer is reallocated only when chunk is bigger than ever before
+        if (nullptr != m_buffer)
+        {
+            operator delete [] (m_buffer, std::align_val_t(16));
+        }
+        m_buffer = new ( std::align_val_t(16) ) uint8_t[maxBytes];
+        m_bufferSize = maxBytes;
+    }
+
+    if (nullptr != m_decoder)
+    {
+        bytesRead = m_decoder->read(m_buffer, maxBytes);
+        return m_buffer;
+    }
+
+    if (m_dataRemaining >= 0)
+    {   // data chunk can be followed by other chunks (WAV)
+        maxBytes = qMin(maxBytes, m_dataRemaining);
+    }
+    bytesRead = m_file->read((char *) m_buffer, maxBytes);
+    if (bytesRead < 0)
+    {   // read error
+        bytesRead = 0;
+    }
+    if (m_dataRemaining >= 0)
+    {
+        m_dataRemaining -= bytesRead;
+    }
+    return m_buffer;
+}
+
+void RawFileWorker::rewindFile()
+{
+    if (0 != m_partIdx)
+    {   // back to first part
+        openPart(0);
+    }
+    else if (nullptr != m_decoder)
+    {
+        m_decoder->rewind();
+    }
+    else if (nullptr != m_mapPtr)
+    {
+        m_mapPos = m_dataOffset;
+    }
+    else
+    {
+        m_file->seek(m_dataOffset);
+        m_dataRemaining = m_dataSize;
+    }
+}
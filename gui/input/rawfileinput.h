@@ -35,35 +35,87 @@
 #include <QElapsedTimer>
 #include <QSemaphore>
 #include "inputdevice.h"
+#include "rawfilecodec.h"
 
 #define RAWFILEINPUT_XML_PADDING 2048
 
+// split recording parts are named <name>_partNNN.<ext> (see InputDeviceRecorder)
+#define RAWFILEINPUT_PART_SUFFIX "_part"
+
 enum class RawFileInputFormat
 {
     SAMPLE_FORMAT_U8,
     SAMPLE_FORMAT_S16,
+    SAMPLE_FORMAT_S8,       // cs8
+    SAMPLE_FORMAT_U16,      // cu16, offset binary
+    SAMPLE_FORMAT_S12P,     // cs12, IQ pair packed in 3 bytes
+    SAMPLE_FORMAT_F32,      // cf32, copied to FIFO without conversion
+};
+
+// one file of playlist, all parts have the same format and header size
+struct RawFilePart
+{
+    QString fileName;
+    qint64 dataBytes;     // sample data (decoded data for compressed file)
 };
 
 class RawFileWorker : public QThread
 {
     Q_OBJECT
 public:
-    explicit RawFileWorker(QFile * inputFile, RawFileInputFormat sampleFormat, QObject *parent = nullptr);
+    // dataSize is number of bytes from current file position, -1 means until the end of file
+    explicit RawFileWorker(fifo_t * fifo, QFile * inputFile, RawFileInputFormat sampleFormat, bool fastReplay = false, bool isCompressed = false,
+                           qint64 dataSize = -1, QObject *parent = nullptr);
+    ~RawFileWorker();
     void trigger();
     void stop();
+
+    // parts following the input file are played seamlessly, shall be called before thread is started
+    void setParts(const QList<RawFilePart> & parts) { m_parts = parts; }
+
+    // sets reading position in values (I or Q) from beginning of playlist, shall be called before thread is started
+    void setPosition(uint64_t valueIdx);
 protected:
     void run() override;
 signals:
     void bytesRead(qint64 numBytes);
     void endOfFile();
 private:
+    fifo_t * m_inputBuffer;
     QAtomicInt m_stopRequest = false;
     QSemaphore m_semaphore;
     QFile * m_inputFile = nullptr;
+    QFile * m_file = nullptr;         // current part, input file or m_partFile
+    QFile * m_partFile = nullptr;     // opened by worker
+    QList<RawFilePart> m_parts;
+    int m_partIdx = 0;
+    bool m_isCompressed;
     QElapsedTimer m_elapsedTimer;
     qint64 m_lastTriggerTime = 0;
     RawFileInputFormat m_sampleFormat;
     qint64 m_bytesRead;
+    bool m_fastReplay;
+
+    // file is memory mapped if possible, reusable buffer is used otherwise
+    uchar * m_mapPtr = nullptr;
+    qint64 m_mapSize = 0;
+    qint64 m_mapPos = 0;
+    qint64 m_dataOffset = 0;
+    qint64 m_dataSize = -1;          // current part
+    qint64 m_inputDataSize = -1;     // input file
+    qint64 m_dataRemaining = -1;     // when file is read to buffer
+    uint8_t * m_buffer = nullptr;
+    qint64 m_bufferSize = 0;
+
+    // compressed file is decoded to buffer
+    RawFileDecoder * m_decoder = nullptr;
+
+    void attachFile(QFile * file, qint64 dataSize);
+    void detachFile();
+    bool openPart(int idx);
+    const uint8_t * readChunk(qint64 maxBytes, qint64 & bytesRead);
+    void convert(const uint8_t * in, float * out, uint64_t numValues) const;
+    void rewindFile();
 };
 
 
@@ -77,22 +129,47 @@ public:
     void tune(uint32_t freq) override;
     void setFile(const QString & fileName, const RawFileInputFormat & sampleFormat = RawFileInputFormat::SAMPLE_FORMAT_U8);
     void setFileFormat(const RawFileInputFormat & sampleFormat);
+
+    // fast replay ignores real time and reads as fast as DAB processing consumes samples
+    void setFastReplay(bool ena) { m_fastReplay = ena; }
     void startStopRecording(bool start) override { /* do nothing */ }
+
+    // jumps to position in file during playback, input FIFO is flushed and demodulator resynchronizes
+    void seek(int msec);
+
+    // size of one IQ sample in file
+    static int bytesPerSample(const RawFileInputFormat & sampleFormat);
+
+    // format from name used in command line, file extension or header (u8, cs16, int16, cf32, float32, ...)
+    static bool formatFromName(const QString & name, RawFileInputFormat & sampleFormat);
+
+    // container name used in description (uint8, int16, ...)
+    static QString formatName(const RawFileInputFormat & sampleFormat);
 signals:
     void fileLength(int msec);
     void fileProgress(int msec);
 
 private:
     RawFileInputFormat m_sampleFormat;
+    bool m_fastReplay = false;
     QString m_fileName;
     QFile * m_inputFile = nullptr;
     RawFileWorker * m_worker = nullptr;
     QTimer * m_inputTimer = nullptr;
+    uint32_t m_frequency = 0;
+    qint64 m_dataOffset = 0;        // beginning of samples in file
+    qint64 m_dataSize = -1;         // -1 when samples continue until the end of file
+    QList<RawFilePart> m_parts;     // playlist, first part is input file
     void stop();
     void rewind();
+    void startWorker(uint64_t valueIdx);
     void onBytesRead(quint64 bytesRead);
     void onEndOfFile() { emit error(InputDeviceErrorCode::EndOfFile); }
     void parseXmlHeader(const QByteArray & xml);
+    bool parseWavHeader();
+    void findParts();
+    qint64 partDataBytes(const QString & fileName) const;
+    int fileLengthMsec() const;
 };
 
 
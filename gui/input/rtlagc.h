@@ -0,0 +1,73 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RTLAGC_H
+#define RTLAGC_H
+
+#include <QList>
+#include <cmath>
+#include <algorithm>
+
+// predictive software AGC shared by RTL-SDR and RTL-TCP
+// gain table reported by librtlsdr for the tuner type (0.1 dB) is used to jump directly
+// to the gain that moves measured level to the middle of AGC window
+class RtlAgc
+{
+public:
+    // returns new gain index, levels are mean amplitudes measured by input worker
+    // gainIdx is returned unchanged while level is inside [levelMin, levelMax] (hysteresis)
+    static int gainIdx(const QList<int> & gainList, int gainIdx, float level, float levelMin, float levelMax)
+    {
+        if ((level >= levelMin) && (level <= levelMax))
+        {
+            return gainIdx;
+        }
+        if ((level <= 0.0) || (gainIdx < 0) || (gainIdx >= gainList.size()))
+        {   // no signal, level does not say anything
+            return gainIdx + 1;
+        }
+
+        // gain in 0.1 dB that brings the level to geometric middle of the window
+        float target = gainList.at(gainIdx) + 200.0 * std::log10(std::sqrt(levelMin * levelMax) / level);
+        int bestIdx = 0;
+        for (int n = 1; n < gainList.size(); ++n)
+        {
+            if (std::abs(gainList.at(n) - target) < std::abs(gainList.at(bestIdx) - target))
+            {
+                bestIdx = n;
+            }
+        }
+
+        // level is outside of the window => at least one step in right direction
+        if (level < levelMin)
+        {
+            return std::max(bestIdx, gainIdx + 1);
+        }
+        return std::min(bestIdx, gainIdx - 1);
+    }
+};
+
+#endif // RTLAGC_H
@@ -28,6 +28,8 @@
 #include <QDebug>
 #include <QLoggingCategory>
 #include "rtlsdrinput.h"
+#include "rtlagc.h"
+#include "threadpriority.h"
 
 Q_LOGGING_CATEGORY(rtlsdrInput, "RtlSdrInput", QtInfoMsg)
 
@@ -69,6 +71,16 @@ RtlSdrInput::~RtlSdrInput()
 
 void RtlSdrInput::tune(uint32_t frequency)
 {
+    // AGC on new frequency starts from gain remembered for it
+    if (0 == m_receiver)
+    {
+        TunerStateCache::getInstance()->updateGain((RtlGainMode::Software == m_gainMode) ? m_gainIdx : -1);
+        m_tunerState = TunerStateCache::getInstance()->tune(m_deviceDescription, frequency);
+    }
+    else
+    {   // cache follows primary receiver only
+        m_tunerState = TunerState();
+    }
     m_frequency = frequency;
     if (0 != frequency)
     {   // tuning
@@ -124,8 +136,23 @@ bool RtlSdrInput::openDevice()
     }
 
     //	Iterate over all found rtl-sdr devices and try to open it. Stops if one device is successfull opened.
+    //  only device with requested serial number is opened if serial is set (reconnection)
     const char * deviceName;
-    for(uint32_t n=0; n<deviceCount; ++n)
+    uint32_t firstIdx = 0;
+    uint32_t lastIdx = deviceCount;
+    if (!m_serial.isEmpty())
+    {
+        int idx = rtlsdr_get_index_by_serial(m_serial.toLatin1().constData());
+        if (idx < 0)
+        {
+            qCWarning(rtlsdrInput) << "Device with serial" << m_serial << "not found";
+            return false;
+        }
+        firstIdx = idx;
+        lastIdx = idx + 1;
+    }
+    uint32_t n;
+    for(n = firstIdx; n < lastIdx; ++n)
     {
         ret = rtlsdr_open(&m_device, n);
         if (ret >= 0)
@@ -193,6 +220,13 @@ bool RtlSdrInput::openDevice()
     {
         m_deviceDescription.device.model = QString(deviceName);
     }
+    char manufacturer[256];
+    char product[256];
+    char serial[256];
+    if (0 == rtlsdr_get_device_usb_strings(n, manufacturer, product, serial))
+    {
+        m_deviceDescription.device.serial = QString(serial);
+    }
     m_deviceDescription.sample.sampleRate = 2048000;
     m_deviceDescription.sample.channelBits = 8;
     m_deviceDescription.sample.containerBits = 8;
@@ -231,6 +265,9 @@ bool RtlSdrInput::openDevice()
     // set automatic gain
     setGainMode(RtlGainMode::Software);
 
+    // 8 bit samples can be stored as int16
+    useCompactFifo();
+
     emit deviceReady();
 
     return true;
@@ -238,7 +275,7 @@ bool RtlSdrInput::openDevice()
 
 void RtlSdrInput::run()
 {
-    m_worker = new RtlSdrWorker(m_device, this);
+    m_worker = new RtlSdrWorker(m_inputBuffer, m_device, m_asyncBufNum, m_asyncBufLen, this);
     connect(m_worker, &RtlSdrWorker::agcLevel, this, &RtlSdrInput::onAgcLevel, Qt::QueuedConnection);
     connect(m_worker, &RtlSdrWorker::dataReady, this, [=](){ emit tuned(m_frequency); }, Qt::QueuedConnection);
     connect(m_worker, &RtlSdrWorker::recordBuffer, this, &InputDevice::recordBuffer, Qt::DirectConnection);
@@ -262,10 +299,7 @@ void RtlSdrInput::stop()
             qCWarning(rtlsdrInput) << "Worker thread not finished after timeout - this should not happen :-(";
 
             // reset buffer - and tell the thread it is empty - buffer will be reset in any case
-            pthread_mutex_lock(&inputBuffer.countMutex);
-            inputBuffer.count = 0;
-            pthread_cond_signal(&inputBuffer.countCondition);
-            pthread_mutex_unlock(&inputBuffer.countMutex);
+            m_inputBuffer->flush();
             m_worker->wait(2000);
         }
     }
@@ -280,7 +314,7 @@ void RtlSdrInput::onReadThreadStopped()
         qCCritical(rtlsdrInput) << "Device unplugged.";
 
         // fill buffer (artificially to avoid blocking of the DAB processing thread)
-        inputBuffer.fillDummy();
+        m_inputBuffer->fillDummy();
 
         m_frequency = 0;
 
@@ -356,7 +390,7 @@ void RtlSdrInput::resetAgc()
 {
     if (RtlGainMode::Software == m_gainMode)
     {
-        setGain(m_gainList->size() >> 1);
+        setGain((m_tunerState.gainIdx >= 0) ? m_tunerState.gainIdx : (m_gainList->size() >> 1));
     }
 }
 
@@ -365,6 +399,9 @@ void RtlSdrInput::onAgcLevel(float agcLevel)
     // qDebug() << agcLevel;
     if (RtlGainMode::Software == m_gainMode)
     {
+#if (RTLSDR_AGC_PREDICTIVE > 0)
+        setGain(RtlAgc::gainIdx(*m_gainList, m_gainIdx, agcLevel, m_agcLevelMin, m_agcLevelMax));
+#else
         if (agcLevel < m_agcLevelMin)
         {
             setGain(m_gainIdx+1);
@@ -373,6 +410,7 @@ void RtlSdrInput::onAgcLevel(float agcLevel)
         {
             setGain(m_gainIdx-1);
         }
+#endif
     }
 }
 
@@ -383,7 +421,7 @@ void RtlSdrInput::onWatchdogTimeout()
         if (!m_worker->isRunning())
         {  // some problem in data input
             qCCritical(rtlsdrInput) << "Watchdog timeout";
-            inputBuffer.fillDummy();
+            m_inputBuffer->fillDummy();
             emit error(InputDeviceErrorCode::NoDataAvailable);
         }
     }
@@ -444,6 +482,26 @@ void RtlSdrInput::setBW(uint32_t bw)
     }
 }
 
+void RtlSdrInput::setAsyncBuffers(int bufNum, int bufLen)
+{   // used when worker is started (next tune from idle)
+    if ((bufNum <= 0) || (bufNum > RTLSDR_ASYNC_BUF_NUM_MAX))
+    {
+        bufNum = RTLSDR_ASYNC_BUF_NUM_DEFAULT;
+    }
+    bufLen = (bufLen / 512) * 512;
+    if ((bufLen < RTLSDR_ASYNC_BUF_LEN_MIN) || (bufLen > RTLSDR_ASYNC_BUF_LEN_MAX))
+    {
+        bufLen = RTLSDR_ASYNC_BUF_LEN_DEFAULT;
+    }
+    while (bufLen * sizeof(float) > InputDevice::fifoConfig().sizeBytes() / 2)
+    {   // converted buffer has to fit to input FIFO (low memory profile)
+        bufLen = ((bufLen / 2) / 512) * 512;
+    }
+    m_asyncBufNum = bufNum;
+    m_asyncBufLen = bufLen;
+    qCInfo(rtlsdrInput) << "USB transfers:" << m_asyncBufNum << "x" << m_asyncBufLen << "bytes";
+}
+
 void RtlSdrInput::setBiasT(bool ena)
 {
     if (ena != m_biasT)
@@ -501,22 +559,37 @@ QList<float> RtlSdrInput::getGainList() const
     return ret;
 }
 
-RtlSdrWorker::RtlSdrWorker(struct rtlsdr_dev * device, QObject *parent) : QThread(parent)
+RtlSdrWorker::RtlSdrWorker(fifo_t * fifo, struct rtlsdr_dev * device, int bufNum, int bufLen, QObject *parent) : QThread(parent)
 {
+    m_inputBuffer = fifo;
     m_isRecording = false;
     m_rtlSdrPtr = parent;
     m_device = device;
+    m_bufNum = bufNum;
+    m_bufLen = bufLen;
+
+    // bufLen is number of bytes = 2 * IQ samples
+    int bufMs = bufLen / (2*2048);
+    int discard = (RTLSDR_RESTART_SETTLE_MS + bufMs - 1) / bufMs;
+    m_restartCounter = int8_t(1 + ((discard < 1) ? 1 : discard));
+    m_agcEmitPeriod = (INPUT_CHUNK_IQ_SAMPLES*2) / bufLen;
+    if (m_agcEmitPeriod < 1)
+    {
+        m_agcEmitPeriod = 1;
+    }
+    m_converter.setDcCoef(RTLSDR_DOC_COEF_CHUNK * bufLen / (INPUT_CHUNK_IQ_SAMPLES*2));
+    m_converter.setLevelCoefs(0.1, 0.00005);
 }
 
 void RtlSdrWorker::run()
 {
-    m_dcI = 0.0;
-    m_dcQ = 0.0;
-    m_agcLevel = 0.0;
+    ThreadPriority::update(ThreadClass::Input);
+
+    m_converter.reset();
     m_watchdogFlag = false;  // first callback sets it to true
     m_captureStartCntr = 1;  // first callback resets buffer
 
-    rtlsdr_read_async(m_device, callback, (void*)this, 0, INPUT_CHUNK_IQ_SAMPLES*2*sizeof(uint8_t));
+    rtlsdr_read_async(m_device, callback, (void*)this, m_bufNum, m_bufLen);
 }
 
 void RtlSdrWorker::startStopRecording(bool ena)
@@ -526,7 +599,7 @@ void RtlSdrWorker::startStopRecording(bool ena)
 
 void RtlSdrWorker::restart()
 {
-    m_captureStartCntr = RTLSDR_RESTART_COUNTER;
+    m_captureStartCntr = m_restartCounter;
 }
 
 bool RtlSdrWorker::isRunning()
@@ -543,22 +616,15 @@ void RtlSdrWorker::callback(unsigned char *buf, uint32_t len, void * ctx)
 
 void RtlSdrWorker::processInputData(unsigned char *buf, uint32_t len)
 {
-#if (RTLSDR_DOC_ENABLE > 0)
-    int_fast32_t sumI = 0;
-    int_fast32_t sumQ = 0;
-#endif
-
     if (m_captureStartCntr > 0)
     {   // reset procedure
         if (0 == --m_captureStartCntr)
         {   // restart finished
 
-            // clear buffer to avoid mixing of channels
-            inputBuffer.reset();
+            // samples from previous channel still in buffer are dropped by consumer
+            m_inputBuffer->startGeneration();
 
-            m_dcI = 0.0;
-            m_dcQ = 0.0;
-            //m_agcLevel = 0.0;
+            m_converter.resetDc();
 
             emit dataReady();
         }
@@ -587,24 +653,12 @@ void RtlSdrWorker::processInputData(unsigned char *buf, uint32_t len)
     // reset watchDog flag, timer sets it to false
     m_watchdogFlag = true;
 
-    // retrieving memories
-#if (RTLSDR_DOC_ENABLE > 0)
-    float dcI = m_dcI;
-    float dcQ = m_dcQ;
-#endif
-#if (RTLSDR_AGC_ENABLE > 0)
-    float agcLev = m_agcLevel;
-#endif
-
     // len is number of I and Q samples
     // get FIFO space
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    uint64_t count = inputBuffer.count;
-    Q_ASSERT(count <= INPUT_FIFO_SIZE);
-
-    pthread_mutex_unlock(&inputBuffer.countMutex);
+    Q_ASSERT(m_inputBuffer->freeSpace() <= m_inputBuffer->size);
 
-    if ((INPUT_FIFO_SIZE - count) < len*sizeof(float))
+    const uint64_t bytes = len * m_inputBuffer->valueBytes();
+    if (!m_inputBuffer->prepareWrite(bytes))
     {
         qCWarning(rtlsdrInput) << "Dropping" << len << "bytes...";
         return;
@@ -612,151 +666,19 @@ void RtlSdrWorker::processInputData(unsigned char *buf, uint32_t len)
 
     // input samples are IQ = [uint8_t uint8_t]
     // going to transform them to [float float] = float _Complex
-    // on uint8_t will be transformed to one float
+    // or to [int16 int16] in compact FIFO format, one uint8_t is transformed to one value
 
-    // there is enough room in buffer
-    uint64_t bytesTillEnd = INPUT_FIFO_SIZE - inputBuffer.head;
-    uint8_t * inPtr = buf;
-    if (bytesTillEnd >= len*sizeof(float))
-    {
-        float * outPtr = (float *)(inputBuffer.buffer + inputBuffer.head);
-        for (uint64_t k=0; k<len; k++)
-        {   // convert to float
-#if ((RTLSDR_DOC_ENABLE == 0) && ((RTLSDR_AGC_ENABLE == 0)))
-            *outPtr++ = float(*inPtr++ - 128);  // I or Q
-#else // ((RTLSDR_DOC_ENABLE == 0) && ((RTLSDR_AGC_ENABLE == 0)))
-            int_fast8_t tmp = *inPtr++ - 128; // I or Q
+    // there is enough room in buffer, it is contiguous
+    m_converter.processToFifo(*m_inputBuffer, buf, len);
 
 #if (RTLSDR_AGC_ENABLE > 0)
-            int_fast8_t absTmp = abs(tmp);
-
-            // calculate signal level (rectifier, fast attack slow release)
-            float c = m_agcLevel_crel;
-            if (absTmp > agcLev)
-            {
-                c = m_agcLevel_catt;
-            }
-            agcLev = c * absTmp + agcLev - c * agcLev;
-#endif  // (RTLSDR_AGC_ENABLE > 0)
-
-#if (RTLSDR_DOC_ENABLE > 0)
-            // subtract DC
-            if (k & 0x1)
-            {   // Q
-                sumQ += tmp;
-                *outPtr++ = float(tmp) - dcQ;
-            }
-            else
-            {  // I
-                sumI += tmp;
-                *outPtr++ = float(tmp) - dcI;
-            }
-#else
-            *outPtr++ = float(tmp);
-#endif  // RTLSDR_DOC_ENABLE
-#endif  // ((RTLSDR_DOC_ENABLE == 0) && ((RTLSDR_AGC_ENABLE == 0)))
-        }
-        inputBuffer.head = (inputBuffer.head + len*sizeof(float));
-    }
-    else
+    if (++m_agcEmitCntr >= m_agcEmitPeriod)
     {
-        Q_ASSERT(sizeof(float) == 4);
-        uint64_t samplesTillEnd = bytesTillEnd >> 2; // / sizeof(float);
-
-        float * outPtr = (float *)(inputBuffer.buffer + inputBuffer.head);
-        for (uint64_t k=0; k<samplesTillEnd; ++k)
-        {   // convert to float
-#if ((RTLSDR_DOC_ENABLE == 0) && ((RTLSDR_AGC_ENABLE == 0)))
-            *outPtr++ = float(*inPtr++ - 128);  // I or Q
-#else // ((RTLSDR_DOC_ENABLE == 0) && ((RTLSDR_AGC_ENABLE == 0)))
-            int_fast8_t tmp = *inPtr++ - 128; // I or Q
-
-#if (RTLSDR_AGC_ENABLE > 0)
-            int_fast8_t absTmp = abs(tmp);
-
-            // calculate signal level (rectifier, fast attack slow release)
-            float c = m_agcLevel_crel;
-            if (absTmp > agcLev)
-            {
-                c = m_agcLevel_catt;
-            }
-            agcLev = c * absTmp + agcLev - c * agcLev;
-#endif  // (RTLSDR_AGC_ENABLE > 0)
-
-#if (RTLSDR_DOC_ENABLE > 0)
-            // subtract DC
-            if (k & 0x1)
-            {   // Q
-                sumQ += tmp;
-                *outPtr++ = float(tmp) - dcQ;
-            }
-            else
-            {  // I
-                sumI += tmp;
-                *outPtr++ = float(tmp) - dcI;
-            }
-#else
-            *outPtr++ = float(tmp);
-#endif  // RTLSDR_DOC_ENABLE
-#endif  // ((RTLSDR_DOC_ENABLE == 0) && ((RTLSDR_AGC_ENABLE == 0)))
-        }
-
-        outPtr = (float *)(inputBuffer.buffer);
-        for (uint64_t k=0; k<len-samplesTillEnd; ++k)
-        {   // convert to float
-#if ((RTLSDR_DOC_ENABLE == 0) && ((RTLSDR_AGC_ENABLE == 0)))
-            *outPtr++ = float(*inPtr++ - 128);  // I or Q
-#else // ((RTLSDR_DOC_ENABLE == 0) && ((RTLSDR_AGC_ENABLE == 0)))
-            int_fast8_t tmp = *inPtr++ - 128; // I or Q
-
-#if (RTLSDR_AGC_ENABLE > 0)
-            int_fast8_t absTmp = abs(tmp);
-
-            // calculate signal level (rectifier, fast attack slow release)
-            float c = m_agcLevel_crel;
-            if (absTmp > agcLev)
-            {
-                c = m_agcLevel_catt;
-            }
-            agcLev = c * absTmp + agcLev - c * agcLev;
-#endif  // (RTLSDR_AGC_ENABLE > 0)
-
-#if (RTLSDR_DOC_ENABLE > 0)
-            // subtract DC
-            if (k & 0x1)
-            {   // Q
-                sumQ += tmp;
-                *outPtr++ = float(tmp) - dcQ;
-            }
-            else
-            {  // I
-                sumI += tmp;
-                *outPtr++ = float(tmp) - dcI;
-            }
-#else
-            *outPtr++ = float(tmp);
-#endif  // RTLSDR_DOC_ENABLE
-#endif  // ((RTLSDR_DOC_ENABLE == 0) && ((RTLSDR_AGC_ENABLE == 0)))
-        }
-        inputBuffer.head = (len-samplesTillEnd)*sizeof(float);
+        m_agcEmitCntr = 0;
+        emit agcLevel(m_converter.level());
     }
-
-#if (RTLSDR_DOC_ENABLE > 0)
-    // calculate correction values for next input buffer
-    m_dcI = sumI * m_doc_c / (len >> 1) + dcI - m_doc_c * dcI;
-    m_dcQ = sumQ * m_doc_c / (len >> 1) + dcQ - m_doc_c * dcQ;
-#endif
-
-#if (RTLSDR_AGC_ENABLE > 0)
-    // store memory
-    m_agcLevel = agcLev;
-
-    emit agcLevel(agcLev);
 #endif
 
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    inputBuffer.count = inputBuffer.count + len*sizeof(float);
-    pthread_cond_signal(&inputBuffer.countCondition);
-    pthread_mutex_unlock(&inputBuffer.countMutex);
+    m_inputBuffer->commitWrite(bytes);
 }
 
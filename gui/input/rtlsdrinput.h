@@ -32,13 +32,28 @@
 #include <QTimer>
 #include <rtl-sdr.h>
 #include "inputdevice.h"
+#include "tunerstatecache.h"
+#include "inputdeviceconverter.h"
 
 #define RTLSDR_DOC_ENABLE  1   // enable DOC
 #define RTLSDR_AGC_ENABLE  1   // enable AGC
+#define RTLSDR_AGC_PREDICTIVE 1   // software AGC jumps directly to target gain (gain table), single steps otherwise
+#define RTLSDR_CONVERTER_FEATURES (((RTLSDR_DOC_ENABLE > 0) ? INPUTDEVICECONVERTER_DC_REMOVAL : 0) \
+                                  | ((RTLSDR_AGC_ENABLE > 0) ? INPUTDEVICECONVERTER_LEVEL : 0))
 
-// init value of the counter used to reset buffer after tune
-// RTLSDR_START_COUNTER_INIT-1 buffers will be discarded
-#define RTLSDR_RESTART_COUNTER 2
+// async USB transfers, many small buffers spread conversion work evenly and shorten restart after tune
+// buffer length has to be multiple of 512 bytes (USB bulk packet)
+#define RTLSDR_ASYNC_BUF_NUM_DEFAULT   32
+#define RTLSDR_ASYNC_BUF_LEN_DEFAULT   (64*1024)   // 16 ms @ 2048kHz
+#define RTLSDR_ASYNC_BUF_NUM_MAX       128
+#define RTLSDR_ASYNC_BUF_LEN_MIN       (16*512)
+#define RTLSDR_ASYNC_BUF_LEN_MAX       (INPUT_CHUNK_IQ_SAMPLES*2)
+
+// samples received during this time after tune are discarded (buffer in progress + tuner settling)
+#define RTLSDR_RESTART_SETTLE_MS       20
+
+// DOC time constant is defined for 400 ms buffers, it is scaled according to buffer length
+#define RTLSDR_DOC_COEF_CHUNK          0.05
 
 #define RTLSDR_AGC_LEVEL_MAX_DEFAULT 105
 
@@ -46,7 +61,7 @@ class RtlSdrWorker : public QThread
 {
     Q_OBJECT
 public:
-    explicit RtlSdrWorker(struct rtlsdr_dev *device, QObject *parent = nullptr);
+    explicit RtlSdrWorker(fifo_t * fifo, struct rtlsdr_dev *device, int bufNum, int bufLen, QObject *parent = nullptr);
     void startStopRecording(bool ena);
     bool isRunning();
     void restart();
@@ -57,25 +72,20 @@ signals:
     void recordBuffer(const uint8_t * buf, uint32_t len);
     void dataReady();
 private:
+    fifo_t * m_inputBuffer;
     QObject * m_rtlSdrPtr;
     struct rtlsdr_dev * m_device;
     std::atomic<bool> m_isRecording;
     std::atomic<bool> m_watchdogFlag;
     std::atomic<int8_t> m_captureStartCntr;
+    int m_bufNum;
+    int m_bufLen;
+    int8_t m_restartCounter;     // restart() discards m_restartCounter-1 buffers
+    int m_agcEmitPeriod;         // AGC level is reported once per input chunk
+    int m_agcEmitCntr = 0;
 
-    // DOC memory
-    float m_dcI = 0.0;
-    float m_dcQ = 0.0;
-#if (RTLSDR_DOC_ENABLE > 0)
-    constexpr static const float m_doc_c = 0.05;
-#endif
-
-    // AGC memory
-    float m_agcLevel = 0.0;
-#if (RTLSDR_AGC_ENABLE > 0)
-    constexpr static const float m_agcLevel_catt = 0.1;
-    constexpr static const float m_agcLevel_crel = 0.00005;
-#endif
+    // sample conversion with DOC and AGC memory
+    InputDeviceConverter<uint8_t, RTLSDR_CONVERTER_FEATURES> m_converter;
 
     void processInputData(unsigned char *buf, uint32_t len);
     static void callback(unsigned char *buf, uint32_t len, void *ctx);
@@ -94,18 +104,24 @@ public:
     void setBW(uint32_t bw);
     void setBiasT(bool ena);
     void setPPM(int ppm);
+    void setSerial(const QString & serial) { m_serial = serial; }   // used by openDevice()
     void setAgcLevelMax(float agcMaxValue);
+    void setAsyncBuffers(int bufNum, int bufLen);
     QList<float> getGainList() const;    
 private:
     uint32_t m_frequency;
     uint32_t m_bandwidth;
     bool m_biasT;
     int m_ppm;
+    QString m_serial;
     struct rtlsdr_dev * m_device;
     RtlSdrWorker * m_worker;
+    int m_asyncBufNum = RTLSDR_ASYNC_BUF_NUM_DEFAULT;
+    int m_asyncBufLen = RTLSDR_ASYNC_BUF_LEN_DEFAULT;
     QTimer m_watchdogTimer;
     RtlGainMode m_gainMode = RtlGainMode::Hardware;
     int m_gainIdx;
+    TunerState m_tunerState;
     QList<int> * m_gainList;
     float m_agcLevelMax;
     float m_agcLevelMin;
@@ -28,6 +28,9 @@
 #include <QDebug>
 #include <QLoggingCategory>
 #include "rtltcpinput.h"
+#include "rtlagc.h"
+#include "diagnostics.h"
+#include "threadpriority.h"
 
 Q_LOGGING_CATEGORY(rtlTcpInput, "RtlTcpInput", QtInfoMsg)
 
@@ -109,10 +112,7 @@ RtlTcpInput::~RtlTcpInput()
             qCWarning(rtlTcpInput) << "Worker thread not finished after timeout - this should not happen :-(";
 
             // reset buffer - and tell the thread it is empty - buffer will be reset in any case
-            pthread_mutex_lock(&inputBuffer.countMutex);
-            inputBuffer.count = 0;
-            pthread_cond_signal(&inputBuffer.countCondition);
-            pthread_mutex_unlock(&inputBuffer.countMutex);
+            m_inputBuffer->flush();
             m_worker->wait(2000);
         }
     }
@@ -169,6 +169,13 @@ bool RtlTcpInput::openDevice()
             continue;
         }
 
+        // large receive buffer has to be set before connect so that TCP window scaling is negotiated
+        int rcvBufSize = RTLTCP_SOCKET_RCVBUF;
+        if (0 != setsockopt(sfd, SOL_SOCKET, SO_RCVBUF, (const char *) &rcvBufSize, sizeof(rcvBufSize)))
+        {
+            qCWarning(rtlTcpInput) << "Unable to set socket receive buffer size";
+        }
+
         // Set non-blocking
 #if defined(_WIN32)
         /// Windows sockets are created in blocking mode by default
@@ -300,6 +307,13 @@ bool RtlTcpInput::openDevice()
         uint32_t tunerGainCount;
     } dongleInfo;
 
+    m_transportFormat = RTLTCP_TRANSPORT_U8;
+    if (m_requestPackedTransport)
+    {   // this must be sent before dongle info is received (worker does not exist yet)
+        uint8_t cmdBuffer[5] = { uint8_t(RtlTcpCommand::SET_TRANSPORT_FORMAT), 0, 0, 0, RTLTCP_TRANSPORT_PACKED4 };
+        ::send(m_sock, (char *) cmdBuffer, 5, 0);
+    }
+
     // get information about RTL stick
 #if defined(_WIN32)
 #if (_WIN32_WINNT >= 0x0600)
@@ -353,6 +367,22 @@ bool RtlTcpInput::openDevice()
     // Convert the byte order
     dongleInfo.tunerType = ntohl(dongleInfo.tunerType);
     dongleInfo.tunerGainCount = ntohl(dongleInfo.tunerGainCount);
+    if (m_requestPackedTransport &&
+        dongleInfo.magic[0] == 'R' &&
+        dongleInfo.magic[1] == 'T' &&
+        dongleInfo.magic[2] == 'L' &&
+        dongleInfo.magic[3] == '4')
+    {   // server accepted packed transport
+        qCInfo(rtlTcpInput) << "Using 4-bit packed transport";
+        m_transportFormat = RTLTCP_TRANSPORT_PACKED4;
+        dongleInfo.magic[3] = '0';
+    }
+    else if (m_requestPackedTransport)
+    {
+        qCInfo(rtlTcpInput) << "Packed transport not supported by server, using uint8";
+    }
+    else { /* classic transport */ }
+
     if(dongleInfo.magic[0] == 'R' &&
         dongleInfo.magic[1] == 'T' &&
         dongleInfo.magic[2] == 'L' &&
@@ -459,8 +489,11 @@ bool RtlTcpInput::openDevice()
         // set automatic gain
         //setGainMode(RtlGainMode::Software);
 
+        // 8 bit samples can be stored as int16
+        useCompactFifo();
+
         // need to create worker, server is pushing samples
-        m_worker = new RtlTcpWorker(m_sock, this);
+        m_worker = new RtlTcpWorker(m_inputBuffer, m_sock, m_transportFormat, this);
         connect(m_worker, &RtlTcpWorker::agcLevel, this, &RtlTcpInput::onAgcLevel, Qt::QueuedConnection);
         connect(m_worker, &RtlTcpWorker::dataReady, this, [=](){ emit tuned(m_frequency); }, Qt::QueuedConnection);
         connect(m_worker, &RtlTcpWorker::recordBuffer, this, &InputDevice::recordBuffer, Qt::DirectConnection);
@@ -482,6 +515,16 @@ bool RtlTcpInput::openDevice()
 
 void RtlTcpInput::tune(uint32_t frequency)
 {
+    // AGC on new frequency starts from gain remembered for it
+    if (0 == m_receiver)
+    {
+        TunerStateCache::getInstance()->updateGain((RtlGainMode::Software == m_gainMode) ? m_gainIdx : -1);
+        m_tunerState = TunerStateCache::getInstance()->tune(m_deviceDescription, frequency);
+    }
+    else
+    {   // cache follows primary receiver only
+        m_tunerState = TunerState();
+    }
     m_frequency = frequency;
 
     if ((m_frequency > 0) && (nullptr != m_worker))
@@ -596,7 +639,7 @@ void RtlTcpInput::resetAgc()
 
     if (RtlGainMode::Software == m_gainMode)
     {
-        setGain(m_gainList->size() >> 1);
+        setGain((m_tunerState.gainIdx >= 0) ? m_tunerState.gainIdx : (m_gainList->size() >> 1));
     }
 }
 
@@ -609,6 +652,9 @@ void RtlTcpInput::onAgcLevel(float agcLevel)
 {
     if (RtlGainMode::Software == m_gainMode)
     {
+#if (RTLTCP_AGC_PREDICTIVE > 0)
+        setGain(RtlAgc::gainIdx(*m_gainList, m_gainIdx, agcLevel, m_agcLevelMin, m_agcLevelMax));
+#else
         if (agcLevel < m_agcLevelMin)
         {
             setGain(m_gainIdx+1);
@@ -617,6 +663,7 @@ void RtlTcpInput::onAgcLevel(float agcLevel)
         {
             setGain(m_gainIdx-1);
         }
+#endif
     }
 }
 
@@ -634,7 +681,7 @@ void RtlTcpInput::onReadThreadStopped()
     m_watchdogTimer.stop();
 
     // fill buffer (artificially to avoid blocking of the DAB processing thread)
-    inputBuffer.fillDummy();
+    m_inputBuffer->fillDummy();
 
     emit error(InputDeviceErrorCode::DeviceDisconnected);
 }
@@ -646,7 +693,7 @@ void RtlTcpInput::onWatchdogTimeout()
         if (!m_worker->isRunning())
         {  // some problem in data input
             qCCritical(rtlTcpInput) << "watchdog timeout";
-            inputBuffer.fillDummy();
+            m_inputBuffer->fillDummy();
             emit error(InputDeviceErrorCode::NoDataAvailable);
         }
     }
@@ -689,11 +736,17 @@ void RtlTcpInput::sendCommand(const RtlTcpCommand & cmd, uint32_t param)
     ::send(m_sock, (char *) cmdBuffer, 5, 0);
 }
 
-RtlTcpWorker::RtlTcpWorker(SOCKET sock, QObject *parent) : QThread(parent)
+RtlTcpWorker::RtlTcpWorker(fifo_t * fifo, SOCKET sock, int transportFormat, QObject *parent) : QThread(parent)
 {
+    m_inputBuffer = fifo;
     m_isRecording = false;
     m_enaCaptureIQ = false;
     m_sock = sock;
+    m_transportFormat = transportFormat;
+
+    // DOC coefficient is scaled to chunk size so that time constant does not depend on it
+    m_converter.setDcCoef(0.05 * RTLTCP_CHUNK_SIZE / (INPUT_CHUNK_IQ_SAMPLES*2));
+    m_converter.setLevelCoefs(0.1, 0.00005);
 }
 
 void RtlTcpWorker::startStopRecording(bool ena)
@@ -703,18 +756,26 @@ void RtlTcpWorker::startStopRecording(bool ena)
 
 void RtlTcpWorker::run()
 {
-    m_dcI = 0.0;
-    m_dcQ = 0.0;
-    m_agcLevel = 0.0;
+    ThreadPriority::update(ThreadClass::Input);
+
+    m_converter.reset();
     m_watchdogFlag = false;  // first callback sets it to true
 
+    // packed samples are received to the second half of the buffer and unpacked in place
+    const size_t chunkSize = (RTLTCP_TRANSPORT_PACKED4 == m_transportFormat) ? RTLTCP_CHUNK_SIZE/2 : RTLTCP_CHUNK_SIZE;
+    uint8_t * chunkBuffer = m_bufferIQ + RTLTCP_CHUNK_SIZE - chunkSize;
+
     // read samples
     while (INVALID_SOCKET != m_sock)
     {
         size_t read = 0;
+        int numRecvCalls = 0;
+        uint64_t startUs = Diagnostics::timestampUs();
         do
         {
-            ssize_t ret = ::recv(m_sock, (char *) m_bufferIQ+read, RTLTCP_CHUNK_SIZE - read, 0);
+            // MSG_WAITALL: recv returns full chunk unless it is interrupted or connection is closed
+            ++numRecvCalls;
+            ssize_t ret = ::recv(m_sock, (char *) chunkBuffer+read, chunkSize - read, MSG_WAITALL);
             if (0 == ret)
             {   // disconnected => finish thread operation
                 qCCritical(rtlTcpInput) << "socket disconnected";
@@ -762,7 +823,22 @@ void RtlTcpWorker::run()
             {
                 read += ret;
             }
-        } while (RTLTCP_CHUNK_SIZE > read);
+        } while (chunkSize > read);
+
+        if (RTLTCP_TRANSPORT_PACKED4 == m_transportFormat)
+        {
+            unpack4(m_bufferIQ, RTLTCP_CHUNK_SIZE);
+        }
+
+        // network statistics: more than one call means short read, long receive time means stall
+        Diagnostics * diag = Diagnostics::getInstance();
+        uint64_t chunkMs = (Diagnostics::timestampUs() - startUs) / 1000;
+        diag->add(DiagnosticsMetric::NetworkRecvCalls, numRecvCalls);
+        diag->add(DiagnosticsMetric::NetworkChunkTime, chunkMs);
+        if (chunkMs > RTLTCP_STALL_MS)
+        {
+            qCDebug(rtlTcpInput) << "Network stall:" << chunkMs << "ms to receive" << RTLTCP_CHUNK_MS << "ms of samples";
+        }
 
         // reset watchDog flag, timer sets it to true
         m_watchdogFlag = true;
@@ -775,12 +851,10 @@ void RtlTcpWorker::run()
                 if (0 == --m_captureStartCntr)
                 {   // restart finished
 
-                    // clear buffer to avoid mixing of channels
-                    inputBuffer.reset();
+                    // samples from previous channel still in buffer are dropped by consumer
+                    m_inputBuffer->startGeneration();
 
-                    m_dcI = 0.0;
-                    m_dcQ = 0.0;
-                    //m_agcLevel = 0.0;
+                    m_converter.resetDc();
 
                     emit dataReady();
                 }
@@ -805,6 +879,18 @@ worker_exit:
     return;
 }
 
+void RtlTcpWorker::unpack4(uint8_t *buf, uint32_t len)
+{   // packed data are in the second half of buf, unpacking from the beginning never overwrites unread byte
+    // nibble n represents uint8 value 16*n + 8 (midrise quantizer centered at 128)
+    const uint8_t * in = buf + len/2;
+    for (uint32_t k = 0; k < len/2; ++k)
+    {
+        uint8_t b = in[k];
+        buf[2*k] = (b & 0xF0) | 0x08;
+        buf[2*k+1] = uint8_t(b << 4) | 0x08;
+    }
+}
+
 void RtlTcpWorker::captureIQ(bool ena)
 {
     if (ena)
@@ -823,34 +909,17 @@ bool RtlTcpWorker::isRunning()
 
 void RtlTcpWorker::processInputData(unsigned char *buf, uint32_t len)
 {
-#if (RTLTCP_DOC_ENABLE > 0)
-    int_fast32_t sumI = 0;
-    int_fast32_t sumQ = 0;
-#endif
-
     if (m_isRecording)
     {
         emit recordBuffer(buf, len);
     }
 
-    // retrieving memories
-#if (RTLTCP_DOC_ENABLE > 0)
-    float dcI = m_dcI;
-    float dcQ = m_dcQ;
-#endif
-#if (RTLTCP_AGC_ENABLE > 0)
-    float agcLev = m_agcLevel;
-#endif
-
     // len is number of I and Q samples
     // get FIFO space
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    uint64_t count = inputBuffer.count;
-    Q_ASSERT(count <= INPUT_FIFO_SIZE);
-
-    pthread_mutex_unlock(&inputBuffer.countMutex);
+    Q_ASSERT(m_inputBuffer->freeSpace() <= m_inputBuffer->size);
 
-    if ((INPUT_FIFO_SIZE - count) < len*sizeof(float))
+    const uint64_t bytes = len * m_inputBuffer->valueBytes();
+    if (!m_inputBuffer->prepareWrite(bytes))
     {
         qCWarning(rtlTcpInput) << "dropping" << len << "bytes...";
         return;
@@ -858,150 +927,19 @@ void RtlTcpWorker::processInputData(unsigned char *buf, uint32_t len)
 
     // input samples are IQ = [uint8_t uint8_t]
     // going to transform them to [float float] = float _Complex
-    // on uint8_t will be transformed to one float
+    // or to [int16 int16] in compact FIFO format, one uint8_t is transformed to one value
 
-    // there is enough room in buffer
-    uint64_t bytesTillEnd = INPUT_FIFO_SIZE - inputBuffer.head;
-    uint8_t * inPtr = buf;
-    if (bytesTillEnd >= len*sizeof(float))
-    {
-        float * outPtr = (float *)(inputBuffer.buffer + inputBuffer.head);
-        for (uint64_t k=0; k<len; k++)
-        {   // convert to float
-#if ((RTLTCP_DOC_ENABLE == 0) && ((RTLTCP_AGC_ENABLE == 0)))
-            *outPtr++ = float(*inPtr++ - 128);  // I or Q
-#else // ((RTLTCP_DOC_ENABLE == 0) && ((RTLTCP_AGC_ENABLE == 0)))
-            int_fast8_t tmp = *inPtr++ - 128; // I or Q
+    // there is enough room in buffer, it is contiguous
+    m_converter.processToFifo(*m_inputBuffer, buf, len);
 
 #if (RTLTCP_AGC_ENABLE > 0)
-            int_fast8_t absTmp = abs(tmp);
-
-            // calculate signal level (rectifier, fast attack slow release)
-            float c = m_agcLevel_crel;
-            if (absTmp > agcLev)
-            {
-                c = m_agcLevel_catt;
-            }
-            agcLev = c * absTmp + agcLev - c * agcLev;
-#endif  // (RTLTCP_AGC_ENABLE > 0)
-
-#if (RTLTCP_DOC_ENABLE > 0)
-            // subtract DC
-            if (k & 0x1)
-            {   // Q
-                sumQ += tmp;
-                *outPtr++ = float(tmp) - dcQ;
-            }
-            else
-            {  // I
-                sumI += tmp;
-                *outPtr++ = float(tmp) - dcI;
-            }
-#else
-            *outPtr++ = float(tmp);
-#endif  // RTLTCP_DOC_ENABLE
-#endif  // ((RTLTCP_DOC_ENABLE == 0) && ((RTLTCP_AGC_ENABLE == 0)))
-        }
-        inputBuffer.head = (inputBuffer.head + len*sizeof(float));
-    }
-    else
+    if (++m_agcEmitCntr >= RTLTCP_AGC_EMIT_PERIOD)
     {
-        Q_ASSERT(sizeof(float) == 4);
-        uint64_t samplesTillEnd = bytesTillEnd >> 2; // / sizeof(float);
-
-        float * outPtr = (float *)(inputBuffer.buffer + inputBuffer.head);
-        for (uint64_t k=0; k<samplesTillEnd; ++k)
-        {   // convert to float
-#if ((RTLTCP_DOC_ENABLE == 0) && ((RTLTCP_AGC_ENABLE == 0)))
-            *outPtr++ = float(*inPtr++ - 128);  // I or Q
-#else // ((RTLTCP_DOC_ENABLE == 0) && ((RTLTCP_AGC_ENABLE == 0)))
-            int_fast8_t tmp = *inPtr++ - 128; // I or Q
-
-#if (RTLTCP_AGC_ENABLE > 0)
-            int_fast8_t absTmp = abs(tmp);
-
-            // calculate signal level (rectifier, fast attack slow release)
-            float c = m_agcLevel_crel;
-            if (absTmp > agcLev)
-            {
-                c = m_agcLevel_catt;
-            }
-            agcLev = c * absTmp + agcLev - c * agcLev;
-#endif  // (RTLTCP_AGC_ENABLE > 0)
-
-#if (RTLTCP_DOC_ENABLE > 0)
-            // subtract DC
-            if (k & 0x1)
-            {   // Q
-                sumQ += tmp;
-                *outPtr++ = float(tmp) - dcQ;
-            }
-            else
-            {  // I
-                sumI += tmp;
-                *outPtr++ = float(tmp) - dcI;
-            }
-#else
-            *outPtr++ = float(tmp);
-#endif  // RTLTCP_DOC_ENABLE
-#endif  // ((RTLTCP_DOC_ENABLE == 0) && ((RTLTCP_AGC_ENABLE == 0)))
-        }
-
-        outPtr = (float *)(inputBuffer.buffer);
-        for (uint64_t k=0; k<len-samplesTillEnd; ++k)
-        {   // convert to float
-#if ((RTLTCP_DOC_ENABLE == 0) && ((RTLTCP_AGC_ENABLE == 0)))
-            *outPtr++ = float(*inPtr++ - 128);  // I or Q
-#else // ((RTLTCP_DOC_ENABLE == 0) && ((RTLTCP_AGC_ENABLE == 0)))
-            int_fast8_t tmp = *inPtr++ - 128; // I or Q
-
-#if (RTLTCP_AGC_ENABLE > 0)
-            int_fast8_t absTmp = abs(tmp);
-
-            // calculate signal level (rectifier, fast attack slow release)
-            float c = m_agcLevel_crel;
-            if (absTmp > agcLev)
-            {
-                c = m_agcLevel_catt;
-            }
-            agcLev = c * absTmp + agcLev - c * agcLev;
-#endif  // (RTLTCP_AGC_ENABLE > 0)
-
-#if (RTLTCP_DOC_ENABLE > 0)
-            // subtract DC
-            if (k & 0x1)
-            {   // Q
-                sumQ += tmp;
-                *outPtr++ = float(tmp) - dcQ;
-            }
-            else
-            {  // I
-                sumI += tmp;
-                *outPtr++ = float(tmp) - dcI;
-            }
-#else
-            *outPtr++ = float(tmp);
-#endif  // RTLTCP_DOC_ENABLE
-#endif  // ((RTLTCP_DOC_ENABLE == 0) && ((RTLTCP_AGC_ENABLE == 0)))
-        }
-        inputBuffer.head = (len-samplesTillEnd)*sizeof(float);
+        m_agcEmitCntr = 0;
+        emit agcLevel(m_converter.level());
     }
-
-#if (RTLTCP_DOC_ENABLE > 0)
-    // calculate correction values for next input buffer
-    m_dcI = sumI * m_doc_c / (len >> 1) + dcI - m_doc_c * dcI;
-    m_dcQ = sumQ * m_doc_c / (len >> 1) + dcQ - m_doc_c * dcQ;
-#endif
-
-#if (RTLTCP_AGC_ENABLE > 0)
-    // store memory
-    m_agcLevel = agcLev;
-    emit agcLevel(agcLev);
 #endif
 
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    inputBuffer.count = inputBuffer.count + len*sizeof(float);
-    pthread_cond_signal(&inputBuffer.countCondition);
-    pthread_mutex_unlock(&inputBuffer.countMutex);
+    m_inputBuffer->commitWrite(bytes);
 }
 
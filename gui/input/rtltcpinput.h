@@ -32,6 +32,8 @@
 #include <QTimer>
 #include <rtl-sdr.h>
 #include "inputdevice.h"
+#include "tunerstatecache.h"
+#include "inputdeviceconverter.h"
 
 // socket
 #if defined(_WIN32)
@@ -53,19 +55,33 @@
 #define INVALID_SOCKET (-1)
 #endif
 
-#define RTLTCP_CHUNK_SIZE (16384*100)
+#define RTLTCP_CHUNK_SIZE (16384*4)
+#define RTLTCP_CHUNK_MS   (RTLTCP_CHUNK_SIZE / (2*2048))        // duration of one chunk (16 ms)
+#define RTLTCP_SOCKET_RCVBUF (16384*400)                        // socket buffer covers link jitter (~1.6 sec)
+#define RTLTCP_STALL_MS   (200)                                 // chunk receive time reported as stall
 
 #define RTLTCP_DOC_ENABLE 1         // enable DOC
 #define RTLTCP_AGC_ENABLE 1         // enable AGC
-#define RTLTCP_START_COUNTER_INIT 2 // init value of the counter used to reset buffer after tune
+#define RTLTCP_AGC_PREDICTIVE 1     // software AGC jumps directly to target gain (gain table), single steps otherwise
+#define RTLTCP_CONVERTER_FEATURES (((RTLTCP_DOC_ENABLE > 0) ? INPUTDEVICECONVERTER_DC_REMOVAL : 0) \
+                                  | ((RTLTCP_AGC_ENABLE > 0) ? INPUTDEVICECONVERTER_LEVEL : 0))
+#define RTLTCP_RESTART_DISCARD_MS (100)   // samples received after tune command that are discarded
+#define RTLTCP_START_COUNTER_INIT (1 + (RTLTCP_RESTART_DISCARD_MS + RTLTCP_CHUNK_MS - 1) / RTLTCP_CHUNK_MS)
+#define RTLTCP_AGC_EMIT_PERIOD    ((INPUT_CHUNK_IQ_SAMPLES*2) / RTLTCP_CHUNK_SIZE)  // AGC level is reported once per input chunk
 
 #define RTLTCP_AGC_LEVEL_MAX_DEFAULT 105
 
+// transport extension (supported by IQStreamServer)
+// client sends SET_TRANSPORT_FORMAT command right after connect, before dongle info is received
+// server that supports requested format answers with magic "RTL4", classic server ignores command and sends "RTL0"
+#define RTLTCP_TRANSPORT_U8       (0)     // classic uint8 IQ
+#define RTLTCP_TRANSPORT_PACKED4  (4)     // 4-bit I and 4-bit Q packed in one byte [IIIIQQQQ]
+
 class RtlTcpWorker : public QThread
 {
     Q_OBJECT
 public:
-    explicit RtlTcpWorker(SOCKET sock, QObject *parent = nullptr);
+    explicit RtlTcpWorker(fifo_t * fifo, SOCKET sock, int transportFormat = RTLTCP_TRANSPORT_U8, QObject *parent = nullptr);
     void captureIQ(bool ena);
     void startStopRecording(bool ena);
     bool isRunning();
@@ -76,31 +92,24 @@ signals:
     void recordBuffer(const uint8_t * buf, uint32_t len);
     void dataReady();
 private:
+    fifo_t * m_inputBuffer;
     SOCKET m_sock;
+    int m_transportFormat;
 
     std::atomic<bool> m_isRecording;
     std::atomic<bool> m_enaCaptureIQ;
     std::atomic<bool> m_watchdogFlag;
     std::atomic<int8_t> m_captureStartCntr;
 
-    // DOC memory
-    float m_dcI = 0.0;
-    float m_dcQ = 0.0;
-#if (RTLTCP_DOC_ENABLE > 0)
-    constexpr static const float m_doc_c = 0.05;
-#endif
-
-    // AGC memory
-    float m_agcLevel = 0.0;
-#if (RTLTCP_AGC_ENABLE > 0)
-    constexpr static const float m_agcLevel_catt = 0.1;
-    constexpr static const float m_agcLevel_crel = 0.00005;
-#endif
+    // sample conversion with DOC and AGC memory
+    InputDeviceConverter<uint8_t, RTLTCP_CONVERTER_FEATURES> m_converter;
+    int m_agcEmitCntr = 0;
 
     // input buffer
     uint8_t m_bufferIQ[RTLTCP_CHUNK_SIZE];
 
     void processInputData(unsigned char *buf, uint32_t len);
+    static void unpack4(uint8_t * buf, uint32_t len);
 };
 
 class RtlTcpInput : public InputDevice
@@ -122,7 +131,8 @@ class RtlTcpInput : public InputDevice
         SET_RTL_XTAL_FREQ    = 0x0B,
         SET_TUNER_XTAL_FREQ  = 0x0C,
         SET_GAIN_IDX         = 0x0D,
-        SET_BIAS_TEE         = 0x0E
+        SET_BIAS_TEE         = 0x0E,
+        SET_TRANSPORT_FORMAT = 0x80       // extension
     };
 
     /* taken from rtlsdr_get_tuner_gains() implementation */
@@ -141,6 +151,7 @@ public:
     bool openDevice() override;
     void tune(uint32_t frequency) override;
     void setTcpIp(const QString & address, int port);
+    void setPackedTransport(bool ena) { m_requestPackedTransport = ena; }
     void setGainMode(RtlGainMode gainMode, int gainIdx = 0);
     void setAgcLevelMax(float agcLevelMax);
     void setPPM(int ppm);
@@ -152,11 +163,14 @@ private:
     SOCKET m_sock;
     QString m_address;
     int m_port;
+    bool m_requestPackedTransport = false;
+    int m_transportFormat = RTLTCP_TRANSPORT_U8;
 
     RtlTcpWorker * m_worker;
     QTimer m_watchdogTimer;
     RtlGainMode m_gainMode = RtlGainMode::Undefined;
     int m_gainIdx;
+    TunerState m_tunerState;
     QList<int> * m_gainList;
     float m_agcLevelMax;
     float m_agcLevelMin;
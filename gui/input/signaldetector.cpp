@@ -0,0 +1,139 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdlib>
+#include "signaldetector.h"
+
+SignalDetector * SignalDetector::m_instancePtr = nullptr;
+
+SignalDetector *SignalDetector::getInstance()
+{
+    if (m_instancePtr == nullptr)
+    {
+        m_instancePtr = new SignalDetector();
+    }
+    return m_instancePtr;
+}
+
+void SignalDetector::start()
+{
+    m_result.store(SignalDetectorResult::Pending, std::memory_order_release);
+    m_restart.store(true, std::memory_order_release);
+    m_isRunning.store(true, std::memory_order_release);
+}
+
+void SignalDetector::stop()
+{
+    m_isRunning.store(false, std::memory_order_release);
+    m_result.store(SignalDetectorResult::Idle, std::memory_order_release);
+}
+
+void SignalDetector::process(const float *iq, uint16_t numSamples)
+{
+    if (!m_isRunning.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    if (m_restart.exchange(false, std::memory_order_acq_rel))
+    {
+        reset();
+    }
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        m_blockPower += iq[2*n] * iq[2*n] + iq[2*n+1] * iq[2*n+1];
+        if (++m_blockSamples == SIGNALDETECTOR_BLOCK_SAMPLES)
+        {
+            processBlock(m_blockPower);
+            m_blockPower = 0.0f;
+            m_blockSamples = 0;
+            if (!m_isRunning.load(std::memory_order_relaxed))
+            {   // decision was made
+                return;
+            }
+        }
+    }
+}
+
+void SignalDetector::reset()
+{
+    m_blockPower = 0.0f;
+    m_blockSamples = 0;
+    m_blockCntr = 0;
+    m_meanPower = 0.0f;
+    m_dipBlocks = 0;
+    m_lastDipBlock = -1;
+    m_numPeriodicDips = 0;
+}
+
+void SignalDetector::processBlock(float power)
+{
+    int block = m_blockCntr++;
+    if (block < SIGNALDETECTOR_SETTLE_BLOCKS)
+    {   // waiting for AGC, only estimate mean power
+        m_meanPower = (0 == block) ? power : (m_meanPower + (power - m_meanPower) * (1.0f/64));
+        return;
+    }
+
+    if (power < SIGNALDETECTOR_NULL_THR * m_meanPower)
+    {   // candidate null symbol, mean is not updated
+        ++m_dipBlocks;
+    }
+    else
+    {
+        if ((m_dipBlocks >= SIGNALDETECTOR_NULL_MIN_BLOCKS) && (m_dipBlocks <= SIGNALDETECTOR_NULL_MAX_BLOCKS))
+        {   // null symbol candidate finished
+            if ((m_lastDipBlock >= 0)
+                && (std::abs(block - m_lastDipBlock - SIGNALDETECTOR_FRAME_BLOCKS) <= SIGNALDETECTOR_FRAME_TOLERANCE))
+            {   // spacing corresponds to transmission frame
+                if (++m_numPeriodicDips >= SIGNALDETECTOR_NUM_FRAMES)
+                {
+                    finish(SignalDetectorResult::Present);
+                    return;
+                }
+            }
+            m_lastDipBlock = block;
+        }
+        m_dipBlocks = 0;
+        m_meanPower += (power - m_meanPower) * (1.0f/64);
+    }
+
+    if (m_blockCntr >= SIGNALDETECTOR_WINDOW_BLOCKS)
+    {   // no periodic null symbol found
+        finish(SignalDetectorResult::Absent);
+    }
+}
+
+void SignalDetector::finish(SignalDetectorResult result)
+{
+    if (m_restart.load(std::memory_order_acquire))
+    {   // detector was restarted meanwhile, result is obsolete
+        return;
+    }
+    m_result.store(result, std::memory_order_release);
+    m_isRunning.store(false, std::memory_order_release);
+}
@@ -0,0 +1,91 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SIGNALDETECTOR_H
+#define SIGNALDETECTOR_H
+
+#include <atomic>
+#include <cstdint>
+
+// lightweight DAB presence detector working on raw input samples (before sync)
+// it looks for periodic power dips of DAB transmission mode I null symbol
+#define SIGNALDETECTOR_BLOCK_SAMPLES   (256)    // power is integrated over blocks of samples
+#define SIGNALDETECTOR_FRAME_BLOCKS    (196608 / SIGNALDETECTOR_BLOCK_SAMPLES)  // ETSI EN 300 401 mode I frame length (Tf)
+#define SIGNALDETECTOR_FRAME_TOLERANCE (4)      // tolerance of null symbol spacing [blocks]
+#define SIGNALDETECTOR_NULL_MIN_BLOCKS (6)      // null symbol is 2656 samples (Tnull)
+#define SIGNALDETECTOR_NULL_MAX_BLOCKS (14)
+#define SIGNALDETECTOR_NULL_THR        (0.25f)  // block power relative to mean power (approx. -6dB)
+#define SIGNALDETECTOR_SETTLE_BLOCKS   (320)    // ~40 ms ignored after start (AGC settling)
+#define SIGNALDETECTOR_WINDOW_BLOCKS   (3600)   // ~450 ms -> more than 4 transmission frames
+#define SIGNALDETECTOR_NUM_FRAMES      (2)      // number of periodic null symbols to confirm DAB signal
+
+enum class SignalDetectorResult
+{
+    Idle = 0,
+    Pending,
+    Present,
+    Absent
+};
+
+// singleton class
+// start() and result() are called from GUI thread, process() is called from dabsdr thread
+class SignalDetector
+{
+public:
+    SignalDetector(const SignalDetector & obj) = delete;   // deleting copy constructor
+    static SignalDetector * getInstance();
+
+    void start();
+    void stop();
+    SignalDetectorResult result() const { return m_result.load(std::memory_order_acquire); }
+    bool isRunning() const { return m_isRunning.load(std::memory_order_acquire); }
+
+    // returns immediately when detector is not running
+    void process(const float * iq, uint16_t numSamples);
+
+private:
+    SignalDetector() = default;
+    static SignalDetector * m_instancePtr;
+
+    std::atomic<bool> m_isRunning { false };
+    std::atomic<bool> m_restart { false };
+    std::atomic<SignalDetectorResult> m_result { SignalDetectorResult::Idle };
+
+    // dabsdr thread state
+    float m_blockPower = 0.0f;
+    int m_blockSamples = 0;
+    int m_blockCntr = 0;
+    float m_meanPower = 0.0f;
+    int m_dipBlocks = 0;
+    int m_lastDipBlock = -1;
+    int m_numPeriodicDips = 0;
+
+    void reset();
+    void processBlock(float power);
+    void finish(SignalDetectorResult result);
+};
+
+#endif // SIGNALDETECTOR_H
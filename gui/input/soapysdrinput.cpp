@@ -28,6 +28,9 @@
 #include <QDebug>
 #include <QLoggingCategory>
 #include "soapysdrinput.h"
+#include "inputdeviceenumerator.h"
+#include "inputdeviceconverter.h"
+#include "threadpriority.h"
 
 Q_LOGGING_CATEGORY(soapySdrInput, "SoapySdrInput", QtInfoMsg)
 
@@ -64,7 +67,19 @@ bool SoapySdrInput::openDevice()
 
     if (m_devArgs.isEmpty())
     {   // no device args provided => try to open first device
-        SoapySDR::KwargsList devs = SoapySDR::Device::enumerate();
+        SoapySDR::KwargsList devs;
+        QList<InputDeviceListItem> cached;
+        if (InputDeviceEnumerator::getInstance()->devices(InputDeviceId::SOAPYSDR, cached) && !cached.isEmpty())
+        {   // background enumeration result is used, module loading and enumeration take long time
+            for (const auto & item : std::as_const(cached))
+            {
+                devs.push_back(SoapySDR::KwargsFromString(item.args.toStdString()));
+            }
+        }
+        else
+        {
+            devs = SoapySDR::Device::enumerate();
+        }
         if (0 == devs.size())
         {
             qCCritical(soapySdrInput) << "No devices found";
@@ -131,18 +146,45 @@ bool SoapySdrInput::openDevice()
         return false;
     }
 
-    // check sample format -> need CF32
+    // check sample format -> native CS16 or CS8 is preferred, CF32 otherwise
     std::vector<std::string> formats = m_device->getStreamFormats(SOAPY_SDR_RX, m_rxChannel);
-    if (std::find(formats.begin(), formats.end(), SOAPY_SDR_CF32) == formats.end())
+    auto hasFormat = [&formats](const char * format) {
+        return std::find(formats.begin(), formats.end(), format) != formats.end();
+    };
+    m_sampleFormat = SoapySampleFormat::CF32;
+    m_fullScale = 1.0;
+#if SOAPYSDR_NATIVE_FORMAT
+    double nativeFullScale = 0.0;
+    std::string nativeFormat = m_device->getNativeStreamFormat(SOAPY_SDR_RX, m_rxChannel, nativeFullScale);
+    if (nativeFullScale > 0.0)
+    {
+        if ((SOAPY_SDR_CS8 == nativeFormat) && hasFormat(SOAPY_SDR_CS8))
+        {
+            m_sampleFormat = SoapySampleFormat::CS8;
+            m_fullScale = nativeFullScale;
+        }
+        else if (((SOAPY_SDR_CS16 == nativeFormat) || (SOAPY_SDR_CS12 == nativeFormat) || (SOAPY_SDR_CS8 == nativeFormat))
+                 && hasFormat(SOAPY_SDR_CS16))
+        {   // CS12 is unpacked to CS16 by driver, full scale is given by native format
+            m_sampleFormat = SoapySampleFormat::CS16;
+            m_fullScale = nativeFullScale;
+        }
+        else { /* native format not usable */ }
+    }
+    else { /* full scale unknown */ }
+    qCInfo(soapySdrInput) << "Native format" << nativeFormat.c_str() << "full scale" << nativeFullScale;
+#endif
+    if ((SoapySampleFormat::CF32 == m_sampleFormat) && !hasFormat(SOAPY_SDR_CF32))
     {   // not found
         qCCritical(soapySdrInput) << "Failed to open device. CF32 format not supported.";
         SoapySDR::Device::unmake(m_device);
         m_device = nullptr;
         return false;
     }
-    else { /* CF32 supported */ }
+    else { /* format supported */ }
 
-    // Set sample rate - prefered rates: 2048, 4096 and then the lowest above 2048
+    // Set sample rate - the rate with the cheapest SRC is selected
+    // 2048kHz (passthrough), 2048kHz * 2^N (halfband cascade) and then the lowest above 2048kHz (Farrow)
     SoapySDR::RangeList srRanges = m_device->getSampleRateRange( SOAPY_SDR_RX, m_rxChannel);
 
     QString rangesStr = "";
@@ -152,47 +194,31 @@ bool SoapySdrInput::openDevice()
     }
     qCInfo(soapySdrInput, "Sample rate ranges: %s", rangesStr.toLocal8Bit().data());
 
-    m_sampleRate = 10e8;  // dummy high value
-    bool has2048 = false;
-    bool has4096 = false;
+    // discrete rates reported by driver (e.g. SDRplay or HackRF) and candidates from ranges
+    std::vector<double> sampleRates = m_device->listSampleRates(SOAPY_SDR_RX, m_rxChannel);
     for(int n = 0; n < srRanges.size(); ++n)
     {
-        if (2048e3 <= srRanges[n].maximum())
-        {   // max >= 2048e3
-            if (2048e3 >= srRanges[n].minimum())
-            {   // 2048kHz is in the range => lets use it, nothing else is important
-                has2048 = true;
-                break;
-            }
-            else { /* 2048kHz is not in this range */ }
-
-            if ((4096e3 >= srRanges[n].minimum()) && (4096e3 <= srRanges[n].maximum()))
-            {   // 4096kHz is in the range
-                has4096 = true;
-            }
-            else { /* 4096kHz not in this range */ }
-
-            // we know that max >= 2048e3 && min >= 2048e3
-
-            // lets take minimum
-            if (m_sampleRate > srRanges[n].minimum())
+        double rate = 2048e3;
+        for (int k = 0; k <= INPUTDEVICESRC_MAX_DS2_STAGES; ++k)
+        {
+            if ((rate >= srRanges[n].minimum()) && (rate <= srRanges[n].maximum()))
             {
-                m_sampleRate = srRanges[n].minimum();
+                sampleRates.push_back(rate);
             }
+            rate *= 2;
         }
-        else { /* SR range is below 2048kHz */ }
+        sampleRates.push_back(srRanges[n].minimum());
     }
 
-    // lets evaluate results
-    if (has2048)
-    {
-        m_sampleRate = 2048e3;
-    }
-    else if (has4096)
+    m_sampleRate = InputDeviceSRC::preferredSampleRate(sampleRates);
+    if (0.0 == m_sampleRate)
     {
-        m_sampleRate = 4096e3;
+        qCCritical(soapySdrInput) << "Failed to open device. Sample rate >= 2048kHz not supported.";
+        SoapySDR::Device::unmake(m_device);
+        m_device = nullptr;
+        return false;
     }
-    else { /* neither 2048 nor 4096 kHz supported - using the lowest possible */ }
+    else { /* sample rate found */ }
 
     try
     {
@@ -243,7 +269,9 @@ bool SoapySdrInput::openDevice()
 
     m_deviceDescription.device.name = "SoapySDR | " + QString(m_device->getDriverKey().c_str());
     m_deviceDescription.device.model = QString(m_device->getHardwareKey().c_str());
+    // recording is taken from SRC output (or native stream @ 2048kHz)
     m_deviceDescription.sample.sampleRate = 2048000;
+    m_deviceDescription.sample.inputSampleRate = (2048e3 != m_sampleRate) ? qRound(m_sampleRate) : 0;
 #if SOAPYSDR_RECORD_INT16
     m_deviceDescription.sample.channelBits = sizeof(int16_t) * 8;
     m_deviceDescription.sample.containerBits = sizeof(int16_t) * 8;
@@ -257,7 +285,7 @@ bool SoapySdrInput::openDevice()
     SoapySDR::Stream *stream;
     try
     {
-        stream = m_device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, std::vector<size_t>(m_rxChannel));
+        stream = m_device->setupStream(SOAPY_SDR_RX, SoapySdrWorker::formatString(m_sampleFormat), std::vector<size_t>(m_rxChannel));
     }
     catch(const std::exception &ex)
     {
@@ -278,9 +306,12 @@ bool SoapySdrInput::openDevice()
     {   // stream is functional -> closing
         m_device->closeStream(stream);
     }
+    qCInfo(soapySdrInput) << "Stream format" << SoapySdrWorker::formatString(m_sampleFormat);
 
     m_deviceUnpluggedFlag = false;
 
+    openFifo();
+
     emit deviceReady();
 
     return true;
@@ -288,6 +319,16 @@ bool SoapySdrInput::openDevice()
 
 void SoapySdrInput::tune(uint32_t frequency)
 {
+    // AGC on new frequency starts from gain remembered for it
+    if (0 == m_receiver)
+    {
+        TunerStateCache::getInstance()->updateGain((SoapyGainMode::Software == m_gainMode) ? m_gainIdx : -1);
+        m_tunerState = TunerStateCache::getInstance()->tune(m_deviceDescription, frequency);
+    }
+    else
+    {   // cache follows primary receiver only
+        m_tunerState = TunerState();
+    }
     m_frequency = frequency;
     if ((m_deviceRunningFlag) || (0 == frequency))
     {   // worker is running
@@ -307,7 +348,7 @@ void SoapySdrInput::tune(uint32_t frequency)
 void SoapySdrInput::run()
 {
     // Reset buffer here - worker thread it not running, DAB waits for new data
-    inputBuffer.reset();
+    m_inputBuffer->reset();
 
     if (m_frequency != 0)
     {   // Tune to new frequency
@@ -316,7 +357,7 @@ void SoapySdrInput::run()
         // does nothing if manual AGC
         resetAgc();
 
-        m_worker = new SoapySdrWorker(m_device, m_sampleRate, m_rxChannel, this);
+        m_worker = new SoapySdrWorker(m_inputBuffer, m_device, m_sampleRate, m_rxChannel, m_sampleFormat, m_fullScale, this);
         connect(m_worker, &SoapySdrWorker::agcLevel, this, &SoapySdrInput::onAgcLevel, Qt::QueuedConnection);
         connect(m_worker, &SoapySdrWorker::recordBuffer, this, &InputDevice::recordBuffer, Qt::DirectConnection);
         connect(m_worker, &SoapySdrWorker::finished, this, &SoapySdrInput::onReadThreadStopped, Qt::QueuedConnection);
@@ -348,10 +389,7 @@ void SoapySdrInput::stop()
             qCWarning(soapySdrInput) << "Worker thread not finished after timeout - this should not happen :-(";
 
             // reset buffer - and tell the thread it is empty - buffer will be reset in any case
-            pthread_mutex_lock(&inputBuffer.countMutex);
-            inputBuffer.count = 0;
-            pthread_cond_signal(&inputBuffer.countCondition);
-            pthread_mutex_unlock(&inputBuffer.countMutex);
+            m_inputBuffer->flush();
             m_worker->wait(2000);
         }
     }
@@ -431,7 +469,7 @@ void SoapySdrInput::resetAgc()
     if (SoapyGainMode::Software == m_gainMode)
     {
         m_gainIdx = -1;
-        setGain(m_gainList->size() >> 1);
+        setGain((m_tunerState.gainIdx >= 0) ? m_tunerState.gainIdx : (m_gainList->size() >> 1));
     }
 }
 
@@ -462,7 +500,7 @@ void SoapySdrInput::onReadThreadStopped()
         m_deviceRunningFlag = false;
 
         // fill buffer (artificially to avoid blocking of the DAB processing thread)
-        inputBuffer.fillDummy();
+        m_inputBuffer->fillDummy();
 
         emit error(InputDeviceErrorCode::DeviceDisconnected);
     }
@@ -481,7 +519,7 @@ void SoapySdrInput::onWatchdogTimeout()
         if (!isRunning)
         {  // some problem in data input
             qCCritical(soapySdrInput) << "Watchdog timeout";
-            inputBuffer.fillDummy();
+            m_inputBuffer->fillDummy();
             emit error(InputDeviceErrorCode::NoDataAvailable);
         }
     }
@@ -522,26 +560,58 @@ void SoapySdrInput::setBW(uint32_t bw)
     }
 }
 
-SoapySdrWorker::SoapySdrWorker(SoapySDR::Device * device, double sampleRate, int rxChannel, QObject *parent)
+SoapySdrWorker::SoapySdrWorker(fifo_t * fifo, SoapySDR::Device * device, double sampleRate, int rxChannel, SoapySampleFormat format, double fullScale, QObject *parent)
     : QThread(parent)
 {
+    m_inputBuffer = fifo;
     m_isRecording = false;
     m_device =  device;
     m_rxChannel = rxChannel;
+    m_format = format;
+    m_scale = 1.0 / fullScale;
 
     // we cannot produce more samples in SRC
-    m_filterOutBuffer = (float *) operator new[](sizeof(float) * SOAPYSDR_INPUT_SAMPLES*2, (std::align_val_t)(16));
     m_src = new InputDeviceSRC(sampleRate);
+
+    // int16 samples in Q15 can be processed and recorded without conversion
+    bool isQ15 = (SoapySampleFormat::CS16 == m_format) && (32768.0 == fullScale);
+    m_useSrcS16 = isQ15 && m_src->hasS16Input();
+#if SOAPYSDR_RECORD_INT16
+    m_recordNative = isQ15 && (2048e3 == sampleRate);
+#else
+    m_recordNative = false;
+#endif
+    m_floatBuffer = nullptr;
+    if ((SoapySampleFormat::CF32 != m_format) && !m_useSrcS16)
+    {
+        m_floatBuffer = new float[SOAPYSDR_INPUT_SAMPLES * 2];
+    }
 }
 
 SoapySdrWorker::~SoapySdrWorker()
 {
     delete m_src;
-    operator delete [] (m_filterOutBuffer, std::align_val_t(16));
+    delete [] m_floatBuffer;
+}
+
+const char *SoapySdrWorker::formatString(SoapySampleFormat format)
+{
+    switch (format)
+    {
+    case SoapySampleFormat::CS16:
+        return SOAPY_SDR_CS16;
+    case SoapySampleFormat::CS8:
+        return SOAPY_SDR_CS8;
+    case SoapySampleFormat::CF32:
+    default:
+        return SOAPY_SDR_CF32;
+    }
 }
 
 void SoapySdrWorker::run()
 {
+    ThreadPriority::update(ThreadClass::Input);
+
     m_doReadIQ = true;
 
     m_agcLevel = 0.0;
@@ -551,7 +621,7 @@ void SoapySdrWorker::run()
     SoapySDR::Stream *stream = nullptr;
     try
     {
-        stream = m_device->setupStream(SOAPY_SDR_RX, SOAPY_SDR_CF32, std::vector<size_t>(m_rxChannel));
+        stream = m_device->setupStream(SOAPY_SDR_RX, formatString(m_format), std::vector<size_t>(m_rxChannel));
     }
     catch(const std::exception &ex)
     {
@@ -561,7 +631,8 @@ void SoapySdrWorker::run()
 
     m_device->activateStream(stream);
 
-    std::complex<float> inputBuffer[SOAPYSDR_INPUT_SAMPLES];
+    // buffer is large enough for any format, samples are interpreted according to stream format
+    alignas(16) float inputBuffer[SOAPYSDR_INPUT_SAMPLES * 2];
     void *buffs[] = {inputBuffer};
 
     while (m_doReadIQ)
@@ -622,10 +693,7 @@ void SoapySdrWorker::doRecordBuffer(const float *buf, uint32_t len)
 #if SOAPYSDR_RECORD_INT16
     // dumping in int16
     int16_t int16Buf[len];
-    for (int n = 0; n < len; ++n)
-    {
-        int16Buf[n] = int16_t(*buf++ * SOAPYSDR_RECORD_FLOAT2INT16);
-    }
+    InputDeviceKernels::convertToS16(buf, int16Buf, len, SOAPYSDR_RECORD_FLOAT2INT16);
     emit recordBuffer((const uint8_t *) int16Buf, len * sizeof(int16_t));
 #else
     // dumping in float
@@ -645,57 +713,62 @@ void SoapySdrWorker::stop()
     m_doReadIQ = false;
 }
 
-void SoapySdrWorker::processInputData(std::complex<float> buff[], size_t numSamples)
+void SoapySdrWorker::processInputData(void * buff, size_t numSamples)
 {
-    static float signalLevel = SOAPYSDR_LEVEL_RESET;
-
     // get FIFO space
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    uint64_t count = inputBuffer.count;
-    pthread_mutex_unlock(&inputBuffer.countMutex);
-
-    Q_ASSERT(count <= INPUT_FIFO_SIZE);
-
-    // input samples are IQ = [float float] @ sampleRate
-    // going to transform them to [float float] @ 2048kHz  
-    int numOutputIQ = m_src->process((float*) buff, numSamples, m_filterOutBuffer);
+    Q_ASSERT(m_inputBuffer->freeSpace() <= m_inputBuffer->size);
 
-    uint64_t bytesToWrite = numOutputIQ * 2 * sizeof(float);
-
-    if ((INPUT_FIFO_SIZE - count) < bytesToWrite)
+    // SRC cannot produce more samples than it gets (sample rate is >= 2048kHz)
+    if (!m_inputBuffer->prepareWrite(numSamples * 2 * sizeof(float)))
     {
         qCWarning(soapySdrInput) << "Dropping" << numSamples << "IQ samples...";
         return;
     }
 
-    if (0 == (++m_signalLevelEmitCntr & 0x0F))
+    // input samples are IQ in stream format @ sampleRate
+    // going to transform them to [float float] @ 2048kHz
+    // there is enough room in buffer, SRC writes directly to FIFO
+    float * outPtr = (float *) m_inputBuffer->reserve();
+    int numOutputIQ;
+    switch (m_format)
     {
-        emit agcLevel(m_src->signalLevel());
+    case SoapySampleFormat::CS16:
+        if (m_useSrcS16)
+        {   // fixed point SRC
+            numOutputIQ = m_src->process((const int16_t *) buff, numSamples, outPtr);
+        }
+        else
+        {
+            InputDeviceConverter<int16_t>(m_scale).process((const int16_t *) buff, m_floatBuffer, 2 * numSamples);
+            numOutputIQ = m_src->process(m_floatBuffer, numSamples, outPtr);
+        }
+        break;
+    case SoapySampleFormat::CS8:
+        InputDeviceConverter<int8_t>(m_scale).process((const int8_t *) buff, m_floatBuffer, 2 * numSamples);
+        numOutputIQ = m_src->process(m_floatBuffer, numSamples, outPtr);
+        break;
+    case SoapySampleFormat::CF32:
+    default:
+        numOutputIQ = m_src->process((float*) buff, numSamples, outPtr);
+        break;
     }
 
-    if (m_isRecording)
+    if (0 == (++m_signalLevelEmitCntr & 0x0F))
     {
-        doRecordBuffer(m_filterOutBuffer, 2*numOutputIQ);
+        emit agcLevel(m_src->signalLevel());
     }
 
-    // there is enough room in buffer
-    uint64_t bytesTillEnd = INPUT_FIFO_SIZE - inputBuffer.head;
-
-    if (bytesTillEnd >= bytesToWrite)
-    {
-        std::memcpy((inputBuffer.buffer + inputBuffer.head), (uint8_t *) m_filterOutBuffer, bytesToWrite);
-        inputBuffer.head = (inputBuffer.head + bytesToWrite);
-    }
-    else
+    if (m_isRecording)
     {
-        std::memcpy((inputBuffer.buffer + inputBuffer.head), (uint8_t *) m_filterOutBuffer, bytesTillEnd);
-        std::memcpy((inputBuffer.buffer), ((uint8_t *) m_filterOutBuffer)+bytesTillEnd, bytesToWrite-bytesTillEnd);
-        inputBuffer.head = bytesToWrite-bytesTillEnd;
+        if (m_recordNative)
+        {   // input is already int16 @ 2048kHz
+            emit recordBuffer((const uint8_t *) buff, numSamples * 2 * sizeof(int16_t));
+        }
+        else
+        {
+            doRecordBuffer(outPtr, 2*numOutputIQ);
+        }
     }
 
-    pthread_mutex_lock(&inputBuffer.countMutex);
-    inputBuffer.count = inputBuffer.count + bytesToWrite;
-    pthread_cond_signal(&inputBuffer.countCondition);
-    pthread_mutex_unlock(&inputBuffer.countMutex);
+    m_inputBuffer->commitWrite(numOutputIQ * 2 * sizeof(float));
 }
-
@@ -34,22 +34,32 @@
 #include <SoapySDR/Types.hpp>
 #include <SoapySDR/Formats.hpp>
 #include "inputdevice.h"
+#include "tunerstatecache.h"
 #include "inputdevicesrc.h"
 
 #define SOAPYSDR_RECORD_INT16  1               // record raw stream in int16 instead of float
 #define SOAPYSDR_RECORD_FLOAT2INT16  (32768)   // conversion constant to int16
 
 #define SOAPYSDR_INPUT_SAMPLES (16384)
+#define SOAPYSDR_NATIVE_FORMAT  1           // stream in device native format (CS16 or CS8) instead of CF32 when supported
 
 #define SOAPYSDR_LEVEL_THR_MAX (0.5)
 #define SOAPYSDR_LEVEL_THR_MIN (SOAPYSDR_LEVEL_THR_MAX/20.0)
 #define SOAPYSDR_LEVEL_RESET   ((SOAPYSDR_LEVEL_THR_MAX-SOAPYSDR_LEVEL_THR_MIN)/2.0 + SOAPYSDR_LEVEL_THR_MIN)
 
+enum class SoapySampleFormat
+{
+    CF32,
+    CS16,
+    CS8
+};
+
 class SoapySdrWorker : public QThread
 {
     Q_OBJECT
 public:
-    explicit SoapySdrWorker(SoapySDR::Device *device, double sampleRate, int rxChannel = 0, QObject *parent = nullptr);
+    explicit SoapySdrWorker(fifo_t * fifo, SoapySDR::Device *device, double sampleRate, int rxChannel = 0,
+                            SoapySampleFormat format = SoapySampleFormat::CF32, double fullScale = 1.0, QObject *parent = nullptr);
     ~SoapySdrWorker();
     void startStopRecording(bool ena);
     bool isRunning();
@@ -60,6 +70,7 @@ signals:
     void agcLevel(float level);
     void recordBuffer(const uint8_t * buf, uint32_t len);
 private:
+    fifo_t * m_inputBuffer;
     SoapySDR::Device * m_device;
     int m_rxChannel;
     std::atomic<bool> m_isRecording;
@@ -67,15 +78,22 @@ private:
     std::atomic<bool> m_doReadIQ;
 
     // SRC
-    float * m_filterOutBuffer;
     InputDeviceSRC * m_src;
 
+    // stream format
+    SoapySampleFormat m_format;
+    float m_scale;             // conversion of integer samples to float
+    bool m_useSrcS16;          // int16 samples go directly to fixed point SRC
+    bool m_recordNative;       // input samples are recorded without conversion (2048kHz, int16 full scale)
+    float * m_floatBuffer;     // conversion buffer for integer samples
+
     // AGC memory
     float m_agcLevel = 0.0;
     uint_fast8_t m_signalLevelEmitCntr;
 
     void doRecordBuffer(const float *buf, uint32_t len);
-    void processInputData(std::complex<float> buff[], size_t numSamples);
+    void processInputData(void * buff, size_t numSamples);
+    static const char * formatString(SoapySampleFormat format);
 };
 
 class SoapySdrInput : public InputDevice
@@ -107,9 +125,12 @@ private:
     QString m_antenna;
     int m_rxChannel = 0;
     SoapySdrWorker * m_worker;
+    SoapySampleFormat m_sampleFormat = SoapySampleFormat::CF32;
+    double m_fullScale = 1.0;
     QTimer m_watchdogTimer;
     SoapyGainMode m_gainMode = SoapyGainMode::Manual;
     int m_gainIdx;
+    TunerState m_tunerState;
     QList<float> * m_gainList;
 
     void run();           
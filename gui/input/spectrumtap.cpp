@@ -0,0 +1,232 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include "spectrumtap.h"
+
+SpectrumTap * SpectrumTap::m_instancePtr = nullptr;
+
+SpectrumTap *SpectrumTap::getInstance()
+{
+    if (m_instancePtr == nullptr)
+    {
+        m_instancePtr = new SpectrumTap();
+    }
+    return m_instancePtr;
+}
+
+SpectrumTap::SpectrumTap()
+{
+    const int N = SPECTRUMTAP_FFT_SIZE;
+
+    // Hann window, power normalization so that full scale tone is 0 dB
+    m_window.resize(N);
+    float windowSum = 0.0f;
+    for (int n = 0; n < N; ++n)
+    {
+        m_window[n] = 0.5f * (1.0f - std::cos(2.0f * float(M_PI) * n / N));
+        windowSum += m_window[n];
+    }
+    m_powerNorm = 1.0f / (windowSum * windowSum);
+
+    m_twiddle.resize(N / 2);
+    for (int k = 0; k < N / 2; ++k)
+    {
+        m_twiddle[k] = std::polar(1.0f, -2.0f * float(M_PI) * k / N);
+    }
+
+    int numBits = 0;
+    while ((1 << numBits) < N)
+    {
+        ++numBits;
+    }
+    m_bitReverse.resize(N);
+    for (int n = 0; n < N; ++n)
+    {
+        uint16_t rev = 0;
+        for (int b = 0; b < numBits; ++b)
+        {
+            rev |= ((n >> b) & 1) << (numBits - 1 - b);
+        }
+        m_bitReverse[n] = rev;
+    }
+
+    m_fftBuffer.resize(N);
+    m_avgPower.resize(N);
+}
+
+void SpectrumTap::start()
+{
+    if (nullptr != m_worker)
+    {   // already running
+        return;
+    }
+
+    // worker is not running here, its state can be reset from GUI thread
+    m_avgReset = true;
+    m_workerExit.store(false, std::memory_order_release);
+    m_worker = new std::thread(&SpectrumTap::worker, this);
+
+    m_restart.store(true, std::memory_order_release);
+    m_isRunning.store(true, std::memory_order_release);
+}
+
+void SpectrumTap::stop()
+{
+    m_isRunning.store(false, std::memory_order_release);
+
+    if (nullptr != m_worker)
+    {
+        m_workerExit.store(true, std::memory_order_release);
+        m_worker->join();
+        delete m_worker;
+        m_worker = nullptr;
+    }
+}
+
+void SpectrumTap::process(const float *iq, uint16_t numSamples)
+{
+    if (!m_isRunning.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    if (m_restart.exchange(false, std::memory_order_acq_rel))
+    {
+        m_captured = 0;
+        m_skip = 0;
+    }
+
+    int samples = numSamples;
+    while (samples > 0)
+    {
+        if (m_skip > 0)
+        {   // time decimation, samples between captures are ignored
+            int n = std::min(m_skip, samples);
+            m_skip -= n;
+            iq += 2 * n;
+            samples -= n;
+            continue;
+        }
+
+        int n = std::min(SPECTRUMTAP_FFT_SIZE - m_captured, samples);
+        std::memcpy(m_captureBuffer.back().data() + 2 * m_captured, iq, 2 * n * sizeof(float));
+        m_captured += n;
+        iq += 2 * n;
+        samples -= n;
+
+        if (SPECTRUMTAP_FFT_SIZE == m_captured)
+        {   // if worker did not pick previous capture yet, it is overwritten
+            m_captureBuffer.publish();
+            m_captured = 0;
+            m_skip = (SPECTRUMTAP_SAMPLE_RATE / 1000) * SPECTRUMTAP_PERIOD_MS - SPECTRUMTAP_FFT_SIZE;
+        }
+    }
+}
+
+bool SpectrumTap::getSpectrum(std::vector<float> &spectrumDb)
+{
+    if (!m_spectrumBuffer.update())
+    {
+        return false;
+    }
+    const auto & spectrum = m_spectrumBuffer.front();
+    spectrumDb.assign(spectrum.cbegin(), spectrum.cend());
+    return true;
+}
+
+void SpectrumTap::worker()
+{
+    // default priority, worker is not part of receiver pipeline
+    while (!m_workerExit.load(std::memory_order_acquire))
+    {
+        if (m_captureBuffer.update())
+        {
+            processCapture(m_captureBuffer.front().data());
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(SPECTRUMTAP_POLL_MS));
+        }
+    }
+}
+
+void SpectrumTap::processCapture(const float *iq)
+{
+    const int N = SPECTRUMTAP_FFT_SIZE;
+
+    // windowing and bit reversal permutation
+    for (int n = 0; n < N; ++n)
+    {
+        m_fftBuffer[m_bitReverse[n]] = std::complex<float>(iq[2 * n], iq[2 * n + 1]) * m_window[n];
+    }
+
+    fft(m_fftBuffer.data());
+
+    // exponential averaging, DC is moved to the middle
+    auto & out = m_spectrumBuffer.back();
+    for (int k = 0; k < N; ++k)
+    {
+        int idx = (k + N / 2) & (N - 1);
+        float power = std::norm(m_fftBuffer[idx]) * m_powerNorm;
+        if (m_avgReset)
+        {
+            m_avgPower[k] = power;
+        }
+        else
+        {
+            m_avgPower[k] += SPECTRUMTAP_AVG_ALPHA * (power - m_avgPower[k]);
+        }
+        out[k] = 10.0f * std::log10(m_avgPower[k] + 1e-20f);
+    }
+    m_avgReset = false;
+
+    m_spectrumBuffer.publish();
+}
+
+void SpectrumTap::fft(std::complex<float> *data) const
+{   // iterative radix-2 decimation in time, input is in bit reversed order
+    const int N = SPECTRUMTAP_FFT_SIZE;
+    for (int size = 2; size <= N; size <<= 1)
+    {
+        const int half = size >> 1;
+        const int step = N / size;
+        for (int start = 0; start < N; start += size)
+        {
+            std::complex<float> * a = data + start;
+            std::complex<float> * b = a + half;
+            for (int k = 0; k < half; ++k)
+            {
+                std::complex<float> t = m_twiddle[k * step] * b[k];
+                b[k] = a[k] - t;
+                a[k] += t;
+            }
+        }
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPECTRUMTAP_H
+#define SPECTRUMTAP_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <array>
+#include <vector>
+#include <complex>
+
+// spectrum of raw input samples, one FFT every SPECTRUMTAP_PERIOD_MS
+// dabsdr thread only copies FFT input, transform and averaging are done in worker thread
+#define SPECTRUMTAP_FFT_SIZE      (2048)    // 1 kHz resolution @ 2048 kHz, power of 2
+#define SPECTRUMTAP_SAMPLE_RATE   (2048000)
+#define SPECTRUMTAP_PERIOD_MS     (40)      // time decimation of FFT input
+#define SPECTRUMTAP_AVG_ALPHA     (0.25f)   // weight of new spectrum in exponential average
+#define SPECTRUMTAP_POLL_MS       (10)      // worker thread polling period
+
+// lock-free single producer / single consumer triple buffer
+// neither side ever waits, consumer always gets the latest published buffer
+template <typename T>
+class SpectrumTripleBuffer
+{
+public:
+    // producer
+    T & back() { return m_buffers[m_back]; }
+    void publish() { m_back = m_middle.exchange(m_back | SPECTRUMTAP_TB_DIRTY, std::memory_order_acq_rel) & SPECTRUMTAP_TB_INDEX; }
+
+    // consumer, returns true when new buffer was published since last call
+    bool update()
+    {
+        if (0 == (m_middle.load(std::memory_order_relaxed) & SPECTRUMTAP_TB_DIRTY))
+        {
+            return false;
+        }
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & SPECTRUMTAP_TB_INDEX;
+        return true;
+    }
+    const T & front() const { return m_buffers[m_front]; }
+
+private:
+    enum { SPECTRUMTAP_TB_INDEX = 0x3, SPECTRUMTAP_TB_DIRTY = 0x4 };
+    T m_buffers[3];
+    uint8_t m_back = 0;
+    std::atomic<uint8_t> m_middle { 1 };
+    uint8_t m_front = 2;
+};
+
+// singleton class
+// start(), stop() and getSpectrum() are called from GUI thread, process() is called from dabsdr thread
+class SpectrumTap
+{
+public:
+    SpectrumTap(const SpectrumTap & obj) = delete;   // deleting copy constructor
+    static SpectrumTap * getInstance();
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_isRunning.load(std::memory_order_acquire); }
+
+    // returns immediately when tap is not running, never blocks
+    void process(const float * iq, uint16_t numSamples);
+
+    // averaged power spectrum in dB, DC in the middle, returns false when no new spectrum is available
+    bool getSpectrum(std::vector<float> & spectrumDb);
+
+private:
+    SpectrumTap();
+    static SpectrumTap * m_instancePtr;
+
+    std::atomic<bool> m_isRunning { false };
+    std::atomic<bool> m_restart { false };
+    std::atomic<bool> m_workerExit { false };
+    std::thread * m_worker = nullptr;
+
+    // dabsdr thread state
+    int m_captured = 0;
+    int m_skip = 0;
+    SpectrumTripleBuffer<std::array<float, 2 * SPECTRUMTAP_FFT_SIZE>> m_captureBuffer;    // interleaved I/Q FFT input
+
+    // worker thread state
+    std::vector<float> m_window;
+    std::vector<std::complex<float>> m_twiddle;
+    std::vector<uint16_t> m_bitReverse;
+    std::vector<std::complex<float>> m_fftBuffer;
+    std::vector<float> m_avgPower;
+    float m_powerNorm = 1.0f;
+    bool m_avgReset = true;
+    SpectrumTripleBuffer<std::array<float, SPECTRUMTAP_FFT_SIZE>> m_spectrumBuffer;
+
+    void worker();
+    void processCapture(const float * iq);
+    void fft(std::complex<float> * data) const;
+};
+
+#endif // SPECTRUMTAP_H
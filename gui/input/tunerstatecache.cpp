@@ -0,0 +1,184 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QLoggingCategory>
+#include "tunerstatecache.h"
+
+Q_LOGGING_CATEGORY(tunerStateCache, "TunerStateCache", QtInfoMsg)
+
+TunerStateCache * TunerStateCache::m_instancePtr = nullptr;
+
+TunerStateCache *TunerStateCache::getInstance()
+{
+    if (m_instancePtr == nullptr)
+    {
+        m_instancePtr = new TunerStateCache();
+    }
+    return m_instancePtr;
+}
+
+TunerStateCache::TunerStateCache()
+{
+    load();
+}
+
+TunerState TunerStateCache::tune(const InputDeviceDescription &desc, uint32_t frequency)
+{
+    m_deviceKey = QString("%1/%2/%3").arg(int(desc.id)).arg(desc.device.name, desc.device.model);
+    m_frequency = frequency;
+
+    TunerState state = m_cache.value(m_deviceKey).value(frequency);
+    if (std::isnan(state.freqOffset) && (0 != frequency))
+    {   // frequency not visited yet, offset is estimated from other frequencies
+        state.freqOffset = ppm() * frequency / 1000.0;
+    }
+    if (0 != frequency)
+    {
+        qCDebug(tunerStateCache) << "Tune" << frequency << "kHz: gain index" << state.gainIdx << ", frequency offset" << state.freqOffset << "Hz";
+    }
+    return state;
+}
+
+void TunerStateCache::updateGain(int gainIdx)
+{
+    if ((0 == m_frequency) || (gainIdx < 0))
+    {
+        return;
+    }
+
+    TunerState & state = m_cache[m_deviceKey][m_frequency];
+    if (gainIdx != state.gainIdx)
+    {
+        state.gainIdx = gainIdx;
+        m_changed = true;
+    }
+}
+
+void TunerStateCache::updateFreqOffset(float offset)
+{
+    if ((0 == m_frequency) || std::isnan(offset))
+    {
+        return;
+    }
+
+    TunerState & state = m_cache[m_deviceKey][m_frequency];
+    if (std::isnan(state.freqOffset) || (std::abs(state.freqOffset - offset) >= 1.0))
+    {   // 1Hz resolution is enough, this avoids saving of noise
+        state.freqOffset = offset;
+        m_changed = true;
+    }
+}
+
+float TunerStateCache::ppm() const
+{
+    const QHash<uint32_t, TunerState> records = m_cache.value(m_deviceKey);
+    float sum = 0.0;
+    int num = 0;
+    for (auto it = records.cbegin(); it != records.cend(); ++it)
+    {
+        if (!std::isnan(it->freqOffset))
+        {   // frequency is in kHz
+            sum += it->freqOffset * 1000.0 / it.key();
+            num += 1;
+        }
+    }
+    return (num > 0) ? (sum / num) : NAN;
+}
+
+QString TunerStateCache::fileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/TunerState.cache";
+}
+
+void TunerStateCache::load()
+{
+    QFile file(fileName());
+    if (!file.open(QIODevice::ReadOnly))
+    {   // no cache yet
+        return;
+    }
+
+    QDataStream in(&file);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    quint32 magic;
+    quint16 version;
+    in >> magic >> version;
+    if ((TUNERSTATECACHE_MAGIC != magic) || (TUNERSTATECACHE_VERSION != version))
+    {
+        qCDebug(tunerStateCache) << "Unsupported tuner state cache file";
+        return;
+    }
+
+    while (!in.atEnd() && (QDataStream::Ok == in.status()))
+    {
+        QString device;
+        quint32 frequency;
+        qint32 gainIdx;
+        float freqOffset;
+        in >> device >> frequency >> gainIdx >> freqOffset;
+        if (QDataStream::Ok == in.status())
+        {
+            m_cache[device][frequency] = TunerState{ gainIdx, freqOffset };
+        }
+    }
+    qCDebug(tunerStateCache) << "Tuner state cache loaded," << m_cache.size() << "devices";
+}
+
+void TunerStateCache::save()
+{
+    if (!m_changed)
+    {
+        return;
+    }
+
+    QDir().mkpath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    QSaveFile file(fileName());
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qCWarning(tunerStateCache) << "Failed to store tuner state cache";
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << quint32(TUNERSTATECACHE_MAGIC) << quint16(TUNERSTATECACHE_VERSION);
+    for (auto devIt = m_cache.cbegin(); devIt != m_cache.cend(); ++devIt)
+    {
+        for (auto it = devIt->cbegin(); it != devIt->cend(); ++it)
+        {
+            out << devIt.key() << quint32(it.key()) << qint32(it->gainIdx) << it->freqOffset;
+        }
+    }
+    if (file.commit())
+    {
+        m_changed = false;
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TUNERSTATECACHE_H
+#define TUNERSTATECACHE_H
+
+#include <QHash>
+#include <QString>
+#include <cmath>
+#include "inputdevice.h"
+
+#define TUNERSTATECACHE_MAGIC    (0x54534331)   // "TSC1"
+#define TUNERSTATECACHE_VERSION  (1)
+
+struct TunerState
+{
+    int gainIdx = -1;              // last gain index of software AGC, -1 if unknown
+    float freqOffset = NAN;        // Hz, measured by demodulator in full sync (estimated from device PPM if not visited)
+};
+
+// singleton class
+// persistent per-device and per-frequency state, AGC starts from last gain instead of default
+// all methods are called from GUI thread
+class TunerStateCache
+{
+public:
+    TunerStateCache(const TunerStateCache & obj) = delete;   // deleting copy constructor
+    static TunerStateCache * getInstance();
+
+    // input device calls it when tuning, records of new frequency are updated by following calls
+    TunerState tune(const InputDeviceDescription & desc, uint32_t frequency);
+    void updateGain(int gainIdx);
+    void updateFreqOffset(float offset);
+
+    void save();
+
+private:
+    TunerStateCache();
+    static TunerStateCache * m_instancePtr;
+
+    QString m_deviceKey;
+    uint32_t m_frequency = 0;
+    bool m_changed = false;
+    QHash<QString, QHash<uint32_t, TunerState>> m_cache;
+
+    // frequency offset relative to carrier averaged over all frequencies of current device
+    float ppm() const;
+    void load();
+    static QString fileName();
+};
+
+#endif // TUNERSTATECACHE_H
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include <libusb.h>
+#include "usbhotplug.h"
+
+Q_LOGGING_CATEGORY(usbHotplug, "UsbHotplug", QtInfoMsg)
+
+// libusb callback signature uses libusb types, it is wrapped here
+static int LIBUSB_CALL hotplugCallback(libusb_context * ctx, libusb_device * device, libusb_hotplug_event event, void * userData)
+{
+    struct libusb_device_descriptor desc;
+    if (LIBUSB_SUCCESS != libusb_get_device_descriptor(device, &desc))
+    {
+        return 0;
+    }
+
+    UsbHotplug * hotplug = static_cast<UsbHotplug *>(userData);
+    if (LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED == event)
+    {
+        emit hotplug->deviceArrived(desc.idVendor, desc.idProduct);
+    }
+    else
+    {
+        emit hotplug->deviceLeft(desc.idVendor, desc.idProduct);
+    }
+    (void) ctx;
+
+    return 0;  // stay registered
+}
+
+UsbHotplug::UsbHotplug(QObject *parent) : QObject(parent)
+{
+    if (LIBUSB_SUCCESS != libusb_init(&m_context))
+    {
+        qCWarning(usbHotplug) << "libusb init failed";
+        m_context = nullptr;
+        return;
+    }
+
+    if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG))
+    {
+        qCInfo(usbHotplug) << "USB hotplug is not supported on this platform";
+        return;
+    }
+
+    // no enumeration of devices connected already, only changes are reported
+    int ret = libusb_hotplug_register_callback(m_context,
+                                               libusb_hotplug_event(LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT),
+                                               libusb_hotplug_flag(0),
+                                               LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+                                               hotplugCallback, this, &m_callbackHandle);
+    if (LIBUSB_SUCCESS != ret)
+    {
+        qCWarning(usbHotplug) << "Failed to register USB hotplug callback:" << libusb_error_name(ret);
+        return;
+    }
+
+    m_isSupported = true;
+    m_eventThread = new std::thread(&UsbHotplug::eventLoop, this);
+}
+
+UsbHotplug::~UsbHotplug()
+{
+    if (nullptr != m_eventThread)
+    {
+        m_exitRequest = true;
+        libusb_hotplug_deregister_callback(m_context, m_callbackHandle);  // this also wakes up event loop
+        m_eventThread->join();
+        delete m_eventThread;
+    }
+    if (nullptr != m_context)
+    {
+        libusb_exit(m_context);
+    }
+}
+
+void UsbHotplug::eventLoop()
+{
+    while (!m_exitRequest)
+    {
+        struct timeval tv = { 0, USBHOTPLUG_EVENT_TIMEOUT_MS * 1000 };
+        libusb_handle_events_timeout_completed(m_context, &tv, nullptr);
+    }
+}
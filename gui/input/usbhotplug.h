@@ -0,0 +1,63 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef USBHOTPLUG_H
+#define USBHOTPLUG_H
+
+#include <QObject>
+#include <thread>
+#include <atomic>
+
+#define USBHOTPLUG_EVENT_TIMEOUT_MS  (200)    // libusb event loop wakes up periodically to check exit request
+
+struct libusb_context;
+
+// USB hotplug notification based on libusb (Linux, macOS)
+// libusb does not support hotplug on Windows => isSupported() is false and devices rely on watchdog
+// signals are emitted from libusb event thread
+class UsbHotplug : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UsbHotplug(QObject *parent = nullptr);
+    ~UsbHotplug();
+    bool isSupported() const { return m_isSupported; }
+
+signals:
+    void deviceArrived(quint16 vid, quint16 pid);
+    void deviceLeft(quint16 vid, quint16 pid);
+
+private:
+    libusb_context * m_context = nullptr;
+    int m_callbackHandle = 0;
+    bool m_isSupported = false;
+    std::atomic<bool> m_exitRequest { false };
+    std::thread * m_eventThread = nullptr;
+
+    void eventLoop();
+};
+
+#endif // USBHOTPLUG_H
@@ -47,6 +47,8 @@ LogDialog::LogDialog(QWidget *parent) :
     m_dataModel = new LogModel(this);
     ui->logListView->setModel(m_dataModel);
     ui->logListView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    // all rows have the same height -> view lays out and paints only visible rows
+    ui->logListView->setUniformItemSizes(true);
 
     static const char kViewAtBottom[] = "viewAtBottom";
     auto *scrollBar = ui->logListView->verticalScrollBar();
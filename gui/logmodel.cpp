@@ -27,9 +27,19 @@
 #include <QColor>
 #include "logmodel.h"
 
+LogModel::LogModel(QObject *parent) : QAbstractListModel(parent), m_isDarkMode(false)
+{
+    m_msgRing.resize(LOGMODEL_CAPACITY);
+    m_memory.set(LOGMODEL_CAPACITY * sizeof(LogItem));
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setInterval(LOGMODEL_FLUSH_MS);
+    m_flushTimer->setSingleShot(true);
+    connect(m_flushTimer, &QTimer::timeout, this, &LogModel::flush);
+}
+
 int LogModel::rowCount(const QModelIndex &parent) const
 {
-    return m_msgList.size();
+    return m_count;
 }
 
 QVariant LogModel::data(const QModelIndex &index, int role) const
@@ -39,7 +49,7 @@ QVariant LogModel::data(const QModelIndex &index, int role) const
         return QVariant();
     }
 
-    if (m_msgList.size() > index.row())
+    if (m_count > index.row())
     {
         switch (role)
         {
@@ -48,7 +58,7 @@ QVariant LogModel::data(const QModelIndex &index, int role) const
         case Qt::ForegroundRole:
             if (m_isDarkMode)
             {
-                switch (m_msgList.at(index.row()).type)
+                switch (item(index.row()).type)
                 {
                 case QtInfoMsg:
                     return QVariant();
@@ -66,7 +76,7 @@ QVariant LogModel::data(const QModelIndex &index, int role) const
             }
             else
             {
-                switch (m_msgList.at(index.row()).type)
+                switch (item(index.row()).type)
                 {
                 case QtInfoMsg:
                     return QVariant();
@@ -84,7 +94,7 @@ QVariant LogModel::data(const QModelIndex &index, int role) const
             }
             break;
         case Qt::DisplayRole:
-            return m_msgList.at(index.row()).msg;
+            return item(index.row()).msg;
         default:
             return QVariant();
         }
@@ -93,52 +103,82 @@ QVariant LogModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
-bool LogModel::setData(const QModelIndex & index, const QVariant & value, int role)
+bool LogModel::removeRows(int position, int rows, const QModelIndex &index)
 {
-    if (!index.isValid())
+    if ((position < 0) || (rows <= 0) || (position + rows > m_count))
     {
         return false;
     }
-    if (m_msgList.size() > index.row())
+
+    beginRemoveRows(QModelIndex(), position, position+rows-1);
+    for (int row = position; row < position + rows; ++row)
     {
-        m_msgList[index.row()].msg = value.toString();
-        m_msgList[index.row()].type = static_cast<QtMsgType>(role);
-        return true;
+        m_msgBytes -= item(row).msg.size() * sizeof(QChar);
+    }
+    if (0 == position)
+    {   // oldest messages -> only start is moved
+        for (int row = 0; row < rows; ++row)
+        {   // release memory
+            m_msgRing[(m_start + row) % LOGMODEL_CAPACITY] = LogItem();
+        }
+        m_start = (m_start + rows) % LOGMODEL_CAPACITY;
     }
     else
-    {
-        return false;
+    {   // shifting newer messages
+        for (int row = position; row + rows < m_count; ++row)
+        {
+            m_msgRing[(m_start + row) % LOGMODEL_CAPACITY] = std::move(m_msgRing[(m_start + row + rows) % LOGMODEL_CAPACITY]);
+        }
+        for (int row = m_count - rows; row < m_count; ++row)
+        {
+            m_msgRing[(m_start + row) % LOGMODEL_CAPACITY] = LogItem();
+        }
     }
+    m_count -= rows;
+    m_memory.set(LOGMODEL_CAPACITY * sizeof(LogItem) + m_msgBytes);
+    endRemoveRows();
+    return true;
 }
 
-bool LogModel::insertRows(int position, int rows, const QModelIndex &index)
+void LogModel::append(const QString & rowTxt, QtMsgType type)
 {
-    beginInsertRows(QModelIndex(), position, position+rows-1);
-
-    for (int row = 0; row < rows; ++row) {
-        m_msgList.insert(position, LogItem());
+    QMutexLocker locker(&m_pendingMutex);
+    m_pendingList.append({rowTxt, type});
+    if (1 == m_pendingList.size())
+    {   // first pending message starts timer in GUI thread
+        QMetaObject::invokeMethod(m_flushTimer, [this]() { m_flushTimer->start(); }, Qt::QueuedConnection);
     }
-
-    endInsertRows();
-    return true;
 }
 
-bool LogModel::removeRows(int position, int rows, const QModelIndex &index)
+void LogModel::flush()
 {
-    beginRemoveRows(QModelIndex(), position, position+rows-1);
-
-    for (int row = 0; row < rows; ++row) {
-        m_msgList.removeAt(position);
+    QList<struct LogItem> batch;
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        batch.swap(m_pendingList);
+    }
+    if (batch.isEmpty())
+    {
+        return;
+    }
+    if (batch.size() > LOGMODEL_CAPACITY)
+    {   // only newest messages fit
+        batch.remove(0, batch.size() - LOGMODEL_CAPACITY);
     }
 
-    endRemoveRows();
-    return true;
-}
-
-void LogModel::appendRow(const QString & rowTxt, int role)
-{
-    int row = rowCount();
-    insertRow(row);
-    setData(index(row, 0), rowTxt, role);
+    int overflow = m_count + batch.size() - LOGMODEL_CAPACITY;
+    if (overflow > 0)
+    {
+        removeRows(0, overflow);
+    }
 
+    beginInsertRows(QModelIndex(), m_count, m_count + batch.size() - 1);
+    for (auto & logItem : batch)
+    {
+        m_msgBytes += logItem.msg.size() * sizeof(QChar);
+        m_msgRing[(m_start + m_count) % LOGMODEL_CAPACITY] = std::move(logItem);
+        m_count += 1;
+    }
+    m_memory.set(LOGMODEL_CAPACITY * sizeof(LogItem) + m_msgBytes);
+    endInsertRows();
 }
@@ -30,19 +30,26 @@
 #include <QFontDatabase>
 #include <QAbstractListModel>
 #include <QObject>
+#include <QMutex>
+#include <QTimer>
+#include <vector>
+#include "diagnostics.h"
 
+#define LOGMODEL_CAPACITY       (20000)     // messages, oldest are dropped
+#define LOGMODEL_FLUSH_MS       (100)       // pending messages are inserted in batches
+
+// fixed capacity circular store of log messages
+// append() can be called from any thread, messages are inserted to model periodically in GUI thread
 class LogModel : public QAbstractListModel
 {
     Q_OBJECT
 public:
-    LogModel(QObject *parent = nullptr) : m_isDarkMode(false), QAbstractListModel(parent) {}
+    LogModel(QObject *parent = nullptr);
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
-    bool setData(const QModelIndex & index, const QVariant & value, int role) override;
-    bool insertRows(int position, int rows, const QModelIndex &index = QModelIndex()) override;
     bool removeRows(int position, int rows, const QModelIndex &index = QModelIndex()) override;
     void setupDarkMode(bool darkModeEna) { m_isDarkMode = darkModeEna; }
-    Q_INVOKABLE void appendRow(const QString & rowTxt, int role);
+    void append(const QString & rowTxt, QtMsgType type);
 
 private:
     const QFont fixedFont = QFontDatabase::systemFont(QFontDatabase::FixedFont);
@@ -53,7 +60,18 @@ private:
     };
 
     bool m_isDarkMode;
-    QList<struct LogItem> m_msgList;
+    std::vector<struct LogItem> m_msgRing;
+    int m_start = 0;                    // index of row 0 in ring
+    int m_count = 0;
+    qint64 m_msgBytes = 0;              // text of messages in ring
+    DiagnosticsMemoryCounter m_memory { DiagnosticsMemory::LogModel };
+
+    QMutex m_pendingMutex;
+    QList<struct LogItem> m_pendingList;
+    QTimer * m_flushTimer;
+
+    const LogItem & item(int row) const { return m_msgRing[(m_start + row) % LOGMODEL_CAPACITY]; }
+    void flush();
 };
 
 #endif // LOGMODEL_H
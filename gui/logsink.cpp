@@ -0,0 +1,296 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QDir>
+#include <QDateTime>
+#include <cstring>
+#include <chrono>
+
+#include "logsink.h"
+
+LogSink * LogSink::m_instancePtr = nullptr;
+
+LogSink *LogSink::getInstance()
+{
+    if (m_instancePtr == nullptr)
+    {
+        m_instancePtr = new LogSink();
+    }
+    return m_instancePtr;
+}
+
+LogSink::LogSink() : QThread(nullptr)
+{
+    m_slots = new Slot[LOGSINK_SLOTS];
+    for (uint64_t n = 0; n < LOGSINK_SLOTS; ++n)
+    {
+        m_slots[n].sequence.store(n, std::memory_order_relaxed);
+    }
+    setObjectName("logSinkThr");
+}
+
+void LogSink::start(const QString &directory, int maxFileSizeMB, int maxFiles)
+{
+    if (isRunning())
+    {
+        return;
+    }
+    m_directory = directory;
+    m_maxFileSize = qint64(qMax(1, maxFileSizeMB)) * 1024 * 1024;
+    m_maxFiles = qMax(1, maxFiles);
+    m_exitRequest = false;
+    QThread::start(QThread::LowPriority);
+}
+
+void LogSink::finish()
+{
+    m_exitRequest = true;
+    wait();
+}
+
+void LogSink::push(QtMsgType type, const char *category, const QString &msg)
+{
+    uint64_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    Slot * slot;
+    while (1)
+    {
+        slot = &m_slots[pos & (LOGSINK_SLOTS - 1)];
+        int64_t diff = int64_t(slot->sequence.load(std::memory_order_acquire)) - int64_t(pos);
+        if (0 == diff)
+        {   // slot is free
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {   // queue is full
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {   // other thread took this slot
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    QByteArray utf8 = msg.toUtf8();
+    slot->timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    slot->category = (nullptr != category) ? category : "default";
+    slot->type = uint8_t(type);
+    slot->len = uint16_t(qMin(qsizetype(LOGSINK_SLOT_SIZE), utf8.size()));
+    memcpy(slot->data, utf8.constData(), slot->len);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void LogSink::run()
+{
+    openFile();
+    while (1)
+    {
+        bool exitRequest = m_exitRequest;     // records pushed before exit request are written
+        int numRecords = 0;
+        while (encodeNext())
+        {
+            numRecords += 1;
+        }
+        uint32_t dropped = m_dropped.exchange(0);
+        if (dropped > 0)
+        {
+            m_writeBuffer.append(char(2));
+            m_writeBuffer.append(reinterpret_cast<const char *>(&dropped), sizeof(dropped));
+        }
+        writeBuffer();
+
+        if (exitRequest)
+        {
+            break;
+        }
+        if (0 == numRecords)
+        {
+            QThread::msleep(LOGSINK_PERIOD_MS);
+        }
+    }
+    m_file.close();
+}
+
+bool LogSink::encodeNext()
+{
+    Slot * slot = &m_slots[m_dequeuePos & (LOGSINK_SLOTS - 1)];
+    if (slot->sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+    {   // empty or record is being written
+        return false;
+    }
+
+    auto it = m_categoryIds.constFind(slot->category);
+    uint16_t catId;
+    if (m_categoryIds.cend() == it)
+    {   // first message of category in this file
+        catId = uint16_t(m_categoryIds.size());
+        m_categoryIds.insert(slot->category, catId);
+        uint8_t len = uint8_t(qMin(size_t(255), strlen(slot->category)));
+        m_writeBuffer.append(char(0));
+        m_writeBuffer.append(reinterpret_cast<const char *>(&catId), sizeof(catId));
+        m_writeBuffer.append(char(len));
+        m_writeBuffer.append(slot->category, len);
+    }
+    else
+    {
+        catId = *it;
+    }
+
+    m_writeBuffer.append(char(1));
+    m_writeBuffer.append(reinterpret_cast<const char *>(&slot->timestampUs), sizeof(slot->timestampUs));
+    m_writeBuffer.append(char(slot->type));
+    m_writeBuffer.append(reinterpret_cast<const char *>(&catId), sizeof(catId));
+    m_writeBuffer.append(reinterpret_cast<const char *>(&slot->len), sizeof(slot->len));
+    m_writeBuffer.append(slot->data, slot->len);
+
+    // release slot for producers
+    slot->sequence.store(m_dequeuePos + LOGSINK_SLOTS, std::memory_order_release);
+    m_dequeuePos += 1;
+    return true;
+}
+
+void LogSink::writeBuffer()
+{
+    if (m_writeBuffer.isEmpty())
+    {
+        return;
+    }
+    if (m_file.isOpen())
+    {
+        m_file.write(m_writeBuffer);
+        m_file.flush();
+        if (m_file.size() > m_maxFileSize)
+        {
+            openFile();
+        }
+    }
+    m_writeBuffer.clear();
+}
+
+void LogSink::openFile()
+{
+    if (m_file.isOpen())
+    {
+        m_file.close();
+    }
+
+    QDir dir(m_directory);
+    if (!dir.exists())
+    {
+        dir.mkpath(".");
+    }
+
+    // oldest files are removed, names are sortable by time
+    QStringList files = dir.entryList(QStringList() << "AbracaDABra_*.blog", QDir::Files, QDir::Name);
+    while (files.size() >= m_maxFiles)
+    {
+        dir.remove(files.takeFirst());
+    }
+
+    QString fileName = dir.filePath(QString("AbracaDABra_%1.blog").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hhmmss_zzz")));
+    m_file.setFileName(fileName);
+    if (m_file.open(QIODevice::WriteOnly))
+    {
+        m_file.write(LOGSINK_FILE_MAGIC, 8);
+    }
+    else { /* records are dropped, logging here would recurse */ }
+    m_categoryIds.clear();
+}
+
+bool LogSink::decode(const QString &fileName, QTextStream &out)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QByteArray data = file.readAll();
+    if (!data.startsWith(LOGSINK_FILE_MAGIC))
+    {
+        return false;
+    }
+
+    static const char levelChar[] = { 'D', 'W', 'C', 'F', 'I' };   // QtMsgType order
+    QHash<uint16_t, QString> categories;
+    const char * ptr = data.constData() + 8;
+    const char * end = data.constData() + data.size();
+    auto canRead = [&ptr, end](qsizetype n) { return (end - ptr) >= n; };
+    while (canRead(1))
+    {
+        uint8_t type = uint8_t(*ptr++);
+        if ((0 == type) && canRead(3))
+        {
+            uint16_t id;
+            memcpy(&id, ptr, sizeof(id));
+            uint8_t len = uint8_t(ptr[2]);
+            ptr += 3;
+            if (!canRead(len))
+            {
+                break;
+            }
+            categories.insert(id, QString::fromLatin1(ptr, len));
+            ptr += len;
+        }
+        else if ((1 == type) && canRead(13))
+        {
+            uint64_t timestampUs;
+            uint16_t catId;
+            uint16_t len;
+            memcpy(&timestampUs, ptr, sizeof(timestampUs));
+            uint8_t level = uint8_t(ptr[8]);
+            memcpy(&catId, ptr + 9, sizeof(catId));
+            memcpy(&len, ptr + 11, sizeof(len));
+            ptr += 13;
+            if (!canRead(len))
+            {
+                break;
+            }
+            QString timeStamp = QDateTime::fromMSecsSinceEpoch(timestampUs / 1000).toString("yyyy-MM-dd HH:mm:ss.zzz");
+            out << QString("%1%2 [%3] %4: %5")
+                       .arg(timeStamp)
+                       .arg(timestampUs % 1000, 3, 10, QChar('0'))
+                       .arg(level < sizeof(levelChar) ? levelChar[level] : '?')
+                       .arg(categories.value(catId), QString::fromUtf8(ptr, len))
+                << Qt::endl;
+            ptr += len;
+        }
+        else if ((2 == type) && canRead(4))
+        {
+            uint32_t count;
+            memcpy(&count, ptr, sizeof(count));
+            ptr += 4;
+            out << QString("--- %1 records dropped ---").arg(count) << Qt::endl;
+        }
+        else
+        {   // corrupted or truncated
+            break;
+        }
+    }
+    return true;
+}
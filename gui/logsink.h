@@ -0,0 +1,103 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include <QThread>
+#include <QFile>
+#include <QHash>
+#include <QTextStream>
+#include <atomic>
+#include <cstdint>
+
+#define LOGSINK_SLOTS            (8192)          // must be power of 2
+#define LOGSINK_SLOT_SIZE        (240)           // bytes of UTF-8 message, longer messages are truncated
+#define LOGSINK_PERIOD_MS        (50)            // writer thread period
+#define LOGSINK_FILE_SIZE_MB     (16)            // default size of one file
+#define LOGSINK_NUM_FILES        (8)             // default number of rotated files
+#define LOGSINK_FILE_MAGIC       "ADBRLOG1"      // 8 bytes at the beginning of every file
+
+// asynchronous log sink writing binary log files
+// push() is lock-free and never blocks (bounded MPMC slot queue), record is dropped when queue is full
+// background thread encodes records and writes files, file is rotated when it exceeds maximum size
+//
+// file format (little endian): magic, then records
+//   category definition: u8 type = 0, u16 id, u8 len, name
+//   message:             u8 type = 1, u64 timestamp [us since epoch], u8 level (QtMsgType), u16 category id, u16 len, UTF-8 message
+//   dropped records:     u8 type = 2, u32 count
+class LogSink : public QThread
+{
+    Q_OBJECT
+public:
+    LogSink(const LogSink & obj) = delete;
+    static LogSink * getInstance();
+
+    void start(const QString & directory, int maxFileSizeMB = LOGSINK_FILE_SIZE_MB, int maxFiles = LOGSINK_NUM_FILES);
+    void finish();
+
+    // can be called from any thread, category must be pointer to static string (as in QMessageLogContext)
+    void push(QtMsgType type, const char * category, const QString & msg);
+
+    // converts binary log file to text, returns false if file cannot be read
+    static bool decode(const QString & fileName, QTextStream & out);
+
+protected:
+    void run() override;
+
+private:
+    LogSink();
+    static LogSink * m_instancePtr;
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        uint64_t timestampUs;
+        const char * category;
+        uint8_t type;
+        uint16_t len;
+        char data[LOGSINK_SLOT_SIZE];
+    };
+    Slot * m_slots;
+    std::atomic<uint64_t> m_enqueuePos { 0 };
+    uint64_t m_dequeuePos = 0;                  // writer thread only
+    std::atomic<uint32_t> m_dropped { 0 };
+    std::atomic<bool> m_exitRequest { false };
+
+    // writer thread
+    QString m_directory;
+    qint64 m_maxFileSize;
+    int m_maxFiles;
+    QFile m_file;
+    QByteArray m_writeBuffer;
+    QHash<const char *, uint16_t> m_categoryIds;
+
+    bool encodeNext();                          // false when queue is empty
+    void openFile();
+    void writeBuffer();
+};
+
+#endif // LOGSINK_H
@@ -28,15 +28,63 @@
 #include <QCommandLineParser>
 #include <QTranslator>
 #include <QLibraryInfo>
+#include <QDir>
+#include <cstring>
 #include "mainwindow.h"
+#include "batchdecoder.h"
+#include "zapbenchmark.h"
+#include "audiodecoderbenchmark.h"
+#include "servicelistbenchmark.h"
+#include "diagnosticsserver.h"
+#include "logsink.h"
+#include "inputdevice.h"
+#include "rawfileinput.h"
 #include "config.h"
 
+// options of modes without display, all of them take value
+// argument is matched in forms accepted by QCommandLineParser: "-b file", "-bfile", "--batch file" and "--batch=file"
+static bool isHeadlessOption(const char * arg)
+{
+    static const char * const shortNames = "brlz";
+    static const char * const longNames[] = { "batch", "replay-audio", "decode-log", "zap-benchmark", "servicelist-benchmark" };
+
+    if (('-' != arg[0]) || ('\0' == arg[1]))
+    {
+        return false;
+    }
+    if ('-' != arg[1])
+    {   // short option, value can be attached
+        return (nullptr != strchr(shortNames, arg[1]));
+    }
+    for (const char * name : longNames)
+    {
+        size_t len = strlen(name);
+        if ((0 == strncmp(arg + 2, name, len)) && (('\0' == arg[2 + len]) || ('=' == arg[2 + len])))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 int main(int argc, char *argv[])
 {
 
     QCoreApplication::setApplicationName("AbracaDABra");
     QCoreApplication::setApplicationVersion(PROJECT_VER);
 
+    for (int n = 1; n < argc; ++n)
+    {   // batch mode and benchmark run without display
+        if (isHeadlessOption(argv[n]))
+        {
+            if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+            {
+                qputenv("QT_QPA_PLATFORM", "offscreen");
+            }
+            break;
+        }
+    }
+
     QApplication a(argc, argv);
 
     QCommandLineParser parser;
@@ -49,11 +97,180 @@ int main(int argc, char *argv[])
                                      QObject::tr("Optional INI file. If not specified AbracaDABra.ini in system directory will be used."), "ini");
     parser.addOption(iniFileOption);
 
+    // batch decoding options
+    QCommandLineOption batchOption(QStringList() << "b" << "batch",
+                                   QObject::tr("Decode raw file without GUI at maximum speed."), "file");
+    parser.addOption(batchOption);
+    QCommandLineOption batchOutputOption(QStringList() << "o" << "output",
+                                         QObject::tr("Output directory for batch decoding. Current directory is used if not specified."), "dir");
+    parser.addOption(batchOutputOption);
+    QCommandLineOption batchFormatOption(QStringList() << "f" << "format",
+                                         QObject::tr("Raw file sample format for batch decoding: u8 (default), s8, s16, u16, cs12 or cf32. Ignored when file has XML or WAV header."), "format");
+    parser.addOption(batchFormatOption);
+    QCommandLineOption batchServiceOption(QStringList() << "s" << "service",
+                                          QObject::tr("Service ID (hex) for batch decoding. First audio service is decoded if not specified."), "SId");
+    parser.addOption(batchServiceOption);
+    QCommandLineOption batchWavOption(QStringList() << "w" << "wav",
+                                      QObject::tr("Record decoded audio to WAV files in batch decoding instead of encoded stream."));
+    parser.addOption(batchWavOption);
+    QCommandLineOption batchAllOption(QStringList() << "a" << "all",
+                                      QObject::tr("Decode all packet data services and one more audio service in batch decoding."));
+    parser.addOption(batchAllOption);
+    QCommandLineOption batchAudioDumpOption(QStringList() << "u" << "dump-au",
+                                            QObject::tr("Dump audio AUs of selected service to file in batch decoding (corpus for audio decoder benchmark)."), "file");
+    parser.addOption(batchAudioDumpOption);
+
+    // audio decoder benchmark
+    QCommandLineOption replayAudioOption(QStringList() << "r" << "replay-audio",
+                                         QObject::tr("Decode audio AUs dumped by batch decoding and report decoding time per AU."), "file");
+    parser.addOption(replayAudioOption);
+
+    // zapping latency benchmark
+    QCommandLineOption zapOption(QStringList() << "z" << "zap-benchmark",
+                                 QObject::tr("Replay raw file and report time to sync, ensemble, service, first audio and first slide. Can be used repeatedly."), "file");
+    parser.addOption(zapOption);
+    QCommandLineOption zapChunkOption(QStringList() << "zap-chunk",
+                                      QObject::tr("Comma separated list of input chunk sizes [ms] for zapping benchmark."), "list");
+    parser.addOption(zapChunkOption);
+    QCommandLineOption zapFifoOption(QStringList() << "zap-fifo",
+                                     QObject::tr("Comma separated list of input FIFO sizes [chunks] for zapping benchmark."), "list");
+    parser.addOption(zapFifoOption);
+    QCommandLineOption zapFastOption(QStringList() << "zap-fast",
+                                     QObject::tr("Replay files at maximum speed in zapping benchmark."));
+    parser.addOption(zapFastOption);
+
+    // service list scalability benchmark
+    QCommandLineOption serviceListBenchOption(QStringList() << "servicelist-benchmark",
+                                              QObject::tr("Fill service list with synthetic services and report time of insertion, sorting, filtering, save and load. "
+                                                          "Comma separated list of numbers of services."), "list");
+    parser.addOption(serviceListBenchOption);
+
+    // diagnostics
+    QCommandLineOption metricsPortOption(QStringList() << "m" << "metrics-port",
+                                         QObject::tr("Provide diagnostics on local HTTP port (/metrics in Prometheus format, JSON otherwise)."), "port");
+    parser.addOption(metricsPortOption);
+    QCommandLineOption decodeLogOption(QStringList() << "l" << "decode-log",
+                                       QObject::tr("Print binary log file written by log sink as text."), "file");
+    parser.addOption(decodeLogOption);
+    // memory
+    QCommandLineOption lowMemoryOption(QStringList() << "low-memory",
+                                       QObject::tr("Use small input buffer (for embedded devices)."));
+    parser.addOption(lowMemoryOption);
+    QCommandLineOption compactFifoOption(QStringList() << "compact-fifo",
+                                         QObject::tr("Store 8 bit samples (RTL-SDR, RTL-TCP) as int16 in input buffer, input buffer memory is halved."));
+    parser.addOption(compactFifoOption);
+
     // Process the actual command line arguments given by the user
     parser.process(a);
 
+    if (parser.isSet(decodeLogOption))
+    {
+        QTextStream out(stdout);
+        return LogSink::decode(parser.value(decodeLogOption), out) ? 0 : 1;
+    }
+
     QString iniFile = parser.value(iniFileOption);
 
+    if (parser.isSet(lowMemoryOption) || parser.isSet(compactFifoOption))
+    {
+        InputFifoConfig fifoConfig = parser.isSet(lowMemoryOption) ? InputFifoConfig::lowMemory() : InputDevice::fifoConfig();
+        fifoConfig.compactSamples = parser.isSet(compactFifoOption);
+        InputDevice::setFifoConfig(fifoConfig);
+    }
+
+    RawFileInputFormat rawFileFormat = RawFileInputFormat::SAMPLE_FORMAT_U8;
+    if (parser.isSet(batchFormatOption) && !RawFileInput::formatFromName(parser.value(batchFormatOption), rawFileFormat))
+    {
+        QTextStream(stderr) << QObject::tr("Unknown raw file format: %1").arg(parser.value(batchFormatOption)) << Qt::endl;
+        return 1;
+    }
+
+    DiagnosticsServer * diagnosticsServer = nullptr;
+    if (parser.isSet(metricsPortOption))
+    {
+        diagnosticsServer = new DiagnosticsServer(&a);
+        diagnosticsServer->listen(parser.value(metricsPortOption).toUShort());
+    }
+
+    if (parser.isSet(batchOption))
+    {
+        BatchDecoder decoder(parser.isSet(batchOutputOption) ? parser.value(batchOutputOption) : QDir::currentPath());
+        decoder.setFile(parser.value(batchOption), rawFileFormat);
+        if (parser.isSet(batchServiceOption))
+        {
+            decoder.setService(parser.value(batchServiceOption).toUInt(nullptr, 16));
+        }
+        decoder.setOutputRecording(parser.isSet(batchWavOption));
+        decoder.setSubscribeAll(parser.isSet(batchAllOption));
+        if (parser.isSet(batchAudioDumpOption))
+        {
+            decoder.setAudioDataDump(parser.value(batchAudioDumpOption));
+        }
+        QObject::connect(&decoder, &BatchDecoder::finished, &a, &QCoreApplication::exit, Qt::QueuedConnection);
+        if (!decoder.start())
+        {
+            return 1;
+        }
+        return a.exec();
+    }
+
+    if (parser.isSet(zapOption))
+    {
+        auto toIntList = [](const QString & str) {
+            QList<int> list;
+            const QStringList values = str.split(',', Qt::SkipEmptyParts);
+            for (const auto & v : values)
+            {
+                list.append(v.trimmed().toInt());
+            }
+            return list;
+        };
+
+        ZapBenchmark benchmark;
+        benchmark.setFiles(parser.values(zapOption));
+        benchmark.setFileFormat(rawFileFormat);
+        if (parser.isSet(batchServiceOption))
+        {
+            benchmark.setService(parser.value(batchServiceOption).toUInt(nullptr, 16));
+        }
+        benchmark.setFastReplay(parser.isSet(zapFastOption));
+        benchmark.setInputConfigs(toIntList(parser.value(zapChunkOption)), toIntList(parser.value(zapFifoOption)));
+        QObject::connect(&benchmark, &ZapBenchmark::finished, &a, &QCoreApplication::exit, Qt::QueuedConnection);
+        if (!benchmark.start(QCoreApplication::arguments()))
+        {
+            return 1;
+        }
+        return a.exec();
+    }
+
+    if (parser.isSet(replayAudioOption))
+    {
+        AudioDecoderBenchmark benchmark;
+        return benchmark.run(parser.value(replayAudioOption));
+    }
+
+    if (parser.isSet(serviceListBenchOption))
+    {
+        QList<int> sizes;
+        const QStringList values = parser.value(serviceListBenchOption).split(',', Qt::SkipEmptyParts);
+        for (const auto & v : values)
+        {
+            bool ok = false;
+            int n = v.trimmed().toInt(&ok);
+            if (ok && (n > 0))
+            {
+                sizes.append(n);
+            }
+            else { /* invalid value is ignored */ }
+        }
+        if (sizes.isEmpty())
+        {
+            sizes = {1000, 5000, 20000};
+        }
+        ServiceListBenchmark benchmark;
+        return benchmark.run(sizes);
+    }
+
 #ifdef Q_OS_LINUX
     // Set icon
     a.setWindowIcon(QIcon(":/resources/appIcon-linux.png"));
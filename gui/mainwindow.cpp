@@ -44,6 +44,8 @@
 #include <QToolTip>
 #include <QActionGroup>
 #include <QStandardPaths>
+#include <QWindow>
+#include <QScreen>
 #include <QtGlobal>
 #include <iostream>
 
@@ -68,6 +70,12 @@
 #include "rawfileinput.h"
 #include "rtlsdrinput.h"
 #include "rtltcpinput.h"
+#include "tunerstatecache.h"
+#include "ensemblemonitor.h"
+#include "shmexport.h"
+#if HAVE_LIBUSB
+#include "usbhotplug.h"
+#endif
 #if HAVE_AIRSPY
 #include "airspyinput.h"
 #endif
@@ -81,6 +89,9 @@
 
 Q_LOGGING_CATEGORY(application, "Application", QtInfoMsg)
 
+// ini keys of ThreadClass values
+static const char * threadClassKeys[] = { "input", "dabsdr", "decoder", "output" };
+
 const QString MainWindow::appName("AbracaDABra");
 const char * MainWindow::syncLevelLabels[] = {QT_TR_NOOP("No signal"), QT_TR_NOOP("Signal found"), QT_TR_NOOP("Sync")};
 const char * MainWindow::syncLevelTooltip[] = {QT_TR_NOOP("DAB signal not detected<br>Looking for signal..."),
@@ -101,6 +112,7 @@ enum class SNR10Threhold
 };
 
 static LogModel * logModel;
+static std::atomic<LogSink *> logSink { nullptr };
 
 // this is default log handler printing the sam format to log windows and to stderr
 void logToModelHandlerDefault(QtMsgType type, const QMessageLogContext &context, const QString &msg)
@@ -125,9 +137,15 @@ void logToModelHandlerDefault(QtMsgType type, const QMessageLogContext &context,
         break;
     }
 
-    QMetaObject::invokeMethod(logModel, "appendRow", Qt::QueuedConnection,
-                              Q_ARG(QString, txt),
-                              Q_ARG(int, type));
+    if (nullptr != logModel)
+    {   // messages are inserted to model in batches
+        logModel->append(txt, type);
+    }
+    LogSink * sink = logSink.load(std::memory_order_acquire);
+    if (nullptr != sink)
+    {   // binary log file, message is stored without formatting
+        sink->push(type, context.category, msg);
+    }
 
     std::cerr << txt.toStdString() << std::endl;
 }
@@ -158,9 +176,15 @@ void logToModelHandlerCustom(QtMsgType type, const QMessageLogContext &context,
         break;
     }
 
-    QMetaObject::invokeMethod(logModel, "appendRow", Qt::QueuedConnection,
-                              Q_ARG(QString, txt),
-                              Q_ARG(int, type));
+    if (nullptr != logModel)
+    {   // messages are inserted to model in batches
+        logModel->append(txt, type);
+    }
+    LogSink * sink = logSink.load(std::memory_order_acquire);
+    if (nullptr != sink)
+    {   // binary log file, message is stored without formatting
+        sink->push(type, context.category, msg);
+    }
 }
 
 void setLogToModel(QAbstractItemModel *model)
@@ -182,9 +206,16 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     , ui(new Ui::MainWindow)
     , m_iniFilename(iniFilename)
 {
+    m_startupTimer.start();
+
     initStyle(); // init style as soon as possible
 
     m_audioRecScheduleDialog = nullptr;
+    m_epgDialog = nullptr;
+
+    // widgets are updated from first expose of the window
+    m_uiUpdates = new UiUpdateScheduler(this);
+    m_uiUpdates->setSuspended(true);
 
     m_dlDecoder[Instance::Service] = new DLDecoder();
     m_dlDecoder[Instance::Announcement] = new DLDecoder();
@@ -193,7 +224,12 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
 
     // creating log windows as soon as possible
     m_logDialog = new LogDialog(this);
+    m_diagnosticsDialog = new DiagnosticsDialog(this);
     setLogToModel(m_logDialog->getModel());
+    traceStartup("UI and log");
+
+    // last used device is opened while rest of GUI is constructed
+    preopenInputDevice();
 
     ui->serviceListView->setIconSize(QSize(16,16));
 
@@ -221,6 +257,20 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
 
     m_inputDeviceRecorder = new InputDeviceRecorder();
 
+#if HAVE_LIBUSB
+    m_usbHotplug = new UsbHotplug(this);
+    if (m_usbHotplug->isSupported())
+    {
+        connect(m_usbHotplug, &UsbHotplug::deviceArrived, this, &MainWindow::onUsbDeviceArrived, Qt::QueuedConnection);
+        connect(m_usbHotplug, &UsbHotplug::deviceLeft, this, &MainWindow::onUsbDeviceLeft, Qt::QueuedConnection);
+    }
+    else
+    {   // devices rely on watchdog
+        delete m_usbHotplug;
+        m_usbHotplug = nullptr;
+    }
+#endif
+
     m_setupDialog = new SetupDialog(this);
     m_setupDialog->setSlsDumpPaternDefault(slsDumpPatern);
     m_setupDialog->setSpiDumpPaternDefault(spiDumpPatern);
@@ -230,6 +280,7 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     connect(m_setupDialog, &SetupDialog::expertModeToggled, this, &MainWindow::onExpertModeToggled);
     connect(m_setupDialog, &SetupDialog::newAnnouncementSettings, this, &MainWindow::onNewAnnouncementSettings);
     connect(m_setupDialog, &SetupDialog::xmlHeaderToggled, m_inputDeviceRecorder, &InputDeviceRecorder::setXmlHeaderEnabled);
+    connect(m_setupDialog, &SetupDialog::rawCompressionToggled, m_inputDeviceRecorder, &InputDeviceRecorder::setCompressionEnabled);
 
     m_ensembleInfoDialog = new EnsembleInfoDialog(this);
     connect(m_ensembleInfoDialog, &EnsembleInfoDialog::recordingStart, m_inputDeviceRecorder, &InputDeviceRecorder::start);
@@ -331,9 +382,37 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     m_epgAction->setEnabled(false);
     connect(m_epgAction, &QAction::triggered, this, &MainWindow::showEPG);    
 
+    // timeshift of current service
+    m_timeshiftPauseAction = new QAction(tr("Pause"), this);
+    m_timeshiftPauseAction->setCheckable(true);
+    m_timeshiftPauseAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_P));
+    connect(m_timeshiftPauseAction, &QAction::triggered, this, &MainWindow::audioTimeshiftPause);
+
+    m_timeshiftBackAction = new QAction(tr("Skip back %1 s").arg(AUDIO_TIMESHIFT_SKIP_SEC), this);
+    m_timeshiftBackAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_Left));
+    connect(m_timeshiftBackAction, &QAction::triggered, this, [this]() { emit audioTimeshiftSkip(-AUDIO_TIMESHIFT_SKIP_SEC); });
+
+    m_timeshiftForwardAction = new QAction(tr("Skip forward %1 s").arg(AUDIO_TIMESHIFT_SKIP_SEC), this);
+    m_timeshiftForwardAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_Right));
+    connect(m_timeshiftForwardAction, &QAction::triggered, this, [this]() { emit audioTimeshiftSkip(AUDIO_TIMESHIFT_SKIP_SEC); });
+
+    m_timeshiftLiveAction = new QAction(tr("Return to live"), this);
+    m_timeshiftLiveAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_L));
+    connect(m_timeshiftLiveAction, &QAction::triggered, this, &MainWindow::audioTimeshiftLive);
+
+    // flight recorder buffer is saved manually by shortcut
+    m_flightRecorderAction = new QAction(tr("Save IQ flight recorder"), this);
+    m_flightRecorderAction->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_D));
+    m_flightRecorderAction->setEnabled(false);
+    connect(m_flightRecorderAction, &QAction::triggered, this, [this]() { m_inputDeviceRecorder->triggerFlightRecorder("manual"); });
+    addAction(m_flightRecorderAction);    // shortcut works without menu
+
     m_logAction = new QAction(tr("Application log"), this);
     connect(m_logAction, &QAction::triggered, this, &MainWindow::showLog);
 
+    m_diagnosticsAction = new QAction(tr("Diagnostics"), this);
+    connect(m_diagnosticsAction, &QAction::triggered, this, &MainWindow::showDiagnostics);
+
     m_aboutAction = new QAction(tr("About"), this);
     connect(m_aboutAction, &QAction::triggered, this, &MainWindow::showAboutDialog);
 
@@ -351,6 +430,13 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     }
     m_menu->addAction(m_audioRecordingScheduleAction);
     m_menu->addAction(m_audioRecordingAction);
+    m_timeshiftMenu = m_menu->addMenu(tr("Timeshift"));
+    m_timeshiftMenu->addAction(m_timeshiftPauseAction);
+    m_timeshiftMenu->addAction(m_timeshiftBackAction);
+    m_timeshiftMenu->addAction(m_timeshiftForwardAction);
+    m_timeshiftMenu->addAction(m_timeshiftLiveAction);
+    addActions(m_timeshiftMenu->actions());    // shortcuts work without menu
+    onTimeshiftInfo(false, 0, 0);
 
     m_menu->addSeparator();
     m_menu->addAction(m_setupAction);   
@@ -360,6 +446,7 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     m_menu->addAction(m_epgAction);
     m_menu->addAction(m_ensembleInfoAction);
     m_menu->addAction(m_logAction);
+    m_menu->addAction(m_diagnosticsAction);
     m_menu->addAction(m_aboutAction);
 
     onSignalState(uint8_t(DabSyncLevel::NoSync), 0.0);
@@ -416,6 +503,7 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
 
     // service list
     m_serviceList = new ServiceList;
+    m_ensembleMonitor = new EnsembleMonitor(m_serviceList, this);
 
     // metadata
     m_metadataManager = new MetadataManager(m_serviceList, this);
@@ -429,7 +517,11 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     connect(m_serviceList, &ServiceList::serviceAdded, m_slModel, &SLModel::addService);
     connect(m_serviceList, &ServiceList::serviceUpdated, m_slModel, &SLModel::updateService);
     connect(m_serviceList, &ServiceList::serviceRemoved, m_slModel, &SLModel::removeService);
+    connect(m_serviceList, &ServiceList::serviceAddedToEnsemble, m_slModel, &SLModel::serviceAddedToEnsemble);
+    connect(m_serviceList, &ServiceList::serviceRemovedFromEnsemble, m_slModel, &SLModel::serviceRemovedFromEnsemble);
     connect(m_serviceList, &ServiceList::empty, m_slModel, &SLModel::clear);
+    connect(m_serviceList, &ServiceList::updateStarted, m_slModel, &SLModel::beginUpdate);
+    connect(m_serviceList, &ServiceList::updateFinished, m_slModel, &SLModel::endUpdate);
 
     ui->serviceListView->setModel(m_slModel);
     ui->serviceListView->setSelectionMode(QAbstractItemView::SingleSelection);
@@ -449,30 +541,27 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     ui->serviceTreeView->installEventFilter(this);
     connect(ui->serviceTreeView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::onServiceListTreeSelection);
     connect(m_serviceList, &ServiceList::empty, m_slTreeModel, &SLTreeModel::clear);
+    connect(m_serviceList, &ServiceList::updateStarted, m_slTreeModel, &SLTreeModel::beginUpdate);
+    connect(m_serviceList, &ServiceList::updateFinished, m_slTreeModel, &SLTreeModel::endUpdate);
 
-    // EPG dialog
-    m_epgDialog = new EPGDialog(m_slModel, ui->serviceListView->selectionModel(), m_metadataManager, this);
+    // EPG dialog is created when opened for the first time, QML engine startup is expensive
     connect(m_metadataManager, &MetadataManager::epgAvailable, this, [this](){ m_epgAction->setEnabled(true); } );
     connect(m_metadataManager, &MetadataManager::epgEmpty, this, &MainWindow::onEpgEmpty);
-    connect(m_epgDialog, &EPGDialog::scheduleAudioRecording, this, [this](const AudioRecScheduleItem & item) {
-        showAudioRecordingSchedule();
-        m_audioRecScheduleDialog->addItem(item);
-    });
+    traceStartup("service list and metadata");
 
     // fill channel list
     int freqLabelMaxWidth = 0;
-    dabChannelList_t::const_iterator it = DabTables::channelList.constBegin();
-    while (it != DabTables::channelList.constEnd()) {
+    for (int n = 0; n < DabTables::numChannels(); ++n)
+    {
         // insert to combo
-        ui->channelCombo->addItem(it.value(), it.key());
+        ui->channelCombo->addItem(DabTables::channelLabel(n), DabTables::channelFrequency(n));
 
         // calculate label size
-        QString freqStr = QString("%1 MHz").arg(it.key()/1000.0, 3, 'f', 3, QChar('0'));
+        QString freqStr = QString("%1 MHz").arg(DabTables::channelFrequency(n)/1000.0, 3, 'f', 3, QChar('0'));
         if (freqLabelMaxWidth < ui->frequencyLabel->fontMetrics().boundingRect(freqStr).width())
         {
             freqLabelMaxWidth = ui->frequencyLabel->fontMetrics().boundingRect(freqStr).width();
         }
-        ++it;
     }
     connect(ui->channelCombo, &QComboBox::currentIndexChanged, this, &MainWindow::onChannelChange);
     ui->channelCombo->setCurrentIndex(-1);
@@ -529,6 +618,8 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     ui->channelCombo->setFocusPolicy(Qt::StrongFocus);
     ui->scrollArea->setFocusPolicy(Qt::ClickFocus);
 
+    traceStartup("widgets");
+
     // threads
     m_radioControl = new RadioControl();
     m_radioControlThread = new QThread(this);
@@ -550,14 +641,35 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
 
     AudioRecorder * audioRecorder = new AudioRecorder();
     m_audioDecoder = new AudioDecoder(audioRecorder);
+    m_audioTap = new AudioTap();
+    m_audioDecoder->setAudioTap(m_audioTap);
+    m_audioDecoder->setStreamSource(true);
+    m_audioDecoder->setSharedMemoryExport(true);
     m_audioDecoderThread = new QThread(this);
     m_audioDecoderThread->setObjectName("audioDecoderThr");
     m_audioDecoder->moveToThread(m_audioDecoderThread);
     audioRecorder->moveToThread(m_audioDecoderThread);
     connect(m_audioDecoderThread, &QThread::finished, m_audioDecoder, &QObject::deleteLater);
     connect(m_audioDecoderThread, &QThread::finished, audioRecorder, &QObject::deleteLater);
+
+    // announcement on other service has its own decoder, audio output crossfades between them
+    AudioRecorder * announcementRecorder = new AudioRecorder();     // never started
+    m_audioAnnouncementDecoder = new AudioDecoder(announcementRecorder);
+    m_audioAnnouncementDecoder->moveToThread(m_audioDecoderThread);
+    announcementRecorder->moveToThread(m_audioDecoderThread);
+    connect(m_audioDecoderThread, &QThread::finished, m_audioAnnouncementDecoder, &QObject::deleteLater);
+    connect(m_audioDecoderThread, &QThread::finished, announcementRecorder, &QObject::deleteLater);
     m_audioDecoderThread->start();
 
+    m_loudnessMeter = new AudioLoudnessMeter(m_audioTap, this);
+    connect(m_loudnessMeter, &AudioLoudnessMeter::loudness, this, &MainWindow::onAudioLoudness);
+    m_loudnessMeter->start();
+
+    m_signalTelemetryTimer = new QTimer(this);
+    m_signalTelemetryTimer->setInterval(SIGNAL_TELEMETRY_PULL_MS);
+    connect(m_signalTelemetryTimer, &QTimer::timeout, this, &MainWindow::onSignalTelemetryTimer);
+    m_signalTelemetryTimer->start();
+
     m_audioRecScheduleModel = new AudioRecScheduleModel(this);
     m_audioRecManager = new AudioRecManager(m_audioRecScheduleModel, m_slModel, audioRecorder, this);
 
@@ -566,9 +678,18 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     connect(m_audioRecManager, &AudioRecManager::audioRecordingProgress, this, &MainWindow::onAudioRecordingProgress);
     connect(m_audioRecManager, &AudioRecManager::audioRecordingCountdown, this, &MainWindow::onAudioRecordingCountdown, Qt::QueuedConnection);
     connect(m_audioRecManager, &AudioRecManager::requestServiceSelection, this, &MainWindow::selectService);
+    // recording needs audio decoding
+    connect(m_audioRecManager, &AudioRecManager::audioRecordingCountdown, this, &MainWindow::updateLowPowerMode, Qt::QueuedConnection);
+    connect(m_audioRecManager, &AudioRecManager::audioRecordingStarted, this, &MainWindow::updateLowPowerMode);
+    connect(m_audioRecManager, &AudioRecManager::audioRecordingStopped, this, &MainWindow::updateLowPowerMode);
     connect(m_radioControl, &RadioControl::audioServiceSelection, m_audioRecManager, &AudioRecManager::onAudioServiceSelection, Qt::QueuedConnection);
     connect(m_setupDialog, &SetupDialog::noiseConcealmentLevelChanged, m_audioDecoder, &AudioDecoder::setNoiseConcealment, Qt::QueuedConnection);
+    connect(m_setupDialog, &SetupDialog::noiseConcealmentLevelChanged, m_audioAnnouncementDecoder, &AudioDecoder::setNoiseConcealment, Qt::QueuedConnection);
     connect(this, &MainWindow::audioStop, m_audioDecoder, &AudioDecoder::stop, Qt::QueuedConnection);
+    connect(this, &MainWindow::audioTimeshiftPause, m_audioDecoder, &AudioDecoder::timeshiftPause, Qt::QueuedConnection);
+    connect(this, &MainWindow::audioTimeshiftSkip, m_audioDecoder, &AudioDecoder::timeshiftSkip, Qt::QueuedConnection);
+    connect(this, &MainWindow::audioTimeshiftLive, m_audioDecoder, &AudioDecoder::timeshiftLive, Qt::QueuedConnection);
+    connect(m_audioDecoder, &AudioDecoder::timeshiftInfo, this, &MainWindow::onTimeshiftInfo, Qt::QueuedConnection);
     connect(m_setupDialog, &SetupDialog::audioRecordingSettings, audioRecorder, &AudioRecorder::setup, Qt::QueuedConnection);
 
     onAudioRecordingStopped();
@@ -606,6 +727,7 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     }
     connect(this, &MainWindow::audioVolume, m_audioOutput, &AudioOutput::setVolume, Qt::QueuedConnection);
     connect(this, &MainWindow::audioMute, m_audioOutput, &AudioOutput::mute, Qt::QueuedConnection);
+    connect(m_setupDialog, &SetupDialog::audioLatencyChanged, m_audioOutput, &AudioOutput::setTargetLatency, Qt::QueuedConnection);
 
     // Connect signals
     connect(m_muteLabel, &ClickableLabel::toggled, m_audioOutput, &AudioOutput::mute, Qt::QueuedConnection);
@@ -618,22 +740,20 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     connect(m_radioControl, &RadioControl::ensembleReconfiguration, this, &MainWindow::onEnsembleReconfiguration, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::serviceListComplete, this, &MainWindow::onServiceListComplete, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::signalState, this, &MainWindow::onSignalState, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::serviceFollowRequest, this, &MainWindow::onServiceFollowRequest, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::dabTime, this, &MainWindow::onDabTime, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::serviceListEntry, this, &MainWindow::onServiceListEntry, Qt::BlockingQueuedConnection);
     connect(m_radioControl, &RadioControl::announcement, this, &MainWindow::onAnnouncement, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::programmeTypeChanged, this, &MainWindow::onProgrammeTypeChanged, Qt::QueuedConnection);    
     connect(this, &MainWindow::announcementMask, m_radioControl, &RadioControl::setupAnnouncements, Qt::QueuedConnection);
+    connect(this, &MainWindow::lowPowerMode, m_radioControl, &RadioControl::setLowPowerMode, Qt::QueuedConnection);
     connect(m_audioOutput, &AudioOutput::audioOutputRestart, m_radioControl, &RadioControl::onAudioOutputRestart, Qt::QueuedConnection);
     connect(this, &MainWindow::toggleAnnouncement, m_radioControl, &RadioControl::suspendResumeAnnouncement, Qt::QueuedConnection);
 
     connect(m_ensembleInfoDialog, &EnsembleInfoDialog::requestEnsembleConfiguration, m_radioControl, &RadioControl::getEnsembleConfiguration, Qt::QueuedConnection);
-    connect(m_radioControl, &RadioControl::signalState, m_ensembleInfoDialog, &EnsembleInfoDialog::updateSnr, Qt::QueuedConnection);
-    connect(m_radioControl, &RadioControl::freqOffset, m_ensembleInfoDialog, &EnsembleInfoDialog::updateFreqOffset, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::ensembleConfiguration, m_ensembleInfoDialog, &EnsembleInfoDialog::refreshEnsembleConfiguration, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::tuneDone, m_ensembleInfoDialog, &EnsembleInfoDialog::newFrequency, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::tuneDone, m_inputDeviceRecorder, &InputDeviceRecorder::setCurrentFrequency, Qt::QueuedConnection);
-    connect(m_radioControl, &RadioControl::fibCounter, m_ensembleInfoDialog, &EnsembleInfoDialog::updateFIBstatus, Qt::QueuedConnection);
-    connect(m_radioControl, &RadioControl::mscCounter, m_ensembleInfoDialog, &EnsembleInfoDialog::updateMSCstatus, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::audioServiceSelection, m_ensembleInfoDialog, &EnsembleInfoDialog::serviceChanged, Qt::QueuedConnection);
 
     connect(m_radioControl, &RadioControl::dlDataGroup_Service, m_dlDecoder[Instance::Service], &DLDecoder::newDataGroup, Qt::QueuedConnection);
@@ -662,6 +782,17 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     connect(m_dlDecoder[Instance::Announcement], &DLDecoder::dlPlusObject, this, &MainWindow::onDLPlusObjReceived_Announcement);
     connect(m_dlDecoder[Instance::Announcement], &DLDecoder::dlItemToggle, this, &MainWindow::onDLPlusItemToggle_Announcement);
     connect(m_dlDecoder[Instance::Announcement], &DLDecoder::dlItemRunning, this, &MainWindow::onDLPlusItemRunning_Announcement);
+    // shared memory export
+    for (int instance = 0; instance < Instance::NumInstances; ++instance)
+    {
+        connect(m_dlDecoder[instance], &DLDecoder::dlComplete, this, [instance](const QString & dl) {
+            SharedMemoryExport * shm = SharedMemoryExport::instance();
+            if (nullptr != shm)
+            {
+                shm->writeDynamicLabel(dl, instance);
+            }
+        });
+    }
     connect(m_dlDecoder[Instance::Announcement], &DLDecoder::resetTerminal, this, &MainWindow::onDLReset_Announcement);
 
     connect(m_audioDecoder, &AudioDecoder::audioParametersInfo, this, &MainWindow::onAudioParametersInfo, Qt::QueuedConnection);
@@ -673,12 +804,28 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     connect(m_audioDecoder, &AudioDecoder::switchAudio, m_audioOutput, &AudioOutput::restart, Qt::QueuedConnection);
     connect(m_audioDecoder, &AudioDecoder::stopAudio, m_audioOutput, &AudioOutput::stop, Qt::QueuedConnection);
 
+    // announcement decoder
+    connect(m_radioControl, &RadioControl::announcementAudioSelection, m_audioAnnouncementDecoder, &AudioDecoder::start, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::announcementAudioStop, m_audioAnnouncementDecoder, &AudioDecoder::stop, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::stopAudio, m_audioAnnouncementDecoder, &AudioDecoder::stop, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::audioData_Announcement, m_audioAnnouncementDecoder, &AudioDecoder::decodeData, Qt::QueuedConnection);
+    connect(m_audioAnnouncementDecoder, &AudioDecoder::startAudio, m_audioOutput, &AudioOutput::crossfade, Qt::QueuedConnection);
+    connect(m_audioAnnouncementDecoder, &AudioDecoder::switchAudio, m_audioOutput, &AudioOutput::crossfade, Qt::QueuedConnection);
+    connect(m_audioAnnouncementDecoder, &AudioDecoder::stopAudio, m_audioOutput, &AudioOutput::crossfadeBack, Qt::QueuedConnection);
+    m_radioControl->setAnnouncementDecoder(true);
+
     // tune procedure:
     // 1. mainwindow tune -> radiocontrol tune (this stops DAB SDR - tune to 0)
     // 2. radiocontrol tuneInputDevice -> inputdevice tune (reset of input bufer and tune FE)
     // 3. inputDevice tuned -> radiocontrol start (this starts DAB SDR)
     // 4. notification to HMI
     connect(this, &MainWindow::serviceRequest, m_radioControl, &RadioControl::tuneService, Qt::QueuedConnection);
+    connect(this, &MainWindow::serviceRequest, this, [this](uint32_t freq) {
+        if (freq != m_frequency)
+        {   // sync loss caused by tuning is not flight recorder event
+            m_inputDeviceRecorder->suspendSignalEvents();
+        }
+    });
 
     // these two signals have to be connected in initInputDevice() - left here as comment
     // connect(radioControl, &RadioControl::tuneInputDevice, inputDevice, &InputDevice::tune, Qt::QueuedConnection);
@@ -692,12 +839,17 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     // slide show application is created by default
     // ETSI TS 101 499 V3.1.1  [5.1.1]
     // The application should be automatically started when a SlideShow service is discovered for the current radio service    
+    // user applications have own thread so that MOT reassembly, slide and SPI processing never delay DAB event handling
+    // data groups are handed over by queued connections from radio control thread
+    m_userAppThread = new QThread(this);
+    m_userAppThread->setObjectName("userAppThr");
+
     m_slideShowApp[Instance::Service] = new SlideShowApp();
     m_slideShowApp[Instance::Announcement] = new SlideShowApp();
 
-    m_slideShowApp[Instance::Service]->moveToThread(m_radioControlThread);
-    m_slideShowApp[Instance::Announcement]->moveToThread(m_radioControlThread);
-    connect(m_radioControlThread, &QThread::finished, m_slideShowApp[Instance::Service], &QObject::deleteLater);
+    m_slideShowApp[Instance::Service]->moveToThread(m_userAppThread);
+    m_slideShowApp[Instance::Announcement]->moveToThread(m_userAppThread);
+    connect(m_userAppThread, &QThread::finished, m_slideShowApp[Instance::Service], &QObject::deleteLater);
     connect(m_radioControl, &RadioControl::audioServiceSelection, m_slideShowApp[Instance::Service], &SlideShowApp::start);
     connect(m_radioControl, &RadioControl::userAppData_Service, m_slideShowApp[Instance::Service], &SlideShowApp::onUserAppData);
     connect(m_radioControl, &RadioControl::ensembleInformation, m_slideShowApp[Instance::Service], &UserApplication::setEnsId);
@@ -705,18 +857,30 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
 
     //connect(this, &MainWindow::serviceRequest, m_metadataManager, &MetadataManager::onServiceRequest);
 
-    connect(m_slideShowApp[Instance::Service], &SlideShowApp::currentSlide, ui->slsView_Service, &SLSView::showSlide, Qt::QueuedConnection);
-    connect(m_slideShowApp[Instance::Service], &SlideShowApp::resetTerminal, ui->slsView_Service, &SLSView::reset, Qt::QueuedConnection);
+    // only latest slide is shown, reset drops pending service logo
+    connect(m_slideShowApp[Instance::Service], &SlideShowApp::currentSlide, this, [this](const Slide & slide) {
+        m_uiUpdates->post(UiUpdateScheduler::Update::ServiceSlide, [this, slide]() { ui->slsView_Service->showSlide(slide); });
+    }, Qt::QueuedConnection);
+    connect(m_slideShowApp[Instance::Service], &SlideShowApp::resetTerminal, this, [this]() {
+        m_uiUpdates->cancel(UiUpdateScheduler::Update::ServiceLogo);
+        m_uiUpdates->post(UiUpdateScheduler::Update::ServiceSlide, [this]() { ui->slsView_Service->reset(); });
+    }, Qt::QueuedConnection);
     connect(m_slideShowApp[Instance::Service], &SlideShowApp::catSlsAvailable, ui->catSlsLabel, &ClickableLabel::setVisible, Qt::QueuedConnection);
     connect(this, &MainWindow::stopUserApps, m_slideShowApp[Instance::Service], &SlideShowApp::stop, Qt::QueuedConnection);
 
-    connect(m_radioControlThread, &QThread::finished, m_slideShowApp[Instance::Announcement], &QObject::deleteLater);
+    connect(m_userAppThread, &QThread::finished, m_slideShowApp[Instance::Announcement], &QObject::deleteLater);
     connect(m_radioControl, &RadioControl::audioServiceSelection, m_slideShowApp[Instance::Announcement], &SlideShowApp::start);
     connect(m_radioControl, &RadioControl::userAppData_Announcement, m_slideShowApp[Instance::Announcement], &SlideShowApp::onUserAppData);
-    connect(m_slideShowApp[Instance::Announcement], &SlideShowApp::currentSlide, ui->slsView_Announcement, &SLSView::showSlide, Qt::QueuedConnection);
-    connect(m_slideShowApp[Instance::Announcement], &SlideShowApp::resetTerminal, ui->slsView_Announcement, &SLSView::reset, Qt::QueuedConnection);
+    connect(m_slideShowApp[Instance::Announcement], &SlideShowApp::currentSlide, this, [this](const Slide & slide) {
+        m_uiUpdates->post(UiUpdateScheduler::Update::AnnouncementSlide, [this, slide]() { ui->slsView_Announcement->showSlide(slide); });
+    }, Qt::QueuedConnection);
+    connect(m_slideShowApp[Instance::Announcement], &SlideShowApp::resetTerminal, this, [this]() {
+        m_uiUpdates->post(UiUpdateScheduler::Update::AnnouncementSlide, [this]() { ui->slsView_Announcement->reset(); });
+    }, Qt::QueuedConnection);
     //connect(m_radioControl, &RadioControl::announcement, ui->slsView_Service, &SLSView::showAnnouncement, Qt::QueuedConnection);
-    connect(m_radioControl, &RadioControl::announcement, ui->slsView_Announcement, &SLSView::showAnnouncement, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::announcement, this, [this](DabAnnouncement id) {
+        m_uiUpdates->post(UiUpdateScheduler::Update::AnnouncementSlide, [this, id]() { ui->slsView_Announcement->showAnnouncement(id); });
+    }, Qt::QueuedConnection);
     connect(this, &MainWindow::stopUserApps, m_slideShowApp[Instance::Announcement], &SlideShowApp::stop, Qt::QueuedConnection);
 
     connect(m_setupDialog, &SetupDialog::uaDumpSettings, m_slideShowApp[Instance::Service], &SlideShowApp::setDataDumping, Qt::QueuedConnection);
@@ -730,8 +894,8 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     connect(m_catSlsDialog, &CatSLSDialog::getNextCatSlide, m_slideShowApp[Instance::Service], &SlideShowApp::getNextCatSlide, Qt::QueuedConnection);
 
     m_spiApp = new SPIApp();
-    m_spiApp->moveToThread(m_radioControlThread);
-    connect(m_radioControlThread, &QThread::finished, m_spiApp, &QObject::deleteLater);
+    m_spiApp->moveToThread(m_userAppThread);
+    connect(m_userAppThread, &QThread::finished, m_spiApp, &QObject::deleteLater);
     connect(m_radioControl, &RadioControl::userAppData_Service, m_spiApp, &SPIApp::onUserAppData);
     connect(m_radioControl, &RadioControl::audioServiceSelection,  m_spiApp, &SPIApp::start);
     connect(this, &MainWindow::stopUserApps, m_spiApp, &SPIApp::stop, Qt::QueuedConnection);
@@ -739,6 +903,7 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     connect(m_setupDialog, &SetupDialog::uaDumpSettings,m_spiApp, &SPIApp::setDataDumping, Qt::QueuedConnection);
 
     connect(m_spiApp, &SPIApp::xmlDocument, m_metadataManager, &MetadataManager::processXML, Qt::QueuedConnection);
+    connect(m_spiApp, &SPIApp::epgSchedule, m_metadataManager, &MetadataManager::processEpgSchedule, Qt::QueuedConnection);
     connect(m_metadataManager, &MetadataManager::getSI, m_spiApp, &SPIApp::getSI, Qt::QueuedConnection);
     connect(m_metadataManager, &MetadataManager::getPI, m_spiApp, &SPIApp::getPI, Qt::QueuedConnection);
     connect(m_metadataManager, &MetadataManager::getFile, m_spiApp, &SPIApp::onFileRequest, Qt::QueuedConnection);
@@ -749,14 +914,26 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     connect(m_setupDialog, &SetupDialog::spiApplicationSettingsChanged, m_spiApp, &SPIApp::onSettingsChanged, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::ensembleInformation, m_metadataManager, &MetadataManager::onEnsembleInformation, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::audioServiceSelection, m_metadataManager, &MetadataManager::onAudioServiceSelection, Qt::QueuedConnection);
-    connect(m_radioControl, &RadioControl::ensembleInformation, m_epgDialog, &EPGDialog::onEnsembleInformation, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::ensembleInformation, this, [this](const RadioControlEnsemble & ens) {
+        m_epgEnsemble = ens;
+        if (nullptr != m_epgDialog)
+        {
+            m_epgDialog->onEnsembleInformation(ens);
+        }
+    }, Qt::QueuedConnection);
     connect(m_radioControl, &RadioControl::ensembleInformation, m_spiApp, &UserApplication::setEnsId);
     connect(m_radioControl, &RadioControl::audioServiceSelection, m_spiApp, &UserApplication::setAudioServiceId);
 
+    // user applications yield to DAB processing and audio decoding
+    m_userAppThread->start(QThread::LowPriority);
+
+    traceStartup("radio control and user applications");
+
     // input device connections
     initInputDevice(InputDeviceId::UNDEFINED);
 
     loadSettings();
+    traceStartup("settings");
 
     // setting focus to something harmless that does not do eny visual effects
     m_menuLabel->setFocus();
@@ -773,20 +950,36 @@ MainWindow::MainWindow(const QString &iniFilename, QWidget *parent)
     //     m_metadataManager->processXML(qPrintable(in.readAll()), "dab:de0.d06c.d220.0");
     //     xmlfile.close();
     // }
+
+    traceStartup("constructor");
+    QTimer::singleShot(0, this, [this]() { traceStartup("event loop"); });
 }
 
 MainWindow::~MainWindow()
 {
+    if (nullptr != m_preopenedDevice)
+    {   // wait for openDevice() to finish
+        m_preopenResult.wait();
+        delete m_preopenedDevice;
+    }
     delete m_inputDevice;
+    delete m_ensembleMonitor;
+    TunerStateCache::getInstance()->save();
     delete m_inputDeviceRecorder;
 
     m_radioControlThread->quit();  // this deletes radioControl
     m_radioControlThread->wait();
     delete m_radioControlThread;
 
+    m_userAppThread->quit();  // this deletes user applications
+    m_userAppThread->wait();
+    delete m_userAppThread;
+
     m_audioDecoderThread->quit();  // this deletes audiodecoder
     m_audioDecoderThread->wait();
     delete m_audioDecoderThread;
+    m_loudnessMeter->stop();
+    delete m_audioTap;
 
     if (nullptr != m_audioOutputThread)
     {  // Qt audio
@@ -801,13 +994,28 @@ MainWindow::~MainWindow()
 
     delete m_dlDecoder[Instance::Service];
     delete m_dlDecoder[Instance::Announcement];
+    delete m_dataGroupRecorder;
     delete m_serviceList;
     delete m_metadataManager;
     delete ui;
+
+    // all producers are finished now
+    SharedMemoryExport::stop();
+
+    if (nullptr != logSink.load())
+    {   // remaining records are written
+        logSink.store(nullptr);
+        LogSink::getInstance()->finish();
+    }
 }
 
 bool MainWindow::eventFilter(QObject *o, QEvent *e)
 {
+    if ((o == windowHandle()) && (QEvent::Expose == e->type()))
+    {
+        updateUiSuspension();
+        return QObject::eventFilter(o, e);
+    }
     if (o == ui->serviceListView)
     {
         if(e->type() == QEvent::KeyPress)
@@ -833,6 +1041,24 @@ bool MainWindow::eventFilter(QObject *o, QEvent *e)
                 QToolTip::showText(label->mapToGlobal(event->pos()), tr("<i>DL text copied to clipboard</i>"));
                 return true;
             }
+            else if ((Qt::RightButton == event->button()) && (o == ui->dynamicLabel_Service))
+            {   // DL history of current service
+                ServiceListId id(m_SId.value(), m_SCIdS);
+                QMenu menu(this);
+                QAction * saveAction = menu.addAction(tr("Save DL history..."));
+                saveAction->setEnabled(!m_dlHistory.items(id).isEmpty());
+                if (saveAction == menu.exec(event->globalPosition().toPoint()))
+                {
+                    QString fileName = QFileDialog::getSaveFileName(this, tr("Save DL history"),
+                                                                    QDir::homePath() + "/" + QString("DL_%1.csv").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hhmmss")),
+                                                                    tr("CSV files (*.csv)"));
+                    if (!fileName.isEmpty() && !m_dlHistory.save(id, fileName))
+                    {
+                        qCWarning(application) << "Failed to save DL history to" << fileName;
+                    }
+                }
+                return true;
+            }
         }
         return QObject::eventFilter(o, e);
     }
@@ -907,6 +1133,58 @@ void MainWindow::resizeEvent(QResizeEvent *event)
     QMainWindow::resizeEvent(event);
 }
 
+void MainWindow::prepareReconnect()
+{
+    if ((nullptr != m_usbHotplug)
+        && ((InputDeviceId::RTLSDR == m_inputDeviceId) || (InputDeviceId::AIRSPY == m_inputDeviceId) || (InputDeviceId::SOAPYSDR == m_inputDeviceId)))
+    {   // USB device is reopened automatically when it is connected again
+        m_reconnect.id = m_inputDeviceId;
+        m_reconnect.serial = m_inputDevice->deviceDescription().device.serial;
+        m_reconnect.SId = m_SId.value();
+        m_reconnect.SCIdS = m_SCIdS;
+        m_infoLabel->setToolTip(tr("Device will be reconnected automatically when it is plugged in again"));
+    }
+}
+
+void MainWindow::onUsbDeviceArrived()
+{
+    if (InputDeviceId::UNDEFINED != m_reconnect.id)
+    {
+        QTimer::singleShot(MAINWINDOW_USB_RECONNECT_DELAY_MS, this, &MainWindow::reconnectInputDevice);
+    }
+}
+
+void MainWindow::onUsbDeviceLeft()
+{
+    if (nullptr != m_inputDevice)
+    {   // error is reported by device if it was the one
+        m_inputDevice->checkConnection();
+    }
+}
+
+void MainWindow::reconnectInputDevice()
+{
+    if ((InputDeviceId::UNDEFINED == m_reconnect.id) || (InputDeviceId::UNDEFINED != m_inputDeviceId) || m_deviceChangeRequested)
+    {   // nothing to reconnect or some device is active
+        return;
+    }
+
+    // device init clears reconnect request when successful
+    const InputDeviceId id = m_reconnect.id;
+    const ServiceListId serviceId(m_reconnect.SId, m_reconnect.SCIdS);
+    qCInfo(application) << "USB device connected, trying to reopen input device";
+    if (!m_setupDialog->reconnectInputDevice(id))
+    {   // user selected another device meanwhile
+        m_reconnect.id = InputDeviceId::UNDEFINED;
+        return;
+    }
+    if (id == m_inputDeviceId)
+    {   // device is back => restore service
+        selectService(serviceId);
+    }
+    else { /* another USB device was connected, waiting for next one */ }
+}
+
 void MainWindow::onInputDeviceReady()
 {
     ui->channelCombo->setEnabled(true);
@@ -963,6 +1241,11 @@ void MainWindow::onEnsembleRemoved(const RadioControlEnsemble &ens)
 }
 
 void MainWindow::onSignalState(uint8_t sync, float snr)
+{
+    m_uiUpdates->post(UiUpdateScheduler::Update::SignalState, [this, sync, snr]() { updateSignalState(sync, snr); });
+}
+
+void MainWindow::updateSignalState(uint8_t sync, float snr)
 {
     if (DabSyncLevel::FullSync > DabSyncLevel(sync))
     {   // hide time when no sync
@@ -1036,6 +1319,35 @@ void MainWindow::onSignalState(uint8_t sync, float snr)
     }
 }
 
+void MainWindow::onSignalTelemetryTimer()
+{
+    SignalTelemetry * telemetry = SignalTelemetry::getInstance();
+    SignalTelemetryRecord record;
+    if (telemetry->pull(record) > 0)
+    {   // FIB and MSC counters are summed over all pulled records
+        onSignalState(record.sync, record.snr);
+        m_ensembleInfoDialog->updateSnr(record.sync, record.snr);
+        m_ensembleInfoDialog->updateFreqOffset(record.freqOffset);
+        if (DabSyncLevel::FullSync == DabSyncLevel(record.sync))
+        {   // remembered for next tune to this frequency
+            TunerStateCache::getInstance()->updateFreqOffset(record.freqOffset);
+
+            // SNR ranks alternatives for service following
+            m_serviceList->storeEnsembleSnr(m_frequency, record.snr);
+            if (record.snr >= m_serviceFollowSnrThr)
+            {   // all alternatives can be tried again when signal gets bad
+                m_serviceFollowTried.clear();
+            }
+        }
+        m_ensembleInfoDialog->updateFIBstatus(record.fibExpected, record.fibErrors);
+        m_ensembleInfoDialog->updateMSCstatus(record.mscCorrect, record.mscErrors);
+        m_inputDeviceRecorder->checkSignalEvents(DabSyncLevel::FullSync == DabSyncLevel(record.sync), record.fibErrors, record.mscErrors);
+    }
+
+    // AGC gain is available also without sync
+    m_ensembleInfoDialog->updateAgcGain(telemetry->agcGain());
+}
+
 void MainWindow::onServiceListEntry(const RadioControlEnsemble &ens, const RadioControlServiceComponent &slEntry)
 {
     if (slEntry.TMId != DabTMId::StreamAudio)
@@ -1050,12 +1362,13 @@ void MainWindow::onServiceListEntry(const RadioControlEnsemble &ens, const Radio
 
 void MainWindow::onDLComplete_Service(const QString & dl)
 {
-    onDLComplete(dl, ui->dynamicLabel_Service);
+    m_uiUpdates->post(UiUpdateScheduler::Update::ServiceDL, [this, dl]() { onDLComplete(dl, ui->dynamicLabel_Service); });
+    m_dlHistory.addMessage(ServiceListId(m_SId.value(), m_SCIdS), dl);
 }
 
 void MainWindow::onDLComplete_Announcement(const QString & dl)
 {
-    onDLComplete(dl, ui->dynamicLabel_Announcement);
+    m_uiUpdates->post(UiUpdateScheduler::Update::AnnouncementDL, [this, dl]() { onDLComplete(dl, ui->dynamicLabel_Announcement); });
 }
 
 void MainWindow::onDLComplete(const QString & dl, QLabel * dlLabel)
@@ -1084,7 +1397,10 @@ void MainWindow::onDLComplete(const QString & dl, QLabel * dlLabel)
 
 void MainWindow::onDabTime(const QDateTime & d)
 {
-    m_timeLabel->setText(m_timeLocale.toString(d, QString("dddd, dd.MM.yyyy, hh:mm")));
+    m_uiUpdates->post(UiUpdateScheduler::Update::DabTime, [this, d]() {
+        m_timeLabel->setText(m_timeLocale.toString(d, QString("dddd, dd.MM.yyyy, hh:mm")));
+    });
+    CoarseClock::getInstance()->onDabTime(d);
     EPGTime::getInstance()->onDabTime(d);
 }
 
@@ -1265,7 +1581,7 @@ void MainWindow::onChannelChange(int index)
     {
         prevIdx = prevIdx % ui->channelCombo->count();
     }
-    ui->channelDown->setTooltip(QString(tr("Tune to %1")).arg(DabTables::channelList[ui->channelCombo->itemData(prevIdx).toUInt()]));
+    ui->channelDown->setTooltip(QString(tr("Tune to %1")).arg(DabTables::channelName(ui->channelCombo->itemData(prevIdx).toUInt())));
 }
 
 void MainWindow::onBandScanStart()
@@ -1302,6 +1618,7 @@ void MainWindow::onChannelDownClicked()
 void MainWindow::onTuneDone(uint32_t freq)
 {   // this slot is called when tune is complete
     m_frequency = freq;
+    m_ensembleMonitor->setPrimaryFrequency(freq);
     if (freq != 0)
     {
         ui->channelCombo->setEnabled(true);
@@ -1380,6 +1697,8 @@ void MainWindow::onInputDeviceError(const InputDeviceErrorCode errCode)
         m_infoLabel->setToolTip(tr("Go to settings and try to reconnect the device"));
         m_timeBasicQualInfoWidget->setCurrentWidget(m_infoLabel);
 
+        prepareReconnect();
+
         // force no device
         m_setupDialog->resetInputDevice();
         changeInputDevice(InputDeviceId::UNDEFINED);
@@ -1388,6 +1707,7 @@ void MainWindow::onInputDeviceError(const InputDeviceErrorCode errCode)
         m_infoLabel->setText(tr("Input device error: No data"));
         m_infoLabel->setToolTip(tr("Go to settings and try to reconnect the device"));
         m_timeBasicQualInfoWidget->setCurrentWidget(m_infoLabel);
+        prepareReconnect();
 
         // force no device
         m_setupDialog->resetInputDevice();
@@ -1612,7 +1932,7 @@ void MainWindow::onAudioServiceSelection(const RadioControlServiceComponent &s)
             }
         }
         ui->serviceLabel->setText(s.label);
-        ui->serviceLabel->setToolTip(QString(tr("<b>Service:</b> %1<br>"
+        m_serviceToolTip = QString(tr("<b>Service:</b> %1<br>"
                                              "<b>Short label:</b> %2<br>"
                                              "<b>SId:</b> 0x%3<br>"
                                              "<b>SCIdS:</b> %4<br>"
@@ -1623,7 +1943,8 @@ void MainWindow::onAudioServiceSelection(const RadioControlServiceComponent &s)
                                      .arg(QString("%1").arg(s.SId.countryServiceRef(), 4, 16, QChar('0')).toUpper() )
                                      .arg(s.SCIdS)
                                      .arg(DabTables::getLangName(s.lang))
-                                     .arg(DabTables::getCountryName(s.SId.value())));
+                                     .arg(DabTables::getCountryName(s.SId.value()));
+        ui->serviceLabel->setToolTip(m_serviceToolTip + m_metadataManager->nowNextText(id));
 
 
         onProgrammeTypeChanged(s.SId, s.pty);
@@ -1637,7 +1958,8 @@ void MainWindow::onAudioServiceSelection(const RadioControlServiceComponent &s)
             ui->logoLabel->setVisible(true);
         }
 
-        ui->slsView_Service->showServiceLogo(m_metadataManager->data(s.SId.value(), s.SCIdS, MetadataManager::SLSLogo).value<QPixmap>());
+        QPixmap slsLogo = m_metadataManager->data(s.SId.value(), s.SCIdS, MetadataManager::SLSLogo).value<QPixmap>();
+        m_uiUpdates->post(UiUpdateScheduler::Update::ServiceLogo, [this, slsLogo]() { ui->slsView_Service->showServiceLogo(slsLogo); });
     }
     else
     {   // sid it not equal to selected sid -> this should not happen
@@ -1732,7 +2054,9 @@ void MainWindow::onAnnouncement(const DabAnnouncement id, const RadioControlAnno
     {
     case RadioControlAnnouncementState::None:
         ui->dlWidget->setCurrentIndex(Instance::Service);
+        m_uiUpdates->cancel(UiUpdateScheduler::Update::AnnouncementDL);
         ui->dynamicLabel_Announcement->clear();   // clear for next announcment
+        m_dlDecoder[Instance::Announcement]->resetRepeatFilter();
         ui->dlPlusWidget->setCurrentIndex(Instance::Service);
         // reset DL+
         for (auto objPtr : m_dlObjCache[Instance::Announcement])
@@ -1794,7 +2118,9 @@ void MainWindow::onAnnouncement(const DabAnnouncement id, const RadioControlAnno
         ui->announcementLabel->setVisible(true);
 
         ui->dlWidget->setCurrentIndex(Instance::Service);
+        m_uiUpdates->cancel(UiUpdateScheduler::Update::AnnouncementDL);
         ui->dynamicLabel_Announcement->clear();   // clear for next announcment
+        m_dlDecoder[Instance::Announcement]->resetRepeatFilter();
         ui->dlPlusWidget->setCurrentIndex(Instance::Service);
         // reset DL+
         for (auto objPtr : m_dlObjCache[Instance::Announcement])
@@ -1890,27 +2216,58 @@ void MainWindow::onAudioRecordingStarted()
 
 void MainWindow::onAudioRecordingStopped()
 {       
+    m_uiUpdates->cancel(UiUpdateScheduler::Update::AudioRecordingProgress);
     setAudioRecordingUI();
     emit announcementMask(m_setupDialog->settings().announcementEna);   // restore announcement settings
 }
 
 void MainWindow::onAudioRecordingProgress(size_t bytes, qint64 timeSec)
 {
-    if (timeSec >= 0)
+    m_uiUpdates->post(UiUpdateScheduler::Update::AudioRecordingProgress, [this, bytes, timeSec]() {
+        if (timeSec >= 0)
+        {
+            int min = timeSec / 60;
+            m_audioRecordingProgressLabel->setText(QString(tr("Audio recording: %1:%2")).arg(min).arg(timeSec - min * 60, 2, 10, QChar('0')));
+            m_audioRecordingProgressLabel->setToolTip(QString(tr("Audio recording ongoing (%2 kBytes recorded)\n"
+                                                                 "File: %1")).arg(m_audioRecManager->audioRecordingFile()).arg(bytes >> 10));
+        }
+        else
+        {   // schedued recording will start
+            m_audioRecordingWidget->setVisible(true);
+            m_audioRecordingProgressLabel->setText(QString(tr("Audio recording: 0:00")));
+            m_audioRecordingProgressLabel->setToolTip(QString(tr("Scheduled audio recording is getting ready")));
+        }
+    });
+}
+
+void MainWindow::onTimeshiftInfo(bool isPaused, int delaySec, int bufferedSec)
+{
+    m_timeshiftMenu->setEnabled(m_timeshiftMin > 0);
+    m_timeshiftPauseAction->setChecked(isPaused);
+    m_timeshiftPauseAction->setEnabled(m_timeshiftMin > 0);
+    m_timeshiftBackAction->setEnabled(bufferedSec > delaySec);
+    m_timeshiftForwardAction->setEnabled(delaySec > 0);
+    m_timeshiftLiveAction->setEnabled(isPaused || (delaySec > 0));
+    if (delaySec > 0)
     {
-        int min = timeSec / 60;
-        m_audioRecordingProgressLabel->setText(QString(tr("Audio recording: %1:%2")).arg(min).arg(timeSec - min * 60, 2, 10, QChar('0')));
-        m_audioRecordingProgressLabel->setToolTip(QString(tr("Audio recording ongoing (%2 kBytes recorded)\n"
-                                                             "File: %1")).arg(m_audioRecManager->audioRecordingFile()).arg(bytes >> 10));
+        m_timeshiftLiveAction->setText(tr("Return to live (-%1:%2)").arg(delaySec / 60).arg(delaySec % 60, 2, 10, QChar('0')));
     }
     else
-    {   // schedued recording will start
-        m_audioRecordingWidget->setVisible(true);
-        m_audioRecordingProgressLabel->setText(QString(tr("Audio recording: 0:00")));
-        m_audioRecordingProgressLabel->setToolTip(QString(tr("Scheduled audio recording is getting ready")));
+    {
+        m_timeshiftLiveAction->setText(tr("Return to live"));
     }
 }
 
+void MainWindow::onAudioLoudness(float momentary, float shortTerm, float integrated)
+{
+    Q_UNUSED(momentary);
+    m_uiUpdates->post(UiUpdateScheduler::Update::AudioLoudness, [this, shortTerm, integrated]() {
+        auto toString = [](float value) { return (value > AUDIO_LOUDNESS_INVALID) ? QString::number(value, 'f', 1) : QString("--"); };
+        m_audioVolumeSlider->setToolTip(QString(tr("<b>Audio volume</b><br>Loudness: %1 LUFS (short-term)<br>Integrated: %2 LUFS"))
+                                            .arg(toString(shortTerm), toString(integrated)));
+    });
+}
+
 void MainWindow::onAudioRecordingCountdown(int numSec)
 {
     m_audioRecordingAction->setDisabled(true);
@@ -1995,7 +2352,10 @@ void MainWindow::onMetadataUpdated(const ServiceListId & id, MetadataManager::Me
         switch (role)
         {
         case MetadataManager::MetadataRole::SLSLogo:
-            ui->slsView_Service->showServiceLogo(m_metadataManager->data(id, MetadataManager::SLSLogo).value<QPixmap>());
+        {
+            QPixmap slsLogo = m_metadataManager->data(id, MetadataManager::SLSLogo).value<QPixmap>();
+            m_uiUpdates->post(UiUpdateScheduler::Update::ServiceLogo, [this, slsLogo]() { ui->slsView_Service->showServiceLogo(slsLogo); });
+        }
             break;
         case MetadataManager::SmallLogo:
         {
@@ -2007,6 +2367,9 @@ void MainWindow::onMetadataUpdated(const ServiceListId & id, MetadataManager::Me
             }
         }
             break;
+        case MetadataManager::NowNext:
+            ui->serviceLabel->setToolTip(m_serviceToolTip + m_metadataManager->nowNextText(id));
+            break;
         default:
             break;
         }
@@ -2015,12 +2378,16 @@ void MainWindow::onMetadataUpdated(const ServiceListId & id, MetadataManager::Me
 
 void MainWindow::onEpgEmpty()
 {
-    m_epgDialog->close();
+    if (nullptr != m_epgDialog)
+    {
+        m_epgDialog->close();
+    }
     m_epgAction->setEnabled(false);
 }
 
 void MainWindow::clearEnsembleInformationLabels()
 {
+    m_uiUpdates->cancel(UiUpdateScheduler::Update::DabTime);
     m_timeLabel->setText("");
     ui->ensembleLabel->setText(tr("No ensemble"));
     ui->ensembleLabel->setToolTip(tr("No ensemble tuned"));
@@ -2035,6 +2402,7 @@ void MainWindow::clearServiceInformationLabels()
     ui->catSlsLabel->setHidden(true);
     ui->logoLabel->setHidden(true);
     ui->announcementLabel->setHidden(true);
+    m_serviceToolTip.clear();
     ui->serviceLabel->setToolTip(tr("No service playing"));
     ui->programTypeLabel->setText("");
     ui->audioEncodingLabel->setText("");
@@ -2072,6 +2440,7 @@ void MainWindow::onNewInputDeviceSettings()
         dynamic_cast<RtlSdrInput*>(m_inputDevice)->setBiasT(s.rtlsdr.biasT);
         dynamic_cast<RtlSdrInput*>(m_inputDevice)->setAgcLevelMax(s.rtlsdr.agcLevelMax);
         dynamic_cast<RtlSdrInput*>(m_inputDevice)->setPPM(s.rtlsdr.ppm);
+        dynamic_cast<RtlSdrInput*>(m_inputDevice)->setAsyncBuffers(s.rtlsdr.asyncBufNum, s.rtlsdr.asyncBufLen);
         break;
     case InputDeviceId::RTLTCP:
         dynamic_cast<RtlTcpInput*>(m_inputDevice)->setGainMode(s.rtltcp.gainMode, s.rtltcp.gainIdx);
@@ -2115,6 +2484,34 @@ void MainWindow::changeInputDevice(const InputDeviceId & d)
     }
 }
 
+void MainWindow::preopenInputDevice()
+{
+    QSettings * settings;
+    if (m_iniFilename.isEmpty())
+    {
+        settings = new QSettings(QSettings::IniFormat, QSettings::UserScope, appName, appName);
+    }
+    else
+    {
+        settings = new QSettings(m_iniFilename, QSettings::IniFormat);
+    }
+    InputDeviceId id = static_cast<InputDeviceId>(settings->value("inputDeviceId", int(InputDeviceId::RTLSDR)).toInt());
+    delete settings;
+
+    if (InputDeviceId::RTLSDR != id)
+    {   // only RTL-SDR is opened in background, it does not need any settings for openDevice()
+        // other devices are opened by initInputDevice() from loadSettings()
+        return;
+    }
+    else { /* RTL-SDR */ }
+
+    // device is created in GUI thread (it lives there), only openDevice() runs in parallel
+    // signals are connected later in initInputDevice()
+    InputDevice * device = new RtlSdrInput();
+    m_preopenedDevice = device;
+    m_preopenResult = std::async(std::launch::async, [device]() { return device->openDevice(); });
+}
+
 void MainWindow::initInputDevice(const InputDeviceId & d)
 {
     m_deviceChangeRequested = false;
@@ -2123,6 +2520,25 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
         delete m_inputDevice;
     }
 
+    // device opened in background during startup is used only if the same device is requested
+    InputDevice * preopenedDevice = nullptr;
+    bool preopenedIsOpen = false;
+    if ((nullptr != m_preopenedDevice) && (InputDeviceId::UNDEFINED != d))
+    {
+        preopenedIsOpen = m_preopenResult.get();   // waits for openDevice() to finish
+        if ((InputDeviceId::RTLSDR == d) && (InputDeviceId::RTLSDR != m_reconnect.id))
+        {
+            preopenedDevice = m_preopenedDevice;
+        }
+        else
+        {   // other device requested
+            delete m_preopenedDevice;
+        }
+        m_preopenedDevice = nullptr;
+        traceStartup("input device open");
+    }
+    else { /* no preopened device */ }
+
     // disable band scan - will be enable when it makes sense (RTL-SDR at the moment)
     m_bandScanAction->setDisabled(true);
 
@@ -2168,7 +2584,18 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
         break;
     case InputDeviceId::RTLSDR:
     {
-        m_inputDevice = new RtlSdrInput();
+        if (nullptr != preopenedDevice)
+        {   // openDevice() already finished
+            m_inputDevice = preopenedDevice;
+        }
+        else
+        {
+            m_inputDevice = new RtlSdrInput();
+            if (InputDeviceId::RTLSDR == m_reconnect.id)
+            {   // reopening the same device
+                dynamic_cast<RtlSdrInput*>(m_inputDevice)->setSerial(m_reconnect.serial);
+            }
+        }
 
         // signals have to be connected before calling openDevice
 
@@ -2180,7 +2607,22 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
         connect(m_inputDevice, &InputDevice::deviceReady, this, &MainWindow::onInputDeviceReady, Qt::QueuedConnection);
         connect(m_inputDevice, &InputDevice::error, this, &MainWindow::onInputDeviceError, Qt::QueuedConnection);
 
-        if (m_inputDevice->openDevice())
+        bool isOpen;
+        if (nullptr != preopenedDevice)
+        {
+            isOpen = preopenedIsOpen;
+            if (isOpen)
+            {   // deviceReady was emitted before it was connected
+                QMetaObject::invokeMethod(this, &MainWindow::onInputDeviceReady, Qt::QueuedConnection);
+            }
+            else { /* device not available */ }
+        }
+        else
+        {
+            isOpen = m_inputDevice->openDevice();
+        }
+
+        if (isOpen)
         {   // rtl sdr is available
             if ((InputDeviceId::RAWFILE == m_inputDeviceId) || (InputDeviceId::UNDEFINED == m_inputDeviceId))
             {   // if switching from RAW or UNDEFINED load service list & rec schedule
@@ -2220,12 +2662,12 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
             ui->favoriteLabel->setEnabled(true);
 
             // recorder
-            m_inputDeviceRecorder->setDeviceDescription(m_inputDevice->deviceDescription());
-            connect(m_inputDeviceRecorder, &InputDeviceRecorder::recording, m_inputDevice, &InputDevice::startStopRecording);
+            connect(m_inputDeviceRecorder, &InputDeviceRecorder::deviceRecording, m_inputDevice, &InputDevice::startStopRecording);
             connect(m_inputDevice, &InputDevice::recordBuffer, m_inputDeviceRecorder, &InputDeviceRecorder::writeBuffer, Qt::DirectConnection);
+            m_inputDeviceRecorder->setDeviceDescription(m_inputDevice->deviceDescription());
 
             // ensemble info dialog
-            connect(m_inputDevice, &InputDevice::agcGain, m_ensembleInfoDialog, &EnsembleInfoDialog::updateAgcGain);
+            connect(m_inputDevice, &InputDevice::agcGain, this, [](float gain) { SignalTelemetry::getInstance()->setAgcGain(gain); }, Qt::DirectConnection);
             m_ensembleInfoDialog->enableRecording(true);
 
             // metadata & EPG
@@ -2258,6 +2700,7 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
 
         // set IP address and port
         dynamic_cast<RtlTcpInput*>(m_inputDevice)->setTcpIp(m_setupDialog->settings().rtltcp.tcpAddress, m_setupDialog->settings().rtltcp.tcpPort);
+        dynamic_cast<RtlTcpInput*>(m_inputDevice)->setPackedTransport(m_setupDialog->settings().rtltcp.packedTransport);
 
         if (m_inputDevice->openDevice())
         {  // rtl tcp is available
@@ -2299,12 +2742,12 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
             ui->favoriteLabel->setEnabled(true);
 
             // recorder
-            m_inputDeviceRecorder->setDeviceDescription(m_inputDevice->deviceDescription());
-            connect(m_inputDeviceRecorder, &InputDeviceRecorder::recording, m_inputDevice, &InputDevice::startStopRecording);
+            connect(m_inputDeviceRecorder, &InputDeviceRecorder::deviceRecording, m_inputDevice, &InputDevice::startStopRecording);
             connect(m_inputDevice, &InputDevice::recordBuffer, m_inputDeviceRecorder, &InputDeviceRecorder::writeBuffer, Qt::DirectConnection);
+            m_inputDeviceRecorder->setDeviceDescription(m_inputDevice->deviceDescription());
 
             // ensemble info dialog
-            connect(m_inputDevice, &InputDevice::agcGain, m_ensembleInfoDialog, &EnsembleInfoDialog::updateAgcGain);
+            connect(m_inputDevice, &InputDevice::agcGain, this, [](float gain) { SignalTelemetry::getInstance()->setAgcGain(gain); }, Qt::DirectConnection);
             m_ensembleInfoDialog->enableRecording(true);
 
             // metadata & EPG
@@ -2323,7 +2766,11 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
     case InputDeviceId::AIRSPY:
     {
 #if HAVE_AIRSPY
-        m_inputDevice = new AirspyInput(m_setupDialog->settings().airspy.prefer4096kHz);
+        m_inputDevice = new AirspyInput(m_setupDialog->settings().airspy.prefer4096kHz, m_setupDialog->settings().airspy.wideband);
+        if (InputDeviceId::AIRSPY == m_reconnect.id)
+        {   // reopening the same device
+            dynamic_cast<AirspyInput*>(m_inputDevice)->setSerial(m_reconnect.serial);
+        }
 
         // signals have to be connected before calling isAvailable
 
@@ -2373,12 +2820,12 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
 
             // ensemble info dialog
             // recorder
-            m_inputDeviceRecorder->setDeviceDescription(m_inputDevice->deviceDescription());
-            connect(m_inputDeviceRecorder, &InputDeviceRecorder::recording, m_inputDevice, &InputDevice::startStopRecording);
+            connect(m_inputDeviceRecorder, &InputDeviceRecorder::deviceRecording, m_inputDevice, &InputDevice::startStopRecording);
             connect(m_inputDevice, &InputDevice::recordBuffer, m_inputDeviceRecorder, &InputDeviceRecorder::writeBuffer, Qt::DirectConnection);
+            m_inputDeviceRecorder->setDeviceDescription(m_inputDevice->deviceDescription());
 
             // ensemble info dialog
-            connect(m_inputDevice, &InputDevice::agcGain, m_ensembleInfoDialog, &EnsembleInfoDialog::updateAgcGain);
+            connect(m_inputDevice, &InputDevice::agcGain, this, [](float gain) { SignalTelemetry::getInstance()->setAgcGain(gain); }, Qt::DirectConnection);
             m_ensembleInfoDialog->enableRecording(true);
 
             // metadata & EPG
@@ -2460,12 +2907,12 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
 
             // ensemble info dialog
             // recorder
-            m_inputDeviceRecorder->setDeviceDescription(m_inputDevice->deviceDescription());
-            connect(m_inputDeviceRecorder, &InputDeviceRecorder::recording, m_inputDevice, &InputDevice::startStopRecording);
+            connect(m_inputDeviceRecorder, &InputDeviceRecorder::deviceRecording, m_inputDevice, &InputDevice::startStopRecording);
             connect(m_inputDevice, &InputDevice::recordBuffer, m_inputDeviceRecorder, &InputDeviceRecorder::writeBuffer, Qt::DirectConnection);
+            m_inputDeviceRecorder->setDeviceDescription(m_inputDevice->deviceDescription());
 
             // ensemble info dialog
-            connect(m_inputDevice, &InputDevice::agcGain, m_ensembleInfoDialog, &EnsembleInfoDialog::updateAgcGain);
+            connect(m_inputDevice, &InputDevice::agcGain, this, [](float gain) { SignalTelemetry::getInstance()->setAgcGain(gain); }, Qt::DirectConnection);
             m_ensembleInfoDialog->enableRecording(true);
 
             // metadata & EPG
@@ -2504,6 +2951,7 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
 
         connect(dynamic_cast<RawFileInput*>(m_inputDevice), &RawFileInput::fileLength, m_setupDialog, &SetupDialog::onFileLength, Qt::QueuedConnection);
         connect(dynamic_cast<RawFileInput*>(m_inputDevice), &RawFileInput::fileProgress, m_setupDialog, &SetupDialog::onFileProgress, Qt::QueuedConnection);
+        connect(m_setupDialog, &SetupDialog::rawFileSeek, dynamic_cast<RawFileInput*>(m_inputDevice), &RawFileInput::seek, Qt::QueuedConnection);
 
         // we can open device now
         if (m_inputDevice->openDevice())
@@ -2557,6 +3005,11 @@ void MainWindow::initInputDevice(const InputDeviceId & d)
     }
         break;
     }
+
+    if (InputDeviceId::UNDEFINED != m_inputDeviceId)
+    {   // some device is active => nothing to reconnect
+        m_reconnect.id = InputDeviceId::UNDEFINED;
+    }
 }
 
 void MainWindow::loadSettings()
@@ -2585,7 +3038,168 @@ void MainWindow::loadSettings()
         m_muteLabel->toggle();
     }
     emit audioOutput(settings->value("audioDevice", "").toByteArray());
+#if (HAVE_PORTAUDIO)
+    // float32 output is enabled only from ini file
+    m_audioFloatOutput = settings->value("audioFloatOutput", false).toBool();
+    if (nullptr != dynamic_cast<AudioOutputPa *>(m_audioOutput))
+    {
+        static_cast<AudioOutputPa *>(m_audioOutput)->setFloatOutput(m_audioFloatOutput);
+    }
+    // exclusive (direct hardware) audio output is enabled only from ini file
+    m_audioExclusive = settings->value("AudioExclusive/enable", false).toBool();
+    m_audioExclusivePeriodMs = settings->value("AudioExclusive/periodMs", AUDIOOUTPUTPA_EXCLUSIVE_PERIOD_MS).toInt();
+    m_audioExclusivePeriods = settings->value("AudioExclusive/numPeriods", AUDIOOUTPUTPA_EXCLUSIVE_PERIODS).toInt();
+    m_audioExclusiveAlsaDevice = settings->value("AudioExclusive/alsaDevice", "hw:0,0").toString();
+    if (m_audioExclusive && (nullptr != dynamic_cast<AudioOutputPa *>(m_audioOutput)))
+    {
+        AudioOutputPa::ExclusiveMode mode;
+        mode.enable = true;
+        mode.periodMs = m_audioExclusivePeriodMs;
+        mode.numPeriods = m_audioExclusivePeriods;
+        mode.alsaDevice = m_audioExclusiveAlsaDevice.toLatin1();
+        static_cast<AudioOutputPa *>(m_audioOutput)->setExclusiveMode(mode);
+    }
+#endif
+    // push mode of Qt audio output is enabled only from ini file
+    m_audioPush = settings->value("AudioPush/enable", false).toBool();
+    m_audioPushPeriodMs = settings->value("AudioPush/periodMs", AUDIOOUTPUTQT_PUSH_PERIOD_MS).toInt();
+    m_audioPushPeriods = settings->value("AudioPush/numPeriods", AUDIOOUTPUTQT_PUSH_PERIODS).toInt();
+    if (m_audioPush && (nullptr != dynamic_cast<AudioOutputQt *>(m_audioOutput)))
+    {   // audio output lives in its own thread
+        AudioOutputQt::PushMode mode;
+        mode.enable = true;
+        mode.periodMs = m_audioPushPeriodMs;
+        mode.numPeriods = m_audioPushPeriods;
+        QMetaObject::invokeMethod(m_audioOutput, [this, mode]() { static_cast<AudioOutputQt *>(m_audioOutput)->setPushMode(mode); }, Qt::QueuedConnection);
+    }
     m_keepServiceListOnScan = settings->value("keepServiceListOnScan", false).toBool();
+    // low power monitoring is enabled only from ini file
+    m_lowPowerWhenMinimized = settings->value("lowPowerWhenMinimized", false).toBool();
+
+    // GPU rendering of slideshow is enabled only from ini file
+    m_slsOpenGL = settings->value("slsOpenGL", false).toBool();
+    ui->slsView_Service->setOpenGL(m_slsOpenGL);
+    ui->slsView_Announcement->setOpenGL(m_slsOpenGL);
+
+    // timeshift buffer length is configured only from ini file, 0 disables timeshift
+    m_timeshiftMin = settings->value("timeshiftMinutes", AUDIO_TIMESHIFT_DEFAULT_MIN).toInt();
+    AudioDecoder * decoder = m_audioDecoder;
+    int timeshiftMin = m_timeshiftMin;
+    QMetaObject::invokeMethod(m_audioDecoder, [decoder, timeshiftMin]() { decoder->setTimeshift(timeshiftMin); }, Qt::QueuedConnection);
+    onTimeshiftInfo(false, 0, 0);
+
+    // continuous recording (segmenting and rotation of files) is enabled only from ini file
+    m_audioRecSegmentMin = settings->value("AudioRecSegmenting/segmentMin", 0).toInt();
+    m_audioRecRetentionHours = settings->value("AudioRecSegmenting/retentionHours", 0).toInt();
+    m_audioRecPreallocate = settings->value("AudioRecSegmenting/preallocate", false).toBool();
+    m_audioRecManager->setSegmenting(m_audioRecSegmentMin, m_audioRecRetentionHours, m_audioRecPreallocate);
+
+    // FLAC compression of decoded audio recording is enabled only from ini file
+    m_audioRecFlac = settings->value("AudioRecording/flac", false).toBool();
+    AudioRecorder::setOutputFormat(m_audioRecFlac ? AudioRecorder::OutputFormat::Flac : AudioRecorder::OutputFormat::Wav);
+
+    // splitting of raw IQ recording to parts is enabled only from ini file
+    m_rawFileSplitSizeMB = settings->value("RawFileSplitting/maxSizeMB", 0).toInt();
+    m_rawFileSplitMin = settings->value("RawFileSplitting/maxMinutes", 0).toInt();
+    m_inputDeviceRecorder->setSplitting(m_rawFileSplitSizeMB, m_rawFileSplitMin);
+
+    // IQ flight recorder is enabled only from ini file
+    m_rawFileFlightRecorderSec = settings->value("RawFileFlightRecorder/seconds", 0).toInt();
+    m_inputDeviceRecorder->setFlightRecorder(m_rawFileFlightRecorderSec);
+    m_flightRecorderAction->setEnabled(m_rawFileFlightRecorderSec > 0);
+
+    // thread priorities and CPU affinity are configured only from ini file (priority 0 and empty CPU list = system default)
+    for (int cls = 0; cls < int(ThreadClass::NumClasses); ++cls)
+    {
+        ThreadPriorityConfig cfg;
+        cfg.priority = settings->value(QString("ThreadPriority/%1Priority").arg(threadClassKeys[cls]), 0).toInt();
+        cfg.cpuMask = ThreadPriority::parseCpuList(settings->value(QString("ThreadPriority/%1Cpus").arg(threadClassKeys[cls]), "").toString());
+        ThreadPriority::setConfig(static_cast<ThreadClass>(cls), cfg);
+    }
+
+    // binary log file is enabled only from ini file
+    m_logSinkEna = settings->value("LogSink/enabled", false).toBool();
+    m_logSinkDirectory = settings->value("LogSink/directory", QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/logs").toString();
+    m_logSinkMaxFileSizeMB = settings->value("LogSink/maxFileSizeMB", LOGSINK_FILE_SIZE_MB).toInt();
+    m_logSinkMaxFiles = settings->value("LogSink/maxFiles", LOGSINK_NUM_FILES).toInt();
+    if (m_logSinkEna && (nullptr == logSink.load()))
+    {
+        LogSink::getInstance()->start(m_logSinkDirectory, m_logSinkMaxFileSizeMB, m_logSinkMaxFiles);
+        logSink.store(LogSink::getInstance(), std::memory_order_release);
+    }
+
+    // IQ stream server is enabled only from ini file
+    m_iqStreamServerEna = settings->value("IQStreamServer/enabled", false).toBool();
+    m_iqStreamServerPort = settings->value("IQStreamServer/port", IQSTREAMSERVER_PORT_DEFAULT).toInt();
+    if (m_iqStreamServerEna && (nullptr == m_iqStreamServer))
+    {
+        m_iqStreamServer = new IQStreamServer(this);
+        m_iqStreamServer->start(m_iqStreamServerPort);
+    }
+
+    // audio stream server is enabled only from ini file
+    m_audioStreamServerEna = settings->value("AudioStreamServer/enabled", false).toBool();
+    m_audioStreamServerPort = settings->value("AudioStreamServer/port", AUDIOSTREAMSERVER_PORT_DEFAULT).toInt();
+    m_audioStreamRtpDestination = settings->value("AudioStreamServer/rtpDestination", "").toString();
+    if (m_audioStreamServerEna && (nullptr == m_audioStreamServer))
+    {
+        m_audioStreamServer = new AudioStreamServer(this);
+        m_audioStreamServer->setRtpDestination(m_audioStreamRtpDestination);
+        m_audioStreamServer->start(m_audioStreamServerPort);
+    }
+
+    // shared memory export is enabled only from ini file
+    m_shmExportEna = settings->value("SharedMemoryExport/enabled", false).toBool();
+    m_shmExportName = settings->value("SharedMemoryExport/name", SHMEXPORT_NAME_DEFAULT).toString();
+    if (m_shmExportEna)
+    {
+        SharedMemoryExport::start(m_shmExportName);
+    }
+
+    // input FIFO overflow policy is set only from ini file (0 = block, 1 = drop newest, 2 = drop oldest)
+    m_inputFifoOverflowPolicy = settings->value("InputFifo/overflowPolicy", int(InputFifoOverflowPolicy::DropNewest)).toInt();
+    if ((m_inputFifoOverflowPolicy < int(InputFifoOverflowPolicy::Block)) || (m_inputFifoOverflowPolicy > int(InputFifoOverflowPolicy::DropOldest)))
+    {
+        m_inputFifoOverflowPolicy = int(InputFifoOverflowPolicy::DropNewest);
+    }
+    InputDevice::setFifoOverflowPolicy(static_cast<InputFifoOverflowPolicy>(m_inputFifoOverflowPolicy));
+
+    // data group recording for offline replay is enabled only from ini file
+    m_dataGroupRecordFile = settings->value("DataGroupRecording/file", "").toString();
+    if (!m_dataGroupRecordFile.isEmpty() && (nullptr == m_dataGroupRecorder))
+    {
+        m_dataGroupRecorder = new DataGroupRecorder();
+        if (m_dataGroupRecorder->open(m_dataGroupRecordFile))
+        {   // recorder is used from GUI thread only
+            auto recordUserAppData = [this](int instance, const RadioControlUserAppData & data) {
+                m_dataGroupRecorder->record(DataGroupRecorder::Type::UserAppData, instance, data.data, data.SCId, static_cast<uint16_t>(data.userAppType));
+            };
+            connect(m_radioControl, &RadioControl::userAppData_Service, this, [recordUserAppData](const RadioControlUserAppData & data) {
+                recordUserAppData(Instance::Service, data);
+            }, Qt::QueuedConnection);
+            connect(m_radioControl, &RadioControl::userAppData_Announcement, this, [recordUserAppData](const RadioControlUserAppData & data) {
+                recordUserAppData(Instance::Announcement, data);
+            }, Qt::QueuedConnection);
+            connect(m_radioControl, &RadioControl::dlDataGroup_Service, this, [this](const QByteArray & dg) {
+                m_dataGroupRecorder->record(DataGroupRecorder::Type::DynamicLabel, Instance::Service, dg);
+            }, Qt::QueuedConnection);
+            connect(m_radioControl, &RadioControl::dlDataGroup_Announcement, this, [this](const QByteArray & dg) {
+                m_dataGroupRecorder->record(DataGroupRecorder::Type::DynamicLabel, Instance::Announcement, dg);
+            }, Qt::QueuedConnection);
+        }
+    }
+
+    // service following is enabled only from ini file
+    m_serviceFollowEna = settings->value("ServiceFollowing/enabled", false).toBool();
+    m_serviceFollowSnrThr = settings->value("ServiceFollowing/snrThreshold", RADIO_CONTROL_SERVICE_FOLLOW_SNR_THR).toFloat();
+    m_serviceFollowHoldMs = settings->value("ServiceFollowing/holdMs", RADIO_CONTROL_SERVICE_FOLLOW_HOLD_MS).toInt();
+    RadioControl * radioControl = m_radioControl;
+    bool followEna = m_serviceFollowEna;
+    float followSnrThr = m_serviceFollowSnrThr;
+    int followHoldMs = m_serviceFollowHoldMs;
+    QMetaObject::invokeMethod(m_radioControl, [radioControl, followEna, followSnrThr, followHoldMs]() {
+            radioControl->setServiceFollowing(followEna, followSnrThr, followHoldMs);
+        }, Qt::QueuedConnection);
 
     int inDevice = settings->value("inputDeviceId", int(InputDeviceId::RTLSDR)).toInt();
 
@@ -2615,7 +3229,9 @@ void MainWindow::loadSettings()
     s.announcementEna = settings->value("announcementEna", 0x07FF).toUInt();
     s.bringWindowToForeground = settings->value("bringWindowToForegroundOnAlarm", true).toBool();
     s.noiseConcealmentLevel = settings->value("noiseConcealment", 0).toInt();
+    s.audioLatencyMs = settings->value("audioLatency", 0).toInt();
     s.xmlHeaderEna = settings->value("rawFileXmlHeader", true).toBool();
+    s.rawCompressionEna = settings->value("rawFileCompression", false).toBool();
     s.spiAppEna = settings->value("spiAppEna", true).toBool();
     s.useInternet = settings->value("useInternet", true).toBool();
     s.radioDnsEna = settings->value("radioDNS", true).toBool();
@@ -2630,8 +3246,8 @@ void MainWindow::loadSettings()
     s.uaDump.slsPattern = settings->value("UA-STORAGE/slsPattern", slsDumpPatern).toString();
     s.uaDump.spiPattern = settings->value("UA-STORAGE/spiPattern", spiDumpPatern).toString();
 
-    m_epgDialog->setFilterEmptyEpg(settings->value("epgFilterEmpty", false).toBool());
-    m_epgDialog->setFilterEnsemble(settings->value("epgFilterOtherEnsembles", false).toBool());
+    m_epgFilterEmpty = settings->value("epgFilterEmpty", false).toBool();
+    m_epgFilterEnsemble = settings->value("epgFilterOtherEnsembles", false).toBool();
 
     s.rtlsdr.gainIdx = settings->value("RTL-SDR/gainIndex", 0).toInt();
     s.rtlsdr.gainMode = static_cast<RtlGainMode>(settings->value("RTL-SDR/gainMode", static_cast<int>(RtlGainMode::Software)).toInt());
@@ -2639,6 +3255,8 @@ void MainWindow::loadSettings()
     s.rtlsdr.biasT = settings->value("RTL-SDR/bias-T", false).toBool();
     s.rtlsdr.agcLevelMax = settings->value("RTL-SDR/agcLevelMax", 0).toInt();
     s.rtlsdr.ppm = settings->value("RTL-SDR/ppm", 0).toInt();
+    s.rtlsdr.asyncBufNum = settings->value("RTL-SDR/asyncBufferNum", RTLSDR_ASYNC_BUF_NUM_DEFAULT).toInt();
+    s.rtlsdr.asyncBufLen = settings->value("RTL-SDR/asyncBufferLength", RTLSDR_ASYNC_BUF_LEN_DEFAULT).toInt();
 
     s.rtltcp.gainIdx = settings->value("RTL-TCP/gainIndex", 0).toInt();
     s.rtltcp.gainMode = static_cast<RtlGainMode>(settings->value("RTL-TCP/gainMode", static_cast<int>(RtlGainMode::Software)).toInt());
@@ -2646,6 +3264,7 @@ void MainWindow::loadSettings()
     s.rtltcp.tcpPort = settings->value("RTL-TCP/port", 1234).toInt();
     s.rtltcp.agcLevelMax = settings->value("RTL-TCP/agcLevelMax", 0).toInt();
     s.rtltcp.ppm = settings->value("RTL-TCP/ppm", 0).toInt();
+    s.rtltcp.packedTransport = settings->value("RTL-TCP/packedTransport", false).toBool();
 
 #if HAVE_AIRSPY
     s.airspy.gain.sensitivityGainIdx = settings->value("AIRSPY/sensitivityGainIdx", 9).toInt();
@@ -2658,6 +3277,7 @@ void MainWindow::loadSettings()
     s.airspy.biasT = settings->value("AIRSPY/bias-T", false).toBool();
     s.airspy.dataPacking = settings->value("AIRSPY/dataPacking", true).toBool();
     s.airspy.prefer4096kHz = settings->value("AIRSPY/preferSampleRate4096kHz", true).toBool();
+    s.airspy.wideband = settings->value("AIRSPY/widebandCapture", false).toBool();
 #endif
 #if HAVE_SOAPYSDR
     s.soapysdr.gainIdx = settings->value("SOAPYSDR/gainIndex", 0).toInt();
@@ -2707,6 +3327,9 @@ void MainWindow::loadSettings()
         }
     }
 
+    // additional receivers monitoring other ensembles are configured only from ini file
+    m_ensembleMonitor->loadSettings(*settings);
+
     delete settings;
 
     if (((InputDeviceId::RTLSDR == m_inputDeviceId)
@@ -2776,8 +3399,50 @@ void MainWindow::saveSettings()
         settings->setValue("audioFramework", static_cast<int>(AudioFramework::Qt));
     }
     settings->setValue("volume", m_audioVolume);
+    settings->setValue("audioFloatOutput", m_audioFloatOutput);
+#if (HAVE_PORTAUDIO)
+    settings->setValue("AudioExclusive/enable", m_audioExclusive);
+    settings->setValue("AudioExclusive/periodMs", m_audioExclusivePeriodMs);
+    settings->setValue("AudioExclusive/numPeriods", m_audioExclusivePeriods);
+    settings->setValue("AudioExclusive/alsaDevice", m_audioExclusiveAlsaDevice);
+#endif
+    settings->setValue("AudioPush/enable", m_audioPush);
+    settings->setValue("AudioPush/periodMs", m_audioPushPeriodMs);
+    settings->setValue("AudioPush/numPeriods", m_audioPushPeriods);
     settings->setValue("mute", m_muteLabel->isChecked());
     settings->setValue("keepServiceListOnScan", m_keepServiceListOnScan);
+    settings->setValue("lowPowerWhenMinimized", m_lowPowerWhenMinimized);
+    settings->setValue("slsOpenGL", m_slsOpenGL);
+    settings->setValue("timeshiftMinutes", m_timeshiftMin);
+    settings->setValue("AudioRecSegmenting/segmentMin", m_audioRecSegmentMin);
+    settings->setValue("AudioRecSegmenting/retentionHours", m_audioRecRetentionHours);
+    settings->setValue("AudioRecSegmenting/preallocate", m_audioRecPreallocate);
+    settings->setValue("AudioRecording/flac", m_audioRecFlac);
+    settings->setValue("RawFileSplitting/maxSizeMB", m_rawFileSplitSizeMB);
+    settings->setValue("RawFileSplitting/maxMinutes", m_rawFileSplitMin);
+    settings->setValue("RawFileFlightRecorder/seconds", m_rawFileFlightRecorderSec);
+    for (int cls = 0; cls < int(ThreadClass::NumClasses); ++cls)
+    {
+        ThreadPriorityConfig cfg = ThreadPriority::config(static_cast<ThreadClass>(cls));
+        settings->setValue(QString("ThreadPriority/%1Priority").arg(threadClassKeys[cls]), cfg.priority);
+        settings->setValue(QString("ThreadPriority/%1Cpus").arg(threadClassKeys[cls]), (0 != cfg.cpuMask) ? ThreadPriority::cpuListString(cfg.cpuMask) : QString(""));
+    }
+    settings->setValue("LogSink/enabled", m_logSinkEna);
+    settings->setValue("LogSink/directory", m_logSinkDirectory);
+    settings->setValue("LogSink/maxFileSizeMB", m_logSinkMaxFileSizeMB);
+    settings->setValue("LogSink/maxFiles", m_logSinkMaxFiles);
+    settings->setValue("IQStreamServer/enabled", m_iqStreamServerEna);
+    settings->setValue("IQStreamServer/port", m_iqStreamServerPort);
+    settings->setValue("AudioStreamServer/enabled", m_audioStreamServerEna);
+    settings->setValue("AudioStreamServer/port", m_audioStreamServerPort);
+    settings->setValue("AudioStreamServer/rtpDestination", m_audioStreamRtpDestination);
+    settings->setValue("SharedMemoryExport/enabled", m_shmExportEna);
+    settings->setValue("SharedMemoryExport/name", m_shmExportName);
+    settings->setValue("DataGroupRecording/file", m_dataGroupRecordFile);
+    settings->setValue("InputFifo/overflowPolicy", m_inputFifoOverflowPolicy);
+    settings->setValue("ServiceFollowing/enabled", m_serviceFollowEna);
+    settings->setValue("ServiceFollowing/snrThreshold", m_serviceFollowSnrThr);
+    settings->setValue("ServiceFollowing/holdMs", m_serviceFollowHoldMs);
     settings->setValue("windowGeometry", saveGeometry());
     settings->setValue("style", static_cast<int>(s.applicationStyle));
     settings->setValue("announcementEna", s.announcementEna);
@@ -2786,7 +3451,9 @@ void MainWindow::saveSettings()
     settings->setValue("dlPlus", s.dlPlusEna);
     settings->setValue("language", QLocale::languageToCode(s.lang));
     settings->setValue("noiseConcealment", s.noiseConcealmentLevel);
+    settings->setValue("audioLatency", s.audioLatencyMs);
     settings->setValue("rawFileXmlHeader", s.xmlHeaderEna);
+    settings->setValue("rawFileCompression", s.rawCompressionEna);
     settings->setValue("spiAppEna", s.spiAppEna);
     settings->setValue("useInternet", s.useInternet);
     settings->setValue("radioDNS", s.radioDnsEna);
@@ -2801,8 +3468,13 @@ void MainWindow::saveSettings()
     settings->setValue("UA-STORAGE/slsPattern", s.uaDump.slsPattern);
     settings->setValue("UA-STORAGE/spiPattern", s.uaDump.spiPattern);
 
-    settings->setValue("epgFilterEmpty", m_epgDialog->filterEmptyEpg());
-    settings->setValue("epgFilterOtherEnsembles", m_epgDialog->filterEnsemble());
+    if (nullptr != m_epgDialog)
+    {
+        m_epgFilterEmpty = m_epgDialog->filterEmptyEpg();
+        m_epgFilterEnsemble = m_epgDialog->filterEnsemble();
+    }
+    settings->setValue("epgFilterEmpty", m_epgFilterEmpty);
+    settings->setValue("epgFilterOtherEnsembles", m_epgFilterEnsemble);
 
     settings->setValue("RTL-SDR/gainIndex", s.rtlsdr.gainIdx);
     settings->setValue("RTL-SDR/gainMode", static_cast<int>(s.rtlsdr.gainMode));
@@ -2810,6 +3482,8 @@ void MainWindow::saveSettings()
     settings->setValue("RTL-SDR/bias-T", s.rtlsdr.biasT);
     settings->setValue("RTL-SDR/agcLevelMax", s.rtlsdr.agcLevelMax);
     settings->setValue("RTL-SDR/ppm", s.rtlsdr.ppm);
+    settings->setValue("RTL-SDR/asyncBufferNum", s.rtlsdr.asyncBufNum);
+    settings->setValue("RTL-SDR/asyncBufferLength", s.rtlsdr.asyncBufLen);
 
 #if HAVE_AIRSPY
     settings->setValue("AIRSPY/sensitivityGainIdx", s.airspy.gain.sensitivityGainIdx);
@@ -2822,6 +3496,7 @@ void MainWindow::saveSettings()
     settings->setValue("AIRSPY/bias-T", s.airspy.biasT);
     settings->setValue("AIRSPY/dataPacking", s.airspy.dataPacking);
     settings->setValue("AIRSPY/preferSampleRate4096kHz", s.airspy.prefer4096kHz);
+    settings->setValue("AIRSPY/widebandCapture", s.airspy.wideband);
 #endif
 
 #if HAVE_SOAPYSDR
@@ -2839,6 +3514,7 @@ void MainWindow::saveSettings()
     settings->setValue("RTL-TCP/port", s.rtltcp.tcpPort);
     settings->setValue("RTL-TCP/agcLevelMax", s.rtltcp.agcLevelMax);
     settings->setValue("RTL-TCP/ppm", s.rtltcp.ppm);
+    settings->setValue("RTL-TCP/packedTransport", s.rtltcp.packedTransport);
 
     settings->setValue("RAW-FILE/filename", s.rawfile.file);
     settings->setValue("RAW-FILE/format", int(s.rawfile.format));
@@ -2923,12 +3599,49 @@ void MainWindow::onSwitchSourceClicked()
 {
     QModelIndex current = ui->serviceListView->currentIndex();
     const SLModel * model = reinterpret_cast<const SLModel*>(current.model());
-    ServiceListId id = model->id(current);
-    ServiceListConstIterator it = m_serviceList->findService(id);
+    switchServiceSource(model->id(current), ServiceListId());
+}
+
+void MainWindow::onServiceFollowRequest()
+{
+    if (!m_serviceFollowEna || !m_SId.isValid())
+    {
+        return;
+    }
+
+    ServiceListId servId(m_SId.value(), m_SCIdS);
+    if (servId != m_serviceFollowService)
+    {
+        m_serviceFollowService = servId;
+        m_serviceFollowTried.clear();
+    }
+    m_serviceFollowTried.insert(m_frequency);
+
+    // best alternative not tried yet, tuner state of the frequency is restored by input device
+    const QList<ServiceListAlternative> alternatives = m_serviceList->alternatives(servId, m_frequency);
+    for (const auto & alt : alternatives)
+    {
+        if (!m_serviceFollowTried.contains(alt.frequency))
+        {
+            qCInfo(application, "Service following: %.3f -> %.3f MHz (last SNR %.1f dB)", m_frequency/1000.0, alt.frequency/1000.0, alt.snr);
+            switchServiceSource(servId, alt.ensId);
+            return;
+        }
+    }
+    if (!alternatives.isEmpty())
+    {
+        qCInfo(application) << "Service following: all alternatives were tried";
+    }
+    else { /* no alternative */ }
+}
+
+void MainWindow::switchServiceSource(const ServiceListId &servId, const ServiceListId &ensId)
+{
+    ServiceListConstIterator it = m_serviceList->findService(servId);
     if (it != m_serviceList->serviceListEnd())
     {
-        // swith to next ensemble & get ensemble frequency
-        uint32_t newFrequency = (*it)->switchEnsemble(ServiceListId())->frequency();
+        // swith to requested (or next) ensemble & get ensemble frequency
+        uint32_t newFrequency = (*it)->switchEnsemble(ensId)->frequency();
         if (newFrequency)
         {
             if (newFrequency != m_frequency)
@@ -3016,9 +3729,37 @@ void MainWindow::showEnsembleInfo()
 
 void MainWindow::showEPG()
 {
-    m_epgDialog->show();
-    m_epgDialog->raise();
-    m_epgDialog->activateWindow();
+    EPGDialog * dialog = epgDialog();
+    dialog->show();
+    dialog->raise();
+    dialog->activateWindow();
+}
+
+EPGDialog * MainWindow::epgDialog()
+{
+    if (nullptr == m_epgDialog)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        m_epgDialog = new EPGDialog(m_slModel, ui->serviceListView->selectionModel(), m_metadataManager, this);
+        connect(m_epgDialog, &EPGDialog::scheduleAudioRecording, this, [this](const AudioRecScheduleItem & item) {
+            showAudioRecordingSchedule();
+            m_audioRecScheduleDialog->addItem(item);
+        });
+        m_epgDialog->setFilterEmptyEpg(m_epgFilterEmpty);
+        m_epgDialog->setFilterEnsemble(m_epgFilterEnsemble);
+        m_epgDialog->onEnsembleInformation(m_epgEnsemble);
+        m_epgDialog->setupDarkMode(isDarkMode());
+
+        qCInfo(application) << "EPG dialog created in" << timer.elapsed() << "ms";
+    }
+    return m_epgDialog;
+}
+
+void MainWindow::traceStartup(const char * phase)
+{
+    qCInfo(application) << "Startup:" << phase << m_startupTimer.elapsed() << "ms";
 }
 
 void MainWindow::showAboutDialog()
@@ -3041,6 +3782,13 @@ void MainWindow::showLog()
     m_logDialog->activateWindow();
 }
 
+void MainWindow::showDiagnostics()
+{
+    m_diagnosticsDialog->show();
+    m_diagnosticsDialog->raise();
+    m_diagnosticsDialog->activateWindow();
+}
+
 void MainWindow::showCatSLS()
 {
     m_catSlsDialog->show();
@@ -3120,6 +3868,13 @@ void MainWindow::bandScan()
     connect(m_radioControl, &RadioControl::serviceListComplete, dialog, &BandScanDialog::onServiceListComplete, Qt::QueuedConnection);
     connect(m_serviceList, &ServiceList::serviceAdded, dialog, &BandScanDialog::onServiceFound);
     connect(dialog, &BandScanDialog::scanStarts, this, &MainWindow::onBandScanStart);
+
+    // receivers of ensemble monitor scan the same channel list in parallel, results are merged in service list
+    connect(dialog, &BandScanDialog::scanStarts, this, [this, dialog]() {
+        m_ensembleMonitor->startBandScan([dialog](int receiver) { return dialog->takeChannel(receiver); });
+    });
+    connect(m_ensembleMonitor, &EnsembleMonitor::bandScanEnsembleFound, dialog, &BandScanDialog::onReceiverEnsembleFound);
+    connect(m_ensembleMonitor, &EnsembleMonitor::bandScanReceiverStopped, dialog, &BandScanDialog::releaseReceiver);
     connect(dialog, &BandScanDialog::finished, this, &MainWindow::onBandScanFinished);
 
     dialog->open();
@@ -3128,6 +3883,9 @@ void MainWindow::bandScan()
 
 void MainWindow::onBandScanFinished(int result)
 {
+    // receivers of ensemble monitor return to regular operation
+    m_ensembleMonitor->stopBandScan();
+
     switch (result)
     {
     case BandScanDialogResult::Done:
@@ -3411,18 +4169,65 @@ void MainWindow::onColorSchemeChanged(Qt::ColorScheme colorScheme)
 #endif
 }
 
-#else // QT version < 6.5.0 -> switching is supported only on MacOS
+#endif
+
 void MainWindow::changeEvent( QEvent* e )
 {
-#ifdef Q_OS_MACX
+#if (QT_VERSION < QT_VERSION_CHECK(6, 5, 0)) && defined(Q_OS_MACX)
+    // QT version < 6.5.0 -> switching is supported only on MacOS
     if ( e->type() == QEvent::PaletteChange )
     {
         setupDarkMode();
     }
 #endif
+    if ( e->type() == QEvent::WindowStateChange )
+    {
+        updateLowPowerMode();
+        updateUiSuspension();
+    }
     QMainWindow::changeEvent( e );
 }
-#endif
+
+void MainWindow::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+
+    if (nullptr != windowHandle())
+    {   // expose changes are delivered only to native window
+        windowHandle()->installEventFilter(this);
+    }
+    if ((nullptr != screen()) && (screen()->refreshRate() > 0))
+    {
+        m_uiUpdates->setFramePeriod(qMax(1, qRound(1000.0 / screen()->refreshRate())));
+    }
+    updateUiSuspension();
+}
+
+void MainWindow::hideEvent(QHideEvent *event)
+{
+    QMainWindow::hideEvent(event);
+    updateUiSuspension();
+}
+
+void MainWindow::updateUiSuspension()
+{
+    // window that is not exposed (minimized, hidden or fully covered on platforms that report it) is not rendered
+    // pending widget updates are kept and latest state is applied when it is exposed again
+    bool suspend = !isVisible() || isMinimized() || ((nullptr != windowHandle()) && !windowHandle()->isExposed());
+    m_uiUpdates->setSuspended(suspend);
+}
+
+void MainWindow::updateLowPowerMode()
+{
+    // FIC is still processed (service list, announcements), decoding resumes when window is restored
+    bool ena = m_lowPowerWhenMinimized && isMinimized()
+               && !m_audioRecManager->isAudioRecordingActive() && !m_audioRecManager->isAudioScheduleActive();
+    if (ena != m_lowPowerMode)
+    {
+        m_lowPowerMode = ena;
+        emit lowPowerMode(ena);
+    }
+}
 
 
 bool MainWindow::isDarkMode()
@@ -3493,7 +4298,10 @@ void MainWindow::setupDarkMode()
         ui->slsView_Service->setupDarkMode(true);
         ui->slsView_Announcement->setupDarkMode(true);
         m_logDialog->setupDarkMode(true);
-        m_epgDialog->setupDarkMode(true);
+        if (nullptr != m_epgDialog)
+        {
+            m_epgDialog->setupDarkMode(true);
+        }
     }
     else
     {
@@ -3520,13 +4328,17 @@ void MainWindow::setupDarkMode()
         ui->slsView_Service->setupDarkMode(false);
         ui->slsView_Announcement->setupDarkMode(false);
         m_logDialog->setupDarkMode(false);
-        m_epgDialog->setupDarkMode(false);
+        if (nullptr != m_epgDialog)
+        {
+            m_epgDialog->setupDarkMode(false);
+        }
     }
 }
 
 void MainWindow::onDLPlusObjReceived_Service(const DLPlusObject & object)
 {
     onDLPlusObjReceived(object, Instance::Service);
+    m_dlHistory.addObject(ServiceListId(m_SId.value(), m_SCIdS), object);
 }
 
 void MainWindow::onDLPlusObjReceived_Announcement(const DLPlusObject & object)
@@ -3658,6 +4470,7 @@ void MainWindow::onDLPlusItemRunning(bool isRunning, Instance inst)
 
 void MainWindow::onDLReset_Service()
 {
+    m_uiUpdates->cancel(UiUpdateScheduler::Update::ServiceDL);
     ui->dynamicLabel_Service->clear();
     toggleDLPlus(false);
 
@@ -3670,6 +4483,7 @@ void MainWindow::onDLReset_Service()
 
 void MainWindow::onDLReset_Announcement()
 {
+    m_uiUpdates->cancel(UiUpdateScheduler::Update::AnnouncementDL);
     ui->dynamicLabel_Announcement->clear();
     toggleDLPlus(false);
 
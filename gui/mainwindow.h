@@ -42,6 +42,8 @@
 #include <QLoggingCategory>
 #include <QItemSelection>
 #include <QMessageBox>
+#include <QElapsedTimer>
+#include <future>
 
 #include "audiorecmanager.h"
 #include "audiorecscheduledialog.h"
@@ -53,17 +55,29 @@
 #include "catslsdialog.h"
 #include "inputdevice.h"
 #include "inputdevicerecorder.h"
+#include "iqstreamserver.h"
+#include "audiostreamserver.h"
 #include "radiocontrol.h"
 #include "dldecoder.h"
+#include "dlhistory.h"
 #include "slideshowapp.h"
 #include "spiapp.h"
 #include "audiodecoder.h"
 #include "audiooutput.h"
+#include "audiotap.h"
+#include "audioloudnessmeter.h"
+#include "signaltelemetry.h"
+#include "threadpriority.h"
+#include "logsink.h"
 #include "servicelist.h"
 #include "slmodel.h"
 #include "sltreemodel.h"
 #include "logdialog.h"
+#include "diagnosticsdialog.h"
 #include "audiorecschedulemodel.h"
+#include "uiupdatescheduler.h"
+#include "coarseclock.h"
+#include "datagrouprecorder.h"
 
 
 QT_BEGIN_NAMESPACE
@@ -71,6 +85,11 @@ namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
 class DLPlusObjectUI;
+class UsbHotplug;
+class EnsembleMonitor;
+
+// USB device is reopened after reinsertion, driver needs some time to settle
+#define MAINWINDOW_USB_RECONNECT_DELAY_MS  (1000)
 
 class MainWindow : public QMainWindow
 {
@@ -91,15 +110,19 @@ signals:
     void audioVolume(int volume);
     void audioOutput(const QByteArray & deviceId);
     void audioStop();
+    void audioTimeshiftPause(bool pause);
+    void audioTimeshiftSkip(int offsetSec);
+    void audioTimeshiftLive();
     void announcementMask(uint16_t mask);
+    void lowPowerMode(bool ena);
     void exit();
 
 protected:        
     void closeEvent(QCloseEvent *event);
     void resizeEvent(QResizeEvent *event);
-#if QT_VERSION < QT_VERSION_CHECK(6, 5, 0)
     void changeEvent( QEvent* e );
-#endif
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
 private:
     // constants
     enum Instance { Service = 0, Announcement = 1, NumInstances };
@@ -114,10 +137,11 @@ private:
     // UI and dialogs
     Ui::MainWindow *ui;
     SetupDialog * m_setupDialog;
-    EPGDialog * m_epgDialog;
+    EPGDialog * m_epgDialog;                     // created on first use (QML engine)
     EnsembleInfoDialog * m_ensembleInfoDialog;
     CatSLSDialog * m_catSlsDialog;
     LogDialog * m_logDialog;
+    DiagnosticsDialog * m_diagnosticsDialog;
     AudioRecScheduleDialog * m_audioRecScheduleDialog;
     QProgressBar * m_snrProgressbar;    
     ClickableLabel * m_menuLabel;
@@ -144,9 +168,16 @@ private:
     QAction * m_ensembleInfoAction;
     QAction * m_aboutAction;
     QAction * m_logAction;
+    QAction * m_flightRecorderAction;
+    QAction * m_diagnosticsAction;
     QAction * m_audioRecordingAction;
     QAction * m_audioRecordingScheduleAction;
     QAction * m_epgAction;
+    QMenu * m_timeshiftMenu;
+    QAction * m_timeshiftPauseAction;
+    QAction * m_timeshiftBackAction;
+    QAction * m_timeshiftForwardAction;
+    QAction * m_timeshiftLiveAction;
     QActionGroup * m_audioDevicesGroup = nullptr;
 
     // dark mode
@@ -158,15 +189,36 @@ private:
     QThread * m_radioControlThread;
     RadioControl * m_radioControl;
 
+    // user applications (slideshow, SPI)
+    QThread * m_userAppThread;
+
     // input device
     InputDeviceId m_inputDeviceId = InputDeviceId::UNDEFINED;
     InputDevice * m_inputDevice = nullptr;
     InputDeviceId m_inputDeviceIdRequest = InputDeviceId::UNDEFINED;
     InputDeviceRecorder * m_inputDeviceRecorder = nullptr;
+    UsbHotplug * m_usbHotplug = nullptr;            // nullptr if not supported
+    InputDevice * m_preopenedDevice = nullptr;      // device being opened in background during startup
+    std::future<bool> m_preopenResult;              // result of openDevice() of preopened device
+    EnsembleMonitor * m_ensembleMonitor = nullptr;  // other input devices feeding service list
+
+    // USB device lost during operation, it is reopened on reinsertion
+    struct
+    {
+        InputDeviceId id = InputDeviceId::UNDEFINED;
+        QString serial;
+        uint32_t SId = 0;
+        uint8_t SCIdS = 0;
+    } m_reconnect;
 
     // audio decoder
     QThread * m_audioDecoderThread;    
     AudioDecoder * m_audioDecoder;
+    AudioDecoder * m_audioAnnouncementDecoder;
+    AudioTap * m_audioTap;                      // decoded PCM of service for meters
+    AudioLoudnessMeter * m_loudnessMeter;
+    QTimer * m_signalTelemetryTimer;              // GUI pulls signal telemetry
+    UiUpdateScheduler * m_uiUpdates;              // widget updates coalesced per frame, suspended when hidden
 
     // Audio recording
     AudioRecManager * m_audioRecManager;
@@ -180,6 +232,7 @@ private:
     // state variables
     QString m_iniFilename;
     bool m_isPlaying = false;
+    QString m_serviceToolTip;
     bool m_deviceChangeRequested = false;
     bool m_exitRequested = false;
     uint32_t m_frequency = 0;
@@ -188,7 +241,57 @@ private:
     bool m_hasListViewFocus;
     bool m_hasTreeViewFocus;
     int m_audioVolume = 100;
+    bool m_audioFloatOutput = false;
+    bool m_audioExclusive = false;
+    int m_audioExclusivePeriodMs = 0;
+    int m_audioExclusivePeriods = 0;
+    QString m_audioExclusiveAlsaDevice;
+    int m_timeshiftMin = AUDIO_TIMESHIFT_DEFAULT_MIN;
+    int m_audioRecSegmentMin = 0;
+    int m_audioRecRetentionHours = 0;
+    bool m_audioRecPreallocate = false;
+    bool m_audioRecFlac = false;
+    int m_rawFileSplitSizeMB = 0;
+    int m_rawFileSplitMin = 0;
+    int m_rawFileFlightRecorderSec = 0;
     bool m_keepServiceListOnScan;
+    bool m_lowPowerWhenMinimized = false;        // MSC decoding is stopped when minimized and not recording
+    bool m_slsOpenGL = false;                    // slideshow is rendered by OpenGL viewport
+
+    // startup tracing
+    QElapsedTimer m_startupTimer;
+
+    // state of EPG dialog until it is created
+    bool m_epgFilterEmpty = false;
+    bool m_epgFilterEnsemble = false;
+    RadioControlEnsemble m_epgEnsemble = {};
+    bool m_lowPowerMode = false;
+    bool m_iqStreamServerEna = false;
+    int m_iqStreamServerPort = IQSTREAMSERVER_PORT_DEFAULT;
+    bool m_logSinkEna = false;
+    QString m_logSinkDirectory;
+    int m_logSinkMaxFileSizeMB = LOGSINK_FILE_SIZE_MB;
+    int m_logSinkMaxFiles = LOGSINK_NUM_FILES;
+    IQStreamServer * m_iqStreamServer = nullptr;
+    bool m_audioStreamServerEna = false;
+    int m_audioStreamServerPort = AUDIOSTREAMSERVER_PORT_DEFAULT;
+    QString m_audioStreamRtpDestination;
+    AudioStreamServer * m_audioStreamServer = nullptr;
+    bool m_shmExportEna = false;
+    QString m_shmExportName;
+    QString m_dataGroupRecordFile;
+    DataGroupRecorder * m_dataGroupRecorder = nullptr;
+    int m_inputFifoOverflowPolicy = int(InputFifoOverflowPolicy::DropNewest);
+    bool m_audioPush = false;
+    int m_audioPushPeriodMs = 0;
+    int m_audioPushPeriods = 0;
+
+    // service following
+    bool m_serviceFollowEna = false;
+    float m_serviceFollowSnrThr = RADIO_CONTROL_SERVICE_FOLLOW_SNR_THR;
+    int m_serviceFollowHoldMs = RADIO_CONTROL_SERVICE_FOLLOW_HOLD_MS;
+    ServiceListId m_serviceFollowService;       // service for which frequencies were tried
+    QSet<uint32_t> m_serviceFollowTried;        // frequencies tried since signal was last good
 
     // service list
     ServiceList * m_serviceList;
@@ -197,6 +300,7 @@ private:
 
     // user applications
     DLDecoder * m_dlDecoder[Instance::NumInstances];
+    DLHistory m_dlHistory;                      // DL messages and songs of services
     QMap<DLPlusContentType, DLPlusObjectUI*> m_dlObjCache[Instance::NumInstances];
     SlideShowApp * m_slideShowApp[Instance::NumInstances];
     SPIApp * m_spiApp;
@@ -212,6 +316,7 @@ private:
     void showAboutDialog();
     void showSetupDialog();
     void showLog();
+    void showDiagnostics();
     void showCatSLS();
     void showAudioRecordingSchedule();
     void setExpertMode(bool ena);
@@ -223,6 +328,7 @@ private:
     void clearEnsembleInformationLabels();
     void clearServiceInformationLabels();
     void initInputDevice(const InputDeviceId &d);
+    void preopenInputDevice();
     bool isDarkMode();
     void forceDarkStyle(bool ena);
     void setupDarkMode();
@@ -237,6 +343,10 @@ private:
     void restoreTimeQualWidget();
     bool stopAudioRecordingMsg(const QString &infoText);
     void selectService(const ServiceListId & serviceId);
+    void updateLowPowerMode();
+    void updateUiSuspension();
+    void traceStartup(const char * phase);
+    EPGDialog * epgDialog();
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
     void onColorSchemeChanged(Qt::ColorScheme colorScheme);
@@ -255,10 +365,14 @@ private:
     void onAudioVolumeSliderChanged(int volume);
     void onMuteLabelToggled(bool doMute);
     void onSwitchSourceClicked();
+    void switchServiceSource(const ServiceListId & servId, const ServiceListId & ensId);
+    void onServiceFollowRequest();
     void onAnnouncementClicked();
     void onApplicationStyleChanged(ApplicationStyle style);
     void onExpertModeToggled(bool checked);
     void onSignalState(uint8_t sync, float snr);
+    void updateSignalState(uint8_t sync, float snr);
+    void onSignalTelemetryTimer();
     void onServiceListEntry(const RadioControlEnsemble & ens, const RadioControlServiceComponent & slEntry);
     void onDLComplete_Service(const QString &dl);
     void onDLComplete_Announcement(const QString & dl);
@@ -282,6 +396,10 @@ private:
     void onNewInputDeviceSettings();
     void onNewAnnouncementSettings();    
     void onInputDeviceError(const InputDeviceErrorCode errCode);
+    void prepareReconnect();
+    void onUsbDeviceArrived();
+    void onUsbDeviceLeft();
+    void reconnectInputDevice();
     void onServiceListSelection(const QItemSelection &selected, const QItemSelection &deselected);
     void onServiceListTreeSelection(const QItemSelection &selected, const QItemSelection &deselected);
     void onAudioServiceSelection(const RadioControlServiceComponent &s);
@@ -295,6 +413,8 @@ private:
     void onAudioRecordingStopped();
     void onAudioRecordingProgress(size_t bytes, qint64 timeSec);
     void onAudioRecordingCountdown(int numSec);
+    void onTimeshiftInfo(bool isPaused, int delaySec, int bufferedSec);
+    void onAudioLoudness(float momentary, float shortTerm, float integrated);
     void onMetadataUpdated(const ServiceListId &id, MetadataManager::MetadataRole role);
     void onEpgEmpty();
 
@@ -32,11 +32,14 @@
 #include <QStandardPaths>
 #include <QCryptographicHash>
 #include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
 #include <QThread>
 #include <QLoggingCategory>
 
 #include "epgtime.h"
 #include "metadatamanager.h"
+#include "epgcache.h"
 #include "spiapp.h"
 
 
@@ -44,15 +47,31 @@ Q_LOGGING_CATEGORY(metadataManager, "MetadataManager", QtInfoMsg)
 
 MetadataManager::MetadataManager(const ServiceList *serviceList, QObject *parent) : QObject(parent), m_serviceList(serviceList), m_isLoadingFromCache(false), m_cleanEpgCache(true)
 {
+    m_logoCache.setMaxCost(METADATAMANAGER_LOGO_CACHE_KB);
+    m_logoImageCache.setMaxCost(METADATAMANAGER_LOGO_IMAGE_CACHE_KB);
+    m_xmlParserPool = new QThreadPool(this);
+    m_xmlParserPool->setMaxThreadCount(METADATAMANAGER_XML_PARSER_THREADS);
+    m_nowNextChangeSec = 0;
+    m_nowNextTimeSec = 0;
+    m_epgFileWriter = new EPGFileWriter(this);
+    m_epgFileWriter->start(QThread::LowPriority);
+    connect(EPGTime::getInstance(), &EPGTime::secSinceEpochChanged, this, &MetadataManager::onEpgTimeChanged);
 }
 
 MetadataManager::~MetadataManager()
 {
+    // wait for running parser tasks
+    m_xmlParserPool->clear();
+    m_xmlParserPool->waitForDone();
+
+    // pending files are written before cache maintenance
+    delete m_epgFileWriter;
+
     if (m_cleanEpgCache && EPGTime::getInstance()->isValid())
     {   // do chache maintenance
         QDir directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)  + "/EPG/");
-        QStringList xmlFiles = directory.entryList({"*_PI.xml"}, QDir::Files);
-        QString currentDateStr2 = EPGTime::getInstance()->currentDate().addDays(-2).toString("yyyyMMdd");
+        QStringList xmlFiles = directory.entryList({"*_PI.xml", "*_PI.epg"}, QDir::Files);
+        QString currentDateStr2 = EPGTime::getInstance()->currentDate().addDays(-METADATAMANAGER_EPG_RETENTION_DAYS).toString("yyyyMMdd");
         for (const QString & filename : xmlFiles)
         {
             if (filename.first(8) < currentDateStr2)
@@ -66,13 +85,27 @@ MetadataManager::~MetadataManager()
 
 
 void MetadataManager::processXML(const QString &xml, const QString &scopeId, uint16_t decoderId)
+{   // document is parsed in worker thread, result is applied to models in GUI thread in one step
+    bool isLoadingFromCache = m_isLoadingFromCache;
+    m_xmlParserPool->start([this, xml, scopeId, decoderId, isLoadingFromCache]() {
+        XmlContent content;
+        if (parseXML(xml, scopeId, content))
+        {
+            QMetaObject::invokeMethod(this, [this, xml, decoderId, isLoadingFromCache, content]() {
+                applyXML(content, xml, decoderId, isLoadingFromCache);
+            }, Qt::QueuedConnection);
+        }
+    });
+}
+
+bool MetadataManager::parseXML(const QString &xml, const QString &scopeId, XmlContent &content)
 {
     QDomDocument xmldocument;
     if (!xmldocument.setContent(xml, true))
     {
         qCWarning(metadataManager) << "Failed to parse SPI document";
         qCDebug(metadataManager) << xml;
-        return;
+        return false;
     }
 
     qCDebug(metadataManager) << qPrintable(xmldocument.toString());
@@ -101,8 +134,9 @@ void MetadataManager::processXML(const QString &xml, const QString &scopeId, uin
                             if ("service" == servicesElement.tagName())
                             {   // ETSI TS 102 818 V3.4.1 [6.5]
                                 // Service element describes metadata and available bearers for a service.
-                                QStringList sidList;
-                                serviceInfo_t serviceInfo;
+                                XmlServiceInfo xmlService;
+                                QStringList & sidList = xmlService.sidList;
+                                serviceInfo_t & serviceInfo = xmlService.info;
                                 QDomNode serviceNode = servicesElement.firstChild();
                                 while (!serviceNode.isNull())
                                 {   // ETSI TS 102 818 V3.4.1 [6.5]
@@ -199,7 +233,7 @@ void MetadataManager::processXML(const QString &xml, const QString &scopeId, uin
                                                                     QString filename = QString("%1/%2x%3.%4").arg(sidStr, width, height, ext);
                                                                     qCDebug(metadataManager) << url << "===>" << filename;
 
-                                                                    emit getFile(decoderId, url, filename);
+                                                                    xmlService.files.append(qMakePair(url, filename));
                                                                 }
                                                             }
                                                         }
@@ -211,10 +245,9 @@ void MetadataManager::processXML(const QString &xml, const QString &scopeId, uin
                                     }
                                     serviceNode = serviceNode.nextSibling();
                                 }
-                                for (const QString & sidStr : sidList)
-                                {   // insert in database
-                                    qCDebug(metadataManager) << sidStr << serviceInfo;
-                                    m_info.insert(sidStr, serviceInfo);
+                                if (!sidList.isEmpty())
+                                {   // inserted in database in GUI thread
+                                    content.services.append(xmlService);
                                 }
                             }
                             else if ("serviceProvider" == servicesElement.tagName())
@@ -279,42 +312,20 @@ void MetadataManager::processXML(const QString &xml, const QString &scopeId, uin
                 }
 
                 qCDebug(metadataManager) << "Service scope ID:" << scId;
-                if (!scId.isEmpty() && !scStart.isEmpty())
+                if (!scId.isEmpty() && !scStart.isEmpty() && bearerToServiceId(scId).isValid())
                 {
-                    ServiceListId id = bearerToServiceId(scId);
-                    if (id.isValid()) {
-                        bool valid = false;
-                        QDomElement child = element.firstChildElement("programme");
-                        while (!child.isNull())
-                        {
-                            valid = parseProgramme(child, id) || valid;
-                            child = child.nextSiblingElement("programme");
-                        }
-
-                        if (!m_isLoadingFromCache && valid)
-                        {   // save parsed file to the cache
-                            // "20140805_e1c221.0_PI.xml"
-                            QString filename = QString("%1/EPG/%2_%3.%4_PI.xml").arg(QStandardPaths::writableLocation(QStandardPaths::CacheLocation),
-                                                                                     QDateTime::fromString(scStart, Qt::ISODate).toUTC().toOffsetFromUtc(EPGTime::getInstance()->ltoSec()).toString("yyyyMMdd"))
-                                                   .arg(id.sid(), 6, 16, QChar('0')).arg(id.scids());
-
-
-
-                            QDir dir;
-                            dir.mkpath(QFileInfo(filename).absolutePath());
-                            QFile file(filename);
-                            if (!file.exists())
-                            {
-                                file.open(QIODevice::WriteOnly);
-                                QTextStream output(&file);
-                                output << xml;
-                                file.close();
-                            }
-                            else
-                            {
-                                // qDebug() << "!!!!!!!!!!!!!!!!!!!!!!!!! File EXISTS";
-                            }
-                        }
+                    SPIEpgSchedule schedule;
+                    schedule.scopeIdList.append(scId);
+                    schedule.scopeStart = QDateTime::fromString(scStart, Qt::ISODate);
+                    QDomElement child = element.firstChildElement("programme");
+                    while (!child.isNull())
+                    {
+                        parseProgramme(child, schedule.items);
+                        child = child.nextSiblingElement("programme");
+                    }
+                    if (!schedule.items.isEmpty())
+                    {
+                        content.schedules.append(schedule);
                     }
                 }
             }
@@ -327,26 +338,114 @@ void MetadataManager::processXML(const QString &xml, const QString &scopeId, uin
         qCInfo(metadataManager) << qPrintable(xmldocument.toString());
         qCInfo(metadataManager) << "<=====================================================";
     }
+
+    return !content.services.isEmpty() || !content.schedules.isEmpty();
 }
 
-bool MetadataManager::parseProgramme(const QDomElement &element, const ServiceListId & id)
+void MetadataManager::applyXML(const XmlContent &content, const QString &xml, uint16_t decoderId, bool isLoadingFromCache)
 {
-    bool ret = false;
+    for (const XmlServiceInfo & xmlService : content.services)
+    {
+        for (const auto & file : xmlService.files)
+        {
+            emit getFile(decoderId, file.first, file.second);
+        }
+        for (const QString & sidStr : xmlService.sidList)
+        {   // insert in database
+            qCDebug(metadataManager) << sidStr << xmlService.info;
+            m_info.insert(sidStr, xmlService.info);
+        }
+    }
+    if (!content.services.isEmpty())
+    {
+        m_infoBytes = 0;
+        for (auto it = m_info.cbegin(); it != m_info.cend(); ++it)
+        {
+            m_infoBytes += it.key().size() * sizeof(QChar);
+            for (auto infoIt = it.value().cbegin(); infoIt != it.value().cend(); ++infoIt)
+            {
+                m_infoBytes += (infoIt.key().size() + infoIt.value().size()) * sizeof(QChar);
+            }
+        }
+        updateMemory();
+    }
+
+    QHash<QString, QList<EPGModelItem>> cacheFiles;
+    for (const auto & schedule : content.schedules)
+    {
+        ServiceListId id = bearerToServiceId(schedule.scopeIdList.first());
+        QList<EPGModelItem> cacheItems;
+        if (addScheduleItems(id, schedule.items, cacheItems))
+        {   // save parsed file to the cache
+            // "20140805_e1c221.0_PI.xml"
+            QString filename = epgFileName(schedule.scopeStart, id);
+            if (!isLoadingFromCache)
+            {   // repeated versions are written only when changed
+                m_epgFileWriter->write(filename, xml.toUtf8());
+            }
+            else { /* XML was loaded from cache because binary cache is missing or outdated */ }
+
+            // binary cache is queued after XML so that it is not older than XML
+            cacheFiles[epgCacheFileName(filename)].append(cacheItems);
+        }
+    }
+
+    for (auto it = cacheFiles.cbegin(); it != cacheFiles.cend(); ++it)
+    {   // write binary cache so that next loading does not need XML parsing
+        // "20140805_e1c221.0_PI.epg" ==> "20140805_e1c221.0_PI.xml"
+        m_epgFileWriter->write(it.key(), EPGCache::serialize(it.value()), it.key().chopped(3) + "xml");
+    }
+}
+
+void MetadataManager::processEpgSchedule(const QList<SPIEpgSchedule> &scheduleList)
+{
+    QHash<QString, QList<EPGModelItem>> cacheFiles;
+    for (const auto & schedule : scheduleList)
+    {
+        ServiceListId id;
+        for (const QString & scId : schedule.scopeIdList)
+        {
+            id = bearerToServiceId(scId);
+            if (id.isValid())
+            {   // found valid DAB service scope
+                qCDebug(metadataManager) << "Service scope ID:" << scId;
+                break;
+            }
+        }
+
+        if (id.isValid() && schedule.scopeStart.isValid())
+        {
+            QList<EPGModelItem> cacheItems;
+            if (addScheduleItems(id, schedule.items, cacheItems))
+            {   // save decoded schedule to the cache
+                QString filename = epgCacheFileName(epgFileName(schedule.scopeStart, id));
+                cacheFiles[filename].append(cacheItems);
+            }
+        }
+        else { /* no valid scope */ }
+    }
+
+    for (auto it = cacheFiles.cbegin(); it != cacheFiles.cend(); ++it)
+    {   // repeated versions are written only when changed
+        m_epgFileWriter->write(it.key(), EPGCache::serialize(it.value()));
+    }
+}
 
+void MetadataManager::parseProgramme(const QDomElement &element, QList<EPGModelItem> & items)
+{
     // ETSI TS 102 818 V3.3.1 (2020-08) [7.8]
     // The location element may appear zero or more times within a programme or programmeEvent element.
-    QList<EPGModelItem *> itemList;
-    int ltoSec = EPGTime::getInstance()->ltoSec();
+    QList<EPGModelItem> itemList;
     QDomElement locationElement = element.firstChildElement("location");
     while (!locationElement.isNull())
     {
         QDomElement timeElement = locationElement.firstChildElement("time");
         while (!timeElement.isNull())
         {
-            EPGModelItem * progItem = new EPGModelItem;
+            EPGModelItem progItem;
 
-            QDateTime startTime = QDateTime::fromString(timeElement.attribute("time"), Qt::ISODate);
-            progItem->setStartTime(startTime.toUTC().toOffsetFromUtc(ltoSec));
+            // start time is converted to local time offset when items are added to model
+            progItem.setStartTime(QDateTime::fromString(timeElement.attribute("time"), Qt::ISODate));
 
             // ETSI TS 102 818 V3.3.1 (2020-08) [5.2.5 duration type]
             // Duration is based on the ISO 8601 [2] format: PTnHnMnS, where "T" represents the date/time separator,
@@ -363,15 +462,13 @@ bool MetadataManager::parseProgramme(const QDomElement &element, const ServiceLi
                 // seconds
                 duration += (match.captured(6).isEmpty() ? 0 : match.captured(6).toInt());
 
-                progItem->setDurationSec(duration);
-                progItem->setShortId(element.attribute("shortId").toInt());
+                progItem.setDurationSec(duration);
+                progItem.setShortId(element.attribute("shortId").toInt());
 
                 itemList.append(progItem);
             }
             else
-            {   // duration not valid
-                delete progItem;
-            }
+            {   /* duration not valid */ }
 
             timeElement = timeElement.nextSiblingElement("time");
         }
@@ -385,21 +482,21 @@ bool MetadataManager::parseProgramme(const QDomElement &element, const ServiceLi
         {
             for (auto & progItem : itemList)
             {
-                progItem->setLongName(child.text());
+                progItem.setLongName(child.text());
             }
         }
         else if ("mediumName" == child.tagName())
         {
             for (auto & progItem : itemList)
             {
-                progItem->setMediumName(child.text());
+                progItem.setMediumName(child.text());
             }
         }
         else if ("shortName" == child.tagName())
         {
             for (auto & progItem : itemList)
             {
-                progItem->setShortName(child.text());
+                progItem.setShortName(child.text());
             }
         }
         else if ("mediaDescription" == child.tagName())
@@ -413,6 +510,32 @@ bool MetadataManager::parseProgramme(const QDomElement &element, const ServiceLi
         child = child.nextSiblingElement();
     }
 
+    items.append(itemList);
+}
+
+bool MetadataManager::addScheduleItems(const ServiceListId &id, const QList<EPGModelItem> &items, QList<EPGModelItem> &cacheItems)
+{
+    int ltoSec = EPGTime::getInstance()->ltoSec();
+    QDate lastDate = EPGTime::getInstance()->currentDate().addDays(7);
+    QList<EPGModelItem *> itemList;
+    itemList.reserve(items.size());
+    for (const auto & item : items)
+    {
+        EPGModelItem * progItem = new EPGModelItem(item);
+        progItem->setStartTime(item.startTime().toUTC().toOffsetFromUtc(ltoSec));
+        if (progItem->startTime().date() < lastDate)
+        {   // copy items before they are passed to model
+            cacheItems.append(*progItem);
+        }
+        itemList.append(progItem);
+    }
+
+    return addEpgItems(id, itemList);
+}
+
+bool MetadataManager::addEpgItems(const ServiceListId &id, const QList<EPGModelItem *> &itemList)
+{
+    bool ret = false;
     if (!itemList.isEmpty())
     {
         if (m_epgList.value(id, nullptr) == nullptr)
@@ -424,42 +547,65 @@ bool MetadataManager::parseProgramme(const QDomElement &element, const ServiceLi
             emit epgAvailable();
         }
 
+        QList<EPGModelItem *> weekItems;
+        weekItems.reserve(itemList.size());
         for (auto & progItem : itemList)
         {
             if (progItem->startTime().date() < EPGTime::getInstance()->currentDate().addDays(7))
             {
                 addEpgDate(progItem->startTime().date());
-                ret = m_epgList[id]->addItem(progItem) || ret;
+                weekItems.append(progItem);
             }
             else
             {
                 delete progItem;
             }
         }
+
+        // model is updated in one pass, only changed programmes are notified
+        ret = m_epgList[id]->addItems(weekItems);
+        if (ret)
+        {
+            updateNowNext(id);
+        }
     }
 
     return ret;
 }
 
-void MetadataManager::parseDescription(const QDomElement &element, EPGModelItem *progItem)
+QString MetadataManager::epgFileName(const QDateTime &scopeStart, const ServiceListId &id) const
+{
+    // "20140805_e1c221.0_PI.xml"
+    return QString("%1/EPG/%2_%3.%4_PI.xml").arg(QStandardPaths::writableLocation(QStandardPaths::CacheLocation),
+                                                 scopeStart.toUTC().toOffsetFromUtc(EPGTime::getInstance()->ltoSec()).toString("yyyyMMdd"))
+        .arg(id.sid(), 6, 16, QChar('0')).arg(id.scids());
+}
+
+QString MetadataManager::epgCacheFileName(const QString &xmlFileName) const
+{
+    // "20140805_e1c221.0_PI.xml" ==> "20140805_e1c221.0_PI.epg"
+    return xmlFileName.chopped(3) + "epg";
+}
+
+void MetadataManager::parseDescription(const QDomElement &element, EPGModelItem &progItem)
 {
     QDomElement child = element.firstChildElement();
     while (!child.isNull())
     {
         if ("shortDescription" == child.tagName())
         {
-            progItem->setShortDescription(child.text().replace(QChar('\\'),QChar()).trimmed());
+            progItem.setShortDescription(child.text().replace(QChar('\\'),QChar()).trimmed());
         }
         else if ("longDescription" == child.tagName())
         {
-            progItem->setLongDescription(child.text().replace(QChar('\\') ,QChar()).trimmed());
+            progItem.setLongDescription(child.text().replace(QChar('\\') ,QChar()).trimmed());
         }
 
         child = child.nextSiblingElement();
     }
 }
 
-ServiceListId MetadataManager::bearerToServiceId(const QString &bearerUri) const
+ServiceListId MetadataManager::bearerToServiceId(const QString &bearerUri)
 {   // ETSI TS 103 270 V1.4.1 (2022-05) [5.1.2.4 Construction of bearerURI]
     // The bearerURI for a DAB/DAB+ service is compiled as follows:
     // dab:<gcc>.<eid>.<sid>.<scids>[.<uatype>]
@@ -486,8 +632,6 @@ void MetadataManager::onFileReceived(const QByteArray & data, const QString & re
     QString filename = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/"+ requestId;
     qCDebug(metadataManager) << requestId << filename;
 
-    static const QRegularExpression re("([0-9a-f]{6})\\.(\\d+)/(\\d+x\\d+)\\..*", QRegularExpression::CaseInsensitiveOption);
-
     QDir dir;
     dir.mkpath(QFileInfo(filename).absolutePath());
 
@@ -503,48 +647,45 @@ void MetadataManager::onFileReceived(const QByteArray & data, const QString & re
         QByteArray md5FileInCache = md5gen.result();
         md5gen.reset();
         md5gen.addData(data);
-        if (md5gen.result() != md5FileInCache)
-        {   // different file => overwrite
-            file.open(QIODevice::WriteOnly);
-            file.write(data);
-            file.close();
-
-            QRegularExpressionMatch match = re.match(requestId);
-            if (match.hasMatch())
-            {
-                uint32_t sid = match.captured(1).toUInt(nullptr, 16);
-                uint8_t scids = match.captured(2).toUInt();
-                QString size = match.captured(3);
-                MetadataRole role = MetadataRole::SLSLogo;
-                if (size == "32x32") {
-                    role = MetadataRole::SmallLogo;
-                }
-                emit dataUpdated(ServiceListId(sid, scids), role);
-            }
-        }
-        else
-        {   /* do nothing, file is the same */
+        if (md5gen.result() == md5FileInCache)
+        {   // do nothing, file is the same
             qCDebug(metadataManager) << filename << "is the same";
+            return;
         }
+        else
+        {   /* different file => overwrite */ }
     }
-    else
+
+    file.open(QIODevice::WriteOnly);
+    file.write(data);
+    file.close();
+
+    static const QRegularExpression re("([0-9a-f]{6})\\.(\\d+)/(\\d+x\\d+)\\..*", QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch match = re.match(requestId);
+    if (match.hasMatch())
     {
-        file.open(QIODevice::WriteOnly);
-        file.write(data);
-        file.close();
+        ServiceListId id(match.captured(1).toUInt(nullptr, 16), uint8_t(match.captured(2).toUInt()));
+        MetadataRole role = MetadataRole::SLSLogo;
+        if (match.captured(3) == "32x32") {
+            role = MetadataRole::SmallLogo;
+        }
 
-        QRegularExpressionMatch match = re.match(requestId);
-        if (match.hasMatch())
+        // decoded logo is not valid anymore
+        const QString key = logoKey(id, role);
+        m_logoCache.remove(key);
         {
-            uint32_t sid = match.captured(1).toUInt(nullptr, 16);
-            uint8_t scids = match.captured(2).toUInt();
-            QString size = match.captured(3);
-            MetadataRole role = MetadataRole::SLSLogo;
-            if (size == "32x32") {
-                role = MetadataRole::SmallLogo;
+            QMutexLocker locker(&m_logoImageMutex);
+            const QStringList keys = m_logoImageCache.keys();
+            for (const QString & sizedKey : keys)
+            {
+                if (sizedKey.startsWith(key + "@"))
+                {
+                    m_logoImageCache.remove(sizedKey);
+                }
             }
-            emit dataUpdated(ServiceListId(sid, scids), role);
         }
+        updateMemory();
+        emit dataUpdated(id, role);
     }
 }
 
@@ -555,52 +696,230 @@ QVariant MetadataManager::data(uint32_t sid, uint8_t SCIdS, MetadataRole role) c
 
 QVariant MetadataManager::data(const ServiceListId &id, MetadataRole role) const
 {
-    QString sidStr = QString("%1.%2").arg(id.sid(), 6, 16, QChar('0')).arg(id.scids());
     switch (role) {
     case SLSLogo:
+    case SmallLogo:
+        return QVariant(logo(id, role));
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+QPixmap MetadataManager::logo(const ServiceListId &id, MetadataRole role) const
+{
+    const QString key = logoKey(id, role);
+    const QPixmap * cached = m_logoCache.object(key);
+    if (nullptr != cached)
+    {   // pixmap is implicitly shared, no copy of image data
+        return *cached;
+    }
+
+    // not decoded yet, null pixmap is cached as well when logo is not available
+    QPixmap * pixmap = new QPixmap();
+    QString filename = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + key + ".";
+    if (QFileInfo::exists(filename+"png"))
+    {
+        pixmap->load(filename+"png");
+    }
+    else if (QFileInfo::exists(filename+"jpg"))
+    {
+        pixmap->load(filename+"jpg");
+    }
+    QPixmap ret = *pixmap;
+    m_logoCache.insert(key, pixmap, qMax(1LL, (pixmap->width() * pixmap->height() * pixmap->depth()) / (8LL * 1024)));
+    updateMemory();
+    return ret;
+}
+
+QImage MetadataManager::logoImage(const ServiceListId &id, MetadataRole role, const QSize &requestedSize) const
+{
+    const QString key = logoKey(id, role);
+    const QString sizedKey = QString("%1@%2x%3").arg(key).arg(requestedSize.width()).arg(requestedSize.height());
+    {
+        QMutexLocker locker(&m_logoImageMutex);
+        const QImage * cached = m_logoImageCache.object(sizedKey);
+        if (nullptr != cached)
+        {   // image is implicitly shared
+            return *cached;
+        }
+    }
+
+    // decoding is done without lock, null image is cached as well when logo is not available
+    QImage image;
+    QString filename = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + key + ".";
+    QImageReader reader;
+    if (QFileInfo::exists(filename+"png"))
+    {
+        reader.setFileName(filename+"png");
+    }
+    else if (QFileInfo::exists(filename+"jpg"))
+    {
+        reader.setFileName(filename+"jpg");
+    }
+    if (!reader.fileName().isEmpty())
+    {
+        QSize size = reader.size();
+        if (size.isValid() && (requestedSize.width() > 0) && (requestedSize.height() > 0)
+            && ((size.width() > requestedSize.width()) || (size.height() > requestedSize.height())))
+        {   // decoder scales while reading
+            reader.setScaledSize(size.scaled(requestedSize, Qt::KeepAspectRatio));
+        }
+        image = reader.read();
+    }
+
+    QMutexLocker locker(&m_logoImageMutex);
+    m_logoImageCache.insert(sizedKey, new QImage(image), qMax(qsizetype(1), image.sizeInBytes() / 1024));
+    return image;
+}
+
+void MetadataManager::updateMemory() const
+{   // logo cache cost is in kB
+    qint64 imageCacheKB;
     {
-        QString filename = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + QString("%1/320x240.").arg(sidStr);
-        if (QFileInfo::exists(filename+"png"))
+        QMutexLocker locker(&m_logoImageMutex);
+        imageCacheKB = m_logoImageCache.totalCost();
+    }
+    m_memory.set(m_infoBytes + (qint64(m_logoCache.totalCost()) + imageCacheKB) * 1024);
+}
+
+QString MetadataManager::logoKey(const ServiceListId &id, MetadataRole role) const
+{
+    return QString("%1.%2/%3").arg(id.sid(), 6, 16, QChar('0')).arg(id.scids()).arg((SmallLogo == role) ? "32x32" : "320x240");
+}
+
+EPGModel *MetadataManager::epgModel(const ServiceListId & id) const
+{
+    return m_epgList.value(id, nullptr);
+}
+
+const EPGModelItem *MetadataManager::currentProgramme(const ServiceListId &id) const
+{
+    EPGModel * model = m_epgList.value(id, nullptr);
+    if ((nullptr != model) && EPGTime::getInstance()->isValid())
+    {
+        return model->itemAt(EPGTime::getInstance()->secSinceEpoch());
+    }
+    return nullptr;
+}
+
+const EPGModelItem *MetadataManager::nextProgramme(const ServiceListId &id) const
+{
+    EPGModel * model = m_epgList.value(id, nullptr);
+    if ((nullptr != model) && EPGTime::getInstance()->isValid())
+    {
+        return model->nextItem(EPGTime::getInstance()->secSinceEpoch());
+    }
+    return nullptr;
+}
+
+QString MetadataManager::nowNextText(const ServiceListId &id) const
+{
+    QString text;
+    const EPGModelItem * item = currentProgramme(id);
+    if (nullptr != item)
+    {
+        text += QString("<br><b>"+tr("Now:")+"</b> %1 %2")
+                    .arg(EPGTime::getInstance()->timeLocale().toString(item->startTime(), QString("hh:mm")),
+                         item->longName().isEmpty() ? item->mediumName() : item->longName());
+    }
+    item = nextProgramme(id);
+    if (nullptr != item)
+    {
+        text += QString("<br><b>"+tr("Next:")+"</b> %1 %2")
+                    .arg(EPGTime::getInstance()->timeLocale().toString(item->startTime(), QString("hh:mm")),
+                         item->longName().isEmpty() ? item->mediumName() : item->longName());
+    }
+    return text;
+}
+
+void MetadataManager::onEpgTimeChanged()
+{
+    if (!EPGTime::getInstance()->isValid())
+    {   // time is not known
+        m_nowNextTimeSec = 0;
+        return;
+    }
+
+    qint64 secSinceEpoch = EPGTime::getInstance()->secSinceEpoch();
+
+    if (EPGTime::getInstance()->currentDate() != m_epgPruneDate)
+    {   // once per day
+        pruneEpg();
+    }
+    else { /* same day */ }
+
+    // all services are updated when time becomes valid or when it goes back (switching to raw file)
+    bool updateAll = (0 == m_nowNextTimeSec) || (secSinceEpoch < m_nowNextTimeSec);
+    m_nowNextTimeSec = secSinceEpoch;
+    if (!updateAll && ((0 == m_nowNextChangeSec) || (secSinceEpoch < m_nowNextChangeSec)))
+    {   // nothing changes
+        return;
+    }
+    else
+    { /* current or next programme changes for some services */ }
+
+    m_nowNextChangeSec = 0;
+    const QList<ServiceListId> idList = m_epgList.keys();
+    for (const auto & id : idList)
+    {
+        QHash<ServiceListId, NowNextEntry>::const_iterator it = m_nowNextList.constFind(id);
+        if (updateAll || (m_nowNextList.cend() == it) || (it->changeSec <= secSinceEpoch))
         {
-            QPixmap pixmap;
-            pixmap.load(filename+"png");
-            return QVariant(pixmap);
+            updateNowNext(id);
         }
-        else if (QFileInfo::exists(filename+"jpg"))
+        else if ((0 == m_nowNextChangeSec) || (it->changeSec < m_nowNextChangeSec))
         {
-            QPixmap pixmap;
-            pixmap.load(filename+"jpg");
-            return QVariant(pixmap);
+            m_nowNextChangeSec = it->changeSec;
         }
+        else
+        { /* later change */ }
     }
-    break;
-    case SmallLogo:
+}
+
+void MetadataManager::updateNowNext(const ServiceListId &id)
+{
+    const EPGModelItem * current = currentProgramme(id);
+    const EPGModelItem * next = nextProgramme(id);
+    if ((nullptr == current) && (nullptr == next))
     {
-        QString filename = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + QString("%1/32x32.").arg(sidStr);
-        if (QFileInfo::exists(filename+"png"))
+        if (m_nowNextList.remove(id))
         {
-            QPixmap pixmap;
-            pixmap.load(filename+"png");
-            return QVariant(pixmap);
+            emit dataUpdated(id, MetadataRole::NowNext);
         }
-        else if (QFileInfo::exists(filename+"jpg"))
-        {
-            QPixmap pixmap;
-            pixmap.load(filename+"jpg");
-            return QVariant(pixmap);
+        return;
+    }
+
+    NowNextEntry entry;
+    entry.currentStartSec = (nullptr != current) ? current->startTimeSecSinceEpoch() : 0;
+    entry.nextStartSec = (nullptr != next) ? next->startTimeSecSinceEpoch() : 0;
+    if (nullptr != next)
+    {
+        entry.changeSec = next->startTimeSecSinceEpoch();
+        if ((nullptr != current) && (current->endTimeSecSinceEpoch() < entry.changeSec))
+        {   // gap between programmes
+            entry.changeSec = current->endTimeSecSinceEpoch();
         }
     }
-    break;
-    default:
-        break;
+    else
+    {
+        entry.changeSec = current->endTimeSecSinceEpoch();
     }
 
-    return QVariant();
-}
+    QHash<ServiceListId, NowNextEntry>::const_iterator it = m_nowNextList.constFind(id);
+    bool isChanged = (m_nowNextList.cend() == it)
+                     || (it->currentStartSec != entry.currentStartSec) || (it->nextStartSec != entry.nextStartSec);
+    m_nowNextList.insert(id, entry);
+    if ((0 == m_nowNextChangeSec) || (entry.changeSec < m_nowNextChangeSec))
+    {
+        m_nowNextChangeSec = entry.changeSec;
+    }
 
-EPGModel *MetadataManager::epgModel(const ServiceListId & id) const
-{
-    return m_epgList.value(id, nullptr);
+    if (isChanged)
+    {
+        emit dataUpdated(id, MetadataRole::NowNext);
+    }
 }
 
 QStringList MetadataManager::epgDatesList() const
@@ -612,14 +931,25 @@ void MetadataManager::loadEpg(const ServiceListId &servId, const QList<uint32_t>
 {
     if (EPGTime::getInstance()->isValid() && servId.isValid())
     {
-        m_isLoadingFromCache = true;
+        m_isLoadingFromCache = true;   // XML documents found in cache are parsed asynchronously with this flag
+
+        // files received recently are read from disk
+        m_epgFileWriter->flush();
 
         QDir directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)  + "/EPG/");
         QDate currentDate = EPGTime::getInstance()->currentDate();
-        for (int day = -2; day < +7; ++day) {
+        for (int day = -METADATAMANAGER_EPG_RETENTION_DAYS; day < +7; ++day) {
             QDate date = currentDate.addDays(day);
             QString xmlFileName = QString("%1_%2.%3_PI.xml").arg(date.toString("yyyyMMdd")).arg(servId.sid(), 6, 16, QChar('0')).arg(servId.scids());
-            if (directory.exists(xmlFileName)) {
+            QString cacheFileName = directory.absolutePath() + "/" + epgCacheFileName(xmlFileName);
+            QList<EPGModelItem *> itemList;
+            if (EPGCache::isValid(cacheFileName, directory.absolutePath() + "/" + xmlFileName)
+                && EPGCache::read(cacheFileName, EPGTime::getInstance()->ltoSec(), itemList, true))
+            {   // binary cache is up to date ==> no XML parsing needed
+                qCDebug(metadataManager) << "Loading:" << cacheFileName;
+                addEpgItems(servId, itemList);
+            }
+            else if (directory.exists(xmlFileName)) {
                 QFile xmlfile(directory.absolutePath() + "/" + xmlFileName);
                 qCDebug(metadataManager) << "Loading:" << xmlfile.fileName();
                 if (xmlfile.open(QIODevice::ReadOnly | QIODevice::Text))
@@ -685,6 +1015,10 @@ void MetadataManager::removeServiceEpg(const ServiceListId &servId)
         delete m_epgList[servId];
         m_epgList.remove(servId);
         emit epgModelChanged(servId);
+        if (m_nowNextList.remove(servId))
+        {
+            emit dataUpdated(servId, MetadataRole::NowNext);
+        }
     }
     else
     {
@@ -714,6 +1048,40 @@ void MetadataManager::addEpgDate(const QDate &date)
     }    
 }
 
+void MetadataManager::pruneEpg()
+{
+    QDate currentDate = EPGTime::getInstance()->currentDate();
+    m_epgPruneDate = currentDate;
+
+    // local midnight of first day that is kept
+    qint64 secSinceEpoch = EPGTime::getInstance()->secSinceEpoch();
+    qint64 localSec = secSinceEpoch + EPGTime::getInstance()->ltoSec();
+    qint64 startSec = secSinceEpoch - (localSec % (24*3600)) - METADATAMANAGER_EPG_RETENTION_DAYS * 24*3600;
+
+    bool isChanged = false;
+    for (auto it = m_epgList.cbegin(); it != m_epgList.cend(); ++it)
+    {
+        isChanged = it.value()->removeItemsBefore(startSec) || isChanged;
+    }
+
+    QDate firstDate = currentDate.addDays(-METADATAMANAGER_EPG_RETENTION_DAYS);
+    bool datesChanged = false;
+    while (!m_epgDates.isEmpty() && (m_epgDates.firstKey() < firstDate))
+    {
+        m_epgDates.erase(m_epgDates.begin());
+        datesChanged = true;
+    }
+    if (datesChanged)
+    {
+        emit epgDatesListChanged();
+    }
+
+    if (isChanged)
+    {
+        qCDebug(metadataManager) << "Programmes ended before" << firstDate << "were removed from EPG";
+    }
+}
+
 QDate MetadataManager::epgDate(int idx) const {
     if ((idx < 0) || (idx >= m_epgDates.keys().size())) return QDate();
     return m_epgDates.keys().at(idx);
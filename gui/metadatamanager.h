@@ -31,8 +31,20 @@
 #include <QDomDocument>
 #include <QPixmap>
 #include <QHash>
+#include <QCache>
+#include <QThreadPool>
+#include <QImage>
+#include <QMutex>
 #include "servicelist.h"
 #include "epgmodel.h"
+#include "epgfilewriter.h"
+#include "spiepgdecoder.h"
+#include "diagnostics.h"
+
+#define METADATAMANAGER_LOGO_CACHE_KB  (16*1024)   // memory limit for decoded logos
+#define METADATAMANAGER_LOGO_IMAGE_CACHE_KB  (4*1024)   // memory limit for logos decoded for QML (requested sizes)
+#define METADATAMANAGER_XML_PARSER_THREADS  2        // worker threads parsing SI/PI documents
+#define METADATAMANAGER_EPG_RETENTION_DAYS  2        // past days kept in EPG models (and in cache)
 
 typedef QHash<QString, QString> serviceInfo_t;
 
@@ -48,17 +60,28 @@ public:
         ShortName,
         MediumName,
         LongName,
+        NowNext,        // notification only, current or next programme changed
     };
 
     explicit MetadataManager(const ServiceList * serviceList, QObject * parent = nullptr);
     ~MetadataManager();
     void processXML(const QString &xmldocument, const QString & scopeId, uint16_t decoderId);
+    void processEpgSchedule(const QList<SPIEpgSchedule> & scheduleList);
     void onFileReceived(const QByteArray & data, const QString & requestId);
     QVariant data(uint32_t sid, uint8_t SCIdS, MetadataManager::MetadataRole role) const;
     QVariant data(const ServiceListId & id, MetadataManager::MetadataRole role) const;
+    // thread safe, used by asynchronous QML image provider
+    // logo is decoded scaled to requested size (if it is smaller) and cached for that size, null image if not available
+    QImage logoImage(const ServiceListId & id, MetadataManager::MetadataRole role, const QSize & requestedSize) const;
 
     EPGModel *epgModel(const ServiceListId & id) const;
 
+    // current and next programme of the service, nullptr if not available
+    const EPGModelItem * currentProgramme(const ServiceListId & id) const;
+    const EPGModelItem * nextProgramme(const ServiceListId & id) const;
+    // rich text lines with current and next programme, empty if not available
+    QString nowNextText(const ServiceListId & id) const;
+
     Q_INVOKABLE QDate epgDate(int idx) const;
     QStringList epgDatesList() const;
 
@@ -82,20 +105,69 @@ signals:
 
 private:
     const ServiceList * m_serviceList;
+    EPGFileWriter * m_epgFileWriter;            // cache files are written in writer thread
     bool m_isLoadingFromCache;
     bool m_cleanEpgCache;
     QMap<QDate, QString> m_epgDates;
+    QDate m_epgPruneDate;                       // date of last removal of past programmes
     QHash<QString, serviceInfo_t> m_info;
     QHash<ServiceListId, EPGModel *> m_epgList;
     ServiceListId m_currentEnsemble;
 
-    bool parseProgramme(const QDomElement &element, const ServiceListId &id);
-    void parseDescription(const QDomElement &element, EPGModelItem *progItem);
+    // decoded logos, files are stored in cache location, key is "<sid>.<scids>/<size>"
+    mutable QCache<QString, QPixmap> m_logoCache;
+    // logos decoded in worker threads, key is "<logo key>@<width>x<height>"
+    mutable QMutex m_logoImageMutex;
+    mutable QCache<QString, QImage> m_logoImageCache;
+    mutable DiagnosticsMemoryCounter m_memory { DiagnosticsMemory::Metadata };
+    qint64 m_infoBytes = 0;
+
+    void updateMemory() const;
+
+    // content of SI/PI document parsed in worker thread
+    struct XmlServiceInfo
+    {
+        QStringList sidList;
+        serviceInfo_t info;
+        QList<QPair<QString, QString>> files;     // url and request ID of logos
+    };
+    struct XmlContent
+    {
+        QList<XmlServiceInfo> services;
+        QList<SPIEpgSchedule> schedules;
+    };
+    QThreadPool * m_xmlParserPool;
 
-    ServiceListId bearerToServiceId(const QString & bearerUri) const;
+    struct NowNextEntry
+    {
+        qint64 currentStartSec;
+        qint64 nextStartSec;
+        qint64 changeSec;       // time when current or next programme changes
+    };
+    QHash<ServiceListId, NowNextEntry> m_nowNextList;
+    qint64 m_nowNextChangeSec;  // earliest change of all services
+    qint64 m_nowNextTimeSec;    // time of last update
+
+    // parsing does not use any member data so that it can run in worker thread
+    static bool parseXML(const QString & xml, const QString & scopeId, XmlContent & content);
+    static void parseProgramme(const QDomElement &element, QList<EPGModelItem> & items);
+    static void parseDescription(const QDomElement &element, EPGModelItem &progItem);
+    static ServiceListId bearerToServiceId(const QString & bearerUri);
+    void applyXML(const XmlContent & content, const QString & xml, uint16_t decoderId, bool isLoadingFromCache);
+    bool addScheduleItems(const ServiceListId &id, const QList<EPGModelItem> & items, QList<EPGModelItem> & cacheItems);
+    bool addEpgItems(const ServiceListId &id, const QList<EPGModelItem *> &itemList);
+    QString epgFileName(const QDateTime & scopeStart, const ServiceListId & id) const;
+    QString epgCacheFileName(const QString & xmlFileName) const;
+
+    QPixmap logo(const ServiceListId & id, MetadataRole role) const;
+    QString logoKey(const ServiceListId & id, MetadataRole role) const;
 
     void loadEpg(const ServiceListId & servId, const QList<uint32_t> &ueidList);
     void addEpgDate(const QDate &date);
+    void pruneEpg();
+
+    void onEpgTimeChanged();
+    void updateNowNext(const ServiceListId & id);
 };
 
 #endif // METADATAMANAGER_H
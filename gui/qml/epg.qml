@@ -246,6 +246,8 @@ Item {
                                                     Image {
                                                         id: logoId
                                                         source: "image://metadata/"  + smallLogoId
+                                                        sourceSize: Qt.size(32, 32)
+                                                        asynchronous: true
                                                         cache: false
                                                     }
                                                 }
@@ -297,6 +299,11 @@ Item {
                                             id: epgTable
                                             property int dateIndex: index
                                             property bool needsToSetContentX: true
+                                            // programmes are instantiated only in visible time window extended by one step on each side
+                                            // window moves in steps so that delegates are not recreated on every scroll position
+                                            readonly property int windowStepSec: 3600
+                                            readonly property int windowStartSec: Math.max(0, (Math.floor(contentX / pointsPerSecond / windowStepSec) - 1) * windowStepSec)
+                                            readonly property int windowEndSec: (Math.ceil((contentX + width) / pointsPerSecond / windowStepSec) + 1) * windowStepSec
                                             contentWidth: colId.width
                                             contentHeight: colId.height
                                             boundsBehavior: Flickable.StopAtBounds
@@ -308,6 +315,10 @@ Item {
                                                 Repeater {
                                                     model: slProxyModel
                                                     Item {
+                                                        id: serviceRow
+                                                        // services out of vertical view do not instantiate programmes
+                                                        property bool isInView: ((y + height + lineHeight) > mainView.contentY)
+                                                                                && (y < (mainView.contentY + mainView.height + lineHeight))
                                                         height: lineHeight
                                                         anchors.left: parent.left
                                                         width: 24*3600 * pointsPerSecond
@@ -326,6 +337,8 @@ Item {
                                                                 id: proxyModel
                                                                 sourceModel: epgModelRole
                                                                 dateFilter: metadataManager.epgDate(epgTable.dateIndex)
+                                                                windowStartSec: serviceRow.isInView ? epgTable.windowStartSec : 0
+                                                                windowEndSec: serviceRow.isInView ? epgTable.windowEndSec : 0
                                                             }
 
                                                             Text {
@@ -335,7 +348,7 @@ Item {
                                                                 x: epgTable.contentX + 5
                                                                 text: qsTr("No program available")
                                                                 color: EPGColors.fadeTextColor
-                                                                visible: epgItemRepeater.count === 0
+                                                                visible: serviceRow.isInView && (epgItemRepeater.count === 0)
                                                             }
                                                             Repeater {
                                                                 id: epgItemRepeater
@@ -34,6 +34,9 @@
 #include <QRegularExpression>
 #include "radiocontrol.h"
 #include "inputdevice.h"
+#include "signaltelemetry.h"
+#include "shmexport.h"
+#include "diagnostics.h"
 
 //Q_LOGGING_CATEGORY(radioControl, "RadioControl", QtWarningMsg)
 Q_LOGGING_CATEGORY(radioControl, "RadioControl", QtInfoMsg)
@@ -49,7 +52,7 @@ RadioControl::RadioControl(QObject *parent) : QObject(parent)
 {
     m_dabsdrHandle = nullptr;
     m_frequency = 0;
-    m_serviceList.clear();
+    clearServiceList();
     m_serviceRequest.SId = m_serviceRequest.SCIdS = 0;
     m_ensembleConfigurationTimer = new QTimer(this);
     m_ensembleConfigurationTimer->setSingleShot(true);
@@ -62,7 +65,12 @@ RadioControl::RadioControl(QObject *parent) : QObject(parent)
     connect(m_currentService.announcement.timeoutTimer, &QTimer::timeout, this, &RadioControl::onAnnouncementTimeout);
     connect(this, &RadioControl::announcementAudioAvailable, this, &RadioControl::onAnnouncementAudioAvailable, Qt::QueuedConnection);
 
-    connect(this, &RadioControl::dabEvent, this, &RadioControl::onDabEvent, Qt::QueuedConnection);
+    m_serviceFollow.timer = new QTimer(this);
+    m_serviceFollow.timer->setSingleShot(true);
+    m_serviceFollow.timer->setInterval(RADIO_CONTROL_SERVICE_FOLLOW_HOLD_MS);
+    connect(m_serviceFollow.timer, &QTimer::timeout, this, &RadioControl::serviceFollowRequest);
+
+    connect(this, &RadioControl::dabEventsAvailable, this, &RadioControl::onDabEvents, Qt::QueuedConnection);
 }
 
 RadioControl::~RadioControl()
@@ -71,22 +79,30 @@ RadioControl::~RadioControl()
     delete m_ensembleConfigurationTimer;
     m_currentService.announcement.timeoutTimer->stop();
     delete m_currentService.announcement.timeoutTimer;
+    m_serviceFollow.timer->stop();
+    delete m_serviceFollow.timer;
 
     // this cancels dabsdr thread
     dabsdrDeinit(&m_dabsdrHandle);
 }
 
 // returns false if not successfull
-bool RadioControl::init()
+// receiver selects input FIFO, each receiver has its own input device
+bool RadioControl::init(int receiver)
 {
     if (EXIT_SUCCESS == dabsdrInit(&m_dabsdrHandle))
     {
-        dabsdrRegisterInputFcn(m_dabsdrHandle, getSamples);
-        dabsdrRegisterDummyInputFcn(m_dabsdrHandle, skipSamples);
+        // FIFO has to exist before DAB processing starts reading from it
+        m_receiver = receiver;
+        inputFifo(receiver);
+        dabsdrRegisterInputFcn(m_dabsdrHandle, getSamplesFcn(receiver));
+        dabsdrRegisterDummyInputFcn(m_dabsdrHandle, skipSamplesFcn(receiver));
         dabsdrRegisterNotificationCb(m_dabsdrHandle, dabNotificationCb, (void *) this);
         dabsdrRegisterDynamicLabelCb(m_dabsdrHandle, dynamicLabelCb, (void*) this);
         dabsdrRegisterDataGroupCb(m_dabsdrHandle, dataGroupCb, (void*) this);
         dabsdrRegisterAudioCb(m_dabsdrHandle, audioDataCb, this);
+        // AU buffers are preallocated before DAB processing starts
+        RadioControlAudioDataPool::getInstance();
         // this starts dab processing thread and retunrs
         dabsdr(m_dabsdrHandle);
     }
@@ -105,6 +121,20 @@ bool RadioControl::init()
     return true;
 }
 
+void RadioControl::onDabEvents()
+{
+    // events pushed from now on request new wakeup
+    m_eventQueue.clearWakeup();
+
+    // all pending events are handled in one call
+    RadioControlEvent * pEvent;
+    while (nullptr != (pEvent = m_eventQueue.pop()))
+    {
+        Diagnostics::getInstance()->addDelay(DiagnosticsMetric::EventQueueDelay, pEvent->timestampUs);
+        onDabEvent(pEvent);
+    }
+}
+
 void RadioControl::onDabEvent(RadioControlEvent * pEvent)
 {
     switch (pEvent->type)
@@ -118,7 +148,7 @@ void RadioControl::onDabEvent(RadioControlEvent * pEvent)
         switch (pEvent->resetFlag)
         {
         case DABSDR_RESET_INIT:
-            m_serviceList.clear();
+            clearServiceList();
             clearEnsemble();
             break;
         case DABSDR_RESET_NEW_EID:
@@ -155,8 +185,13 @@ void RadioControl::onDabEvent(RadioControlEvent * pEvent)
             else
             {   // tune is finished , notify HMI
                 emit tuneDone(pEvent->frequency);
+                m_syncLevel = DABSDR_SYNC_LEVEL_NO_SYNC;
                 emit signalState(uint8_t(DabSyncLevel::NoSync), 0.0);
 
+                // hold time of service following starts with every tune
+                m_serviceFollow.timer->stop();
+                serviceFollowUpdate(true);
+
                 // this is to request autontf when EID changes
                 m_enaAutoNotification = false;
 
@@ -185,7 +220,8 @@ void RadioControl::onDabEvent(RadioControlEvent * pEvent)
 
         emit ensembleReconfiguration(m_ensemble);
 
-        m_serviceList.clear();
+        // service list is kept, new configuration is compared with it when it arrives
+        // unaffected components keep their state (user applications, automatically enabled data services)
 
         // request service list
         // ETSI EN 300 401 V2.1.1 (2017-01) [6.1]
@@ -235,13 +271,26 @@ void RadioControl::onDabEvent(RadioControlEvent * pEvent)
         if (DABSDR_NSTAT_SUCCESS == pEvent->status)
         {
             qCDebug(radioControl) <<  "RadioControlEvent::SERVICE_SELECTION success";
+            if ((DABSDR_ID_AUDIO_PRIMARY == pEvent->decoderId) && (m_warmStart.SId == pEvent->SId) && (m_warmStart.SCIdS == pEvent->SCIdS)
+                && (m_serviceRequest.SId == pEvent->SId) && (m_serviceRequest.SCIdS == pEvent->SCIdS))
+            {   // service selected from cached configuration, received configuration is only compared
+                m_serviceRequest.SId = 0;
+            }
             eventHandler_serviceSelection(pEvent);
         }        
         else
         {
             if (pEvent->decoderId == DABSDR_ID_AUDIO_PRIMARY)
             {
-                qCWarning(radioControl) << "RadioControlEvent::SERVICE_SELECTION error" << pEvent->status;
+                if ((m_warmStart.SId == pEvent->SId) && (m_warmStart.SCIdS == pEvent->SCIdS))
+                {   // FIC is not complete yet, request is kept and service is selected when its component is received
+                    qCDebug(radioControl) << "Warm start failed" << pEvent->status;
+                    m_warmStart.SId = 0;
+                }
+                else
+                {
+                    qCWarning(radioControl) << "RadioControlEvent::SERVICE_SELECTION error" << pEvent->status;
+                }
                 if (m_isReconfigurationOngoing)
                 {
                     if (isCurrentService(pEvent->SId, pEvent->SCIdS))
@@ -303,9 +352,28 @@ void RadioControl::onDabEvent(RadioControlEvent * pEvent)
         }
         updateSignalState(pData->syncLevel, pData->snr10);
 
-        emit freqOffset(pData->freqOffset*0.1);
-        emit fibCounter(RADIO_CONTROL_NOTIFICATION_FIB_EXPECTED, pData->fibErrorCntr);
-        emit mscCounter(pData->mscCrcOkCntr, pData->mscCrcErrorCntr);
+        // periodic values are pulled by GUI, telemetry shows primary receiver only
+        if (0 == m_receiver)
+        {
+            SignalTelemetryRecord record;
+            record.timestampMs = QDateTime::currentMSecsSinceEpoch();
+            record.sync = uint8_t(syncLevel(pData->syncLevel));
+            record.snr = (DABSDR_SYNC_LEVEL_NO_SYNC == pData->syncLevel) ? 0.0 : pData->snr10/10.0;
+            record.freqOffset = pData->freqOffset*0.1;
+            record.fibExpected = RADIO_CONTROL_NOTIFICATION_FIB_EXPECTED;
+            record.fibErrors = pData->fibErrorCntr;
+            record.mscCorrect = pData->mscCrcOkCntr;
+            record.mscErrors = pData->mscCrcErrorCntr;
+            SignalTelemetry::getInstance()->push(record);
+
+            SharedMemoryExport * shm = SharedMemoryExport::instance();
+            if (nullptr != shm)
+            {
+                record.agcGain = SignalTelemetry::getInstance()->agcGain();
+                shm->writeTelemetry(record);
+            }
+        }
+        else { /* other receivers report signal state only */ }
 
         qCDebug(radioControl, "AutoNotify: sync %d, freq offset = %.1f Hz, SNR = %.1f dB",
                pData->syncLevel, pData->freqOffset*0.1, pData->snr10/10.0);
@@ -361,8 +429,6 @@ void RadioControl::onDabEvent(RadioControlEvent * pEvent)
         {
             emit dlDataGroup_Announcement(pEvent->pDynamicLabelData->data);
         }
-
-        delete pEvent->pDynamicLabelData;
     }
         break;
     case RadioControlEventType::USERAPP_DATA:
@@ -378,12 +444,29 @@ void RadioControl::onDabEvent(RadioControlEvent * pEvent)
             emit userAppData_Announcement(*(pEvent->pUserAppData));
             break;
         default:
-            // data services started automatically by primary service
-            emit userAppData_Service(*(pEvent->pUserAppData));
+        {
+            auto subscriptionIt = m_dataSubscriptions.constFind(pEvent->pUserAppData->SCId);
+            if (m_dataSubscriptions.cend() != subscriptionIt)
+            {   // subscribed data service
+                emit userAppData_Subscription(*(pEvent->pUserAppData));
+
+                serviceConstIterator serviceIt = m_serviceList.constFind(subscriptionIt->SId);
+                if (serviceIt != m_serviceList.cend())
+                {
+                    serviceComponentConstIterator scIt = serviceIt->serviceComponents.constFind(subscriptionIt->SCIdS);
+                    if ((scIt != serviceIt->serviceComponents.cend()) && scIt->autoEnabled)
+                    {   // also used by current service
+                        emit userAppData_Service(*(pEvent->pUserAppData));
+                    }
+                }
+            }
+            else
+            {   // data services started automatically by primary service
+                emit userAppData_Service(*(pEvent->pUserAppData));
+            }
+        }
             break;
         }
-
-        delete pEvent->pUserAppData;
     }
         break;
 
@@ -391,7 +474,7 @@ void RadioControl::onDabEvent(RadioControlEvent * pEvent)
         qCWarning(radioControl) << "ERROR: Unsupported event" << int(pEvent->type);
     }
 
-    delete pEvent;
+    m_eventQueue.release(pEvent);
 }
 
 void RadioControl::exit()
@@ -411,7 +494,7 @@ void RadioControl::start(uint32_t freq)
         m_frequency = freq;
         m_syncLevel = DABSDR_SYNC_LEVEL_NO_SYNC;
         emit signalState(uint8_t(DabSyncLevel::NoSync), 0.0);
-        m_serviceList.clear();
+        clearServiceList();
         clearEnsemble();
         dabTune(freq);
     }
@@ -450,7 +533,11 @@ void RadioControl::tuneService(uint32_t freq, uint32_t SId, uint8_t SCIdS)
             else
             {   // there is no pending request
                 // stop any service running in secondary instance (announcment)
-                dabsdrRequest_ServiceStop(m_dabsdrHandle, 0, 0, DABSDR_ID_AUDIO_SECONDARY);
+                if (!m_audioSubscriptionActive)
+                {
+                    dabsdrRequest_ServiceStop(m_dabsdrHandle, 0, 0, DABSDR_ID_AUDIO_SECONDARY);
+                }
+                else { /* secondary instance is used by subscription */ }
 
                 // remove automatically enabled data services
                 auto serviceIt = m_serviceList.constFind(m_currentService.SId);
@@ -458,7 +545,7 @@ void RadioControl::tuneService(uint32_t freq, uint32_t SId, uint8_t SCIdS)
                 {   // service is in the list
                     for (auto & sc : serviceIt->serviceComponents)
                     {
-                        if (sc.autoEnabled)
+                        if (sc.autoEnabled && !isSubscribed(m_currentService.SId, sc.SCIdS))
                         {   // request stop
                             dabServiceStop(m_currentService.SId, sc.SCIdS, DABSDR_ID_DATA);
                         }
@@ -484,6 +571,7 @@ void RadioControl::tuneService(uint32_t freq, uint32_t SId, uint8_t SCIdS)
 
         // reset current service - tuning resets dab process
         resetCurrentService();
+        clearSubscriptions();
 
         m_serviceRequest.SId = SId;
         m_serviceRequest.SCIdS = SCIdS;
@@ -495,21 +583,27 @@ void RadioControl::tuneService(uint32_t freq, uint32_t SId, uint8_t SCIdS)
      }
 }
 
-void RadioControl::updateSignalState(dabsdrSyncLevel_t s, int16_t snr10)
-{   
-    m_syncLevel = s;
-    switch (m_syncLevel)
+DabSyncLevel RadioControl::syncLevel(dabsdrSyncLevel_t s)
+{
+    switch (s)
     {
-    case DABSDR_SYNC_LEVEL_NO_SYNC:
-        emit signalState(uint8_t(DabSyncLevel::NoSync), 0.0);
-        break;
     case DABSDR_SYNC_LEVEL_ON_NULL:
-        emit signalState(uint8_t(DabSyncLevel::NullSync), snr10/10.0);
-        break;
+        return DabSyncLevel::NullSync;
     case DABSDR_SYNC_LEVEL_FIC:
-        emit signalState(uint8_t(DabSyncLevel::FullSync), snr10/10.0);
-        break;
+        return DabSyncLevel::FullSync;
+    default:
+        return DabSyncLevel::NoSync;
     }
+}
+
+void RadioControl::updateSignalState(dabsdrSyncLevel_t s, int16_t snr10)
+{   
+    if (s != m_syncLevel)
+    {   // only sync changes are signalled, periodic SNR is in telemetry
+        m_syncLevel = s;
+        emit signalState(uint8_t(syncLevel(m_syncLevel)), (DABSDR_SYNC_LEVEL_NO_SYNC == m_syncLevel) ? 0.0 : snr10/10.0);
+    }
+    serviceFollowUpdate((DABSDR_SYNC_LEVEL_FIC != m_syncLevel) || (snr10 < m_serviceFollow.snrThreshold10));
 
     if ((m_syncLevel > DABSDR_SYNC_LEVEL_NO_SYNC) && (!m_enaAutoNotification))
     {
@@ -519,35 +613,175 @@ void RadioControl::updateSignalState(dabsdrSyncLevel_t s, int16_t snr10)
     }
 }
 
+void RadioControl::setServiceFollowing(bool ena, float snrThreshold, int holdMs)
+{
+    m_serviceFollow.enabled = ena;
+    m_serviceFollow.snrThreshold10 = int16_t(qRound(snrThreshold * 10));
+    m_serviceFollow.timer->setInterval(holdMs);
+    if (!ena)
+    {
+        m_serviceFollow.timer->stop();
+    }
+}
+
+void RadioControl::serviceFollowUpdate(bool isSignalBad)
+{
+    if (!m_serviceFollow.enabled || (0 != m_receiver))
+    {
+        return;
+    }
+
+    if (!isSignalBad)
+    {
+        m_serviceFollow.timer->stop();
+    }
+    else if (!m_serviceFollow.timer->isActive() && (0 != m_frequency) && ((0 != m_currentService.SId) || (0 != m_serviceRequest.SId)))
+    {   // request is emitted when signal does not recover within hold time
+        // it is repeated while periodic notifications report bad signal, GUI decides about retuning
+        m_serviceFollow.timer->start();
+    }
+    else { /* already waiting or no service selected */ }
+}
+
 bool RadioControl::getCurrentAudioServiceComponent(serviceComponentIterator &scIt)
 {
-    for (auto & service : m_serviceList)
+    serviceIterator serviceIt = m_serviceList.find(m_currentService.SId);
+    if (m_serviceList.end() != serviceIt)
     {
-        if (service.SId.value() == m_currentService.SId)
-        {
-            scIt = service.serviceComponents.find(m_currentService.SCIdS);
-            return (service.serviceComponents.end() != scIt);
-        }
+        scIt = serviceIt->serviceComponents.find(m_currentService.SCIdS);
+        return (serviceIt->serviceComponents.end() != scIt);
     }
     return false;
 }
 
 bool RadioControl::cgetCurrentAudioServiceComponent(serviceComponentConstIterator &scIt) const
 {
-    for (const auto & service : m_serviceList)
+    serviceConstIterator serviceIt = m_serviceList.constFind(m_currentService.SId);
+    if (m_serviceList.cend() != serviceIt)
+    {
+        scIt = serviceIt->serviceComponents.constFind(m_currentService.SCIdS);
+        return (serviceIt->serviceComponents.cend() != scIt);
+    }
+    return false;
+}
+
+void RadioControl::clearServiceList()
+{
+    m_serviceList.clear();
+    m_audioSubChIndex.clear();
+    m_warmStart.SId = 0;
+}
+
+void RadioControl::warmStart()
+{   // ensemble information was received, service list is not known yet
+#if (RADIO_CONTROL_WARM_START)
+    if ((0 == m_serviceRequest.SId) || m_serviceList.contains(m_serviceRequest.SId))
+    {   // nothing requested or service is already known
+        return;
+    }
+
+    auto ensIt = m_warmStartCache.constFind(m_ensemble.frequency);
+    if ((m_warmStartCache.cend() == ensIt) || (ensIt->ueid != m_ensemble.ueid))
+    {   // unknown or different ensemble
+        return;
+    }
+    serviceConstIterator serviceIt = ensIt->serviceList.constFind(m_serviceRequest.SId);
+    if (ensIt->serviceList.cend() == serviceIt)
+    {
+        return;
+    }
+    serviceComponentConstIterator scIt = serviceIt->serviceComponents.constFind(m_serviceRequest.SCIdS);
+    if ((serviceIt->serviceComponents.cend() == scIt) || !scIt->isAudioService())
     {
-        if (service.SId.value() == m_currentService.SId)
+        return;
+    }
+
+    qCInfo(radioControl, "Warm start: %6.6X : %d from cached configuration", m_serviceRequest.SId, m_serviceRequest.SCIdS);
+    m_warmStart.SId = m_serviceRequest.SId;
+    m_warmStart.SCIdS = m_serviceRequest.SCIdS;
+    m_warmStart.component = *scIt;
+    m_warmStart.component.userApps.clear();     // requested when service is selected
+
+    // cached service is replaced when service list is received
+    RadioControlService service = *serviceIt;
+    service.serviceComponents.clear();
+    service.serviceComponents.insert(m_warmStart.SCIdS, m_warmStart.component);
+    m_serviceList.insert(m_warmStart.SId, service);
+    updateSubChIndex(service);
+
+    dabServiceSelection(m_warmStart.SId, m_warmStart.SCIdS, DABSDR_ID_AUDIO_PRIMARY);
+#endif
+}
+
+void RadioControl::updateSubChIndex(const RadioControlService &service)
+{
+    removeFromSubChIndex(service.SId.value());
+    if (service.SId.isProgServiceId())
+    {   // only programme audio is indexed
+        for (const auto & sc : service.serviceComponents)
         {
-            scIt = service.serviceComponents.constFind(m_currentService.SCIdS);
-            return (service.serviceComponents.cend() != scIt);
+            if (sc.isAudioService())
+            {
+                m_audioSubChIndex.insert(sc.SubChId, qMakePair(service.SId.value(), sc.SCIdS));
+            }
         }
     }
+}
+
+bool RadioControl::isSameComponentConfiguration(const RadioControlServiceComponent &a, const RadioControlServiceComponent &b)
+{
+    if ((a.SubChId != b.SubChId) || (a.SubChAddr != b.SubChAddr) || (a.SubChSize != b.SubChSize)
+        || (a.TMId != b.TMId) || (a.ps != b.ps) || (a.lang != b.lang) || (a.CAflag != b.CAflag) || (a.CAId != b.CAId)
+        || (a.protection.level != b.protection.level) || (a.protection.codeRateFecValue != b.protection.codeRateFecValue)
+        || (a.pty.s != b.pty.s) || (a.pty.d != b.pty.d) || (a.label != b.label) || (a.labelShort != b.labelShort))
+    {
+        return false;
+    }
+    switch (a.TMId)
+    {
+    case DabTMId::StreamAudio:
+    case DabTMId::StreamData:
+        return (a.streamAudioData.scType == b.streamAudioData.scType) && (a.streamAudioData.bitRate == b.streamAudioData.bitRate);
+    case DabTMId::PacketData:
+        return (a.packetData.DSCTy == b.packetData.DSCTy) && (a.packetData.SCId == b.packetData.SCId)
+               && (a.packetData.DGflag == b.packetData.DGflag) && (a.packetData.packetAddress == b.packetData.packetAddress);
+    }
     return false;
 }
 
+void RadioControl::removeFromSubChIndex(uint32_t SId)
+{   // there are at most 64 subchannels, entries of other services sharing subchannel are kept
+    auto it = m_audioSubChIndex.begin();
+    while (it != m_audioSubChIndex.end())
+    {
+        if (it->first == SId)
+        {
+            it = m_audioSubChIndex.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
 void RadioControl::getEnsembleConfiguration()
 {
-    emit ensembleConfiguration(ensembleConfigurationString());
+    RadioControlEnsembleConfiguration config;
+    ensembleConfigurationDiff(config);
+
+    // full configuration
+    config.reset = true;
+    config.removed.clear();
+    if (m_ensembleConfigurationHeader.isEmpty())
+    {
+        config.services.clear();
+    }
+    else
+    {
+        config.services = m_ensembleConfigurationCache;
+    }
+    emit ensembleConfiguration(config);
 }
 
 void RadioControl::startUserApplication(DabUserApplicationType uaType, bool start, bool singleChannel)
@@ -589,7 +823,7 @@ void RadioControl::startUserApplication(DabUserApplicationType uaType, bool star
                                DabTables::getUserApplicationName(uaType).toLocal8Bit().data(), sc.SCIdS);
                         dabServiceSelection(sc.SId.value(), sc.SCIdS, DABSDR_ID_DATA);
                     }
-                    else
+                    else if (!isSubscribed(sc.SId.value(), sc.SCIdS))
                     {
                         dabServiceStop(sc.SId.value(), sc.SCIdS, DABSDR_ID_DATA);
                     }
@@ -618,7 +852,7 @@ void RadioControl::startUserApplication(DabUserApplicationType uaType, bool star
                                        DabTables::getUserApplicationName(uaType).toLocal8Bit().data(), sc.SId.value(), sc.SCIdS);
                                 dabServiceSelection(sc.SId.value(), sc.SCIdS, DABSDR_ID_DATA);
                             }
-                            else
+                            else if (!isSubscribed(sc.SId.value(), sc.SCIdS))
                             {
                                 dabServiceStop(sc.SId.value(), sc.SCIdS, DABSDR_ID_DATA);
                             }
@@ -684,7 +918,163 @@ void RadioControl::onSpiApplicationEnabled(bool enabled)
     }
 }
 
-QString RadioControl::ensembleConfigurationString() const
+void RadioControl::setLowPowerMode(bool ena)
+{
+    if (ena == m_lowPowerMode)
+    {
+        return;
+    }
+    m_lowPowerMode = ena;
+
+    if (0 == m_currentService.SId)
+    {   // no service is decoded, FIC processing continues
+        return;
+    }
+
+    if (ena)
+    {
+        qCInfo(radioControl) << "Low power mode: MSC decoding of current service is stopped";
+
+        // announcement switching is not performed in low power mode
+        if (RadioControlAnnouncementState::None != m_currentService.announcement.state)
+        {
+            onAnnouncementTimeout();
+        }
+
+        // XPAD applications and data services started automatically, subscriptions are kept
+        startUserApplication(DabUserApplicationType::SlideShow, false, false);
+        startUserApplication(DabUserApplicationType::SPI, false, false);
+
+        // current service is kept, it is selected again when low power mode ends
+        dabServiceStop(m_currentService.SId, m_currentService.SCIdS, DABSDR_ID_AUDIO_PRIMARY);
+        emit stopAudio();
+    }
+    else
+    {   // user applications are started when user application list is received after selection
+        qCInfo(radioControl) << "Low power mode: MSC decoding of current service is resumed";
+        dabServiceSelection(m_currentService.SId, m_currentService.SCIdS, DABSDR_ID_AUDIO_PRIMARY);
+    }
+}
+
+void RadioControl::subscribeServiceComponent(uint32_t SId, uint8_t SCIdS)
+{
+    serviceConstIterator serviceIt = m_serviceList.constFind(SId);
+    if (m_serviceList.cend() == serviceIt)
+    {
+        qCWarning(radioControl, "Subscription: service %6.6X not found", SId);
+        return;
+    }
+    serviceComponentConstIterator scIt = serviceIt->serviceComponents.constFind(SCIdS);
+    if (serviceIt->serviceComponents.cend() == scIt)
+    {
+        qCWarning(radioControl, "Subscription: service component %6.6X : %d not found", SId, SCIdS);
+        return;
+    }
+    if (isSubscribed(SId, SCIdS))
+    {   // nothing to do
+        return;
+    }
+
+    if (scIt->isAudioService())
+    {
+        if (isCurrentService(SId, SCIdS))
+        {   // current service is decoded already
+            qCInfo(radioControl, "Subscription: %6.6X : %d is current service", SId, SCIdS);
+            return;
+        }
+        if (m_audioSubscriptionActive || m_currentService.announcement.isOtherService
+            || (AnnouncementSwitchState::NoAnnouncement != m_currentService.announcement.switchState))
+        {   // secondary instance is busy
+            qCWarning(radioControl, "Subscription: no audio instance available for %6.6X : %d", SId, SCIdS);
+            return;
+        }
+        m_audioSubscription.SId = SId;
+        m_audioSubscription.SCIdS = SCIdS;
+        m_audioSubscriptionActive = true;
+        dabServiceSelection(SId, SCIdS, DABSDR_ID_AUDIO_SECONDARY);
+    }
+    else if (scIt->isDataPacketService())
+    {
+        m_dataSubscriptions.insert(scIt->packetData.SCId, { SId, SCIdS });
+        if (scIt->autoEnabled)
+        {   // already running
+            emit subscriptionStarted(*scIt);
+        }
+        else
+        {
+            dabServiceSelection(SId, SCIdS, DABSDR_ID_DATA);
+        }
+    }
+    else
+    {
+        qCWarning(radioControl, "Subscription: stream data service %6.6X : %d is not supported", SId, SCIdS);
+    }
+}
+
+void RadioControl::unsubscribeServiceComponent(uint32_t SId, uint8_t SCIdS)
+{
+    if (m_audioSubscriptionActive && (m_audioSubscription.SId == SId) && (m_audioSubscription.SCIdS == SCIdS))
+    {
+        m_audioSubscriptionActive = false;
+        dabsdrRequest_ServiceStop(m_dabsdrHandle, SId, SCIdS, DABSDR_ID_AUDIO_SECONDARY);
+        emit subscriptionStopped(SId, SCIdS);
+        return;
+    }
+
+    for (auto it = m_dataSubscriptions.begin(); it != m_dataSubscriptions.end(); ++it)
+    {
+        if ((it->SId == SId) && (it->SCIdS == SCIdS))
+        {
+            m_dataSubscriptions.erase(it);
+
+            bool autoEnabled = false;
+            serviceConstIterator serviceIt = m_serviceList.constFind(SId);
+            if (m_serviceList.cend() != serviceIt)
+            {
+                serviceComponentConstIterator scIt = serviceIt->serviceComponents.constFind(SCIdS);
+                autoEnabled = (serviceIt->serviceComponents.cend() != scIt) && scIt->autoEnabled;
+            }
+            if (!autoEnabled)
+            {   // service is not used by current service user applications
+                dabServiceStop(SId, SCIdS, DABSDR_ID_DATA);
+            }
+            emit subscriptionStopped(SId, SCIdS);
+            return;
+        }
+    }
+}
+
+bool RadioControl::isSubscribed(uint32_t sid, uint8_t scids) const
+{
+    if (m_audioSubscriptionActive && (m_audioSubscription.SId == sid) && (m_audioSubscription.SCIdS == scids))
+    {
+        return true;
+    }
+    for (const auto & subscription : m_dataSubscriptions)
+    {
+        if ((subscription.SId == sid) && (subscription.SCIdS == scids))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RadioControl::clearSubscriptions()
+{   // called when tuning, dab process is reset
+    if (m_audioSubscriptionActive)
+    {
+        m_audioSubscriptionActive = false;
+        emit subscriptionStopped(m_audioSubscription.SId, m_audioSubscription.SCIdS);
+    }
+    for (const auto & subscription : m_dataSubscriptions)
+    {
+        emit subscriptionStopped(subscription.SId, subscription.SCIdS);
+    }
+    m_dataSubscriptions.clear();
+}
+
+QString RadioControl::ensembleConfigurationHeader() const
 {
     if (0 == m_serviceList.size())
     {
@@ -710,225 +1100,274 @@ QString RadioControl::ensembleConfigurationString() const
     strOut << "<dt>";
     strOut << QString("Services (%1):").arg(m_serviceList.size());
     strOut << "</dt>";
+    strOut << "</dl>";
 
-    for (auto const & s : m_serviceList)
-    {
-        strOut << "<dd>";
+    strOut.flush();
 
-        strOut << "<dl>";
-        strOut << "<dt>";
-        if (s.SId.isProgServiceId())
-        {   // programme service
-            strOut << QString("0x%1 <b>%2</b> [ <i>%3</i> ] ECC: 0x%4, Country: %5,")
-                              .arg(QString("%1").arg(s.SId.progSId(), 4, 16, QChar('0')).toUpper())
-                              .arg(s.label)
-                              .arg(s.labelShort)
-                              .arg(QString("%1").arg(s.SId.ecc(), 2, 16, QChar('0')).toUpper())
-                              .arg(DabTables::getCountryNameEnglish(s.SId.value()));
-
-            // ETSI EN 300 401 V2.1.1 [8.1.5]
-            // At any one time, the PTy shall be either Static or Dynamic;
-            // there shall be only one PTy per service.
-            if (s.pty.d != 0)
-            {
-                strOut << QString(" PTy: %1 (dynamic), ").arg(DabTables::getPtyNameEnglish(s.pty.d));
-            }
-            else
-            {
-                strOut << QString(" PTy: %1 (static), ").arg(DabTables::getPtyNameEnglish(s.pty.s));
-            }
-            if (0 == s.ASu)
-            {
-                strOut << "Announcements: No";
-            }
-            else
-            {
-                strOut << "Announcements: ";
-                for (int b = 0; b < 16; ++b)
-                {
-                    if ((1 << b) & s.ASu)
-                    {
-                        strOut << DabTables::getAnnouncementNameEnglish(static_cast<DabAnnouncement>(b)) << ", ";
-                    }
-                }
-                strOut << QString("Cluster IDs [");
-                strOut << QString("%1").arg(s.clusterIds.at(0), 2, 16, QLatin1Char('0')).toUpper();
-                for (int d = 1; d < s.clusterIds.size(); ++d)
-                {
-                    strOut << QString(" %1").arg(s.clusterIds.at(d), 2, 16, QLatin1Char('0')).toUpper();
-                }
-                strOut << "]";
-            }
+    return output;
+}
+
+QString RadioControl::serviceConfigurationString(const RadioControlService & s) const
+{
+    QString output;
+    QTextStream strOut(&output, QIODevice::Text);
+
+    strOut << "<dl><dd>";
+
+    strOut << "<dl>";
+    strOut << "<dt>";
+    if (s.SId.isProgServiceId())
+    {   // programme service
+        strOut << QString("0x%1 <b>%2</b> [ <i>%3</i> ] ECC: 0x%4, Country: %5,")
+                          .arg(QString("%1").arg(s.SId.progSId(), 4, 16, QChar('0')).toUpper())
+                          .arg(s.label)
+                          .arg(s.labelShort)
+                          .arg(QString("%1").arg(s.SId.ecc(), 2, 16, QChar('0')).toUpper())
+                          .arg(DabTables::getCountryNameEnglish(s.SId.value()));
+
+        // ETSI EN 300 401 V2.1.1 [8.1.5]
+        // At any one time, the PTy shall be either Static or Dynamic;
+        // there shall be only one PTy per service.
+        if (s.pty.d != 0)
+        {
+            strOut << QString(" PTy: %1 (dynamic), ").arg(DabTables::getPtyNameEnglish(s.pty.d));
         }
         else
-        {   // data service
-            strOut << QString("0x%1 <b>%2</b> [ <i>%3</i> ]")
-                   .arg(QString("%1").arg(s.SId.value(), 8, 16, QChar('0')).toUpper())
-                   .arg(s.label)
-                   .arg(s.labelShort);
+        {
+            strOut << QString(" PTy: %1 (static), ").arg(DabTables::getPtyNameEnglish(s.pty.s));
         }
-        if (s.CAId)
+        if (0 == s.ASu)
         {
-            strOut << QString(", CAId %1").arg(s.CAId);
+            strOut << "Announcements: No";
         }
-        strOut << "</dt>";
-
-        for (auto const & sc : s.serviceComponents)
+        else
         {
-            strOut << "<dd>";
-            if (sc.isDataPacketService())
+            strOut << "Announcements: ";
+            for (int b = 0; b < 16; ++b)
             {
-                strOut << "DataComponent (MSC Packet Data)";
-                strOut << ((sc.ps) ? " (primary)," : " (secondary),");
-                strOut << QString(" SCIdS: %1,").arg(sc.SCIdS);
-                strOut << QString(" SCId: %1,").arg(sc.packetData.SCId);
-                strOut << QString(" Language: %1,").arg(DabTables::getLangNameEnglish(sc.lang));
+                if ((1 << b) & s.ASu)
+                {
+                    strOut << DabTables::getAnnouncementNameEnglish(static_cast<DabAnnouncement>(b)) << ", ";
+                }
             }
-            else
+            strOut << QString("Cluster IDs [");
+            strOut << QString("%1").arg(s.clusterIds.at(0), 2, 16, QLatin1Char('0')).toUpper();
+            for (int d = 1; d < s.clusterIds.size(); ++d)
             {
-                strOut << ((sc.isDataStreamService()) ? "DataComponent (MSC Stream Data)" : "AudioComponent");
-                strOut << ((sc.ps) ? " (primary)," : " (secondary),");
-                strOut << QString(" SCIdS: %1,").arg(sc.SCIdS);
+                strOut << QString(" %1").arg(s.clusterIds.at(d), 2, 16, QLatin1Char('0')).toUpper();
             }
+            strOut << "]";
+        }
+    }
+    else
+    {   // data service
+        strOut << QString("0x%1 <b>%2</b> [ <i>%3</i> ]")
+               .arg(QString("%1").arg(s.SId.value(), 8, 16, QChar('0')).toUpper())
+               .arg(s.label)
+               .arg(s.labelShort);
+    }
+    if (s.CAId)
+    {
+        strOut << QString(", CAId %1").arg(s.CAId);
+    }
+    strOut << "</dt>";
 
-            QString scLabel = sc.label;
-            QString scLabelShort = sc.labelShort;
-            strOut << QString(" Label: '%1' [ '%2' ], ").arg(scLabel.replace(QRegularExpression("\\s"), "&nbsp;"), scLabelShort.replace(QRegularExpression("\\s"), "&nbsp;"));
+    for (auto const & sc : s.serviceComponents)
+    {
+        strOut << "<dd>";
+        if (sc.isDataPacketService())
+        {
+            strOut << "DataComponent (MSC Packet Data)";
+            strOut << ((sc.ps) ? " (primary)," : " (secondary),");
+            strOut << QString(" SCIdS: %1,").arg(sc.SCIdS);
+            strOut << QString(" SCId: %1,").arg(sc.packetData.SCId);
+            strOut << QString(" Language: %1,").arg(DabTables::getLangNameEnglish(sc.lang));
+        }
+        else
+        {
+            strOut << ((sc.isDataStreamService()) ? "DataComponent (MSC Stream Data)" : "AudioComponent");
+            strOut << ((sc.ps) ? " (primary)," : " (secondary),");
+            strOut << QString(" SCIdS: %1,").arg(sc.SCIdS);
+        }
 
-            DabAudioDataSCty scType;
-            if (sc.isDataPacketService())
-            {
-                scType = sc.packetData.DSCTy;
+        QString scLabel = sc.label;
+        QString scLabelShort = sc.labelShort;
+        strOut << QString(" Label: '%1' [ '%2' ], ").arg(scLabel.replace(QRegularExpression("\\s"), "&nbsp;"), scLabelShort.replace(QRegularExpression("\\s"), "&nbsp;"));
+
+        DabAudioDataSCty scType;
+        if (sc.isDataPacketService())
+        {
+            scType = sc.packetData.DSCTy;
+        }
+        else
+        {
+            scType = sc.streamAudioData.scType;
+        }
+
+        switch (scType)
+        {
+        case DabAudioDataSCty::DAB_AUDIO:
+            strOut << QString("ASCTy: 0x%2 (MP2)").arg(QString::number(int(scType), 16).toUpper());
+            break;
+        case DabAudioDataSCty::DABPLUS_AUDIO:
+            strOut << QString("ASCTy: 0x%2 (AAC)").arg(QString::number(int(scType), 16).toUpper());
+            break;
+        case DabAudioDataSCty::TDC:
+            strOut << QString("DSCTy: 0x%2 (TDC)").arg(QString::number(int(scType), 16).toUpper());
+            break;
+        case DabAudioDataSCty::MPEG2TS:
+            strOut << QString("DSCTy: 0x%2 (MPEG2TS)").arg(QString::number(int(scType), 16).toUpper());
+            break;
+        case DabAudioDataSCty::MOT:
+            strOut << QString("DSCTy: 0x%2 (MOT)").arg(QString::number(int(scType), 16).toUpper());
+            break;
+        case DabAudioDataSCty::PROPRIETARY_SERVICE:
+            strOut << QString("DSCTy: 0x%2 (Proprietary)").arg(QString::number(int(scType), 16).toUpper());
+            break;
+        default:
+            strOut << QString("DSCTy: 0x%2 (unknown)").arg(QString::number(int(scType), 16).toUpper());
+            break;
+        }
+
+        if (sc.isDataPacketService())
+        {
+            strOut << QString(", DG: %1, PacketAddr: %2")
+                      .arg(sc.packetData.DGflag)
+                      .arg(sc.packetData.packetAddress);
+        }
+        else
+        {  /* do nothing */ }
+        strOut << "<br>";
+
+        strOut << "&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;";
+        strOut << QString("SubChId: %1, Language: %2, StartCU: %3, NumCU: %4,")
+                  .arg(sc.SubChId)
+                  .arg(DabTables::getLangNameEnglish(sc.lang))
+                  .arg(sc.SubChAddr)
+                  .arg(sc.SubChSize);
+        if (sc.protection.isEEP())
+        {   // EEP
+            if (sc.protection.level < DabProtectionLevel::EEP_1B)
+            {  // EEP x-A
+                strOut << QString(" EEP %1-%2").arg(int(sc.protection.level) - int(DabProtectionLevel::EEP_1A) + 1).arg("A");
             }
             else
-            {
-                scType = sc.streamAudioData.scType;
-            }
-
-            switch (scType)
-            {
-            case DabAudioDataSCty::DAB_AUDIO:
-                strOut << QString("ASCTy: 0x%2 (MP2)").arg(QString::number(int(scType), 16).toUpper());
-                break;
-            case DabAudioDataSCty::DABPLUS_AUDIO:
-                strOut << QString("ASCTy: 0x%2 (AAC)").arg(QString::number(int(scType), 16).toUpper());
-                break;
-            case DabAudioDataSCty::TDC:
-                strOut << QString("DSCTy: 0x%2 (TDC)").arg(QString::number(int(scType), 16).toUpper());
-                break;
-            case DabAudioDataSCty::MPEG2TS:
-                strOut << QString("DSCTy: 0x%2 (MPEG2TS)").arg(QString::number(int(scType), 16).toUpper());
-                break;
-            case DabAudioDataSCty::MOT:
-                strOut << QString("DSCTy: 0x%2 (MOT)").arg(QString::number(int(scType), 16).toUpper());
-                break;
-            case DabAudioDataSCty::PROPRIETARY_SERVICE:
-                strOut << QString("DSCTy: 0x%2 (Proprietary)").arg(QString::number(int(scType), 16).toUpper());
-                break;
-            default:
-                strOut << QString("DSCTy: 0x%2 (unknown)").arg(QString::number(int(scType), 16).toUpper());
-                break;
+            {  // EEP x+B
+                strOut << QString(" EEP %1-%2").arg(int(sc.protection.level) - int(DabProtectionLevel::EEP_1B) + 1).arg("B");
             }
-
             if (sc.isDataPacketService())
             {
-                strOut << QString(", DG: %1, PacketAddr: %2")
-                          .arg(sc.packetData.DGflag)
-                          .arg(sc.packetData.packetAddress);
-            }
-            else
-            {  /* do nothing */ }
-            strOut << "<br>";
-
-            strOut << "&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;";
-            strOut << QString("SubChId: %1, Language: %2, StartCU: %3, NumCU: %4,")
-                      .arg(sc.SubChId)
-                      .arg(DabTables::getLangNameEnglish(sc.lang))
-                      .arg(sc.SubChAddr)
-                      .arg(sc.SubChSize);
-            if (sc.protection.isEEP())
-            {   // EEP
-                if (sc.protection.level < DabProtectionLevel::EEP_1B)
-                {  // EEP x-A
-                    strOut << QString(" EEP %1-%2").arg(int(sc.protection.level) - int(DabProtectionLevel::EEP_1A) + 1).arg("A");
-                }
-                else
-                {  // EEP x+B
-                    strOut << QString(" EEP %1-%2").arg(int(sc.protection.level) - int(DabProtectionLevel::EEP_1B) + 1).arg("B");
-                }
-                if (sc.isDataPacketService())
+                if (sc.protection.fecScheme)
                 {
-                    if (sc.protection.fecScheme)
-                    {
-                        strOut << " [FEC scheme applied]";
-                    }
+                    strOut << " [FEC scheme applied]";
                 }
-                strOut << QString(", Coderate: %1/%2").arg(sc.protection.codeRateUpper).arg(sc.protection.codeRateLower);
-            }
-            else
-            {  // UEP
-                strOut << QString(" UEP #%1, Protection level: %2").arg(sc.protection.uepIndex).arg(int(sc.protection.level));
-            }
-            if (!sc.isDataPacketService())
-            {
-                strOut << QString(", Bitrate: %1kbps").arg(sc.streamAudioData.bitRate);
             }
-            int uaCntr = 1;
-            for (const auto & ua : sc.userApps)
-            {
-                strOut << "<br>";
-                strOut << "&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;";
-                strOut << "&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;";
-                strOut << QString("UserApp %1/%2: Label: '%3' [ '%4' ], ")
-                          .arg(uaCntr++).arg(sc.userApps.size())
-                          .arg(ua.label)
-                          .arg(ua.labelShort);
+            strOut << QString(", Coderate: %1/%2").arg(sc.protection.codeRateUpper).arg(sc.protection.codeRateLower);
+        }
+        else
+        {  // UEP
+            strOut << QString(" UEP #%1, Protection level: %2").arg(sc.protection.uepIndex).arg(int(sc.protection.level));
+        }
+        if (!sc.isDataPacketService())
+        {
+            strOut << QString(", Bitrate: %1kbps").arg(sc.streamAudioData.bitRate);
+        }
+        int uaCntr = 1;
+        for (const auto & ua : sc.userApps)
+        {
+            strOut << "<br>";
+            strOut << "&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;";
+            strOut << "&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;";
+            strOut << QString("UserApp %1/%2: Label: '%3' [ '%4' ], ")
+                      .arg(uaCntr++).arg(sc.userApps.size())
+                      .arg(ua.label)
+                      .arg(ua.labelShort);
 
 
-                strOut << QString("UAType: 0x%1 (%2)").arg(QString::number(int(ua.uaType), 16).toUpper(), DabTables::getUserApplicationName(ua.uaType));
+            strOut << QString("UAType: 0x%1 (%2)").arg(QString::number(int(ua.uaType), 16).toUpper(), DabTables::getUserApplicationName(ua.uaType));
 
-                if (sc.isAudioService())
-                {
-                    strOut << QString(", X-PAD AppTy: %1, ").arg(ua.xpadData.xpadAppTy);
-                    switch (ua.xpadData.DScTy)
-                    {
-                    case DabAudioDataSCty::TDC:
-                        strOut << QString("DSCTy: 0x%2 (TDC)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
-                        break;
-                    case DabAudioDataSCty::MPEG2TS:
-                        strOut << QString("DSCTy: 0x%2 (MPEG2TS)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
-                        break;
-                    case DabAudioDataSCty::MOT:
-                        strOut << QString("DSCTy: 0x%2 (MOT)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
-                        break;
-                    case DabAudioDataSCty::PROPRIETARY_SERVICE:
-                        strOut << QString("DSCTy: 0x%2 (Proprietary)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
-                        break;
-                    default:
-                        strOut << QString("DSCTy: 0x%2 (unknown)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
-                        break;
-                    }
-                    strOut << QString(", DG: %3").arg(ua.xpadData.dgFlag);
-                }
-                strOut << QString(", Data (%1) [").arg(ua.uaData.size());
-                for (int d = 0; d < ua.uaData.size(); ++d)
+            if (sc.isAudioService())
+            {
+                strOut << QString(", X-PAD AppTy: %1, ").arg(ua.xpadData.xpadAppTy);
+                switch (ua.xpadData.DScTy)
                 {
-                    strOut << QString("%1").arg(ua.uaData.at(d), 2, 16, QLatin1Char('0')).toUpper();
+                case DabAudioDataSCty::TDC:
+                    strOut << QString("DSCTy: 0x%2 (TDC)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
+                    break;
+                case DabAudioDataSCty::MPEG2TS:
+                    strOut << QString("DSCTy: 0x%2 (MPEG2TS)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
+                    break;
+                case DabAudioDataSCty::MOT:
+                    strOut << QString("DSCTy: 0x%2 (MOT)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
+                    break;
+                case DabAudioDataSCty::PROPRIETARY_SERVICE:
+                    strOut << QString("DSCTy: 0x%2 (Proprietary)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
+                    break;
+                default:
+                    strOut << QString("DSCTy: 0x%2 (unknown)").arg(QString::number(int(ua.xpadData.DScTy), 16).toUpper());
+                    break;
                 }
-                strOut << "]";
+                strOut << QString(", DG: %3").arg(ua.xpadData.dgFlag);
+            }
+            strOut << QString(", Data (%1) [").arg(ua.uaData.size());
+            for (int d = 0; d < ua.uaData.size(); ++d)
+            {
+                strOut << QString("%1").arg(ua.uaData.at(d), 2, 16, QLatin1Char('0')).toUpper();
             }
-            strOut << "</dd>";
+            strOut << "]";
         }
-        strOut << "</dl>";
         strOut << "</dd>";
     }
     strOut << "</dl>";
+    strOut << "</dd></dl>";
 
     strOut.flush();
 
     return output;
 }
 
+bool RadioControl::ensembleConfigurationDiff(RadioControlEnsembleConfiguration & config)
+{
+    bool changed = false;
+
+    QString header = ensembleConfigurationHeader();
+    if (header != m_ensembleConfigurationHeader)
+    {
+        m_ensembleConfigurationHeader = header;
+        changed = true;
+    }
+    config.ensemble = m_ensembleConfigurationHeader;
+
+    for (auto it = m_ensembleConfigurationCache.begin(); it != m_ensembleConfigurationCache.end(); )
+    {
+        if (m_serviceList.contains(it.key()))
+        {
+            ++it;
+        }
+        else
+        {   // service removed (reconfiguration)
+            config.removed.append(it.key());
+            it = m_ensembleConfigurationCache.erase(it);
+            changed = true;
+        }
+    }
+
+    for (auto const & s : m_serviceList)
+    {
+        uint32_t sid = s.SId.value();
+        if (m_ensembleConfigurationDirty.contains(sid) || !m_ensembleConfigurationCache.contains(sid))
+        {   // only new and changed services are rendered
+            QString html = serviceConfigurationString(s);
+            m_ensembleConfigurationCache.insert(sid, html);
+            config.services.insert(sid, html);
+            changed = true;
+        }
+    }
+    m_ensembleConfigurationDirty.clear();
+
+    return changed;
+}
+
 void RadioControl::clearEnsemble()
 {    
     m_ensemble.ueid = RADIO_CONTROL_UEID_INVALID;
@@ -938,12 +1377,18 @@ void RadioControl::clearEnsemble()
     m_ensemble.alarm = 0;
     m_ensembleConfigurationTimer->stop();
     m_ensembleConfigurationUpdateRequest = false;
+    m_ensembleConfigurationHeader.clear();
+    m_ensembleConfigurationCache.clear();
+    m_ensembleConfigurationDirty.clear();
 
-    emit ensembleConfiguration(QString());
+    RadioControlEnsembleConfiguration config;
+    config.reset = true;
+    emit ensembleConfiguration(config);
 }
 
-void RadioControl::ensembleConfigurationUpdate()
+void RadioControl::ensembleConfigurationUpdate(uint32_t sid)
 {
+    m_ensembleConfigurationDirty.insert(sid);
     if (m_ensembleConfigurationTimer->isActive())
     {   // will be done on timer timeout
         m_ensembleConfigurationUpdateRequest = true;
@@ -951,10 +1396,13 @@ void RadioControl::ensembleConfigurationUpdate()
     else
     {   // do update and start timer
         m_ensembleConfigurationUpdateRequest = false;
-        emit ensembleConfiguration(ensembleConfigurationString());
+        RadioControlEnsembleConfiguration config;
+        if (ensembleConfigurationDiff(config))
+        {
+            emit ensembleConfiguration(config);
+        }
         m_ensembleConfigurationTimer->start();
     }
-
 }
 
 void RadioControl::ensembleConfigurationDispatch()
@@ -962,7 +1410,11 @@ void RadioControl::ensembleConfigurationDispatch()
     if (m_ensembleConfigurationUpdateRequest)
     {
         m_ensembleConfigurationUpdateRequest = false;
-        emit ensembleConfiguration(ensembleConfigurationString());
+        RadioControlEnsembleConfiguration config;
+        if (ensembleConfigurationDiff(config))
+        {
+            emit ensembleConfiguration(config);
+        }
     }
     else { /* do nothing */ }
 }
@@ -975,6 +1427,11 @@ void RadioControl::resetCurrentService()
     m_currentService.announcement.timeoutTimer->stop();
     m_currentService.announcement.activeCluster = 0;
     m_currentService.announcement.SId = 0;
+    if (m_announcementDecoderEna && (AnnouncementSwitchState::NoAnnouncement != m_currentService.announcement.switchState))
+    {
+        emit announcementAudioStop();
+    }
+    else { /* announcement decoder is not running */ }
     m_currentService.announcement.switchState = AnnouncementSwitchState::NoAnnouncement;
     m_currentService.announcement.state = RadioControlAnnouncementState::None;
     m_currentService.announcement.id = DabAnnouncement::Undefined;
@@ -1005,6 +1462,9 @@ void RadioControl::eventHandler_ensembleInfo(RadioControlEvent *pEvent)
 
         emit ensembleInformation(m_ensemble);                
 
+        // service can be selected before FIC is complete if configuration is known
+        warmStart();
+
         // request service list
         // ETSI EN 300 401 V2.1.1 (2017-01) [6.1]
         // The complete MCI for one configuration shall normally be signalled in a 96ms period;
@@ -1026,7 +1486,11 @@ void RadioControl::eventHandler_serviceList(RadioControlEvent *pEvent)
     QList<dabsdrServiceListItem_t> * pServiceList = pEvent->pServiceList;
     if (0 == pServiceList->size())
     {   // no service list received (invalid probably)
-        m_serviceList.clear();
+        if (!m_isReconfigurationOngoing)
+        {
+            clearServiceList();
+        }
+        else { /* current configuration is kept until new one is received */ }
 
         // send new request after some timeout
         QTimer::singleShot(100, this, &RadioControl::dabGetServiceList);
@@ -1034,24 +1498,48 @@ void RadioControl::eventHandler_serviceList(RadioControlEvent *pEvent)
     else
     {
         m_numReqPendingServiceList = 0;
+        QSet<uint32_t> signalledServices;
         for (auto const & dabService : *pServiceList)
         {
             DabSId sid(dabService.sid, m_ensemble.ecc());
-            serviceConstIterator servIt = m_serviceList.constFind(sid.value());
-            if (servIt != m_serviceList.cend())
-            {   // delete existing service
-                m_serviceList.erase(servIt);
-            }
-            RadioControlService newService;
-            newService.SId = sid;
+            signalledServices.insert(sid.value());
             QString label = DabTables::convertToQString(dabService.label.str, dabService.label.charset);
-            newService.labelShort = toShortLabel(label, dabService.label.charField);
-            newService.label = removeTrailingSpaces(label);
-            newService.pty.s = dabService.pty.s;
-            newService.pty.d = dabService.pty.d;
-            newService.CAId = dabService.CAId;
-            newService.ASu = 0;
-            m_serviceList.insert(sid.value(), newService);
+            QString labelShort = toShortLabel(label, dabService.label.charField);
+            label = removeTrailingSpaces(label);
+
+            serviceIterator servIt = m_serviceList.find(sid.value());
+            if (m_isReconfigurationOngoing && (servIt != m_serviceList.end()))
+            {   // service is updated in place, its components are compared when they arrive
+                if ((servIt->label != label) || (servIt->labelShort != labelShort) || (servIt->pty.s != dabService.pty.s)
+                    || (servIt->pty.d != dabService.pty.d) || (servIt->CAId != dabService.CAId))
+                {
+                    servIt->label = label;
+                    servIt->labelShort = labelShort;
+                    servIt->pty.s = dabService.pty.s;
+                    servIt->pty.d = dabService.pty.d;
+                    servIt->CAId = dabService.CAId;
+                    m_ensembleConfigurationDirty.insert(sid.value());
+                }
+                else { /* service not changed */ }
+            }
+            else
+            {
+                if (servIt != m_serviceList.end())
+                {   // delete existing service
+                    removeFromSubChIndex(sid.value());
+                    m_serviceList.erase(servIt);
+                    m_ensembleConfigurationDirty.insert(sid.value());
+                }
+                RadioControlService newService;
+                newService.SId = sid;
+                newService.labelShort = labelShort;
+                newService.label = label;
+                newService.pty.s = dabService.pty.s;
+                newService.pty.d = dabService.pty.d;
+                newService.CAId = dabService.CAId;
+                newService.ASu = 0;
+                m_serviceList.insert(sid.value(), newService);
+            }
             m_numReqPendingServiceList++;
             dabGetServiceComponent(sid.value());
             if (sid.isProgServiceId())
@@ -1061,6 +1549,41 @@ void RadioControl::eventHandler_serviceList(RadioControlEvent *pEvent)
                 QTimer::singleShot(1000, this, [this, sidVal](){dabGetAnnouncementSupport(sidVal); } );
             }
         }
+
+        if (m_isReconfigurationOngoing)
+        {   // services that are not signalled anymore are removed
+            serviceIterator it = m_serviceList.begin();
+            while (it != m_serviceList.end())
+            {
+                if (!signalledServices.contains(it.key()))
+                {
+                    qCInfo(radioControl, "Service %8.8X removed by reconfiguration", it.key());
+                    if (it.key() == m_currentService.SId)
+                    {   // playback will be stopped => emit dummy service component
+                        emit audioServiceReconfiguration(RadioControlServiceComponent());
+                    }
+                    removeFromSubChIndex(it.key());
+                    m_ensembleConfigurationDirty.insert(it.key());
+                    it = m_serviceList.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+        else if ((0 != m_warmStart.SId) && !signalledServices.contains(m_warmStart.SId))
+        {   // service selected from cached configuration is not in ensemble anymore
+            qCInfo(radioControl, "Service %8.8X from cached configuration not found", m_warmStart.SId);
+            if (isCurrentService(m_warmStart.SId, m_warmStart.SCIdS))
+            {   // playback will be stopped => emit dummy service component
+                emit audioServiceReconfiguration(RadioControlServiceComponent());
+            }
+            removeFromSubChIndex(m_warmStart.SId);
+            m_serviceList.remove(m_warmStart.SId);
+            m_warmStart.SId = 0;
+        }
+        else { /* new service list */ }
     }
 }
 
@@ -1076,6 +1599,14 @@ void RadioControl::eventHandler_serviceComponentList(RadioControlEvent *pEvent)
         serviceIterator serviceIt = m_serviceList.find(sid.value());
         if (serviceIt != m_serviceList.end())
         {   // SId found
+            // during reconfiguration new components are compared with current ones
+            RadioControlServiceCompList previousComponents;
+            if (m_isReconfigurationOngoing)
+            {
+                previousComponents = serviceIt->serviceComponents;
+            }
+            QSet<uint8_t> unchangedComponents;
+            bool isChanged = (previousComponents.size() != pList->size());
             serviceIt->serviceComponents.clear();
 
             bool requestUpdate = false;
@@ -1149,18 +1680,39 @@ void RadioControl::eventHandler_serviceComponentList(RadioControlEvent *pEvent)
                     newServiceComp.packetData.packetAddress = dabServiceComp.packetData.packetAddress;
                     break;
                 }
+                serviceComponentConstIterator previousIt = previousComponents.constFind(newServiceComp.SCIdS);
+                bool isUnchanged = (previousComponents.cend() != previousIt) && isSameComponentConfiguration(*previousIt, newServiceComp);
+                if (isUnchanged)
+                {   // state of the component is kept
+                    newServiceComp.userApps = previousIt->userApps;
+                    newServiceComp.autoEnabled = previousIt->autoEnabled;
+                    unchangedComponents.insert(newServiceComp.SCIdS);
+                }
+                else
+                {
+                    isChanged = true;
+                }
                 serviceIt->serviceComponents.insert(newServiceComp.SCIdS, newServiceComp);
 
                 if (m_isReconfigurationOngoing)
                 {
-
-                    if (isCurrentService(serviceIt->SId.value(), newServiceComp.SCIdS) && (newServiceComp.isAudioService()))
+                    if (!isUnchanged && isCurrentService(serviceIt->SId.value(), newServiceComp.SCIdS) && (newServiceComp.isAudioService()))
                     {   // inform HMI about possible new service configuration
                         emit audioServiceReconfiguration(newServiceComp);
                     }
                 }
                 else
                 {
+                    if ((m_warmStart.SId == serviceIt->SId.value()) && (m_warmStart.SCIdS == newServiceComp.SCIdS))
+                    {   // received configuration confirms warm start
+                        if (!isSameComponentConfiguration(m_warmStart.component, newServiceComp) && isCurrentService(m_warmStart.SId, m_warmStart.SCIdS))
+                        {
+                            qCInfo(radioControl) << "Cached configuration differs, selecting service again";
+                            dabServiceSelection(m_warmStart.SId, m_warmStart.SCIdS, DABSDR_ID_AUDIO_PRIMARY);
+                        }
+                        else { /* configuration is the same */ }
+                        m_warmStart.SId = 0;
+                    }
                     if ((m_serviceRequest.SId == serviceIt->SId.value()) && (m_serviceRequest.SCIdS == newServiceComp.SCIdS))
                     {
                         dabServiceSelection(m_serviceRequest.SId, m_serviceRequest.SCIdS, DABSDR_ID_AUDIO_PRIMARY);
@@ -1171,15 +1723,31 @@ void RadioControl::eventHandler_serviceComponentList(RadioControlEvent *pEvent)
                 emit serviceListEntry(m_ensemble, newServiceComp);
             }
             if (requestUpdate)
-            {
-                serviceIt->serviceComponents.clear();
+            {   // during reconfiguration previous components are kept until valid list arrives
+                serviceIt->serviceComponents = previousComponents;
                 uint32_t sidVal = sid.value();
                 QTimer::singleShot(100, this, [this, sidVal](){ dabGetServiceComponent(sidVal); } );
             }
             else
             {  // service list item information is complete
+                if (isChanged)
+                {
+                    m_ensembleConfigurationDirty.insert(sid.value());
+                }
+                else { /* service configuration not changed */ }
+
+                if (m_isReconfigurationOngoing && (sid.value() == m_currentService.SId)
+                    && !serviceIt->serviceComponents.contains(m_currentService.SCIdS))
+                {   // current component was removed => emit dummy service component
+                    emit audioServiceReconfiguration(RadioControlServiceComponent());
+                }
+
                 for (auto & serviceComp : serviceIt->serviceComponents)
                 {
+                    if (unchangedComponents.contains(serviceComp.SCIdS))
+                    {   // user applications are known
+                        continue;
+                    }
                     serviceComp.userApps.clear();
 
                     // request user apps -> wait 1 second before asking
@@ -1199,9 +1767,15 @@ void RadioControl::eventHandler_serviceComponentList(RadioControlEvent *pEvent)
                     // clear any pending request => it can happen if requested service was not in the list
                     m_serviceRequest.SId = 0;
 
+#if (RADIO_CONTROL_WARM_START)
+                    // configuration is cached for next tune to this frequency
+                    m_warmStartCache[m_ensemble.frequency] = WarmStartEnsemble{m_ensemble.ueid, m_serviceList};
+#endif
+
                     emit serviceListComplete(m_ensemble);
                 }
             }
+            updateSubChIndex(*serviceIt);
         }
         else
         {   // SId not found
@@ -1249,15 +1823,15 @@ void RadioControl::eventHandler_userAppList(RadioControlEvent *pEvent)
                             newUserApp.xpadData.DScTy = DabAudioDataSCty(userApp.data[1] & 0x3F);
                         }
                         scIt->userApps.insert(newUserApp.uaType, newUserApp);
-                        ensembleConfigurationUpdate();
-
-                        if ((newUserApp.uaType == DabUserApplicationType::SPI) && m_spiAppEnabled)
-                        {
-                            startUserApplication(DabUserApplicationType::SPI, true, false);
-                        }
+                    }
+                    ensembleConfigurationUpdate(sid.value());
 
+                    // search of SPI components walks whole ensemble -> started once per list
+                    if (scIt->userApps.contains(DabUserApplicationType::SPI) && m_spiAppEnabled && !m_lowPowerMode)
+                    {
+                        startUserApplication(DabUserApplicationType::SPI, true, false);
                     }
-                }                
+                }
                 else { /* SC not found - this should not happen */ }
             }
             else
@@ -1271,7 +1845,7 @@ void RadioControl::eventHandler_userAppList(RadioControlEvent *pEvent)
             // FIG 0/13 may be signalled at a slower rate but not less frequently than once per second.
         }
 
-        if (isCurrentService(pEvent->SId, pEvent->SCIdS))
+        if (isCurrentService(pEvent->SId, pEvent->SCIdS) && !m_lowPowerMode)
         {   // if is is current service ==> start user applications
             // enable SLS automatically - if available
             startUserApplication(DabUserApplicationType::SlideShow, true);
@@ -1297,7 +1871,7 @@ void RadioControl::eventHandler_serviceSelection(RadioControlEvent *pEvent)
             {   // service components exists in service
                 if (!scIt->autoEnabled)
                 {   // if not data service that is automatically enabled
-                    qCInfo(radioControl, "Playing: [%6.6X @ %6d kHz | %3s] %-18s %6.6X : %d", m_ensemble.ueid, m_ensemble.frequency, DabTables::channelList.value(m_ensemble.frequency).toUtf8().data(),
+                    qCInfo(radioControl, "Playing: [%6.6X @ %6d kHz | %3s] %-18s %6.6X : %d", m_ensemble.ueid, m_ensemble.frequency, DabTables::channelName(m_ensemble.frequency).toUtf8().data(),
                             scIt->label.toUtf8().data(), pEvent->SId, pEvent->SCIdS);
                     // store current service
                     m_currentService.SId = pEvent->SId;
@@ -1316,6 +1890,20 @@ void RadioControl::eventHandler_serviceSelection(RadioControlEvent *pEvent)
             }
         }
     }
+    else if ((pEvent->decoderId == DABSDR_ID_AUDIO_SECONDARY) && m_audioSubscriptionActive
+             && (m_audioSubscription.SId == pEvent->SId) && (m_audioSubscription.SCIdS == pEvent->SCIdS))
+    {   // secondary is used for subscription
+        serviceConstIterator serviceIt = m_serviceList.constFind(pEvent->SId);
+        if (serviceIt != m_serviceList.cend())
+        {
+            serviceComponentConstIterator scIt = serviceIt->serviceComponents.constFind(pEvent->SCIdS);
+            if (scIt != serviceIt->serviceComponents.cend())
+            {
+                qCInfo(radioControl, "Subscription: %-18s %6.6X : %d", scIt->label.toUtf8().data(), pEvent->SId, pEvent->SCIdS);
+                emit subscriptionStarted(*scIt);
+            }
+        }
+    }
     else if (pEvent->decoderId == DABSDR_ID_AUDIO_SECONDARY)
     {   // secondary is used for announceement on other service
         qCDebug(radioControl) << "RadioControlEvent::SERVICE_SELECTION success instance" << int(pEvent->decoderId);
@@ -1324,10 +1912,38 @@ void RadioControl::eventHandler_serviceSelection(RadioControlEvent *pEvent)
 
         m_currentService.announcement.SId = pEvent->SId;
         m_currentService.announcement.SCIdS = pEvent->SCIdS;
+
+        if (m_announcementDecoderEna)
+        {
+            serviceConstIterator serviceIt = m_serviceList.constFind(pEvent->SId);
+            if (serviceIt != m_serviceList.cend())
+            {
+                serviceComponentConstIterator scIt = serviceIt->serviceComponents.constFind(pEvent->SCIdS);
+                if (scIt != serviceIt->serviceComponents.cend())
+                {
+                    emit announcementAudioSelection(*scIt);
+                }
+            }
+        }
+        else { /* announcement is decoded by service decoder */ }
     }
     else
     {   // data service
         qCDebug(radioControl) << "RadioControlEvent::SERVICE_SELECTION success instance" << int(pEvent->decoderId);
+
+        if (isSubscribed(pEvent->SId, pEvent->SCIdS))
+        {
+            serviceConstIterator serviceIt = m_serviceList.constFind(pEvent->SId);
+            if (serviceIt != m_serviceList.cend())
+            {
+                serviceComponentConstIterator scIt = serviceIt->serviceComponents.constFind(pEvent->SCIdS);
+                if (scIt != serviceIt->serviceComponents.cend())
+                {
+                    qCInfo(radioControl, "Subscription: %-18s %6.6X : %d", scIt->label.toUtf8().data(), pEvent->SId, pEvent->SCIdS);
+                    emit subscriptionStarted(*scIt);
+                }
+            }
+        }
     }
 }
 
@@ -1367,7 +1983,7 @@ void RadioControl::eventHandler_announcementSupport(RadioControlEvent * pEvent)
                     setCurrentServiceAnnouncementSupport();
                 }
 
-                ensembleConfigurationUpdate();
+                ensembleConfigurationUpdate(sid.value());
             }
             else { /* no announcment support */ }
         }
@@ -1382,6 +1998,11 @@ void RadioControl::eventHandler_announcementSupport(RadioControlEvent * pEvent)
 
 void RadioControl::eventHandler_announcementSwitching(RadioControlEvent * pEvent)
 {
+    if (m_lowPowerMode)
+    {   // switching information is still tracked by FIC processing, audio is not started
+        return;
+    }
+
     dabsdrNtfAnnouncementSwitching_t * pAnnouncement = pEvent->pAnnouncement;
 
     // go through asw array
@@ -1425,7 +2046,7 @@ void RadioControl::eventHandler_programmeType(RadioControlEvent * pEvent)
             {
                 emit programmeTypeChanged(sid, serviceIt->pty);
             }
-            ensembleConfigurationUpdate();
+            ensembleConfigurationUpdate(sid.value());
         }
         else { /* not programme - should not happen  */ }
     }
@@ -1504,27 +2125,25 @@ bool RadioControl::startAnnouncement(uint8_t subChId)
 
     // 2. find SId and SCIdS that match subChId
     DabSId sid;
-    uint8_t scids;
-    serviceConstIterator serviceIt = m_serviceList.cbegin();
-    while ((serviceIt != m_serviceList.cend()) && !sid.isValid())
-    {
-        if (serviceIt->SId.isProgServiceId())
-        {   // check service components
-            serviceComponentConstIterator serviceCompIt = serviceIt->serviceComponents.cbegin();
-            while (serviceCompIt != serviceIt->serviceComponents.cend())
-            {
-                if (serviceCompIt->SubChId == subChId)
-                {   // found
-                    sid = serviceIt->SId;   // valid sid stop outer loop
-                    scids = serviceCompIt->SCIdS;
-
-                    // breaking inner loop
-                    break;
-                }
-                serviceCompIt++;
-            }
+    uint8_t scids = 0;
+    auto subChRange = m_audioSubChIndex.equal_range(subChId);
+    for (auto subChIt = subChRange.first; subChIt != subChRange.second; ++subChIt)
+    {   // first component present in service list is used
+        serviceConstIterator serviceIt = m_serviceList.constFind(subChIt->first);
+        if (m_serviceList.cend() != serviceIt)
+        {
+            sid = serviceIt->SId;
+            scids = subChIt->second;
+            break;
         }
-        serviceIt++;
+        else { /* index is updated with service list, this should not happen */ }
+    }
+
+    if (sid.isValid() && m_audioSubscriptionActive)
+    {   // secondary instance is used by subscription -> announcement on other service cannot be followed
+        qCInfo(radioControl) << "Announcement ignored, audio instance is used by subscription";
+        m_currentService.announcement.isOtherService = false;
+        return false;
     }
 
     // check if found
@@ -1564,6 +2183,11 @@ void RadioControl::stopAnnouncement()
     {   // stop announcement - sid, scids and subChId are not relevant, simply stopping secondary audio service
         dabsdrRequest_ServiceStop(m_dabsdrHandle, 0, 0, DABSDR_ID_AUDIO_SECONDARY);
         m_currentService.announcement.switchState = AnnouncementSwitchState::NoAnnouncement;
+        if (m_announcementDecoderEna)
+        {
+            emit announcementAudioStop();
+        }
+        else { /* service decoder switches back */ }
     }
     else
     {  /* do nothing */ }
@@ -1585,7 +2209,7 @@ void RadioControl::announcementHandler(dabsdrAsw_t *pAnnouncement)
         // corresponding to the announcement type while the announcement is active
         // ...
         // An ASw flag field with more than one bit flag set to 1 is invalid and shall be ignored.
-        int announcementId = DabTables::ASwValues.indexOf(pAnnouncement->ASwFlags);
+        int announcementId = DabTables::aswIndex(pAnnouncement->ASwFlags);
         if ((static_cast<int>(DabAnnouncement::Alarm) == announcementId) && (0xFE == pAnnouncement->clusterId))
         {   // this is test mode
             // ETSI TS 103 176 V2.4.1 [Annex G]
@@ -1734,7 +2358,7 @@ void RadioControl::announcementHandler(dabsdrAsw_t *pAnnouncement)
         else
         {   // During the announcement the receiver shall monitor ASw information for only the active Cluster Id
             // monitor for alarm announcement
-            DabAnnouncement announcementId = static_cast<DabAnnouncement>(DabTables::ASwValues.indexOf(pAnnouncement->ASwFlags));
+            DabAnnouncement announcementId = static_cast<DabAnnouncement>(DabTables::aswIndex(pAnnouncement->ASwFlags));
             if ((DabAnnouncement::Alarm == announcementId) && (0xFE == pAnnouncement->clusterId))
             {   // this is test mode
                 // ETSI TS 103 176 V2.4.1 [Annex G]
@@ -1803,7 +2427,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
     {
     case DABSDR_NID_SYNC_STATUS:
     {
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
 
         const dabsdrNtfSyncStatus_t * pInfo = static_cast<const dabsdrNtfSyncStatus_t *>(p->pData);
         qCDebug(radioControl, "DABSDR_NID_SYNC_STATUS: %d", pInfo->syncLevel);
@@ -1818,7 +2442,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
     {
         qCDebug(radioControl, "DABSDR_NID_TUNE: status %d", p->status);
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::TUNE;
         pEvent->status = p->status;
         pEvent->frequency = static_cast<uint32_t>(*((uint32_t*) p->pData));
@@ -1829,7 +2453,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
     {
         qCDebug(radioControl, "DABSDR_NID_ENSEMBLE_INFO: status %d", p->status);
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::ENSEMBLE_INFO;
         pEvent->status = p->status;        
         pEvent->pEnsembleInfo = new dabsdrNtfEnsemble_t;
@@ -1850,7 +2474,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
             pServiceList->append(item);
         }
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::SERVICE_LIST;
         pEvent->status = p->status;
         pEvent->pServiceList = pServiceList;
@@ -1871,7 +2495,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
                 pList->append(item);
             }
 
-            RadioControlEvent * pEvent = new RadioControlEvent;
+            RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
             pEvent->SId = pInfo->SId;
             pEvent->type = RadioControlEventType::SERVICE_COMPONENT_LIST;
             pEvent->status = p->status;
@@ -1887,7 +2511,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
     case DABSDR_NID_USER_APP_UPDATE:
     {
         const dabsdrNtfUserAppUpdate_t * pUserApps = (const dabsdrNtfUserAppUpdate_t * ) p->pData;
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::USER_APP_UPDATE;
         pEvent->status = p->status;
         pEvent->SId = pUserApps->SId;
@@ -1909,7 +2533,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
                 pList->append(item);
             }
 
-            RadioControlEvent * pEvent = new RadioControlEvent;
+            RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
             pEvent->type = RadioControlEventType::USER_APP_LIST;
             pEvent->status = p->status;
             pEvent->SId = pInfo->SId;
@@ -1927,7 +2551,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
     {
         const dabsdrNtfServiceSelection_t * pInfo = (const dabsdrNtfServiceSelection_t * ) p->pData;
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::SERVICE_SELECTION;
 
         pEvent->status = p->status;
@@ -1941,7 +2565,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
     {
         const dabsdrNtfServiceStop_t * pInfo = (const dabsdrNtfServiceStop_t * ) p->pData;
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::SERVICE_STOP;
 
         pEvent->status = p->status;
@@ -1956,7 +2580,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
         dabsdrNtfXpadAppStartStop_t * pServStopInfo = new dabsdrNtfXpadAppStartStop_t;
         memcpy(pServStopInfo, p->pData, sizeof(dabsdrNtfXpadAppStartStop_t));
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::XPAD_APP_START_STOP;
 
         pEvent->status = p->status;
@@ -1973,7 +2597,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
             dabsdrNtfPeriodic_t * pNotifyData = new dabsdrNtfPeriodic_t;
             memcpy((uint8_t*) pNotifyData, p->pData, p->len);
 
-            RadioControlEvent * pEvent = new RadioControlEvent;
+            RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
             pEvent->type = RadioControlEventType::AUTO_NOTIFICATION;
             pEvent->status = p->status;
             pEvent->pNotifyData = pNotifyData;
@@ -1985,7 +2609,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
     {
         qCDebug(radioControl, "DABSDR_NID_RECONFIGURATION: status %d", p->status);
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::RECONFIGURATION;
 
         pEvent->status = p->status;
@@ -1994,7 +2618,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
         break;
     case DABSDR_NID_RESET:
     {
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::RESET;
 
         pEvent->status = p->status;
@@ -2007,7 +2631,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
         dabsdrNtfAnnouncementSupport_t * pAnnouncementSupport = new dabsdrNtfAnnouncementSupport_t;
         memcpy(pAnnouncementSupport, p->pData, sizeof(dabsdrNtfAnnouncementSupport_t));
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::ANNOUNCEMENT_SUPPORT;
         pEvent->status = p->status;
         pEvent->SId = pAnnouncementSupport->SId;
@@ -2020,7 +2644,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
         dabsdrNtfAnnouncementSwitching_t * pAnnouncement = new dabsdrNtfAnnouncementSwitching_t;
         memcpy(pAnnouncement, p->pData, sizeof(dabsdrNtfAnnouncementSwitching_t));
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::ANNOUNCEMENT_SWITCHING;
         pEvent->status = p->status;
         pEvent->pAnnouncement = pAnnouncement;
@@ -2032,7 +2656,7 @@ void RadioControl::dabNotificationCb(dabsdrNotificationCBData_t * p, void * ctx)
         dabsdrNtfPTy_t * pPty = new dabsdrNtfPTy_t;
         memcpy(pPty, p->pData, sizeof(dabsdrNtfPTy_t));
 
-        RadioControlEvent * pEvent = new RadioControlEvent;
+        RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
         pEvent->type = RadioControlEventType::PROGRAMME_TYPE;
         pEvent->status = p->status;
         pEvent->SId = pPty->SId;
@@ -2055,13 +2679,12 @@ void RadioControl::dynamicLabelCb(dabsdrDynamicLabelCBData_t * p, void * ctx)
     }
     RadioControl * radioCtrl = static_cast<RadioControl *>(ctx);
 
-    RadioControlEvent * pEvent = new RadioControlEvent;
+    RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
     pEvent->type = RadioControlEventType::DATAGROUP_DL;
     pEvent->status = DABSDR_NSTAT_SUCCESS;
-    RadioControlDataDL * pDynamicLabelData = new RadioControlDataDL;
-    pDynamicLabelData->id = p->id;
-    pDynamicLabelData->data.append((const char *)p->pData, p->len);
-    pEvent->pDynamicLabelData = pDynamicLabelData;
+    pEvent->dynamicLabelData.id = p->id;
+    pEvent->dynamicLabelData.data = QByteArray((const char *)p->pData, p->len);
+    pEvent->pDynamicLabelData = &pEvent->dynamicLabelData;
     radioCtrl->emit_dabEvent(pEvent);
 }
 
@@ -2073,32 +2696,44 @@ void RadioControl::dataGroupCb(dabsdrDataGroupCBData_t * p, void * ctx)
         return;
     }
 
-    RadioControl * radioCtrl = static_cast<RadioControl *>(ctx);       
-    RadioControlUserAppData * pData = new RadioControlUserAppData;
+    RadioControl * radioCtrl = static_cast<RadioControl *>(ctx);
+
+    // data group ring has single producer, only primary receiver writes it
+    SharedMemoryExport * shm = SharedMemoryExport::instance();
+    if ((nullptr != shm) && (0 == radioCtrl->m_receiver))
+    {
+        shm->writeDataGroup(p->userAppType, p->SCId, p->pDgData, p->dgLen);
+    }
+
+    RadioControlEvent * pEvent = radioCtrl->m_eventQueue.acquire();
+    RadioControlUserAppData * pData = &pEvent->userAppData;
     pData->userAppType = DabUserApplicationType(p->userAppType);
     pData->id = p->id;
     pData->SCId = p->SCId;
     // copy data to QByteArray
     pData->data = QByteArray((const char *)p->pDgData, p->dgLen);
 
-    RadioControlEvent * pEvent = new RadioControlEvent;
     pEvent->type = RadioControlEventType::USERAPP_DATA;
     pEvent->status = DABSDR_NSTAT_SUCCESS;
     pEvent->pUserAppData = pData;
-    radioCtrl->emit_dabEvent(pEvent);        
+    radioCtrl->emit_dabEvent(pEvent);
 }
 
 void RadioControl::audioDataCb(dabsdrAudioCBData_t * p, void * ctx)
 {
     RadioControl * radioCtrl = static_cast<RadioControl *>(ctx);
 
+    // dabsdr does not provide frame counters => AU is tagged with capture time of the newest input sample
+    // it is upper bound of capture time, processing delay of dabsdr (time deinterleaving) is not included
+    uint64_t captureUs = inputFifo(radioCtrl->m_receiver)->readCaptureUs.load(std::memory_order_relaxed);
+
     switch (radioCtrl->m_currentService.announcement.switchState)
     {
     case AnnouncementSwitchState::NoAnnouncement:
     {   // no ennouncement ongoing
         if (DABSDR_ID_AUDIO_PRIMARY == p->id)
         {
-            RadioControlAudioData * pAudioData = new RadioControlAudioData;
+            RadioControlAudioData * pAudioData = RadioControlAudioDataPool::getInstance()->acquire(captureUs);
             pAudioData->id = p->id;
             pAudioData->ASCTy = static_cast<DabAudioDataSCty>(p->ASCTy);
             pAudioData->header = p->header;
@@ -2106,6 +2741,16 @@ void RadioControl::audioDataCb(dabsdrAudioCBData_t * p, void * ctx)
 
             radioCtrl->emit_audioData(pAudioData);
         }
+        else if (radioCtrl->m_audioSubscriptionActive)
+        {   // secondary instance is used by subscription
+            RadioControlAudioData * pAudioData = RadioControlAudioDataPool::getInstance()->acquire(captureUs);
+            pAudioData->id = p->id;
+            pAudioData->ASCTy = static_cast<DabAudioDataSCty>(p->ASCTy);
+            pAudioData->header = p->header;
+            pAudioData->data.assign(p->pAuData, p->pAuData+p->auLen);
+
+            radioCtrl->emit_audioData_Subscription(pAudioData);
+        }
         else
         {
             //qCDebug(radioControl) << "Ignoring announcement audio data";
@@ -2114,13 +2759,20 @@ void RadioControl::audioDataCb(dabsdrAudioCBData_t * p, void * ctx)
         break;
     case AnnouncementSwitchState::WaitForAnnouncement:
     {   // announcement expected
-        RadioControlAudioData * pAudioData = new RadioControlAudioData;
+        RadioControlAudioData * pAudioData = RadioControlAudioDataPool::getInstance()->acquire(captureUs);
         pAudioData->id = p->id;
         pAudioData->ASCTy = static_cast<DabAudioDataSCty>(p->ASCTy);
         pAudioData->header = p->header;
         pAudioData->data.assign(p->pAuData, p->pAuData+p->auLen);
 
-        radioCtrl->emit_audioData(pAudioData);
+        if (radioCtrl->m_announcementDecoderEna && (DABSDR_ID_AUDIO_SECONDARY == p->id))
+        {   // announcement decoder fills its buffer while service is still playing
+            radioCtrl->emit_audioData_Announcement(pAudioData);
+        }
+        else
+        {
+            radioCtrl->emit_audioData(pAudioData);
+        }
         if (DABSDR_ID_AUDIO_SECONDARY == p->id)
         {   // first announcement data increment value
             radioCtrl->emit_announcementAudioAvailable();
@@ -2130,9 +2782,26 @@ void RadioControl::audioDataCb(dabsdrAudioCBData_t * p, void * ctx)
         break;
     default:
     {   //
-        if (DABSDR_ID_AUDIO_SECONDARY == p->id)
+        if (radioCtrl->m_announcementDecoderEna)
+        {   // service is decoded during announcement to be ready when announcement ends
+            RadioControlAudioData * pAudioData = RadioControlAudioDataPool::getInstance()->acquire(captureUs);
+            pAudioData->id = p->id;
+            pAudioData->ASCTy = static_cast<DabAudioDataSCty>(p->ASCTy);
+            pAudioData->header = p->header;
+            pAudioData->data.assign(p->pAuData, p->pAuData+p->auLen);
+
+            if (DABSDR_ID_AUDIO_SECONDARY == p->id)
+            {
+                radioCtrl->emit_audioData_Announcement(pAudioData);
+            }
+            else
+            {
+                radioCtrl->emit_audioData(pAudioData);
+            }
+        }
+        else if (DABSDR_ID_AUDIO_SECONDARY == p->id)
         {
-            RadioControlAudioData * pAudioData = new RadioControlAudioData;
+            RadioControlAudioData * pAudioData = RadioControlAudioDataPool::getInstance()->acquire(captureUs);
             pAudioData->id = p->id;
             pAudioData->ASCTy = static_cast<DabAudioDataSCty>(p->ASCTy);
             pAudioData->header = p->header;
@@ -2147,3 +2816,161 @@ void RadioControl::audioDataCb(dabsdrAudioCBData_t * p, void * ctx)
     }
     }
 }
+
+RadioControlEventQueue::RadioControlEventQueue()
+{
+    m_events = new RadioControlEvent[RADIO_CONTROL_EVENT_QUEUE_SIZE];
+    for (int n = 0; n < RADIO_CONTROL_EVENT_QUEUE_SIZE; ++n)
+    {
+        m_freeRing.push(&m_events[n]);
+    }
+}
+
+RadioControlEventQueue::~RadioControlEventQueue()
+{
+    RadioControlEvent * pEvent;
+    while (nullptr != (pEvent = m_eventRing.pop()))
+    {   // only events allocated on overflow are deleted here, payload is dropped
+        if ((pEvent < m_events) || (pEvent >= m_events + RADIO_CONTROL_EVENT_QUEUE_SIZE))
+        {
+            delete pEvent;
+        }
+    }
+    delete [] m_events;
+}
+
+RadioControlEvent *RadioControlEventQueue::acquire()
+{
+    RadioControlEvent * pEvent = m_freeRing.pop();
+    if (nullptr == pEvent)
+    {   // all events are in queue -> fallback to allocation
+        if (!m_overflowReported)
+        {
+            m_overflowReported = true;
+            qCWarning(radioControl) << "Event pool exhausted";
+        }
+        pEvent = new RadioControlEvent;
+    }
+    return pEvent;
+}
+
+bool RadioControlEventQueue::push(RadioControlEvent *pEvent)
+{
+    pEvent->timestampUs = Diagnostics::timestampUs();
+    while (!m_eventRing.push(pEvent))
+    {   // this happens only when radioControl thread is blocked for very long time
+        QThread::yieldCurrentThread();
+    }
+    return !m_wakeupPending.exchange(true, std::memory_order_seq_cst);
+}
+
+RadioControlEvent *RadioControlEventQueue::pop()
+{
+    return m_eventRing.pop();
+}
+
+void RadioControlEventQueue::release(RadioControlEvent *pEvent)
+{
+    if ((pEvent >= m_events) && (pEvent < m_events + RADIO_CONTROL_EVENT_QUEUE_SIZE))
+    {   // release references to data groups
+        pEvent->userAppData.data.clear();
+        pEvent->dynamicLabelData.data.clear();
+        m_freeRing.push(pEvent);
+    }
+    else
+    {   // allocated on overflow
+        delete pEvent;
+    }
+}
+
+bool RadioControlEventQueue::Ring::push(RadioControlEvent *pEvent)
+{
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= RADIO_CONTROL_EVENT_QUEUE_SIZE)
+    {   // full
+        return false;
+    }
+    items[h & (RADIO_CONTROL_EVENT_QUEUE_SIZE - 1)] = pEvent;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+RadioControlEvent *RadioControlEventQueue::Ring::pop()
+{
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire))
+    {   // empty
+        return nullptr;
+    }
+    RadioControlEvent * pEvent = items[t & (RADIO_CONTROL_EVENT_QUEUE_SIZE - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return pEvent;
+}
+
+RadioControlAudioDataPool *RadioControlAudioDataPool::getInstance()
+{   // initialization is thread safe, receivers are initialized from their own threads
+    static RadioControlAudioDataPool instance;
+    return &instance;
+}
+
+RadioControlAudioDataPool::RadioControlAudioDataPool()
+{
+    m_items = new RadioControlAudioData[RADIO_CONTROL_AUDIO_DATA_POOL_SIZE];
+    m_freeList.reserve(RADIO_CONTROL_AUDIO_DATA_POOL_SIZE);
+    for (int n = RADIO_CONTROL_AUDIO_DATA_POOL_SIZE-1; n >= 0; --n)
+    {
+        m_items[n].data.reserve(RADIO_CONTROL_AUDIO_DATA_MAX_SIZE);
+        m_freeList.push_back(&m_items[n]);
+    }
+}
+
+RadioControlAudioDataPool::~RadioControlAudioDataPool()
+{
+    delete [] m_items;
+}
+
+RadioControlAudioData *RadioControlAudioDataPool::acquire(uint64_t captureUs)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_freeList.empty())
+        {
+            RadioControlAudioData * pData = m_freeList.back();
+            m_freeList.pop_back();
+            pData->timestampUs = Diagnostics::timestampUs();
+            pData->captureUs = captureUs;
+            return pData;
+        }
+    }
+
+    // pool is empty (decoder is blocked) -> fallback to allocation
+    if (!m_overflowReported)
+    {
+        m_overflowReported = true;
+        qCWarning(radioControl) << "Audio data pool exhausted";
+    }
+    RadioControlAudioData * pData = new RadioControlAudioData;
+    pData->data.reserve(RADIO_CONTROL_AUDIO_DATA_MAX_SIZE);
+    pData->timestampUs = Diagnostics::timestampUs();
+    pData->captureUs = captureUs;
+    return pData;
+}
+
+void RadioControlAudioDataPool::release(RadioControlAudioData *pData)
+{
+    if ((pData >= m_items) && (pData < m_items + RADIO_CONTROL_AUDIO_DATA_POOL_SIZE))
+    {   // data.clear() keeps capacity
+        pData->data.clear();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_freeList.push_back(pData);
+    }
+    else
+    {   // allocated on pool overflow
+        delete pData;
+    }
+}
+
+void RadioControlAudioData::release()
+{
+    RadioControlAudioDataPool::getInstance()->release(this);
+}
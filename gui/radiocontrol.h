@@ -30,11 +30,14 @@
 #include <QObject>
 #include <QMap>
 #include <QHash>
+#include <QSet>
 #include <QDateTime>
 #include <QStringList>
 #include <QDebug>
 #include <QTimer>
 #include <QThread>
+#include <mutex>
+#include <atomic>
 
 #include "dabtables.h"
 #include "dabsdr.h"
@@ -50,6 +53,18 @@
 #define RADIO_CONTROL_ENSEMBLE_CONFIGURATION_UPDATE_TIMEOUT_SEC (1)
 #define RADIO_CONTROL_ANNOUNCEMENT_TIMEOUT_SEC (5)
 
+// service following: alternative ensemble is requested when signal stays bad for hold time
+#define RADIO_CONTROL_SERVICE_FOLLOW_SNR_THR   (4.0)    // dB, SNR below threshold is considered bad
+#define RADIO_CONTROL_SERVICE_FOLLOW_HOLD_MS   (3000)   // shall cover acquisition time after tune
+
+// warm start: requested service is selected from configuration cached for the frequency when ensemble ID matches,
+// service list received afterwards confirms the selection or the service is selected again
+#define RADIO_CONTROL_WARM_START  1
+
+#define RADIO_CONTROL_AUDIO_DATA_POOL_SIZE  (128)   // number of preallocated AU buffers (~2.5 sec of HE-AAC)
+#define RADIO_CONTROL_AUDIO_DATA_MAX_SIZE  (3840)   // this is maximum AU size (HE-AAC superframe)
+#define RADIO_CONTROL_EVENT_QUEUE_SIZE     (1024)   // number of preallocated events, shall be power of 2
+
 // this is used for testing of receiver perfomance, it allows ensemble ECC = 0
 // and data services without user application
 #define RADIO_CONTROL_TEST_MODE 0
@@ -132,6 +147,7 @@ struct RadioControlEnsemble
     bool isValid() const { return (0 != frequency) && (RADIO_CONTROL_UEID_INVALID != ueid); }
 };
 Q_DECLARE_METATYPE(RadioControlEnsemble)
+Q_DECLARE_TYPEINFO(RadioControlEnsemble, Q_RELOCATABLE_TYPE);
 
 struct RadioControlUserApp
 {
@@ -147,7 +163,10 @@ struct RadioControlUserApp
     } xpadData;
     QList<uint8_t> uaData;  // optional user application data
 };
+Q_DECLARE_TYPEINFO(RadioControlUserApp, Q_RELOCATABLE_TYPE);
 
+// passed by value in queued signals: all variable size members are implicitly shared Qt containers,
+// copy is fixed size memcpy and reference counting, nothing is deep copied
 struct RadioControlServiceComponent
 {
     // Each service component shall be uniquely identified by the combination of the
@@ -203,6 +222,7 @@ struct RadioControlServiceComponent
     bool isDataPacketService() const { return DabTMId::PacketData == TMId; }
 };
 Q_DECLARE_METATYPE(RadioControlServiceComponent)
+Q_DECLARE_TYPEINFO(RadioControlServiceComponent, Q_RELOCATABLE_TYPE);
 
 typedef QMap<uint8_t, RadioControlServiceComponent> RadioControlServiceCompList;
 
@@ -229,7 +249,18 @@ struct RadioControlService
     RadioControlServiceCompList serviceComponents;
 };
 
-typedef QMap<uint32_t, RadioControlService> RadioControlServiceList;
+// services are looked up by SId in every notification handler, order is not significant
+typedef QHash<uint32_t, RadioControlService> RadioControlServiceList;
+
+// ensemble configuration is published incrementally, only changed services are rendered
+struct RadioControlEnsembleConfiguration
+{
+    bool reset = false;                  // all rows are replaced, empty ensemble means tuning to new frequency
+    QString ensemble;                    // ensemble information (HTML)
+    QMap<uint32_t, QString> services;    // added or changed services, SId -> HTML
+    QList<uint32_t> removed;             // removed services
+};
+Q_DECLARE_METATYPE(RadioControlEnsembleConfiguration)
 
 struct RadioControlDataDL
 {
@@ -251,6 +282,30 @@ struct RadioControlAudioData
     DabAudioDataSCty ASCTy;
     dabsdrAudioFrameHeader_t header;
     std::vector<uint8_t> data;
+    uint64_t timestampUs;   // diagnostics: time when AU was received from dabsdr
+    uint64_t captureUs;     // capture time of the newest input sample consumed by dabsdr when AU was received, 0 if unknown
+
+    // returns object to the pool, shall be called by receiver instead of delete
+    void release();
+};
+
+// preallocated AU buffers, audio path does not allocate memory in steady state
+// buffers are acquired in dabsdr thread and released by audio decoder
+class RadioControlAudioDataPool
+{
+public:
+    static RadioControlAudioDataPool * getInstance();
+    RadioControlAudioData * acquire(uint64_t captureUs = 0);
+    void release(RadioControlAudioData * pData);
+
+private:
+    RadioControlAudioDataPool();
+    ~RadioControlAudioDataPool();
+
+    RadioControlAudioData * m_items;
+    std::vector<RadioControlAudioData *> m_freeList;
+    std::mutex m_mutex;
+    bool m_overflowReported = false;
 };
 
 
@@ -289,6 +344,7 @@ struct RadioControlEvent
 {
     RadioControlEventType type;
     dabsdrNotificationStatus_t status;
+    uint64_t timestampUs;   // diagnostics: time when event was pushed to queue
     // service identification where needed
     uint32_t SId;
     uint8_t SCIdS;
@@ -326,6 +382,45 @@ struct RadioControlEvent
         dabsdrNtfPTy_t * pPty;
 
     };
+    // payload storage of data group events, pUserAppData and pDynamicLabelData point here
+    RadioControlUserAppData userAppData;
+    RadioControlDataDL dynamicLabelData;
+};
+
+// lock-free queue of preallocated events
+// single producer (dabsdr thread) and single consumer (radioControl thread)
+// consumed events are returned to producer through second ring
+class RadioControlEventQueue
+{
+public:
+    RadioControlEventQueue();
+    ~RadioControlEventQueue();
+
+    // producer
+    RadioControlEvent * acquire();
+    bool push(RadioControlEvent * pEvent);  // returns true when consumer shall be woken up
+
+    // consumer
+    RadioControlEvent * pop();
+    void release(RadioControlEvent * pEvent);
+    void clearWakeup() { m_wakeupPending.store(false, std::memory_order_seq_cst); }
+
+private:
+    struct Ring
+    {
+        std::atomic<uint32_t> head { 0 };
+        std::atomic<uint32_t> tail { 0 };
+        RadioControlEvent * items[RADIO_CONTROL_EVENT_QUEUE_SIZE];
+
+        bool push(RadioControlEvent * pEvent);
+        RadioControlEvent * pop();
+    };
+
+    RadioControlEvent * m_events;
+    Ring m_eventRing;   // dabsdr -> radioControl
+    Ring m_freeRing;    // radioControl -> dabsdr
+    std::atomic<bool> m_wakeupPending { false };
+    bool m_overflowReported = false;
 };
 
 class RadioControl : public QObject
@@ -335,7 +430,7 @@ public:
     explicit RadioControl(QObject *parent = nullptr);
     ~RadioControl();
 
-    bool init();
+    bool init(int receiver = 0);
     void start(uint32_t freq);
     void exit();
     void tuneService(uint32_t freq, uint32_t SId, uint8_t SCIdS);
@@ -345,14 +440,20 @@ public:
     void onAudioOutputRestart();
     void setupAnnouncements(uint16_t enaFlags);
     void suspendResumeAnnouncement();
+    // announcement on other service is decoded by separate decoder (audioData_Announcement)
+    // service audio continues in audioData so that output can crossfade between them
+    void setAnnouncementDecoder(bool ena) { m_announcementDecoderEna = ena; }
     void onSpiApplicationEnabled(bool enabled);
+    // low power monitoring: MSC decoding of current service is stopped, FIC processing continues
+    void setLowPowerMode(bool ena);
+    void subscribeServiceComponent(uint32_t SId, uint8_t SCIdS);
+    void unsubscribeServiceComponent(uint32_t SId, uint8_t SCIdS);
+    // service following is evaluated for primary receiver only
+    void setServiceFollowing(bool ena, float snrThreshold, int holdMs);
 
 signals:
-    void dabEvent(RadioControlEvent * pEvent);
+    void dabEventsAvailable();
     void signalState(uint8_t sync, float snr);
-    void freqOffset(float f);
-    void fibCounter(int expected, int errors);
-    void mscCounter(int correct, int errors);
     void tuneInputDevice(uint32_t freq);
     void tuneDone(uint32_t freq);
     void stopAudio();
@@ -367,19 +468,29 @@ signals:
     void audioData(RadioControlAudioData * pData);
     void dabTime(const QDateTime & dateAndTime);   
     void ensembleInformation(const RadioControlEnsemble & ens);
-    void ensembleConfiguration(const QString &);
+    void ensembleConfiguration(const RadioControlEnsembleConfiguration & config);
     void ensembleReconfiguration(const RadioControlEnsemble & ens);
     void ensembleRemoved(const RadioControlEnsemble & ens);
     void announcement(DabAnnouncement id, const RadioControlAnnouncementState state, const RadioControlServiceComponent & s);
     void announcementAudioAvailable();
+    void announcementAudioSelection(const RadioControlServiceComponent & s);
+    void announcementAudioStop();
+    void audioData_Announcement(RadioControlAudioData * pData);
     void programmeTypeChanged(const DabSId & sid, const struct DabPTy & pty);
+    void subscriptionStarted(const RadioControlServiceComponent & sc);
+    void subscriptionStopped(uint32_t SId, uint8_t SCIdS);
+    void userAppData_Subscription(const RadioControlUserAppData & data);
+    void audioData_Subscription(RadioControlAudioData * pData);
+    void serviceFollowRequest();
 private:
     enum class AnnouncementSwitchState { NoAnnouncement, WaitForAnnouncement, OngoingAnnouncement };
 
     static const uint8_t EEPCoderate[];
 
     dabsdrHandle_t m_dabsdrHandle;
-    dabsdrSyncLevel_t m_syncLevel;
+    int m_receiver = 0;
+    RadioControlEventQueue m_eventQueue;
+    dabsdrSyncLevel_t m_syncLevel = DABSDR_SYNC_LEVEL_NO_SYNC;
     bool m_enaAutoNotification = false;
     uint32_t m_frequency;
     struct {
@@ -408,6 +519,12 @@ private:
         } announcement;
     } m_currentService;
 
+    struct {
+        bool enabled = false;
+        int16_t snrThreshold10 = int16_t(RADIO_CONTROL_SERVICE_FOLLOW_SNR_THR * 10);
+        QTimer * timer;
+    } m_serviceFollow;
+
     // this is a counter of requests to check
     // when the service list is complete
     int m_numReqPendingServiceList = 0;
@@ -415,12 +532,45 @@ private:
     // set when ensemble information is complete
     QTimer * m_ensembleConfigurationTimer;
     bool m_ensembleConfigurationUpdateRequest = false;
+    QString m_ensembleConfigurationHeader;
+    QMap<uint32_t, QString> m_ensembleConfigurationCache;    // rendered services, SId -> HTML
+    QSet<uint32_t> m_ensembleConfigurationDirty;            // services to be rendered again
 
     bool m_isReconfigurationOngoing = false;
     bool m_spiAppEnabled = false;
+    bool m_lowPowerMode = false;
+
+    // service components decoded in addition to current service
+    // dabsdr has only two audio instances -> audio subscription uses secondary instance (not available for announcements then)
+    // data services use data instance, data groups are identified by SCId
+    struct RadioControlSubscription
+    {
+        uint32_t SId;
+        uint8_t SCIdS;
+    };
+    QHash<uint16_t, RadioControlSubscription> m_dataSubscriptions;
+    RadioControlSubscription m_audioSubscription = { 0, 0 };
+    std::atomic<bool> m_audioSubscriptionActive { false };
+    std::atomic<bool> m_announcementDecoderEna { false };
 
     RadioControlEnsemble m_ensemble;
     RadioControlServiceList m_serviceList;
+    // programme audio components by SubChId (announcements signal SubChId only), SubChId -> SId, SCIdS
+    // subchannel can be shared by components of several services, it is updated together with service components
+    QMultiHash<uint8_t, QPair<uint32_t, uint8_t>> m_audioSubChIndex;
+
+    // last complete configuration per frequency, used for warm start
+    struct WarmStartEnsemble
+    {
+        uint32_t ueid;
+        RadioControlServiceList serviceList;
+    };
+    QHash<uint32_t, WarmStartEnsemble> m_warmStartCache;
+    struct {
+        uint32_t SId = 0;       // 0 = no service selected from cache
+        uint8_t SCIdS = 0;
+        RadioControlServiceComponent component;
+    } m_warmStart;
 
     typedef RadioControlServiceCompList::iterator serviceComponentIterator;
     typedef RadioControlServiceCompList::const_iterator serviceComponentConstIterator;
@@ -433,13 +583,25 @@ private:
     QString toShortLabel(QString & label, uint16_t charField) const;
 
     void clearEnsemble();
-    QString ensembleConfigurationString() const;
-    void ensembleConfigurationUpdate();
+    void clearServiceList();
+    void warmStart();
+    void removeFromSubChIndex(uint32_t SId);
+    void updateSubChIndex(const RadioControlService & service);
+    // true when decoders and user applications of the component are not affected by reconfiguration
+    static bool isSameComponentConfiguration(const RadioControlServiceComponent & a, const RadioControlServiceComponent & b);
+    QString ensembleConfigurationHeader() const;
+    QString serviceConfigurationString(const RadioControlService & s) const;
+    bool ensembleConfigurationDiff(RadioControlEnsembleConfiguration & config);
+    void ensembleConfigurationUpdate(uint32_t sid);
     void ensembleConfigurationDispatch();
     bool isCurrentService(uint32_t sid, uint8_t scids) { return ((sid == m_currentService.SId) && (scids == m_currentService.SCIdS)); }
+    bool isSubscribed(uint32_t sid, uint8_t scids) const;
+    void clearSubscriptions();
     void resetCurrentService();
     void updateSignalState(dabsdrSyncLevel_t s, int16_t snr10);
+    static DabSyncLevel syncLevel(dabsdrSyncLevel_t s);
     void setCurrentServiceAnnouncementSupport();
+    void serviceFollowUpdate(bool isSignalBad);
     void onAnnouncementTimeout();
     void onAnnouncementAudioAvailable();
     void announcementHandler(dabsdrAsw_t *pAnnouncement);
@@ -471,8 +633,10 @@ private:
     void dabXPadAppStart(uint8_t appType, bool start, dabsdrDecoderId_t decoderId) { dabsdrRequest_XPadAppStart(m_dabsdrHandle, appType, start, decoderId); }
 
     // wrappers used in callback functions (emit requires class instance)
-    void emit_dabEvent(RadioControlEvent * pEvent) { emit dabEvent(pEvent); }
+    void emit_dabEvent(RadioControlEvent * pEvent) { if (m_eventQueue.push(pEvent)) { emit dabEventsAvailable(); } }
     void emit_audioData(RadioControlAudioData * pData) { emit audioData(pData); }
+    void emit_audioData_Subscription(RadioControlAudioData * pData) { emit audioData_Subscription(pData); }
+    void emit_audioData_Announcement(RadioControlAudioData * pData) { emit audioData_Announcement(pData); }
     void emit_announcementAudioAvailable() { emit announcementAudioAvailable(); }
 
     // static methods used as dabsdr library callbacks
@@ -481,6 +645,7 @@ private:
     static void dataGroupCb(dabsdrDataGroupCBData_t * p, void * ctx);
     static void audioDataCb(dabsdrAudioCBData_t * p, void * ctx);
 private slots:
+    void onDabEvents();
     void onDabEvent(RadioControlEvent * pEvent);
 };
 
@@ -0,0 +1,103 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SAMPLETIMESTAMPS_H
+#define SAMPLETIMESTAMPS_H
+
+#include <atomic>
+#include <cstdint>
+
+#define SAMPLETIMESTAMPS_MARKS  (512)    // marks kept for lookup (several seconds of device callbacks), power of 2
+
+// capture time of samples in single producer single consumer FIFO
+// producer marks stream position (total bytes written) with capture time of the last sample written,
+// consumer looks up capture time of any position that is still covered by marks
+// capture time of position between marks is extrapolated back from the next mark using stream byte rate
+// time is in microseconds of Diagnostics::timestampUs(), 0 means unknown
+class SampleTimestamps
+{
+public:
+    void reset()
+    {
+        for (auto & m : m_marks)
+        {
+            m.endPos.store(0, std::memory_order_relaxed);
+            m.timeUs.store(0, std::memory_order_relaxed);
+        }
+        m_next.store(0, std::memory_order_release);
+    }
+
+    // producer side: all data up to endPos are captured, last sample at timeUs
+    void mark(uint64_t endPos, uint64_t timeUs)
+    {
+        uint32_t idx = m_next.load(std::memory_order_relaxed);
+        Mark & m = m_marks[idx & (SAMPLETIMESTAMPS_MARKS - 1)];
+        m.timeUs.store(timeUs, std::memory_order_relaxed);
+        m.endPos.store(endPos, std::memory_order_release);
+        m_next.store(idx + 1, std::memory_order_release);
+    }
+
+    // consumer side: capture time of byte at pos
+    uint64_t captureUs(uint64_t pos, double bytesPerUs) const
+    {
+        uint32_t next = m_next.load(std::memory_order_acquire);
+        uint32_t numMarks = (next < SAMPLETIMESTAMPS_MARKS) ? next : SAMPLETIMESTAMPS_MARKS;
+
+        // the oldest mark at or after pos, marks are searched from the newest one
+        uint64_t endPos = 0;
+        uint64_t timeUs = 0;
+        bool isCovered = (numMarks < SAMPLETIMESTAMPS_MARKS);    // all marks are available
+        for (uint32_t n = 1; n <= numMarks; ++n)
+        {
+            const Mark & m = m_marks[(next - n) & (SAMPLETIMESTAMPS_MARKS - 1)];
+            uint64_t markPos = m.endPos.load(std::memory_order_acquire);
+            if (markPos < pos)
+            {
+                isCovered = true;
+                break;
+            }
+            endPos = markPos;
+            timeUs = m.timeUs.load(std::memory_order_relaxed);
+        }
+        if ((0 == timeUs) || !isCovered)
+        {   // not marked yet or marks were overwritten
+            return 0;
+        }
+        uint64_t deltaUs = uint64_t((endPos - pos) / bytesPerUs);
+        return (timeUs > deltaUs) ? (timeUs - deltaUs) : 0;
+    }
+
+private:
+    struct Mark
+    {
+        std::atomic<uint64_t> endPos { 0 };
+        std::atomic<uint64_t> timeUs { 0 };
+    };
+    Mark m_marks[SAMPLETIMESTAMPS_MARKS];
+    std::atomic<uint32_t> m_next { 0 };
+};
+
+#endif // SAMPLETIMESTAMPS_H
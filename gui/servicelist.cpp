@@ -25,6 +25,11 @@
  */
 
 #include <QLoggingCategory>
+#include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <algorithm>
 #include "servicelist.h"
 
 Q_LOGGING_CATEGORY(serviceList, "ServiceList", QtInfoMsg)
@@ -41,16 +46,7 @@ ServiceList::~ServiceList()
 
 void ServiceList::clear(bool clearFavorites)
 {
-    foreach (ServiceListItem * item, m_serviceList)
-    {
-        delete item;
-    }
     m_serviceList.clear();
-
-    foreach (EnsembleListItem * item, m_ensembleList)
-    {
-        delete item;
-    }
     m_ensembleList.clear();
 
     if (clearFavorites)
@@ -71,7 +67,7 @@ void ServiceList::addService(const RadioControlEnsemble & e, const RadioControlS
     bool newService = false;
     bool updatedService = false;
 
-    qCInfo(serviceList, "          [%6.6X @ %6d kHz | %3s] %-18s %X : %d", e.ueid, e.frequency, DabTables::channelList.value(e.frequency).toUtf8().data(),
+    qCInfo(serviceList, "          [%6.6X @ %6d kHz | %3s] %-18s %X : %d", e.ueid, e.frequency, DabTables::channelName(e.frequency).toUtf8().data(),
                                                                             s.label.toUtf8().data(), s.SId.value(), s.SCIdS);
 
 
@@ -80,8 +76,7 @@ void ServiceList::addService(const RadioControlEnsemble & e, const RadioControlS
     ServiceListIterator sit = m_serviceList.find(servId);
     if (m_serviceList.end() == sit)
     {  // not found
-        pService = new ServiceListItem(s, currentEns);
-        m_serviceList.insert(servId, pService);
+        pService = m_serviceList.emplace(servId, s, currentEns);
         if (fav)
         {
             m_favoritesList.insert(servId);
@@ -127,8 +122,7 @@ void ServiceList::addService(const RadioControlEnsemble & e, const RadioControlS
     }
     if (nullptr == pEns)
     {   // not found
-        pEns = new EnsembleListItem(e);
-        m_ensembleList.insert(ensId, pEns);
+        pEns = m_ensembleList.emplace(ensId, e);
     }
 
     // we have ens and service item => lets link them together
@@ -213,6 +207,37 @@ int ServiceList::currentEnsembleIdx(const ServiceListId & servId) const
     return 0;
 }
 
+QList<ServiceListAlternative> ServiceList::alternatives(const ServiceListId &servId, uint32_t excludeFreq) const
+{
+    QList<ServiceListAlternative> list;
+    ServiceListConstIterator sit = m_serviceList.find(servId);
+    if (m_serviceList.end() != sit)
+    {   // found
+        for (int e = 0; e < (*sit)->numEnsembles(); ++e)
+        {
+            const EnsembleListItem * ens = (*sit)->getEnsemble(e);
+            if (ens->frequency() != excludeFreq)
+            {
+                list.append({ ens->frequency(), ens->id(), ens->snr() });
+            }
+            else { /* current frequency */ }
+        }
+        std::stable_sort(list.begin(), list.end(), [](const ServiceListAlternative & a, const ServiceListAlternative & b) { return a.snr > b.snr; });
+    }
+    return list;
+}
+
+void ServiceList::storeEnsembleSnr(uint32_t frequency, float snr)
+{
+    for (auto & ens : m_ensembleList)
+    {
+        if (ens->frequency() == frequency)
+        {
+            ens->storeSnr(snr);
+        }
+    }
+}
+
 void ServiceList::save(QSettings & settings)
 {
     // first sort service list by ID
@@ -224,6 +249,14 @@ void ServiceList::save(QSettings & settings)
     }
     std::sort(idVect.begin(), idVect.end());
 
+    if (saveBinary(binaryFileName(settings), idVect))
+    {   // list from previous versions is not needed anymore
+        settings.remove("ServiceList");
+        return;
+    }
+    else
+    { /* store list to settings */ }
+
     settings.beginWriteArray("ServiceList", m_serviceList.size());          
     int n = 0;
     for (auto id : idVect)
@@ -255,6 +288,15 @@ void ServiceList::save(QSettings & settings)
 
 void ServiceList::load(QSettings & settings)
 {
+    emit updateStarted();
+    if (loadBinary(binaryFileName(settings)))
+    {
+        emit updateFinished();
+        return;
+    }
+    else
+    { /* file not available -> loading list stored in settings */ }
+
     int numServ = settings.beginReadArray("ServiceList");
     RadioControlServiceComponent item;
     RadioControlEnsemble ens;
@@ -306,6 +348,106 @@ void ServiceList::load(QSettings & settings)
         settings.endArray();
     }
     settings.endArray();
+    emit updateFinished();
+}
+
+QString ServiceList::binaryFileName(const QSettings &settings) const
+{
+    QFileInfo fi(settings.fileName());
+    return fi.absolutePath() + "/" + fi.completeBaseName() + ".servicelist";
+}
+
+bool ServiceList::saveBinary(const QString &fileName, const QVector<uint64_t> &idVect) const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << quint32(idVect.size());
+    for (auto id : idVect)
+    {
+        ServiceListConstIterator it = m_serviceList.constFind(ServiceListId(id));
+        out << quint32((*it)->SId().value()) << quint8((*it)->SCIdS()) << (*it)->label() << (*it)->shortLabel()
+            << m_favoritesList.contains(ServiceListId(id)) << qint32((*it)->currentEnsembleIdx());
+        out << quint32((*it)->numEnsembles());
+        for (int e = 0; e < (*it)->numEnsembles(); ++e)
+        {
+            const EnsembleListItem * ens = (*it)->getEnsemble(e);
+            out << quint32(ens->ueid()) << quint32(ens->frequency()) << ens->label() << ens->shortLabel();
+        }
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qCWarning(serviceList) << "Failed to store service list to" << fileName;
+        return false;
+    }
+
+    // header: magic, version, payload size, payload checksum
+    QDataStream header(&file);
+    header << quint32(SERVICELIST_FILE_MAGIC) << quint16(SERVICELIST_FILE_VERSION)
+           << quint32(data.size()) << quint16(qChecksum(data));
+    file.write(data);
+    if (!file.commit())
+    {
+        qCWarning(serviceList) << "Failed to store service list to" << fileName;
+        return false;
+    }
+    return true;
+}
+
+bool ServiceList::loadBinary(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream header(&file);
+    quint32 magic;
+    quint16 version;
+    quint32 size;
+    quint16 checksum;
+    header >> magic >> version >> size >> checksum;
+    if ((QDataStream::Ok != header.status()) || (SERVICELIST_FILE_MAGIC != magic) || (SERVICELIST_FILE_VERSION != version))
+    {
+        qCWarning(serviceList) << "Unsupported service list file" << fileName;
+        return false;
+    }
+    QByteArray data = file.read(size);
+    if ((data.size() != int(size)) || (qChecksum(data) != checksum))
+    {
+        qCWarning(serviceList) << "Service list file is corrupted" << fileName;
+        return false;
+    }
+
+    QDataStream in(data);
+    quint32 numServ;
+    in >> numServ;
+    RadioControlServiceComponent item;
+    RadioControlEnsemble ens;
+    for (quint32 s = 0; (s < numServ) && (QDataStream::Ok == in.status()); ++s)
+    {
+        quint32 sid;
+        quint8 scids;
+        bool fav;
+        qint32 currentEns;
+        quint32 numEns;
+        in >> sid >> scids >> item.label >> item.labelShort >> fav >> currentEns >> numEns;
+        item.SId.set(sid);
+        item.SCIdS = scids;
+        for (quint32 e = 0; (e < numEns) && (QDataStream::Ok == in.status()); ++e)
+        {
+            quint32 ueid;
+            quint32 frequency;
+            in >> ueid >> frequency >> ens.label >> ens.labelShort;
+            ens.ueid = ueid;
+            ens.frequency = frequency;
+            addService(ens, item, fav, currentEns);
+        }
+    }
+
+    return QDataStream::Ok == in.status();
 }
 
 // this marks all services as obsolete
@@ -355,8 +497,7 @@ void ServiceList::endEnsembleUpdate(const RadioControlEnsemble & e)
             {   // this was the last ensemble -> remove service completely
                 emit serviceRemoved((*it)->id());
 
-                delete *it;                    // release memory
-                it = m_serviceList.erase(it);  // remove record from hash                
+                it = m_serviceList.erase(it);  // releases item, last item is moved here
             }
             else
             {
@@ -381,7 +522,6 @@ void ServiceList::removeEnsemble(const RadioControlEnsemble &e)
         beginEnsembleUpdate(e);
         endEnsembleUpdate(e);
 
-        delete *eit;
         m_ensembleList.erase(eit);
 
         emit ensembleRemoved(ensId);
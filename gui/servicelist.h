@@ -42,11 +42,23 @@
 #include "servicelistid.h"
 #include "servicelistitem.h"
 #include "ensemblelistitem.h"
+#include "servicelistmap.h"
 
-typedef QHash<ServiceListId, ServiceListItem *>::Iterator ServiceListIterator;
-typedef QHash<ServiceListId, EnsembleListItem *>::Iterator EnsembleListIterator;
-typedef QHash<ServiceListId, ServiceListItem *>::ConstIterator ServiceListConstIterator;
-typedef QHash<ServiceListId, EnsembleListItem *>::ConstIterator EnsembleListConstIterator;
+#define SERVICELIST_FILE_MAGIC   0x4C534241   // "ABSL"
+#define SERVICELIST_FILE_VERSION 1
+
+// ensemble carrying service, candidate for service following
+struct ServiceListAlternative
+{
+    uint32_t frequency;     // kHz
+    ServiceListId ensId;
+    float snr;              // last SNR in full sync, 0 if ensemble was not received yet
+};
+
+typedef ServiceListMap<ServiceListItem>::Iterator ServiceListIterator;
+typedef ServiceListMap<EnsembleListItem>::Iterator EnsembleListIterator;
+typedef ServiceListMap<ServiceListItem>::Iterator ServiceListConstIterator;
+typedef ServiceListMap<EnsembleListItem>::Iterator EnsembleListConstIterator;
 
 class ServiceList : public QObject
 {
@@ -60,6 +72,10 @@ public:
     int numServices() const { return m_serviceList.size(); }
     int numEnsembles(const ServiceListId &servId = 0) const;
     int currentEnsembleIdx(const ServiceListId &servId) const;
+    // ensembles carrying service sorted by last SNR (best first), ensembles on excludeFreq are skipped
+    QList<ServiceListAlternative> alternatives(const ServiceListId &servId, uint32_t excludeFreq = 0) const;
+    // SNR is remembered for all ensembles on frequency (normally only one)
+    void storeEnsembleSnr(uint32_t frequency, float snr);
     void clear(bool clearFavorites = true);
 
     void setServiceFavorite(const ServiceListId &servId, bool ena);
@@ -70,6 +86,8 @@ public:
     EnsembleListConstIterator ensembleListBegin() const { return m_ensembleList.cbegin();}
     EnsembleListConstIterator ensembleListEnd() const { return m_ensembleList.cend();}
     EnsembleListConstIterator findEnsemble(const ServiceListId & id) const { return m_ensembleList.find(id); }
+    // service list is stored in binary file next to settings file,
+    // settings are used only when the file cannot be written or when loading list stored by previous versions
     void save(QSettings & settings);
     void load(QSettings & settings);
 
@@ -88,10 +106,19 @@ signals:
 
     void ensembleRemoved(const ServiceListId & ensId);
     void empty();
+
+    // emitted around bulk changes (loading of the list)
+    void updateStarted();
+    void updateFinished();
 private:
-    QHash<ServiceListId, ServiceListItem *> m_serviceList;
-    QHash<ServiceListId, EnsembleListItem *> m_ensembleList;
+    // items are owned by the maps
+    ServiceListMap<ServiceListItem> m_serviceList;
+    ServiceListMap<EnsembleListItem> m_ensembleList;
     QSet<ServiceListId> m_favoritesList;
+
+    QString binaryFileName(const QSettings & settings) const;
+    bool saveBinary(const QString & fileName, const QVector<uint64_t> & idVect) const;
+    bool loadBinary(const QString & fileName);
 };
 
 #endif // SERVICELIST_H
@@ -53,6 +53,15 @@ public:
 
     bool operator==(const ServiceListId & other) const { return other.m_id == m_id; }
 
+    // 64-bit finalizer (splitmix64), ID bits of frequency, UEID, SId and SCIdS are concentrated in few positions
+    uint32_t hash() const
+    {
+        uint64_t x = m_id;
+        x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+        x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+        return uint32_t(x ^ (x >> 31));
+    }
+
     // this is required for using it in hash
     operator uint64_t() const { return m_id;}
 private:
@@ -62,4 +71,6 @@ private:
     uint64_t calcEnsembleId(uint32_t freq, uint32_t ueid) { return (uint64_t(freq)<<32) | ueid; }
 };
 
+inline size_t qHash(const ServiceListId & id, size_t seed = 0) { return id.hash() ^ seed; }
+
 #endif // SERVICELISTID_H
@@ -0,0 +1,232 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SERVICELISTMAP_H
+#define SERVICELISTMAP_H
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "servicelistid.h"
+
+#define SERVICELISTMAP_MIN_SLOTS  (64)    // power of 2
+
+// open addressing map from ServiceListId to items owned by the map
+// keys and item pointers are stored in dense arrays -> iteration is a linear scan
+// hash table (linear probing, max load 0.5) keeps only precomputed hash and index to dense arrays
+// items live in pool with stable addresses, pointers to them are valid until the item is erased
+// erase moves last element to the erased position, iterators to other elements stay valid
+template <typename T>
+class ServiceListMap
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const ServiceListMap * map = nullptr, uint32_t idx = 0) : m_map(map), m_idx(idx) {}
+        T * const & operator*() const { return m_map->m_values[m_idx]; }
+        T * const & value() const { return m_map->m_values[m_idx]; }
+        ServiceListId key() const { return m_map->m_keys[m_idx]; }
+        Iterator & operator++() { ++m_idx; return *this; }
+        bool operator==(const Iterator & other) const { return m_idx == other.m_idx; }
+        bool operator!=(const Iterator & other) const { return m_idx != other.m_idx; }
+    private:
+        friend class ServiceListMap;
+        const ServiceListMap * m_map;
+        uint32_t m_idx;
+    };
+
+    ServiceListMap() = default;
+    ServiceListMap(const ServiceListMap &) = delete;
+    ServiceListMap & operator=(const ServiceListMap &) = delete;
+
+    int size() const { return int(m_keys.size()); }
+    bool isEmpty() const { return m_keys.empty(); }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, uint32_t(m_keys.size())); }
+    Iterator cbegin() const { return begin(); }
+    Iterator cend() const { return end(); }
+
+    Iterator find(const ServiceListId & key) const
+    {
+        int slot = findSlot(key, key.hash());
+        return (slot < 0) ? end() : Iterator(this, m_slots[slot].idx);
+    }
+    Iterator constFind(const ServiceListId & key) const { return find(key); }
+
+    // item is constructed in the map, key shall not be present already
+    template <typename... Args>
+    T * emplace(const ServiceListId & key, Args &&... args)
+    {
+        if (2 * (m_keys.size() + 1) > m_slots.size())
+        {
+            rehash((0 == m_slots.size()) ? SERVICELISTMAP_MIN_SLOTS : 2 * m_slots.size());
+        }
+
+        uint32_t poolIdx;
+        if (m_freePool.empty())
+        {
+            poolIdx = uint32_t(m_pool.size());
+            m_pool.emplace_back(std::in_place, std::forward<Args>(args)...);
+        }
+        else
+        {
+            poolIdx = m_freePool.back();
+            m_freePool.pop_back();
+            m_pool[poolIdx].emplace(std::forward<Args>(args)...);
+        }
+
+        uint32_t hash = key.hash();
+        uint32_t idx = uint32_t(m_keys.size());
+        m_keys.push_back(key);
+        m_values.push_back(&*m_pool[poolIdx]);
+        m_hashes.push_back(hash);
+        m_poolIdx.push_back(poolIdx);
+        insertSlot(hash, idx);
+
+        return m_values.back();
+    }
+
+    // returns iterator to element that took place of erased one (next element to visit)
+    Iterator erase(const Iterator & it)
+    {
+        uint32_t idx = it.m_idx;
+        eraseSlot(findSlot(m_keys[idx], m_hashes[idx]));
+
+        m_pool[m_poolIdx[idx]].reset();
+        m_freePool.push_back(m_poolIdx[idx]);
+
+        uint32_t last = uint32_t(m_keys.size()) - 1;
+        if (idx != last)
+        {   // last element is moved to erased position
+            m_slots[findSlot(m_keys[last], m_hashes[last])].idx = int32_t(idx);
+            m_keys[idx] = m_keys[last];
+            m_values[idx] = m_values[last];
+            m_hashes[idx] = m_hashes[last];
+            m_poolIdx[idx] = m_poolIdx[last];
+        }
+        else { /* last element erased */ }
+        m_keys.pop_back();
+        m_values.pop_back();
+        m_hashes.pop_back();
+        m_poolIdx.pop_back();
+
+        return Iterator(this, idx);
+    }
+
+    void clear()
+    {
+        m_keys.clear();
+        m_values.clear();
+        m_hashes.clear();
+        m_poolIdx.clear();
+        m_slots.clear();
+        m_pool.clear();
+        m_freePool.clear();
+    }
+
+private:
+    struct Slot
+    {
+        uint32_t hash;
+        int32_t idx = -1;   // index to dense arrays, -1 = empty slot
+    };
+
+    // dense arrays
+    std::vector<ServiceListId> m_keys;
+    std::vector<T *> m_values;
+    std::vector<uint32_t> m_hashes;
+    std::vector<uint32_t> m_poolIdx;
+
+    std::vector<Slot> m_slots;                  // size is power of 2
+    std::deque<std::optional<T>> m_pool;        // deque does not move elements when growing
+    std::vector<uint32_t> m_freePool;
+
+    int findSlot(const ServiceListId & key, uint32_t hash) const
+    {
+        if (m_slots.empty())
+        {
+            return -1;
+        }
+        uint32_t mask = uint32_t(m_slots.size()) - 1;
+        for (uint32_t s = hash & mask; ; s = (s + 1) & mask)
+        {
+            const Slot & slot = m_slots[s];
+            if (slot.idx < 0)
+            {
+                return -1;
+            }
+            if ((slot.hash == hash) && (m_keys[slot.idx] == key))
+            {
+                return int(s);
+            }
+        }
+    }
+
+    void insertSlot(uint32_t hash, uint32_t idx)
+    {
+        uint32_t mask = uint32_t(m_slots.size()) - 1;
+        uint32_t s = hash & mask;
+        while (m_slots[s].idx >= 0)
+        {
+            s = (s + 1) & mask;
+        }
+        m_slots[s].hash = hash;
+        m_slots[s].idx = int32_t(idx);
+    }
+
+    // backward shift deletion, no tombstones
+    void eraseSlot(int slot)
+    {
+        uint32_t mask = uint32_t(m_slots.size()) - 1;
+        uint32_t hole = uint32_t(slot);
+        for (uint32_t s = (hole + 1) & mask; m_slots[s].idx >= 0; s = (s + 1) & mask)
+        {
+            uint32_t home = m_slots[s].hash & mask;
+            if (((s - home) & mask) >= ((s - hole) & mask))
+            {   // element can be moved to the hole without passing its home slot
+                m_slots[hole] = m_slots[s];
+                hole = s;
+            }
+            else { /* element is at or closer to home than the hole */ }
+        }
+        m_slots[hole].idx = -1;
+    }
+
+    void rehash(size_t numSlots)
+    {
+        m_slots.assign(numSlots, Slot());
+        for (uint32_t idx = 0; idx < m_keys.size(); ++idx)
+        {
+            insertSlot(m_hashes[idx], idx);
+        }
+    }
+};
+
+#endif // SERVICELISTMAP_H
@@ -28,10 +28,12 @@
 #include <QFile>
 #include <QDebug>
 #include <QStandardItemModel>
+#include <QCompleter>
 
 #include "setupdialog.h"
 #include "./ui_setupdialog.h"
 #include "audiodecoder.h"
+#include "inputdeviceenumerator.h"
 
 SetupDialog::SetupDialog(QWidget *parent) : QDialog(parent), ui(new Ui::SetupDialog)
 {
@@ -64,6 +66,10 @@ SetupDialog::SetupDialog(QWidget *parent) : QDialog(parent), ui(new Ui::SetupDia
 
     ui->fileFormatCombo->insertItem(int(RawFileInputFormat::SAMPLE_FORMAT_U8), tr("Unsigned 8 bits"));
     ui->fileFormatCombo->insertItem(int(RawFileInputFormat::SAMPLE_FORMAT_S16), tr("Signed 16 bits"));
+    ui->fileFormatCombo->insertItem(int(RawFileInputFormat::SAMPLE_FORMAT_S8), tr("Signed 8 bits"));
+    ui->fileFormatCombo->insertItem(int(RawFileInputFormat::SAMPLE_FORMAT_U16), tr("Unsigned 16 bits"));
+    ui->fileFormatCombo->insertItem(int(RawFileInputFormat::SAMPLE_FORMAT_S12P), tr("Signed 12 bits packed"));
+    ui->fileFormatCombo->insertItem(int(RawFileInputFormat::SAMPLE_FORMAT_F32), tr("Float 32 bits"));
 
     // this has to be aligned with mainwindow
     ui->loopCheckbox->setChecked(false);
@@ -241,6 +247,16 @@ SetupDialog::SetupDialog(QWidget *parent) : QDialog(parent), ui(new Ui::SetupDia
     connect(ui->soapysdrBandwidth, &QSpinBox::valueChanged, this, &SetupDialog::onSoapySdrBandwidthChanged);
     connect(ui->soapysdrBandwidthDefault, &QPushButton::clicked, this, [this]() { ui->soapysdrBandwidth->setValue(0); } );
 #endif
+    m_soapysdrDevArgsModel = new QStringListModel(this);
+    QCompleter * devArgsCompleter = new QCompleter(m_soapysdrDevArgsModel, this);
+    devArgsCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    ui->soapysdrDevArgs->setCompleter(devArgsCompleter);
+
+    // devices are enumerated in background, results are shown when available
+    InputDeviceEnumerator * enumerator = InputDeviceEnumerator::getInstance();
+    connect(enumerator, &InputDeviceEnumerator::enumerationStarted, this, &SetupDialog::onDeviceEnumerationStarted, Qt::QueuedConnection);
+    connect(enumerator, &InputDeviceEnumerator::devicesFound, this, &SetupDialog::onDevicesFound, Qt::QueuedConnection);
+    enumerator->refresh();
 
     ui->defaultStyleRadioButton->setText(tr("Default style (OS dependent)"));
     ui->lightStyleRadioButton->setText(tr("Light style (Fusion with light colors)"));
@@ -266,6 +282,7 @@ SetupDialog::SetupDialog(QWidget *parent) : QDialog(parent), ui(new Ui::SetupDia
     ui->expertCheckBox->setToolTip(tr("User interface in expert mode"));
     ui->dlPlusCheckBox->setToolTip(tr("Show Dynamic Label Plus (DL+) tags like artist, song name, etc."));
     ui->xmlHeaderCheckBox->setToolTip(tr("Include raw file XML header in IQ recording"));
+    ui->rawCompressionCheckBox->setToolTip(tr("Compress IQ recording losslessly, XML header is always included"));
 
     ui->audioRecordingFolderLabel->setElideMode(Qt::ElideLeft);
 
@@ -275,6 +292,7 @@ SetupDialog::SetupDialog(QWidget *parent) : QDialog(parent), ui(new Ui::SetupDia
     connect(ui->expertCheckBox, &QCheckBox::clicked, this, &SetupDialog::onExpertModeChecked);
     connect(ui->dlPlusCheckBox, &QCheckBox::clicked, this, &SetupDialog::onDLPlusChecked);
     connect(ui->xmlHeaderCheckBox, &QCheckBox::clicked, this, &SetupDialog::onXmlHeaderChecked);
+    connect(ui->rawCompressionCheckBox, &QCheckBox::clicked, this, &SetupDialog::onRawCompressionChecked);
     connect(ui->spiAppCheckBox, &QCheckBox::clicked, this, &SetupDialog::onSpiAppChecked);
     connect(ui->internetCheckBox, &QCheckBox::clicked, this, &SetupDialog::onUseInternetChecked);
     connect(ui->radioDNSCheckBox, &QCheckBox::clicked, this, &SetupDialog::onRadioDnsChecked);
@@ -296,7 +314,14 @@ SetupDialog::SetupDialog(QWidget *parent) : QDialog(parent), ui(new Ui::SetupDia
     connect(ui->dumpSpiPatternReset, &QPushButton::clicked, this, &SetupDialog::onDataDumpResetClicked);
     connect(ui->dumpSlsPatternEdit, &QLineEdit::editingFinished, this, &SetupDialog::onDataDumpPatternEditingFinished);
     connect(ui->dumpSpiPatternEdit, &QLineEdit::editingFinished, this, &SetupDialog::onDataDumpPatternEditingFinished);
-    connect(ui->rawFileProgressBar, &QProgressBar::valueChanged, this, &SetupDialog::onRawFileProgressChanged);            
+    connect(ui->rawFileSlider, &QSlider::valueChanged, this, &SetupDialog::onRawFileProgressChanged);
+    connect(ui->rawFileSlider, &QSlider::sliderReleased, this, [this]() { emit rawFileSeek(ui->rawFileSlider->value()); });
+    connect(ui->rawFileSlider, &QSlider::actionTriggered, this, [this](int action) {
+        if ((QAbstractSlider::SliderPageStepAdd == action) || (QAbstractSlider::SliderPageStepSub == action))
+        {   // click to slider groove
+            emit rawFileSeek(ui->rawFileSlider->sliderPosition());
+        }
+    });
     // reset UI
     onFileLength(0);
 
@@ -315,6 +340,17 @@ SetupDialog::SetupDialog(QWidget *parent) : QDialog(parent), ui(new Ui::SetupDia
 #else
     ui->audioDecoderGroupBox->setVisible(false);
 #endif
+
+    ui->audioLatencyCombo->addItem(tr("Default"), QVariant(0));
+    ui->audioLatencyCombo->addItem("100 ms", QVariant(100));
+    ui->audioLatencyCombo->addItem("150 ms", QVariant(150));
+    ui->audioLatencyCombo->addItem("200 ms", QVariant(200));
+    ui->audioLatencyCombo->addItem("300 ms", QVariant(300));
+    ui->audioLatencyCombo->addItem("500 ms", QVariant(500));
+    ui->audioLatencyCombo->setToolTip(tr("Select target latency of audio output.<br>"
+                                         "Buffer is adapted to audio jitter and clock drift is compensated by resampling. "
+                                         "Default setting uses large buffer."));
+    connect(ui->audioLatencyCombo, &QComboBox::currentIndexChanged, this, &SetupDialog::onAudioLatencyChanged);
     QTimer::singleShot(10, this, [this](){ resize(minimumSizeHint()); } );
 }
 
@@ -322,6 +358,9 @@ void SetupDialog::showEvent(QShowEvent *event)
 {
     ui->tabWidget->setFocus();
 
+    // devices might have been connected meanwhile
+    InputDeviceEnumerator::getInstance()->refresh();
+
     QDialog::showEvent(event);
 
     //QTimer::singleShot(10, this, [this](){ adjustSize(); } );
@@ -392,7 +431,9 @@ void SetupDialog::setSettings(const Settings &settings)
     setStatusLabel();    
     emit newAnnouncementSettings();
     emit noiseConcealmentLevelChanged(m_settings.noiseConcealmentLevel);
+    emit audioLatencyChanged(m_settings.audioLatencyMs);
     emit xmlHeaderToggled(m_settings.xmlHeaderEna);
+    emit rawCompressionToggled(m_settings.rawCompressionEna);
     emit audioRecordingSettings(m_settings.audioRecFolder, m_settings.audioRecCaptureOutput);
     emit uaDumpSettings(m_settings.uaDump);
     onUseInternetChecked(m_settings.useInternet);
@@ -401,7 +442,7 @@ void SetupDialog::setSettings(const Settings &settings)
 
 void SetupDialog::setXmlHeader(const InputDeviceDescription &desc)
 {
-    if (desc.rawFile.hasXmlHeader)
+    if (desc.rawFile.hasXmlHeader || desc.rawFile.hasWavHeader)
     {
         m_xmlHeaderLabel[SetupDialogXmlHeader::XMLDate]->setText(desc.rawFile.time);
         m_xmlHeaderLabel[SetupDialogXmlHeader::XMLRecorder]->setText(desc.rawFile.recorder);
@@ -411,15 +452,7 @@ void SetupDialog::setXmlHeader(const InputDeviceDescription &desc)
         m_xmlHeaderLabel[SetupDialogXmlHeader::XMLLength]->setText(QString::number(desc.rawFile.numSamples * 1.0 / desc.sample.sampleRate));
         m_xmlHeaderLabel[SetupDialogXmlHeader::XMLFormat]->setText(desc.sample.channelContainer);
 
-        switch (desc.sample.containerBits)
-        {
-        case 8:
-            m_settings.rawfile.format = RawFileInputFormat::SAMPLE_FORMAT_U8;
-            break;
-        case 16:
-            m_settings.rawfile.format = RawFileInputFormat::SAMPLE_FORMAT_S16;
-            break;
-        }
+        RawFileInput::formatFromName(desc.sample.channelContainer, m_settings.rawfile.format);
         ui->fileFormatCombo->setCurrentIndex(static_cast<int>(m_settings.rawfile.format));
         ui->fileFormatCombo->setEnabled(false);
         ui->xmlHeaderWidget->setVisible(true);
@@ -433,18 +466,21 @@ void SetupDialog::setXmlHeader(const InputDeviceDescription &desc)
 
 void SetupDialog::onFileLength(int msec)
 {    
-    ui->rawFileProgressBar->setMinimum(0);
-    ui->rawFileProgressBar->setMaximum(msec);
-    ui->rawFileProgressBar->setValue(0);
+    ui->rawFileSlider->setMinimum(0);
+    ui->rawFileSlider->setMaximum(msec);
+    ui->rawFileSlider->setValue(0);
     onRawFileProgressChanged(0);
 
-    ui->rawFileProgressBar->setVisible(0 != msec);
+    ui->rawFileSlider->setVisible(0 != msec);
     ui->rawFileTime->setVisible(0 != msec);
 }
 
 void SetupDialog::onFileProgress(int msec)
 {
-    ui->rawFileProgressBar->setValue(msec);
+    if (!ui->rawFileSlider->isSliderDown())
+    {   // user is not dragging the slider
+        ui->rawFileSlider->setValue(msec);
+    }
 }
 
 void SetupDialog::setAudioRecAutoStop(bool ena)
@@ -650,7 +686,14 @@ void SetupDialog::setUiState()
         index = 0;
     }
     ui->noiseConcealmentCombo->setCurrentIndex(index);
+    index = ui->audioLatencyCombo->findData(QVariant(m_settings.audioLatencyMs));
+    if (index < 0)
+    {   // not found
+        index = 0;
+    }
+    ui->audioLatencyCombo->setCurrentIndex(index);
     ui->xmlHeaderCheckBox->setChecked(m_settings.xmlHeaderEna);
+    ui->rawCompressionCheckBox->setChecked(m_settings.rawCompressionEna);
     ui->spiAppCheckBox->setChecked(m_settings.spiAppEna);
     ui->internetCheckBox->setChecked(m_settings.useInternet);
     ui->radioDNSCheckBox->setChecked(m_settings.radioDnsEna);
@@ -1084,6 +1127,43 @@ void SetupDialog::setStatusLabel()
     }
 }
 
+void SetupDialog::onDeviceEnumerationStarted()
+{
+    ui->soapysdrDevArgs->setPlaceholderText(tr("Searching for devices..."));
+}
+
+void SetupDialog::onDevicesFound(InputDeviceId id)
+{
+    QList<InputDeviceListItem> list;
+    if (!InputDeviceEnumerator::getInstance()->devices(id, list))
+    {
+        return;
+    }
+
+    QStringList labels;
+    for (const auto & item : std::as_const(list))
+    {
+        labels.append(item.label);
+    }
+
+    int idx = ui->inputCombo->findData(QVariant(int(id)));
+    if (idx >= 0)
+    {
+        ui->inputCombo->setItemData(idx, list.isEmpty() ? tr("No device found") : labels.join('\n'), Qt::ToolTipRole);
+    }
+
+    if (InputDeviceId::SOAPYSDR == id)
+    {
+        QStringList args;
+        for (const auto & item : std::as_const(list))
+        {
+            args.append(item.args);
+        }
+        m_soapysdrDevArgsModel->setStringList(args);
+        ui->soapysdrDevArgs->setPlaceholderText(list.isEmpty() ? tr("No device found") : tr("%n device(s) found", "", list.size()));
+    }
+}
+
 void SetupDialog::onInputChanged(int index)
 {
     int inputDeviceInt = ui->inputCombo->itemData(index).toInt();
@@ -1125,19 +1205,16 @@ void SetupDialog::onOpenFileButtonClicked()
     {
         dir = QFileInfo(m_rawfilename).path();
     }
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Open IQ stream"), dir, tr("Binary files")+" (*.bin *.s16 *.u8 *.raw *.sdr *.uff)");
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open IQ stream"), dir, tr("Binary files")+" (*.bin *.s16 *.u8 *.raw *.sdr *.uff *.uffz *.cu8 *.cs8 *.cs16 *.cu16 *.cs12 *.cf32 *.wav)");
     if (!fileName.isEmpty())
     {
         m_rawfilename = fileName;
         ui->fileNameLabel->setText(fileName);
         ui->fileNameLabel->setToolTip(fileName);
-        if (fileName.endsWith(".s16"))
-        {
-            ui->fileFormatCombo->setCurrentIndex(int(RawFileInputFormat::SAMPLE_FORMAT_S16));
-        }
-        else if (fileName.endsWith(".u8"))
-        {
-            ui->fileFormatCombo->setCurrentIndex(int(RawFileInputFormat::SAMPLE_FORMAT_U8));
+        RawFileInputFormat format;
+        if (RawFileInput::formatFromName(QFileInfo(fileName).suffix(), format))
+        {   // .u8, .s16, .cf32, ...
+            ui->fileFormatCombo->setCurrentIndex(int(format));
         }
         else
         {   /* format cannot be guessed from extension - if XML header is recognized, then it will be set automatically */ }
@@ -1186,6 +1263,17 @@ void SetupDialog::resetInputDevice()
     ui->connectButton->setVisible(true);
 }
 
+bool SetupDialog::reconnectInputDevice(const InputDeviceId &id)
+{   // same as user clicking connect button, only if device selection was not changed meanwhile
+    if ((InputDeviceId::UNDEFINED != m_settings.inputDevice)
+        || (id != static_cast<InputDeviceId>(ui->inputCombo->itemData(ui->inputCombo->currentIndex()).toInt())))
+    {
+        return false;
+    }
+    onConnectDeviceClicked();
+    return true;
+}
+
 void SetupDialog::onAnnouncementClicked()
 {   // calculate ena flag
     uint16_t announcementEna = 0;
@@ -1290,15 +1378,31 @@ void SetupDialog::onNoiseLevelChanged(int index)
     }
 }
 
+void SetupDialog::onAudioLatencyChanged(int index)
+{
+    int latency = ui->audioLatencyCombo->itemData(index).toInt();
+    if (latency != m_settings.audioLatencyMs)
+    {
+        m_settings.audioLatencyMs = latency;
+        emit audioLatencyChanged(latency);
+    }
+}
+
 void SetupDialog::onXmlHeaderChecked(bool checked)
 {
     m_settings.xmlHeaderEna = checked;
     emit xmlHeaderToggled(checked);
 }
 
+void SetupDialog::onRawCompressionChecked(bool checked)
+{
+    m_settings.rawCompressionEna = checked;
+    emit rawCompressionToggled(checked);
+}
+
 void SetupDialog::onRawFileProgressChanged(int val)
 {
-    ui->rawFileTime->setText(QString("%1 / %2 "+tr("sec")).arg(val/1000.0, 0, 'f', 1).arg(ui->rawFileProgressBar->maximum()/1000.0, 0, 'f', 1));
+    ui->rawFileTime->setText(QString("%1 / %2 "+tr("sec")).arg(val/1000.0, 0, 'f', 1).arg(ui->rawFileSlider->maximum()/1000.0, 0, 'f', 1));
 }
 
 void SetupDialog::onSpiAppChecked(bool checked)
@@ -32,6 +32,7 @@
 #include <QList>
 #include <QAbstractButton>
 #include <QLocale>
+#include <QStringListModel>
 #include "QtWidgets/qcheckbox.h"
 #include "QtWidgets/qlabel.h"
 #include "config.h"
@@ -70,6 +71,8 @@ public:
             bool biasT;
             int agcLevelMax;
             int ppm;
+            int asyncBufNum;        // USB transfers (ini file only)
+            int asyncBufLen;
         } rtlsdr;
         struct
         {
@@ -79,6 +82,7 @@ public:
             int tcpPort;
             int agcLevelMax;
             int ppm;
+            bool packedTransport;   // request 4-bit transport extension
         } rtltcp;
 #if HAVE_AIRSPY
         struct
@@ -87,6 +91,7 @@ public:
             bool biasT;
             bool dataPacking;
             bool prefer4096kHz;
+            bool wideband;          // neighbouring channels are tuned digitally
         } airspy;
 #endif
 #if HAVE_SOAPYSDR
@@ -107,7 +112,9 @@ public:
         bool expertModeEna;
         bool dlPlusEna;
         int noiseConcealmentLevel;
+        int audioLatencyMs;
         bool xmlHeaderEna;
+        bool rawCompressionEna;
         bool spiAppEna;
         bool useInternet;
         bool radioDnsEna;
@@ -131,6 +138,7 @@ public:
     Settings settings() const;
     void setGainValues(const QList<float> & gainList);
     void resetInputDevice();
+    bool reconnectInputDevice(const InputDeviceId & id);
     void setSettings(const Settings &settings);
     void setXmlHeader(const InputDeviceDescription & desc);
     void onFileLength(int msec);
@@ -149,7 +157,10 @@ signals:
     void expertModeToggled(bool enabled);
     void applicationStyleChanged(ApplicationStyle style);
     void noiseConcealmentLevelChanged(int level);
+    void audioLatencyChanged(int latencyMs);
     void xmlHeaderToggled(bool enabled);
+    void rawCompressionToggled(bool enabled);
+    void rawFileSeek(int msec);
     void spiApplicationEnabled(bool enabled);
     void spiApplicationSettingsChanged(bool useInterent, bool enaRadioDNS);
     void audioRecordingSettings(const QString &folder, bool doOutputRecording);
@@ -177,6 +188,7 @@ private:
     QLabel * m_xmlHeaderLabel[SetupDialogXmlHeader::XMLNumLabels];
     QString m_slsDumpPaternDefault;
     QString m_spiDumpPaternDefault;
+    QStringListModel * m_soapysdrDevArgsModel;     // completer of device arguments from enumeration
 
     void setUiState();
     void setStatusLabel();
@@ -186,6 +198,8 @@ private:
     void onOpenFileButtonClicked();
 
     void onConnectDeviceClicked();
+    void onDevicesFound(InputDeviceId id);
+    void onDeviceEnumerationStarted();
 
     void onRtlSdrGainModeToggled(bool checked);
     void onRtlSdrGainSliderChanged(int val);
@@ -212,7 +226,9 @@ private:
     void onDLPlusChecked(bool checked);
     void onLanguageChanged(int index);
     void onNoiseLevelChanged(int index);    
+    void onAudioLatencyChanged(int index);
     void onXmlHeaderChecked(bool checked);
+    void onRawCompressionChecked(bool checked);
     void onRawFileProgressChanged(int val);
     void onSpiAppChecked(bool checked);
     void onUseInternetChecked(bool checked);
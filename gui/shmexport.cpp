@@ -0,0 +1,251 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QLoggingCategory>
+#include <cstring>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "shmexport.h"
+
+Q_LOGGING_CATEGORY(shmExport, "ShmExport", QtInfoMsg)
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "64-bit atomics are required for shared memory export");
+static_assert(sizeof(shmexport_record_t) == 24, "Unexpected size of shmexport_record_t");
+
+// every value in shared memory written by producer and polled by readers is accessed as atomic
+#define SHMEXPORT_ATOMIC(T, x) (*reinterpret_cast<std::atomic<T> *>(const_cast<T *>(&(x))))
+
+std::atomic<SharedMemoryExport *> SharedMemoryExport::m_instancePtr { nullptr };
+
+bool SharedMemoryExport::start(const QString &name)
+{
+    if (nullptr != instance())
+    {   // already running
+        return true;
+    }
+
+    SharedMemoryExport * shm = new SharedMemoryExport();
+    if (!shm->open(name))
+    {
+        delete shm;
+        return false;
+    }
+    m_instancePtr.store(shm, std::memory_order_release);
+    return true;
+}
+
+void SharedMemoryExport::stop()
+{
+    delete m_instancePtr.exchange(nullptr);
+}
+
+bool SharedMemoryExport::open(const QString &name)
+{
+    const uint64_t ringSize[SHMEXPORT_NUM_RINGS] = { SHMEXPORT_AUDIO_RING_SIZE, SHMEXPORT_DATAGROUP_RING_SIZE,
+                                                     SHMEXPORT_DL_RING_SIZE, SHMEXPORT_TELEMETRY_RING_SIZE };
+    const uint64_t dataOffset = (sizeof(shmexport_header_t) + 63) & ~uint64_t(63);
+    m_mappingSize = dataOffset;
+    for (int r = 0; r < SHMEXPORT_NUM_RINGS; ++r)
+    {
+        m_mappingSize += ringSize[r];
+    }
+    m_name = name;
+
+#if defined(_WIN32)
+    QString mappingName = "Local\\" + name;
+    m_handle = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, DWORD(uint64_t(m_mappingSize) >> 32), DWORD(m_mappingSize & 0xFFFFFFFF),
+                                  reinterpret_cast<LPCWSTR>(mappingName.utf16()));
+    if (NULL == m_handle)
+    {
+        qCWarning(shmExport) << "Failed to create file mapping" << mappingName << GetLastError();
+        return false;
+    }
+    m_mapping = static_cast<uint8_t *>(MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, m_mappingSize));
+    if (nullptr == m_mapping)
+    {
+        qCWarning(shmExport) << "Failed to map" << mappingName << GetLastError();
+        return false;
+    }
+#else
+    QByteArray shmName = "/" + name.toUtf8();
+    m_fd = shm_open(shmName.constData(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0)
+    {
+        qCWarning(shmExport) << "Failed to open shared memory" << shmName << strerror(errno);
+        return false;
+    }
+    if (0 != ftruncate(m_fd, m_mappingSize))
+    {
+        qCWarning(shmExport) << "Failed to resize shared memory" << shmName << strerror(errno);
+        return false;
+    }
+    void * addr = mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (MAP_FAILED == addr)
+    {
+        qCWarning(shmExport) << "Failed to map shared memory" << shmName << strerror(errno);
+        return false;
+    }
+    m_mapping = static_cast<uint8_t *>(addr);
+#endif
+
+    m_header = reinterpret_cast<shmexport_header_t *>(m_mapping);
+    memset(m_header, 0, sizeof(shmexport_header_t));
+    m_header->version = SHMEXPORT_VERSION;
+    m_header->header_size = sizeof(shmexport_header_t);
+    m_header->pid = uint32_t(QCoreApplication::applicationPid());
+    uint64_t offset = dataOffset;
+    for (int r = 0; r < SHMEXPORT_NUM_RINGS; ++r)
+    {
+        m_header->ring[r].data_offset = offset;
+        m_header->ring[r].size = ringSize[r];
+        offset += ringSize[r];
+    }
+
+    // magic is written last, readers can check it to know that header is valid
+    SHMEXPORT_ATOMIC(uint32_t, m_header->magic).store(SHMEXPORT_MAGIC, std::memory_order_release);
+
+    qCInfo(shmExport) << "Shared memory export started:" << name << m_mappingSize << "bytes";
+    return true;
+}
+
+SharedMemoryExport::~SharedMemoryExport()
+{
+#if defined(_WIN32)
+    if (nullptr != m_mapping)
+    {
+        UnmapViewOfFile(m_mapping);
+    }
+    if (nullptr != m_handle)
+    {
+        CloseHandle(m_handle);
+    }
+#else
+    if (nullptr != m_mapping)
+    {
+        munmap(m_mapping, m_mappingSize);
+    }
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        shm_unlink(("/" + m_name.toUtf8()).constData());
+    }
+#endif
+}
+
+void SharedMemoryExport::writeBytes(int ringId, uint64_t pos, const void *data, uint64_t len)
+{
+    const shmexport_ring_t & ring = m_header->ring[ringId];
+    uint8_t * base = m_mapping + ring.data_offset;
+    uint64_t offset = pos & (ring.size - 1);
+    uint64_t bytesToEnd = std::min(len, ring.size - offset);
+    memcpy(base + offset, data, bytesToEnd);
+    if (bytesToEnd < len)
+    {
+        memcpy(base, static_cast<const uint8_t *>(data) + bytesToEnd, len - bytesToEnd);
+    }
+}
+
+void SharedMemoryExport::commit(int ringId, uint64_t pos)
+{
+    SHMEXPORT_ATOMIC(uint64_t, m_header->ring[ringId].write_pos).store(pos, std::memory_order_release);
+}
+
+void SharedMemoryExport::writeRecord(int ringId, uint16_t type, uint32_t arg0, uint32_t arg1, const void *payload, uint32_t len)
+{
+    uint64_t recordSize = (sizeof(shmexport_record_t) + len + 7) & ~uint64_t(7);
+    if (recordSize > m_header->ring[ringId].size / 2)
+    {   // record does not fit
+        return;
+    }
+
+    shmexport_record_t record;
+    record.size = len;
+    record.type = type;
+    record.reserved = 0;
+    record.timestamp_ms = QDateTime::currentMSecsSinceEpoch();
+    record.arg0 = arg0;
+    record.arg1 = arg1;
+
+    uint64_t pos = SHMEXPORT_ATOMIC(uint64_t, m_header->ring[ringId].write_pos).load(std::memory_order_relaxed);
+    writeBytes(ringId, pos, &record, sizeof(record));
+    writeBytes(ringId, pos + sizeof(record), payload, len);
+    commit(ringId, pos + recordSize);
+}
+
+void SharedMemoryExport::setAudioFormat(uint32_t sampleRate, uint8_t numChannels)
+{
+    m_header->audio_sample_rate = sampleRate;
+    m_header->audio_channels = numChannels;
+#if HAVE_AUDIO_FLOAT32
+    m_header->audio_sample_format = SHMEXPORT_SAMPLE_FLOAT32;
+#else
+    m_header->audio_sample_format = SHMEXPORT_SAMPLE_INT16;
+#endif
+    m_header->audio_format_pos = SHMEXPORT_ATOMIC(uint64_t, m_header->ring[SHMEXPORT_RING_AUDIO].write_pos).load(std::memory_order_relaxed);
+    SHMEXPORT_ATOMIC(uint32_t, m_header->audio_generation).fetch_add(1, std::memory_order_release);
+}
+
+void SharedMemoryExport::writeAudio(const audioSample_t *data, uint32_t numSamples)
+{
+    uint64_t pos = SHMEXPORT_ATOMIC(uint64_t, m_header->ring[SHMEXPORT_RING_AUDIO].write_pos).load(std::memory_order_relaxed);
+    uint64_t len = numSamples * sizeof(audioSample_t);
+    writeBytes(SHMEXPORT_RING_AUDIO, pos, data, len);
+    commit(SHMEXPORT_RING_AUDIO, pos + len);
+}
+
+void SharedMemoryExport::writeDataGroup(uint16_t userAppType, uint16_t SCId, const uint8_t *data, uint32_t len)
+{
+    writeRecord(SHMEXPORT_RING_DATAGROUP, SHMEXPORT_RECORD_DATAGROUP, userAppType, SCId, data, len);
+}
+
+void SharedMemoryExport::writeDynamicLabel(const QString &label, uint32_t instance)
+{
+    QByteArray utf8 = label.toUtf8();
+    writeRecord(SHMEXPORT_RING_DL, SHMEXPORT_RECORD_DL, instance, 0, utf8.constData(), utf8.size());
+}
+
+void SharedMemoryExport::writeTelemetry(const SignalTelemetryRecord &record)
+{
+    shmexport_telemetry_t telemetry;
+    memset(&telemetry, 0, sizeof(telemetry));
+    telemetry.snr = record.snr;
+    telemetry.freq_offset = record.freqOffset;
+    telemetry.agc_gain = record.agcGain;
+    telemetry.fib_expected = record.fibExpected;
+    telemetry.fib_errors = record.fibErrors;
+    telemetry.msc_correct = record.mscCorrect;
+    telemetry.msc_errors = record.mscErrors;
+    telemetry.sync = record.sync;
+    writeRecord(SHMEXPORT_RING_TELEMETRY, SHMEXPORT_RECORD_TELEMETRY, 0, 0, &telemetry, sizeof(telemetry));
+}
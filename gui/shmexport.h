@@ -0,0 +1,93 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHMEXPORT_H
+#define SHMEXPORT_H
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+
+#include "audiofifo.h"
+#include "shmexportlayout.h"
+#include "signaltelemetry.h"
+
+#define SHMEXPORT_AUDIO_RING_SIZE       (1 << 21)   // bytes, ~5 s of 48kHz stereo float32
+#define SHMEXPORT_DATAGROUP_RING_SIZE   (1 << 20)   // bytes
+#define SHMEXPORT_DL_RING_SIZE          (1 << 16)   // bytes
+#define SHMEXPORT_TELEMETRY_RING_SIZE   (1 << 16)   // bytes
+
+// export of decoded audio, data groups, DL and signal telemetry to shared memory for external processes
+// layout is described in shmexportlayout.h, every ring has single producer thread that only copies data to mapping:
+// audio is written by main audio decoder, data groups and telemetry by primary receiver, DL by GUI thread,
+// producer never waits for readers and readers cannot influence the application
+class SharedMemoryExport
+{
+public:
+    SharedMemoryExport(const SharedMemoryExport & obj) = delete;
+
+    // GUI thread, stop() shall be called only when all producers are finished
+    static bool start(const QString & name = SHMEXPORT_NAME_DEFAULT);
+    static void stop();
+
+    // nullptr when export is not running
+    static SharedMemoryExport * instance() { return m_instancePtr.load(std::memory_order_acquire); }
+
+    // audio decoder thread
+    void setAudioFormat(uint32_t sampleRate, uint8_t numChannels);
+    void writeAudio(const audioSample_t * data, uint32_t numSamples);
+
+    // radio control callback thread
+    void writeDataGroup(uint16_t userAppType, uint16_t SCId, const uint8_t * data, uint32_t len);
+
+    // GUI thread
+    void writeDynamicLabel(const QString & label, uint32_t instance);
+
+    // radio control thread
+    void writeTelemetry(const SignalTelemetryRecord & record);
+
+private:
+    SharedMemoryExport() = default;
+    ~SharedMemoryExport();
+    static std::atomic<SharedMemoryExport *> m_instancePtr;
+
+    QString m_name;
+    uint8_t * m_mapping = nullptr;
+    size_t m_mappingSize = 0;
+    shmexport_header_t * m_header = nullptr;
+#if defined(_WIN32)
+    void * m_handle = nullptr;
+#else
+    int m_fd = -1;
+#endif
+
+    bool open(const QString & name);
+    void writeBytes(int ringId, uint64_t pos, const void * data, uint64_t len);
+    void commit(int ringId, uint64_t pos);
+    void writeRecord(int ringId, uint16_t type, uint32_t arg0, uint32_t arg1, const void * payload, uint32_t len);
+};
+
+#endif // SHMEXPORT_H
@@ -0,0 +1,125 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Layout of shared memory export, plain C header for external processes
+ *
+ * Mapping is created by AbracaDABra when shared memory export is enabled:
+ *   POSIX:   shm_open("/<name>", O_RDONLY, 0) and mmap of whole object
+ *   Windows: OpenFileMappingA(FILE_MAP_READ, FALSE, "Local\\<name>") and MapViewOfFile
+ * default name is SHMEXPORT_NAME_DEFAULT, all values are little endian
+ *
+ * Mapping starts with shmexport_header_t followed by data of all rings.
+ * Every ring has single producer that never waits for readers. write_pos is total number of bytes
+ * written to the ring, it is updated (release) after the data. Byte at position p is stored
+ * at data_offset + (p & (size - 1)). Reader keeps its own position and copies data between its position
+ * and write_pos, then it reads write_pos again: copied data are valid only if (write_pos - p) <= size,
+ * otherwise reader was overrun and it continues from write_pos.
+ *
+ * Audio ring contains interleaved PCM samples. Other rings contain records, every record starts
+ * with shmexport_record_t followed by payload and it is padded to 8 bytes.
+ */
+
+#ifndef SHMEXPORTLAYOUT_H
+#define SHMEXPORTLAYOUT_H
+
+#include <stdint.h>
+
+#define SHMEXPORT_MAGIC          (0x4D485341u)     /* "ASHM" */
+#define SHMEXPORT_VERSION        (1)
+#define SHMEXPORT_NAME_DEFAULT   "AbracaDABra"
+
+enum shmexport_ring_id
+{
+    SHMEXPORT_RING_AUDIO = 0,        /* PCM samples */
+    SHMEXPORT_RING_DATAGROUP,        /* raw data groups of user applications */
+    SHMEXPORT_RING_DL,               /* dynamic label strings */
+    SHMEXPORT_RING_TELEMETRY,        /* signal telemetry */
+    SHMEXPORT_NUM_RINGS
+};
+
+enum shmexport_record_type
+{
+    SHMEXPORT_RECORD_DATAGROUP = 1,  /* arg0 = user application type, arg1 = SCId, payload = data group */
+    SHMEXPORT_RECORD_DL = 2,         /* arg0 = 0 service, 1 announcement, payload = UTF-8 string without terminating zero */
+    SHMEXPORT_RECORD_TELEMETRY = 3   /* payload = shmexport_telemetry_t */
+};
+
+enum shmexport_sample_format
+{
+    SHMEXPORT_SAMPLE_INT16 = 0,
+    SHMEXPORT_SAMPLE_FLOAT32 = 1     /* normalized to [-1.0, 1.0) */
+};
+
+typedef struct
+{
+    uint64_t data_offset;            /* from beginning of mapping */
+    uint64_t size;                   /* bytes, power of 2 */
+    volatile uint64_t write_pos;     /* total bytes written */
+    uint64_t reserved;
+} shmexport_ring_t;
+
+typedef struct
+{
+    uint32_t magic;                  /* SHMEXPORT_MAGIC */
+    uint32_t version;                /* SHMEXPORT_VERSION */
+    uint32_t header_size;            /* sizeof(shmexport_header_t) */
+    uint32_t pid;                    /* process ID of producer */
+
+    /* audio format, producer increments audio_generation after all other fields are updated
+     * audio_format_pos is position in audio ring where samples in current format start */
+    volatile uint32_t audio_generation;
+    volatile uint32_t audio_sample_rate;
+    volatile uint32_t audio_channels;
+    volatile uint32_t audio_sample_format;   /* shmexport_sample_format */
+    volatile uint64_t audio_format_pos;
+
+    shmexport_ring_t ring[SHMEXPORT_NUM_RINGS];
+} shmexport_header_t;
+
+typedef struct
+{
+    uint32_t size;                   /* payload bytes without this header and padding */
+    uint16_t type;                   /* shmexport_record_type */
+    uint16_t reserved;
+    int64_t timestamp_ms;            /* ms since epoch */
+    uint32_t arg0;
+    uint32_t arg1;
+} shmexport_record_t;
+
+typedef struct
+{
+    float snr;                       /* dB */
+    float freq_offset;               /* Hz */
+    float agc_gain;                  /* dB, NaN when not available */
+    uint16_t fib_expected;
+    uint16_t fib_errors;
+    uint16_t msc_correct;
+    uint16_t msc_errors;
+    uint8_t sync;                    /* 0 = no sync, 1 = null symbol sync, 2 = full sync */
+    uint8_t reserved[3];
+} shmexport_telemetry_t;
+
+#endif /* SHMEXPORTLAYOUT_H */
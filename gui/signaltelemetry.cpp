@@ -0,0 +1,139 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QFile>
+#include <QTextStream>
+#include <QDateTime>
+#include <cmath>
+
+#include "signaltelemetry.h"
+
+SignalTelemetry * SignalTelemetry::m_instancePtr = nullptr;
+
+SignalTelemetry *SignalTelemetry::getInstance()
+{
+    if (m_instancePtr == nullptr)
+    {
+        m_instancePtr = new SignalTelemetry();
+    }
+    return m_instancePtr;
+}
+
+SignalTelemetry::SignalTelemetry() : m_agcGain(NAN)
+{
+    m_history.resize(SIGNAL_TELEMETRY_HISTORY_SIZE);
+}
+
+void SignalTelemetry::push(const SignalTelemetryRecord &record)
+{
+    uint32_t writeIdx = m_writeIdx.load(std::memory_order_relaxed);
+    if ((writeIdx - m_readIdx.load(std::memory_order_acquire)) >= SIGNAL_TELEMETRY_RING_SIZE)
+    {   // GUI does not pull
+        return;
+    }
+    m_ring[writeIdx & (SIGNAL_TELEMETRY_RING_SIZE - 1)] = record;
+    m_ring[writeIdx & (SIGNAL_TELEMETRY_RING_SIZE - 1)].agcGain = agcGain();
+    m_writeIdx.store(writeIdx + 1, std::memory_order_release);
+}
+
+int SignalTelemetry::pull(SignalTelemetryRecord &latest)
+{
+    uint32_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+    uint32_t writeIdx = m_writeIdx.load(std::memory_order_acquire);
+    int numRecords = writeIdx - readIdx;
+    if (0 == numRecords)
+    {
+        return 0;
+    }
+
+    uint32_t fibExpected = 0;
+    uint32_t fibErrors = 0;
+    uint32_t mscCorrect = 0;
+    uint32_t mscErrors = 0;
+    for ( ; readIdx != writeIdx; ++readIdx)
+    {
+        const SignalTelemetryRecord & record = m_ring[readIdx & (SIGNAL_TELEMETRY_RING_SIZE - 1)];
+        fibExpected += record.fibExpected;
+        fibErrors += record.fibErrors;
+        mscCorrect += record.mscCorrect;
+        mscErrors += record.mscErrors;
+
+        // history is circular buffer, oldest records are overwritten
+        m_history[(m_historyStart + m_historyCount) % SIGNAL_TELEMETRY_HISTORY_SIZE] = record;
+        if (m_historyCount < SIGNAL_TELEMETRY_HISTORY_SIZE)
+        {
+            m_historyCount += 1;
+        }
+        else
+        {
+            m_historyStart = (m_historyStart + 1) % SIGNAL_TELEMETRY_HISTORY_SIZE;
+        }
+        latest = record;
+    }
+    m_readIdx.store(readIdx, std::memory_order_release);
+
+    latest.fibExpected = qMin(fibExpected, uint32_t(UINT16_MAX));
+    latest.fibErrors = qMin(fibErrors, uint32_t(UINT16_MAX));
+    latest.mscCorrect = qMin(mscCorrect, uint32_t(UINT16_MAX));
+    latest.mscErrors = qMin(mscErrors, uint32_t(UINT16_MAX));
+
+    return numRecords;
+}
+
+const SignalTelemetryRecord &SignalTelemetry::historyRecord(int n) const
+{
+    return m_history[(m_historyStart + n) % SIGNAL_TELEMETRY_HISTORY_SIZE];
+}
+
+void SignalTelemetry::clearHistory()
+{
+    m_historyStart = 0;
+    m_historyCount = 0;
+}
+
+bool SignalTelemetry::saveHistory(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "time,sync,snr_db,freq_offset_hz,agc_gain_db,fib_expected,fib_errors,msc_correct,msc_errors\n";
+    for (int n = 0; n < m_historyCount; ++n)
+    {
+        const SignalTelemetryRecord & record = historyRecord(n);
+        out << QDateTime::fromMSecsSinceEpoch(record.timestampMs).toString(Qt::ISODateWithMs) << ','
+            << record.sync << ','
+            << QString::number(record.snr, 'f', 1) << ','
+            << QString::number(record.freqOffset, 'f', 1) << ','
+            << (std::isnan(record.agcGain) ? QString("") : QString::number(record.agcGain, 'f', 1)) << ','
+            << record.fibExpected << ',' << record.fibErrors << ','
+            << record.mscCorrect << ',' << record.mscErrors << '\n';
+    }
+    return (QTextStream::Ok == out.status());
+}
@@ -0,0 +1,94 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SIGNALTELEMETRY_H
+#define SIGNALTELEMETRY_H
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#define SIGNAL_TELEMETRY_RING_SIZE      (64)        // must be power of 2, records between two GUI pulls
+#define SIGNAL_TELEMETRY_PULL_MS        (250)       // GUI refresh period
+#define SIGNAL_TELEMETRY_HISTORY_HOURS  (12)
+// one record every notification period (768 ms)
+#define SIGNAL_TELEMETRY_HISTORY_SIZE   (SIGNAL_TELEMETRY_HISTORY_HOURS*3600*1000/768)
+
+struct SignalTelemetryRecord
+{
+    int64_t timestampMs;        // ms since epoch
+    float snr;                  // dB
+    float freqOffset;           // Hz
+    float agcGain;              // dB, NaN when not available
+    uint16_t fibExpected;
+    uint16_t fibErrors;
+    uint16_t mscCorrect;
+    uint16_t mscErrors;
+    uint8_t sync;               // DabSyncLevel
+};
+
+// singleton class
+// signal quality telemetry is pushed by radioControl thread every notification period (lock-free SPSC ring)
+// and pulled by GUI at its own rate, pulled records are kept in history for trends
+class SignalTelemetry
+{
+public:
+    SignalTelemetry(const SignalTelemetry & obj) = delete;   // deleting copy constructor
+    static SignalTelemetry * getInstance();
+
+    // producer (radioControl thread), record is dropped when ring is full
+    void push(const SignalTelemetryRecord & record);
+
+    // input device can report AGC gain from any thread, latest value is added to next record
+    void setAgcGain(float gain) { m_agcGain.store(gain, std::memory_order_relaxed); }
+    float agcGain() const { return m_agcGain.load(std::memory_order_relaxed); }
+
+    // consumer (GUI thread), returns number of new records
+    // latest contains last record with FIB and MSC counters summed over all new records
+    int pull(SignalTelemetryRecord & latest);
+
+    // history (GUI thread), oldest record first
+    int historySize() const { return m_historyCount; }
+    const SignalTelemetryRecord & historyRecord(int n) const;
+    void clearHistory();
+    bool saveHistory(const QString & fileName) const;     // CSV
+
+private:
+    SignalTelemetry();
+    static SignalTelemetry * m_instancePtr;
+
+    SignalTelemetryRecord m_ring[SIGNAL_TELEMETRY_RING_SIZE];
+    std::atomic<uint32_t> m_writeIdx { 0 };
+    std::atomic<uint32_t> m_readIdx { 0 };
+    std::atomic<float> m_agcGain;
+
+    std::vector<SignalTelemetryRecord> m_history;
+    int m_historyStart = 0;
+    int m_historyCount = 0;
+};
+
+#endif // SIGNALTELEMETRY_H
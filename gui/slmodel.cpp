@@ -24,6 +24,7 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
 #include "slmodel.h"
 #include <QFlags>
 
@@ -36,38 +37,38 @@ SLModel::SLModel(const ServiceList *sl, const MetadataManager *mm, QObject *pare
     connect(m_metadataMgrPtr, &MetadataManager::epgModelChanged, this, &SLModel::epgModelChanged);
     connect(m_metadataMgrPtr, &MetadataManager::dataUpdated, this, &SLModel::metadataUpdated);
 
-    QPixmap nopic(20,20);
+    // icons are scaled once and shared by all rows
+    QPixmap nopic(SLMODEL_ICON_SIZE, SLMODEL_ICON_SIZE);
     nopic.fill(Qt::transparent);
-    m_noIcon = QIcon(nopic);
+    m_noIcon = QVariant(QIcon(nopic));
 
     QPixmap pic;
 #ifdef Q_OS_LINUX
     // SVG is too big on linux, using PNG instead
-    if (pic.load(":/resources/star.png"))
-    {
-        m_favIcon = QIcon(pic);
-    }
-    else
-    {
-        m_favIcon = m_noIcon;
-        qDebug() << "Unable to load :/resources/star.png";
-    }
+    const QString favIconFile(":/resources/star.png");
 #else
-    if (pic.load(":/resources/star.svg"))
+    const QString favIconFile(":/resources/star.svg");
+#endif
+    if (pic.load(favIconFile))
     {
-        m_favIcon = QIcon(pic);
+        if ((pic.width() > SLMODEL_ICON_SIZE) || (pic.height() > SLMODEL_ICON_SIZE))
+        {
+            pic = pic.scaled(SLMODEL_ICON_SIZE, SLMODEL_ICON_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        m_favIcon = QVariant(QIcon(pic));
     }
     else
     {
         m_favIcon = m_noIcon;
-        qDebug() << "Unable to load :/resources/star.svg";
+        qDebug() << "Unable to load" << favIconFile;
     }
-#endif
 }
 
 
 SLModel::~SLModel()
 {
+    qDeleteAll(m_serviceItems);
+    qDeleteAll(m_pendingItems);
 }
 
 int SLModel::columnCount(const QModelIndex &parent) const
@@ -98,18 +99,7 @@ QVariant SLModel::data(const QModelIndex &index, int role) const
         case SLModelRole::EnsembleListRole:
               return item->data(index.column(), role);
         case Qt::DecorationRole:
-        {
-            if (item->isFavoriteService())
-            {
-                return QVariant(m_favIcon);
-            }
-            else
-            {
-                return QVariant(m_noIcon);
-            }
-            return QVariant();
-        }
-        break;
+            return item->isFavoriteService() ? m_favIcon : m_noIcon;
         }
     }
     return QVariant();
@@ -193,26 +183,111 @@ int SLModel::rowCount(const QModelIndex &parent) const
 
 void SLModel::addService(const ServiceListId & servId)
 {  // new service in service list
-    beginInsertRows(QModelIndex(), m_serviceItems.size(), m_serviceItems.size());
-    m_serviceItems.append(new SLModelItem(m_slPtr, m_metadataMgrPtr, servId));
-    endInsertRows();
+    SLModelItem * item = new SLModelItem(m_slPtr, m_metadataMgrPtr, servId);
+    initFilterFlags(item);
+    m_itemById.insert(servId, item);
+    if (m_isUpdating)
+    {   // inserted when update is finished
+        m_pendingItems.append(item);
+        return;
+    }
 
-    sort(0);
+    int row = insertPosition(item, 0, m_serviceItems.size());
+    beginInsertRows(QModelIndex(), row, row);
+    m_serviceItems.insert(row, item);
+    endInsertRows();
 }
 
 void SLModel::updateService(const ServiceListId & servId)
-{   // service label was updated -> need to sort
-    sort(0);  // --> this emits dataChanged()
+{   // service label was updated -> need to move item to new position
+    int row = findRow(servId);
+    if (row < 0)
+    {   // not found or still pending
+        return;
+    }
+
+    SLModelItem * item = m_serviceItems.at(row);
+    item->invalidateCache(SLModelItem::CacheLabel | SLModelItem::CacheToolTip);
+    if ((row > 0) && lessThan(item, m_serviceItems.at(row-1)))
+    {   // moving up
+        int dest = insertPosition(item, 0, row);
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(), dest);
+        m_serviceItems.move(row, dest);
+        endMoveRows();
+    }
+    else if ((row < m_serviceItems.size()-1) && lessThan(m_serviceItems.at(row+1), item))
+    {   // moving down, destination is index in the list before move
+        int dest = insertPosition(item, row+1, m_serviceItems.size());
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(), dest);
+        m_serviceItems.move(row, dest-1);
+        endMoveRows();
+    }
+    else
+    {   // position is not changed
+        emit dataChanged(index(row, 0), index(row, 0));
+    }
+}
+
+void SLModel::beginUpdate()
+{
+    m_isUpdating = true;
+}
+
+void SLModel::endUpdate()
+{
+    m_isUpdating = false;
+    if (m_pendingItems.isEmpty())
+    {
+        return;
+    }
+
+    std::stable_sort(m_pendingItems.begin(), m_pendingItems.end(), [this](const SLModelItem * a, const SLModelItem * b) {
+        return lessThan(a, b);
+    });
+
+    // merge pending items into the list, items with the same insert position are inserted as single range
+    int row = 0;
+    int n = 0;
+    while (n < m_pendingItems.size())
+    {
+        row = insertPosition(m_pendingItems.at(n), row, m_serviceItems.size());
+        int last = n + 1;
+        while ((last < m_pendingItems.size())
+               && ((row == m_serviceItems.size()) || lessThan(m_pendingItems.at(last), m_serviceItems.at(row))))
+        {
+            ++last;
+        }
+
+        beginInsertRows(QModelIndex(), row, row + last - n - 1);
+        for (int p = n; p < last; ++p)
+        {
+            m_serviceItems.insert(row++, m_pendingItems.at(p));
+        }
+        endInsertRows();
+        n = last;
+    }
+    m_pendingItems.clear();
 }
 
 void SLModel::removeService(const ServiceListId & servId)
 {
+    for (int n = 0; n < m_pendingItems.size(); ++n)
+    {
+        if (m_pendingItems.at(n)->id() == servId)
+        {   // not inserted yet
+            m_itemById.remove(servId);
+            delete m_pendingItems.takeAt(n);
+            return;
+        }
+    }
+
     // first find service in the list
     for (int row = 0; row < m_serviceItems.size(); ++row)
     {
         if (m_serviceItems.at(row)->id() == servId)
         {   // found
             beginRemoveRows(QModelIndex(), row, row);
+            m_itemById.remove(servId);
             SLModelItem * item = m_serviceItems.at(row);
             m_serviceItems.removeAt(row);
             delete item;
@@ -224,30 +299,94 @@ void SLModel::removeService(const ServiceListId & servId)
 
 void SLModel::epgModelChanged(const ServiceListId &servId)
 {
-    // first find service in the list
-    for (int row = 0; row < m_serviceItems.size(); ++row)
+    SLModelItem * item = m_itemById.value(servId, nullptr);
+    if (nullptr == item)
+    {   // not found
+        return;
+    }
+    item->setHasEpg(nullptr != m_metadataMgrPtr->epgModel(servId));
+
+    int row = findRow(servId);
+    if (row >= 0)
+    {   // inserted
+        emit dataChanged(index(row, 0), index(row, 0), {SLModelRole::EpgModelRole});
+    }
+}
+
+void SLModel::serviceAddedToEnsemble(const ServiceListId &ensId, const ServiceListId &servId)
+{
+    updateEnsembleBit(ensId, servId, true);
+}
+
+void SLModel::serviceRemovedFromEnsemble(const ServiceListId &ensId, const ServiceListId &servId)
+{
+    updateEnsembleBit(ensId, servId, false);
+}
+
+int SLModel::ensembleBit(uint32_t ueid)
+{
+    auto it = m_ensembleBits.constFind(ueid);
+    if (m_ensembleBits.cend() != it)
     {
-        if (m_serviceItems.at(row)->id() == servId)
-        {   // found
-            dataChanged(index(row, 0), index(row, 0), {SLModelRole::EpgModelRole});
-            return;
+        return *it;
+    }
+    int bit = m_ensembleBits.size();
+    m_ensembleBits.insert(ueid, bit);
+    return bit;
+}
+
+void SLModel::initFilterFlags(SLModelItem *item)
+{
+    item->setHasEpg(nullptr != m_metadataMgrPtr->epgModel(item->id()));
+
+    ServiceListConstIterator it = m_slPtr->findService(item->id());
+    if (m_slPtr->serviceListEnd() != it)
+    {   // found
+        for (int e = 0; e < (*it)->numEnsembles(); ++e)
+        {
+            item->setEnsembleBit(ensembleBit((*it)->getEnsemble(e)->ueid()), true);
         }
     }
 }
 
+void SLModel::updateEnsembleBit(const ServiceListId &ensId, const ServiceListId &servId, bool isMember)
+{
+    SLModelItem * item = m_itemById.value(servId, nullptr);
+    if (nullptr == item)
+    {   // new service, flags are set when it is added
+        return;
+    }
+    item->setEnsembleBit(ensembleBit(ensId.ueid()), isMember);
+
+    int row = findRow(servId);
+    if (row >= 0)
+    {   // inserted
+        emit dataChanged(index(row, 0), index(row, 0), {SLModelRole::EnsembleListRole});
+    }
+}
+
 void SLModel::metadataUpdated(const ServiceListId &servId, MetadataManager::MetadataRole role)
 {
+    if ((role != MetadataManager::MetadataRole::SmallLogo) && (role != MetadataManager::MetadataRole::NowNext))
+    {   // not shown in the list
+        return;
+    }
+
+    int row = findRow(servId);
+    if (row < 0)
+    {   // not found or still pending
+        return;
+    }
+
     if (role == MetadataManager::MetadataRole::SmallLogo)
     {
-        // first find service in the list
-        for (int row = 0; row < m_serviceItems.size(); ++row)
-        {
-            if (m_serviceItems.at(row)->id() == servId)
-            {   // found
-                dataChanged(index(row, 0), index(row, 0), {SLModelRole::SmallLogoIdRole});
-                return;
-            }
-        }
+        m_serviceItems.at(row)->invalidateCache(SLModelItem::CacheSmallLogo);
+        emit dataChanged(index(row, 0), index(row, 0), {SLModelRole::SmallLogoIdRole});
+    }
+    else
+    {
+        m_serviceItems.at(row)->invalidateCache(SLModelItem::CacheToolTip);
+        emit dataChanged(index(row, 0), index(row, 0), {Qt::ToolTipRole});
     }
 }
 
@@ -255,7 +394,11 @@ void SLModel::clear()
 {
     beginResetModel();
     // remove all items
+    qDeleteAll(m_serviceItems);
     m_serviceItems.clear();
+    qDeleteAll(m_pendingItems);
+    m_pendingItems.clear();
+    m_itemById.clear();
     endResetModel();
 }
 
@@ -265,38 +408,47 @@ void SLModel::sort(int column, Qt::SortOrder order)
 
     beginResetModel();
 
-    if (Qt::AscendingOrder == order)
-    {
-        std::sort(m_serviceItems.begin(), m_serviceItems.end(), [](const SLModelItem * a, const SLModelItem * b) {
-            if ((a->isFavoriteService() && b->isFavoriteService()) || (!a->isFavoriteService() && !b->isFavoriteService()))
-            {
-                return a->label().toUpper() < b->label().toUpper();
-            }
-            if (a->isFavoriteService())
-            {
-                return true;
-            }
-            return false;
-        });
+    m_sortOrder = order;
+    std::stable_sort(m_serviceItems.begin(), m_serviceItems.end(), [this](const SLModelItem * a, const SLModelItem * b) {
+        return lessThan(a, b);
+    });
+
+    endResetModel();
+
+    emit dataChanged(QModelIndex(), QModelIndex());
+}
+
+bool SLModel::lessThan(const SLModelItem *a, const SLModelItem *b) const
+{
+    if (a->isFavoriteService() != b->isFavoriteService())
+    {   // favorites are first
+        return (Qt::AscendingOrder == m_sortOrder) ? a->isFavoriteService() : b->isFavoriteService();
     }
-    else
+    if (Qt::AscendingOrder == m_sortOrder)
     {
-        std::sort(m_serviceItems.begin(), m_serviceItems.end(), [](const SLModelItem * a, const SLModelItem * b) {
-            if ((a->isFavoriteService() && b->isFavoriteService()) || (!a->isFavoriteService() && !b->isFavoriteService()))
-            {
-                return a->label().toUpper() > b->label().toUpper();
-            }
-            if (b->isFavoriteService())
-            {
-                return true;
-            }
-            return false;
-        });
+        return a->sortKey() < b->sortKey();
     }
+    return a->sortKey() > b->sortKey();
+}
 
-    endResetModel();
+int SLModel::insertPosition(const SLModelItem *item, int from, int to) const
+{   // binary search in sorted list, new item is placed after equal items
+    auto it = std::upper_bound(m_serviceItems.cbegin() + from, m_serviceItems.cbegin() + to, item, [this](const SLModelItem * a, const SLModelItem * b) {
+        return lessThan(a, b);
+    });
+    return it - m_serviceItems.cbegin();
+}
 
-    emit dataChanged(QModelIndex(), QModelIndex());
+int SLModel::findRow(const ServiceListId &servId) const
+{
+    for (int row = 0; row < m_serviceItems.size(); ++row)
+    {
+        if (m_serviceItems.at(row)->id() == servId)
+        {
+            return row;
+        }
+    }
+    return -1;
 }
 
 QHash<int, QByteArray> SLModel::roleNames() const
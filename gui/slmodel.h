@@ -37,6 +37,8 @@
 #include "servicelist.h"
 #include "metadatamanager.h"
 
+#define SLMODEL_ICON_SIZE  (20)   // favorite icon size in pixels
+
 enum SLModelRole{
     IdRole = Qt::UserRole,
     SmallLogoRole,
@@ -69,21 +71,43 @@ public:
     bool isFavoriteService(const QModelIndex &index) const;
     const ServiceList * getServiceList() const { return m_slPtr; }
 
+    // filtering support for proxy models, rows are tested without QVariant boxing
+    int ensembleBit(uint32_t ueid);     // bit index of ensemble in membership sets, assigned on first use
+    bool isServiceInEnsemble(int row, int ensembleBit) const { return m_serviceItems.at(row)->testEnsembleBit(ensembleBit); }
+    bool serviceHasEpg(int row) const { return m_serviceItems.at(row)->hasEpg(); }
+
 public slots:
     void addService(const ServiceListId & servId);
     void updateService(const ServiceListId & servId);
     void removeService(const ServiceListId & servId);
+    // services added between beginUpdate() and endUpdate() are inserted in one step
+    void beginUpdate();
+    void endUpdate();
     void epgModelChanged(const ServiceListId & servId);
+    void serviceAddedToEnsemble(const ServiceListId & ensId, const ServiceListId & servId);
+    void serviceRemovedFromEnsemble(const ServiceListId & ensId, const ServiceListId & servId);
     void metadataUpdated(const ServiceListId &servId, MetadataManager::MetadataRole role);
     void clear();
 
 private:
     const ServiceList * m_slPtr;
     const MetadataManager * m_metadataMgrPtr;
-    QList<SLModelItem *> m_serviceItems;    
+    QList<SLModelItem *> m_serviceItems;       // sorted
+    QList<SLModelItem *> m_pendingItems;       // waiting for endUpdate()
+    QHash<ServiceListId, SLModelItem *> m_itemById;   // inserted and pending items
+    QHash<uint32_t, int> m_ensembleBits;              // UEID -> bit index
+    bool m_isUpdating = false;
+    Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+
+    // prebuilt decoration values returned from data()
+    QVariant m_favIcon;
+    QVariant m_noIcon;
 
-    QIcon m_favIcon;
-    QIcon m_noIcon;
+    bool lessThan(const SLModelItem * a, const SLModelItem * b) const;
+    int insertPosition(const SLModelItem * item, int from, int to) const;
+    int findRow(const ServiceListId & servId) const;
+    void initFilterFlags(SLModelItem * item);
+    void updateEnsembleBit(const ServiceListId & ensId, const ServiceListId & servId, bool isMember);
 };
 
 #endif // SLMODEL_H
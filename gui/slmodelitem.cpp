@@ -28,6 +28,7 @@
 #include <QFont>
 #include <QIcon>
 
+#include <algorithm>
 #include "slmodelitem.h"
 #include "slmodel.h"
 #include "dabtables.h"
@@ -52,11 +53,34 @@ SLModelItem::~SLModelItem()
     qDeleteAll(m_childItems);
 }
 
+void SLModelItem::setEnsembleBit(int bit, bool isMember)
+{
+    if (bit >= m_ensembleBits.size())
+    {
+        if (!isMember)
+        {
+            return;
+        }
+        m_ensembleBits.resize(bit + 1);
+    }
+    m_ensembleBits.setBit(bit, isMember);
+}
+
 void SLModelItem::appendChild(SLModelItem *item)
 {
     m_childItems.append(item);
 }
 
+void SLModelItem::insertChild(int row, SLModelItem *item)
+{
+    m_childItems.insert(row, item);
+}
+
+void SLModelItem::moveChild(int from, int to)
+{
+    m_childItems.move(from, to);
+}
+
 
 SLModelItem *SLModelItem::child(int row)
 {
@@ -84,26 +108,10 @@ QVariant SLModelItem::data(int column, int role) const
             break;
         case Qt::ToolTipRole:
         {
-            if (m_id.isService())
-            {  // service item
-                ServiceListConstIterator it = m_slPtr->findService(m_id);
-                if (m_slPtr->serviceListEnd() != it)
-                {  // found
-                    QString tooltip = QString("<b>"+QObject::tr("Short label:")+"</b> %1<br><b>SId:</b> 0x%2").arg(it.value()->shortLabel(),
-                                          QString("%1").arg(it.value()->SId().countryServiceRef(), 4, 16, QChar('0')).toUpper() );
-                    return QVariant(tooltip);
-
-                }
-            }
-            if (m_id.isEnsemble())
-            {  // ensemble item
-                EnsembleListConstIterator it = m_slPtr->findEnsemble(m_id);
-                if (m_slPtr->ensembleListEnd() != it)
-                {  // found
-                    return QVariant(QString(QObject::tr("Channel %1<br>Frequency: %2 MHz"))
-                                        .arg(DabTables::channelList.value(it.value()->frequency()))
-                                        .arg(it.value()->frequency()/1000.0, 3, 'f', 3, QChar('0')));
-                }
+            QString tooltip = toolTip();
+            if (!tooltip.isEmpty())
+            {
+                return QVariant(tooltip);
             }
         }
             break;
@@ -119,10 +127,10 @@ QVariant SLModelItem::data(int column, int role) const
         case SLModelRole::IdRole:
             return QVariant::fromValue(m_id.value());
         case SLModelRole::SmallLogoRole:
-            return m_metadataMgrPtr->data(m_id, MetadataManager::SmallLogo);
+            return smallLogo();
         case SLModelRole::SmallLogoIdRole:
         {
-            if (m_metadataMgrPtr->data(m_id, MetadataManager::SmallLogo).value<QPixmap>().isNull())
+            if (smallLogo().value<QPixmap>().isNull())
             {
                 return QVariant(0);
             }
@@ -197,24 +205,97 @@ bool SLModelItem::isEnsemble() const
 
 QString SLModelItem::label() const
 {
+    if (m_cacheValid & CacheLabel)
+    {
+        return m_labelCache;
+    }
+
+    m_labelCache = QStringLiteral("--- UNKNOWN ---");
     if (m_id.isService())
     {  // service item
         ServiceListConstIterator it = m_slPtr->findService(m_id);
         if (m_slPtr->serviceListEnd() != it)
         {  // found
-            return it.value()->label();
+            m_labelCache = it.value()->label();
+        }
+    }
+    else if (m_id.isEnsemble())
+    {  // ensemble item
+        EnsembleListConstIterator it = m_slPtr->findEnsemble(m_id);
+        if (m_slPtr->ensembleListEnd() != it)
+        {  // found
+            m_labelCache = it.value()->label().trimmed();
         }
     }
+    m_cacheValid |= CacheLabel;
+    return m_labelCache;
+}
 
-    if (m_id.isEnsemble())
+const QString &SLModelItem::sortKey() const
+{
+    if (m_cacheValid & CacheSortKey)
+    {
+        return m_sortKeyCache;
+    }
+
+    m_sortKeyCache = label().toUpper();
+    m_cacheValid |= CacheSortKey;
+    return m_sortKeyCache;
+}
+
+QString SLModelItem::toolTip() const
+{
+    if (m_cacheValid & CacheToolTip)
+    {
+        return m_toolTipCache;
+    }
+
+    m_toolTipCache.clear();
+    if (m_id.isService())
+    {  // service item
+        ServiceListConstIterator it = m_slPtr->findService(m_id);
+        if (m_slPtr->serviceListEnd() != it)
+        {  // found
+            m_toolTipCache = QString("<b>"+QObject::tr("Short label:")+"</b> %1<br><b>SId:</b> 0x%2").arg(it.value()->shortLabel(),
+                                 QString("%1").arg(it.value()->SId().countryServiceRef(), 4, 16, QChar('0')).toUpper() );
+            m_toolTipCache += m_metadataMgrPtr->nowNextText(m_id);
+        }
+    }
+    else if (m_id.isEnsemble())
     {  // ensemble item
         EnsembleListConstIterator it = m_slPtr->findEnsemble(m_id);
         if (m_slPtr->ensembleListEnd() != it)
         {  // found
-            return it.value()->label().trimmed();
+            m_toolTipCache = QString(QObject::tr("Channel %1<br>Frequency: %2 MHz"))
+                                 .arg(DabTables::channelName(it.value()->frequency()))
+                                 .arg(it.value()->frequency()/1000.0, 3, 'f', 3, QChar('0'));
         }
     }
-    return QString("--- UNKNOWN ---");
+    m_cacheValid |= CacheToolTip;
+    return m_toolTipCache;
+}
+
+const QVariant & SLModelItem::smallLogo() const
+{
+    if (0 == (m_cacheValid & CacheSmallLogo))
+    {
+        m_smallLogoCache = m_metadataMgrPtr->data(m_id, MetadataManager::SmallLogo);
+        m_cacheValid |= CacheSmallLogo;
+    }
+    return m_smallLogoCache;
+}
+
+void SLModelItem::invalidateCache(uint8_t flags)
+{
+    if (flags & CacheLabel)
+    {   // sort key is derived from label
+        flags |= CacheSortKey;
+    }
+    m_cacheValid &= ~flags;
+    if (flags & CacheSmallLogo)
+    {   // release pixmap
+        m_smallLogoCache.clear();
+    }
 }
 
 QString SLModelItem::shortLabel() const
@@ -256,37 +337,39 @@ DabSId SLModelItem::SId() const
 
 void SLModelItem::sort(Qt::SortOrder order)
 {
-    if (Qt::AscendingOrder == order)
+    std::stable_sort(m_childItems.begin(), m_childItems.end(), [order](const SLModelItem * a, const SLModelItem * b) {
+        return lessThan(a, b, order);
+    });
+
+    for (auto child : m_childItems)
     {
-        std::sort(m_childItems.begin(), m_childItems.end(), [](SLModelItem* a, SLModelItem* b) {
-            if (a->isEnsemble())
-            {
-                return a->frequency() < b->frequency();
-            }
-            else
-            {
-                return a->label().toUpper() < b->label().toUpper();
-            }
-        });
+        child->sort(order);
     }
-    else
+}
+
+bool SLModelItem::lessThan(const SLModelItem *a, const SLModelItem *b, Qt::SortOrder order)
+{
+    if (a->isEnsemble())
     {
-        std::sort(m_childItems.begin(), m_childItems.end(), [](SLModelItem* a, SLModelItem* b) {
-            if (a->isEnsemble())
-            {
-                return a->frequency() > b->frequency();
-            }
-            else
-            {
-                return a->label().toUpper() > b->label().toUpper();
-            }
-        });
+        return (Qt::AscendingOrder == order) ? (a->frequency() < b->frequency()) : (a->frequency() > b->frequency());
     }
+    if (Qt::AscendingOrder == order)
+    {
+        return a->sortKey() < b->sortKey();
+    }
+    return a->sortKey() > b->sortKey();
+}
 
-    for (auto child : m_childItems)
+int SLModelItem::childInsertPosition(const SLModelItem *item, Qt::SortOrder order, int from, int to) const
+{   // binary search in sorted children, new item is placed after equal items
+    if (to < 0)
     {
-        child->sort(order);
+        to = m_childItems.size();
     }
+    auto it = std::upper_bound(m_childItems.cbegin() + from, m_childItems.cbegin() + to, item, [order](const SLModelItem * a, const SLModelItem * b) {
+        return lessThan(a, b, order);
+    });
+    return it - m_childItems.cbegin();
 }
 
 SLModelItem* SLModelItem::findChildId(const ServiceListId & id, bool recursive) const
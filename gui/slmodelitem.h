@@ -29,6 +29,7 @@
 
 #include <QList>
 #include <QVariant>
+#include <QBitArray>
 #include "metadatamanager.h"
 #include "servicelist.h"
 
@@ -40,6 +41,8 @@ public:
     ~SLModelItem();
 
     void appendChild(SLModelItem *child);    
+    void insertChild(int row, SLModelItem *child);
+    void moveChild(int from, int to);
 
     SLModelItem *child(int row);
     int childCount() const;
@@ -52,12 +55,34 @@ public:
     bool isEnsemble() const;
     bool isFavoriteService() const;
     QString label() const;
+    // case insensitive key used for sorting, cached with label
+    const QString & sortKey() const;
     QString shortLabel() const;
     uint32_t frequency() const;
     DabSId SId() const;
     SLModelItem* findChildId(const ServiceListId &id, bool recursive = false) const;
     bool removeChildId(const ServiceListId &id);
     void sort(Qt::SortOrder order);
+    // position where item should be inserted to keep children sorted, searching in range <from, to)
+    int childInsertPosition(const SLModelItem *item, Qt::SortOrder order, int from = 0, int to = -1) const;
+    static bool lessThan(const SLModelItem *a, const SLModelItem *b, Qt::SortOrder order);
+
+    enum CacheFlags
+    {
+        CacheLabel = 0x01,
+        CacheToolTip = 0x02,
+        CacheSmallLogo = 0x04,
+        CacheSortKey = 0x08,
+        CacheAll = 0xFF
+    };
+    // display values are cached in item, model invalidates them when service or metadata is updated
+    void invalidateCache(uint8_t flags = CacheAll);
+
+    // filtering flags maintained by model: ensemble membership (bit per ensemble index) and EPG availability
+    void setEnsembleBit(int bit, bool isMember);
+    bool testEnsembleBit(int bit) const { return (bit >= 0) && (bit < m_ensembleBits.size()) && m_ensembleBits.testBit(bit); }
+    void setHasEpg(bool hasEpg) { m_hasEpg = hasEpg; }
+    bool hasEpg() const { return m_hasEpg; }
 
 private:
     QList<SLModelItem*> m_childItems;
@@ -66,6 +91,17 @@ private:
     const ServiceList * m_slPtr;
     const MetadataManager * m_metadataMgrPtr;
     ServiceListId m_id;
+    QBitArray m_ensembleBits;
+    bool m_hasEpg = false;
+
+    mutable uint8_t m_cacheValid = 0;
+    mutable QString m_labelCache;
+    mutable QString m_sortKeyCache;
+    mutable QString m_toolTipCache;
+    mutable QVariant m_smallLogoCache;
+
+    QString toolTip() const;
+    const QVariant & smallLogo() const;
 
 };
 
@@ -33,8 +33,24 @@ SLProxyModel::SLProxyModel(QObject *parent)
     m_ueidFilter(0)
 {}
 
+void SLProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    m_slModel = qobject_cast<SLModel *>(sourceModel);
+    updateUeidFilterBit();
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
 bool SLProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
+    if (nullptr != m_slModel)
+    {   // flat list, flags are prepared in model
+        if (m_emptyEpgFilter && !m_slModel->serviceHasEpg(sourceRow))
+        {
+            return false;
+        }
+        return (m_ueidFilter <= 0) || m_slModel->isServiceInEnsemble(sourceRow, m_ueidFilterBit);
+    }
+
     QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
     bool ret = true;
     if (m_emptyEpgFilter)
@@ -73,6 +89,19 @@ void SLProxyModel::setUeidFilter(int newUeidFilter)
     if (m_ueidFilter == newUeidFilter)
         return;
     m_ueidFilter = newUeidFilter;
+    updateUeidFilterBit();
     invalidateFilter();
     emit ueidFilterChanged();
 }
+
+void SLProxyModel::updateUeidFilterBit()
+{
+    if ((nullptr != m_slModel) && (m_ueidFilter > 0))
+    {
+        m_ueidFilterBit = m_slModel->ensembleBit(m_ueidFilter);
+    }
+    else
+    {
+        m_ueidFilterBit = -1;
+    }
+}
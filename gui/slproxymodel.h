@@ -31,6 +31,8 @@
 #include <QQmlEngine>
 #include <QSortFilterProxyModel>
 
+class SLModel;
+
 class SLProxyModel : public QSortFilterProxyModel
 {
     Q_OBJECT
@@ -40,6 +42,7 @@ class SLProxyModel : public QSortFilterProxyModel
 public:
     explicit SLProxyModel(QObject *parent = nullptr);
 
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
 
     bool emptyEpgFilter() const;
@@ -54,6 +57,10 @@ signals:
 private:
     bool m_emptyEpgFilter;
     int m_ueidFilter;
+    SLModel * m_slModel = nullptr;     // source model when it is SLModel, filters are evaluated on its flags
+    int m_ueidFilterBit = -1;          // ensemble bit of UEID filter in SLModel
+
+    void updateUeidFilterBit();
 };
 
 #endif // SLPROXYMODEL_H
@@ -35,6 +35,8 @@ SLTreeModel::SLTreeModel(const ServiceList *sl, const MetadataManager *mm, QObje
     , m_metadataMgrPtr(mm)
 {
     m_rootItem = new SLModelItem(m_slPtr, m_metadataMgrPtr);
+
+    connect(m_metadataMgrPtr, &MetadataManager::dataUpdated, this, &SLTreeModel::metadataUpdated);
 }
 
 
@@ -196,9 +198,7 @@ void SLTreeModel::addEnsembleService(const ServiceListId & ensId, const ServiceL
     if (nullptr == ensChild)
     {   // not found ==> new ensemble
         ensChild = new SLModelItem(m_slPtr, m_metadataMgrPtr, ensId, m_rootItem);
-        beginInsertRows(QModelIndex(), m_rootItem->childCount(), m_rootItem->childCount());
-        m_rootItem->appendChild(ensChild);
-        endInsertRows();
+        insertItem(m_rootItem, ensChild);
     }
 
     if (servId.scids() != 0)
@@ -209,9 +209,7 @@ void SLTreeModel::addEnsembleService(const ServiceListId & ensId, const ServiceL
         SLModelItem * serviceChild = ensChild->findChildId(id);
         if (nullptr != serviceChild)
         {   // primary service found
-            beginInsertRows(index(serviceChild->row(), 0, index(ensChild->row(), 0, QModelIndex())), serviceChild->childCount(), serviceChild->childCount());
-            serviceChild->appendChild(new SLModelItem(m_slPtr, m_metadataMgrPtr, servId, serviceChild));
-            endInsertRows();
+            insertItem(serviceChild, new SLModelItem(m_slPtr, m_metadataMgrPtr, servId, serviceChild));
         }
         else
         {
@@ -219,9 +217,7 @@ void SLTreeModel::addEnsembleService(const ServiceListId & ensId, const ServiceL
             serviceChild = ensChild->findChildId(servId);
             if (nullptr == serviceChild)
             {  // new service to be added
-                beginInsertRows(index(ensChild->row(), 0, QModelIndex()), ensChild->childCount(), ensChild->childCount());
-                ensChild->appendChild(new SLModelItem(m_slPtr, m_metadataMgrPtr, servId, ensChild));
-                endInsertRows();
+                insertItem(ensChild, new SLModelItem(m_slPtr, m_metadataMgrPtr, servId, ensChild));
             }
         }
     }
@@ -230,18 +226,116 @@ void SLTreeModel::addEnsembleService(const ServiceListId & ensId, const ServiceL
         SLModelItem * serviceChild = ensChild->findChildId(servId);
         if (nullptr == serviceChild)
         {  // new service to be added
-            beginInsertRows(index(ensChild->row(), 0, QModelIndex()), ensChild->childCount(), ensChild->childCount());
-            ensChild->appendChild(new SLModelItem(m_slPtr, m_metadataMgrPtr, servId, ensChild));
-            endInsertRows();
+            insertItem(ensChild, new SLModelItem(m_slPtr, m_metadataMgrPtr, servId, ensChild));
         }
     }
-
-    sort(0);
 }
 
 void SLTreeModel::updateEnsembleService(const ServiceListId &ensId, const ServiceListId &servId)
-{   // service label was updated -> need to sort
-    sort(0);  // --> this emits dataChanged()
+{   // service label was updated -> need to move item to new position
+    SLModelItem * ensChild = m_rootItem->findChildId(ensId);
+    if (nullptr == ensChild)
+    {
+        return;
+    }
+    SLModelItem * serviceChild = ensChild->findChildId(servId, true);
+    if (nullptr == serviceChild)
+    {
+        return;
+    }
+    serviceChild->invalidateCache(SLModelItem::CacheLabel | SLModelItem::CacheToolTip);
+    if (m_isUpdating)
+    {   // no signals during reset
+        serviceChild->parentItem()->sort(m_sortOrder);
+        return;
+    }
+
+    SLModelItem * parentItem = serviceChild->parentItem();
+    QModelIndex parentIdx = itemIndex(parentItem);
+    int row = serviceChild->row();
+    if ((row > 0) && SLModelItem::lessThan(serviceChild, parentItem->child(row-1), m_sortOrder))
+    {   // moving up
+        int dest = parentItem->childInsertPosition(serviceChild, m_sortOrder, 0, row);
+        beginMoveRows(parentIdx, row, row, parentIdx, dest);
+        parentItem->moveChild(row, dest);
+        endMoveRows();
+    }
+    else if ((row < parentItem->childCount()-1) && SLModelItem::lessThan(parentItem->child(row+1), serviceChild, m_sortOrder))
+    {   // moving down, destination is index before move
+        int dest = parentItem->childInsertPosition(serviceChild, m_sortOrder, row+1);
+        beginMoveRows(parentIdx, row, row, parentIdx, dest);
+        parentItem->moveChild(row, dest-1);
+        endMoveRows();
+    }
+    else
+    {   // position is not changed
+        QModelIndex idx = index(row, 0, parentIdx);
+        emit dataChanged(idx, idx);
+    }
+}
+
+void SLTreeModel::metadataUpdated(const ServiceListId &servId, MetadataManager::MetadataRole role)
+{
+    if (role != MetadataManager::MetadataRole::NowNext)
+    {   // only tooltip depends on metadata in the tree
+        return;
+    }
+
+    // service can be present in more ensembles
+    for (int e = 0; e < m_rootItem->childCount(); ++e)
+    {
+        SLModelItem * serviceChild = m_rootItem->child(e)->findChildId(servId, true);
+        if (nullptr != serviceChild)
+        {
+            serviceChild->invalidateCache(SLModelItem::CacheToolTip);
+            if (!m_isUpdating)
+            {
+                QModelIndex idx = itemIndex(serviceChild);
+                emit dataChanged(idx, idx, {Qt::ToolTipRole});
+            }
+        }
+    }
+}
+
+void SLTreeModel::beginUpdate()
+{   // items are added without notification, views are updated once in endUpdate()
+    if (!m_isUpdating)
+    {
+        m_isUpdating = true;
+        beginResetModel();
+    }
+}
+
+void SLTreeModel::endUpdate()
+{
+    if (m_isUpdating)
+    {
+        m_isUpdating = false;
+        endResetModel();
+    }
+}
+
+void SLTreeModel::insertItem(SLModelItem *parentItem, SLModelItem *item)
+{
+    int row = parentItem->childInsertPosition(item, m_sortOrder);
+    if (m_isUpdating)
+    {
+        parentItem->insertChild(row, item);
+        return;
+    }
+
+    beginInsertRows(itemIndex(parentItem), row, row);
+    parentItem->insertChild(row, item);
+    endInsertRows();
+}
+
+QModelIndex SLTreeModel::itemIndex(SLModelItem *item) const
+{
+    if (m_rootItem == item)
+    {
+        return QModelIndex();
+    }
+    return createIndex(item->row(), 0, item);
 }
 
 void SLTreeModel::removeEnsembleService(const ServiceListId & ensId, const ServiceListId & servId)
@@ -257,7 +351,12 @@ void SLTreeModel::removeEnsembleService(const ServiceListId & ensId, const Servi
     if (nullptr != serviceChild)
     {   // found
         //beginRemoveRows(index(ensChild->row(), 0, QModelIndex()), serviceChild->row(), serviceChild->row());
-        beginRemoveRows(index(serviceChild->parentItem()->row(), 0, QModelIndex()), serviceChild->row(), serviceChild->row());
+        if (m_isUpdating)
+        {
+            serviceChild->parentItem()->removeChildId(servId);
+            return;
+        }
+        beginRemoveRows(itemIndex(serviceChild->parentItem()), serviceChild->row(), serviceChild->row());
         serviceChild->parentItem()->removeChildId(servId);
         endRemoveRows();
     }
@@ -271,6 +370,11 @@ void SLTreeModel::removeEnsemble(const ServiceListId &ensId)
         return;
     }
 
+    if (m_isUpdating)
+    {
+        m_rootItem->removeChildId(ensId);
+        return;
+    }
     beginRemoveRows(QModelIndex(), ensChild->row(), ensChild->row());
     m_rootItem->removeChildId(ensId);
     endRemoveRows();
@@ -278,6 +382,13 @@ void SLTreeModel::removeEnsemble(const ServiceListId &ensId)
 
 void SLTreeModel::clear()
 {
+    if (m_isUpdating)
+    {   // model is already in reset
+        delete m_rootItem;
+        m_rootItem = new SLModelItem(m_slPtr, m_metadataMgrPtr);
+        return;
+    }
+
     beginResetModel();
     // remove all items
     delete m_rootItem;
@@ -290,6 +401,13 @@ void SLTreeModel::sort(int column, Qt::SortOrder order)
 {   
     Q_UNUSED(column)
 
+    m_sortOrder = order;
+    if (m_isUpdating)
+    {
+        m_rootItem->sort(order);
+        return;
+    }
+
     beginResetModel();
     m_rootItem->sort(order);
     endResetModel();
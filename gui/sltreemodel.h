@@ -59,12 +59,21 @@ public slots:
     void updateEnsembleService(const ServiceListId & ensId, const ServiceListId & servId);
     void removeEnsembleService(const ServiceListId &ensId, const ServiceListId &servId);
     void removeEnsemble(const ServiceListId &ensId);
+    void metadataUpdated(const ServiceListId &servId, MetadataManager::MetadataRole role);
     void clear();
+    // services added between beginUpdate() and endUpdate() are shown in one step
+    void beginUpdate();
+    void endUpdate();
 
 private:
     SLModelItem * m_rootItem;    
     const ServiceList * m_slPtr;
     const MetadataManager * m_metadataMgrPtr;
+    bool m_isUpdating = false;
+    Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+
+    void insertItem(SLModelItem * parentItem, SLModelItem * item);
+    QModelIndex itemIndex(SLModelItem * item) const;
 };
 
 #endif // SLTREEMODEL_H
@@ -0,0 +1,253 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+
+#include "subscriptionmanager.h"
+#include "audiodecoder.h"
+#include "audiorecorder.h"
+#include "audiofifo.h"
+#include "slideshowapp.h"
+#include "spiapp.h"
+
+Q_LOGGING_CATEGORY(subscriptionManager, "SubscriptionManager", QtInfoMsg)
+
+SubscriptionManager::SubscriptionManager(RadioControl *radioControl, QObject *parent) : QObject(parent)
+    , m_radioControl(radioControl)
+{
+    int numThreads = qBound(1, QThread::idealThreadCount() / 2, SUBSCRIPTION_MANAGER_MAX_THREADS);
+    for (int n = 0; n < numThreads; ++n)
+    {
+        QThread * thread = new QThread(this);
+        thread->setObjectName(QString("subscriptionThr%1").arg(n));
+        thread->start();
+        m_threadPool.append(thread);
+    }
+
+    connect(this, &SubscriptionManager::subscribeServiceComponent, m_radioControl, &RadioControl::subscribeServiceComponent, Qt::QueuedConnection);
+    connect(this, &SubscriptionManager::unsubscribeServiceComponent, m_radioControl, &RadioControl::unsubscribeServiceComponent, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::subscriptionStarted, this, &SubscriptionManager::onSubscriptionStarted, Qt::QueuedConnection);
+    connect(m_radioControl, &RadioControl::subscriptionStopped, this, &SubscriptionManager::onSubscriptionStopped, Qt::QueuedConnection);
+
+    // routing is done directly in radioControl thread, data group is then queued to user application thread
+    connect(m_radioControl, &RadioControl::userAppData_Subscription, this, &SubscriptionManager::onUserAppData, Qt::DirectConnection);
+}
+
+SubscriptionManager::~SubscriptionManager()
+{
+    disconnect(m_radioControl, nullptr, this, nullptr);
+
+    while (!m_subscriptions.isEmpty())
+    {
+        removeSubscription(m_subscriptions.takeFirst());
+    }
+
+    for (auto thread : m_threadPool)
+    {   // this deletes all remaining objects
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+}
+
+void SubscriptionManager::setAudioRecording(const QString &recordingPath, bool doOutputRecording)
+{
+    m_recordingPath = recordingPath;
+    m_doOutputRecording = doOutputRecording;
+}
+
+void SubscriptionManager::setAudioSegmenting(int segmentMin, int retentionHours, bool preallocate)
+{
+    m_segmentMin = segmentMin;
+    m_retentionHours = retentionHours;
+    m_preallocate = preallocate;
+}
+
+QThread *SubscriptionManager::nextThread()
+{
+    QThread * thread = m_threadPool.at(m_nextThreadIdx);
+    m_nextThreadIdx = (m_nextThreadIdx + 1) % m_threadPool.size();
+    return thread;
+}
+
+void SubscriptionManager::onSubscriptionStarted(const RadioControlServiceComponent &sc)
+{
+    for (const auto subscription : m_subscriptions)
+    {
+        if ((subscription->SId == sc.SId.value()) && (subscription->SCIdS == sc.SCIdS))
+        {   // already running
+            return;
+        }
+    }
+
+    Subscription * subscription = new Subscription;
+    subscription->SId = sc.SId.value();
+    subscription->SCIdS = sc.SCIdS;
+    subscription->isAudio = sc.isAudioService();
+    subscription->SCId = sc.isDataPacketService() ? sc.packetData.SCId : 0;
+
+    QThread * thread = nextThread();
+    RadioControlEnsemble ens;
+    ens.ueid = m_radioControl->getEnsembleUEID();
+
+    if (subscription->isAudio)
+    {
+        subscription->audioRecorder = new AudioRecorder();
+        subscription->audioDecoder = new AudioDecoder(subscription->audioRecorder);
+        subscription->audioDrain = new AudioFifoDrain(this);
+        subscription->audioRecorder->moveToThread(thread);
+        subscription->audioDecoder->moveToThread(thread);
+
+        AudioRecorder * recorder = subscription->audioRecorder;
+        AudioDecoder * decoder = subscription->audioDecoder;
+        connect(m_radioControl, &RadioControl::audioData_Subscription, decoder, &AudioDecoder::decodeData, Qt::QueuedConnection);
+        connect(decoder, &AudioDecoder::startAudio, subscription->audioDrain, &AudioFifoDrain::start, Qt::QueuedConnection);
+        connect(decoder, &AudioDecoder::switchAudio, subscription->audioDrain, &AudioFifoDrain::start, Qt::QueuedConnection);
+        connect(decoder, &AudioDecoder::stopAudio, subscription->audioDrain, &AudioFifoDrain::stop, Qt::QueuedConnection);
+        if (!m_recordingPath.isEmpty())
+        {   // new file is started for every audio format, recorder lives in decoder thread
+            connect(decoder, &AudioDecoder::audioParametersInfo, recorder, [recorder]() { recorder->start(); }, Qt::DirectConnection);
+        }
+
+        QString recordingPath = m_recordingPath;
+        bool doOutputRecording = m_doOutputRecording;
+        int segmentMin = m_segmentMin;
+        int retentionHours = m_retentionHours;
+        bool preallocate = m_preallocate;
+        QMetaObject::invokeMethod(decoder, [=]() {
+            recorder->setup(recordingPath, doOutputRecording);
+            recorder->setSegmenting(segmentMin, retentionHours, preallocate);
+            decoder->start(sc);
+        }, Qt::QueuedConnection);
+    }
+    else
+    {
+        QList<DabUserApplicationType> uaTypes = sc.userApps.keys();
+        if (uaTypes.isEmpty())
+        {   // user applications are not known yet, applications ignore data of other type
+            uaTypes << DabUserApplicationType::SlideShow << DabUserApplicationType::SPI;
+        }
+        for (const auto & uaType : uaTypes)
+        {
+            UserApplication * app = nullptr;
+            switch (uaType)
+            {
+            case DabUserApplicationType::SlideShow:
+                app = new SlideShowApp();
+                break;
+            case DabUserApplicationType::SPI:
+                app = new SPIApp();
+                break;
+            default:
+                qCInfo(subscriptionManager) << "User application" << DabTables::getUserApplicationName(uaType) << "is not supported";
+                continue;
+            }
+            app->moveToThread(thread);
+            connect(thread, &QThread::finished, app, &QObject::deleteLater);
+
+            SetupDialog::Settings::UADumpSettings settings = m_dumpSettings;
+            QMetaObject::invokeMethod(app, [app, settings, ens, sc]() {
+                app->setEnsId(ens);
+                app->setAudioServiceId(sc);
+                app->setDataDumping(settings);
+                app->start();
+            }, Qt::QueuedConnection);
+
+            subscription->userApps.append(app);
+        }
+
+        QMutexLocker locker(&m_routingMutex);
+        m_routingTable[subscription->SCId].append(subscription->userApps);
+    }
+
+    qCInfo(subscriptionManager, "Started %6.6X : %d (%s)", subscription->SId, subscription->SCIdS, thread->objectName().toLatin1().data());
+    m_subscriptions.append(subscription);
+}
+
+void SubscriptionManager::onSubscriptionStopped(uint32_t SId, uint8_t SCIdS)
+{
+    for (int n = 0; n < m_subscriptions.size(); ++n)
+    {
+        if ((m_subscriptions.at(n)->SId == SId) && (m_subscriptions.at(n)->SCIdS == SCIdS))
+        {
+            qCInfo(subscriptionManager, "Stopped %6.6X : %d", SId, SCIdS);
+            removeSubscription(m_subscriptions.takeAt(n));
+            return;
+        }
+    }
+}
+
+void SubscriptionManager::onUserAppData(const RadioControlUserAppData &data)
+{
+    QMutexLocker locker(&m_routingMutex);
+    auto it = m_routingTable.constFind(data.SCId);
+    if (m_routingTable.cend() != it)
+    {
+        for (const auto app : *it)
+        {
+            QMetaObject::invokeMethod(app, [app, data]() { app->onUserAppData(data); }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void SubscriptionManager::removeSubscription(Subscription *subscription)
+{
+    if (subscription->isAudio)
+    {
+        disconnect(m_radioControl, &RadioControl::audioData_Subscription, subscription->audioDecoder, &AudioDecoder::decodeData);
+
+        // decoder is deleted first, it uses recorder
+        AudioDecoder * decoder = subscription->audioDecoder;
+        QMetaObject::invokeMethod(decoder, [decoder]() { decoder->stop(); }, Qt::QueuedConnection);
+        subscription->audioDecoder->deleteLater();
+        subscription->audioRecorder->deleteLater();
+        subscription->audioDrain->finish();
+        delete subscription->audioDrain;
+    }
+    else
+    {
+        {
+            QMutexLocker locker(&m_routingMutex);
+            auto it = m_routingTable.find(subscription->SCId);
+            if (m_routingTable.end() != it)
+            {
+                for (const auto app : std::as_const(subscription->userApps))
+                {
+                    it->removeAll(app);
+                }
+                if (it->isEmpty())
+                {
+                    m_routingTable.erase(it);
+                }
+            }
+        }
+        for (const auto app : std::as_const(subscription->userApps))
+        {   // pending data groups are discarded with the object
+            app->deleteLater();
+        }
+    }
+    delete subscription;
+}
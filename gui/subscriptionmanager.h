@@ -0,0 +1,100 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SUBSCRIPTIONMANAGER_H
+#define SUBSCRIPTIONMANAGER_H
+
+#include <QObject>
+#include <QThread>
+#include <QHash>
+#include <QMutex>
+
+#include "radiocontrol.h"
+#include "setupdialog.h"
+
+#define SUBSCRIPTION_MANAGER_MAX_THREADS  (4)
+
+class UserApplication;
+class AudioDecoder;
+class AudioRecorder;
+class AudioFifoDrain;
+
+// decoding of service components subscribed in RadioControl in addition to current service
+// every subscription has its own user application / audio decoder instances running in worker pool
+class SubscriptionManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SubscriptionManager(RadioControl * radioControl, QObject *parent = nullptr);
+    ~SubscriptionManager();
+    void setDataDumping(const SetupDialog::Settings::UADumpSettings & settings) { m_dumpSettings = settings; }
+    void setAudioRecording(const QString & recordingPath, bool doOutputRecording);
+    void setAudioSegmenting(int segmentMin, int retentionHours, bool preallocate);
+    void subscribe(uint32_t SId, uint8_t SCIdS) { emit subscribeServiceComponent(SId, SCIdS); }
+    void unsubscribe(uint32_t SId, uint8_t SCIdS) { emit unsubscribeServiceComponent(SId, SCIdS); }
+    int numSubscriptions() const { return m_subscriptions.size(); }
+
+signals:
+    void subscribeServiceComponent(uint32_t SId, uint8_t SCIdS);
+    void unsubscribeServiceComponent(uint32_t SId, uint8_t SCIdS);
+
+private:
+    struct Subscription
+    {
+        uint32_t SId;
+        uint8_t SCIdS;
+        uint16_t SCId;
+        bool isAudio;
+        QList<UserApplication *> userApps;
+        AudioDecoder * audioDecoder = nullptr;
+        AudioRecorder * audioRecorder = nullptr;
+        AudioFifoDrain * audioDrain = nullptr;
+    };
+
+    RadioControl * m_radioControl;
+    QList<QThread *> m_threadPool;
+    int m_nextThreadIdx = 0;
+    QList<Subscription *> m_subscriptions;
+
+    // SCId -> user applications, data groups are routed in radioControl thread
+    QHash<uint16_t, QList<UserApplication *> > m_routingTable;
+    QMutex m_routingMutex;
+
+    SetupDialog::Settings::UADumpSettings m_dumpSettings;
+    QString m_recordingPath;
+    bool m_doOutputRecording = false;
+    int m_segmentMin = 0;
+    int m_retentionHours = 0;
+    bool m_preallocate = false;
+
+    QThread * nextThread();
+    void onSubscriptionStarted(const RadioControlServiceComponent & sc);
+    void onSubscriptionStopped(uint32_t SId, uint8_t SCIdS);
+    void onUserAppData(const RadioControlUserAppData & data);
+    void removeSubscription(Subscription * subscription);
+};
+
+#endif // SUBSCRIPTIONMANAGER_H
@@ -0,0 +1,203 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QLoggingCategory>
+#include <QStringList>
+#include <algorithm>
+#include <mutex>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <avrt.h>
+#elif defined(Q_OS_MACOS)
+#include <pthread.h>
+#include <pthread/qos.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#endif
+
+#include "threadpriority.h"
+
+Q_LOGGING_CATEGORY(threadPriority, "ThreadPriority", QtInfoMsg)
+
+std::atomic<uint32_t> ThreadPriority::m_generation { 0 };
+
+namespace
+{
+std::mutex configMutex;
+ThreadPriorityConfig configs[int(ThreadClass::NumClasses)];
+
+const char * className(ThreadClass cls)
+{
+    switch (cls)
+    {
+    case ThreadClass::Input:
+        return "input";
+    case ThreadClass::Dabsdr:
+        return "dabsdr";
+    case ThreadClass::Decoder:
+        return "decoder";
+    case ThreadClass::Output:
+        return "output";
+    default:
+        return "";
+    }
+}
+}
+
+void ThreadPriority::setConfig(ThreadClass cls, const ThreadPriorityConfig &config)
+{
+    {
+        std::lock_guard<std::mutex> lock(configMutex);
+        configs[int(cls)] = config;
+    }
+    m_generation.fetch_add(1, std::memory_order_release);
+}
+
+ThreadPriorityConfig ThreadPriority::config(ThreadClass cls)
+{
+    std::lock_guard<std::mutex> lock(configMutex);
+    return configs[int(cls)];
+}
+
+void ThreadPriority::apply(ThreadClass cls)
+{
+    ThreadPriorityConfig cfg = config(cls);
+
+#if defined(Q_OS_WIN)
+    if (cfg.priority > 0)
+    {
+        bool done = false;
+        if ((ThreadClass::Output == cls) || (ThreadClass::Decoder == cls))
+        {   // MMCSS is preferred for audio, it is available to non-admin users
+            DWORD taskIndex = 0;
+            HANDLE task = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+            if (nullptr != task)
+            {
+                AvSetMmThreadPriority(task, (cfg.priority > 50) ? AVRT_PRIORITY_CRITICAL : AVRT_PRIORITY_HIGH);
+                done = true;
+            }
+            else { /* fallback to thread priority */ }
+        }
+        if (!done && !SetThreadPriority(GetCurrentThread(), (cfg.priority > 50) ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST))
+        {
+            qCWarning(threadPriority, "Failed to set priority of %s thread [error %lu]", className(cls), GetLastError());
+        }
+    }
+    if (0 != cfg.cpuMask)
+    {
+        if (0 == SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(cfg.cpuMask)))
+        {
+            qCWarning(threadPriority, "Failed to set CPU affinity of %s thread [error %lu]", className(cls), GetLastError());
+        }
+    }
+#elif defined(Q_OS_MACOS)
+    if (cfg.priority > 0)
+    {
+        int ret = pthread_set_qos_class_self_np((cfg.priority > 50) ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_USER_INITIATED, 0);
+        if (0 != ret)
+        {
+            qCWarning(threadPriority, "Failed to set QoS class of %s thread [error %d]", className(cls), ret);
+        }
+    }
+    if (0 != cfg.cpuMask)
+    {   // macOS does not support binding threads to CPUs
+        qCInfo(threadPriority, "CPU affinity is not supported, ignored for %s thread", className(cls));
+    }
+#else
+    if (cfg.priority > 0)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = std::min(std::max(cfg.priority, sched_get_priority_min(SCHED_FIFO)), sched_get_priority_max(SCHED_FIFO));
+        int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (0 != ret)
+        {   // typically EPERM when RLIMIT_RTPRIO is not set for user
+            qCWarning(threadPriority, "Failed to set SCHED_FIFO priority %d of %s thread: %s", param.sched_priority, className(cls), strerror(ret));
+        }
+    }
+    if (0 != cfg.cpuMask)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (int cpu = 0; cpu < 64; ++cpu)
+        {
+            if (cfg.cpuMask & (uint64_t(1) << cpu))
+            {
+                CPU_SET(cpu, &cpuSet);
+            }
+        }
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        if (0 != ret)
+        {
+            qCWarning(threadPriority, "Failed to set CPU affinity of %s thread: %s", className(cls), strerror(ret));
+        }
+    }
+#endif
+    if ((cfg.priority > 0) || (0 != cfg.cpuMask))
+    {
+        qCInfo(threadPriority, "Thread %s: priority %d, CPUs [%s]", className(cls), cfg.priority, cpuListString(cfg.cpuMask).toUtf8().data());
+    }
+}
+
+uint64_t ThreadPriority::parseCpuList(const QString &list)
+{
+    uint64_t mask = 0;
+    const QStringList items = list.split(',', Qt::SkipEmptyParts);
+    for (const auto & item : items)
+    {
+        QStringList range = item.trimmed().split('-');
+        bool ok1 = false;
+        bool ok2 = false;
+        int first = range.at(0).toInt(&ok1);
+        int last = (range.size() > 1) ? range.at(1).toInt(&ok2) : first;
+        if (!ok1 || ((range.size() > 1) && !ok2) || (first < 0) || (last > 63) || (first > last))
+        {
+            qCWarning(threadPriority) << "Invalid CPU list item:" << item;
+            continue;
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            mask |= uint64_t(1) << cpu;
+        }
+    }
+    return mask;
+}
+
+QString ThreadPriority::cpuListString(uint64_t mask)
+{
+    QStringList items;
+    for (int cpu = 0; cpu < 64; ++cpu)
+    {
+        if (mask & (uint64_t(1) << cpu))
+        {
+            items.append(QString::number(cpu));
+        }
+    }
+    return items.isEmpty() ? QString("any") : items.join(',');
+}
@@ -0,0 +1,81 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef THREADPRIORITY_H
+#define THREADPRIORITY_H
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+
+// threads of receiver pipeline that can be prioritized
+enum class ThreadClass
+{
+    Input = 0,      // input device worker or driver callback thread
+    Dabsdr,         // DAB processing thread (calls getSamples())
+    Decoder,        // audio decoder thread
+    Output,         // audio output thread or callback
+    NumClasses
+};
+
+struct ThreadPriorityConfig
+{
+    int priority = 0;           // 0 = default, 1..99 = real-time priority
+    uint64_t cpuMask = 0;       // 0 = any CPU, bit n = CPU n
+};
+
+// real-time scheduling and CPU affinity of pipeline threads
+// Linux: SCHED_FIFO, Windows: MMCSS "Pro Audio" (time critical priority as fallback), macOS: QoS class (no affinity)
+// configuration is set from GUI thread, each thread applies it to itself by calling update()
+class ThreadPriority
+{
+public:
+    static void setConfig(ThreadClass cls, const ThreadPriorityConfig & config);
+    static ThreadPriorityConfig config(ThreadClass cls);
+
+    // applies configuration to calling thread if it changed since last call
+    // cheap enough to be called from real-time callbacks
+    static void update(ThreadClass cls)
+    {
+        thread_local uint32_t appliedGeneration = 0;
+        uint32_t generation = m_generation.load(std::memory_order_acquire);
+        if (generation != appliedGeneration)
+        {
+            appliedGeneration = generation;
+            apply(cls);
+        }
+    }
+
+    // CPU list like "0,2-3" <-> mask
+    static uint64_t parseCpuList(const QString & list);
+    static QString cpuListString(uint64_t mask);
+
+private:
+    static std::atomic<uint32_t> m_generation;
+    static void apply(ThreadClass cls);
+};
+
+#endif // THREADPRIORITY_H
@@ -0,0 +1,90 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "uiupdatescheduler.h"
+
+UiUpdateScheduler::UiUpdateScheduler(QObject *parent) : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(UIUPDATESCHEDULER_FRAME_MS);
+    connect(&m_timer, &QTimer::timeout, this, &UiUpdateScheduler::flush);
+}
+
+void UiUpdateScheduler::post(Update id, const std::function<void()> & apply)
+{
+    for (auto & update : m_pending)
+    {
+        if (update.id == id)
+        {   // superseded by newer state
+            update.apply = apply;
+            return;
+        }
+    }
+    m_pending.append({id, apply});
+
+    if (!m_isSuspended && !m_timer.isActive())
+    {
+        m_timer.start();
+    }
+}
+
+void UiUpdateScheduler::cancel(Update id)
+{
+    m_pending.removeIf([id](const PendingUpdate & update) { return update.id == id; });
+}
+
+void UiUpdateScheduler::setSuspended(bool suspended)
+{
+    if (suspended == m_isSuspended)
+    {
+        return;
+    }
+
+    m_isSuspended = suspended;
+    if (suspended)
+    {
+        m_timer.stop();
+    }
+    else
+    {   // replay latest state immediately
+        flush();
+    }
+}
+
+void UiUpdateScheduler::flush()
+{
+    // apply can post new updates, they are scheduled for next frame
+    QList<PendingUpdate> pending;
+    pending.swap(m_pending);
+    for (const auto & update : pending)
+    {
+        update.apply();
+    }
+    if (!m_pending.isEmpty() && !m_isSuspended)
+    {
+        m_timer.start();
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UIUPDATESCHEDULER_H
+#define UIUPDATESCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QList>
+#include <functional>
+
+#define UIUPDATESCHEDULER_FRAME_MS  (16)    // default display frame period
+
+// widget updates driven by decoder signals are collected and applied at most once per display frame
+// only latest update of each kind is kept, updates are applied in order of their first arrival
+// while window is hidden nothing is applied, latest state is replayed when it is shown again
+class UiUpdateScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Update
+    {
+        SignalState,
+        DabTime,
+        ServiceDL,
+        AnnouncementDL,
+        ServiceSlide,
+        ServiceLogo,
+        AnnouncementSlide,
+        AudioRecordingProgress,
+        AudioLoudness,
+    };
+
+    explicit UiUpdateScheduler(QObject *parent = nullptr);
+
+    // replaces pending update of the same kind, apply is called from GUI thread
+    void post(Update id, const std::function<void()> & apply);
+
+    // drops pending update, used when widget is reset directly
+    void cancel(Update id);
+
+    // pending updates are kept while suspended and applied when resumed
+    void setSuspended(bool suspended);
+    bool isSuspended() const { return m_isSuspended; }
+
+    void setFramePeriod(int ms) { m_timer.setInterval(ms); }
+
+private:
+    struct PendingUpdate
+    {
+        Update id;
+        std::function<void()> apply;
+    };
+    QList<PendingUpdate> m_pending;
+    QTimer m_timer;
+    bool m_isSuspended = false;
+
+    void flush();
+};
+
+#endif // UIUPDATESCHEDULER_H
@@ -34,6 +34,11 @@
 #include <QRegularExpression>
 #include <QApplication>
 #include <QClipboard>
+#include <QPixmapCache>
+#include "config.h"
+#if HAVE_OPENGL
+#include <QOpenGLWidget>
+#endif
 #include "slsview.h"
 
 Q_DECLARE_LOGGING_CATEGORY(application)
@@ -41,24 +46,35 @@ Q_DECLARE_LOGGING_CATEGORY(application)
 SLSView::SLSView(QWidget *parent) : QGraphicsView(parent)
 {
     m_announcementText = nullptr;
+    m_pixmapItem = nullptr;
+
+    m_rescaleTimer = new QTimer(this);
+    m_rescaleTimer->setSingleShot(true);
+    m_rescaleTimer->setInterval(SLSVIEW_RESCALE_DELAY_MS);
+    connect(m_rescaleTimer, &QTimer::timeout, this, [this]() { updateScaledSlide(); });
+
+    m_transitionAnimation = new QVariantAnimation(this);
+    m_transitionAnimation->setDuration(SLSVIEW_TRANSITION_MS);
+    m_transitionAnimation->setStartValue(1.0);
+    m_transitionAnimation->setEndValue(0.0);
+    connect(m_transitionAnimation, &QVariantAnimation::valueChanged, this, [this](const QVariant & value) {
+        if (nullptr != m_transitionItem)
+        {
+            m_transitionItem->setOpacity(value.toReal());
+        }
+    });
+    connect(m_transitionAnimation, &QVariantAnimation::finished, this, &SLSView::stopTransition);
+
     reset();
 }
 
 void SLSView::reset()
 {
-    QPixmap pic = getLogo();
-    QGraphicsScene * sc = scene();
-    if (nullptr == sc)
-    {
-        sc = new QGraphicsScene(this);
-        m_pixmapItem = sc->addPixmap(pic);
+    clearScaledSlide(true);
 
-        setScene(sc);
-    }
-    else
-    {
-        m_pixmapItem->setPixmap(pic);
-    }
+    QPixmap pic = getLogo();
+    QGraphicsScene * sc = getScene();
+    m_pixmapItem->setPixmap(pic);
     sc->setSceneRect(pic.rect());
     if (m_isDarkMode)
     {
@@ -87,16 +103,16 @@ void SLSView::showAnnouncement(DabAnnouncement id)
     }
     else
     {
-        pic.load(QString(":/resources/announcement%1.png").arg(static_cast<int>(id), 2, 10, QChar('0')));
+        pic = loadResourcePixmap(QString(":/resources/announcement%1.png").arg(static_cast<int>(id), 2, 10, QChar('0')));
         m_isShowingSlide = true;
     }
+    clearScaledSlide();
 
-    QGraphicsScene * sc = scene();
-    if (nullptr == sc)
-    {
-        sc = new QGraphicsScene(this);
-        m_pixmapItem = sc->addPixmap(pic);
+    QGraphicsScene * sc = getScene();
+    m_pixmapItem->setPixmap(pic);
 
+    if (nullptr == m_announcementText)
+    {
         QFont font;
         font.setPixelSize(24);
         font.setBold(true);
@@ -104,26 +120,10 @@ void SLSView::showAnnouncement(DabAnnouncement id)
 
         m_announcementText = sc->addText(DabTables::getAnnouncementName(id), font);
         m_announcementText->setDefaultTextColor(QColor(255,255,255));
-        setScene(sc);
     }
     else
     {
-        m_pixmapItem->setPixmap(pic);
-
-        if (nullptr == m_announcementText)
-        {
-            QFont font;
-            font.setPixelSize(24);
-            font.setBold(true);
-            //font.setFamily("Calibri");
-
-            m_announcementText = sc->addText(DabTables::getAnnouncementName(id), font);
-            m_announcementText->setDefaultTextColor(QColor(255,255,255));
-        }
-        else
-        {
-            m_announcementText->setPlainText(DabTables::getAnnouncementName(id));
-        }
+        m_announcementText->setPlainText(DabTables::getAnnouncementName(id));
     }
     QRectF rect = m_announcementText->boundingRect();
     m_announcementText->setPos((320 - rect.width())/2, 185);
@@ -210,6 +210,53 @@ void SLSView::setupDarkMode(bool darkModeEna)
     }
 }
 
+void SLSView::setOpenGL(bool ena)
+{
+#if HAVE_OPENGL
+    if (ena == m_isOpenGL)
+    {
+        return;
+    }
+    m_isOpenGL = ena;
+    stopTransition();
+
+    if (ena)
+    {   // scene consists of few items, full update is cheaper for GPU than tracking of dirty regions
+        setViewport(new QOpenGLWidget());
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    }
+    else
+    {
+        setViewport(new QWidget());
+        setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+    }
+
+    // GPU filters texture of original slide, CPU uses pre-scaled variants instead
+    Qt::TransformationMode mode = ena ? Qt::SmoothTransformation : Qt::FastTransformation;
+    if (nullptr != m_pixmapItem)
+    {
+        m_pixmapItem->setTransformationMode(mode);
+    }
+    if (nullptr != m_transitionItem)
+    {
+        m_transitionItem->setTransformationMode(mode);
+    }
+
+    m_scaledSlideCache.clear();
+    QGraphicsScene * sc = scene();
+    if (nullptr != sc)
+    {
+        fitInViewTight(sc->sceneRect(), Qt::KeepAspectRatio);
+        updateScaledSlide();
+    }
+#else
+    if (ena)
+    {
+        qCWarning(application) << "OpenGL rendering of slideshow is not available in this build";
+    }
+#endif
+}
+
 void SLSView::setExpertMode(bool expertModeEna)
 {
     m_isExpertMode = expertModeEna;
@@ -217,7 +264,9 @@ void SLSView::setExpertMode(bool expertModeEna)
 
 void SLSView::showSlide(const Slide & slide)
 {
-    displayPixmap(slide.getPixmap());
+    // image is already decoded, only conversion of scaled variant to pixmap is done here
+    startTransition(slide.getImage().size());
+    displayImage(slide.getImage());
 
     // update tool tip
     QString toolTip;
@@ -246,7 +295,7 @@ void SLSView::showSlide(const Slide & slide)
         {
             toolTip += "<br>";
         }
-        toolTip += QString(tr("<b>Resolution:</b> %1x%2 pixels<br>")).arg(slide.getPixmap().width()).arg(slide.getPixmap().height());
+        toolTip += QString(tr("<b>Resolution:</b> %1x%2 pixels<br>")).arg(slide.getImage().width()).arg(slide.getImage().height());
         toolTip += QString(tr("<b>Size:</b> %1 bytes<br>")).arg(slide.getNumBytes());
         toolTip += QString(tr("<b>Format:</b> %1<br>")).arg(slide.getFormat());
         toolTip += QString(tr("<b>Content name:</b> \"%1\"")).arg(slide.getContentName());
@@ -287,8 +336,9 @@ void SLSView::resizeEvent(QResizeEvent *event)
 {
     QGraphicsScene * sc = scene();
     if (nullptr != sc)
-    {
-        fitInViewTight(sc->itemsBoundingRect(), Qt::KeepAspectRatio);
+    {   // only transformation changes while resizing, slide is resampled when resizing stops
+        fitInViewTight(sc->sceneRect(), Qt::KeepAspectRatio);
+        m_rescaleTimer->start();
     }
 
     QGraphicsView::resizeEvent(event);
@@ -299,7 +349,8 @@ void SLSView::showEvent(QShowEvent *event)
     QGraphicsScene * sc = scene();
     if (nullptr != sc)
     {
-        fitInViewTight(sc->itemsBoundingRect(), Qt::KeepAspectRatio);
+        fitInViewTight(sc->sceneRect(), Qt::KeepAspectRatio);
+        updateScaledSlide();
     }
 
     QGraphicsView::showEvent(event);
@@ -395,42 +446,199 @@ void SLSView::mouseReleaseEvent(QMouseEvent *event)
 
 QPixmap SLSView::getLogo() const
 {
-    QPixmap pic;
     if (m_isDarkMode)
     {
-        pic.load(":/resources/sls_logo_dark.png");
+        return loadResourcePixmap(":/resources/sls_logo_dark.png");
     }
-    else
+    return loadResourcePixmap(":/resources/sls_logo.png");
+}
+
+QPixmap SLSView::loadResourcePixmap(const QString &path) const
+{   // resource pictures are decoded only once and shared by both views
+    QPixmap pic;
+    if (!QPixmapCache::find(path, &pic))
     {
-        pic.load(":/resources/sls_logo.png");
+        pic.load(path);
+        QPixmapCache::insert(path, pic);
     }
     return pic;
 }
 
-void SLSView::displayPixmap(const QPixmap &pixmap)
+QGraphicsScene * SLSView::getScene()
 {
     QGraphicsScene * sc = scene();
     if (nullptr == sc)
     {
+        Qt::TransformationMode mode = m_isOpenGL ? Qt::SmoothTransformation : Qt::FastTransformation;
         sc = new QGraphicsScene(this);
-        m_pixmapItem = sc->addPixmap(pixmap);
+        m_pixmapItem = sc->addPixmap(QPixmap());
+        m_pixmapItem->setTransformationMode(mode);
+
+        // previous slide is drawn on top of new one while it fades out
+        m_transitionItem = sc->addPixmap(QPixmap());
+        m_transitionItem->setTransformationMode(mode);
+        m_transitionItem->setZValue(1);
+        m_transitionItem->setVisible(false);
+
         setScene(sc);
     }
+    return sc;
+}
+
+void SLSView::removeAnnouncementText()
+{
+    if (nullptr != m_announcementText)
+    {
+        scene()->removeItem(m_announcementText);
+        delete m_announcementText;
+        m_announcementText = nullptr;
+    }
+}
+
+void SLSView::displayPixmap(const QPixmap &pixmap)
+{
+    clearScaledSlide();
+
+    QGraphicsScene * sc = getScene();
+    removeAnnouncementText();
+    m_pixmapItem->setPixmap(pixmap);
+
+    sc->setSceneRect(pixmap.rect());
+    sc->setBackgroundBrush(Qt::black);
+    fitInViewTight(pixmap.rect(), Qt::KeepAspectRatio);
+}
+
+void SLSView::displayImage(const QImage &image)
+{
+    QGraphicsScene * sc = getScene();
+    removeAnnouncementText();
+    m_slideImage = image;
+
+    sc->setSceneRect(image.rect());
+    sc->setBackgroundBrush(Qt::black);
+    fitInViewTight(image.rect(), Qt::KeepAspectRatio);
+
+    if (!updateScaledSlide())
+    {   // view is not visible yet, slide is scaled in showEvent
+        m_pixmapItem->setPixmap(QPixmap::fromImage(image));
+        m_pixmapItem->setScale(1.0);
+    }
+}
+
+void SLSView::startTransition(const QSize &nextSlideSize)
+{
+    stopTransition();
+
+    // crossfade only between slides of the same size, CPU would have to repaint whole view in every step
+    if (!m_isOpenGL || !isVisible() || (nullptr == m_transitionItem)
+        || m_slideImage.isNull() || (m_slideImage.size() != nextSlideSize))
+    {
+        return;
+    }
+
+    m_transitionItem->setPixmap(m_pixmapItem->pixmap());
+    m_transitionItem->setScale(m_pixmapItem->scale());
+    m_transitionItem->setOpacity(1.0);
+    m_transitionItem->setVisible(true);
+    m_transitionAnimation->start();
+}
+
+void SLSView::stopTransition()
+{
+    if (QAbstractAnimation::Stopped != m_transitionAnimation->state())
+    {   // stop() does not emit finished()
+        m_transitionAnimation->stop();
+    }
+    if (nullptr != m_transitionItem)
+    {
+        m_transitionItem->setVisible(false);
+        m_transitionItem->setPixmap(QPixmap());
+    }
+}
+
+bool SLSView::updateScaledSlide()
+{
+    if (m_slideImage.isNull() || (nullptr == m_pixmapItem))
+    {
+        return false;
+    }
+
+    // size of slide in device pixels for current view transformation
+    QSize targetSize = (transform().mapRect(QRectF(m_slideImage.rect())).size() * devicePixelRatioF()).toSize();
+    if (targetSize.isEmpty())
+    {   // view is not visible yet
+        return false;
+    }
+
+    if (m_isOpenGL && (targetSize.width() >= m_slideImage.width()))
+    {   // GPU upscales texture of original slide, texture is uploaded only once for each slide
+        targetSize = m_slideImage.size();
+    }
+    else
+    { /* CPU or downscaling => slide is resampled only once for each view size, paint then does not need to resample it */ }
+
+    const qint64 imageKey = m_slideImage.cacheKey();
+    int idx = 0;
+    while ((idx < m_scaledSlideCache.size())
+           && ((m_scaledSlideCache.at(idx).imageKey != imageKey) || (m_scaledSlideCache.at(idx).pixmap.size() != targetSize)))
+    {
+        ++idx;
+    }
+
+    ScaledSlide scaled;
+    if (idx < m_scaledSlideCache.size())
+    {   // found in cache
+        scaled = m_scaledSlideCache.takeAt(idx);
+    }
     else
     {
-        if (nullptr != m_announcementText)
+        scaled.imageKey = imageKey;
+        if (targetSize == m_slideImage.size())
+        {   // no scaling needed
+            scaled.pixmap = QPixmap::fromImage(m_slideImage);
+        }
+        else
+        {
+            scaled.pixmap = QPixmap::fromImage(m_slideImage.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+        }
+
+        // least recently used variants are released, current one is always kept
+        qint64 cacheBytes = qint64(targetSize.width()) * targetSize.height() * scaled.pixmap.depth() / 8;
+        for (const auto & item : std::as_const(m_scaledSlideCache))
+        {
+            cacheBytes += qint64(item.pixmap.width()) * item.pixmap.height() * item.pixmap.depth() / 8;
+        }
+        while ((cacheBytes > SLSVIEW_SCALED_CACHE_BYTES) && !m_scaledSlideCache.isEmpty())
         {
-            sc->removeItem(m_announcementText);
-            delete m_announcementText;
-            m_announcementText = nullptr;
+            const QPixmap & last = m_scaledSlideCache.last().pixmap;
+            cacheBytes -= qint64(last.width()) * last.height() * last.depth() / 8;
+            m_scaledSlideCache.removeLast();
         }
+    }
+    m_scaledSlideCache.prepend(scaled);
 
-        m_pixmapItem->setPixmap(pixmap);
+    // item keeps size of original slide in scene coordinates
+    if (m_pixmapItem->pixmap().cacheKey() != scaled.pixmap.cacheKey())
+    {
+        m_pixmapItem->setPixmap(scaled.pixmap);
     }
+    m_pixmapItem->setScale(qreal(m_slideImage.width()) / scaled.pixmap.width());
 
-    sc->setSceneRect(pixmap.rect());
-    sc->setBackgroundBrush(Qt::black);
-    fitInViewTight(pixmap.rect(), Qt::KeepAspectRatio);
+    return true;
+}
+
+void SLSView::clearScaledSlide(bool clearCache)
+{
+    stopTransition();
+    m_slideImage = QImage();
+    if (clearCache)
+    {
+        m_scaledSlideCache.clear();
+    }
+    if (nullptr != m_pixmapItem)
+    {
+        m_pixmapItem->setScale(1.0);
+    }
 }
 
 QString SLSView::savePath() const
@@ -30,9 +30,15 @@
 #include <QGraphicsView>
 #include <QObject>
 #include <QGraphicsPixmapItem>
+#include <QVariantAnimation>
+#include <QTimer>
 
 #include "slideshowapp.h"
 
+#define SLSVIEW_SCALED_CACHE_BYTES (48*1024*1024)  // pre-scaled slide variants, slideshows often repeat slides
+#define SLSVIEW_RESCALE_DELAY_MS   (150)  // slide is resampled only when resizing stops
+#define SLSVIEW_TRANSITION_MS      (300)  // crossfade duration, used only with OpenGL viewport
+
 // this implementation allow scaling od SLS with the window
 class SLSView : public QGraphicsView
 {
@@ -68,6 +74,9 @@ public:
     //! @brief This methis sets default slide save path
     void setSavePath(const QString &newSavePath);
 
+    //! @brief This method enables rendering by OpenGL viewport (if available in build)
+    void setOpenGL(bool ena);
+
 protected:
     //! @brief Reimplemented to scale image correctly
     void resizeEvent(QResizeEvent *event);
@@ -97,12 +106,61 @@ private:
     //! @brief expert mode
     bool m_isExpertMode = false;
 
+    //! @brief OpenGL viewport is used, GPU does scaling and transitions
+    bool m_isOpenGL = false;
+
+    //! @brief Previous slide fading out during transition
+    QGraphicsPixmapItem * m_transitionItem = nullptr;
+
+    //! @brief Animation of crossfade between slides
+    QVariantAnimation * m_transitionAnimation = nullptr;
+
+    //! @brief Delays resampling of slide while view is being resized
+    QTimer * m_rescaleTimer = nullptr;
+
+    //! @brief Pre-scaled slide variant
+    struct ScaledSlide
+    {
+        qint64 imageKey;   // QImage::cacheKey() of source slide
+        QPixmap pixmap;
+    };
+
     //! @brief returns logo to show when no slide is available
     QPixmap getLogo() const;
 
+    //! @brief Loads picture from resources, pictures are kept in QPixmapCache
+    QPixmap loadResourcePixmap(const QString & path) const;
+
+    //! @brief Creates scene if it does not exist
+    QGraphicsScene * getScene();
+
+    //! @brief Removes announcement text from scene
+    void removeAnnouncementText();
+
+    //! @brief Shows decoded slide image in the view
+    void displayImage(const QImage & image);
+
+    //! @brief Starts crossfade from currently shown pixmap
+    void startTransition(const QSize & nextSlideSize);
+
+    //! @brief Stops running crossfade
+    void stopTransition();
+
     //! @brief Methods displays pixmap
     void displayPixmap(const QPixmap & logo);
 
+    //! @brief Replaces slide pixmap by variant pre-scaled to current view size, returns false if view is not visible
+    bool updateScaledSlide();
+
+    //! @brief Releases current slide image, scaled variants are kept unless clearCache is set
+    void clearScaledSlide(bool clearCache = false);
+
+    //! @brief Decoded image of current slide, source for scaled variants
+    QImage m_slideImage;
+
+    //! @brief Pre-scaled slide variants, most recently used first
+    QList<ScaledSlide> m_scaledSlideCache;
+
     //! @brief This is copy of current slide
     Slide m_currentSlide;
 
@@ -0,0 +1,162 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QShowEvent>
+#include <QHideEvent>
+#include <algorithm>
+#include <cmath>
+#include "spectrumwidget.h"
+#include "spectrumtap.h"
+
+SpectrumWidget::SpectrumWidget(QWidget *parent) : QWidget(parent)
+{
+    m_refreshTimer.setInterval(SPECTRUMWIDGET_REFRESH_MS);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &SpectrumWidget::onRefreshTimer);
+
+    setToolTip(tr("Spectrum of input signal"));
+}
+
+SpectrumWidget::~SpectrumWidget()
+{
+    if (m_refreshTimer.isActive())
+    {
+        SpectrumTap::getInstance()->stop();
+    }
+}
+
+QSize SpectrumWidget::sizeHint() const
+{
+    return QSize(600, 180);
+}
+
+QSize SpectrumWidget::minimumSizeHint() const
+{
+    return QSize(300, 120);
+}
+
+void SpectrumWidget::showEvent(QShowEvent *event)
+{
+    m_spectrum.clear();
+    SpectrumTap::getInstance()->start();
+    m_refreshTimer.start();
+    QWidget::showEvent(event);
+}
+
+void SpectrumWidget::hideEvent(QHideEvent *event)
+{
+    m_refreshTimer.stop();
+    SpectrumTap::getInstance()->stop();
+    QWidget::hideEvent(event);
+}
+
+void SpectrumWidget::onRefreshTimer()
+{
+    if (!SpectrumTap::getInstance()->getSpectrum(m_spectrum))
+    {   // no new spectrum (no input samples)
+        return;
+    }
+
+    // reference level follows maximum in 10 dB steps with hysteresis
+    float maxDb = *std::max_element(m_spectrum.cbegin(), m_spectrum.cend());
+    if ((maxDb > m_topDb) || (maxDb < m_topDb - 20.0f))
+    {
+        m_topDb = 10.0f * std::ceil(maxDb / 10.0f) + 5.0f;
+    }
+    else { /* keep scale */ }
+
+    update();
+}
+
+void SpectrumWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    const QRectF area = rect().adjusted(1, 1, -1, -fontMetrics().height() - 2);
+    painter.fillRect(rect(), palette().base());
+
+    // grid: 10 dB vertical, 250 kHz horizontal
+    QColor gridColor = palette().text().color();
+    gridColor.setAlpha(50);
+    painter.setPen(gridColor);
+    for (float db = 10.0f; db < SPECTRUMWIDGET_RANGE_DB; db += 10.0f)
+    {
+        qreal y = area.top() + area.height() * db / SPECTRUMWIDGET_RANGE_DB;
+        painter.drawLine(QPointF(area.left(), y), QPointF(area.right(), y));
+    }
+    const qreal halfBwKHz = SPECTRUMTAP_SAMPLE_RATE / 2000.0;
+    for (int offset = -1000; offset <= 1000; offset += 250)
+    {
+        qreal x = area.left() + area.width() * (offset + halfBwKHz) / (2 * halfBwKHz);
+        painter.setPen(gridColor);
+        painter.drawLine(QPointF(x, area.top()), QPointF(x, area.bottom()));
+
+        if (0 == offset % 500)
+        {
+            QString label = (m_frequency != 0) ? QString::number((m_frequency + offset) / 1000.0, 'f', 1)
+                                               : QString::number(offset);
+            qreal labelWidth = fontMetrics().horizontalAdvance(label);
+            qreal labelX = std::clamp(x - labelWidth / 2, area.left(), area.right() - labelWidth);
+            painter.setPen(palette().text().color());
+            painter.drawText(QPointF(labelX, rect().bottom() - fontMetrics().descent()), label);
+        }
+    }
+
+    if (m_spectrum.empty())
+    {
+        return;
+    }
+
+    // one point per pixel column, maximum of bins falling into the column
+    QPainterPath path;
+    const int numBins = m_spectrum.size();
+    const int numColumns = std::max(1, int(area.width()));
+    for (int col = 0; col < numColumns; ++col)
+    {
+        int binFirst = col * numBins / numColumns;
+        int binLast = std::max(binFirst + 1, (col + 1) * numBins / numColumns);
+        float db = *std::max_element(m_spectrum.cbegin() + binFirst, m_spectrum.cbegin() + binLast);
+        float rel = std::clamp((m_topDb - db) / SPECTRUMWIDGET_RANGE_DB, 0.0f, 1.0f);
+        QPointF pt(area.left() + col, area.top() + rel * area.height());
+        if (0 == col)
+        {
+            path.moveTo(pt);
+        }
+        else
+        {
+            path.lineTo(pt);
+        }
+    }
+    painter.setPen(QPen(palette().highlight().color(), 1.0));
+    painter.drawPath(path);
+
+    painter.setPen(palette().text().color());
+    painter.drawText(area.adjusted(4, 2, -4, 0), Qt::AlignTop | Qt::AlignLeft, QString("%1 dB").arg(m_topDb, 0, 'f', 0));
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is part of the AbracaDABra project
+ *
+ * MIT License
+ *
+  * Copyright (c) 2019-2023 Petr Kopecký <xkejpi (at) gmail (dot) com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPECTRUMWIDGET_H
+#define SPECTRUMWIDGET_H
+
+#include <QWidget>
+#include <QTimer>
+#include <vector>
+
+#define SPECTRUMWIDGET_REFRESH_MS  (100)    // GUI refresh period
+#define SPECTRUMWIDGET_RANGE_DB    (80.0f)  // displayed dynamic range
+
+// averaged spectrum of input signal provided by SpectrumTap
+// tap is running only while widget is visible
+class SpectrumWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SpectrumWidget(QWidget *parent = nullptr);
+    ~SpectrumWidget();
+    void setFrequency(uint32_t freq) { m_frequency = freq; update(); }
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QTimer m_refreshTimer;
+    std::vector<float> m_spectrum;
+    float m_topDb = 0.0f;
+    uint32_t m_frequency = 0;    // kHz
+
+    void onRefreshTimer();
+};
+
+#endif // SPECTRUMWIDGET_H